@@ -0,0 +1,532 @@
+/*
+ * cl_demo.c - Demo recording and timedemo benchmarking
+ *
+ * A demo is the usercmd_t stream CL_Frame fed the game, one record per
+ * engine frame, together with the frame's msec and the final camera. The
+ * engine is a single process with the server in it, so replaying the same
+ * commands with the same msec and random seed, from a fresh load of the
+ * same map, reproduces the session. The recorded camera is also forced
+ * back onto the renderer, so the rendered views match even if the game
+ * drifts.
+ *
+ *   record <name> [map]   reload map (default: current) and record
+ *   stop                  finish recording, or abort playback
+ *   timedemo <name>       replay as fast as possible and report timings
+ *
+ * Demos are demos/<name>.sdm under the game directory. Playback finds
+ * them through the filesystem, so they can also ship inside a pak. Each
+ * run appends one JSON line to timedemo.log with the frame time summary,
+ * a histogram, the sv/cl/render split and world draw counts.
+ * timedemo_quit 1 quits once the report is written, for scripted runs.
+ */
+
+#include "../common/qcommon.h"
+#include "win32_compat.h"
+#include "../renderer/r_local.h"
+
+#include <time.h>
+
+extern bsp_world_t *R_GetWorldModel(void);
+
+#define DEMO_IDENT      (('M'<<24)+('D'<<16)+('F'<<8)+'S')     /* "SFDM" */
+#define DEMO_VERSION    1
+
+#define DF_CMD          1       /* cmd was run through SV_ClientThink */
+
+/* Written in host byte order; demos are benchmark inputs, not releases */
+typedef struct {
+    int         ident;
+    int         version;
+    char        map[MAX_QPATH];
+    int         seed;
+    int         numframes;      /* patched in by stop */
+} demoheader_t;
+
+typedef struct {
+    int         msec;
+    int         flags;
+    usercmd_t   cmd;
+    vec3_t      origin;
+    vec3_t      angles;
+} demoframe_t;
+
+typedef enum {
+    DEMO_IDLE,
+    DEMO_RECORDING,
+    DEMO_PLAYING
+} demostate_t;
+
+/* Report histogram bucket upper bounds, in ms; the last bucket is open */
+static const float demo_buckets[] = { 1, 2, 4, 8, 12, 16.7f, 25, 33.3f, 50, 100 };
+#define DEMO_NUMBUCKETS (int)(sizeof(demo_buckets) / sizeof(demo_buckets[0]) + 1)
+
+static struct {
+    demostate_t     state;
+    qboolean        pending;        /* start at the top of the next frame */
+    char            name[MAX_QPATH];
+    demoheader_t    header;
+
+    /* Recording */
+    FILE            *file;
+    demoframe_t     rec;
+
+    /* Playback */
+    void            *buffer;        /* whole demo, from FS_LoadFile */
+    demoframe_t     *frames;
+    int             frame;
+    int             oldswap;
+
+    /* Timings of the frame in progress, in Sys_PerfCounter ticks */
+    uint64_t        t_start, t_mark;
+    uint64_t        t_phase[DEMO_NUMPHASES];
+
+    /* Per-frame results, numframes long */
+    float           *frame_ms;
+    double          phase_ms[DEMO_NUMPHASES];
+    double          draw_calls, state_changes, visible_faces;
+    int             max_draws;
+    uint64_t        run_start;
+} demo;
+
+static cvar_t   *timedemo_quit;
+
+/* ==========================================================================
+   Starting
+   ========================================================================== */
+
+/*
+ * CL_DemoLoadMap — fresh map load and seed, identical for record and
+ * playback, so both begin from the same state.
+ */
+static qboolean CL_DemoLoadMap(void)
+{
+    char cmd[MAX_QPATH + 8];
+
+    Com_sprintf(cmd, sizeof(cmd), "map %s", demo.header.map);
+    Cmd_ExecuteString(cmd);
+
+    if (!R_WorldLoaded()) {
+        Com_Printf("Demo: couldn't load map %s\n", demo.header.map);
+        return qfalse;
+    }
+
+    srand((unsigned)demo.header.seed);
+    return qtrue;
+}
+
+static void CL_DemoStartRecording(void)
+{
+    char path[MAX_OSPATH];
+
+    if (!CL_DemoLoadMap())
+        return;
+
+    Com_sprintf(path, sizeof(path), "%s/demos", FS_Gamedir());
+    Sys_Mkdir(path);
+    Com_sprintf(path, sizeof(path), "%s/demos/%s.sdm", FS_Gamedir(), demo.name);
+
+    demo.file = fopen(path, "wb");
+    if (!demo.file) {
+        Com_Printf("Couldn't open %s for writing\n", path);
+        return;
+    }
+    fwrite(&demo.header, sizeof(demo.header), 1, demo.file);
+
+    demo.state = DEMO_RECORDING;
+    Com_Printf("Recording %s on %s\n", path, demo.header.map);
+}
+
+static void CL_DemoStartPlayback(void)
+{
+    if (!CL_DemoLoadMap()) {
+        FS_FreeFile(demo.buffer);
+        demo.buffer = NULL;
+        return;
+    }
+
+    demo.frame = 0;
+    demo.frame_ms = (float *)Z_Malloc(demo.header.numframes * sizeof(float));
+    memset(demo.phase_ms, 0, sizeof(demo.phase_ms));
+    demo.draw_calls = demo.state_changes = demo.visible_faces = 0;
+    demo.max_draws = 0;
+
+    /* Measure the engine, not the display */
+    demo.oldswap = Sys_SetSwapInterval(0);
+
+    demo.state = DEMO_PLAYING;
+    demo.run_start = Sys_PerfCounter();
+}
+
+/* ==========================================================================
+   Report
+   ========================================================================== */
+
+static int CL_DemoCompareFloat(const void *a, const void *b)
+{
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+static void CL_DemoReport(void)
+{
+    static const char *phase_names[DEMO_NUMPHASES] = { "sv", "cl", "render" };
+    int         n = demo.frame;
+    int         hist[DEMO_NUMBUCKETS];
+    float       *sorted;
+    double      total, sum = 0;
+    float       p50, p99, maxms;
+    char        path[MAX_OSPATH];
+    char        date[32];
+    time_t      now;
+    FILE        *f;
+    int         i, b;
+
+    if (n <= 0)
+        return;
+
+    total = (double)(Sys_PerfCounter() - demo.run_start) * 1000.0 / (double)Sys_PerfFrequency();
+
+    memset(hist, 0, sizeof(hist));
+    sorted = (float *)Z_Malloc(n * sizeof(float));
+    for (i = 0; i < n; i++) {
+        sorted[i] = demo.frame_ms[i];
+        sum += sorted[i];
+        for (b = 0; b < DEMO_NUMBUCKETS - 1 && sorted[i] > demo_buckets[b]; b++)
+            ;
+        hist[b]++;
+    }
+    qsort(sorted, n, sizeof(float), CL_DemoCompareFloat);
+    p50 = sorted[n / 2];
+    p99 = sorted[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+    maxms = sorted[n - 1];
+    Z_Free(sorted);
+
+    Com_Printf("timedemo %s: %d frames, %.1f seconds, %.1f fps\n",
+        demo.name, n, total / 1000.0, n * 1000.0 / total);
+    Com_Printf("  frame ms: avg %.2f  p50 %.2f  p99 %.2f  max %.2f\n",
+        sum / n, p50, p99, maxms);
+    Com_Printf("  split ms: sv %.2f  cl %.2f  render %.2f\n",
+        demo.phase_ms[0] / n, demo.phase_ms[1] / n, demo.phase_ms[2] / n);
+    Com_Printf("  world: %.0f draws (max %d), %.0f binds, %.0f faces per frame\n",
+        demo.draw_calls / n, demo.max_draws, demo.state_changes / n,
+        demo.visible_faces / n);
+
+    /* One JSON object per line so runs from many builds can be diffed */
+    Com_sprintf(path, sizeof(path), "%s/timedemo.log", FS_Gamedir());
+    f = fopen(path, "a");
+    if (!f) {
+        Com_Printf("Couldn't write %s\n", path);
+        return;
+    }
+
+    now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(f, "{\"demo\":\"%s\",\"map\":\"%s\",\"version\":\"%s\",\"date\":\"%s\","
+        "\"width\":%d,\"height\":%d,\"frames\":%d,\"seconds\":%.3f,\"fps\":%.2f,",
+        demo.name, demo.header.map, Cvar_VariableString("version"), date,
+        g_display.width, g_display.height, n, total / 1000.0, n * 1000.0 / total);
+    fprintf(f, "\"frame_ms\":{\"avg\":%.3f,\"p50\":%.3f,\"p99\":%.3f,\"max\":%.3f},",
+        sum / n, p50, p99, maxms);
+
+    fprintf(f, "\"split_ms\":{");
+    for (i = 0; i < DEMO_NUMPHASES; i++)
+        fprintf(f, "%s\"%s\":%.3f", i ? "," : "", phase_names[i], demo.phase_ms[i] / n);
+    fprintf(f, "},");
+
+    fprintf(f, "\"world\":{\"draw_calls\":%.1f,\"draw_calls_max\":%d,"
+        "\"state_changes\":%.1f,\"visible_faces\":%.1f},",
+        demo.draw_calls / n, demo.max_draws, demo.state_changes / n,
+        demo.visible_faces / n);
+
+    fprintf(f, "\"histogram\":[");
+    for (b = 0; b < DEMO_NUMBUCKETS; b++) {
+        if (b < DEMO_NUMBUCKETS - 1)
+            fprintf(f, "%s{\"le\":%g,\"frames\":%d}", b ? "," : "", demo_buckets[b], hist[b]);
+        else
+            fprintf(f, ",{\"le\":null,\"frames\":%d}", hist[b]);
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+
+    Com_Printf("Results appended to %s\n", path);
+}
+
+/* ==========================================================================
+   Stopping
+   ========================================================================== */
+
+static void CL_DemoStop(qboolean report)
+{
+    if (demo.state == DEMO_RECORDING) {
+        fseek(demo.file, 0, SEEK_SET);
+        fwrite(&demo.header, sizeof(demo.header), 1, demo.file);
+        fclose(demo.file);
+        demo.file = NULL;
+        Com_Printf("Stopped recording %s, %d frames\n", demo.name, demo.header.numframes);
+    } else if (demo.state == DEMO_PLAYING) {
+        if (report)
+            CL_DemoReport();
+        else
+            Com_Printf("Stopped timedemo %s after %d frames\n", demo.name, demo.frame);
+
+        Sys_SetSwapInterval(demo.oldswap);
+        Z_Free(demo.frame_ms);
+        demo.frame_ms = NULL;
+        FS_FreeFile(demo.buffer);
+        demo.buffer = NULL;
+        demo.frames = NULL;
+
+        if (report && timedemo_quit->value)
+            Cbuf_AddText("quit\n");
+    }
+
+    /* A timedemo that was queued but never started */
+    if (demo.pending && demo.buffer) {
+        FS_FreeFile(demo.buffer);
+        demo.buffer = NULL;
+    }
+
+    demo.state = DEMO_IDLE;
+    demo.pending = qfalse;
+}
+
+/* ==========================================================================
+   Frame Hooks (called from Qcommon_Frame / CL_Frame)
+   ========================================================================== */
+
+qboolean CL_DemoPlaying(void)
+{
+    return demo.state == DEMO_PLAYING;
+}
+
+/*
+ * CL_DemoBeginFrame — top of Qcommon_Frame. Starts a pending record or
+ * timedemo (so the map load is never part of a measured frame) and, during
+ * playback, replaces the frame time with the recorded one.
+ */
+int CL_DemoBeginFrame(int msec)
+{
+    if (demo.pending) {
+        demo.pending = qfalse;
+        if (demo.buffer)
+            CL_DemoStartPlayback();
+        else
+            CL_DemoStartRecording();
+    }
+
+    if (demo.state == DEMO_RECORDING) {
+        /* The frame after the map load sees the whole load as its msec */
+        if (msec > 100)
+            msec = 100;
+        memset(&demo.rec, 0, sizeof(demo.rec));
+        demo.rec.msec = msec;
+    } else if (demo.state == DEMO_PLAYING) {
+        msec = demo.frames[demo.frame].msec;
+        if (msec < 1)
+            msec = 1;
+    } else {
+        return msec;
+    }
+
+    demo.t_start = demo.t_mark = Sys_PerfCounter();
+    memset(demo.t_phase, 0, sizeof(demo.t_phase));
+    return msec;
+}
+
+/*
+ * CL_DemoReadCmd — during playback, the command to send this frame.
+ * Returns qfalse when the recorded frame didn't send one.
+ */
+qboolean CL_DemoReadCmd(usercmd_t *cmd)
+{
+    demoframe_t *fr = &demo.frames[demo.frame];
+
+    *cmd = fr->cmd;
+    return (fr->flags & DF_CMD) ? qtrue : qfalse;
+}
+
+void CL_DemoWriteCmd(const usercmd_t *cmd)
+{
+    if (demo.state != DEMO_RECORDING)
+        return;
+    demo.rec.cmd = *cmd;
+    demo.rec.flags |= DF_CMD;
+}
+
+/*
+ * CL_DemoCamera — after CL_Frame, before anything renders. Records the
+ * view, or forces the recorded one back onto the renderer.
+ */
+void CL_DemoCamera(void)
+{
+    if (demo.state == DEMO_RECORDING) {
+        R_GetCameraOrigin(demo.rec.origin);
+        R_GetCameraAngles(demo.rec.angles);
+    } else if (demo.state == DEMO_PLAYING) {
+        R_SetCameraOrigin(demo.frames[demo.frame].origin);
+        R_SetCameraAngles(demo.frames[demo.frame].angles);
+    }
+}
+
+/* Close the current sv/cl phase of a timed frame */
+void CL_DemoMark(int phase)
+{
+    uint64_t now;
+
+    if (demo.state != DEMO_PLAYING)
+        return;
+    now = Sys_PerfCounter();
+    demo.t_phase[phase] += now - demo.t_mark;
+    demo.t_mark = now;
+}
+
+void CL_DemoEndFrame(void)
+{
+    double  tick_ms;
+
+    if (demo.state == DEMO_RECORDING) {
+        fwrite(&demo.rec, sizeof(demo.rec), 1, demo.file);
+        demo.header.numframes++;
+        return;
+    }
+
+    if (demo.state != DEMO_PLAYING)
+        return;
+
+    /* Everything after the client phase is rendering */
+    CL_DemoMark(DEMO_PHASE_RENDER);
+
+    tick_ms = 1000.0 / (double)Sys_PerfFrequency();
+    demo.frame_ms[demo.frame] = (float)((double)(demo.t_mark - demo.t_start) * tick_ms);
+    demo.phase_ms[DEMO_PHASE_SV] += (double)demo.t_phase[DEMO_PHASE_SV] * tick_ms;
+    demo.phase_ms[DEMO_PHASE_CL] += (double)demo.t_phase[DEMO_PHASE_CL] * tick_ms;
+    demo.phase_ms[DEMO_PHASE_RENDER] += (double)demo.t_phase[DEMO_PHASE_RENDER] * tick_ms;
+    demo.draw_calls += c_brush_polys;
+    demo.state_changes += c_state_changes;
+    demo.visible_faces += c_visible_faces;
+    if (c_brush_polys > demo.max_draws)
+        demo.max_draws = c_brush_polys;
+
+    if (++demo.frame >= demo.header.numframes)
+        CL_DemoStop(qtrue);
+}
+
+/* ==========================================================================
+   Console Commands
+   ========================================================================== */
+
+static void CL_Record_f(void)
+{
+    const char *map;
+
+    if (Cmd_Argc() < 2) {
+        Com_Printf("usage: record <demoname> [map]\n");
+        return;
+    }
+    if (demo.state != DEMO_IDLE || demo.pending) {
+        Com_Printf("Already recording or playing, use stop first\n");
+        return;
+    }
+    /* Frames are paced by the game tick; a free-running sim would drift */
+    if (SV_SimThreadActive()) {
+        Com_Printf("Demos need sv_simthread 0\n");
+        return;
+    }
+
+    if (Cmd_Argc() > 2) {
+        map = Cmd_Argv(2);
+    } else {
+        bsp_world_t *world = R_GetWorldModel();
+        char        *slash;
+
+        if (!world || !world->loaded) {
+            Com_Printf("No map running, use record <demoname> <map>\n");
+            return;
+        }
+        /* world->name is maps/<map>.bsp */
+        slash = strrchr(world->name, '/');
+        map = slash ? slash + 1 : world->name;
+    }
+
+    memset(&demo.header, 0, sizeof(demo.header));
+    demo.header.ident = DEMO_IDENT;
+    demo.header.version = DEMO_VERSION;
+    Q_strncpyz(demo.header.map, map, sizeof(demo.header.map));
+    if (strstr(demo.header.map, ".bsp"))
+        *strstr(demo.header.map, ".bsp") = 0;
+    demo.header.seed = Sys_Milliseconds();
+
+    Q_strncpyz(demo.name, Cmd_Argv(1), sizeof(demo.name));
+    demo.buffer = NULL;
+    demo.pending = qtrue;
+}
+
+static void CL_Stop_f(void)
+{
+    if (demo.state == DEMO_IDLE && !demo.pending) {
+        Com_Printf("Not recording or playing a demo\n");
+        return;
+    }
+    CL_DemoStop(qfalse);
+}
+
+static void CL_Timedemo_f(void)
+{
+    char            path[MAX_QPATH];
+    demoheader_t    *header;
+    int             len;
+
+    if (Cmd_Argc() != 2) {
+        Com_Printf("usage: timedemo <demoname>\n");
+        return;
+    }
+    if (demo.state != DEMO_IDLE || demo.pending) {
+        Com_Printf("Already recording or playing, use stop first\n");
+        return;
+    }
+    /* Frames are paced by the game tick; a free-running sim would drift */
+    if (SV_SimThreadActive()) {
+        Com_Printf("Demos need sv_simthread 0\n");
+        return;
+    }
+
+    Com_sprintf(path, sizeof(path), "demos/%s.sdm", Cmd_Argv(1));
+    len = FS_LoadFile(path, &demo.buffer);
+    if (!demo.buffer) {
+        Com_Printf("Couldn't load %s\n", path);
+        return;
+    }
+
+    header = (demoheader_t *)demo.buffer;
+    if (len < (int)sizeof(*header) || header->ident != DEMO_IDENT ||
+        header->version != DEMO_VERSION) {
+        Com_Printf("%s is not a version %d demo\n", path, DEMO_VERSION);
+        FS_FreeFile(demo.buffer);
+        demo.buffer = NULL;
+        return;
+    }
+
+    /* Trust the file length over a header a crash never patched */
+    demo.header = *header;
+    demo.header.numframes = (len - (int)sizeof(*header)) / (int)sizeof(demoframe_t);
+    if (demo.header.numframes <= 0) {
+        Com_Printf("%s has no frames\n", path);
+        FS_FreeFile(demo.buffer);
+        demo.buffer = NULL;
+        return;
+    }
+    demo.frames = (demoframe_t *)(header + 1);
+
+    Q_strncpyz(demo.name, Cmd_Argv(1), sizeof(demo.name));
+    demo.pending = qtrue;
+}
+
+void CL_DemoInit(void)
+{
+    timedemo_quit = Cvar_Get("timedemo_quit", "0", 0);
+
+    Cmd_AddCommand("record", CL_Record_f);
+    Cmd_AddCommand("stop", CL_Stop_f);
+    Cmd_AddCommand("timedemo", CL_Timedemo_f);
+}
@@ -0,0 +1,153 @@
+/*
+ * cl_pred.c - Client-side movement prediction
+ *
+ * With cl_predict 1 and the game ticking on its own thread (sv_simthread),
+ * CL_Frame's usercmds aren't run through the game's ClientThink as they
+ * are made. They are queued for the game's next tick, the way a server
+ * receives them, and the view is predicted instead: every frame the
+ * player's movement state as of the last tick is run forward through the
+ * shared Pmove over the commands the game hasn't run yet. Mouse look and
+ * movement respond at the display rate while the game simulates at 10 Hz.
+ *
+ * When a tick has run some of the commands, the origin it reached is
+ * compared with the one predicted for the same command. Small misses
+ * (ladders, crouch, anything ClientThink does beyond Pmove) are blended
+ * out over a tenth of a second; large ones are teleports and snap.
+ * cl_showmiss 1 prints each miss.
+ *
+ * Everything here runs with the game locked, from CL_Frame, so the player
+ * traces can clip against live entities, and the sim thread is never
+ * inside Pmove (which keeps its state in statics) at the same time.
+ *
+ * Without the sim thread, or during timedemo playback, commands go
+ * straight to ClientThink and there is nothing to predict.
+ *
+ * Based on Q2 cl_pred.c (id Software GPL)
+ */
+
+#include "../common/qcommon.h"
+
+#define CMD_BACKUP      256     /* at least SV_CMD_QUEUE: all the game may not have run */
+#define CMD_MASK        (CMD_BACKUP - 1)
+
+#define PRED_SMOOTH_MSEC    100     /* blend a miss out over this long */
+#define PRED_SNAP_DIST      64      /* misses further than this are teleports */
+
+static struct {
+    usercmd_t   cmds[CMD_BACKUP];
+    vec3_t      origins[CMD_BACKUP];    /* where each command was predicted to end */
+    int         sequence;               /* last command sent */
+    int         predicted;              /* last command origins[] holds */
+    int         ack;                    /* last acknowledgement seen */
+
+    vec3_t      error;                  /* predicted - actual, at error_time */
+    int         error_time;
+} cl_pred;
+
+static cvar_t   *cl_predict;
+static cvar_t   *cl_showmiss;
+
+static qboolean CL_PredictActive(void)
+{
+    return cl_predict->value && SV_SimThreadActive() && !CL_DemoPlaying();
+}
+
+/*
+ * CL_SendCmd — Hand this frame's command to the game: queued for its next
+ * tick when predicting, run at once otherwise
+ */
+void CL_SendCmd(usercmd_t *cmd)
+{
+    int seq = ++cl_pred.sequence;
+
+    cl_pred.cmds[seq & CMD_MASK] = *cmd;
+
+    if (CL_PredictActive())
+        SV_QueueClientThink(cmd, seq);
+    else
+        SV_RunClientThink(cmd, seq);
+}
+
+/* A tick has run the commands up to ack: see how far off we were */
+static void CL_CheckPredictionError(const pmove_state_t *ps, int ack)
+{
+    vec3_t  delta;
+    float   len;
+
+    if (ack > cl_pred.predicted || cl_pred.predicted - ack >= CMD_BACKUP)
+        return;     /* never predicted it */
+
+    VectorSubtract(cl_pred.origins[ack & CMD_MASK], ps->origin, delta);
+    len = VectorLength(delta);
+
+    if (cl_showmiss->value && len > 0.1f)
+        Com_Printf("prediction miss on %i: %.1f\n", ack, len);
+
+    /* Whatever is still being blended out is folded into the new miss */
+    if (len > PRED_SNAP_DIST) {
+        VectorClear(cl_pred.error);
+    } else {
+        int ms = Sys_Milliseconds() - cl_pred.error_time;
+
+        if (ms < PRED_SMOOTH_MSEC)
+            VectorMA(delta, 1.0f - (float)ms / PRED_SMOOTH_MSEC, cl_pred.error, delta);
+        VectorCopy(delta, cl_pred.error);
+    }
+    cl_pred.error_time = Sys_Milliseconds();
+}
+
+/*
+ * CL_PredictView — Where the player's view is, counting the commands the
+ * game hasn't run yet. Leaves the authoritative origin, angles and
+ * velocity alone and returns qfalse when there is nothing to predict.
+ */
+qboolean CL_PredictView(vec3_t origin, vec3_t angles, vec3_t velocity)
+{
+    pmove_state_t   ps;
+    pmove_t         pm;
+    int             ack, seq, ms;
+
+    if (!CL_PredictActive() || !SV_GetPredictionState(&ps, &ack))
+        return qfalse;
+
+    if (ack != cl_pred.ack) {
+        CL_CheckPredictionError(&ps, ack);
+        cl_pred.ack = ack;
+    }
+
+    if (ps.pm_type != PM_NORMAL && ps.pm_type != PM_SPECTATOR)
+        return qfalse;
+    if (ps.pm_flags & PMF_NO_PREDICTION)
+        return qfalse;
+    if (cl_pred.sequence - ack >= CMD_BACKUP)
+        return qfalse;      /* the game is too far behind to catch up with */
+
+    memset(&pm, 0, sizeof(pm));
+    pm.s = ps;
+    pm.trace = SV_PlayerTrace;
+    pm.pointcontents = SV_PointContents;
+
+    for (seq = ack + 1; seq <= cl_pred.sequence; seq++) {
+        pm.cmd = cl_pred.cmds[seq & CMD_MASK];
+        Pmove(&pm);
+        VectorCopy(pm.s.origin, cl_pred.origins[seq & CMD_MASK]);
+    }
+    cl_pred.predicted = cl_pred.sequence;
+
+    VectorCopy(pm.s.origin, origin);
+    VectorCopy(pm.s.velocity, velocity);
+    if (ack < cl_pred.sequence)
+        VectorCopy(pm.viewangles, angles);
+
+    ms = Sys_Milliseconds() - cl_pred.error_time;
+    if (ms >= 0 && ms < PRED_SMOOTH_MSEC)
+        VectorMA(origin, 1.0f - (float)ms / PRED_SMOOTH_MSEC, cl_pred.error, origin);
+
+    return qtrue;
+}
+
+void CL_InitPrediction(void)
+{
+    cl_predict = Cvar_Get("cl_predict", "1", CVAR_ARCHIVE);
+    cl_showmiss = Cvar_Get("cl_showmiss", "0", 0);
+}
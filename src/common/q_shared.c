@@ -102,6 +102,23 @@ int Q_strncasecmp(const char *s1, const char *s2, int n)
     return 0;
 }
 
+/*
+ * Com_HashString — case-folded FNV-1a. Folds exactly like Q_stricmp, so two
+ * names that compare equal always land in the same bucket.
+ */
+unsigned Com_HashString(const char *s)
+{
+    unsigned hash = 2166136261u;
+    int c;
+
+    while ((c = *s++) != 0) {
+        if (c >= 'A' && c <= 'Z') c += ('a' - 'A');
+        hash ^= (unsigned)(unsigned char)c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 void Q_strncpyz(char *dest, const char *src, int destsize)
 {
     if (!dest || !src || destsize < 1)
@@ -121,6 +121,10 @@ typedef enum {
 
 #define VectorCompare(v1,v2)    ((v1)[0]==(v2)[0]&&(v1)[1]==(v2)[1]&&(v1)[2]==(v2)[2])
 
+/* Angles as 16 bits of a turn, for usercmds and the network */
+#define ANGLE2SHORT(x)  ((int)((x)*65536.0f/360.0f) & 65535)
+#define SHORT2ANGLE(x)  ((x)*(360.0f/65536.0f))
+
 vec_t   VectorLength(vec3_t v);
 vec_t   VectorNormalize(vec3_t v);
 void    CrossProduct(vec3_t v1, vec3_t v2, vec3_t cross);
@@ -148,6 +152,7 @@ int     Q_strncasecmp(const char *s1, const char *s2, int n);
 void    Com_sprintf(char *dest, int size, const char *fmt, ...);
 char    *va(const char *format, ...);
 void    Q_strncpyz(char *dest, const char *src, int destsize);
+unsigned Com_HashString(const char *s);    /* case-folded, matches Q_stricmp */
 
 /* ==========================================================================
    Random Numbers (SoF exports)
@@ -185,6 +190,7 @@ typedef struct cvar_s {
     int         modified;           /* set each time the cvar is changed */
     float       value;
     struct cvar_s *next;
+    struct cvar_s *hash_next;       /* engine only: Cvar_FindVar bucket chain */
 } cvar_t;
 
 /* ==========================================================================
@@ -220,6 +226,13 @@ typedef struct {
     struct edict_s *ent;        /* not set by CM_*() functions */
 } trace_t;
 
+/* One trace of a batch (gi.trace_batch, CM_BoxTraceBatch) */
+typedef struct {
+    vec3_t      start, end;
+    vec3_t      mins, maxs;     /* all zero for a point trace */
+    trace_t     trace;          /* result */
+} tracequery_t;
+
 /* Content flags (BSP) */
 #define CONTENTS_SOLID          1
 #define CONTENTS_WINDOW         2
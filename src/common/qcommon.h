@@ -47,6 +47,10 @@ void    Cvar_SetValue(const char *var_name, float value);
 float   Cvar_VariableValue(const char *var_name);
 char    *Cvar_VariableString(const char *var_name);
 cvar_t  *Cvar_FindVar(const char *var_name);
+/* cvar_t pointers are never freed; hold on to them instead of re-looking
+ * names up in per-frame code, and write through these */
+cvar_t  *Cvar_SetVar(cvar_t *var, const char *value, qboolean force);
+void    Cvar_SetVarValue(cvar_t *var, float value);
 void    Cvar_WriteVariables(const char *path);
 char    *Cvar_Userinfo(void);
 char    *Cvar_Serverinfo(void);
@@ -58,6 +62,8 @@ char    *Cvar_Serverinfo(void);
 #define Z_TAG_GENERAL   0
 #define Z_TAG_LEVEL     1
 #define Z_TAG_GAME      2
+#define Z_TAG_TEMP      3       /* short-lived scratch, reset by its owner */
+#define Z_NUMTAGS       4       /* LEVEL and TEMP are arena-backed */
 
 void    Z_Init(void);
 void    *Z_Malloc(int size);
@@ -65,6 +71,7 @@ void    *Z_TagMalloc(int size, int tag);
 void    Z_Free(void *ptr);
 void    Z_Touch(void *ptr);
 void    Z_FreeTags(int tag);
+void    Z_Stats_f(void);
 
 /* ==========================================================================
    Hunk Memory (Large Persistent Allocations)
@@ -75,6 +82,42 @@ void    *Hunk_Alloc(int size);
 int     Hunk_End(void);
 void    Hunk_Free(void *base);
 
+/* Frame scratch: valid until the next Qcommon_Frame, main thread only,
+ * not zeroed. See z_zone.c. */
+void    *Z_FrameAlloc(int size);
+void    Z_FrameReset(void);
+void    Z_FrameStats_f(void);
+
+/* ==========================================================================
+   Profiler (prof.c)
+   ========================================================================== */
+
+/* Nestable timing zones. Names must be string literals — they are kept by
+ * pointer. Begin/End pair up per thread and may be used from any thread.
+ * Prof_Begin is a single branch while com_profile is 0. */
+void    Prof_Init(void);
+void    Prof_FrameBegin(void);
+void    Prof_FrameEnd(void);
+void    Prof_Begin(const char *name);
+void    Prof_End(void);
+void    Prof_DrawOverlay(void);
+
+/* Map load phases, for map_load_profile. Phases nest and time goes to the
+ * innermost one; outside Prof_MapLoadStart/Finish they do nothing. */
+#define LOAD_BSP            0
+#define LOAD_LIGHTMAPS      1
+#define LOAD_TEXTURES       2
+#define LOAD_ENTITIES       3
+#define LOAD_SCRIPTS        4
+#define LOAD_SOUNDS         5
+#define LOAD_NAV            6
+#define LOAD_NUM_PHASES     7
+
+void    Prof_MapLoadStart(const char *mapname);
+void    Prof_MapLoadBegin(int phase);
+void    Prof_MapLoadEnd(void);
+void    Prof_MapLoadFinish(void);
+
 /* ==========================================================================
    Filesystem
    ========================================================================== */
@@ -100,6 +143,52 @@ int     FS_Write(const void *buffer, int len, fileHandle_t f);
 int     FS_LoadFile(const char *path, void **buffer);
 void    FS_FreeFile(void *buffer);
 
+/* Read-only views: zero-copy when the file lives in a mapped pak.
+ * Not null terminated — always honour the returned length. */
+int     FS_MapFile(const char *path, const void **view);
+void    FS_UnmapFile(const void *view);
+
+/* Which copy of a file FS_FOpenFile resolves to, for derived-data caches */
+qboolean FS_FileStamp(const char *path, char *stamp, int size);
+
+/* Background loader (fs_async.c). `work` runs on a worker thread and may
+ * only use FS_MapFile/FS_LoadFile/FS_FileStamp, Z_Malloc and plain file
+ * I/O — no GL, no console, no cvars. `done` runs later on the main thread
+ * from FS_AsyncPump. Any thread may queue; only the main thread pumps. */
+typedef void (*fsasyncfunc_t)(void *ctx);
+
+void    FS_AsyncInit(void);
+void    FS_AsyncShutdown(void);
+void    FS_AsyncQueue(fsasyncfunc_t work, fsasyncfunc_t done, void *ctx);
+int     FS_AsyncPump(qboolean block);   /* returns completions run */
+void    FS_AsyncWait(void);             /* drain everything queued */
+int     FS_AsyncPending(void);
+qboolean FS_AsyncMainThread(void);
+
+/* ==========================================================================
+   Jobs (jobs.c)
+   ========================================================================== */
+
+/* Work-stealing pool shared by every subsystem; see jobs.c. A job is
+ * func(ctx, index) and must not call GL or touch cvars. A counter counts
+ * the unfinished jobs added with it; zero it before first use. Zone names
+ * are profiler zones, so string literals. */
+typedef void (*jobfunc_t)(void *ctx, int index);
+
+typedef struct {
+    volatile int    count;
+    struct job_s    *waiting;       /* Job_AddAfter jobs held on this counter */
+} jobcounter_t;
+
+void    Job_Init(void);
+void    Job_Shutdown(void);
+void    Job_Add(const char *zone, jobfunc_t func, void *ctx, int index, jobcounter_t *counter);
+void    Job_AddAfter(jobcounter_t *after, const char *zone, jobfunc_t func, void *ctx,
+                     int index, jobcounter_t *counter);
+void    Job_Wait(jobcounter_t *counter);
+void    Job_ParallelFor(const char *zone, jobfunc_t func, void *ctx, int count);
+int     Job_Threads(void);              /* workers + the calling thread */
+
 char    **FS_ListFiles(const char *findname, int *numfiles);
 void    FS_FreeFileList(char **list, int nfiles);
 
@@ -139,6 +228,12 @@ typedef struct {
     unsigned short  port;
 } netadr_t;
 
+#define PROTOCOL_VERSION    1000    /* ours, not the original 33 */
+#define PORT_SERVER         27910
+
+#define MAX_MSGLEN          1400    /* max length of a message, one packet */
+#define PACKET_HEADER       10      /* two ints and a short */
+
 /* ==========================================================================
    Network Message Buffers
    ========================================================================== */
@@ -150,6 +245,8 @@ typedef struct {
     int         maxsize;
     int         cursize;
     int         readcount;
+    int         bit;            /* bits used of the last byte, 0 = aligned */
+    int         readbit;        /* bits read of the last byte read */
 } sizebuf_t;
 
 void    SZ_Init(sizebuf_t *buf, byte *data, int length);
@@ -187,6 +284,115 @@ float   MSG_ReadAngle16(sizebuf_t *sb);
 void    MSG_ReadDir(sizebuf_t *sb, vec3_t dir);
 void    MSG_ReadDeltaUsercmd(sizebuf_t *sb, void *from, void *cmd);
 
+/* Bit-packed fields. Bits pack into the bytes MSG_WriteBits adds; the next
+ * byte-aligned write or read starts a fresh byte. A read past the end
+ * returns -1 and leaves readcount past cursize. */
+#define ENTNUM_BITS         11      /* MAX_EDICTS is a valid end marker */
+
+void    MSG_WriteBits(sizebuf_t *sb, int value, int bits);
+int     MSG_ReadBits(sizebuf_t *sb, int bits);
+int     MSG_ReadSBits(sizebuf_t *sb, int bits);
+
+/* Delta compression. A NULL to removes the entity; nothing is written for
+ * an unchanged one unless force is set. The reader is handed the number
+ * the caller read and returns qfalse for a removal. */
+void    MSG_WriteDeltaEntity(sizebuf_t *sb, const entity_state_t *from,
+                             const entity_state_t *to, qboolean force);
+qboolean MSG_ReadDeltaEntity(sizebuf_t *sb, const entity_state_t *from,
+                             entity_state_t *to, int number);
+void    MSG_WriteDeltaPmove(sizebuf_t *sb, const pmove_state_t *from,
+                            const pmove_state_t *to);
+void    MSG_ReadDeltaPmove(sizebuf_t *sb, const pmove_state_t *from,
+                           pmove_state_t *to);
+
+/* UDP sockets (engine/net_udp.c). The server socket opens for dedicated
+ * servers, or with net_listen 1. */
+void    NET_Init(void);
+void    NET_Shutdown(void);
+void    NET_Config(qboolean open);
+qboolean NET_IsOpen(void);
+qboolean NET_GetPacket(netadr_t *from, sizebuf_t *msg);
+void    NET_SendPacket(int length, const void *data, const netadr_t *to);
+qboolean NET_StringToAdr(const char *s, netadr_t *a);
+const char *NET_AdrToString(const netadr_t *a);
+qboolean NET_CompareAdr(const netadr_t *a, const netadr_t *b);
+qboolean NET_CompareBaseAdr(const netadr_t *a, const netadr_t *b);
+
+/* ==========================================================================
+   Network Channel (engine/net_chan.c)
+   Sequenced unreliable packets, each of which can carry the one reliable
+   message in flight until it is acknowledged.
+   ========================================================================== */
+
+typedef struct {
+    int         in_bytes, out_bytes;        /* totals, headers included */
+    int         in_packets, out_packets;
+    int         dropped;                    /* incoming packets missed */
+    int         largest_out;
+    int         in_rate, out_rate;          /* bytes over the last second */
+    int         rate_time;                  /* Sys_Milliseconds the window began */
+    int         rate_in, rate_out;          /* this window so far */
+} netstats_t;
+
+typedef struct {
+    qboolean    fatal_error;
+    qboolean    client;                     /* our end is the client's */
+
+    netadr_t    remote_address;
+    int         qport;                      /* client's, survives NAT port changes */
+
+    int         last_received;              /* Sys_Milliseconds */
+    int         last_sent;
+
+    /* sequencing variables */
+    int         incoming_sequence;
+    int         incoming_acknowledged;
+    int         incoming_reliable_acknowledged; /* single bit */
+    int         incoming_reliable_sequence;     /* single bit, maintained locally */
+
+    int         outgoing_sequence;
+    int         reliable_sequence;          /* single bit */
+    int         last_reliable_sequence;     /* sequence number of last send */
+
+    /* reliable staging and holding areas */
+    sizebuf_t   message;                    /* writing buffer to send to server */
+    byte        message_buf[MAX_MSGLEN - 16];
+
+    int         reliable_length;
+    byte        reliable_buf[MAX_MSGLEN - 16];  /* unacked reliable message */
+
+    netstats_t  stats;
+} netchan_t;
+
+void    Netchan_Init(void);
+void    Netchan_Setup(netchan_t *chan, qboolean client, const netadr_t *adr, int qport);
+qboolean Netchan_NeedReliable(const netchan_t *chan);
+void    Netchan_Transmit(netchan_t *chan, int length, const byte *data);
+void    Netchan_OutOfBand(const netadr_t *adr, int length, const byte *data);
+void    Netchan_OutOfBandPrint(const netadr_t *adr, const char *format, ...);
+qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg);
+qboolean Netchan_CanReliable(const netchan_t *chan);
+
+/* Server to client */
+enum svc_ops_e {
+    svc_bad,
+    svc_disconnect,
+    svc_print,              /* [string] */
+    svc_serverdata,         /* [long protocol] [long servercount] [short edict] [string map] */
+    svc_configstring,       /* [short index] [string] */
+    svc_baselines,          /* bit-packed entities from nothing, MAX_EDICTS ends */
+    svc_gamestate_done,     /* answer "begin <servercount>" */
+    svc_frame               /* [long frame] [long deltaframe] pmove, entities */
+};
+
+/* Client to server */
+enum clc_ops_e {
+    clc_bad,
+    clc_nop,
+    clc_move,               /* [long lastframe] [byte count] delta usercmds */
+    clc_stringcmd           /* [string] */
+};
+
 /* ==========================================================================
    Engine Core
    ========================================================================== */
@@ -202,21 +408,118 @@ void    Sys_Error(const char *error, ...);
 char    *Sys_ConsoleInput(void);
 void    Sys_ConsoleOutput(const char *string);
 int     Sys_Milliseconds(void);
+uint64_t Sys_PerfCounter(void);
+uint64_t Sys_PerfFrequency(void);
 void    Sys_Mkdir(const char *path);
 char    *Sys_FindFirst(const char *path, unsigned musthave, unsigned canthave);
 char    *Sys_FindNext(unsigned musthave, unsigned canthave);
 void    Sys_FindClose(void);
 
+/* Threads — opaque handles; NULL mutex/semaphore arguments are no-ops */
+void    *Sys_CreateThread(int (*func)(void *), const char *name, void *arg);
+void    Sys_WaitThread(void *thread);
+unsigned long Sys_ThreadID(void);
+int     Sys_CPUCount(void);
+void    *Sys_CreateMutex(void);
+void    Sys_DestroyMutex(void *mutex);
+void    Sys_LockMutex(void *mutex);
+void    Sys_UnlockMutex(void *mutex);
+void    *Sys_CreateSemaphore(int value);
+void    Sys_DestroySemaphore(void *sem);
+void    Sys_SemPost(void *sem);
+int     Sys_SemWait(void *sem, int msec);
+int     Sys_AtomicAdd(volatile int *value, int delta);   /* returns the new value */
+void    Sys_Yield(void);
+
 /* Client and Server forward declarations */
 void    CL_Init(void);
 void    CL_Drop(void);
 void    CL_Shutdown(void);
 void    CL_Frame(int msec);
 
+/* Demo record / timedemo (client/cl_demo.c) */
+#define DEMO_PHASE_SV       0
+#define DEMO_PHASE_CL       1
+#define DEMO_PHASE_RENDER   2
+#define DEMO_NUMPHASES      3
+
+void    CL_DemoInit(void);
+qboolean CL_DemoPlaying(void);
+int     CL_DemoBeginFrame(int msec);    /* returns the msec to run */
+qboolean CL_DemoReadCmd(usercmd_t *cmd);
+void    CL_DemoWriteCmd(const usercmd_t *cmd);
+void    CL_DemoCamera(void);
+void    CL_DemoMark(int phase);
+void    CL_DemoEndFrame(void);
+
+/* Client-side movement prediction (client/cl_pred.c). Both run with the
+ * game locked, from CL_Frame. */
+void    CL_InitPrediction(void);
+void    CL_SendCmd(usercmd_t *cmd);
+qboolean CL_PredictView(vec3_t origin, vec3_t angles, vec3_t velocity);
+
 void    SV_Init(void);
 void    SV_Shutdown(const char *finalmsg, qboolean reconnect);
 void    SV_Frame(int msec);
 
+/* Entity snapshots (server/sv_snap.c). Published after every game tick;
+ * the renderer draws from these and never reads edicts. */
+#define SNAP_MAX_ENTITIES   MAX_EDICTS
+
+typedef struct {
+    entity_state_t  s;              /* s.old_origin is last tick's origin */
+    vec3_t          old_angles;
+    int             oldframe;
+    vec3_t          mins, maxs;
+    int             solid;
+    int             svflags;
+    int             health;
+    int             deadflag;
+    int             gore_zone_mask; /* GHOUL zones damaged / severed */
+    int             severed_zone_mask;
+    qboolean        client;
+} snapent_t;
+
+typedef struct {
+    int             sequence;       /* game ticks published, 0 = none yet */
+    uint64_t        time;           /* Sys_PerfCounter when published */
+    int             num_entities;
+    snapent_t       entities[SNAP_MAX_ENTITIES];
+} snapshot_t;
+
+void    SV_InitSnapshots(void);
+void    SV_ClearSnapshots(void);
+void    SV_PublishSnapshot(void);
+void    SV_AcquireSnapshot(void);
+const snapshot_t *SV_GetSnapshot(void);
+
+/* Game simulation thread (server/sv_thread.c), enabled by sv_simthread.
+ * While it runs, the main thread must hold the game lock around anything
+ * that touches live game or HUD state. All of these are no-ops when off. */
+void    SV_InitSimThread(void);
+void    SV_ShutdownSimThread(void);
+qboolean SV_SimThreadActive(void);
+float   SV_SimThreadLerp(void);
+void    SV_LockGame(void);
+void    SV_UnlockGame(void);
+void    SV_GameYield(void);
+
+/* Client command delivery (server/sv_game.c), game locked. Queued
+ * commands run at the start of the next game tick. */
+void    SV_QueueClientThink(const usercmd_t *cmd, int sequence);
+void    SV_RunClientThink(usercmd_t *cmd, int sequence);
+qboolean SV_GetPredictionState(pmove_state_t *ps, int *ack);
+trace_t SV_PlayerTrace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end);
+int     SV_PointContents(vec3_t point);
+
+/* Remote clients (server/sv_net.c), game locked */
+void    SV_InitNet(void);
+void    SV_ShutdownNet(void);
+void    SV_ReadPackets(void);
+void    SV_SendClientMessages(void);
+void    SV_NetMapChanged(void);
+void    SV_NetConfigstring(int index, const char *val);
+
 /* Game module interface */
 void    SV_InitGameProgs(void);
 void    SV_ShutdownGameProgs(void);
@@ -227,5 +530,6 @@ void    SV_SetConfigstring(int index, const char *val);
 
 /* Collision model — declared in r_bsp.h with full bsp_world_t type.
  * cm_trace.c includes r_bsp.h directly. */
+void    CM_Init(void);                  /* cm_capture / cm_bench commands */
 
 #endif /* QCOMMON_H */
@@ -12,6 +12,14 @@
  *   CM_BoxTrace     - Sweep AABB from start to end, return first hit
  *   CM_PointContents - Test what material type a point is inside
  *   CM_TransformedBoxTrace - Trace against an inline brush model
+ *   CM_BoxTraceBatch - Many world traces at once, spread over the job system
+ *
+ * Brush clipping normally runs through CM_TestBrushSides: each brush is
+ * first rejected against the swept bounds, then its sides are clipped four
+ * at a time with SSE or NEON, using separate point and box kernels. The
+ * scalar CM_TestBrush is kept as the reference; cm_capture records live
+ * trace queries and cm_bench replays them through both to time the
+ * difference and check they agree.
  *
  * Original addresses:
  *   CM_BoxTrace:         0x26A40
@@ -22,6 +30,18 @@
 #include "../common/qcommon.h"
 #include "../renderer/r_bsp.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CM_NEON
+#endif
+
+#define DIST_EPSILON    0.03125f
+
+extern bsp_world_t *R_GetWorldModel(void);
+
 /* ==========================================================================
    Trace State (per-trace, not global)
    ========================================================================== */
@@ -37,11 +57,27 @@ typedef struct {
 
     bsp_world_t *world;
 
+    int         *brushchecks;       /* per-brush checkcount, or NULL to test every visit */
     int         checkcount;         /* avoid double-testing brushes */
     qboolean    ispoint;            /* optimization: point trace (zero-size box) */
+    qboolean    reference;          /* scalar CM_TestBrush only, for cm_bench */
 } trace_work_t;
 
-static int cm_checkcount;           /* global brush check counter */
+/*
+ * Batch traces are split into one chunk per job thread, and each chunk
+ * keeps its own brush checkcounts so a brush that spans several leaves is
+ * only tested once per trace. Single traces run on whatever thread the
+ * caller is on and skip the dedup rather than share these.
+ */
+#define CM_MAX_CHUNKS   16
+
+typedef struct {
+    int         *brushchecks;
+    int         numbrushes;         /* brushchecks is sized for this many */
+    int         checkcount;
+} cm_chunk_t;
+
+static cm_chunk_t   cm_chunks[CM_MAX_CHUNKS];
 
 /* ==========================================================================
    Brush Testing
@@ -159,6 +195,280 @@ static void CM_TestBrush(trace_work_t *tw, bsp_brush_t *brush)
     }
 }
 
+/* ==========================================================================
+   Brush Side Kernels
+   ========================================================================== */
+
+/*
+ * Build the per-brush bounds and four-wide side groups the kernels read.
+ * Bounds come from the axial sides every compiled brush has; a brush
+ * without one in some direction is left open that way.
+ */
+void CM_InitBrushData(bsp_world_t *world)
+{
+    int i, j, numgroups = 0;
+
+    world->cmbrushes = NULL;
+    world->cmsides = NULL;
+    world->num_cmsides = 0;
+    if (world->num_brushes <= 0)
+        return;
+
+    for (i = 0; i < world->num_brushes; i++)
+        numgroups += (world->brushes[i].numsides + 3) / 4;
+
+    world->cmbrushes = Z_TagMalloc(world->num_brushes * (int)sizeof(bsp_cmbrush_t), Z_TAG_LEVEL);
+    if (numgroups)
+        world->cmsides = Z_TagMalloc(numgroups * (int)sizeof(bsp_cmsides_t), Z_TAG_LEVEL);
+    world->num_cmsides = numgroups;
+
+    for (i = 0, numgroups = 0; i < world->num_brushes; i++) {
+        bsp_brush_t     *brush = &world->brushes[i];
+        bsp_cmbrush_t   *cb = &world->cmbrushes[i];
+        int             lane = 4;
+
+        VectorSet(cb->mins, -1e30f, -1e30f, -1e30f);
+        VectorSet(cb->maxs, 1e30f, 1e30f, 1e30f);
+        cb->firstgroup = numgroups;
+
+        for (j = 0; j < brush->numsides; j++) {
+            int             sidenum = brush->firstside + j;
+            int             planenum;
+            bsp_plane_t     *plane;
+            bsp_cmsides_t   *g;
+            int             k;
+
+            if (sidenum < 0 || sidenum >= world->num_brushsides)
+                continue;
+            planenum = world->brushsides[sidenum].planenum;
+            if (planenum >= world->num_planes)
+                continue;   /* CM_TestBrush skips these too */
+            plane = &world->planes[planenum];
+
+            if (lane == 4) {
+                g = &world->cmsides[numgroups++];
+                for (k = 0; k < 4; k++) {
+                    g->normal[0][k] = g->normal[1][k] = g->normal[2][k] = 0;
+                    g->dist[k] = 1e30f;     /* always behind: never clips */
+                    g->plane[k] = -1;
+                }
+                lane = 0;
+            }
+            g = &world->cmsides[numgroups - 1];
+            for (k = 0; k < 3; k++)
+                g->normal[k][lane] = plane->normal[k];
+            g->dist[lane] = plane->dist;
+            g->plane[lane] = planenum;
+            lane++;
+
+            for (k = 0; k < 3; k++) {
+                if (plane->normal[(k + 1) % 3] != 0 || plane->normal[(k + 2) % 3] != 0)
+                    continue;
+                if (plane->normal[k] == 1)
+                    cb->maxs[k] = plane->dist;
+                else if (plane->normal[k] == -1)
+                    cb->mins[k] = -plane->dist;
+            }
+        }
+
+        cb->numgroups = numgroups - cb->firstgroup;
+    }
+}
+
+/*
+ * Start and end distances to four sides, with the planes pushed out by
+ * the box for box traces, in the same operation order as CM_TestBrush so
+ * the results match it bit for bit. Returns a bit per lane where the
+ * whole move is in front of that side, which misses the brush.
+ */
+static int CM_SideDistances(const trace_work_t *tw, const bsp_cmsides_t *g,
+                            float *d1, float *d2)
+{
+#if defined(CM_SSE)
+    __m128  nx = _mm_loadu_ps(g->normal[0]);
+    __m128  ny = _mm_loadu_ps(g->normal[1]);
+    __m128  nz = _mm_loadu_ps(g->normal[2]);
+    __m128  dist = _mm_loadu_ps(g->dist);
+    __m128  v1, v2, front;
+
+    if (!tw->ispoint) {
+        __m128 zero = _mm_setzero_ps();
+        __m128 negx = _mm_cmplt_ps(nx, zero);
+        __m128 negy = _mm_cmplt_ps(ny, zero);
+        __m128 negz = _mm_cmplt_ps(nz, zero);
+        __m128 ox = _mm_or_ps(_mm_and_ps(negx, _mm_set1_ps(tw->maxs[0])),
+                              _mm_andnot_ps(negx, _mm_set1_ps(tw->mins[0])));
+        __m128 oy = _mm_or_ps(_mm_and_ps(negy, _mm_set1_ps(tw->maxs[1])),
+                              _mm_andnot_ps(negy, _mm_set1_ps(tw->mins[1])));
+        __m128 oz = _mm_or_ps(_mm_and_ps(negz, _mm_set1_ps(tw->maxs[2])),
+                              _mm_andnot_ps(negz, _mm_set1_ps(tw->mins[2])));
+
+        dist = _mm_sub_ps(dist, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, ox),
+                                                      _mm_mul_ps(ny, oy)),
+                                           _mm_mul_ps(nz, oz)));
+    }
+
+    v1 = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tw->start[0]), nx),
+                                          _mm_mul_ps(_mm_set1_ps(tw->start[1]), ny)),
+                               _mm_mul_ps(_mm_set1_ps(tw->start[2]), nz)), dist);
+    v2 = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tw->end[0]), nx),
+                                          _mm_mul_ps(_mm_set1_ps(tw->end[1]), ny)),
+                               _mm_mul_ps(_mm_set1_ps(tw->end[2]), nz)), dist);
+    _mm_storeu_ps(d1, v1);
+    _mm_storeu_ps(d2, v2);
+
+    front = _mm_and_ps(_mm_cmpgt_ps(v1, _mm_setzero_ps()),
+                       _mm_or_ps(_mm_cmpge_ps(v2, _mm_set1_ps(DIST_EPSILON)),
+                                 _mm_cmpge_ps(v2, v1)));
+    return _mm_movemask_ps(front);
+#elif defined(CM_NEON)
+    float32x4_t nx = vld1q_f32(g->normal[0]);
+    float32x4_t ny = vld1q_f32(g->normal[1]);
+    float32x4_t nz = vld1q_f32(g->normal[2]);
+    float32x4_t dist = vld1q_f32(g->dist);
+    float32x4_t v1, v2;
+    uint32x4_t  front;
+    uint32_t    lanes[4];
+
+    if (!tw->ispoint) {
+        float32x4_t zero = vdupq_n_f32(0);
+        float32x4_t ox = vbslq_f32(vcltq_f32(nx, zero), vdupq_n_f32(tw->maxs[0]), vdupq_n_f32(tw->mins[0]));
+        float32x4_t oy = vbslq_f32(vcltq_f32(ny, zero), vdupq_n_f32(tw->maxs[1]), vdupq_n_f32(tw->mins[1]));
+        float32x4_t oz = vbslq_f32(vcltq_f32(nz, zero), vdupq_n_f32(tw->maxs[2]), vdupq_n_f32(tw->mins[2]));
+
+        dist = vsubq_f32(dist, vaddq_f32(vaddq_f32(vmulq_f32(nx, ox), vmulq_f32(ny, oy)),
+                                         vmulq_f32(nz, oz)));
+    }
+
+    v1 = vsubq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(nx, tw->start[0]), vmulq_n_f32(ny, tw->start[1])),
+                             vmulq_n_f32(nz, tw->start[2])), dist);
+    v2 = vsubq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(nx, tw->end[0]), vmulq_n_f32(ny, tw->end[1])),
+                             vmulq_n_f32(nz, tw->end[2])), dist);
+    vst1q_f32(d1, v1);
+    vst1q_f32(d2, v2);
+
+    front = vandq_u32(vcgtq_f32(v1, vdupq_n_f32(0)),
+                      vorrq_u32(vcgeq_f32(v2, vdupq_n_f32(DIST_EPSILON)), vcgeq_f32(v2, v1)));
+    vst1q_u32(lanes, front);
+    return (lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8);
+#else
+    int i, mask = 0;
+
+    for (i = 0; i < 4; i++) {
+        float dist = g->dist[i];
+
+        if (!tw->ispoint) {
+            float ofs_x = (g->normal[0][i] < 0) ? tw->maxs[0] : tw->mins[0];
+            float ofs_y = (g->normal[1][i] < 0) ? tw->maxs[1] : tw->mins[1];
+            float ofs_z = (g->normal[2][i] < 0) ? tw->maxs[2] : tw->mins[2];
+
+            dist -= g->normal[0][i] * ofs_x + g->normal[1][i] * ofs_y +
+                    g->normal[2][i] * ofs_z;
+        }
+        d1[i] = tw->start[0] * g->normal[0][i] + tw->start[1] * g->normal[1][i] +
+                tw->start[2] * g->normal[2][i] - dist;
+        d2[i] = tw->end[0] * g->normal[0][i] + tw->end[1] * g->normal[1][i] +
+                tw->end[2] * g->normal[2][i] - dist;
+        if (d1[i] > 0 && (d2[i] >= DIST_EPSILON || d2[i] >= d1[i]))
+            mask |= 1 << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * CM_TestBrush on the prepared side groups. The kernels do the plane
+ * distances for four sides at a time; the enter/leave bookkeeping stays
+ * scalar, side by side, so ties resolve exactly as in CM_TestBrush.
+ */
+static void CM_TestBrushSides(trace_work_t *tw, int brushnum)
+{
+    const bsp_cmbrush_t *cb = &tw->world->cmbrushes[brushnum];
+    const bsp_cmsides_t *g = &tw->world->cmsides[cb->firstgroup];
+    float       enter_frac = -1, leave_frac = 1;
+    qboolean    getout = qfalse, startout = qfalse;
+    bsp_plane_t *clipplane = NULL;
+    float       d1[4], d2[4];
+    int         i, lane;
+
+    if (!cb->numgroups)
+        return;
+
+    for (i = 0; i < cb->numgroups; i++, g++) {
+        if (CM_SideDistances(tw, g, d1, d2))
+            return;     /* in front of one side the whole way */
+
+        for (lane = 0; lane < 4 && g->plane[lane] >= 0; lane++) {
+            float f;
+
+            if (d2[lane] > 0)
+                getout = qtrue;
+            if (d1[lane] > 0)
+                startout = qtrue;
+
+            if (d1[lane] <= 0 && d2[lane] <= 0)
+                continue;
+
+            if (d1[lane] > d2[lane]) {
+                f = (d1[lane] - DIST_EPSILON) / (d1[lane] - d2[lane]);
+                if (f < 0) f = 0;
+                if (f > enter_frac) {
+                    enter_frac = f;
+                    clipplane = &tw->world->planes[g->plane[lane]];
+                }
+            } else {
+                f = (d1[lane] + DIST_EPSILON) / (d1[lane] - d2[lane]);
+                if (f > 1) f = 1;
+                if (f < leave_frac)
+                    leave_frac = f;
+            }
+        }
+    }
+
+    if (!startout) {
+        tw->trace.startsolid = qtrue;
+        if (!getout)
+            tw->trace.allsolid = qtrue;
+        return;
+    }
+
+    if (enter_frac < leave_frac) {
+        if (enter_frac > -1 && enter_frac < tw->trace.fraction) {
+            if (enter_frac < 0)
+                enter_frac = 0;
+            tw->trace.fraction = enter_frac;
+            if (clipplane) {
+                VectorCopy(clipplane->normal, tw->trace.plane.normal);
+                tw->trace.plane.dist = clipplane->dist;
+            }
+            tw->trace.contents = tw->world->brushes[brushnum].contents;
+        }
+    }
+}
+
+/*
+ * Clip against one brush: the kernels after a bounds reject, or the
+ * reference path. A brush whose bounds miss the swept box would fail
+ * one of its axial sides in CM_TestBrush anyway, so the reject is exact.
+ */
+static void CM_ClipToBrush(trace_work_t *tw, int brushnum)
+{
+    const bsp_cmbrush_t *cb;
+
+    if (tw->reference || !tw->world->cmbrushes) {
+        CM_TestBrush(tw, &tw->world->brushes[brushnum]);
+        return;
+    }
+
+    cb = &tw->world->cmbrushes[brushnum];
+    if (cb->mins[0] > tw->absmaxs[0] || cb->maxs[0] < tw->absmins[0] ||
+        cb->mins[1] > tw->absmaxs[1] || cb->maxs[1] < tw->absmins[1] ||
+        cb->mins[2] > tw->absmaxs[2] || cb->maxs[2] < tw->absmins[2])
+        return;
+
+    CM_TestBrushSides(tw, brushnum);
+}
+
 /* ==========================================================================
    Leaf Testing
    ========================================================================== */
@@ -192,7 +502,13 @@ static void CM_TestInLeaf(trace_work_t *tw, bsp_leaf_t *leaf)
             if (!(brush->contents & tw->contents))
                 continue;
 
-            CM_TestBrush(tw, brush);
+            if (tw->brushchecks) {
+                if (tw->brushchecks[brushnum] == tw->checkcount)
+                    continue;   /* already tested from another leaf */
+                tw->brushchecks[brushnum] = tw->checkcount;
+            }
+
+            CM_ClipToBrush(tw, brushnum);
 
             if (tw->trace.allsolid)
                 return;
@@ -205,7 +521,7 @@ static void CM_TestInLeaf(trace_work_t *tw, bsp_leaf_t *leaf)
             if (!(brush->contents & tw->contents))
                 continue;
 
-            CM_TestBrush(tw, brush);
+            CM_ClipToBrush(tw, i);
 
             if (tw->trace.allsolid)
                 return;
@@ -318,6 +634,93 @@ static void CM_RecursiveTrace(trace_work_t *tw, int num,
     CM_RecursiveTrace(tw, node->children[side ^ 1], midf, p2f, mid, p2);
 }
 
+/* ==========================================================================
+   Trace Capture
+   ========================================================================== */
+
+/*
+ * cm_capture <count> records the next count traces, from any thread, and
+ * writes them to traces/<map>.trc once the last one is in. Slots are
+ * claimed with an atomic add, and whichever thread fills the final one
+ * writes the file.
+ */
+#define CM_TRACE_IDENT      (('R' << 24) + ('T' << 16) + ('M' << 8) + 'C')
+#define CM_TRACE_VERSION    1
+#define CM_MAX_CAPTURE      (1 << 20)
+
+typedef struct {
+    int         ident;
+    int         version;
+    int         count;
+    char        map[MAX_QPATH];
+} cm_traceheader_t;
+
+typedef struct {
+    float       start[3], end[3];
+    float       mins[3], maxs[3];
+    int         brushmask;
+    int         headnode;
+} cm_tracerecord_t;
+
+static struct {
+    cm_tracerecord_t * volatile records;   /* NULL when not capturing */
+    int         max;
+    volatile int next;          /* slots claimed */
+    volatile int filled;        /* slots written */
+    char        map[MAX_QPATH];
+    char        path[MAX_OSPATH];
+} cm_capture;
+
+static void CM_WriteCapture(void)
+{
+    cm_tracerecord_t    *records = cm_capture.records;
+    cm_traceheader_t    header;
+    FILE                *f;
+
+    cm_capture.records = NULL;
+
+    memset(&header, 0, sizeof(header));
+    header.ident = CM_TRACE_IDENT;
+    header.version = CM_TRACE_VERSION;
+    header.count = cm_capture.max;
+    Q_strncpyz(header.map, cm_capture.map, sizeof(header.map));
+
+    f = fopen(cm_capture.path, "wb");
+    if (f && fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(records, sizeof(*records), cm_capture.max, f) == (size_t)cm_capture.max)
+        Com_Printf("cm_capture: wrote %d traces to %s\n", cm_capture.max, cm_capture.path);
+    else
+        Com_Printf("cm_capture: couldn't write %s\n", cm_capture.path);
+    if (f)
+        fclose(f);
+
+    Z_Free(records);
+}
+
+static void CM_CaptureTrace(const trace_work_t *tw, int headnode)
+{
+    cm_tracerecord_t    *records = cm_capture.records;
+    cm_tracerecord_t    *rec;
+    int                 slot;
+
+    if (!records)
+        return;
+    slot = Sys_AtomicAdd(&cm_capture.next, 1) - 1;
+    if (slot >= cm_capture.max)
+        return;
+
+    rec = &records[slot];
+    VectorCopy(tw->start, rec->start);
+    VectorCopy(tw->end, rec->end);
+    VectorCopy(tw->mins, rec->mins);
+    VectorCopy(tw->maxs, rec->maxs);
+    rec->brushmask = tw->contents;
+    rec->headnode = headnode;
+
+    if (Sys_AtomicAdd(&cm_capture.filled, 1) == cm_capture.max)
+        CM_WriteCapture();
+}
+
 /* ==========================================================================
    Public API
    ========================================================================== */
@@ -330,7 +733,8 @@ static void CM_RecursiveTrace(trace_work_t *tw, int num,
  */
 static trace_t CM_BoxTraceNode(bsp_world_t *world,
                                vec3_t start, vec3_t mins, vec3_t maxs,
-                               vec3_t end, int brushmask, int headnode)
+                               vec3_t end, int brushmask, int headnode,
+                               cm_chunk_t *chunk, qboolean reference)
 {
     trace_work_t tw;
     int i;
@@ -338,6 +742,11 @@ static trace_t CM_BoxTraceNode(bsp_world_t *world,
     memset(&tw, 0, sizeof(tw));
     tw.world = world;
     tw.contents = brushmask;
+    tw.reference = reference;
+    if (chunk) {
+        tw.brushchecks = chunk->brushchecks;
+        tw.checkcount = ++chunk->checkcount;
+    }
 
     /* Initialize trace result */
     tw.trace.fraction = 1.0f;
@@ -387,8 +796,10 @@ static trace_t CM_BoxTraceNode(bsp_world_t *world,
         }
     }
 
+    if (!reference)
+        CM_CaptureTrace(&tw, headnode);
+
     /* Trace through BSP tree starting from headnode */
-    cm_checkcount++;
     CM_RecursiveTrace(&tw, headnode, 0, 1, start, end);
 
     /* Calculate final endpoint */
@@ -408,7 +819,71 @@ trace_t CM_BoxTrace(bsp_world_t *world,
                     vec3_t start, vec3_t mins, vec3_t maxs,
                     vec3_t end, int brushmask)
 {
-    return CM_BoxTraceNode(world, start, mins, maxs, end, brushmask, 0);
+    return CM_BoxTraceNode(world, start, mins, maxs, end, brushmask, 0, NULL, qfalse);
+}
+
+typedef struct {
+    bsp_world_t     *world;
+    tracequery_t    *queries;
+    int             count;
+    int             numchunks;
+    int             brushmask;
+} cm_batch_t;
+
+static void CM_BoxTraceChunk(void *ctx, int index)
+{
+    cm_batch_t      *b = ctx;
+    cm_chunk_t      *chunk = &cm_chunks[index];
+    int             i, first = b->count * index / b->numchunks;
+    int             last = b->count * (index + 1) / b->numchunks;
+
+    for (i = first; i < last; i++) {
+        tracequery_t *q = &b->queries[i];
+
+        q->trace = CM_BoxTraceNode(b->world, q->start, q->mins, q->maxs,
+                                   q->end, b->brushmask, 0, chunk, qfalse);
+    }
+}
+
+/*
+ * CM_BoxTraceBatch - CM_BoxTrace for each query, filling in queries[i].trace
+ *
+ * The queries are split across the job threads. Only one batch may run at
+ * a time, which holds as long as only the game thread batches.
+ */
+void CM_BoxTraceBatch(bsp_world_t *world, tracequery_t *queries, int count,
+                      int brushmask)
+{
+    cm_batch_t  b;
+    int         i;
+
+    if (count <= 0)
+        return;
+
+    b.world = world;
+    b.queries = queries;
+    b.count = count;
+    b.brushmask = brushmask;
+    b.numchunks = Job_Threads();
+    if (b.numchunks > CM_MAX_CHUNKS)
+        b.numchunks = CM_MAX_CHUNKS;
+    if (b.numchunks > count)
+        b.numchunks = count;
+
+    /* Size every chunk's checkcounts here, the jobs can't allocate */
+    for (i = 0; i < b.numchunks; i++) {
+        cm_chunk_t *chunk = &cm_chunks[i];
+
+        if (!world || world->num_brushes <= chunk->numbrushes)
+            continue;
+        if (chunk->brushchecks)
+            Z_Free(chunk->brushchecks);
+        chunk->numbrushes = world->num_brushes;
+        chunk->brushchecks = Z_Malloc(chunk->numbrushes * (int)sizeof(int));
+        chunk->checkcount = 0;  /* Z_Malloc zeroes */
+    }
+
+    Job_ParallelFor("CM_BoxTraceBatch", CM_BoxTraceChunk, &b, b.numchunks);
 }
 
 /*
@@ -509,7 +984,7 @@ trace_t CM_TransformedBoxTrace(bsp_world_t *world,
     }
 
     /* Trace in model-local space against the submodel's BSP subtree */
-    tr = CM_BoxTraceNode(world, start_l, mins, maxs, end_l, brushmask, headnode);
+    tr = CM_BoxTraceNode(world, start_l, mins, maxs, end_l, brushmask, headnode, NULL, qfalse);
 
     if (rotated && tr.fraction < 1.0f) {
         /* Rotate the hit normal back to world space */
@@ -528,3 +1003,170 @@ trace_t CM_TransformedBoxTrace(bsp_world_t *world,
 
     return tr;
 }
+
+/* ==========================================================================
+   Capture / Benchmark Commands
+   ========================================================================== */
+
+/* "maps/nyc1.bsp" -> "nyc1" */
+static void CM_MapBase(const char *name, char *out, int size)
+{
+    const char *slash = strrchr(name, '/');
+    char *dot;
+
+    Q_strncpyz(out, slash ? slash + 1 : name, size);
+    dot = strrchr(out, '.');
+    if (dot)
+        *dot = 0;
+}
+
+static void CM_Capture_f(void)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    int         count;
+
+    if (cm_capture.records) {
+        Com_Printf("cm_capture: %d of %d traces recorded\n",
+                   cm_capture.filled, cm_capture.max);
+        return;
+    }
+    if (Cmd_Argc() != 2) {
+        Com_Printf("usage: cm_capture <count>\n");
+        return;
+    }
+    if (!world || !world->loaded) {
+        Com_Printf("cm_capture: no map loaded\n");
+        return;
+    }
+
+    count = atoi(Cmd_Argv(1));
+    if (count <= 0)
+        return;
+    if (count > CM_MAX_CAPTURE)
+        count = CM_MAX_CAPTURE;
+
+    CM_MapBase(world->name, cm_capture.map, sizeof(cm_capture.map));
+    Sys_Mkdir(va("%s/traces", FS_Gamedir()));
+    Com_sprintf(cm_capture.path, sizeof(cm_capture.path), "%s/traces/%s.trc",
+                FS_Gamedir(), cm_capture.map);
+
+    cm_capture.max = count;
+    cm_capture.next = 0;
+    cm_capture.filled = 0;
+    cm_capture.records = Z_Malloc(count * (int)sizeof(cm_tracerecord_t));
+    Com_Printf("cm_capture: recording the next %d traces\n", count);
+}
+
+/* Whether two traces of the same query came out the same */
+static qboolean CM_SameTrace(const trace_t *a, const trace_t *b)
+{
+    return a->fraction == b->fraction && a->startsolid == b->startsolid &&
+           a->allsolid == b->allsolid && a->contents == b->contents &&
+           VectorCompare(a->plane.normal, b->plane.normal);
+}
+
+/*
+ * CM_BenchCapture - replay a capture through the reference and the kernel
+ * paths, report the time of each and any traces that differ. Returns the
+ * number that differ, or -1 if path isn't a capture. The cm_bench command
+ * and the headless cm_bench tool both run this.
+ */
+int CM_BenchCapture(bsp_world_t *world, const char *path, int passes)
+{
+    cm_traceheader_t    *header = NULL;
+    cm_tracerecord_t    *records;
+    char                map[MAX_QPATH];
+    int                 len, count, pass, i, mismatches = 0;
+    uint64_t            t0, ref_time = 0, fast_time = 0;
+    double              freq = (double)Sys_PerfFrequency();
+    volatile float      sink = 0;  /* keeps the timed traces from being dropped */
+
+    CM_MapBase(world->name, map, sizeof(map));
+    if (passes < 1)
+        passes = 1;
+
+    len = FS_LoadFile(path, (void **)&header);
+    if (!header) {
+        Com_Printf("cm_bench: couldn't load %s\n", path);
+        return -1;
+    }
+    if (len < (int)sizeof(*header) || header->ident != CM_TRACE_IDENT ||
+        header->version != CM_TRACE_VERSION || header->count < 0 ||
+        (len - (int)sizeof(*header)) / (int)sizeof(*records) < header->count) {
+        Com_Printf("cm_bench: %s is not a trace capture\n", path);
+        FS_FreeFile(header);
+        return -1;
+    }
+    if (Q_stricmp(header->map, map))
+        Com_Printf("cm_bench: %s was captured on %s, not %s\n", path, header->map, map);
+
+    count = header->count;
+    records = (cm_tracerecord_t *)(header + 1);
+
+    for (pass = 0; pass < passes; pass++) {
+        t0 = Sys_PerfCounter();
+        for (i = 0; i < count; i++) {
+            cm_tracerecord_t *rec = &records[i];
+            trace_t tr = CM_BoxTraceNode(world, rec->start, rec->mins, rec->maxs, rec->end,
+                                         rec->brushmask, rec->headnode, NULL, qtrue);
+            sink += tr.fraction;
+        }
+        ref_time += Sys_PerfCounter() - t0;
+
+        t0 = Sys_PerfCounter();
+        for (i = 0; i < count; i++) {
+            cm_tracerecord_t *rec = &records[i];
+            trace_t tr = CM_BoxTraceNode(world, rec->start, rec->mins, rec->maxs, rec->end,
+                                         rec->brushmask, rec->headnode, NULL, qfalse);
+            sink += tr.fraction;
+        }
+        fast_time += Sys_PerfCounter() - t0;
+    }
+
+    /* Untimed pass to compare results */
+    for (i = 0; i < count; i++) {
+        cm_tracerecord_t *rec = &records[i];
+        trace_t ref = CM_BoxTraceNode(world, rec->start, rec->mins, rec->maxs, rec->end,
+                                      rec->brushmask, rec->headnode, NULL, qtrue);
+        trace_t fast = CM_BoxTraceNode(world, rec->start, rec->mins, rec->maxs, rec->end,
+                                       rec->brushmask, rec->headnode, NULL, qfalse);
+        if (!CM_SameTrace(&ref, &fast))
+            mismatches++;
+    }
+
+    Com_Printf("%d traces x %d passes on %s\n", count, passes, map);
+    Com_Printf("  reference: %8.2f ms\n", ref_time * 1000.0 / freq);
+    Com_Printf("  kernels:   %8.2f ms (%.2fx)\n", fast_time * 1000.0 / freq,
+               fast_time ? (double)ref_time / (double)fast_time : 0.0);
+    if (mismatches)
+        Com_Printf("  %d traces differ from the reference\n", mismatches);
+
+    FS_FreeFile(header);
+    return mismatches;
+}
+
+/* cm_bench [file] [passes] - CM_BenchCapture on the loaded map */
+static void CM_Bench_f(void)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    char        map[MAX_QPATH], path[MAX_QPATH];
+
+    if (!world || !world->loaded) {
+        Com_Printf("cm_bench: no map loaded\n");
+        return;
+    }
+
+    CM_MapBase(world->name, map, sizeof(map));
+    if (Cmd_Argc() > 1)
+        Q_strncpyz(path, Cmd_Argv(1), sizeof(path));
+    else
+        Com_sprintf(path, sizeof(path), "traces/%s.trc", map);
+
+    CM_BenchCapture(world, path, Cmd_Argc() > 2 ? atoi(Cmd_Argv(2)) : 10);
+}
+
+void CM_Init(void)
+{
+    Cmd_AddCommand("cm_capture", CM_Capture_f);
+    Cmd_AddCommand("cm_bench", CM_Bench_f);
+}
@@ -243,18 +243,28 @@ void Cmd_TokenizeString(char *text, qboolean macroExpand)
 
 typedef struct cmd_function_s {
     struct cmd_function_s   *next;
+    struct cmd_function_s   *hash_next;
     char                    *name;
     xcommand_t              function;
 } cmd_function_t;
 
+/* cmd_functions keeps registration order for cmdlist; cmd_hash is what
+ * Cmd_ExecuteString actually searches. Buckets are case-folded, so the
+ * strcmp users below and the Q_stricmp dispatch share one index. */
+#define CMD_HASH_SIZE   256     /* power of two */
+
 static cmd_function_t *cmd_functions;
+static cmd_function_t *cmd_hash[CMD_HASH_SIZE];
+
+#define CMD_BUCKET(name)    (Com_HashString(name) & (CMD_HASH_SIZE - 1))
 
 void Cmd_AddCommand(const char *cmd_name, xcommand_t function)
 {
-    cmd_function_t *cmd;
+    cmd_function_t  *cmd;
+    unsigned        bucket = CMD_BUCKET(cmd_name);
 
     /* Fail if the command already exists */
-    for (cmd = cmd_functions; cmd; cmd = cmd->next) {
+    for (cmd = cmd_hash[bucket]; cmd; cmd = cmd->hash_next) {
         if (!strcmp(cmd_name, cmd->name)) {
             Com_Printf("Cmd_AddCommand: %s already defined\n", cmd_name);
             return;
@@ -267,13 +277,15 @@ void Cmd_AddCommand(const char *cmd_name, xcommand_t function)
     cmd->function = function;
     cmd->next = cmd_functions;
     cmd_functions = cmd;
+    cmd->hash_next = cmd_hash[bucket];
+    cmd_hash[bucket] = cmd;
 }
 
 void Cmd_RemoveCommand(const char *cmd_name)
 {
     cmd_function_t *cmd, **back;
 
-    back = &cmd_functions;
+    back = &cmd_hash[CMD_BUCKET(cmd_name)];
     while (1) {
         cmd = *back;
         if (!cmd) {
@@ -281,20 +293,25 @@ void Cmd_RemoveCommand(const char *cmd_name)
             return;
         }
         if (!strcmp(cmd_name, cmd->name)) {
-            *back = cmd->next;
-            Z_Free(cmd->name);
-            Z_Free(cmd);
-            return;
+            *back = cmd->hash_next;
+            break;
         }
-        back = &cmd->next;
+        back = &cmd->hash_next;
     }
+
+    for (back = &cmd_functions; *back != cmd; back = &(*back)->next)
+        ;
+    *back = cmd->next;
+
+    Z_Free(cmd->name);
+    Z_Free(cmd);
 }
 
 qboolean Cmd_Exists(const char *cmd_name)
 {
     cmd_function_t *cmd;
 
-    for (cmd = cmd_functions; cmd; cmd = cmd->next) {
+    for (cmd = cmd_hash[CMD_BUCKET(cmd_name)]; cmd; cmd = cmd->hash_next) {
         if (!strcmp(cmd_name, cmd->name))
             return qtrue;
     }
@@ -321,7 +338,7 @@ void Cmd_ExecuteString(char *text)
         return;     /* no tokens */
 
     /* Check registered commands */
-    for (cmd = cmd_functions; cmd; cmd = cmd->next) {
+    for (cmd = cmd_hash[CMD_BUCKET(cmd_argv[0])]; cmd; cmd = cmd->hash_next) {
         if (!Q_stricmp(cmd_argv[0], cmd->name)) {
             if (cmd->function) {
                 cmd->function();
@@ -334,13 +351,12 @@ void Cmd_ExecuteString(char *text)
     }
 
     /* Check cvars */
-    if (Cvar_FindVar(cmd_argv[0])) {
-        if (Cmd_Argc() == 1) {
-            v = Cvar_FindVar(cmd_argv[0]);
+    v = Cvar_FindVar(cmd_argv[0]);
+    if (v) {
+        if (Cmd_Argc() == 1)
             Com_Printf("\"%s\" is \"%s\"\n", v->name, v->string);
-        } else {
-            Cvar_Set(cmd_argv[0], cmd_argv[1]);
-        }
+        else
+            Cvar_SetVar(v, cmd_argv[1], qfalse);
         return;
     }
 
@@ -410,18 +426,38 @@ static void Cmd_Echo_f(void)
    ========================================================================== */
 
 #define MAX_ALIASES     128
+#define ALIAS_HASH_SIZE 64      /* power of two */
 
 typedef struct {
     char    name[32];
     char    command[256];
+    int     hash_next;          /* index into cmd_aliases, -1 ends the chain */
 } cmd_alias_t;
 
 static cmd_alias_t  cmd_aliases[MAX_ALIASES];
 static int          num_aliases;
+static int          alias_hash[ALIAS_HASH_SIZE];   /* index + 1, 0 = empty */
+
+/*
+ * Cmd_FindAlias — index of the alias called name, or -1.
+ * Aliases are only ever redefined, never removed, so chains never shrink.
+ */
+static int Cmd_FindAlias(const char *name)
+{
+    int i;
+
+    for (i = alias_hash[Com_HashString(name) & (ALIAS_HASH_SIZE - 1)] - 1;
+         i >= 0; i = cmd_aliases[i].hash_next) {
+        if (!Q_stricmp(cmd_aliases[i].name, name))
+            return i;
+    }
+    return -1;
+}
 
 static void Cmd_Alias_f(void)
 {
     const char *name;
+    unsigned bucket;
     int i;
 
     if (Cmd_Argc() < 2) {
@@ -435,30 +471,30 @@ static void Cmd_Alias_f(void)
 
     if (Cmd_Argc() == 2) {
         /* Print alias value */
-        for (i = 0; i < num_aliases; i++) {
-            if (!Q_stricmp(cmd_aliases[i].name, name)) {
-                Com_Printf("%s = \"%s\"\n", name, cmd_aliases[i].command);
-                return;
-            }
-        }
-        Com_Printf("alias \"%s\" not found\n", name);
+        i = Cmd_FindAlias(name);
+        if (i >= 0)
+            Com_Printf("%s = \"%s\"\n", name, cmd_aliases[i].command);
+        else
+            Com_Printf("alias \"%s\" not found\n", name);
         return;
     }
 
     /* Find existing or allocate new */
-    for (i = 0; i < num_aliases; i++) {
-        if (!Q_stricmp(cmd_aliases[i].name, name))
-            break;
-    }
-    if (i == num_aliases) {
+    i = Cmd_FindAlias(name);
+    if (i < 0) {
         if (num_aliases >= MAX_ALIASES) {
             Com_Printf("MAX_ALIASES exceeded\n");
             return;
         }
-        num_aliases++;
+        i = num_aliases++;
+        Q_strncpyz(cmd_aliases[i].name, name, sizeof(cmd_aliases[i].name));
+
+        /* Hash the stored (possibly truncated) name so lookups agree */
+        bucket = Com_HashString(cmd_aliases[i].name) & (ALIAS_HASH_SIZE - 1);
+        cmd_aliases[i].hash_next = alias_hash[bucket] - 1;
+        alias_hash[bucket] = i + 1;
     }
 
-    Q_strncpyz(cmd_aliases[i].name, name, sizeof(cmd_aliases[i].name));
     Q_strncpyz(cmd_aliases[i].command, Cmd_Args() + (int)strlen(name) + 1,
                sizeof(cmd_aliases[i].command));
 }
@@ -469,15 +505,14 @@ static void Cmd_Alias_f(void)
  */
 qboolean Cmd_CheckAlias(const char *name)
 {
-    int i;
-    for (i = 0; i < num_aliases; i++) {
-        if (!Q_stricmp(cmd_aliases[i].name, name)) {
-            Cbuf_AddText(cmd_aliases[i].command);
-            Cbuf_AddText("\n");
-            return qtrue;
-        }
-    }
-    return qfalse;
+    int i = Cmd_FindAlias(name);
+
+    if (i < 0)
+        return qfalse;
+
+    Cbuf_AddText(cmd_aliases[i].command);
+    Cbuf_AddText("\n");
+    return qtrue;
 }
 
 void Cmd_Init(void)
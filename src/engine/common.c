@@ -53,7 +53,6 @@ extern void CL_CreateCmd(usercmd_t *cmd, int msec);
 
 /* Forward declarations — server frame (server/sv_game.c) */
 extern void SV_RunGameFrame(void);
-extern void SV_ClientThink(usercmd_t *cmd);
 extern qboolean SV_GetPlayerState(vec3_t origin, vec3_t angles, float *viewheight);
 extern qboolean SV_GetPlayerHealth(int *health, int *max_health);
 extern const char *SV_GetPlayerWeapon(void);
@@ -81,8 +80,10 @@ extern void R_SetViewWeaponState(int weapon_id, float kick, float bob_phase,
                                  float bob_amount, float sway_yaw, float sway_pitch,
                                  qboolean reloading);
 
+#ifndef DEDICATED_ONLY
 /* Forward declaration — freecam toggle (defined below in client section) */
 static void Cmd_Freecam_f(void);
+#endif
 
 /* Forward declaration — client command forwarding */
 extern void SV_ExecuteClientCommand(void);
@@ -129,8 +130,10 @@ static void Cmd_WriteConfig_f(void)
     }
 
     fprintf(f, "// Generated by SoF Recomp\n\n");
+#ifndef DEDICATED_ONLY
     fprintf(f, "// Key bindings\n");
     Key_WriteBindings(f);
+#endif
     fprintf(f, "\n// Cvars\n");
     fclose(f);
 
@@ -140,6 +143,7 @@ static void Cmd_WriteConfig_f(void)
     Com_Printf("Wrote %s\n", filename);
 }
 
+#ifndef DEDICATED_ONLY
 /* Forward declarations — HUD, menu, scoreboard, chat, damage, pickup, killfeed */
 static void SCR_DrawHUD(float frametime);
 static void SCR_DrawMenu(void);
@@ -172,10 +176,7 @@ static float    scr_fade_target;        /* target alpha */
 static float    scr_fade_speed;         /* alpha change per second */
 static float    scr_fade_hold;          /* seconds to hold at target */
 static float    scr_fade_hold_time;     /* when hold started */
-
-/* ANGLE2SHORT / SHORT2ANGLE for usercmd angle encoding */
-#define ANGLE2SHORT(x)  ((int)((x)*65536.0f/360.0f) & 65535)
-#define SHORT2ANGLE(x)  ((x)*(360.0f/65536.0f))
+#endif /* !DEDICATED_ONLY */
 
 /* ==========================================================================
    Global Cvars
@@ -195,6 +196,7 @@ cvar_t  *gore_detail;
 
 static FILE *logfile;
 static int  server_state;
+static void *com_printlock;     /* background loader threads may print */
 
 /* ==========================================================================
    Console Output
@@ -211,6 +213,8 @@ void Com_Printf(const char *fmt, ...)
     vsnprintf(msg, sizeof(msg), fmt, argptr);
     va_end(argptr);
 
+    Sys_LockMutex(com_printlock);
+
     /* Print to stdout */
     fputs(msg, stdout);
     fflush(stdout);
@@ -221,8 +225,12 @@ void Com_Printf(const char *fmt, ...)
         fflush(logfile);
     }
 
+#ifndef DEDICATED_ONLY
     /* Route to in-game console */
     Con_Print(msg);
+#endif
+
+    Sys_UnlockMutex(com_printlock);
 }
 
 void Com_DPrintf(const char *fmt, ...)
@@ -296,6 +304,7 @@ void Qcommon_Init(int argc, char **argv)
     Com_Printf("\n");
 
     /* Initialize subsystems in dependency order */
+    com_printlock = Sys_CreateMutex();
     Z_Init();
     Cbuf_Init();
     Cmd_Init();
@@ -304,19 +313,30 @@ void Qcommon_Init(int argc, char **argv)
     /* Register core commands */
     Cmd_AddCommand("quit", Sys_Quit);
     Cmd_AddCommand("error", NULL);  /* placeholder */
+#ifndef DEDICATED_ONLY
     Cmd_AddCommand("freecam", Cmd_Freecam_f);
+#endif
     Cmd_AddCommand("cmd", Cmd_ForwardToServer);
     Cmd_AddCommand("savegame", Cmd_SaveGame_f);
     Cmd_AddCommand("loadgame", Cmd_LoadGame_f);
     Cmd_AddCommand("writeconfig", Cmd_WriteConfig_f);
+#ifndef DEDICATED_ONLY
     Cmd_AddCommand("vid_restart", R_SetMode);
     Cmd_AddCommand("screenshot", R_Screenshot_f);
+#endif
+    Cmd_AddCommand("z_stats", Z_Stats_f);
+    Cmd_AddCommand("mem_frame", Z_FrameStats_f);
+    Prof_Init();
 
     /* Register core cvars */
     developer = Cvar_Get("developer", "0", 0);
     timescale = Cvar_Get("timescale", "1", 0);
     fixedtime = Cvar_Get("fixedtime", "0", 0);
+#ifdef DEDICATED_ONLY
+    dedicated = Cvar_Get("dedicated", "1", CVAR_NOSET);
+#else
     dedicated = Cvar_Get("dedicated", "0", CVAR_NOSET);
+#endif
     com_speeds = Cvar_Get("com_speeds", "0", 0);
     logfile_cvar = Cvar_Get("logfile", "0", 0);
     showtrace = Cvar_Get("showtrace", "0", 0);
@@ -332,8 +352,10 @@ void Qcommon_Init(int argc, char **argv)
     /* Initialize filesystem */
     FS_InitFilesystem();
 
+#ifndef DEDICATED_ONLY
     /* Register key bindings before executing configs */
     Key_Init();
+#endif
 
     /* Execute default config */
     Cbuf_AddText("exec default.cfg\n");
@@ -360,7 +382,11 @@ void Qcommon_Init(int argc, char **argv)
     }
 
     /* Initialize subsystems that depend on filesystem */
-    /* TODO: NET_Init(), Netchan_Init() */
+    Job_Init();
+    FS_AsyncInit();
+    CM_Init();
+    NET_Init();
+    Netchan_Init();
 
     Com_Printf("====== Soldier of Fortune Initialized ======\n\n");
 
@@ -368,14 +394,19 @@ void Qcommon_Init(int argc, char **argv)
     GHOUL_Init();
 
     /* Initialize game module (was gamex86.dll in original) */
+    SV_InitSnapshots();
     SV_InitGameProgs();
+    SV_InitNet();
 
+#ifndef DEDICATED_ONLY
     /* Initialize console */
     Con_Init();
 
     /* Initialize input */
     IN_Init();
     CL_InitInput();
+    CL_DemoInit();
+    CL_InitPrediction();
 
     /* Re-apply essential bindings after config loading.
        SoF's default_keys.cfg does unbindall then rebinds with SoF-specific
@@ -399,6 +430,10 @@ void Qcommon_Init(int argc, char **argv)
 
     /* Initialize sound (replaces Defsnd.dll/EAXSnd.dll/A3Dsnd.dll) */
     S_Init();
+#else
+    /* No renderer, but the server still needs the world and "map" */
+    R_InitSurfCommands();
+#endif
 
     /* Now process deferred command line args (+map, etc.) */
     {
@@ -419,6 +454,9 @@ void Qcommon_Init(int argc, char **argv)
         }
         Cbuf_Execute();
     }
+
+    /* Last, so the initial map load above didn't need the game lock */
+    SV_InitSimThread();
 }
 
 /* ==========================================================================
@@ -437,9 +475,23 @@ void Qcommon_Frame(int msec)
     if (msec < 1)
         msec = 1;
 
+    Prof_FrameBegin();
+
+    /* Starts a pending record/timedemo; playback substitutes its msec */
+    msec = CL_DemoBeginFrame(msec);
+
     if (com_speeds && com_speeds->value)
         time_before = Sys_Milliseconds();
 
+    /* Last frame's scratch memory is dead now */
+    Z_FrameReset();
+
+    /* Completions and commands may touch game state */
+    SV_LockGame();
+
+    /* Hook up any assets the background loader finished since last frame */
+    FS_AsyncPump(qfalse);
+
     /* Execute any pending console commands */
     Cbuf_Execute();
 
@@ -447,11 +499,22 @@ void Qcommon_Frame(int msec)
         time_between = Sys_Milliseconds();
 
     /* Run server frame */
+    Prof_Begin("SV_Frame");
     SV_Frame(msec);
+    Prof_End();
+    SV_UnlockGame();
+    CL_DemoMark(DEMO_PHASE_SV);
 
+#ifndef DEDICATED_ONLY
     /* Run client frame (input, view setup) */
     if (!dedicated || !dedicated->value) {
+        SV_LockGame();
+        Prof_Begin("CL_Frame");
         CL_Frame(msec);
+        Prof_End();
+        SV_UnlockGame();
+        CL_DemoCamera();
+        CL_DemoMark(DEMO_PHASE_CL);
 
         /* Animate console slide */
         {
@@ -494,36 +557,59 @@ void Qcommon_Frame(int msec)
             snd_up[1] = (cr * sp * sy + -sr * cy);
             snd_up[2] = cr * cp;
 
+            Prof_Begin("S_Update");
             S_Update(snd_origin, snd_forward, snd_right, snd_up);
+            Prof_End();
         }
 
         /* Update screen fade */
         SCR_UpdateFade(msec / 1000.0f);
 
-        /* Render frame */
+        /* Render frame — the 3D pass draws from the entity snapshot */
         R_BeginFrame(0.0f);
+
+        /* The HUD reads the player straight from the game */
+        SV_LockGame();
         if (cl_intermission) {
+            Prof_Begin("SCR_DrawIntermission");
             SCR_DrawIntermission();
+            Prof_End();
         } else {
+            Prof_Begin("SCR_DrawHUD");
             SCR_DrawHUD(msec / 1000.0f);
+            Prof_End();
+
+            Prof_Begin("SCR_DrawEffects");
             SCR_DrawBloodSplatters();
             SCR_DrawDamageNumbers();
             SCR_DrawScorePopups();
             SCR_DrawHitMarker();
             SCR_DrawDamageDirection();
+            Prof_End();
+
+            Prof_Begin("SCR_DrawMessages");
             SCR_DrawPickupMessages();
             SCR_DrawKillFeed();
             SCR_DrawDeathScreen();
             SCR_DrawObjectives();
             SCR_DrawChat();
             SCR_DrawScoreboard();
+            Prof_End();
         }
+        Prof_Begin("SCR_DrawConsole");
         SCR_DrawMenu();
         Con_DrawNotify();
         Con_DrawConsole(con.current_frac);
         SCR_DrawFade();  /* fade overlay drawn last, on top of everything */
+        Prof_End();
+        SV_UnlockGame();
+        Prof_DrawOverlay();
+
+        Prof_Begin("R_EndFrame");
         R_EndFrame();
+        Prof_End();
     }
+#endif /* !DEDICATED_ONLY */
 
     if (com_speeds && com_speeds->value) {
         time_after = Sys_Milliseconds();
@@ -532,6 +618,9 @@ void Qcommon_Frame(int msec)
             time_between - time_before,
             time_after - time_between);
     }
+
+    CL_DemoEndFrame();
+    Prof_FrameEnd();
 }
 
 /* ==========================================================================
@@ -540,6 +629,12 @@ void Qcommon_Frame(int msec)
 
 void Qcommon_Shutdown(void)
 {
+    SV_ShutdownSimThread();
+    SV_ShutdownNet();
+    NET_Shutdown();
+    FS_AsyncShutdown();
+    Job_Shutdown();
+
     /* Auto-save config on clean shutdown */
     Cmd_WriteConfig_f();
 
@@ -549,6 +644,8 @@ void Qcommon_Shutdown(void)
     }
 }
 
+#ifndef DEDICATED_ONLY
+
 /* ==========================================================================
    Client State
    ========================================================================== */
@@ -781,23 +878,38 @@ void CL_Frame(int msec)
     } else {
         /* Player movement mode — build usercmd, send to game */
         usercmd_t cmd;
-        CL_CreateCmd(&cmd, msec);
+        qboolean send;
+
+        if (CL_DemoPlaying()) {
+            /* Timedemo: replay exactly what was sent when recording */
+            send = CL_DemoReadCmd(&cmd);
+        } else {
+            CL_CreateCmd(&cmd, msec);
 
-        /* Pack view angles into usercmd */
-        cmd.angles[0] = (short)ANGLE2SHORT(cl_viewangles[0]);
-        cmd.angles[1] = (short)ANGLE2SHORT(cl_viewangles[1]);
-        cmd.angles[2] = 0;
+            /* Pack view angles into usercmd */
+            cmd.angles[0] = (short)ANGLE2SHORT(cl_viewangles[0]);
+            cmd.angles[1] = (short)ANGLE2SHORT(cl_viewangles[1]);
+            cmd.angles[2] = 0;
+
+            send = !Con_IsVisible();
+            if (send)
+                CL_DemoWriteCmd(&cmd);
+        }
 
         /* Send to game module */
-        if (!Con_IsVisible())
-            SV_ClientThink(&cmd);
+        if (send)
+            CL_SendCmd(&cmd);
 
         /* Build refdef from player entity state */
         {
-            vec3_t org, ang;
+            vec3_t org, ang, pvel;
             float vh = 0;
+            qboolean predicted;
 
             if (SV_GetPlayerState(org, ang, &vh)) {
+                /* Run ahead over the commands the game hasn't yet */
+                predicted = CL_PredictView(org, ang, pvel);
+
                 /* ---- View smoothing: stair step, crouch, landing ---- */
                 {
                     if (!cl_smooth_inited) {
@@ -847,8 +959,11 @@ void CL_Frame(int msec)
                 {
                     vec3_t vel;
                     float speed = 0;
+                    qboolean have_vel = SV_GetPlayerVelocity(vel);
 
-                    if (SV_GetPlayerVelocity(vel)) {
+                    if (predicted)
+                        VectorCopy(pvel, vel);
+                    if (have_vel) {
                         speed = (float)sqrt(vel[0] * vel[0] + vel[1] * vel[1]);
 
                         /* Landing detection: was falling, now stopped */
@@ -1093,6 +1208,29 @@ static int  opt_cursor = 0;
 
 #define OPT_ITEMS 6  /* sensitivity, volume, resolution, fullscreen, gore, difficulty */
 
+/* Options menu cvars, looked up once and then read through the handle.
+ * Most are registered by other subsystems, so resolve lazily and keep
+ * trying until the owner has created them. */
+static const char *opt_cvar_names[OPT_ITEMS] = {
+    "sensitivity", "s_volume", "r_mode", "vid_fullscreen", "gore_detail", "skill"
+};
+static cvar_t *opt_cvars[OPT_ITEMS];
+
+static float M_OptValue(int item)
+{
+    if (!opt_cvars[item])
+        opt_cvars[item] = Cvar_FindVar(opt_cvar_names[item]);
+    return opt_cvars[item] ? (float)atof(opt_cvars[item]->string) : 0.0f;
+}
+
+static void M_OptSetValue(int item, float value)
+{
+    if (opt_cvars[item])
+        Cvar_SetVarValue(opt_cvars[item], value);
+    else
+        Cvar_SetValue(opt_cvar_names[item], value);
+}
+
 /* Exposed to key handler */
 int  M_IsActive(void) { return menu_active; }
 
@@ -1133,43 +1271,43 @@ void M_Keydown(int key)
             float dir = (key == K_RIGHTARROW) ? 1.0f : -1.0f;
             switch (opt_cursor) {
             case 0: { /* Sensitivity */
-                float s = Cvar_VariableValue("sensitivity") + dir * 0.5f;
+                float s = M_OptValue(0) + dir * 0.5f;
                 if (s < 0.5f) s = 0.5f;
                 if (s > 20.0f) s = 20.0f;
-                Cvar_SetValue("sensitivity", s);
+                M_OptSetValue(0, s);
                 break;
             }
             case 1: { /* Volume */
-                float v = Cvar_VariableValue("s_volume") + dir * 0.1f;
+                float v = M_OptValue(1) + dir * 0.1f;
                 if (v < 0.0f) v = 0.0f;
                 if (v > 1.0f) v = 1.0f;
-                Cvar_SetValue("s_volume", v);
+                M_OptSetValue(1, v);
                 break;
             }
             case 2: { /* Resolution */
-                int mode = (int)Cvar_VariableValue("r_mode") + (int)dir;
+                int mode = (int)M_OptValue(2) + (int)dir;
                 if (mode < 0) mode = 14;
                 if (mode > 14) mode = 0;
-                Cvar_SetValue("r_mode", (float)mode);
+                M_OptSetValue(2, (float)mode);
                 break;
             }
             case 3: { /* Fullscreen */
-                float fs = Cvar_VariableValue("vid_fullscreen");
-                Cvar_SetValue("vid_fullscreen", fs > 0 ? 0.0f : 1.0f);
+                float fs = M_OptValue(3);
+                M_OptSetValue(3, fs > 0 ? 0.0f : 1.0f);
                 break;
             }
             case 4: { /* Gore */
-                float g = Cvar_VariableValue("gore_detail");
+                float g = M_OptValue(4);
                 if (dir > 0) { if (g < 2) g += 1; }
                 else { if (g > 0) g -= 1; }
-                Cvar_SetValue("gore_detail", g);
+                M_OptSetValue(4, g);
                 break;
             }
             case 5: { /* Difficulty */
-                float sk = Cvar_VariableValue("skill");
+                float sk = M_OptValue(5);
                 if (dir > 0) { if (sk < 3) sk += 1; }
                 else { if (sk > 0) sk -= 1; }
-                Cvar_SetValue("skill", sk);
+                M_OptSetValue(5, sk);
                 break;
             }
             }
@@ -1297,30 +1435,30 @@ static void SCR_DrawMenu(void)
             switch (i) {
             case 0:
                 Com_sprintf(val, sizeof(val), "%-12s < %.1f >", opt_labels[i],
-                            Cvar_VariableValue("sensitivity"));
+                            M_OptValue(0));
                 break;
             case 1:
                 Com_sprintf(val, sizeof(val), "%-12s < %.0f%% >", opt_labels[i],
-                            Cvar_VariableValue("s_volume") * 100.0f);
+                            M_OptValue(1) * 100.0f);
                 break;
             case 2: {
-                int mode = (int)Cvar_VariableValue("r_mode");
+                int mode = (int)M_OptValue(2);
                 if (mode < 0 || mode > 14) mode = 6;
                 Com_sprintf(val, sizeof(val), "%-12s < %s >", opt_labels[i], res_names[mode]);
                 break;
             }
             case 3:
                 Com_sprintf(val, sizeof(val), "%-12s < %s >", opt_labels[i],
-                            Cvar_VariableValue("vid_fullscreen") > 0 ? "ON" : "OFF");
+                            M_OptValue(3) > 0 ? "ON" : "OFF");
                 break;
             case 4: {
-                int gd = (int)Cvar_VariableValue("gore_detail");
+                int gd = (int)M_OptValue(4);
                 Com_sprintf(val, sizeof(val), "%-12s < %s >", opt_labels[i],
                             gd >= 2 ? "Full" : (gd >= 1 ? "Reduced" : "Off"));
                 break;
             }
             case 5: {
-                int sk = (int)Cvar_VariableValue("skill");
+                int sk = (int)M_OptValue(5);
                 static const char *diff_names[] = { "Easy", "Normal", "Hard", "Nightmare" };
                 if (sk < 0) sk = 0; if (sk > 3) sk = 3;
                 Com_sprintf(val, sizeof(val), "%-12s < %s >", opt_labels[i], diff_names[sk]);
@@ -3095,6 +3233,8 @@ static void SCR_DrawHUD(float frametime)
     }
 }
 
+#endif /* !DEDICATED_ONLY */
+
 void SV_Init(void) {}
 void SV_Shutdown(const char *finalmsg, qboolean reconnect)
 {
@@ -3105,23 +3245,32 @@ void SV_Shutdown(const char *finalmsg, qboolean reconnect)
 /* Server frame — runs game at 10Hz tick rate */
 static int sv_frame_residual = 0;
 
-/* Forward declarations — entity interpolation (renderer/r_main.c) */
+/* Forward declaration — entity interpolation (renderer/r_main.c) */
 extern void R_SetInterpFraction(float frac);
-extern void R_UpdateEntityInterp(void);
 
 void SV_Frame(int msec)
 {
+    /* Remote clients' commands, for the next tick to run */
+    SV_ReadPackets();
+
+    /* sv_simthread: ticks run on their own clock, just follow it */
+    if (SV_SimThreadActive()) {
+        SV_AcquireSnapshot();
+        R_SetInterpFraction(SV_SimThreadLerp());
+        return;
+    }
+
     sv_frame_residual += msec;
 
     /* Run game frames at 100ms intervals (10 Hz) */
     while (sv_frame_residual >= 100) {
-        /* Snapshot entity positions before tick for interpolation */
-        R_UpdateEntityInterp();
-
         sv_frame_residual -= 100;
         SV_RunGameFrame();
+        SV_PublishSnapshot();
+        SV_SendClientMessages();
     }
 
     /* Calculate interpolation fraction for rendering (0..1 between ticks) */
+    SV_AcquireSnapshot();
     R_SetInterpFraction(sv_frame_residual / 100.0f);
 }
@@ -13,7 +13,18 @@
 
 #include "../common/qcommon.h"
 
+/*
+ * Every cvar lives on the cvar_vars list (registration order, newest first,
+ * used by cvarlist and the config writer) and on one hash_next chain for
+ * lookup by name. Cvars are never freed, so the cvar_t pointer returned by
+ * Cvar_Get or Cvar_FindVar is a stable handle: code that touches a cvar
+ * every frame should keep the pointer and read ->value, or write through
+ * Cvar_SetVar, rather than looking the name up again.
+ */
+#define CVAR_HASH_SIZE  512     /* power of two */
+
 static cvar_t   *cvar_vars;
+static cvar_t   *cvar_hash[CVAR_HASH_SIZE];
 static qboolean cvar_allowCheats = qtrue;
 
 /* ==========================================================================
@@ -24,7 +35,8 @@ cvar_t *Cvar_FindVar(const char *var_name)
 {
     cvar_t *var;
 
-    for (var = cvar_vars; var; var = var->next) {
+    var = cvar_hash[Com_HashString(var_name) & (CVAR_HASH_SIZE - 1)];
+    for (; var; var = var->hash_next) {
         if (!Q_stricmp(var_name, var->name))
             return var;
     }
@@ -57,7 +69,8 @@ char *Cvar_VariableString(const char *var_name)
 
 cvar_t *Cvar_Get(const char *var_name, const char *var_value, int flags)
 {
-    cvar_t *var;
+    cvar_t      *var;
+    unsigned    bucket;
 
     if (flags & (CVAR_USERINFO | CVAR_SERVERINFO)) {
         /* Validate the info string */
@@ -92,6 +105,10 @@ cvar_t *Cvar_Get(const char *var_name, const char *var_value, int flags)
     var->next = cvar_vars;
     cvar_vars = var;
 
+    bucket = Com_HashString(var_name) & (CVAR_HASH_SIZE - 1);
+    var->hash_next = cvar_hash[bucket];
+    cvar_hash[bucket] = var;
+
     return var;
 }
 
@@ -99,15 +116,13 @@ cvar_t *Cvar_Get(const char *var_name, const char *var_value, int flags)
    Cvar_Set — SoF export
    ========================================================================== */
 
-static cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
+/*
+ * Cvar_SetVar — Cvar_Set on a handle the caller already holds. Honours
+ * NOSET/LATCH unless force is set, exactly like the by-name versions.
+ */
+cvar_t *Cvar_SetVar(cvar_t *var, const char *value, qboolean force)
 {
-    cvar_t *var;
-
-    var = Cvar_FindVar(var_name);
-    if (!var) {
-        /* Create it */
-        return Cvar_Get(var_name, value, 0);
-    }
+    const char *var_name = var->name;
 
     if (var->flags & (CVAR_USERINFO | CVAR_SERVERINFO)) {
         if (value && (strchr(value, '\\') || strchr(value, ';') || strchr(value, '"'))) {
@@ -157,6 +172,19 @@ static cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force
     return var;
 }
 
+static cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
+{
+    cvar_t *var;
+
+    var = Cvar_FindVar(var_name);
+    if (!var) {
+        /* Create it */
+        return Cvar_Get(var_name, value, 0);
+    }
+
+    return Cvar_SetVar(var, value, force);
+}
+
 cvar_t *Cvar_Set(const char *var_name, const char *value)
 {
     return Cvar_Set2(var_name, value, qfalse);
@@ -171,18 +199,30 @@ cvar_t *Cvar_ForceSet(const char *var_name, const char *value)
    Cvar_SetValue — SoF export
    ========================================================================== */
 
-void Cvar_SetValue(const char *var_name, float value)
+static void Cvar_FormatValue(char *val, int size, float value)
 {
-    char val[32];
-
     if (value == (int)value)
-        Com_sprintf(val, sizeof(val), "%d", (int)value);
+        Com_sprintf(val, size, "%d", (int)value);
     else
-        Com_sprintf(val, sizeof(val), "%f", value);
+        Com_sprintf(val, size, "%f", value);
+}
+
+void Cvar_SetValue(const char *var_name, float value)
+{
+    char val[32];
 
+    Cvar_FormatValue(val, sizeof(val), value);
     Cvar_Set(var_name, val);
 }
 
+void Cvar_SetVarValue(cvar_t *var, float value)
+{
+    char val[32];
+
+    Cvar_FormatValue(val, sizeof(val), value);
+    Cvar_SetVar(var, val, qfalse);
+}
+
 /* ==========================================================================
    Info String Building
    ========================================================================== */
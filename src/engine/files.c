@@ -14,6 +14,10 @@
  *   Header: "PACK" magic, directory offset (uint32), directory size (uint32)
  *   Directory: 64-byte entries (56-byte name + uint32 offset + uint32 size)
  *   pak0.pak = 9728 files (673 MB), pak1.pak = 533 files (19.6 MB)
+ *
+ * With fs_mmap 1 (default) each pak is mapped read-only once at mount time.
+ * FS_Read then copies straight out of the mapping, and FS_MapFile hands
+ * out zero-copy views for loaders that only parse.
  */
 
 #include "../common/qcommon.h"
@@ -21,6 +25,18 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <sys/stat.h>
+
+#ifdef SOF_PLATFORM_WINDOWS
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+#endif
 
 /* ==========================================================================
    Types
@@ -29,6 +45,7 @@
 #define PAK_MAGIC       (('K'<<24)+('C'<<16)+('A'<<8)+'P')  /* "PACK" */
 #define MAX_FILES_IN_PAK    16384
 #define MAX_HANDLES         64
+#define FS_HASH_SIZE        16384   /* power of two, >= pak0 + pak1 entries */
 
 typedef struct {
     char    name[56];
@@ -36,11 +53,31 @@ typedef struct {
     int     filelen;
 } dpackfile_t;
 
+struct searchpath_s;
+
+/*
+ * Hashed directory entry. Every mounted PAK contributes one entry per file,
+ * chained into fs_filehash by case-folded name. Newer paks are linked at the
+ * head of each chain, so the first match is the searchpath that wins.
+ */
+typedef struct fsentry_s {
+    unsigned                hash;       /* full case-folded hash of the name */
+    dpackfile_t             *file;
+    struct searchpath_s     *search;    /* owning PAK searchpath */
+    struct fsentry_s        *next;      /* hash chain */
+} fsentry_t;
+
 typedef struct pack_s {
     char            filename[MAX_OSPATH];
     FILE            *handle;
     int             numfiles;
     dpackfile_t     *files;
+    fsentry_t       *entries;   /* [numfiles], linked into fs_filehash */
+    byte            *map;       /* read-only mapping of the whole pak, or NULL */
+    size_t          map_size;
+#ifdef SOF_PLATFORM_WINDOWS
+    HANDLE          map_handle; /* CreateFileMapping object backing map */
+#endif
     struct pack_s   *next;      /* for search path chaining */
 } pack_t;
 
@@ -68,6 +105,69 @@ static char         fs_basedir[MAX_OSPATH];
 
 static fshandle_t   fs_handles[MAX_HANDLES];
 
+static fsentry_t    *fs_filehash[FS_HASH_SIZE];
+
+/* Lookup cost counters, reported by fs_stats */
+static struct {
+    int     lookups;        /* FS_FOpenFile calls */
+    int     probes;         /* hash chain entries visited */
+    int     compares;       /* full name compares (hash matched) */
+    int     loose_tries;    /* fopen attempts on loose directories */
+    int     pak_hits;
+    int     loose_hits;
+    int     misses;
+    int     views;          /* FS_MapFile calls served from a mapping */
+    int     view_fallbacks; /* FS_MapFile calls that had to copy */
+    double  view_bytes;     /* bytes handed out without a copy */
+} fs_stats;
+
+static cvar_t       *fs_mmap;
+
+/* Guards the handle table, unmapped pak FILE positions and fs_stats so the
+ * background loader's workers can open files alongside the main thread */
+static void         *fs_lock;
+
+/* ==========================================================================
+   Directory Hash Index
+   ========================================================================== */
+
+/*
+ * FS_IndexPack — link a freshly mounted pak into the global index.
+ * Files are inserted in reverse so a duplicate name inside one pak still
+ * resolves to its first directory entry, as the linear scan did.
+ */
+static void FS_IndexPack(searchpath_t *search)
+{
+    pack_t      *pak = search->pack;
+    fsentry_t   *e;
+    int         i;
+
+    for (i = pak->numfiles - 1; i >= 0; i--) {
+        e = &pak->entries[i];
+        e->search = search;
+        e->next = fs_filehash[e->hash & (FS_HASH_SIZE - 1)];
+        fs_filehash[e->hash & (FS_HASH_SIZE - 1)] = e;
+    }
+}
+
+/*
+ * FS_FindPakEntry — highest-priority pak entry for a name, or NULL.
+ */
+static fsentry_t *FS_FindPakEntry(const char *filename, unsigned hash)
+{
+    fsentry_t *e;
+
+    for (e = fs_filehash[hash & (FS_HASH_SIZE - 1)]; e; e = e->next) {
+        fs_stats.probes++;
+        if (e->hash != hash)
+            continue;
+        fs_stats.compares++;
+        if (!Q_stricmp(e->file->name, filename))
+            return e;
+    }
+    return NULL;
+}
+
 /* ==========================================================================
    Handle Management
    ========================================================================== */
@@ -95,6 +195,67 @@ static fshandle_t *FS_GetHandle(fileHandle_t f)
     return &fs_handles[f - 1];
 }
 
+/* ==========================================================================
+   PAK Memory Mapping
+   ========================================================================== */
+
+/*
+ * FS_MapPack — map an opened pak read-only. Failure is not an error; the
+ * pak simply keeps using the stdio path.
+ */
+static void FS_MapPack(pack_t *pack)
+{
+    long size;
+
+    fseek(pack->handle, 0, SEEK_END);
+    size = ftell(pack->handle);
+    fseek(pack->handle, 0, SEEK_SET);
+    if (size <= 0)
+        return;
+
+#ifdef SOF_PLATFORM_WINDOWS
+    {
+        HANDLE fh = (HANDLE)_get_osfhandle(_fileno(pack->handle));
+        pack->map_handle = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!pack->map_handle)
+            return;
+        pack->map = (byte *)MapViewOfFile(pack->map_handle, FILE_MAP_READ, 0, 0, 0);
+        if (!pack->map) {
+            CloseHandle(pack->map_handle);
+            pack->map_handle = NULL;
+            return;
+        }
+    }
+#else
+    {
+        void *base = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE,
+                          fileno(pack->handle), 0);
+        if (base == MAP_FAILED)
+            return;
+        pack->map = (byte *)base;
+    }
+#endif
+
+    pack->map_size = (size_t)size;
+}
+
+static void FS_UnmapPack(pack_t *pack)
+{
+    if (!pack->map)
+        return;
+
+#ifdef SOF_PLATFORM_WINDOWS
+    UnmapViewOfFile(pack->map);
+    CloseHandle(pack->map_handle);
+    pack->map_handle = NULL;
+#else
+    munmap(pack->map, pack->map_size);
+#endif
+
+    pack->map = NULL;
+    pack->map_size = 0;
+}
+
 /* ==========================================================================
    PAK File Loading
    ========================================================================== */
@@ -156,7 +317,33 @@ static pack_t *FS_LoadPackFile(const char *packfile)
     pack->numfiles = i;
     pack->files = info;
 
-    Com_Printf("Added packfile %s (%d files)\n", packfile, pack->numfiles);
+    /* Hash every name now; chains are linked once the searchpath exists */
+    if (pack->numfiles > 0) {
+        pack->entries = (fsentry_t *)Z_Malloc(pack->numfiles * sizeof(fsentry_t));
+        for (i = 0; i < pack->numfiles; i++) {
+            pack->entries[i].hash = Com_HashString(info[i].name);
+            pack->entries[i].file = &info[i];
+        }
+    }
+
+    if (fs_mmap && fs_mmap->value)
+        FS_MapPack(pack);
+
+    /* Directory entries pointing outside the file would read past the map */
+    if (pack->map) {
+        for (i = 0; i < pack->numfiles; i++) {
+            if (info[i].filepos < 0 || info[i].filelen < 0 ||
+                (size_t)info[i].filepos + (size_t)info[i].filelen > pack->map_size) {
+                Com_Printf("%s: entry %s out of range, not mapping\n",
+                    packfile, info[i].name);
+                FS_UnmapPack(pack);
+                break;
+            }
+        }
+    }
+
+    Com_Printf("Added packfile %s (%d files%s)\n", packfile, pack->numfiles,
+        pack->map ? ", mapped" : "");
 
     return pack;
 }
@@ -192,6 +379,8 @@ static void FS_AddGameDirectory(const char *dir)
         search->pack = pak;
         search->next = fs_searchpaths;
         fs_searchpaths = search;
+
+        FS_IndexPack(search);
     }
 }
 
@@ -199,40 +388,42 @@ static void FS_AddGameDirectory(const char *dir)
    FS_FOpenFile — SoF export
    ========================================================================== */
 
-int FS_FOpenFile(const char *filename, fileHandle_t *f)
+static int FS_FOpenFileLocked(const char *filename, fileHandle_t *f)
 {
     searchpath_t    *search;
+    fsentry_t       *entry;
     char            netpath[MAX_OSPATH];
-    int             i;
 
     *f = 0;
+    fs_stats.lookups++;
+
+    /* One hash probe resolves the winning pak; only loose directories that
+     * sit in front of it in the search order still need an fopen */
+    entry = FS_FindPakEntry(filename, Com_HashString(filename));
 
     /* Search through the path, one element at a time */
     for (search = fs_searchpaths; search; search = search->next) {
         /* Check PAK file */
-        if (search->pack) {
+        if (entry && search == entry->search) {
             pack_t *pak = search->pack;
-            for (i = 0; i < pak->numfiles; i++) {
-                if (!Q_stricmp(pak->files[i].name, filename)) {
-                    /* Found it */
-                    fileHandle_t handle = FS_AllocHandle();
-                    fshandle_t *fsh = FS_GetHandle(handle);
-
-                    fsh->pack = pak;
-                    fsh->pak_offset = pak->files[i].filepos;
-                    fsh->pak_remaining = pak->files[i].filelen;
-
-                    Com_DPrintf("FS_FOpenFile: %s (pak: %s)\n", filename, pak->filename);
-                    *f = handle;
-                    return pak->files[i].filelen;
-                }
-            }
+            fileHandle_t handle = FS_AllocHandle();
+            fshandle_t *fsh = FS_GetHandle(handle);
+
+            fsh->pack = pak;
+            fsh->pak_offset = entry->file->filepos;
+            fsh->pak_remaining = entry->file->filelen;
+
+            Com_DPrintf("FS_FOpenFile: %s (pak: %s)\n", filename, pak->filename);
+            fs_stats.pak_hits++;
+            *f = handle;
+            return entry->file->filelen;
         }
 
         /* Check loose file */
         if (search->filename[0]) {
             Com_sprintf(netpath, sizeof(netpath), "%s/%s", search->filename, filename);
 
+            fs_stats.loose_tries++;
             FILE *fp = fopen(netpath, "rb");
             if (fp) {
                 fileHandle_t handle = FS_AllocHandle();
@@ -245,6 +436,7 @@ int FS_FOpenFile(const char *filename, fileHandle_t *f)
 
                 fsh->file = fp;
                 Com_DPrintf("FS_FOpenFile: %s (loose: %s)\n", filename, netpath);
+                fs_stats.loose_hits++;
                 *f = handle;
                 return len;
             }
@@ -252,9 +444,21 @@ int FS_FOpenFile(const char *filename, fileHandle_t *f)
     }
 
     Com_DPrintf("FS_FOpenFile: can't find %s\n", filename);
+    fs_stats.misses++;
     return -1;
 }
 
+int FS_FOpenFile(const char *filename, fileHandle_t *f)
+{
+    int len;
+
+    Sys_LockMutex(fs_lock);
+    len = FS_FOpenFileLocked(filename, f);
+    Sys_UnlockMutex(fs_lock);
+
+    return len;
+}
+
 /* ==========================================================================
    FS_FCloseFile — SoF export
    ========================================================================== */
@@ -270,7 +474,9 @@ void FS_FCloseFile(fileHandle_t f)
         fsh->file = NULL;
     }
 
+    Sys_LockMutex(fs_lock);
     fsh->used = qfalse;
+    Sys_UnlockMutex(fs_lock);
 }
 
 /* ==========================================================================
@@ -289,8 +495,17 @@ int FS_Read(void *buffer, int len, fileHandle_t f)
         if (toread > fsh->pak_remaining)
             toread = fsh->pak_remaining;
 
-        fseek(fsh->pack->handle, fsh->pak_offset, SEEK_SET);
-        int got = (int)fread(buffer, 1, toread, fsh->pack->handle);
+        int got;
+        if (fsh->pack->map) {
+            memcpy(buffer, fsh->pack->map + fsh->pak_offset, toread);
+            got = toread;
+        } else {
+            /* The pak FILE is shared by every handle into it */
+            Sys_LockMutex(fs_lock);
+            fseek(fsh->pack->handle, fsh->pak_offset, SEEK_SET);
+            got = (int)fread(buffer, 1, toread, fsh->pack->handle);
+            Sys_UnlockMutex(fs_lock);
+        }
 
         fsh->pak_offset += got;
         fsh->pak_remaining -= got;
@@ -356,6 +571,122 @@ void FS_FreeFile(void *buffer)
         Z_Free(buffer);
 }
 
+/* ==========================================================================
+   FS_MapFile / FS_UnmapFile — read-only zero-copy views
+   ========================================================================== */
+
+/*
+ * FS_MapFile — return a read-only view of a whole file.
+ *
+ * Files inside a mapped pak are returned as a pointer into the mapping, so
+ * nothing is allocated or copied. Loose files and unmapped paks fall back to
+ * FS_LoadFile. Either way the caller must release the view with
+ * FS_UnmapFile and must not write through it. Unlike FS_LoadFile, a view is
+ * NOT null terminated; parsers have to honour the returned length.
+ */
+int FS_MapFile(const char *path, const void **view)
+{
+    fileHandle_t    f;
+    fshandle_t      *fsh;
+    int             len;
+
+    *view = NULL;
+
+    len = FS_FOpenFile(path, &f);
+    if (!f || len < 0)
+        return -1;
+
+    fsh = FS_GetHandle(f);
+    if (fsh->pack && fsh->pack->map) {
+        *view = fsh->pack->map + fsh->pak_offset;
+        FS_FCloseFile(f);
+        Sys_LockMutex(fs_lock);
+        fs_stats.views++;
+        fs_stats.view_bytes += len;
+        Sys_UnlockMutex(fs_lock);
+        return len;
+    }
+
+    /* No mapping: read it into zone memory like FS_LoadFile */
+    {
+        byte *buf = (byte *)Z_Malloc(len + 1);
+        buf[len] = 0;
+        FS_Read(buf, len, f);
+        FS_FCloseFile(f);
+        *view = buf;
+    }
+    Sys_LockMutex(fs_lock);
+    fs_stats.view_fallbacks++;
+    Sys_UnlockMutex(fs_lock);
+    return len;
+}
+
+/*
+ * FS_UnmapFile — release a view from FS_MapFile. Views into a pak mapping
+ * stay valid until FS_Shutdown, so only fallback copies are freed.
+ */
+void FS_UnmapFile(const void *view)
+{
+    searchpath_t    *s;
+    const byte      *p = (const byte *)view;
+
+    if (!view)
+        return;
+
+    for (s = fs_searchpaths; s; s = s->next) {
+        pack_t *pak = s->pack;
+        if (pak && pak->map && p >= pak->map && p < pak->map + pak->map_size)
+            return;
+    }
+
+    Z_Free((void *)view);
+}
+
+/* ==========================================================================
+   File Stamps
+   ========================================================================== */
+
+/*
+ * FS_FileStamp — identify the copy of path that FS_FOpenFile would open,
+ * for caches of data derived from it: the pak, the entry's offset and
+ * length and the pak's mtime, or a loose file's path, size and mtime.
+ * Any change to the file or to which copy wins gives a different stamp.
+ * Returns qfalse if the file doesn't exist.
+ */
+qboolean FS_FileStamp(const char *path, char *stamp, int size)
+{
+    searchpath_t    *search;
+    fsentry_t       *entry;
+    char            netpath[MAX_OSPATH];
+    struct stat     st;
+    qboolean        found = qfalse;
+
+    Sys_LockMutex(fs_lock);
+    entry = FS_FindPakEntry(path, Com_HashString(path));
+
+    for (search = fs_searchpaths; search && !found; search = search->next) {
+        if (entry && search == entry->search) {
+            pack_t *pak = search->pack;
+
+            if (stat(pak->filename, &st) != 0)
+                st.st_mtime = 0;
+            Com_sprintf(stamp, size, "%s:%d:%d:%lld", pak->filename, entry->file->filepos,
+                        entry->file->filelen, (long long)st.st_mtime);
+            found = qtrue;
+        } else if (search->filename[0]) {
+            Com_sprintf(netpath, sizeof(netpath), "%s/%s", search->filename, path);
+            if (stat(netpath, &st) == 0) {
+                Com_sprintf(stamp, size, "%s:%lld:%lld", netpath,
+                            (long long)st.st_size, (long long)st.st_mtime);
+                found = qtrue;
+            }
+        }
+    }
+
+    Sys_UnlockMutex(fs_lock);
+    return found;
+}
+
 /* ==========================================================================
    Directory Listing
    ========================================================================== */
@@ -480,11 +811,63 @@ char *FS_NextPath(char *prevpath)
 static cvar_t *fs_basepath;
 static cvar_t *fs_game;
 
+/*
+ * fs_stats — report lookup cost since startup (or the last "fs_stats reset").
+ * The probes/compares per lookup ratio is what the hash index buys over the
+ * old linear Q_stricmp walk of every pak directory.
+ */
+static void FS_Stats_f(void)
+{
+    searchpath_t    *s;
+    int             files = 0, used = 0, longest = 0;
+    int             i;
+
+    if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset")) {
+        memset(&fs_stats, 0, sizeof(fs_stats));
+        Com_Printf("fs_stats: counters reset\n");
+        return;
+    }
+
+    for (s = fs_searchpaths; s; s = s->next) {
+        if (s->pack)
+            files += s->pack->numfiles;
+    }
+    for (i = 0; i < FS_HASH_SIZE; i++) {
+        fsentry_t *e;
+        int len = 0;
+        for (e = fs_filehash[i]; e; e = e->next)
+            len++;
+        if (len)
+            used++;
+        if (len > longest)
+            longest = len;
+    }
+
+    Com_Printf("----- Filesystem stats -----\n");
+    Com_Printf("%6d pak entries in %d/%d buckets (longest chain %d)\n",
+        files, used, FS_HASH_SIZE, longest);
+    Com_Printf("%6d lookups: %d pak, %d loose, %d missing\n",
+        fs_stats.lookups, fs_stats.pak_hits, fs_stats.loose_hits, fs_stats.misses);
+    Com_Printf("%6d chain probes, %d name compares, %d loose fopens\n",
+        fs_stats.probes, fs_stats.compares, fs_stats.loose_tries);
+    Com_Printf("%6d mapped views (%.1f MB zero-copy), %d copied fallbacks\n",
+        fs_stats.views, fs_stats.view_bytes / (1024.0 * 1024.0),
+        fs_stats.view_fallbacks);
+    if (fs_stats.lookups)
+        Com_Printf("%6.2f probes/lookup, %.2f compares/lookup\n",
+            (float)fs_stats.probes / fs_stats.lookups,
+            (float)fs_stats.compares / fs_stats.lookups);
+}
+
 void FS_InitFilesystem(void)
 {
     /* Determine base directory */
     fs_basepath = Cvar_Get("basedir", ".", CVAR_NOSET);
     fs_game = Cvar_Get("game", "", CVAR_LATCH | CVAR_SERVERINFO);
+    fs_mmap = Cvar_Get("fs_mmap", "1", CVAR_LATCH);
+
+    if (!fs_lock)
+        fs_lock = Sys_CreateMutex();
 
     Q_strncpyz(fs_basedir, fs_basepath->string, sizeof(fs_basedir));
 
@@ -495,6 +878,8 @@ void FS_InitFilesystem(void)
     if (fs_game->string[0]) {
         FS_AddGameDirectory(va("%s/%s", fs_basedir, fs_game->string));
     }
+
+    Cmd_AddCommand("fs_stats", FS_Stats_f);
 }
 
 void FS_Shutdown(void)
@@ -505,8 +890,10 @@ void FS_Shutdown(void)
         next = fs_searchpaths->next;
 
         if (fs_searchpaths->pack) {
+            FS_UnmapPack(fs_searchpaths->pack);
             if (fs_searchpaths->pack->handle)
                 fclose(fs_searchpaths->pack->handle);
+            Z_Free(fs_searchpaths->pack->entries);
             Z_Free(fs_searchpaths->pack->files);
             Z_Free(fs_searchpaths->pack);
         }
@@ -514,4 +901,6 @@ void FS_Shutdown(void)
         Z_Free(fs_searchpaths);
         fs_searchpaths = next;
     }
+
+    memset(fs_filehash, 0, sizeof(fs_filehash));
 }
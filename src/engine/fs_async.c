@@ -0,0 +1,303 @@
+/*
+ * fs_async.c - Background asset loader
+ *
+ * A small pool of worker threads that read and decode assets ahead of the
+ * main thread. Each request is a pair of callbacks sharing a context:
+ *
+ *   work(ctx)  — worker thread. Maps/reads the file and decodes it into
+ *                zone memory. Must not touch GL, cvars or subsystem state.
+ *   done(ctx)  — main thread, from FS_AsyncPump. Does the GL upload or the
+ *                final hookup and frees ctx.
+ *
+ * Any thread may queue (the sim thread registers sounds and writes saves),
+ * but only the main thread pumps: FS_AsyncPump and FS_AsyncWait do nothing
+ * anywhere else, so done() never runs beside the frame it hooks into.
+ *
+ * Level loads queue everything they know about up front (texinfo textures,
+ * precached sounds), keep working on the main thread, and only block on an
+ * asset when they actually need it. With fs_threads 0, or if no thread can
+ * be started, FS_AsyncQueue runs both callbacks inline, which is exactly
+ * the old synchronous behaviour.
+ *
+ * FS_FOpenFile, FS_MapFile, Z_Malloc and Com_Printf are serialised by their
+ * own locks, so workers can use them freely.
+ */
+
+#include "../common/qcommon.h"
+
+#define FS_MAX_WORKERS  8
+
+typedef struct fsjob_s {
+    fsasyncfunc_t   work;
+    fsasyncfunc_t   done;
+    void            *ctx;
+    struct fsjob_s  *next;
+} fsjob_t;
+
+static struct {
+    int         numworkers;
+    void        *threads[FS_MAX_WORKERS];
+
+    void        *lock;          /* guards both lists */
+    void        *work_sem;      /* one post per queued job */
+    void        *done_sem;      /* one post per finished job */
+
+    fsjob_t     *queue_head, *queue_tail;   /* waiting for a worker */
+    fsjob_t     *done_head, *done_tail;     /* waiting for FS_AsyncPump */
+
+    unsigned long   mainthread; /* the only one that pumps */
+
+    /* Sys_AtomicAdd, since any thread may queue */
+    volatile int    outstanding;    /* queued, done() not yet run */
+
+    /* Reported by fs_async; peak is written under lock */
+    volatile int    queued;
+    volatile int    completed;
+    volatile int    inlined;
+    int             peak;
+    int             wait_msec;      /* main thread time blocked in FS_AsyncPump */
+} fs_async;
+
+static cvar_t   *fs_threads;
+
+/* ==========================================================================
+   Worker Thread
+   ========================================================================== */
+
+static int FS_AsyncWorker(void *arg)
+{
+    fsjob_t *job;
+
+    (void)arg;
+
+    for (;;) {
+        Sys_SemWait(fs_async.work_sem, -1);
+
+        Sys_LockMutex(fs_async.lock);
+        job = fs_async.queue_head;
+        if (job) {
+            fs_async.queue_head = job->next;
+            if (!fs_async.queue_head)
+                fs_async.queue_tail = NULL;
+        }
+        Sys_UnlockMutex(fs_async.lock);
+
+        /* An empty wakeup is the shutdown signal */
+        if (!job)
+            break;
+
+        if (job->work)
+            job->work(job->ctx);
+
+        job->next = NULL;
+        Sys_LockMutex(fs_async.lock);
+        if (fs_async.done_tail)
+            fs_async.done_tail->next = job;
+        else
+            fs_async.done_head = job;
+        fs_async.done_tail = job;
+        Sys_UnlockMutex(fs_async.lock);
+
+        Sys_SemPost(fs_async.done_sem);
+    }
+
+    return 0;
+}
+
+/* ==========================================================================
+   Queue / Completion
+   ========================================================================== */
+
+void FS_AsyncQueue(fsasyncfunc_t work, fsasyncfunc_t done, void *ctx)
+{
+    fsjob_t *job;
+    int     n;
+
+    Sys_AtomicAdd(&fs_async.queued, 1);
+
+    if (!fs_async.numworkers) {
+        Sys_AtomicAdd(&fs_async.inlined, 1);
+        if (work)
+            work(ctx);
+        if (done)
+            done(ctx);
+        Sys_AtomicAdd(&fs_async.completed, 1);
+        return;
+    }
+
+    job = (fsjob_t *)Z_Malloc(sizeof(*job));
+    job->work = work;
+    job->done = done;
+    job->ctx = ctx;
+    job->next = NULL;
+
+    Sys_LockMutex(fs_async.lock);
+    if (fs_async.queue_tail)
+        fs_async.queue_tail->next = job;
+    else
+        fs_async.queue_head = job;
+    fs_async.queue_tail = job;
+
+    /* Counted before any worker can finish it, so a pump never sees a
+       completion it doesn't owe */
+    n = Sys_AtomicAdd(&fs_async.outstanding, 1);
+    if (n > fs_async.peak)
+        fs_async.peak = n;
+    Sys_UnlockMutex(fs_async.lock);
+
+    Sys_SemPost(fs_async.work_sem);
+}
+
+/*
+ * FS_AsyncPump — run the main-thread half of every finished job.
+ * With block set, waits for at least one completion if anything is still
+ * in flight. Every done_sem post is consumed exactly once, so the count
+ * always matches the completed list. Main thread only; anywhere else it
+ * runs nothing and returns 0.
+ */
+int FS_AsyncPump(qboolean block)
+{
+    fsjob_t *job;
+    int     n = 0;
+
+    if (!FS_AsyncMainThread())
+        return 0;
+
+    while (fs_async.outstanding > 0) {
+        int wait = (block && !n) ? -1 : 0;
+        int start = wait ? Sys_Milliseconds() : 0;
+
+        if (!Sys_SemWait(fs_async.done_sem, wait))
+            break;
+        if (wait)
+            fs_async.wait_msec += Sys_Milliseconds() - start;
+
+        Sys_LockMutex(fs_async.lock);
+        job = fs_async.done_head;
+        fs_async.done_head = job->next;
+        if (!fs_async.done_head)
+            fs_async.done_tail = NULL;
+        Sys_UnlockMutex(fs_async.lock);
+
+        if (job->done)
+            job->done(job->ctx);
+        Z_Free(job);
+
+        Sys_AtomicAdd(&fs_async.outstanding, -1);
+        Sys_AtomicAdd(&fs_async.completed, 1);
+        n++;
+    }
+
+    return n;
+}
+
+void FS_AsyncWait(void)
+{
+    if (!FS_AsyncMainThread())
+        return;
+
+    while (fs_async.outstanding > 0)
+        FS_AsyncPump(qtrue);
+}
+
+int FS_AsyncPending(void)
+{
+    return fs_async.outstanding;
+}
+
+/* Whether this thread may pump, i.e. wait on a queued load */
+qboolean FS_AsyncMainThread(void)
+{
+    return Sys_ThreadID() == fs_async.mainthread;
+}
+
+/* ==========================================================================
+   Console Command
+   ========================================================================== */
+
+static void FS_Async_f(void)
+{
+    if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset")) {
+        fs_async.queued = fs_async.completed = fs_async.inlined = 0;
+        fs_async.peak = fs_async.wait_msec = 0;
+        return;
+    }
+
+    Com_Printf("%d loader threads, %d jobs in flight (peak %d)\n",
+        fs_async.numworkers, fs_async.outstanding, fs_async.peak);
+    Com_Printf("%d queued, %d completed, %d run inline\n",
+        fs_async.queued, fs_async.completed, fs_async.inlined);
+    Com_Printf("%d ms spent waiting on workers\n", fs_async.wait_msec);
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+void FS_AsyncInit(void)
+{
+    int i, want;
+
+    memset(&fs_async, 0, sizeof(fs_async));
+    fs_async.mainthread = Sys_ThreadID();
+
+    /* -1 = one per spare core, 0 = load everything synchronously */
+    fs_threads = Cvar_Get("fs_threads", "-1", CVAR_ARCHIVE | CVAR_LATCH);
+    Cmd_AddCommand("fs_async", FS_Async_f);
+
+    want = (int)fs_threads->value;
+    if (want < 0)
+        want = Sys_CPUCount() - 1;
+    if (want > FS_MAX_WORKERS)
+        want = FS_MAX_WORKERS;
+    if (want <= 0) {
+        Com_Printf("Background loader disabled\n");
+        return;
+    }
+
+    fs_async.lock = Sys_CreateMutex();
+    fs_async.work_sem = Sys_CreateSemaphore(0);
+    fs_async.done_sem = Sys_CreateSemaphore(0);
+    if (!fs_async.lock || !fs_async.work_sem || !fs_async.done_sem) {
+        Com_Printf("FS_AsyncInit: couldn't create sync objects, loading synchronously\n");
+        FS_AsyncShutdown();
+        return;
+    }
+
+    for (i = 0; i < want; i++) {
+        fs_async.threads[i] = Sys_CreateThread(FS_AsyncWorker, "fs_loader", NULL);
+        if (!fs_async.threads[i])
+            break;
+        fs_async.numworkers++;
+    }
+
+    if (!fs_async.numworkers) {
+        Com_Printf("FS_AsyncInit: couldn't start worker threads, loading synchronously\n");
+        FS_AsyncShutdown();
+        return;
+    }
+
+    Com_Printf("Background loader: %d threads\n", fs_async.numworkers);
+}
+
+void FS_AsyncShutdown(void)
+{
+    int i, n;
+
+    FS_AsyncWait();
+
+    /* Wake every worker with an empty queue so each one exits */
+    n = fs_async.numworkers;
+    fs_async.numworkers = 0;
+    for (i = 0; i < n; i++)
+        Sys_SemPost(fs_async.work_sem);
+    for (i = 0; i < n; i++) {
+        Sys_WaitThread(fs_async.threads[i]);
+        fs_async.threads[i] = NULL;
+    }
+
+    Sys_DestroySemaphore(fs_async.work_sem);
+    Sys_DestroySemaphore(fs_async.done_sem);
+    Sys_DestroyMutex(fs_async.lock);
+    fs_async.work_sem = fs_async.done_sem = fs_async.lock = NULL;
+}
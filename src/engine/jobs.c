@@ -0,0 +1,444 @@
+/*
+ * jobs.c - Engine job system
+ *
+ * One pool of worker threads shared by every subsystem that has CPU work
+ * to spread across cores (the renderer's world gather and light grid,
+ * anything else that can split a loop into independent pieces).
+ *
+ *   Job_Add(zone, func, ctx, index, counter)
+ *               queue func(ctx, index); counter, if given, counts it
+ *   Job_Wait(counter)
+ *               run queued jobs on this thread until counter drains
+ *   Job_AddAfter(after, ...)
+ *               queue a job that only becomes runnable once `after` drains
+ *   Job_ParallelFor(zone, func, ctx, count)
+ *               func(ctx, i) for every i, returning once all have run
+ *
+ * Every thread that adds jobs pushes them onto the bottom of its own
+ * deque and takes them back from the bottom, newest first, which keeps
+ * recently-touched data in cache. An idle worker steals from the top of
+ * someone else's deque; the oldest job there is usually the biggest piece
+ * left. Worker threads own deques 1..N; the main thread and any other
+ * thread (simulation, loaders) share deque 0. Each deque has its own
+ * lock — short critical sections, no lock-free trickery to port.
+ *
+ * Waiting never blocks while there is work: Job_Wait runs jobs itself,
+ * its own first. Each job runs inside a profiler zone named by the caller,
+ * so com_profile traces show how the work landed on each core.
+ *
+ * Jobs must not call GL or touch cvars; Z_Malloc and Com_Printf are safe.
+ * With com_workers 0, or a single core, every Job_Add runs inline.
+ */
+
+#include "../common/qcommon.h"
+
+#define JOB_MAX_WORKERS     15
+#define JOB_MAX_DEQUES      (JOB_MAX_WORKERS + 1)
+#define JOB_DEQUE_SIZE      4096    /* power of two */
+#define JOB_MAX_WAITING     1024    /* Job_AddAfter jobs not yet runnable */
+
+typedef struct job_s {
+    const char      *zone;
+    jobfunc_t       func;
+    void            *ctx;
+    int             index;
+    jobcounter_t    *counter;
+    struct job_s    *next;          /* in a counter's waiting list */
+} job_t;
+
+typedef struct {
+    void            *lock;
+    volatile unsigned top, bottom;  /* steal from top, owner pushes/pops bottom */
+    job_t           jobs[JOB_DEQUE_SIZE];
+
+    unsigned long   thread;         /* owning worker, 0 for the shared deque */
+
+    /* Reported by jobs; Sys_AtomicAdd since deque 0 has several owners */
+    volatile int    run;
+    volatile int    stolen;
+} jobdeque_t;
+
+static struct {
+    int             numworkers;
+    void            *threads[JOB_MAX_WORKERS];
+    jobdeque_t      deques[JOB_MAX_DEQUES];
+
+    void            *wake;          /* one post per job added */
+    volatile int    quit;
+
+    void            *wait_lock;     /* guards counters' waiting lists and the pool */
+    job_t           waiting[JOB_MAX_WAITING];
+    job_t           *free_waiting;
+
+    volatile int    inlined;
+} jobs;
+
+static cvar_t   *com_workers;
+
+/* ==========================================================================
+   Deques
+   ========================================================================== */
+
+/* This thread's deque: its own if it is a worker, else the shared one */
+static int Job_Self(void)
+{
+    unsigned long   id;
+    int             i;
+
+    if (!jobs.numworkers)
+        return 0;
+
+    id = Sys_ThreadID();
+    for (i = 1; i <= jobs.numworkers; i++) {
+        if (jobs.deques[i].thread == id)
+            return i;
+    }
+    return 0;
+}
+
+static qboolean Job_Push(jobdeque_t *d, const job_t *job)
+{
+    qboolean ok = qfalse;
+
+    Sys_LockMutex(d->lock);
+    if (d->bottom - d->top < JOB_DEQUE_SIZE) {
+        d->jobs[d->bottom & (JOB_DEQUE_SIZE - 1)] = *job;
+        d->bottom++;
+        ok = qtrue;
+    }
+    Sys_UnlockMutex(d->lock);
+
+    return ok;
+}
+
+/* Owner end: newest first */
+static qboolean Job_Pop(jobdeque_t *d, job_t *job)
+{
+    qboolean ok = qfalse;
+
+    if (d->bottom == d->top)
+        return qfalse;      /* unlocked peek; a miss just means look elsewhere */
+
+    Sys_LockMutex(d->lock);
+    if (d->bottom != d->top) {
+        d->bottom--;
+        *job = d->jobs[d->bottom & (JOB_DEQUE_SIZE - 1)];
+        ok = qtrue;
+    }
+    Sys_UnlockMutex(d->lock);
+
+    return ok;
+}
+
+/* Thief end: oldest first */
+static qboolean Job_Steal(jobdeque_t *d, job_t *job)
+{
+    qboolean ok = qfalse;
+
+    if (d->bottom == d->top)
+        return qfalse;
+
+    Sys_LockMutex(d->lock);
+    if (d->bottom != d->top) {
+        *job = d->jobs[d->top & (JOB_DEQUE_SIZE - 1)];
+        d->top++;
+        ok = qtrue;
+    }
+    Sys_UnlockMutex(d->lock);
+
+    return ok;
+}
+
+/* ==========================================================================
+   Running Jobs
+   ========================================================================== */
+
+static void Job_Enqueue(const job_t *job);
+
+/* Run one job and retire it from its counter, releasing its dependents */
+static void Job_Execute(const job_t *job)
+{
+    jobcounter_t *c = job->counter;
+
+    Prof_Begin(job->zone);
+    job->func(job->ctx, job->index);
+    Prof_End();
+
+    if (c) {
+        job_t *list = NULL, *next;
+
+        /* Take the held jobs before the count can reach 0: a waiter may
+         * return and drop the counter as soon as it does */
+        Sys_LockMutex(jobs.wait_lock);
+        if (c->count == 1) {
+            list = c->waiting;
+            c->waiting = NULL;
+        }
+        Sys_AtomicAdd(&c->count, -1);
+        Sys_UnlockMutex(jobs.wait_lock);
+
+        for (; list; list = next) {
+            job_t ready = *list;
+
+            next = list->next;
+            Sys_LockMutex(jobs.wait_lock);
+            list->next = jobs.free_waiting;
+            jobs.free_waiting = list;
+            Sys_UnlockMutex(jobs.wait_lock);
+
+            Job_Enqueue(&ready);
+        }
+    }
+}
+
+/* Own deque first, then steal round the others; false if all were empty */
+static qboolean Job_RunOne(int self)
+{
+    job_t   job;
+    int     i, n = jobs.numworkers + 1;
+
+    if (Job_Pop(&jobs.deques[self], &job)) {
+        Sys_AtomicAdd(&jobs.deques[self].run, 1);
+        Job_Execute(&job);
+        return qtrue;
+    }
+
+    for (i = 1; i < n; i++) {
+        jobdeque_t *victim = &jobs.deques[(self + i) % n];
+
+        if (Job_Steal(victim, &job)) {
+            Sys_AtomicAdd(&jobs.deques[self].run, 1);
+            Sys_AtomicAdd(&jobs.deques[self].stolen, 1);
+            Job_Execute(&job);
+            return qtrue;
+        }
+    }
+
+    return qfalse;
+}
+
+static int Job_Worker(void *arg)
+{
+    int self = (int)(intptr_t)arg;
+
+    jobs.deques[self].thread = Sys_ThreadID();
+
+    for (;;) {
+        if (Job_RunOne(self))
+            continue;
+
+        Sys_SemWait(jobs.wake, -1);
+        if (jobs.quit)
+            break;
+    }
+
+    return 0;
+}
+
+/* Make a job runnable: this thread's deque, or inline if it is full */
+static void Job_Enqueue(const job_t *job)
+{
+    if (!jobs.numworkers || !Job_Push(&jobs.deques[Job_Self()], job)) {
+        Sys_AtomicAdd(&jobs.inlined, 1);
+        Job_Execute(job);
+        return;
+    }
+    Sys_SemPost(jobs.wake);
+}
+
+/* ==========================================================================
+   API
+   ========================================================================== */
+
+void Job_Add(const char *zone, jobfunc_t func, void *ctx, int index, jobcounter_t *counter)
+{
+    job_t job;
+
+    job.zone = zone;
+    job.func = func;
+    job.ctx = ctx;
+    job.index = index;
+    job.counter = counter;
+    job.next = NULL;
+
+    if (counter)
+        Sys_AtomicAdd(&counter->count, 1);
+    Job_Enqueue(&job);
+}
+
+/*
+ * Job_AddAfter - Queue a job that must not start before everything counted
+ * by `after` has finished. It is held on `after` and pushed by whichever
+ * thread retires the last of those jobs.
+ */
+void Job_AddAfter(jobcounter_t *after, const char *zone, jobfunc_t func, void *ctx,
+                  int index, jobcounter_t *counter)
+{
+    job_t *job;
+
+    if (counter)
+        Sys_AtomicAdd(&counter->count, 1);
+
+    Sys_LockMutex(jobs.wait_lock);
+    if (after->count > 0 && jobs.free_waiting) {
+        job = jobs.free_waiting;
+        jobs.free_waiting = job->next;
+
+        job->zone = zone;
+        job->func = func;
+        job->ctx = ctx;
+        job->index = index;
+        job->counter = counter;
+        job->next = after->waiting;
+        after->waiting = job;
+        Sys_UnlockMutex(jobs.wait_lock);
+        return;
+    }
+    Sys_UnlockMutex(jobs.wait_lock);
+
+    /* Already drained, or no room to hold it: wait for it here */
+    Job_Wait(after);
+    {
+        job_t ready = { zone, func, ctx, index, counter, NULL };
+        Job_Enqueue(&ready);
+    }
+}
+
+/* Help out until every job counted by `counter` has finished */
+void Job_Wait(jobcounter_t *counter)
+{
+    int self = Job_Self();
+
+    while (counter->count > 0) {
+        if (!Job_RunOne(self))
+            Sys_Yield();     /* the rest are running on other threads */
+    }
+}
+
+void Job_ParallelFor(const char *zone, jobfunc_t func, void *ctx, int count)
+{
+    jobcounter_t    counter;
+    int             i;
+
+    if (count <= 0)
+        return;
+    if (count == 1 || !jobs.numworkers) {
+        Prof_Begin(zone);
+        for (i = 0; i < count; i++)
+            func(ctx, i);
+        Prof_End();
+        return;
+    }
+
+    memset(&counter, 0, sizeof(counter));
+    for (i = 0; i < count; i++)
+        Job_Add(zone, func, ctx, i, &counter);
+    Job_Wait(&counter);
+}
+
+/* Threads a batch can spread over, including the caller */
+int Job_Threads(void)
+{
+    return jobs.numworkers + 1;
+}
+
+static void Job_Stats_f(void)
+{
+    int i;
+
+    if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset")) {
+        for (i = 0; i <= jobs.numworkers; i++)
+            jobs.deques[i].run = jobs.deques[i].stolen = 0;
+        jobs.inlined = 0;
+        return;
+    }
+
+    Com_Printf("%d job workers\n", jobs.numworkers);
+    for (i = 0; i <= jobs.numworkers; i++) {
+        Com_Printf("%-8s %8d run, %8d stolen\n", i ? va("worker%d", i) : "shared",
+                   jobs.deques[i].run, jobs.deques[i].stolen);
+    }
+    Com_Printf("%d run inline\n", jobs.inlined);
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+void Job_Init(void)
+{
+    int i, want;
+
+    memset(&jobs, 0, sizeof(jobs));
+
+    /* -1 = one per spare core, 0 = run every job on the thread that adds it */
+    com_workers = Cvar_Get("com_workers", "-1", CVAR_ARCHIVE | CVAR_LATCH);
+    Cmd_AddCommand("jobs", Job_Stats_f);
+
+    for (i = 0; i < JOB_MAX_WAITING - 1; i++)
+        jobs.waiting[i].next = &jobs.waiting[i + 1];
+    jobs.free_waiting = &jobs.waiting[0];
+
+    want = (int)com_workers->value;
+    if (want < 0)
+        want = Sys_CPUCount() - 1;
+    if (want > JOB_MAX_WORKERS)
+        want = JOB_MAX_WORKERS;
+
+    if (want <= 0)
+        return;
+
+    jobs.wait_lock = Sys_CreateMutex();
+    jobs.wake = Sys_CreateSemaphore(0);
+    for (i = 0; i <= want; i++) {
+        jobs.deques[i].lock = Sys_CreateMutex();
+        if (!jobs.deques[i].lock)
+            break;
+    }
+    if (!jobs.wait_lock || !jobs.wake || i <= want) {
+        Com_Printf("Job_Init: couldn't create sync objects, running jobs inline\n");
+        return;
+    }
+
+    /* Deques are claimed by index before any thread runs */
+    for (i = 0; i < want; i++) {
+        jobs.threads[i] = Sys_CreateThread(Job_Worker, "job_worker", (void *)(intptr_t)(i + 1));
+        if (!jobs.threads[i])
+            break;
+    }
+    jobs.numworkers = i;
+
+    if (!jobs.numworkers) {
+        Com_Printf("Job_Init: couldn't start worker threads, running jobs inline\n");
+        return;
+    }
+
+    Com_Printf("Job system: %d worker threads\n", jobs.numworkers);
+}
+
+void Job_Shutdown(void)
+{
+    int i, n = jobs.numworkers;
+
+    /* Finish whatever is still queued, then wake every worker to exit */
+    while (Job_RunOne(0))
+        ;
+
+    jobs.quit = 1;
+    for (i = 0; i < n; i++)
+        Sys_SemPost(jobs.wake);
+    for (i = 0; i < n; i++) {
+        Sys_WaitThread(jobs.threads[i]);
+        jobs.threads[i] = NULL;
+    }
+    jobs.numworkers = 0;
+
+    for (i = 0; i < JOB_MAX_DEQUES; i++) {
+        Sys_DestroyMutex(jobs.deques[i].lock);
+        jobs.deques[i].lock = NULL;
+    }
+    Sys_DestroySemaphore(jobs.wake);
+    Sys_DestroyMutex(jobs.wait_lock);
+    jobs.wake = jobs.wait_lock = NULL;
+    Cmd_RemoveCommand("jobs");
+}
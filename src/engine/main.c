@@ -14,6 +14,14 @@
 
 #include <SDL2/SDL.h>
 
+#ifdef SOF_PLATFORM_WINDOWS
+  #include <conio.h>
+  #include <mmsystem.h>
+#else
+  #include <sys/select.h>
+  #include <unistd.h>
+#endif
+
 /* ==========================================================================
    System Layer (Sys_* functions expected by engine)
    ========================================================================== */
@@ -50,10 +58,65 @@ void Sys_Error(const char *error, ...)
     exit(1);
 }
 
+/*
+ * Sys_ConsoleInput — one line of typed input, or NULL. Never blocks.
+ */
 char *Sys_ConsoleInput(void)
 {
-    /* TODO: Non-blocking stdin read for dedicated server mode */
+    static char text[256];
+
+#ifdef SOF_PLATFORM_WINDOWS
+    static int  len;
+
+    while (_kbhit()) {
+        int c = _getch();
+
+        if (c == '\r') {
+            _putch('\n');
+            text[len] = 0;
+            len = 0;
+            return text;
+        }
+        if (c == '\b') {
+            if (len > 0) {
+                len--;
+                _cputs("\b \b");
+            }
+        } else if (c >= ' ' && len < (int)sizeof(text) - 1) {
+            text[len++] = (char)c;
+            _putch(c);
+        }
+    }
     return NULL;
+#else
+    static qboolean stdin_closed;
+    fd_set          fdset;
+    struct timeval  timeout;
+    int             len;
+
+    if (stdin_closed)
+        return NULL;
+
+    FD_ZERO(&fdset);
+    FD_SET(0, &fdset);
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+    if (select(1, &fdset, NULL, NULL, &timeout) <= 0 || !FD_ISSET(0, &fdset))
+        return NULL;
+
+    len = (int)read(0, text, sizeof(text) - 1);
+    if (len == 0) {
+        stdin_closed = qtrue;   /* EOF — running detached */
+        return NULL;
+    }
+    if (len < 1)
+        return NULL;
+
+    if (text[len - 1] == '\n')
+        len--;
+    text[len] = 0;
+    return text;
+#endif
 }
 
 void Sys_ConsoleOutput(const char *string)
@@ -135,13 +198,184 @@ void Sys_FindClose(void)
 #endif
 }
 
+#ifdef DEDICATED_ONLY
+
+/* ==========================================================================
+   Dedicated Server Tick Scheduler
+   Nothing to draw, so nothing to gain from running faster than the game
+   ticks. Each tick sleeps until just short of its deadline, then spins the
+   last sv_tickspin microseconds on the performance counter: the OS sleep
+   is only trusted to the millisecond, the spin makes up the rest. Ticks
+   are scheduled against absolute deadlines so wake-up error never drifts.
+   ========================================================================== */
+
+#define TICK_HIST_BUCKETS   64      /* 100 us each; the last one is "later" */
+
+static cvar_t   *sv_fps;
+static cvar_t   *sv_tickspin;
+static cvar_t   *sv_tickreport;
+
+static struct {
+    int         ticks;
+    int         overruns;       /* ticks whose work outlasted the period */
+    int         resyncs;        /* times the schedule fell a period behind */
+    double      late_total;     /* wake-up lateness, microseconds */
+    double      late_max;
+    double      work_total;     /* Qcommon_Frame time, microseconds */
+    double      work_max;
+    int         hist[TICK_HIST_BUCKETS];
+} tick;
+
+static double Sys_TicksToUsec(uint64_t ticks, uint64_t freq)
+{
+    return (double)ticks * 1000000.0 / (double)freq;
+}
+
+/* Sleep through most of the wait, spin through the rest */
+static void Sys_WaitForTick(uint64_t deadline, uint64_t freq)
+{
+    uint64_t    spin = (uint64_t)(sv_tickspin->value * (double)freq / 1000000.0);
+    uint64_t    now;
+
+    while ((now = Sys_PerfCounter()) < deadline) {
+        uint64_t remain = deadline - now;
+
+        if (remain > spin) {
+            int ms = (int)((remain - spin) * 1000 / freq);
+            SDL_Delay(ms > 0 ? (Uint32)ms : 0);
+        }
+    }
+}
+
+static int Sys_TickPercentile(double frac)
+{
+    int i, sum = 0, want = (int)(tick.ticks * frac);
+
+    for (i = 0; i < TICK_HIST_BUCKETS - 1; i++) {
+        sum += tick.hist[i];
+        if (sum > want)
+            break;
+    }
+    return (i + 1) * 100;
+}
+
+static void Sys_TickReport(void)
+{
+    if (!tick.ticks) {
+        Com_Printf("No ticks yet\n");
+        return;
+    }
+
+    Com_Printf("%d ticks at %d Hz, %d overruns, %d resyncs\n",
+        tick.ticks, (int)sv_fps->value, tick.overruns, tick.resyncs);
+    Com_Printf("jitter: avg %.0f us, p99 < %d us, max %.0f us\n",
+        tick.late_total / tick.ticks, Sys_TickPercentile(0.99), tick.late_max);
+    Com_Printf("work:   avg %.0f us, max %.0f us\n",
+        tick.work_total / tick.ticks, tick.work_max);
+}
+
+static void Sys_TickStats_f(void)
+{
+    if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+        memset(&tick, 0, sizeof(tick));
+    else
+        Sys_TickReport();
+}
+
+static void Sys_DedicatedLoop(void)
+{
+    uint64_t    freq = Sys_PerfFrequency();
+    uint64_t    deadline, start, period;
+    double      msec_frac = 0;
+    int         report_time = Sys_Milliseconds();
+    char        *cmd;
+
+    /* The game runs at 10 Hz; faster only tightens command latency */
+    sv_fps = Cvar_Get("sv_fps", "10", 0);
+    sv_tickspin = Cvar_Get("sv_tickspin", "1000", 0);     /* microseconds */
+    sv_tickreport = Cvar_Get("sv_tickreport", "0", 0);    /* seconds, 0 = off */
+    Cmd_AddCommand("sv_tickstats", Sys_TickStats_f);
+
+#ifdef SOF_PLATFORM_WINDOWS
+    timeBeginPeriod(1);     /* default Sleep granularity is 15.6 ms */
+#endif
+
+    deadline = Sys_PerfCounter();
+
+    while (1) {
+        double  hz = sv_fps->value;
+        double  late, work;
+        int     msec;
+
+        if (hz < 1)
+            hz = 1;
+        else if (hz > 1000)
+            hz = 1000;
+        period = (uint64_t)((double)freq / hz);
+
+        deadline += period;
+        Sys_WaitForTick(deadline, freq);
+        start = Sys_PerfCounter();
+
+        late = Sys_TicksToUsec(start - deadline, freq);
+        tick.late_total += late;
+        if (late > tick.late_max)
+            tick.late_max = late;
+        if (late >= 100.0 * (TICK_HIST_BUCKETS - 1))
+            tick.hist[TICK_HIST_BUCKETS - 1]++;
+        else
+            tick.hist[(int)(late / 100.0)]++;
+
+        /* A whole period behind: restart the schedule from now instead of
+         * firing the missed ticks back to back. Game time still gets the
+         * full elapsed msec, so nothing is lost, only batched. */
+        msec_frac += 1000.0 / hz;
+        if (start - deadline >= period) {
+            uint64_t missed = (start - deadline) / period;
+
+            msec_frac += 1000.0 / hz * (double)missed;
+            deadline += missed * period;
+            tick.resyncs++;
+        }
+        msec = (int)msec_frac;
+        msec_frac -= msec;
+
+        while ((cmd = Sys_ConsoleInput()) != NULL) {
+            Cbuf_AddText(cmd);
+            Cbuf_AddText("\n");
+        }
+
+        Qcommon_Frame(msec);
+
+        work = Sys_TicksToUsec(Sys_PerfCounter() - start, freq);
+        tick.work_total += work;
+        if (work > tick.work_max)
+            tick.work_max = work;
+        if (work > Sys_TicksToUsec(period, freq)) {
+            tick.overruns++;
+            Com_DPrintf("tick %d overran: %.1f ms\n", tick.ticks, work / 1000.0);
+        }
+        tick.ticks++;
+
+        if (sv_tickreport->value > 0 &&
+            Sys_Milliseconds() - report_time >= (int)(sv_tickreport->value * 1000)) {
+            report_time = Sys_Milliseconds();
+            Sys_TickReport();
+        }
+    }
+}
+
+#endif /* DEDICATED_ONLY */
+
 /* ==========================================================================
    Main Entry Point
    ========================================================================== */
 
 int main(int argc, char **argv)
 {
+#ifndef DEDICATED_ONLY
     int     oldtime, newtime, msec;
+#endif
 
     /* Initialize SDL2 platform layer */
     if (!Sys_PlatformInit(argc, argv)) {
@@ -152,6 +386,9 @@ int main(int argc, char **argv)
     /* Initialize engine */
     Qcommon_Init(argc, argv);
 
+#ifdef DEDICATED_ONLY
+    Sys_DedicatedLoop();
+#else
     /* Main loop — replaces the original WinMain message pump */
     oldtime = Sys_Milliseconds();
 
@@ -163,13 +400,14 @@ int main(int argc, char **argv)
         do {
             newtime = Sys_Milliseconds();
             msec = newtime - oldtime;
-        } while (msec < 1);    /* don't spin at 0ms frames */
+        } while (msec < 1 && !CL_DemoPlaying());   /* timedemo doesn't wait */
 
         oldtime = newtime;
 
         /* Run one engine frame */
         Qcommon_Frame(msec);
     }
+#endif
 
     /* Never reached */
     return 0;
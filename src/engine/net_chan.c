@@ -0,0 +1,286 @@
+/*
+ * net_chan.c - Sequenced packets with one reliable message in flight
+ *
+ * Every packet starts with:
+ *
+ *   31 bits  sequence
+ *    1 bit   carries a reliable message
+ *   31 bits  acknowledged sequence of the last packet received
+ *    1 bit   reliable sequence of that packet (the acknowledgement)
+ *   16 bits  qport, client to server only
+ *
+ * Anything written to chan->message is reliable. It waits there until the
+ * reliable message before it is acknowledged, then goes out in every
+ * packet until its own acknowledgement arrives: the receiver flips its
+ * reliable bit each time it takes one, and the sender sees the bit come
+ * back. Unreliable data rides along in whatever room is left. Packets
+ * older than the newest received are dropped, never reordered.
+ *
+ * A packet of sequence -1 is connectionless (Netchan_OutOfBand): it
+ * carries a command string and needs no channel.
+ *
+ * Each channel keeps its own traffic totals and a rate over the last whole
+ * second, for sv_netstats.
+ *
+ * Based on Q2 net_chan.c (id Software GPL)
+ */
+
+#include "../common/qcommon.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+static cvar_t   *showpackets;
+static cvar_t   *showdrop;
+static cvar_t   *qport;
+
+static byte     net_sendbuf[MAX_MSGLEN + PACKET_HEADER];
+
+void Netchan_Init(void)
+{
+    int port;
+
+    /* A client port picked at random keeps NATs that rewrite the UDP port
+       from splitting one player into two */
+    port = Sys_Milliseconds() & 0xffff;
+
+    showpackets = Cvar_Get("showpackets", "0", 0);
+    showdrop = Cvar_Get("showdrop", "0", 0);
+    qport = Cvar_Get("qport", va("%i", port), CVAR_NOSET);
+}
+
+/* ==========================================================================
+   Stats
+   ========================================================================== */
+
+static void Netchan_RollRate(netstats_t *st)
+{
+    int now = Sys_Milliseconds();
+
+    if (now - st->rate_time < 1000)
+        return;
+
+    /* A silent gap of more than a second reads as nothing, not as the last
+       busy second */
+    if (now - st->rate_time < 2000) {
+        st->in_rate = st->rate_in;
+        st->out_rate = st->rate_out;
+    } else {
+        st->in_rate = st->out_rate = 0;
+    }
+    st->rate_in = st->rate_out = 0;
+    st->rate_time = now;
+}
+
+static void Netchan_CountOut(netstats_t *st, int bytes)
+{
+    Netchan_RollRate(st);
+    st->out_bytes += bytes;
+    st->out_packets++;
+    st->rate_out += bytes;
+    if (bytes > st->largest_out)
+        st->largest_out = bytes;
+}
+
+static void Netchan_CountIn(netstats_t *st, int bytes)
+{
+    Netchan_RollRate(st);
+    st->in_bytes += bytes;
+    st->in_packets++;
+    st->rate_in += bytes;
+}
+
+/* ==========================================================================
+   Connectionless
+   ========================================================================== */
+
+void Netchan_OutOfBand(const netadr_t *adr, int length, const byte *data)
+{
+    sizebuf_t send;
+
+    SZ_Init(&send, net_sendbuf, sizeof(net_sendbuf));
+    MSG_WriteLong(&send, -1);
+    SZ_Write(&send, data, length);
+
+    NET_SendPacket(send.cursize, send.data, adr);
+}
+
+void Netchan_OutOfBandPrint(const netadr_t *adr, const char *format, ...)
+{
+    va_list argptr;
+    char    string[MAX_MSGLEN - 4];
+
+    va_start(argptr, format);
+    vsnprintf(string, sizeof(string), format, argptr);
+    va_end(argptr);
+
+    Netchan_OutOfBand(adr, (int)strlen(string), (const byte *)string);
+}
+
+/* ==========================================================================
+   Channel
+   ========================================================================== */
+
+/*
+ * Netchan_Setup — client is set for the client's end of the connection.
+ * A client passes -1 for its own qport.
+ */
+void Netchan_Setup(netchan_t *chan, qboolean client, const netadr_t *adr, int port)
+{
+    memset(chan, 0, sizeof(*chan));
+
+    if (client && port < 0)
+        port = (int)qport->value;
+
+    chan->client = client;
+    chan->remote_address = *adr;
+    chan->qport = port;
+    chan->last_received = Sys_Milliseconds();
+    chan->incoming_sequence = 0;
+    chan->outgoing_sequence = 1;
+    chan->stats.rate_time = chan->last_received;
+
+    SZ_Init(&chan->message, chan->message_buf, sizeof(chan->message_buf));
+    chan->message.allowoverflow = qtrue;
+}
+
+/* No reliable message is waiting for its acknowledgement */
+qboolean Netchan_CanReliable(const netchan_t *chan)
+{
+    return chan->reliable_length == 0;
+}
+
+/* Something reliable has to go out, old or new */
+qboolean Netchan_NeedReliable(const netchan_t *chan)
+{
+    /* The last one went unacknowledged: resend */
+    if (chan->incoming_acknowledged > chan->last_reliable_sequence &&
+        chan->incoming_reliable_acknowledged != chan->reliable_sequence)
+        return qtrue;
+
+    /* Or a new one is waiting to go */
+    return !chan->reliable_length && chan->message.cursize;
+}
+
+/*
+ * Netchan_Transmit — Send a packet with the reliable message, if one is
+ * due, and as much of data as fits. A zero length sends a bare
+ * acknowledgement.
+ */
+void Netchan_Transmit(netchan_t *chan, int length, const byte *data)
+{
+    sizebuf_t   send;
+    qboolean    send_reliable;
+    unsigned    w1, w2;
+
+    if (chan->message.overflowed) {
+        chan->fatal_error = qtrue;
+        Com_Printf("%s: outgoing message overflow\n", NET_AdrToString(&chan->remote_address));
+        return;
+    }
+
+    send_reliable = Netchan_NeedReliable(chan);
+
+    if (!chan->reliable_length && chan->message.cursize) {
+        memcpy(chan->reliable_buf, chan->message_buf, chan->message.cursize);
+        chan->reliable_length = chan->message.cursize;
+        chan->message.cursize = 0;
+        chan->message.bit = 0;
+        chan->reliable_sequence ^= 1;
+    }
+
+    SZ_Init(&send, net_sendbuf, sizeof(net_sendbuf));
+
+    w1 = ((unsigned)chan->outgoing_sequence & ~(1u << 31)) | ((unsigned)send_reliable << 31);
+    w2 = ((unsigned)chan->incoming_sequence & ~(1u << 31)) |
+         ((unsigned)chan->incoming_reliable_sequence << 31);
+
+    chan->outgoing_sequence++;
+    chan->last_sent = Sys_Milliseconds();
+
+    MSG_WriteLong(&send, (int)w1);
+    MSG_WriteLong(&send, (int)w2);
+
+    /* The client identifies itself */
+    if (chan->client)
+        MSG_WriteShort(&send, chan->qport);
+
+    if (send_reliable) {
+        SZ_Write(&send, chan->reliable_buf, chan->reliable_length);
+        chan->last_reliable_sequence = chan->outgoing_sequence - 1;
+    }
+
+    /* Unreliable data only if it fits whole */
+    if (send.maxsize - send.cursize >= length)
+        SZ_Write(&send, data, length);
+    else
+        Com_DPrintf("Netchan_Transmit: dumped unreliable\n");
+
+    NET_SendPacket(send.cursize, send.data, &chan->remote_address);
+    Netchan_CountOut(&chan->stats, send.cursize);
+
+    if (showpackets->value)
+        Com_Printf("send %4i : s=%i%s ack=%i rack=%i\n", send.cursize,
+                   chan->outgoing_sequence - 1, send_reliable ? " reliable" : "",
+                   chan->incoming_sequence, chan->incoming_reliable_sequence);
+}
+
+/*
+ * Netchan_Process — Read the header of a packet from the remote end.
+ * qfalse means drop it: out of order or a duplicate. Otherwise msg is
+ * left at the message data.
+ */
+qboolean Netchan_Process(netchan_t *chan, sizebuf_t *msg)
+{
+    unsigned    sequence, sequence_ack;
+    int         reliable_message, reliable_ack;
+
+    MSG_BeginReading(msg);
+    sequence = (unsigned)MSG_ReadLong(msg);
+    sequence_ack = (unsigned)MSG_ReadLong(msg);
+
+    /* A server reads the client's qport; the caller matched on it */
+    if (!chan->client)
+        MSG_ReadShort(msg);
+
+    if (msg->readcount > msg->cursize)
+        return qfalse;
+
+    reliable_message = (int)(sequence >> 31);
+    reliable_ack = (int)(sequence_ack >> 31);
+    sequence &= ~(1u << 31);
+    sequence_ack &= ~(1u << 31);
+
+    if (showpackets->value)
+        Com_Printf("recv %4i : s=%u%s ack=%u rack=%i\n", msg->cursize, sequence,
+                   reliable_message ? " reliable" : "", sequence_ack, reliable_ack);
+
+    /* Old or duplicated */
+    if ((int)sequence <= chan->incoming_sequence) {
+        if (showdrop->value)
+            Com_Printf("%s: out of order packet %u at %i\n",
+                       NET_AdrToString(&chan->remote_address), sequence,
+                       chan->incoming_sequence);
+        return qfalse;
+    }
+
+    /* Dropped packets don't keep the message from being processed */
+    chan->stats.dropped += (int)sequence - (chan->incoming_sequence + 1);
+    if (showdrop->value && (int)sequence > chan->incoming_sequence + 1)
+        Com_Printf("%s: dropped %i packets at %u\n", NET_AdrToString(&chan->remote_address),
+                   (int)sequence - (chan->incoming_sequence + 1), sequence);
+
+    /* The reliable message we sent has been received */
+    if (reliable_ack == chan->reliable_sequence)
+        chan->reliable_length = 0;
+
+    chan->incoming_sequence = (int)sequence;
+    chan->incoming_acknowledged = (int)sequence_ack;
+    chan->incoming_reliable_acknowledged = reliable_ack;
+    if (reliable_message)
+        chan->incoming_reliable_sequence ^= 1;
+
+    chan->last_received = Sys_Milliseconds();
+    Netchan_CountIn(&chan->stats, msg->cursize);
+    return qtrue;
+}
@@ -11,6 +11,7 @@
 
 #include "../common/qcommon.h"
 
+#include <stddef.h>
 #include <string.h>
 #include <math.h>
 
@@ -28,6 +29,7 @@ void SZ_Init(sizebuf_t *buf, byte *data, int length)
 void SZ_Clear(sizebuf_t *buf)
 {
     buf->cursize = 0;
+    buf->bit = 0;
     buf->overflowed = qfalse;
 }
 
@@ -49,6 +51,7 @@ void *SZ_GetSpace(sizebuf_t *buf, int length)
 
     data = buf->data + buf->cursize;
     buf->cursize += length;
+    buf->bit = 0;
     return data;
 }
 
@@ -160,12 +163,326 @@ void MSG_WriteDir(sizebuf_t *sb, vec3_t dir)
     MSG_WriteAngle(sb, yaw);
 }
 
-void MSG_WriteDeltaUsercmd(sizebuf_t *sb, void *from, void *cmd)
+/* ==========================================================================
+   Bit Packing
+   ========================================================================== */
+
+void MSG_WriteBits(sizebuf_t *sb, int value, int bits)
+{
+    unsigned v = (unsigned)value;
+
+    if (bits < 32)
+        v &= (1u << bits) - 1;
+
+    while (bits > 0) {
+        byte    *b;
+        int     n;
+
+        if (!sb->bit)
+            *(byte *)SZ_GetSpace(sb, 1) = 0;
+        b = &sb->data[sb->cursize - 1];
+
+        n = 8 - sb->bit;
+        if (n > bits)
+            n = bits;
+        *b |= (byte)((v & ((1u << n) - 1)) << sb->bit);
+        v >>= n;
+        bits -= n;
+        sb->bit = (sb->bit + n) & 7;
+    }
+}
+
+int MSG_ReadBits(sizebuf_t *sb, int bits)
+{
+    unsigned    v = 0;
+    int         got = 0;
+
+    while (got < bits) {
+        int n;
+
+        if (!sb->readbit) {
+            if (sb->readcount >= sb->cursize) {
+                sb->readcount = sb->cursize + 1;
+                return -1;
+            }
+            sb->readcount++;
+        }
+
+        n = 8 - sb->readbit;
+        if (n > bits - got)
+            n = bits - got;
+        v |= ((unsigned)(sb->data[sb->readcount - 1] >> sb->readbit) & ((1u << n) - 1)) << got;
+        got += n;
+        sb->readbit = (sb->readbit + n) & 7;
+    }
+    return (int)v;
+}
+
+int MSG_ReadSBits(sizebuf_t *sb, int bits)
+{
+    int v = MSG_ReadBits(sb, bits);
+
+    if (bits < 32 && (v & (1 << (bits - 1))))
+        v |= -(1 << bits);
+    return v;
+}
+
+/* ==========================================================================
+   Delta Compression
+   Each struct is described by a field table, most often changed first. A
+   delta is the count of fields up to the last changed one, then a changed
+   bit per field and the new value for those that did. Floats go out
+   quantized, and are compared quantized, so jitter below the step sends
+   nothing.
+   ========================================================================== */
+
+#define NF_COORD        -1      /* 1/8 unit, COORD_BITS signed: +-65536 */
+#define NF_ANGLE        -2      /* 16 bits of a turn */
+#define NF_VELOCITY     -3      /* 1/8 unit, 17 bits signed: +-8192 */
+
+#define COORD_BITS      20
+
+typedef struct {
+    int     offset;
+    int     size;               /* of the member: 2 or 4 */
+    int     bits;               /* NF_* for a float, else bits of an int */
+} netfield_t;
+
+#define NETF(type, field, bits) \
+    { (int)offsetof(type, field), (int)sizeof(((type *)0)->field), bits }
+
+static const netfield_t entity_fields[] = {
+    NETF(entity_state_t, origin[0], NF_COORD),
+    NETF(entity_state_t, origin[1], NF_COORD),
+    NETF(entity_state_t, angles[1], NF_ANGLE),
+    NETF(entity_state_t, origin[2], NF_COORD),
+    NETF(entity_state_t, frame, 16),
+    NETF(entity_state_t, event, 8),
+    NETF(entity_state_t, angles[0], NF_ANGLE),
+    NETF(entity_state_t, angles[2], NF_ANGLE),
+    NETF(entity_state_t, modelindex, 8),
+    NETF(entity_state_t, effects, 32),
+    NETF(entity_state_t, renderfx, 32),
+    NETF(entity_state_t, sound, 8),
+    NETF(entity_state_t, skinnum, 32),
+    NETF(entity_state_t, solid, 32),
+    NETF(entity_state_t, modelindex2, 8),
+    NETF(entity_state_t, modelindex3, 8),
+    NETF(entity_state_t, modelindex4, 8),
+    NETF(entity_state_t, old_origin[0], NF_COORD),  /* RF_BEAM endpoints */
+    NETF(entity_state_t, old_origin[1], NF_COORD),
+    NETF(entity_state_t, old_origin[2], NF_COORD),
+};
+
+static const netfield_t pmove_fields[] = {
+    NETF(pmove_state_t, origin[0], NF_COORD),
+    NETF(pmove_state_t, origin[1], NF_COORD),
+    NETF(pmove_state_t, velocity[0], NF_VELOCITY),
+    NETF(pmove_state_t, velocity[1], NF_VELOCITY),
+    NETF(pmove_state_t, origin[2], NF_COORD),
+    NETF(pmove_state_t, velocity[2], NF_VELOCITY),
+    NETF(pmove_state_t, pm_flags, 8),
+    NETF(pmove_state_t, pm_time, 8),
+    NETF(pmove_state_t, pm_type, 4),
+    NETF(pmove_state_t, gravity, 16),
+    NETF(pmove_state_t, delta_angles[0], 16),
+    NETF(pmove_state_t, delta_angles[1], 16),
+    NETF(pmove_state_t, delta_angles[2], 16),
+};
+
+#define NUM_ENTITY_FIELDS   (int)(sizeof(entity_fields) / sizeof(entity_fields[0]))
+#define NUM_PMOVE_FIELDS    (int)(sizeof(pmove_fields) / sizeof(pmove_fields[0]))
+#define FIELDCOUNT_BITS     5   /* holds either count */
+
+/* The value a field goes out as */
+static int MSG_FieldValue(const netfield_t *f, const void *base)
+{
+    const byte *p = (const byte *)base + f->offset;
+
+    switch (f->bits) {
+    case NF_COORD:
+    case NF_VELOCITY:
+        return (int)floorf(*(const float *)p * 8.0f + 0.5f);
+    case NF_ANGLE:
+        return ANGLE2SHORT(*(const float *)p) & 0xFFFF;
+    default:
+        if (f->size == 2)
+            return *(const short *)p;
+        return *(const int *)p;
+    }
+}
+
+static void MSG_SetField(const netfield_t *f, void *base, int value)
+{
+    byte *p = (byte *)base + f->offset;
+
+    switch (f->bits) {
+    case NF_COORD:
+    case NF_VELOCITY:
+        *(float *)p = value * (1.0f / 8.0f);
+        break;
+    case NF_ANGLE:
+        *(float *)p = SHORT2ANGLE(value);
+        break;
+    default:
+        if (f->size == 2)
+            *(short *)p = (short)value;
+        else
+            *(int *)p = value;
+        break;
+    }
+}
+
+static int MSG_FieldBits(const netfield_t *f)
+{
+    switch (f->bits) {
+    case NF_COORD:      return COORD_BITS;
+    case NF_ANGLE:      return 16;
+    case NF_VELOCITY:   return 17;
+    default:            return f->bits;
+    }
+}
+
+/* Sign-extended on read; the ints that are never negative don't care */
+static qboolean MSG_FieldSigned(const netfield_t *f)
+{
+    return f->bits == NF_COORD || f->bits == NF_VELOCITY || f->size == 2;
+}
+
+static void MSG_WriteDeltaFields(sizebuf_t *sb, const netfield_t *fields, int count,
+                                 const void *from, const void *to)
+{
+    int i, last = 0;
+
+    for (i = 0; i < count; i++)
+        if (MSG_FieldValue(&fields[i], from) != MSG_FieldValue(&fields[i], to))
+            last = i + 1;
+
+    MSG_WriteBits(sb, last, FIELDCOUNT_BITS);
+    for (i = 0; i < last; i++) {
+        int v = MSG_FieldValue(&fields[i], to);
+
+        if (v == MSG_FieldValue(&fields[i], from)) {
+            MSG_WriteBits(sb, 0, 1);
+        } else {
+            MSG_WriteBits(sb, 1, 1);
+            MSG_WriteBits(sb, v, MSG_FieldBits(&fields[i]));
+        }
+    }
+}
+
+static void MSG_ReadDeltaFields(sizebuf_t *sb, const netfield_t *fields, int count,
+                                void *to)
+{
+    int i, last = MSG_ReadBits(sb, FIELDCOUNT_BITS);
+
+    if (last > count)
+        last = 0;       /* garbage; leave to as from */
+
+    for (i = 0; i < last; i++) {
+        int bits, v;
+
+        if (!MSG_ReadBits(sb, 1))
+            continue;
+        bits = MSG_FieldBits(&fields[i]);
+        v = MSG_FieldSigned(&fields[i]) ? MSG_ReadSBits(sb, bits) : MSG_ReadBits(sb, bits);
+        MSG_SetField(&fields[i], to, v);
+    }
+}
+
+static qboolean MSG_FieldsDiffer(const netfield_t *fields, int count,
+                                 const void *from, const void *to)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        if (MSG_FieldValue(&fields[i], from) != MSG_FieldValue(&fields[i], to))
+            return qtrue;
+    return qfalse;
+}
+
+/*
+ * MSG_WriteDeltaEntity — number, removed bit, then the changed fields.
+ * The number is to's, or from's for a removal.
+ */
+void MSG_WriteDeltaEntity(sizebuf_t *sb, const entity_state_t *from,
+                          const entity_state_t *to, qboolean force)
+{
+    if (!to) {
+        MSG_WriteBits(sb, from->number, ENTNUM_BITS);
+        MSG_WriteBits(sb, 1, 1);
+        return;
+    }
+
+    if (!force && !MSG_FieldsDiffer(entity_fields, NUM_ENTITY_FIELDS, from, to))
+        return;
+
+    MSG_WriteBits(sb, to->number, ENTNUM_BITS);
+    MSG_WriteBits(sb, 0, 1);
+    MSG_WriteDeltaFields(sb, entity_fields, NUM_ENTITY_FIELDS, from, to);
+}
+
+qboolean MSG_ReadDeltaEntity(sizebuf_t *sb, const entity_state_t *from,
+                             entity_state_t *to, int number)
+{
+    if (MSG_ReadBits(sb, 1)) {
+        memset(to, 0, sizeof(*to));
+        to->number = number;
+        return qfalse;
+    }
+
+    *to = *from;
+    to->number = number;
+    MSG_ReadDeltaFields(sb, entity_fields, NUM_ENTITY_FIELDS, to);
+    return qtrue;
+}
+
+void MSG_WriteDeltaPmove(sizebuf_t *sb, const pmove_state_t *from,
+                         const pmove_state_t *to)
 {
-    /* Stub — full delta encoding needed for multiplayer */
-    (void)sb; (void)from; (void)cmd;
+    MSG_WriteDeltaFields(sb, pmove_fields, NUM_PMOVE_FIELDS, from, to);
 }
 
+void MSG_ReadDeltaPmove(sizebuf_t *sb, const pmove_state_t *from,
+                        pmove_state_t *to)
+{
+    *to = *from;
+    MSG_ReadDeltaFields(sb, pmove_fields, NUM_PMOVE_FIELDS, to);
+}
+
+/*
+ * Usercmds go out three to a packet, each against the one before, so
+ * a changed bit per field wins over a field table
+ */
+void MSG_WriteDeltaUsercmd(sizebuf_t *sb, void *from, void *cmd)
+{
+    const usercmd_t *a = (const usercmd_t *)from;
+    const usercmd_t *b = (const usercmd_t *)cmd;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        MSG_WriteBits(sb, b->angles[i] != a->angles[i], 1);
+        if (b->angles[i] != a->angles[i])
+            MSG_WriteBits(sb, b->angles[i], 16);
+    }
+    MSG_WriteBits(sb, b->forwardmove != a->forwardmove, 1);
+    if (b->forwardmove != a->forwardmove)
+        MSG_WriteBits(sb, b->forwardmove, 16);
+    MSG_WriteBits(sb, b->sidemove != a->sidemove, 1);
+    if (b->sidemove != a->sidemove)
+        MSG_WriteBits(sb, b->sidemove, 16);
+    MSG_WriteBits(sb, b->upmove != a->upmove, 1);
+    if (b->upmove != a->upmove)
+        MSG_WriteBits(sb, b->upmove, 16);
+    MSG_WriteBits(sb, b->buttons != a->buttons, 1);
+    if (b->buttons != a->buttons)
+        MSG_WriteBits(sb, b->buttons, 16);
+    MSG_WriteBits(sb, b->impulse != a->impulse, 1);
+    if (b->impulse != a->impulse)
+        MSG_WriteBits(sb, b->impulse, 8);
+    MSG_WriteBits(sb, b->msec, 8);
+    MSG_WriteBits(sb, b->lightlevel, 8);
+}
 /* ==========================================================================
    Message Reading
    ========================================================================== */
@@ -173,12 +490,14 @@ void MSG_WriteDeltaUsercmd(sizebuf_t *sb, void *from, void *cmd)
 void MSG_BeginReading(sizebuf_t *sb)
 {
     sb->readcount = 0;
+    sb->readbit = 0;
 }
 
 int MSG_ReadChar(sizebuf_t *sb)
 {
     int c;
 
+    sb->readbit = 0;
     if (sb->readcount + 1 > sb->cursize)
         return -1;
 
@@ -191,6 +510,7 @@ int MSG_ReadByte(sizebuf_t *sb)
 {
     int c;
 
+    sb->readbit = 0;
     if (sb->readcount + 1 > sb->cursize)
         return -1;
 
@@ -203,6 +523,7 @@ int MSG_ReadShort(sizebuf_t *sb)
 {
     int c;
 
+    sb->readbit = 0;
     if (sb->readcount + 2 > sb->cursize)
         return -1;
 
@@ -215,6 +536,7 @@ int MSG_ReadLong(sizebuf_t *sb)
 {
     int c;
 
+    sb->readbit = 0;
     if (sb->readcount + 4 > sb->cursize)
         return -1;
 
@@ -291,5 +613,24 @@ void MSG_ReadDir(sizebuf_t *sb, vec3_t dir)
 
 void MSG_ReadDeltaUsercmd(sizebuf_t *sb, void *from, void *cmd)
 {
-    (void)sb; (void)from; (void)cmd;
+    usercmd_t *b = (usercmd_t *)cmd;
+    int i;
+
+    *b = *(const usercmd_t *)from;
+
+    for (i = 0; i < 3; i++)
+        if (MSG_ReadBits(sb, 1))
+            b->angles[i] = (short)MSG_ReadBits(sb, 16);
+    if (MSG_ReadBits(sb, 1))
+        b->forwardmove = (short)MSG_ReadBits(sb, 16);
+    if (MSG_ReadBits(sb, 1))
+        b->sidemove = (short)MSG_ReadBits(sb, 16);
+    if (MSG_ReadBits(sb, 1))
+        b->upmove = (short)MSG_ReadBits(sb, 16);
+    if (MSG_ReadBits(sb, 1))
+        b->buttons = (short)MSG_ReadBits(sb, 16);
+    if (MSG_ReadBits(sb, 1))
+        b->impulse = (byte)MSG_ReadBits(sb, 8);
+    b->msec = (byte)MSG_ReadBits(sb, 8);
+    b->lightlevel = (byte)MSG_ReadBits(sb, 8);
 }
@@ -0,0 +1,291 @@
+/*
+ * net_udp.c - UDP sockets
+ *
+ * One non-blocking IPv4 socket, bound to net_ip:net_port. It is opened by
+ * the server (sv_net.c) for dedicated servers, or for a listen server
+ * with net_listen 1; the local player never goes through it.
+ *
+ * Replaces the WSOCK32.dll ordinal imports of the original (see
+ * win32_compat.h) with Winsock2 or BSD sockets. IPX is gone.
+ *
+ * Based on Q2 net_udp.c (id Software GPL)
+ */
+
+#include "../common/qcommon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SOF_PLATFORM_WINDOWS
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  typedef SOCKET netsocket_t;
+  #define NET_BADSOCKET     INVALID_SOCKET
+  #define NET_ERRNO()       WSAGetLastError()
+  #define NET_WOULDBLOCK(e) ((e) == WSAEWOULDBLOCK)
+  #define NET_BOUNCED(e)    ((e) == WSAECONNRESET)
+  #define NET_CLOSE         closesocket
+#else
+  #include <sys/types.h>
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <netdb.h>
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <errno.h>
+  typedef int netsocket_t;
+  #define NET_BADSOCKET     (-1)
+  #define NET_ERRNO()       errno
+  #define NET_WOULDBLOCK(e) ((e) == EWOULDBLOCK || (e) == EAGAIN)
+  #define NET_BOUNCED(e)    ((e) == ECONNREFUSED)
+  #define NET_CLOSE         close
+#endif
+
+static netsocket_t  net_socket = NET_BADSOCKET;
+static qboolean     net_started;
+
+static cvar_t       *net_ip;
+static cvar_t       *net_port;
+
+/* ==========================================================================
+   Addresses
+   ========================================================================== */
+
+static void NET_AdrToSockadr(const netadr_t *a, struct sockaddr_in *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->sin_family = AF_INET;
+    s->sin_port = a->port;
+    if (a->type == NA_BROADCAST)
+        s->sin_addr.s_addr = INADDR_BROADCAST;
+    else
+        memcpy(&s->sin_addr, a->ip, 4);
+}
+
+static void NET_SockadrToAdr(const struct sockaddr_in *s, netadr_t *a)
+{
+    memset(a, 0, sizeof(*a));
+    a->type = NA_IP;
+    memcpy(a->ip, &s->sin_addr, 4);
+    a->port = s->sin_port;
+}
+
+qboolean NET_CompareAdr(const netadr_t *a, const netadr_t *b)
+{
+    return a->type == b->type && !memcmp(a->ip, b->ip, 4) && a->port == b->port;
+}
+
+/* Ignores the port */
+qboolean NET_CompareBaseAdr(const netadr_t *a, const netadr_t *b)
+{
+    return a->type == b->type && !memcmp(a->ip, b->ip, 4);
+}
+
+const char *NET_AdrToString(const netadr_t *a)
+{
+    static char s[64];
+
+    snprintf(s, sizeof(s), "%i.%i.%i.%i:%i", a->ip[0], a->ip[1], a->ip[2], a->ip[3],
+             ntohs(a->port));
+    return s;
+}
+
+/*
+ * NET_StringToAdr — "host" or "host:port", by name or dotted quad.
+ * The port defaults to PORT_SERVER.
+ */
+qboolean NET_StringToAdr(const char *s, netadr_t *a)
+{
+    struct addrinfo     hints, *res;
+    struct sockaddr_in  sadr;
+    char                host[256];
+    char                *colon;
+    int                 port = PORT_SERVER;
+
+    Q_strncpyz(host, s, sizeof(host));
+    colon = strchr(host, ':');
+    if (colon) {
+        *colon = 0;
+        port = atoi(colon + 1);
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(host, NULL, &hints, &res) || !res)
+        return qfalse;
+
+    memcpy(&sadr, res->ai_addr, sizeof(sadr));
+    freeaddrinfo(res);
+
+    sadr.sin_port = htons((unsigned short)port);
+    NET_SockadrToAdr(&sadr, a);
+    return qtrue;
+}
+
+/* ==========================================================================
+   Packets
+   ========================================================================== */
+
+qboolean NET_GetPacket(netadr_t *from, sizebuf_t *msg)
+{
+    struct sockaddr_in  sadr;
+    socklen_t           len = sizeof(sadr);
+    int                 ret;
+
+    if (net_socket == NET_BADSOCKET)
+        return qfalse;
+
+    for (;;) {
+        ret = (int)recvfrom(net_socket, (char *)msg->data, msg->maxsize, 0,
+                            (struct sockaddr *)&sadr, &len);
+        if (ret < 0) {
+            int err = NET_ERRNO();
+
+            if (NET_BOUNCED(err))
+                continue;   /* an earlier send was refused: look for the next */
+            if (!NET_WOULDBLOCK(err))
+                Com_DPrintf("NET_GetPacket: error %i\n", err);
+            return qfalse;
+        }
+
+        NET_SockadrToAdr(&sadr, from);
+        if (ret == msg->maxsize) {
+            Com_Printf("Oversize packet from %s\n", NET_AdrToString(from));
+            continue;
+        }
+
+        msg->cursize = ret;
+        msg->bit = 0;
+        return qtrue;
+    }
+}
+
+void NET_SendPacket(int length, const void *data, const netadr_t *to)
+{
+    struct sockaddr_in  sadr;
+    int                 ret;
+
+    if (net_socket == NET_BADSOCKET)
+        return;
+
+    NET_AdrToSockadr(to, &sadr);
+    ret = (int)sendto(net_socket, (const char *)data, length, 0,
+                      (struct sockaddr *)&sadr, sizeof(sadr));
+    if (ret < 0) {
+        int err = NET_ERRNO();
+
+        if (!NET_WOULDBLOCK(err) && !NET_BOUNCED(err))
+            Com_Printf("NET_SendPacket to %s: error %i\n", NET_AdrToString(to), err);
+    }
+}
+
+/* ==========================================================================
+   Socket
+   ========================================================================== */
+
+static netsocket_t NET_OpenSocket(const char *ip, int port)
+{
+    netsocket_t         sock;
+    struct sockaddr_in  address;
+    int                 one = 1;
+
+    sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == NET_BADSOCKET) {
+        Com_Printf("NET_OpenSocket: socket: error %i\n", NET_ERRNO());
+        return NET_BADSOCKET;
+    }
+
+#ifdef SOF_PLATFORM_WINDOWS
+    {
+        u_long nonblocking = 1;
+        ioctlsocket(sock, FIONBIO, &nonblocking);
+    }
+#else
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, (const char *)&one, sizeof(one));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    if (!ip[0] || !Q_stricmp(ip, "localhost")) {
+        address.sin_addr.s_addr = INADDR_ANY;
+    } else {
+        netadr_t a;
+
+        if (!NET_StringToAdr(ip, &a)) {
+            Com_Printf("NET_OpenSocket: bad net_ip %s\n", ip);
+            NET_CLOSE(sock);
+            return NET_BADSOCKET;
+        }
+        memcpy(&address.sin_addr, a.ip, 4);
+    }
+    address.sin_port = htons((unsigned short)port);
+
+    if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        Com_Printf("NET_OpenSocket: bind %s:%i: error %i\n", ip, port, NET_ERRNO());
+        NET_CLOSE(sock);
+        return NET_BADSOCKET;
+    }
+
+    return sock;
+}
+
+/* NET_Config — Open or close the server socket */
+void NET_Config(qboolean open)
+{
+    if (!net_started)
+        return;
+
+    if (!open) {
+        if (net_socket != NET_BADSOCKET) {
+            NET_CLOSE(net_socket);
+            net_socket = NET_BADSOCKET;
+        }
+        return;
+    }
+
+    if (net_socket != NET_BADSOCKET)
+        return;
+
+    net_socket = NET_OpenSocket(net_ip->string, (int)net_port->value);
+    if (net_socket != NET_BADSOCKET)
+        Com_Printf("UDP listening on %s:%i\n",
+                   net_ip->string[0] ? net_ip->string : "*", (int)net_port->value);
+}
+
+qboolean NET_IsOpen(void)
+{
+    return net_socket != NET_BADSOCKET;
+}
+
+void NET_Init(void)
+{
+#ifdef SOF_PLATFORM_WINDOWS
+    WSADATA wsadata;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsadata)) {
+        Com_Printf("NET_Init: WSAStartup failed, no networking\n");
+        return;
+    }
+#endif
+
+    net_ip = Cvar_Get("net_ip", "localhost", CVAR_LATCH);
+    net_port = Cvar_Get("net_port", va("%i", PORT_SERVER), CVAR_LATCH);
+    net_started = qtrue;
+}
+
+void NET_Shutdown(void)
+{
+    NET_Config(qfalse);
+#ifdef SOF_PLATFORM_WINDOWS
+    if (net_started)
+        WSACleanup();
+#endif
+    net_started = qfalse;
+}
@@ -0,0 +1,544 @@
+/*
+ * prof.c - Hierarchical frame profiler
+ *
+ * Prof_Begin/Prof_End bracket a named zone. Zones nest, are timed with the
+ * high-resolution Sys_PerfCounter, and may be opened from any thread; each
+ * thread gets its own stack and its own ring of finished zones, so the
+ * only shared state touched per zone is read-only.
+ *
+ *   com_profile 0   off — Prof_Begin is a single branch
+ *   com_profile 1   record zones into the per-thread rings
+ *   com_profile 2   record, and draw the main thread's zone tree on screen
+ *
+ * `profile_dump [file]` writes the rings as Chrome trace JSON (load it in
+ * chrome://tracing or ui.perfetto.dev). The rings hold the last
+ * PROF_RING_SIZE zones per thread, so dumping right after a hitch captures
+ * the frames around it.
+ *
+ * Map loads are timed separately, whatever com_profile is set to, and
+ * `map_load_profile` prints the last one broken down by phase.
+ */
+
+#include "../common/qcommon.h"
+#include "win32_compat.h"
+#include "../renderer/r_local.h"
+
+#define PROF_MAX_THREADS    32      /* main, sim, loaders and job workers */
+#define PROF_MAX_DEPTH      32
+#define PROF_RING_SIZE      65536   /* finished zones kept per thread, power of two */
+#define PROF_MAX_ZONES      128     /* distinct main-thread zones in the overlay */
+#define PROF_ZONE_HASH      256     /* power of two, > PROF_MAX_ZONES */
+#define PROF_PEAK_FRAMES    60      /* overlay max/visibility window */
+
+typedef struct {
+    const char  *name;
+    uint64_t    start, end;
+} profevent_t;
+
+/* Per-frame statistics for one main-thread zone, keyed by name pointer */
+typedef struct {
+    const char  *name;
+    int         depth;          /* nesting depth when first entered */
+    int         order;          /* entry order within the frame */
+    int         lastframe;      /* frame this zone last ran in */
+    uint64_t    ticks;          /* inclusive time this frame */
+    int         calls;          /* entries this frame */
+    float       avg_ms;         /* smoothed per-frame time */
+    float       avg_calls;
+    float       peak_ms, shown_peak_ms;
+} profzone_t;
+
+typedef struct {
+    const char  *name;
+    uint64_t    start;
+    profzone_t  *zone;          /* main thread only */
+} profscope_t;
+
+typedef struct {
+    unsigned long   id;
+    int             depth;      /* may run past PROF_MAX_DEPTH; extra levels untimed */
+    profscope_t     stack[PROF_MAX_DEPTH];
+    profevent_t     *ring;
+    unsigned        head;       /* zones written so far */
+} profthread_t;
+
+static profthread_t prof_threads[PROF_MAX_THREADS];
+static volatile int prof_numthreads;
+static void         *prof_lock;         /* guards thread registration */
+static unsigned long prof_mainthread;
+
+static volatile int prof_active;        /* latched from com_profile once per frame */
+static volatile int prof_dumping;       /* rings are being read, don't write */
+
+static uint64_t     prof_freq;
+static uint64_t     prof_base;          /* trace timestamps are relative to this */
+static uint64_t     prof_framestart;
+
+static profzone_t   prof_zones[PROF_MAX_ZONES];
+static profzone_t   *prof_zonehash[PROF_ZONE_HASH];
+static int          prof_numzones;
+static int          prof_framenum;
+static int          prof_order;
+
+static float        prof_frame_avg, prof_frame_peak, prof_frame_shownpeak;
+
+static cvar_t       *com_profile;
+
+/* ==========================================================================
+   Thread Registration
+   ========================================================================== */
+
+/*
+ * Prof_Thread — this thread's slot, registering it on first use. Returns
+ * NULL once every slot is taken; that thread simply goes unprofiled.
+ */
+static profthread_t *Prof_Thread(void)
+{
+    unsigned long   id = Sys_ThreadID();
+    profthread_t    *t;
+    int             i, n = prof_numthreads;
+
+    for (i = 0; i < n; i++) {
+        if (prof_threads[i].id == id)
+            return &prof_threads[i];
+    }
+
+    /* Only this thread ever registers itself, so no re-check is needed;
+     * the lock just keeps two new threads from taking the same slot */
+    Sys_LockMutex(prof_lock);
+    t = NULL;
+    i = prof_numthreads;
+    if (i < PROF_MAX_THREADS) {
+        t = &prof_threads[i];
+        memset(t, 0, sizeof(*t));
+        t->id = id;
+        t->ring = (profevent_t *)Z_Malloc(PROF_RING_SIZE * sizeof(profevent_t));
+        prof_numthreads = i + 1;
+    }
+    Sys_UnlockMutex(prof_lock);
+
+    return t;
+}
+
+/* ==========================================================================
+   Main-Thread Zone Statistics
+   ========================================================================== */
+
+static profzone_t *Prof_Zone(const char *name)
+{
+    unsigned    h = (unsigned)(((uintptr_t)name >> 3) & (PROF_ZONE_HASH - 1));
+    profzone_t  *z;
+
+    while ((z = prof_zonehash[h]) != NULL) {
+        if (z->name == name)
+            return z;
+        h = (h + 1) & (PROF_ZONE_HASH - 1);
+    }
+
+    if (prof_numzones == PROF_MAX_ZONES)
+        return NULL;
+
+    z = &prof_zones[prof_numzones++];
+    memset(z, 0, sizeof(*z));
+    z->name = name;
+    z->lastframe = -1;
+    prof_zonehash[h] = z;
+    return z;
+}
+
+/* ==========================================================================
+   Zones
+   ========================================================================== */
+
+void Prof_Begin(const char *name)
+{
+    profthread_t    *t;
+    profscope_t     *s;
+
+    if (!prof_active)
+        return;
+
+    t = Prof_Thread();
+    if (!t)
+        return;
+
+    if (t->depth >= PROF_MAX_DEPTH) {
+        t->depth++;
+        return;
+    }
+
+    s = &t->stack[t->depth];
+    s->name = name;
+    s->zone = NULL;
+
+    if (t->id == prof_mainthread) {
+        s->zone = Prof_Zone(name);
+        if (s->zone && s->zone->lastframe != prof_framenum) {
+            s->zone->lastframe = prof_framenum;
+            s->zone->depth = t->depth;
+            s->zone->order = prof_order++;
+            s->zone->ticks = 0;
+            s->zone->calls = 0;
+        }
+    }
+
+    t->depth++;
+    s->start = Sys_PerfCounter();
+}
+
+/*
+ * Prof_End — close the innermost zone. Pops whenever something is open,
+ * even after com_profile was switched off, so a zone that straddles the
+ * switch can never unbalance the stack.
+ */
+void Prof_End(void)
+{
+    uint64_t        now;
+    profthread_t    *t;
+    profscope_t     *s;
+    profevent_t     *ev;
+    int             i, n = prof_numthreads;
+    unsigned long   id;
+
+    if (!n)
+        return;
+
+    id = Sys_ThreadID();
+    for (i = 0, t = NULL; i < n; i++) {
+        if (prof_threads[i].id == id) {
+            t = &prof_threads[i];
+            break;
+        }
+    }
+    if (!t || !t->depth)
+        return;
+
+    if (--t->depth >= PROF_MAX_DEPTH || !prof_active)
+        return;
+
+    now = Sys_PerfCounter();
+    s = &t->stack[t->depth];
+    if (s->zone) {
+        s->zone->ticks += now - s->start;
+        s->zone->calls++;
+    }
+
+    if (prof_dumping)
+        return;
+
+    ev = &t->ring[t->head & (PROF_RING_SIZE - 1)];
+    ev->name = s->name;
+    ev->start = s->start;
+    ev->end = now;
+    t->head++;
+}
+
+/* ==========================================================================
+   Frame Boundaries
+   ========================================================================== */
+
+void Prof_FrameBegin(void)
+{
+    prof_active = (com_profile && com_profile->value) ? 1 : 0;
+    prof_framestart = Sys_PerfCounter();
+    prof_order = 0;
+
+    Prof_Begin("Qcommon_Frame");
+}
+
+void Prof_FrameEnd(void)
+{
+    profzone_t  *z;
+    float       ms;
+    int         i;
+
+    Prof_End();
+
+    if (!prof_active)
+        return;
+
+    ms = (float)((double)(Sys_PerfCounter() - prof_framestart) * 1000.0 / (double)prof_freq);
+    prof_frame_avg = prof_frame_avg * 0.9f + ms * 0.1f;
+    if (ms > prof_frame_peak)
+        prof_frame_peak = ms;
+
+    for (i = 0, z = prof_zones; i < prof_numzones; i++, z++) {
+        int     calls = 0;
+
+        ms = 0;
+        if (z->lastframe == prof_framenum) {
+            ms = (float)((double)z->ticks * 1000.0 / (double)prof_freq);
+            calls = z->calls;
+        }
+        z->avg_ms = z->avg_ms * 0.9f + ms * 0.1f;
+        z->avg_calls = z->avg_calls * 0.9f + calls * 0.1f;
+        if (ms > z->peak_ms)
+            z->peak_ms = ms;
+    }
+
+    /* Peaks are shown for the previous window so they stay readable */
+    if (!(prof_framenum % PROF_PEAK_FRAMES)) {
+        prof_frame_shownpeak = prof_frame_peak;
+        prof_frame_peak = 0;
+        for (i = 0, z = prof_zones; i < prof_numzones; i++, z++) {
+            z->shown_peak_ms = z->peak_ms;
+            z->peak_ms = 0;
+        }
+    }
+
+    prof_framenum++;
+}
+
+/* ==========================================================================
+   Overlay
+   ========================================================================== */
+
+#ifndef DEDICATED_ONLY
+void Prof_DrawOverlay(void)
+{
+    profzone_t  *list[PROF_MAX_ZONES];
+    char        line[64];
+    int         i, j, n, x, y;
+
+    if (!prof_active || !com_profile || com_profile->value < 2)
+        return;
+
+    /* Recently active zones in entry order, which reads as a call tree */
+    for (i = n = 0; i < prof_numzones; i++) {
+        profzone_t *z = &prof_zones[i];
+
+        if (prof_framenum - z->lastframe > PROF_PEAK_FRAMES)
+            continue;
+        for (j = n; j > 0 && list[j - 1]->order > z->order; j--)
+            list[j] = list[j - 1];
+        list[j] = z;
+        n++;
+    }
+
+    x = g_display.width - 8 * 48 - 8;
+    y = 8;
+    R_DrawFill(x - 4, y - 4, 8 * 48 + 8, (n + 2) * 10 + 4, (int)0xA0000000);
+
+    R_SetDrawColor(1.0f, 1.0f, 0.0f, 1.0f);
+    Com_sprintf(line, sizeof(line), "%-26s %6s %6s %6s", "frame", "avg", "max", "calls");
+    R_DrawString(x, y, line);
+    y += 10;
+    Com_sprintf(line, sizeof(line), "%-26s %6.2f %6.2f", "", prof_frame_avg, prof_frame_shownpeak);
+    R_DrawString(x, y, line);
+    y += 10;
+
+    for (i = 0; i < n; i++) {
+        profzone_t  *z = list[i];
+        char        label[32];
+        int         indent = z->depth > 8 ? 8 : z->depth;
+
+        Com_sprintf(label, sizeof(label), "%*s%s", indent, "", z->name);
+        Com_sprintf(line, sizeof(line), "%-26.26s %6.2f %6.2f %6.0f",
+            label, z->avg_ms, z->shown_peak_ms, z->avg_calls);
+
+        if (z->avg_ms > 4.0f)
+            R_SetDrawColor(1.0f, 0.3f, 0.3f, 1.0f);
+        else
+            R_SetDrawColor(0.85f, 0.85f, 0.85f, 1.0f);
+        R_DrawString(x, y, line);
+        y += 10;
+    }
+
+    R_SetDrawColor(1.0f, 1.0f, 1.0f, 1.0f);
+}
+#endif /* !DEDICATED_ONLY */
+
+/* ==========================================================================
+   Trace Export
+   ========================================================================== */
+
+static void Prof_WriteString(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 32)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/*
+ * Profile_Dump_f — write every thread's ring as Chrome "complete" events.
+ * Recording is paused while the rings are read; a zone that another thread
+ * was in the middle of writing may come out torn, which only affects that
+ * one event.
+ */
+static void Profile_Dump_f(void)
+{
+    char        path[MAX_OSPATH];
+    FILE        *f;
+    double      usec = 1000000.0 / (double)prof_freq;
+    int         i, count = 0;
+    qboolean    first = qtrue;
+
+    Com_sprintf(path, sizeof(path), "%s/%s", FS_Gamedir(),
+        Cmd_Argc() > 1 ? Cmd_Argv(1) : "profile.json");
+
+    if (!prof_numthreads) {
+        Com_Printf("Nothing recorded, set com_profile 1 first\n");
+        return;
+    }
+
+    f = fopen(path, "w");
+    if (!f) {
+        Com_Printf("Couldn't write %s\n", path);
+        return;
+    }
+
+    prof_dumping = 1;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (i = 0; i < prof_numthreads; i++) {
+        profthread_t    *t = &prof_threads[i];
+        unsigned        e, start;
+
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", i + 1,
+            t->id == prof_mainthread ? "main" : va("thread %d", i + 1));
+        first = qfalse;
+
+        start = t->head > PROF_RING_SIZE ? t->head - PROF_RING_SIZE : 0;
+        for (e = start; e != t->head; e++) {
+            profevent_t *ev = &t->ring[e & (PROF_RING_SIZE - 1)];
+
+            fprintf(f, ",\n{\"name\":");
+            Prof_WriteString(f, ev->name);
+            fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                i + 1, (double)(ev->start - prof_base) * usec,
+                (double)(ev->end - ev->start) * usec);
+            count++;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    prof_dumping = 0;
+
+    Com_Printf("Wrote %d zones from %d threads to %s\n", count, prof_numthreads, path);
+}
+
+/* ==========================================================================
+   Map Load Profile
+   ========================================================================== */
+
+#define LOAD_MAX_DEPTH  8
+
+static const char *load_phase_names[LOAD_NUM_PHASES] = {
+    "bsp", "lightmaps", "textures", "entities", "scripts", "sounds", "navigation"
+};
+
+static struct {
+    qboolean    active;
+    char        map[MAX_QPATH];
+    uint64_t    start, mark;            /* load start, last phase switch */
+    uint64_t    total;
+    uint64_t    ticks[LOAD_NUM_PHASES]; /* exclusive of nested phases */
+    int         calls[LOAD_NUM_PHASES];
+    int         stack[LOAD_MAX_DEPTH];
+    int         depth;
+} load_prof;
+
+/* Charge the time since the last switch to the innermost open phase */
+static void Prof_MapLoadCharge(void)
+{
+    uint64_t now = Sys_PerfCounter();
+
+    if (load_prof.depth > 0 && load_prof.depth <= LOAD_MAX_DEPTH)
+        load_prof.ticks[load_prof.stack[load_prof.depth - 1]] += now - load_prof.mark;
+    load_prof.mark = now;
+}
+
+void Prof_MapLoadStart(const char *mapname)
+{
+    memset(&load_prof, 0, sizeof(load_prof));
+    Q_strncpyz(load_prof.map, mapname, sizeof(load_prof.map));
+    load_prof.active = qtrue;
+    load_prof.start = load_prof.mark = Sys_PerfCounter();
+}
+
+void Prof_MapLoadBegin(int phase)
+{
+    if (!load_prof.active || phase < 0 || phase >= LOAD_NUM_PHASES)
+        return;
+
+    Prof_MapLoadCharge();
+    if (load_prof.depth < LOAD_MAX_DEPTH)
+        load_prof.stack[load_prof.depth] = phase;
+    load_prof.depth++;
+    load_prof.calls[phase]++;
+}
+
+void Prof_MapLoadEnd(void)
+{
+    if (!load_prof.active || load_prof.depth <= 0)
+        return;
+
+    Prof_MapLoadCharge();
+    load_prof.depth--;
+}
+
+void Prof_MapLoadFinish(void)
+{
+    if (!load_prof.active)
+        return;
+
+    Prof_MapLoadCharge();
+    load_prof.total = load_prof.mark - load_prof.start;
+    load_prof.active = qfalse;
+    load_prof.depth = 0;
+
+    Com_DPrintf("Map %s loaded in %.1f ms\n", load_prof.map,
+        (double)load_prof.total * 1000.0 / (double)prof_freq);
+}
+
+static void Prof_MapLoadProfile_f(void)
+{
+    double ms = 1000.0 / (double)prof_freq;
+    uint64_t accounted = 0;
+    int i;
+
+    if (!load_prof.total) {
+        Com_Printf("No map loaded yet\n");
+        return;
+    }
+
+    Com_Printf("Map load: %s, %.1f ms\n", load_prof.map, (double)load_prof.total * ms);
+    for (i = 0; i < LOAD_NUM_PHASES; i++) {
+        accounted += load_prof.ticks[i];
+        Com_Printf("  %-12s %9.1f ms %5.1f%%  (%d)\n", load_phase_names[i],
+            (double)load_prof.ticks[i] * ms,
+            100.0 * (double)load_prof.ticks[i] / (double)load_prof.total,
+            load_prof.calls[i]);
+    }
+    if (load_prof.total > accounted)
+        Com_Printf("  %-12s %9.1f ms %5.1f%%\n", "other",
+            (double)(load_prof.total - accounted) * ms,
+            100.0 * (double)(load_prof.total - accounted) / (double)load_prof.total);
+}
+
+/* ==========================================================================
+   Init
+   ========================================================================== */
+
+void Prof_Init(void)
+{
+    prof_freq = Sys_PerfFrequency();
+    if (!prof_freq)
+        prof_freq = 1000;
+    prof_base = Sys_PerfCounter();
+    prof_mainthread = Sys_ThreadID();
+    prof_lock = Sys_CreateMutex();
+
+    com_profile = Cvar_Get("com_profile", "0", 0);
+    Cmd_AddCommand("profile_dump", Profile_Dump_f);
+    Cmd_AddCommand("map_load_profile", Prof_MapLoadProfile_f);
+}
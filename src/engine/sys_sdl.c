@@ -34,7 +34,12 @@ int Sys_PlatformInit(int argc, char **argv)
     if (sys_initialized)
         return 1;
 
+#ifdef DEDICATED_ONLY
+    /* Headless: no window, audio device or controllers */
+    if (SDL_Init(SDL_INIT_TIMER) < 0) {
+#else
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER | SDL_INIT_TIMER) < 0) {
+#endif
         fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
         return 0;
     }
@@ -67,7 +72,9 @@ void Sys_PlatformShutdown(void)
     if (!sys_initialized)
         return;
 
+#ifndef DEDICATED_ONLY
     Sys_DestroyWindow();
+#endif
     SDL_Quit();
     sys_initialized = 0;
 }
@@ -81,20 +88,167 @@ int Sys_Milliseconds(void)
     return (int)SDL_GetTicks();
 }
 
+/* High-resolution counter for the profiler; ticks per second from
+ * Sys_PerfFrequency. Only differences are meaningful. */
+uint64_t Sys_PerfCounter(void)
+{
+    return (uint64_t)SDL_GetPerformanceCounter();
+}
+
+uint64_t Sys_PerfFrequency(void)
+{
+    return (uint64_t)SDL_GetPerformanceFrequency();
+}
+
+/* ==========================================================================
+   Threads and Synchronisation
+   Thin wrappers so engine code never includes SDL directly. SDL mutexes are
+   recursive. A NULL mutex/semaphore is accepted everywhere and does nothing,
+   which lets subsystems lock unconditionally before threading is set up.
+   ========================================================================== */
+
+void *Sys_CreateThread(int (*func)(void *), const char *name, void *arg)
+{
+    return SDL_CreateThread(func, name, arg);
+}
+
+void Sys_WaitThread(void *thread)
+{
+    if (thread)
+        SDL_WaitThread((SDL_Thread *)thread, NULL);
+}
+
+unsigned long Sys_ThreadID(void)
+{
+    return (unsigned long)SDL_ThreadID();
+}
+
+int Sys_CPUCount(void)
+{
+    int n = SDL_GetCPUCount();
+    return n > 0 ? n : 1;
+}
+
+void *Sys_CreateMutex(void)
+{
+    return SDL_CreateMutex();
+}
+
+void Sys_DestroyMutex(void *mutex)
+{
+    if (mutex)
+        SDL_DestroyMutex((SDL_mutex *)mutex);
+}
+
+void Sys_LockMutex(void *mutex)
+{
+    if (mutex)
+        SDL_LockMutex((SDL_mutex *)mutex);
+}
+
+void Sys_UnlockMutex(void *mutex)
+{
+    if (mutex)
+        SDL_UnlockMutex((SDL_mutex *)mutex);
+}
+
+void *Sys_CreateSemaphore(int value)
+{
+    return SDL_CreateSemaphore((Uint32)value);
+}
+
+void Sys_DestroySemaphore(void *sem)
+{
+    if (sem)
+        SDL_DestroySemaphore((SDL_sem *)sem);
+}
+
+void Sys_SemPost(void *sem)
+{
+    if (sem)
+        SDL_SemPost((SDL_sem *)sem);
+}
+
+/* Wait on a semaphore; msec < 0 waits forever. Returns 0 on timeout. */
+int Sys_SemWait(void *sem, int msec)
+{
+    if (!sem)
+        return 0;
+    if (msec < 0)
+        return SDL_SemWait((SDL_sem *)sem) == 0;
+    return SDL_SemWaitTimeout((SDL_sem *)sem, (Uint32)msec) == 0;
+}
+
+int Sys_AtomicAdd(volatile int *value, int delta)
+{
+    return SDL_AtomicAdd((SDL_atomic_t *)value, delta) + delta;
+}
+
+/* Give up the rest of this time slice */
+void Sys_Yield(void)
+{
+    SDL_Delay(0);
+}
+
+#ifndef DEDICATED_ONLY
+
 /* ==========================================================================
    Window Management
    ========================================================================== */
 
+/* Context version for the next Sys_CreateWindow; the renderer raises it
+ * when it has a path that can use more than GL 2.1 */
+static int gl_req_major = 2, gl_req_minor = 1;
+
+void Sys_GL_RequestVersion(int major, int minor)
+{
+    gl_req_major = major;
+    gl_req_minor = minor;
+}
+
+/* A Vulkan window has no GL context; the renderer makes its own surface */
+static int vk_window;
+
+void Sys_RequestVulkanWindow(int vulkan)
+{
+    vk_window = vulkan;
+}
+
+static void Sys_GL_SetContextVersion(int major, int minor)
+{
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, major);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, minor);
+    /* 3.2+ has profiles: keep the fixed-function pipeline SoF's code needs */
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        major > 3 || (major == 3 && minor >= 2)
+                            ? SDL_GL_CONTEXT_PROFILE_COMPATIBILITY : 0);
+}
+
 int Sys_CreateWindow(int width, int height, int fullscreen)
 {
-    uint32_t flags = SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
+    uint32_t flags = (vk_window ? SDL_WINDOW_VULKAN : SDL_WINDOW_OPENGL) | SDL_WINDOW_SHOWN;
 
     if (fullscreen)
         flags |= SDL_WINDOW_FULLSCREEN;
 
-    /* Request OpenGL 2.1 compatibility (enough for SoF's GL 1.1 code) */
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+    if (vk_window) {
+        g_display.window = SDL_CreateWindow(
+            "Soldier of Fortune",
+            SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+            width, height, flags
+        );
+        if (!g_display.window) {
+            fprintf(stderr, "SDL_CreateWindow (Vulkan) failed: %s\n", SDL_GetError());
+            return 0;
+        }
+        g_display.width = width;
+        g_display.height = height;
+        g_display.fullscreen = fullscreen;
+        return 1;
+    }
+
+    /* OpenGL 2.1 compatibility is enough for SoF's GL 1.1 code */
+    Sys_GL_SetContextVersion(gl_req_major, gl_req_minor);
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
     SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
@@ -115,6 +269,12 @@ int Sys_CreateWindow(int width, int height, int fullscreen)
     }
 
     g_display.gl_context = SDL_GL_CreateContext(g_display.window);
+    if (!g_display.gl_context && (gl_req_major != 2 || gl_req_minor != 1)) {
+        fprintf(stderr, "No OpenGL %d.%d context (%s), trying 2.1\n",
+                gl_req_major, gl_req_minor, SDL_GetError());
+        Sys_GL_SetContextVersion(2, 1);
+        g_display.gl_context = SDL_GL_CreateContext(g_display.window);
+    }
     if (!g_display.gl_context) {
         fprintf(stderr, "SDL_GL_CreateContext failed: %s\n", SDL_GetError());
         SDL_DestroyWindow(g_display.window);
@@ -192,10 +352,20 @@ void Sys_GetDesktopSize(int *width, int *height)
 
 void Sys_SwapBuffers(void)
 {
-    if (g_display.window)
+    if (g_display.window && g_display.gl_context)
         SDL_GL_SwapWindow(g_display.window);
 }
 
+/* 1 = vsync, 0 = swap immediately. Returns the interval it had before. */
+int Sys_SetSwapInterval(int interval)
+{
+    int old = SDL_GL_GetSwapInterval();
+
+    if (g_display.gl_context)
+        SDL_GL_SetSwapInterval(interval);
+    return old;
+}
+
 /* ==========================================================================
    Input
    ========================================================================== */
@@ -260,14 +430,23 @@ int Sys_GL_MakeCurrent(void)
     return SDL_GL_MakeCurrent(g_display.window, g_display.gl_context) == 0;
 }
 
+#endif /* !DEDICATED_ONLY */
+
 /* ==========================================================================
    Message Box
    ========================================================================== */
 
 void Sys_MessageBox(const char *title, const char *message, int error)
 {
+#ifdef DEDICATED_ONLY
+    /* No display to put it on; Sys_Error already wrote it to stderr */
+    (void)title;
+    (void)message;
+    (void)error;
+#else
     uint32_t flags = error ? SDL_MESSAGEBOX_ERROR : SDL_MESSAGEBOX_INFORMATION;
     SDL_ShowSimpleMessageBox(flags, title, message, g_display.window);
+#endif
 }
 
 /* ==========================================================================
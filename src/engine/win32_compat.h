@@ -497,14 +497,22 @@ void    Sys_GetOSVersion(sof_osversion_t *ver);
 /* High-resolution timer using SDL2 — declared in qcommon.h as int */
 /* uint32_t Sys_Milliseconds(void); — see qcommon.h */
 
+/* --- Threads (wraps SDL2) --- */
+
+/* Sys_CreateThread, Sys_CreateMutex, Sys_CreateSemaphore etc. are used by
+ * the engine core and are declared in qcommon.h */
+
 /* --- Window Management (wraps SDL2) --- */
 
 int     Sys_CreateWindow(int width, int height, int fullscreen);
+void    Sys_GL_RequestVersion(int major, int minor);
+void    Sys_RequestVulkanWindow(int vulkan);
 void    Sys_DestroyWindow(void);
 void    Sys_SetWindowTitle(const char *title);
 int     Sys_SetDisplayMode(int width, int height, int fullscreen);
 void    Sys_GetDesktopSize(int *width, int *height);
 void    Sys_SwapBuffers(void);
+int     Sys_SetSwapInterval(int interval);
 
 /* --- Input (wraps SDL2) --- */
 
@@ -6,24 +6,107 @@
  *
  * SoF exports: Z_Malloc, Z_Free, Z_Touch
  * Original addresses: Z_Malloc=0x20940, Z_Free=0x203D0, Z_Touch=0x20430
+ *
+ * Backing store:
+ *   - Z_TAG_LEVEL and Z_TAG_TEMP blocks up to Z_SMALL_MAX come from one
+ *     bump arena per tag. Their owners free them in bulk, and Z_FreeTags
+ *     on those tags just rewinds the arena. Z_Free of an arena block only
+ *     reclaims it when it is the most recent allocation; otherwise the
+ *     space comes back at the reset.
+ *   - Other small blocks come from size-class slabs with free lists, so
+ *     they never reach the system allocator after warm-up. That includes
+ *     Z_TAG_GAME, which lives until game shutdown but is freed a block at
+ *     a time (finished scripts, a reloaded save's strings), so an arena
+ *     would only grow.
+ *   - Anything larger is malloc'd, as before.
+ * Slab and malloc blocks stay on a per-tag chain so Z_FreeTags still works
+ * for every tag. Everything is serialised by z_lock because the background
+ * loader's workers allocate too.
  */
 
 #include "../common/qcommon.h"
 
-/* Zone memory block header */
+#ifdef SOF_PLATFORM_WINDOWS
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+#endif
+
+/* Zone memory block header — 32 bytes keeps user data 16-byte aligned */
 typedef struct zhead_s {
-    struct zhead_s  *prev, *next;
-    int             size;       /* including header */
-    int             tag;        /* Z_TAG_* */
+    struct zhead_s  *prev, *next;   /* tag chain (slab/malloc); free list */
+    int             size;           /* block size including header */
+    int             tag;            /* Z_TAG_* */
     int             magic;
+    unsigned short  kind;           /* ZK_* */
+    unsigned short  sizeclass;      /* slab class index */
 } zhead_t;
 
 #define Z_MAGIC     0x1D1D1D1D
+#define Z_FREEMAGIC 0x1D1DDEAD
 #define Z_MAXSIZE   0x1000000   /* 16 MB max single allocation */
 
-static zhead_t  z_chain;
-static int      z_count;
-static int      z_bytes;
+#define ZK_MALLOC   0
+#define ZK_SLAB     1
+#define ZK_ARENA    2
+
+#define Z_ALIGN(x)      (((x) + 15) & ~15)
+#define Z_SMALL_MAX     4096            /* largest slab/arena block, header included */
+#define Z_SLAB_PAGE     0x10000         /* slab pages are carved from 64 KB mallocs */
+#define Z_ARENA_CHUNK   0x40000         /* arenas grow in 256 KB chunks */
+
+/* Stats slot per known tag, plus one for anything else the game passes */
+#define Z_STATSLOTS     (Z_NUMTAGS + 1)
+
+static const int z_classsizes[] = {
+    64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+#define Z_NUMCLASSES    ((int)(sizeof(z_classsizes) / sizeof(z_classsizes[0])))
+
+typedef struct zchunk_s {
+    struct zchunk_s *next;
+    int             size;           /* usable bytes after this header */
+    int             used;
+} zchunk_t;
+
+typedef struct {
+    zchunk_t        *head;
+    zchunk_t        *cur;           /* chunks after cur are always empty */
+    int             reserved;       /* bytes in all chunks */
+} zarena_t;
+
+typedef struct {
+    int             blocks;
+    int             bytes;          /* live bytes, headers included */
+    int             peak;           /* high-water mark of bytes */
+    int             allocs;         /* lifetime Z_TagMalloc calls */
+    int             resets;         /* Z_FreeTags calls */
+} ztagstats_t;
+
+static zhead_t      z_chain[Z_STATSLOTS];       /* sentinels */
+static ztagstats_t  z_tagstats[Z_STATSLOTS];
+static zarena_t     z_arenas[Z_NUMTAGS];
+static zhead_t      *z_freelist[Z_NUMCLASSES];
+static byte         z_classindex[Z_SMALL_MAX / 16 + 1];
+static int          z_slabbytes;                /* slab pages reserved */
+static int          z_count;
+static int          z_bytes;
+
+/* The zone is shared with the background loader's worker threads */
+static void         *z_lock;
+
+static int Z_StatSlot(int tag)
+{
+    return (tag >= 0 && tag < Z_NUMTAGS) ? tag : Z_NUMTAGS;
+}
+
+static qboolean Z_IsArenaTag(int tag)
+{
+    return tag == Z_TAG_LEVEL || tag == Z_TAG_TEMP;
+}
 
 /* ==========================================================================
    Z_Init
@@ -31,9 +114,112 @@ static int      z_bytes;
 
 void Z_Init(void)
 {
-    z_chain.next = z_chain.prev = &z_chain;
+    int i, c;
+
+    for (i = 0; i < Z_STATSLOTS; i++)
+        z_chain[i].next = z_chain[i].prev = &z_chain[i];
+    memset(z_tagstats, 0, sizeof(z_tagstats));
+    memset(z_arenas, 0, sizeof(z_arenas));
+    memset(z_freelist, 0, sizeof(z_freelist));
+    z_slabbytes = 0;
     z_count = 0;
     z_bytes = 0;
+
+    /* Size (in 16-byte steps) -> smallest class that holds it */
+    for (i = 0, c = 0; i <= Z_SMALL_MAX / 16; i++) {
+        while (z_classsizes[c] < i * 16)
+            c++;
+        z_classindex[i] = (byte)c;
+    }
+
+    if (!z_lock)
+        z_lock = Sys_CreateMutex();
+}
+
+/* ==========================================================================
+   Backing Stores
+   ========================================================================== */
+
+static zhead_t *Z_SlabAlloc(int size)
+{
+    int     c = z_classindex[size >> 4];
+    zhead_t *z = z_freelist[c];
+
+    if (!z) {
+        /* Carve a fresh page into blocks of this class */
+        int     bsize = z_classsizes[c];
+        int     n = Z_SLAB_PAGE / bsize;
+        byte    *page = (byte *)malloc(Z_SLAB_PAGE);
+        int     i;
+
+        if (!page)
+            return NULL;
+        z_slabbytes += Z_SLAB_PAGE;
+
+        for (i = n - 1; i >= 0; i--) {
+            zhead_t *b = (zhead_t *)(page + i * bsize);
+            b->prev = z;
+            z = b;
+        }
+    }
+
+    z_freelist[c] = z->prev;
+    z->kind = ZK_SLAB;
+    z->sizeclass = (unsigned short)c;
+    z->size = z_classsizes[c];
+    return z;
+}
+
+static zhead_t *Z_ArenaAlloc(zarena_t *arena, int size)
+{
+    zchunk_t *ch = arena->cur;
+    zhead_t  *z;
+
+    if (!ch || ch->used + size > ch->size) {
+        /* Chunks past cur are empty after a reset; reuse before growing */
+        if (ch && ch->next) {
+            ch = ch->next;
+        } else {
+            zchunk_t *nc = (zchunk_t *)malloc(sizeof(zchunk_t) + Z_ARENA_CHUNK);
+            if (!nc)
+                return NULL;
+            nc->next = NULL;
+            nc->size = Z_ARENA_CHUNK;
+            nc->used = 0;
+            if (ch)
+                ch->next = nc;
+            else
+                arena->head = nc;
+            arena->reserved += Z_ARENA_CHUNK;
+            ch = nc;
+        }
+        arena->cur = ch;
+    }
+
+    z = (zhead_t *)((byte *)(ch + 1) + ch->used);
+    ch->used += size;
+    z->kind = ZK_ARENA;
+    z->sizeclass = 0;
+    z->size = size;
+    return z;
+}
+
+/* Give back an arena block if nothing was allocated after it */
+static void Z_ArenaFree(zarena_t *arena, zhead_t *z)
+{
+    zchunk_t *ch = arena->cur;
+
+    if (ch && (byte *)z + z->size == (byte *)(ch + 1) + ch->used)
+        ch->used -= z->size;
+}
+
+static void Z_ArenaReset(zarena_t *arena)
+{
+    zchunk_t *ch;
+
+    for (ch = arena->head; ch; ch = ch->next)
+        ch->used = 0;
+    arena->cur = arena->head;
 }
 
 /* ==========================================================================
@@ -43,30 +229,59 @@ void Z_Init(void)
 void *Z_TagMalloc(int size, int tag)
 {
     zhead_t *z;
+    int     slot, total;
 
     if (size <= 0)
         Com_Error(ERR_FATAL, "Z_TagMalloc: size %d", size);
     if (size > Z_MAXSIZE)
         Com_Error(ERR_FATAL, "Z_TagMalloc: %d bytes is too large", size);
 
-    size += sizeof(zhead_t);
-    z = (zhead_t *)malloc(size);
-    if (!z)
-        Com_Error(ERR_FATAL, "Z_TagMalloc: failed on allocation of %d bytes", size);
+    total = Z_ALIGN(size + (int)sizeof(zhead_t));
+    slot = Z_StatSlot(tag);
+
+    Sys_LockMutex(z_lock);
+
+    if (total > Z_SMALL_MAX) {
+        z = (zhead_t *)malloc(total);
+        if (z) {
+            z->kind = ZK_MALLOC;
+            z->sizeclass = 0;
+            z->size = total;
+        }
+    } else if (Z_IsArenaTag(tag)) {
+        z = Z_ArenaAlloc(&z_arenas[tag], total);
+    } else {
+        z = Z_SlabAlloc(total);
+    }
+
+    if (!z) {
+        Sys_UnlockMutex(z_lock);
+        Com_Error(ERR_FATAL, "Z_TagMalloc: failed on allocation of %d bytes", total);
+        return NULL;
+    }
 
-    memset(z, 0, size);
     z->magic = Z_MAGIC;
     z->tag = tag;
-    z->size = size;
 
-    z->next = z_chain.next;
-    z->prev = &z_chain;
-    z_chain.next->prev = z;
-    z_chain.next = z;
+    if (z->kind != ZK_ARENA) {
+        z->next = z_chain[slot].next;
+        z->prev = &z_chain[slot];
+        z_chain[slot].next->prev = z;
+        z_chain[slot].next = z;
+    }
 
     z_count++;
-    z_bytes += size;
+    z_bytes += z->size;
+    z_tagstats[slot].blocks++;
+    z_tagstats[slot].allocs++;
+    z_tagstats[slot].bytes += z->size;
+    if (z_tagstats[slot].bytes > z_tagstats[slot].peak)
+        z_tagstats[slot].peak = z_tagstats[slot].bytes;
+
+    Sys_UnlockMutex(z_lock);
 
+    /* Callers rely on zeroed memory; only the user part needs clearing */
+    memset(z + 1, 0, size);
     return (void *)(z + 1);
 }
 
@@ -86,6 +301,7 @@ void *Z_Malloc(int size)
 void Z_Free(void *ptr)
 {
     zhead_t *z;
+    int     slot;
 
     if (!ptr)
         return;
@@ -95,13 +311,30 @@ void Z_Free(void *ptr)
     if (z->magic != Z_MAGIC)
         Com_Error(ERR_FATAL, "Z_Free: bad magic (%x)", z->magic);
 
-    z->prev->next = z->next;
-    z->next->prev = z->prev;
+    Sys_LockMutex(z_lock);
 
+    slot = Z_StatSlot(z->tag);
+    z->magic = Z_FREEMAGIC;
     z_count--;
     z_bytes -= z->size;
+    z_tagstats[slot].blocks--;
+    z_tagstats[slot].bytes -= z->size;
+
+    if (z->kind == ZK_ARENA) {
+        Z_ArenaFree(&z_arenas[z->tag], z);
+    } else {
+        z->prev->next = z->next;
+        z->next->prev = z->prev;
+
+        if (z->kind == ZK_SLAB) {
+            z->prev = z_freelist[z->sizeclass];
+            z_freelist[z->sizeclass] = z;
+        } else {
+            free(z);
+        }
+    }
 
-    free(z);
+    Sys_UnlockMutex(z_lock);
 }
 
 /* ==========================================================================
@@ -122,73 +355,242 @@ void Z_Touch(void *ptr)
 void Z_FreeTags(int tag)
 {
     zhead_t *z, *next;
+    int     slot = Z_StatSlot(tag);
+
+    Sys_LockMutex(z_lock);
 
-    for (z = z_chain.next; z != &z_chain; z = next) {
+    /* Slab and malloc blocks are chained per tag */
+    for (z = z_chain[slot].next; z != &z_chain[slot]; z = next) {
         next = z->next;
         if (z->tag == tag) {
             Z_Free((void *)(z + 1));
         }
     }
+
+    /* Arena blocks go all at once. Whatever is left in the slot belongs
+     * to the arena, so the counters can simply drop to zero */
+    if (Z_IsArenaTag(tag)) {
+        Z_ArenaReset(&z_arenas[tag]);
+        z_count -= z_tagstats[slot].blocks;
+        z_bytes -= z_tagstats[slot].bytes;
+        z_tagstats[slot].blocks = 0;
+        z_tagstats[slot].bytes = 0;
+    }
+
+    z_tagstats[slot].resets++;
+
+    Sys_UnlockMutex(z_lock);
+}
+
+/* ==========================================================================
+   Z_Stats_f — "z_stats" console command
+   ========================================================================== */
+
+void Z_Stats_f(void)
+{
+    static const char *names[Z_STATSLOTS] = {
+        "general", "level", "game", "temp", "other"
+    };
+    int i;
+
+    Sys_LockMutex(z_lock);
+
+    Com_Printf("%d bytes in %d blocks\n", z_bytes, z_count);
+    Com_Printf("tag       blocks      bytes       peak     allocs resets  arena\n");
+    for (i = 0; i < Z_STATSLOTS; i++) {
+        ztagstats_t *st = &z_tagstats[i];
+        Com_Printf("%-8s %7d %10d %10d %10d %6d %6dK\n", names[i],
+            st->blocks, st->bytes, st->peak, st->allocs, st->resets,
+            i < Z_NUMTAGS ? z_arenas[i].reserved >> 10 : 0);
+    }
+    Com_Printf("%dK in slab pages\n", z_slabbytes >> 10);
+
+    Sys_UnlockMutex(z_lock);
 }
 
 /* ==========================================================================
    Hunk Memory — large persistent allocations via virtual memory
    ========================================================================== */
 
+/*
+ * Hunk_Begin reserves address space only; Hunk_Alloc commits pages in
+ * HUNK_COMMIT steps as the hunk grows, so a generous maxsize costs nothing
+ * until it is used. Fresh pages come back zeroed from the OS. The header
+ * lives in the first committed bytes of the reservation.
+ */
+
 typedef struct {
-    int     maxsize;
-    int     cursize;
+    int     maxsize;        /* reserved bytes after the header */
+    int     cursize;        /* bytes handed out */
+    int     committed;      /* bytes after the header backed by memory */
+    int     pad;
 } hunkheader_t;
 
-void *Hunk_Begin(int maxsize)
-{
-    hunkheader_t *hdr;
+#define HUNK_HEADER     32                  /* keeps allocations 32-byte aligned */
+#define HUNK_COMMIT     0x10000             /* commit granularity */
+#define HUNK_ROUND(x)   (((x) + HUNK_COMMIT - 1) & ~(HUNK_COMMIT - 1))
 
-    /* Allocate the maximum possible size upfront.
-     * On modern systems with virtual memory, this is fine —
-     * only touched pages actually consume physical memory. */
-    hdr = (hunkheader_t *)malloc(maxsize + sizeof(hunkheader_t));
-    if (!hdr)
-        Com_Error(ERR_FATAL, "Hunk_Begin: failed on %d bytes", maxsize);
+static hunkheader_t *hunk_current;          /* target of Hunk_Alloc/Hunk_End */
 
-    memset(hdr, 0, sizeof(hunkheader_t));
-    hdr->maxsize = maxsize;
+static hunkheader_t *Hunk_Reserve(int maxsize)
+{
+    size_t          total = (size_t)HUNK_ROUND(maxsize + HUNK_HEADER);
+    hunkheader_t    *hdr;
+
+#ifdef SOF_PLATFORM_WINDOWS
+    hdr = (hunkheader_t *)VirtualAlloc(NULL, total, MEM_RESERVE, PAGE_NOACCESS);
+    if (!hdr || !VirtualAlloc(hdr, HUNK_COMMIT, MEM_COMMIT, PAGE_READWRITE))
+        Com_Error(ERR_FATAL, "Hunk_Begin: reserve failed on %d bytes", maxsize);
+#else
+    hdr = (hunkheader_t *)mmap(NULL, total, PROT_NONE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (hdr == MAP_FAILED ||
+        mprotect(hdr, HUNK_COMMIT, PROT_READ | PROT_WRITE) != 0)
+        Com_Error(ERR_FATAL, "Hunk_Begin: reserve failed on %d bytes", maxsize);
+#endif
+
+    hdr->maxsize = (int)total - HUNK_HEADER;
     hdr->cursize = 0;
-
-    return (void *)hdr;
+    hdr->committed = HUNK_COMMIT - HUNK_HEADER;
+    return hdr;
 }
 
-void *Hunk_Alloc(int size)
+static void *Hunk_AllocIn(hunkheader_t *hdr, int size)
 {
-    hunkheader_t *hdr;
-    byte *buf;
-
-    /* The hunk base pointer was returned by Hunk_Begin */
-    /* We need to recover it — in Q2, this was stored globally */
-    /* For now, this is a simplified version */
+    byte    *base = (byte *)hdr + HUNK_HEADER;
+    byte    *buf;
 
     /* Align to 32 bytes */
     size = (size + 31) & ~31;
 
-    /* TODO: In the full implementation, Hunk_Alloc works on the
-     * current hunk allocated by Hunk_Begin. For now, just malloc. */
-    buf = (byte *)malloc(size);
-    if (!buf)
-        Com_Error(ERR_FATAL, "Hunk_Alloc: failed on %d bytes", size);
-    memset(buf, 0, size);
+    if (hdr->cursize + size > hdr->maxsize)
+        Com_Error(ERR_FATAL, "Hunk_Alloc: overflow (%d + %d > %d)",
+                  hdr->cursize, size, hdr->maxsize);
+
+    if (hdr->cursize + size > hdr->committed) {
+        /* Offsets from the reservation start are commit-aligned */
+        int     from = hdr->committed + HUNK_HEADER;
+        int     to = HUNK_ROUND(hdr->cursize + size + HUNK_HEADER);
 
+#ifdef SOF_PLATFORM_WINDOWS
+        if (!VirtualAlloc((byte *)hdr + from, to - from, MEM_COMMIT, PAGE_READWRITE))
+#else
+        if (mprotect((byte *)hdr + from, to - from, PROT_READ | PROT_WRITE) != 0)
+#endif
+            Com_Error(ERR_FATAL, "Hunk_Alloc: commit failed on %d bytes", to - from);
+
+        hdr->committed = to - HUNK_HEADER;
+    }
+
+    buf = base + hdr->cursize;
+    hdr->cursize += size;
     return buf;
 }
 
+void *Hunk_Begin(int maxsize)
+{
+    hunk_current = Hunk_Reserve(maxsize);
+    return (byte *)hunk_current + HUNK_HEADER;
+}
+
+void *Hunk_Alloc(int size)
+{
+    if (!hunk_current)
+        Com_Error(ERR_FATAL, "Hunk_Alloc: no Hunk_Begin");
+    return Hunk_AllocIn(hunk_current, size);
+}
+
 int Hunk_End(void)
 {
-    /* Return the total bytes used in the current hunk */
-    /* TODO: Proper implementation with virtual memory commit */
-    return 0;
+    /* Return the total bytes used in the current hunk. The tail stays
+     * reserved but uncommitted, which costs no memory. */
+    return hunk_current ? hunk_current->cursize : 0;
 }
 
 void Hunk_Free(void *base)
 {
-    if (base)
-        free(base);
+    hunkheader_t *hdr;
+
+    if (!base)
+        return;
+
+    hdr = (hunkheader_t *)((byte *)base - HUNK_HEADER);
+    if (hdr == hunk_current)
+        hunk_current = NULL;
+
+#ifdef SOF_PLATFORM_WINDOWS
+    VirtualFree(hdr, 0, MEM_RELEASE);
+#else
+    munmap(hdr, (size_t)hdr->maxsize + HUNK_HEADER);
+#endif
+}
+
+/* ==========================================================================
+   Frame Scratch — linear allocator reset once per Qcommon_Frame
+   ========================================================================== */
+
+/*
+ * Z_FrameAlloc hands out memory that lives until the next Z_FrameReset,
+ * for per-frame work lists and bitfields in the renderer, HUD and server.
+ * It is a bump pointer in its own hunk: no headers, no free, no locking.
+ * Main thread only. The memory is NOT zeroed.
+ */
+
+#define FRAME_RESERVE   (64 << 20)
+
+static hunkheader_t *frame_hunk;
+
+static struct {
+    int     allocs;             /* this frame */
+    int     last_bytes;         /* previous complete frame */
+    int     last_allocs;
+    int     peak_bytes;
+    int     peak_allocs;
+    int     frames;
+} frame_stats;
+
+void *Z_FrameAlloc(int size)
+{
+    if (size <= 0)
+        Com_Error(ERR_FATAL, "Z_FrameAlloc: size %d", size);
+
+    if (!frame_hunk)
+        frame_hunk = Hunk_Reserve(FRAME_RESERVE);
+
+    frame_stats.allocs++;
+    return Hunk_AllocIn(frame_hunk, size);
+}
+
+void Z_FrameReset(void)
+{
+    int used = frame_hunk ? frame_hunk->cursize : 0;
+
+    frame_stats.last_bytes = used;
+    frame_stats.last_allocs = frame_stats.allocs;
+    if (used > frame_stats.peak_bytes)
+        frame_stats.peak_bytes = used;
+    if (frame_stats.allocs > frame_stats.peak_allocs)
+        frame_stats.peak_allocs = frame_stats.allocs;
+    frame_stats.allocs = 0;
+    frame_stats.frames++;
+
+    if (frame_hunk)
+        frame_hunk->cursize = 0;
+}
+
+/* "mem_frame" console command */
+void Z_FrameStats_f(void)
+{
+    if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset")) {
+        frame_stats.peak_bytes = frame_stats.peak_allocs = 0;
+        return;
+    }
+
+    Com_Printf("frame scratch: %d bytes in %d allocs last frame\n",
+        frame_stats.last_bytes, frame_stats.last_allocs);
+    Com_Printf("peak: %d bytes, %d allocs (over %d frames)\n",
+        frame_stats.peak_bytes, frame_stats.peak_allocs, frame_stats.frames);
+    Com_Printf("%dK committed of %dK reserved\n",
+        frame_hunk ? (frame_hunk->committed + HUNK_HEADER) >> 10 : 0,
+        FRAME_RESERVE >> 10);
 }
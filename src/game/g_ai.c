@@ -183,23 +183,65 @@ static void AI_CalloutManDown(edict_t *self)
    AI Utility Functions
    ========================================================================== */
 
+/*
+ * Line-of-sight results, by (observer, target) entity number. A pair is
+ * traced at most once per server frame however many behaviours ask, and
+ * a pair that was out of sight waits AI_VIS_RECHECK frames before it is
+ * traced again, unless the target is the observer's enemy. Direct mapped:
+ * a collision just costs a trace.
+ */
+#define AI_VIS_SLOTS    1024    /* power of two */
+#define AI_VIS_RECHECK  2
+
+typedef struct {
+    short       observer, target;
+    int         frame;          /* level.framenum of the trace */
+    qboolean    visible;
+} aivis_t;
+
+static aivis_t  ai_vis[AI_VIS_SLOTS];
+
 /*
  * AI_Visible - Can this entity see the target?
  * Traces a line from eyes to target, returns true if unobstructed.
+ * Pairs in clusters that can't see each other are rejected first.
  */
 static qboolean AI_Visible(edict_t *self, edict_t *target)
 {
+    extern game_export_t globals;
+    int observer = (int)(self - globals.edicts);
+    int other = (int)(target - globals.edicts);
+    aivis_t *v = &ai_vis[(observer * 37 + other) & (AI_VIS_SLOTS - 1)];
     vec3_t start, end;
     trace_t tr;
 
+    /* A frame later than now is left over from a previous game */
+    if (v->observer == observer && v->target == other && v->frame <= level.framenum) {
+        if (v->frame == level.framenum)
+            return v->visible;
+        if (!v->visible && target != self->enemy &&
+            level.framenum - v->frame < AI_VIS_RECHECK)
+            return qfalse;
+    }
+
     VectorCopy(self->s.origin, start);
     start[2] += 20;    /* approximate eye height */
 
     VectorCopy(target->s.origin, end);
     end[2] += 20;
 
+    v->observer = (short)observer;
+    v->target = (short)other;
+    v->frame = level.framenum;
+
+    if (!gi.inPVS(start, end)) {
+        v->visible = qfalse;
+        return qfalse;
+    }
+
     tr = gi.trace(start, NULL, NULL, end, self, MASK_OPAQUE);
-    return (tr.fraction == 1.0f || tr.ent == target);
+    v->visible = (tr.fraction == 1.0f || tr.ent == target);
+    return v->visible;
 }
 
 /*
@@ -246,11 +288,35 @@ static void AI_FaceEnemy(edict_t *self)
 }
 
 /*
- * AI_MoveToward - Walk toward a target position
+ * Paths being followed, by entity number. A monster asks the navigation
+ * graph for a new one when its goal has drifted off the end of the old
+ * one, when it has walked all of it, or every AI_PATH_STALE frames; a
+ * failed request isn't retried until one of those happens.
+ */
+#define AI_PATH_POINTS  16
+#define AI_PATH_DIRECT  96.0f   /* closer than this, walk straight at it */
+#define AI_PATH_REPATH  64.0f   /* goal drift that invalidates a path */
+#define AI_PATH_REACHED 24.0f
+#define AI_PATH_STALE   20
+
+typedef struct {
+    vec3_t      goal;
+    vec3_t      points[AI_PATH_POINTS];
+    int         count, next;
+    int         frame;          /* level.framenum of the request */
+} aipath_t;
+
+static aipath_t ai_paths[MAX_EDICTS];
+
+/*
+ * AI_MoveToward - Walk toward a target position, along the navigation
+ * graph when it is far enough away that walls may be in the way
  */
 static void AI_MoveToward(edict_t *self, vec3_t target, float speed)
 {
-    vec3_t dir;
+    extern game_export_t globals;
+    aipath_t *path = &ai_paths[self - globals.edicts];
+    vec3_t dir, drift;
     float dist;
 
     VectorSubtract(target, self->s.origin, dir);
@@ -260,6 +326,36 @@ static void AI_MoveToward(edict_t *self, vec3_t target, float speed)
     if (dist < 1.0f)
         return;
 
+    if (dist > AI_PATH_DIRECT) {
+        VectorSubtract(target, path->goal, drift);
+        if (path->frame > level.framenum || level.framenum - path->frame >= AI_PATH_STALE ||
+            VectorLength(drift) > AI_PATH_REPATH ||
+            (path->count && path->next >= path->count)) {
+            path->count = gi.nav_path(self->s.origin, target, path->points, AI_PATH_POINTS);
+            path->next = 0;
+            path->frame = level.framenum;
+            VectorCopy(target, path->goal);
+        }
+
+        /* Pass waypoints already reached */
+        while (path->next < path->count) {
+            vec3_t to;
+            VectorSubtract(path->points[path->next], self->s.origin, to);
+            to[2] = 0;
+            if (VectorLength(to) > AI_PATH_REACHED)
+                break;
+            path->next++;
+        }
+
+        if (path->next < path->count) {
+            VectorSubtract(path->points[path->next], self->s.origin, dir);
+            dir[2] = 0;
+            dist = VectorLength(dir);
+            if (dist < 1.0f)
+                return;
+        }
+    }
+
     VectorScale(dir, 1.0f / dist, dir);
     self->velocity[0] = dir[0] * speed;
     self->velocity[1] = dir[1] * speed;
@@ -519,92 +615,75 @@ static void AI_Dodge(edict_t *self)
 
 /*
  * AI_SeekCover - Try to move behind nearby geometry to break LOS
- * Tests 8 compass directions, picks one that blocks LOS to enemy.
+ * Prefers the map's cover points, from the navigation cover index.
+ * Otherwise tests 8 compass directions, picks one that blocks LOS to
+ * enemy: first whether we can walk there, then whether the enemy could
+ * still see us there, each as one batch of traces.
  */
+#define AI_COVER_BATCH  32
+
 static qboolean AI_SeekCover(edict_t *self)
 {
-    int i;
-    vec3_t test_pos, enemy_eye;
+    int i, n;
+    vec3_t enemy_eye;
     float best_dist = 999999.0f;
     vec3_t best_pos;
     qboolean found = qfalse;
+    tracequery_t move[AI_COVER_BATCH], vis[AI_COVER_BATCH];
 
     if (!self->enemy) return qfalse;
 
     VectorCopy(self->enemy->s.origin, enemy_eye);
     enemy_eye[2] += 20;
 
-    /* First pass: check placed cover_point entities */
-    {
-        extern game_export_t globals;
-        for (i = 1; i < globals.num_edicts; i++) {
-            edict_t *cp = &globals.edicts[i];
-            vec3_t diff;
-            float dist;
-            trace_t tr_move, tr_vis;
-
-            if (!cp->inuse || !cp->classname ||
-                Q_stricmp(cp->classname, "cover_point") != 0)
-                continue;
+    memset(move, 0, sizeof(move));
+    memset(vis, 0, sizeof(vis));
 
-            VectorSubtract(cp->s.origin, self->s.origin, diff);
-            dist = VectorLength(diff);
-            if (dist > 512.0f || dist < 32.0f) continue;
-
-            /* Can we walk there? */
-            tr_move = gi.trace(self->s.origin, self->mins, self->maxs,
-                               cp->s.origin, self, MASK_MONSTERSOLID);
-            if (tr_move.fraction < 0.8f) continue;
-
-            /* Would we be hidden from enemy there? */
-            tr_vis = gi.trace(cp->s.origin, NULL, NULL, enemy_eye,
-                              self, MASK_OPAQUE);
-            if (tr_vis.fraction >= 1.0f) continue;
-
-            if (dist < best_dist) {
-                best_dist = dist;
-                VectorCopy(cp->s.origin, best_pos);
-                found = qtrue;
-            }
-        }
-        if (found) {
-            VectorCopy(best_pos, self->move_origin);
-            return qtrue;
-        }
+    /* First choice: the nearest placed cover point hidden from the enemy */
+    if (gi.nav_cover(self->s.origin, enemy_eye, 32.0f, 512.0f, best_pos)) {
+        VectorCopy(best_pos, self->move_origin);
+        return qtrue;
     }
 
     /* Fallback: test 8 compass directions */
     best_dist = 999999.0f;
     for (i = 0; i < 8; i++) {
-        trace_t tr_move, tr_vis;
         float angle = (float)i * 45.0f * 3.14159265f / 180.0f;
-        float dx = cosf(angle) * 128.0f;
-        float dy = sinf(angle) * 128.0f;
-        float dist;
-        vec3_t diff;
 
-        VectorCopy(self->s.origin, test_pos);
-        test_pos[0] += dx;
-        test_pos[1] += dy;
+        VectorCopy(self->s.origin, move[i].start);
+        VectorCopy(self->s.origin, move[i].end);
+        move[i].end[0] += cosf(angle) * 128.0f;
+        move[i].end[1] += sinf(angle) * 128.0f;
+        VectorCopy(self->mins, move[i].mins);
+        VectorCopy(self->maxs, move[i].maxs);
+    }
+
+    /* Can we walk there? */
+    gi.trace_batch(move, 8, self, MASK_MONSTERSOLID);
 
-        /* Can we walk there? */
-        tr_move = gi.trace(self->s.origin, self->mins, self->maxs,
-                           test_pos, self, MASK_MONSTERSOLID);
-        if (tr_move.fraction < 0.8f)
+    /* Would we be hidden from enemy there? */
+    for (i = n = 0; i < 8; i++) {
+        if (move[i].trace.fraction < 0.8f)
             continue;
+        VectorCopy(move[i].trace.endpos, vis[n].start);
+        VectorCopy(enemy_eye, vis[n].end);
+        n++;
+    }
+    gi.trace_batch(vis, n, self, MASK_OPAQUE);
+
+    for (i = 0; i < n; i++) {
+        float dist;
+        vec3_t diff;
 
-        /* Would we be hidden from enemy there? */
-        tr_vis = gi.trace(tr_move.endpos, NULL, NULL, enemy_eye,
-                          self, MASK_OPAQUE);
-        if (tr_vis.fraction >= 1.0f)
+        if (vis[i].trace.fraction >= 1.0f)
             continue;  /* still visible, not cover */
 
         /* Pick the closest cover spot */
-        VectorSubtract(tr_move.endpos, self->s.origin, diff);
+        VectorSubtract(vis[i].start, self->s.origin, diff);
         dist = VectorLength(diff);
         if (dist < best_dist) {
             best_dist = dist;
-            VectorCopy(tr_move.endpos, best_pos);
+            VectorCopy(vis[i].start, best_pos);
             found = qtrue;
         }
     }
@@ -622,34 +701,30 @@ static qboolean AI_SeekCover(edict_t *self)
  */
 static qboolean AI_AvoidGrenade(edict_t *self)
 {
-    extern game_export_t globals;
+    static const char *grenades[] = { "ai_grenade", "grenade", "smoke_grenade" };
     int i;
 
-    for (i = 1; i < globals.num_edicts; i++) {
-        edict_t *e = &globals.edicts[i];
-        vec3_t diff, away;
-        float dist;
+    for (i = 0; i < (int)(sizeof(grenades) / sizeof(grenades[0])); i++) {
+        edict_t *e;
 
-        if (!e->inuse || !e->classname)
-            continue;
-        if (Q_stricmp(e->classname, "ai_grenade") != 0 &&
-            Q_stricmp(e->classname, "grenade") != 0 &&
-            Q_stricmp(e->classname, "smoke_grenade") != 0)
-            continue;
+        for (e = NULL; (e = G_FindClassname(e, grenades[i])) != NULL; ) {
+            vec3_t diff, away;
+            float dist;
 
-        VectorSubtract(e->s.origin, self->s.origin, diff);
-        dist = VectorLength(diff);
-        if (dist > 256.0f || dist < 1.0f)
-            continue;
+            VectorSubtract(e->s.origin, self->s.origin, diff);
+            dist = VectorLength(diff);
+            if (dist > 256.0f || dist < 1.0f)
+                continue;
 
-        /* Found a nearby grenade — run away from it */
-        VectorSubtract(self->s.origin, e->s.origin, away);
-        away[2] = 0;
-        VectorNormalize(away);
+            /* Found a nearby grenade — run away from it */
+            VectorSubtract(self->s.origin, e->s.origin, away);
+            away[2] = 0;
+            VectorNormalize(away);
 
-        self->velocity[0] = away[0] * AI_CHASE_SPEED * 1.5f;
-        self->velocity[1] = away[1] * AI_CHASE_SPEED * 1.5f;
-        return qtrue;
+            self->velocity[0] = away[0] * AI_CHASE_SPEED * 1.5f;
+            self->velocity[1] = away[1] * AI_CHASE_SPEED * 1.5f;
+            return qtrue;
+        }
     }
     return qfalse;
 }
@@ -772,15 +847,8 @@ static qboolean AI_TryRetreat(edict_t *self)
 /* Helper: find entity by targetname (same as g_spawn.c version) */
 static edict_t *AI_FindByTargetname(const char *targetname)
 {
-    extern game_export_t globals;
-    int i;
     if (!targetname || !targetname[0]) return NULL;
-    for (i = 0; i < globals.max_edicts; i++) {
-        edict_t *e = &globals.edicts[i];
-        if (e->inuse && e->targetname && Q_stricmp(e->targetname, targetname) == 0)
-            return e;
-    }
-    return NULL;
+    return G_FindTargetname(NULL, targetname);
 }
 
 static void ai_think_idle(edict_t *self)
@@ -1009,18 +1077,13 @@ static void ai_think_chase(edict_t *self)
         !(self->ai_flags & AI_STAND_GROUND)) {
         /* Try to find a fallback_point first, then cover, then back away */
         {
-            extern game_export_t globals;
-            int fi;
+            edict_t *fp;
             float best_fb = 999999.0f;
             vec3_t fb_pos;
             qboolean fb_found = qfalse;
-            for (fi = 1; fi < globals.num_edicts; fi++) {
-                edict_t *fp = &globals.edicts[fi];
+            for (fp = NULL; (fp = G_FindClassname(fp, "fallback_point")) != NULL; ) {
                 vec3_t fd;
                 float fdist;
-                if (!fp->inuse || !fp->classname ||
-                    Q_stricmp(fp->classname, "fallback_point") != 0)
-                    continue;
                 VectorSubtract(fp->s.origin, self->s.origin, fd);
                 fdist = VectorLength(fd);
                 if (fdist < 64.0f || fdist > 800.0f) continue;
@@ -1950,15 +2013,164 @@ static void ai_think_pain(edict_t *self)
     self->nextthink = level.time + FRAMETIME;
 }
 
+/* ==========================================================================
+   AI Scheduler
+   Monsters that are fighting, or close and in the player's PVS, think
+   whenever they ask to. The rest are idle: they think less often the
+   further out of view they are, and share what is left of the
+   sv_ai_budget_ms allowance once the priority thinks have run. Idle
+   thinks are queued during the entity pass and served afterwards from a
+   rotating cursor, so under load every queued monster gets a turn before
+   any gets a second one. sv_ai_budget_ms 0 runs everything in place.
+   ========================================================================== */
+
+#define AI_LOD_NEAR     1024.0f     /* in PVS and closer than this: priority */
+#define AI_LOD_FAR      2048.0f
+#define AI_LOD_HIDDEN   1.0f        /* idle think interval out of PVS */
+#define AI_LOD_REMOTE   2.0f        /* ... and beyond AI_LOD_FAR */
+
+static byte     ai_queued[MAX_EDICTS];
+static int      ai_cursor;
+static uint64_t ai_spent;           /* Sys_PerfCounter ticks this frame */
+static uint64_t ai_allowance;       /* 0 = unlimited */
+static qboolean ai_deferred_pass;
+
+/*
+ * AI_ThinkInterval - 0 for a priority monster, otherwise the shortest
+ * interval its idle think may run at.
+ */
+static float AI_ThinkInterval(edict_t *self)
+{
+    extern game_export_t globals;
+    edict_t *player = &globals.edicts[1];
+    vec3_t eye, diff;
+    float dist;
+
+    if (self->enemy || self->count != AI_STATE_IDLE)
+        return 0;
+    if (!player->inuse || !player->client)
+        return AI_LOD_HIDDEN;
+
+    VectorSubtract(self->s.origin, player->s.origin, diff);
+    dist = VectorLength(diff);
+
+    VectorCopy(player->s.origin, eye);
+    eye[2] += player->client->viewheight;
+    if (gi.inPVS(eye, self->s.origin)) {
+        if (dist < AI_LOD_NEAR)
+            return 0;
+        return FRAMETIME;
+    }
+
+    /* Patrols keep their pace so they don't overshoot path corners */
+    if (self->patrol_target)
+        return FRAMETIME;
+    return dist > AI_LOD_FAR ? AI_LOD_REMOTE : AI_LOD_HIDDEN;
+}
+
+/*
+ * AI_BeginFrame - Reset the frame's AI allowance. Called from RunFrame
+ * before the entity pass.
+ */
+void AI_BeginFrame(void)
+{
+    extern cvar_t *sv_ai_budget_ms;
+    float ms = sv_ai_budget_ms ? sv_ai_budget_ms->value : 0;
+
+    if (level.framenum <= 1) {
+        memset(ai_queued, 0, sizeof(ai_queued));
+        ai_cursor = 0;
+    }
+
+    ai_spent = 0;
+    ai_allowance = ms > 0 ? (uint64_t)((double)ms * (double)Sys_PerfFrequency() / 1000.0) : 0;
+    if (ms > 0 && !ai_allowance)
+        ai_allowance = 1;
+}
+
+/*
+ * AI_RunDeferred - Serve queued idle thinks, starting where the last
+ * frame stopped, until the allowance is spent. At least one is served
+ * every frame so the queue always drains.
+ */
+void AI_RunDeferred(void)
+{
+    extern game_export_t globals;
+    extern void SV_GameYield(void);
+    int n, i, num = globals.num_edicts, served = 0;
+
+    if (num <= 0)
+        return;
+
+    Prof_Begin("AI_RunDeferred");
+    ai_deferred_pass = qtrue;
+
+    i = ai_cursor % num;
+    for (n = 0; n < num; n++, i = (i + 1) % num) {
+        edict_t *ent;
+
+        if (!ai_queued[i])
+            continue;
+        if (served && ai_spent >= ai_allowance)
+            break;
+
+        ai_queued[i] = 0;
+        ent = &globals.edicts[i];
+
+        /* Freed, replaced or rescheduled since it was queued */
+        if (!ent->inuse || ent->think != monster_think ||
+            ent->nextthink > level.time + FRAMETIME)
+            continue;
+
+        SV_GameYield();
+        monster_think(ent);
+        served++;
+    }
+    ai_cursor = i;
+
+    ai_deferred_pass = qfalse;
+    Prof_End();
+}
+
 /* ==========================================================================
    Monster Think Dispatcher
    ========================================================================== */
 
+static void AI_RunThink(edict_t *self);
+
 void monster_think(edict_t *self)
 {
+    extern game_export_t globals;
+    float interval;
+    uint64_t start;
+
     if (!self->inuse || self->health <= 0)
         return;
 
+    interval = AI_ThinkInterval(self);
+
+    /* Idle: the deferred pass shares out what the budget has left */
+    if (interval > 0 && ai_allowance && !ai_deferred_pass) {
+        ai_queued[self - globals.edicts] = 1;
+        self->nextthink = level.time + FRAMETIME;
+        return;
+    }
+
+    start = Sys_PerfCounter();
+    AI_RunThink(self);
+    ai_spent += Sys_PerfCounter() - start;
+
+    /* Think LOD: idle monsters out of view come back less often */
+    if (interval > FRAMETIME && self->inuse && self->health > 0 &&
+        !self->enemy && self->count == AI_STATE_IDLE &&
+        self->nextthink > 0 && self->nextthink < level.time + interval)
+        self->nextthink = level.time + interval;
+}
+
+static void AI_RunThink(edict_t *self)
+{
+    Prof_Begin("monster_think");
+
     /* Blood trail — wounded monsters drip blood periodically */
     if (self->max_health > 0 && self->health < self->max_health / 2) {
         /* Random chance each think frame */
@@ -1974,6 +2186,7 @@ void monster_think(edict_t *self)
     /* Grenade avoidance — always check regardless of state */
     if (AI_AvoidGrenade(self)) {
         self->nextthink = level.time + FRAMETIME;
+        Prof_End();
         return;
     }
 
@@ -2006,6 +2219,8 @@ void monster_think(edict_t *self)
     case AI_STATE_SEARCH:   ai_think_search(self); break;
     default:                self->nextthink = level.time + 1.0f; break;
     }
+
+    Prof_End();
 }
 
 /* ==========================================================================
@@ -2966,8 +3181,9 @@ static void AI_LeapfrogAdvance(edict_t *self)
 
 static void AI_TryBreach(edict_t *self)
 {
+    static const char *doors[] = { "func_door", "func_door_secret" };
     extern game_export_t globals;
-    int i;
+    int i, d;
     edict_t *target_door = NULL;
     float best_door_dist = AI_BREACH_STACK_DIST;
 
@@ -2982,33 +3198,31 @@ static void AI_TryBreach(edict_t *self)
     if (!self->enemy)
         return;
 
-    for (i = 1; i < globals.num_edicts; i++) {
-        edict_t *door = &globals.edicts[i];
-        vec3_t diff;
-        float dist;
+    for (d = 0; d < (int)(sizeof(doors) / sizeof(doors[0])); d++) {
+        edict_t *door;
 
-        if (!door->inuse || !door->classname)
-            continue;
-        if (Q_stricmp(door->classname, "func_door") != 0 &&
-            Q_stricmp(door->classname, "func_door_secret") != 0)
-            continue;
-        /* Only target closed doors */
-        if (door->moveinfo.state != MSTATE_BOTTOM)
-            continue;
+        for (door = NULL; (door = G_FindClassname(door, doors[d])) != NULL; ) {
+            vec3_t diff;
+            float dist;
 
-        VectorSubtract(door->s.origin, self->s.origin, diff);
-        dist = VectorLength(diff);
-        if (dist < best_door_dist) {
-            /* Door must be between us and enemy */
-            vec3_t to_enemy;
-            float dot;
-            VectorSubtract(self->enemy->s.origin, self->s.origin, to_enemy);
-            VectorNormalize(to_enemy);
-            VectorNormalize(diff);
-            dot = DotProduct(to_enemy, diff);
-            if (dot > 0.3f) {
-                best_door_dist = dist;
-                target_door = door;
+            /* Only target closed doors */
+            if (door->moveinfo.state != MSTATE_BOTTOM)
+                continue;
+
+            VectorSubtract(door->s.origin, self->s.origin, diff);
+            dist = VectorLength(diff);
+            if (dist < best_door_dist) {
+                /* Door must be between us and enemy */
+                vec3_t to_enemy;
+                float dot;
+                VectorSubtract(self->enemy->s.origin, self->s.origin, to_enemy);
+                VectorNormalize(to_enemy);
+                VectorNormalize(diff);
+                dot = DotProduct(to_enemy, diff);
+                if (dot > 0.3f) {
+                    best_door_dist = dist;
+                    target_door = door;
+                }
             }
         }
     }
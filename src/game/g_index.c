@@ -0,0 +1,298 @@
+/*
+ * g_index.c - Classname and targetname entity indexes
+ *
+ * Every name an entity carries is interned once per level into a small
+ * hash table, and each interned name heads two lists of the entities
+ * using it: one for classname, one for targetname. The lists are kept
+ * in entity number order, so G_FindClassname/G_FindTargetname return
+ * matches in the same order a scan of globals.edicts would.
+ *
+ * The links live here, by entity number, so the memset in G_AllocEdict
+ * can't break them. Entries are refreshed by G_IndexEdict, which spawn,
+ * G_AllocEdict, G_FreeEdict and the RunFrame entity pass call; much of
+ * the game still sets classname or clears inuse directly, so a lookup
+ * also re-checks each entity it walks past and re-indexes any that have
+ * changed. Entities allocated since the last lookup are indexed first,
+ * which covers a classname set just after G_AllocEdict. An entity
+ * renamed into a name some other way is found once the next RunFrame
+ * pass has seen it.
+ */
+
+#include "g_local.h"
+
+extern game_export_t globals;
+
+/* ==========================================================================
+   Names
+   ========================================================================== */
+
+#define G_MAX_NAMES     1024
+#define G_NAME_HASH     2048    /* power of two, at least twice G_MAX_NAMES */
+#define G_NAME_LEN      64
+
+#define G_INDEX_CLASS   0
+#define G_INDEX_TARGET  1
+#define G_INDEX_KINDS   2
+
+typedef struct {
+    char        name[G_NAME_LEN];
+    int         head[G_INDEX_KINDS];    /* lowest entity number, -1 */
+} gname_t;
+
+typedef struct {
+    const char  *str;           /* string the entity was indexed under */
+    int         name;           /* into g_names, -1 not listed */
+    int         prev, next;     /* entity numbers, -1 */
+} gindexlink_t;
+
+static gname_t      g_names[G_MAX_NAMES];
+static int          g_numnames;
+static short        g_namehash[G_NAME_HASH];    /* g_names index + 1, 0 empty */
+static qboolean     g_nameoverflow;             /* some name didn't fit */
+
+static gindexlink_t g_links[G_INDEX_KINDS][MAX_EDICTS];
+
+static int          g_pending[MAX_EDICTS];      /* allocated since the last lookup */
+static int          g_numpending;
+static byte         g_ispending[MAX_EDICTS];
+
+static unsigned G_NameHash(const char *s)
+{
+    unsigned h = 5381;
+
+    while (*s) {
+        int c = *s++;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        h = h * 33 + (unsigned)c;
+    }
+    return h;
+}
+
+/*
+ * G_NameIndex - Interned index of a name, entering it when add is set.
+ * -1 when it isn't there, or can't be entered.
+ */
+static int G_NameIndex(const char *s, qboolean add)
+{
+    unsigned h = G_NameHash(s) & (G_NAME_HASH - 1);
+    gname_t *n;
+
+    while (g_namehash[h]) {
+        n = &g_names[g_namehash[h] - 1];
+        if (!Q_stricmp(n->name, s))
+            return g_namehash[h] - 1;
+        h = (h + 1) & (G_NAME_HASH - 1);
+    }
+
+    if (!add)
+        return -1;
+    if (g_numnames == G_MAX_NAMES || strlen(s) >= G_NAME_LEN) {
+        g_nameoverflow = qtrue;
+        return -1;
+    }
+
+    n = &g_names[g_numnames];
+    Q_strncpyz(n->name, s, sizeof(n->name));
+    n->head[G_INDEX_CLASS] = n->head[G_INDEX_TARGET] = -1;
+    g_namehash[h] = (short)++g_numnames;
+    return g_numnames - 1;
+}
+
+/* ==========================================================================
+   Lists
+   ========================================================================== */
+
+static void G_UnlinkIndex(int kind, int num)
+{
+    gindexlink_t *link = &g_links[kind][num];
+
+    if (link->name >= 0) {
+        if (link->prev >= 0)
+            g_links[kind][link->prev].next = link->next;
+        else
+            g_names[link->name].head[kind] = link->next;
+        if (link->next >= 0)
+            g_links[kind][link->next].prev = link->prev;
+    }
+    link->name = -1;
+    link->prev = link->next = -1;
+    link->str = NULL;
+}
+
+/* Insert in entity number order */
+static void G_LinkIndex(int kind, int num, int name)
+{
+    gindexlink_t *link = &g_links[kind][num];
+    int prev = -1, next = g_names[name].head[kind];
+
+    while (next >= 0 && next < num) {
+        prev = next;
+        next = g_links[kind][next].next;
+    }
+
+    link->name = name;
+    link->prev = prev;
+    link->next = next;
+    if (prev >= 0)
+        g_links[kind][prev].next = num;
+    else
+        g_names[name].head[kind] = num;
+    if (next >= 0)
+        g_links[kind][next].prev = num;
+}
+
+/*
+ * G_ClearEntityIndex - Forget every name and list. Called before a
+ * level's entities spawn.
+ */
+void G_ClearEntityIndex(void)
+{
+    int kind, i;
+
+    g_numnames = 0;
+    g_nameoverflow = qfalse;
+    memset(g_namehash, 0, sizeof(g_namehash));
+    for (kind = 0; kind < G_INDEX_KINDS; kind++) {
+        for (i = 0; i < MAX_EDICTS; i++) {
+            g_links[kind][i].str = NULL;
+            g_links[kind][i].name = -1;
+            g_links[kind][i].prev = g_links[kind][i].next = -1;
+        }
+    }
+    g_numpending = 0;
+    memset(g_ispending, 0, sizeof(g_ispending));
+}
+
+/*
+ * G_IndexEdict - Bring an entity's entries up to date with its inuse,
+ * classname and targetname. Cheap when nothing has changed.
+ */
+void G_IndexEdict(edict_t *ent)
+{
+    int num = (int)(ent - globals.edicts);
+    int kind;
+
+    if (num < 0 || num >= MAX_EDICTS)
+        return;
+
+    for (kind = 0; kind < G_INDEX_KINDS; kind++) {
+        gindexlink_t *link = &g_links[kind][num];
+        const char *str = NULL;
+        int name;
+
+        if (ent->inuse)
+            str = kind == G_INDEX_CLASS ? ent->classname : ent->targetname;
+        if (str && !str[0])
+            str = NULL;
+        if (str == link->str)
+            continue;
+
+        G_UnlinkIndex(kind, num);
+        link->str = str;
+        if (!str)
+            continue;
+        name = G_NameIndex(str, qtrue);
+        if (name >= 0)
+            G_LinkIndex(kind, num, name);
+    }
+}
+
+/*
+ * G_PendingEdict - Index a newly allocated entity at the next lookup,
+ * by when its spawner will have named it
+ */
+void G_PendingEdict(edict_t *ent)
+{
+    int num = (int)(ent - globals.edicts);
+
+    G_IndexEdict(ent);
+    if (num < 0 || num >= MAX_EDICTS || g_ispending[num])
+        return;
+    g_ispending[num] = 1;
+    g_pending[g_numpending++] = num;
+}
+
+static void G_FlushPending(void)
+{
+    int i;
+
+    for (i = 0; i < g_numpending; i++) {
+        g_ispending[g_pending[i]] = 0;
+        G_IndexEdict(&globals.edicts[g_pending[i]]);
+    }
+    g_numpending = 0;
+}
+
+/* ==========================================================================
+   Lookups
+   ========================================================================== */
+
+static edict_t *G_FindIndexed(int kind, edict_t *from, const char *match)
+{
+    int name, num, next, start = from ? (int)(from - globals.edicts) : -1;
+
+    if (!match || !match[0])
+        return NULL;
+
+    G_FlushPending();
+
+    name = G_NameIndex(match, qfalse);
+    if (name < 0) {
+        int i;
+
+        if (!g_nameoverflow)
+            return NULL;    /* nothing carries it */
+
+        /* It may be one of the names that didn't fit */
+        for (i = start + 1; i < globals.num_edicts; i++) {
+            edict_t *e = &globals.edicts[i];
+            const char *str = kind == G_INDEX_CLASS ? e->classname : e->targetname;
+            if (e->inuse && str && !Q_stricmp(str, match))
+                return e;
+        }
+        return NULL;
+    }
+
+    /* Continue from the last match, or from the first entity after it
+       if it has since left the list */
+    if (start >= 0 && start < MAX_EDICTS && g_links[kind][start].name == name) {
+        num = g_links[kind][start].next;
+    } else {
+        num = g_names[name].head[kind];
+        while (num >= 0 && num <= start)
+            num = g_links[kind][num].next;
+    }
+
+    for (; num >= 0; num = next) {
+        edict_t *e = &globals.edicts[num];
+        const char *str = kind == G_INDEX_CLASS ? e->classname : e->targetname;
+
+        next = g_links[kind][num].next;
+        if (e->inuse && str && !Q_stricmp(str, match))
+            return e;
+
+        /* Freed or renamed behind our back */
+        G_IndexEdict(e);
+    }
+    return NULL;
+}
+
+/*
+ * G_FindClassname - Next entity after from (NULL for the first) whose
+ * classname matches, case-insensitively:
+ *
+ *     for (e = NULL; (e = G_FindClassname(e, "path_corner")) != NULL; )
+ */
+edict_t *G_FindClassname(edict_t *from, const char *classname)
+{
+    return G_FindIndexed(G_INDEX_CLASS, from, classname);
+}
+
+/*
+ * G_FindTargetname - Next entity after from whose targetname matches
+ */
+edict_t *G_FindTargetname(edict_t *from, const char *targetname)
+{
+    return G_FindIndexed(G_INDEX_TARGET, from, targetname);
+}
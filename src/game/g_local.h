@@ -201,6 +201,22 @@ typedef struct {
     /* Random number generation (SoF exports, highest xref counts) */
     float   (*flrand)(float min, float max);
     int     (*irand)(int min, int max);
+
+    /* --- Recompilation extensions (not in the original table) --- */
+
+    /* gi.trace for each query at once; the traces run in parallel */
+    void    (*trace_batch)(tracequery_t *queries, int count,
+                           edict_t *passent, int contentmask);
+
+    /* Waypoints from start towards end over the map's navigation graph,
+       the last being end itself when the whole path fits in max.
+       Returns the count, 0 when there is no way there */
+    int     (*nav_path)(vec3_t start, vec3_t end, vec3_t *points, int max);
+    /* Nearest registered cover point within mindist..maxdist of origin
+       that threat can't see */
+    qboolean (*nav_cover)(vec3_t origin, vec3_t threat, float mindist,
+                          float maxdist, vec3_t out);
+    void    (*nav_addcover)(vec3_t origin);
 } game_import_t;
 
 /* ==========================================================================
@@ -632,15 +648,24 @@ struct edict_s {
 
     /* --- Game-private fields below --- */
 
-    /* Movement */
+    /* Hot: read for every entity by the RunFrame pass and G_RunEntity.
+       Kept together straight after the shared fields so a pass over
+       mostly idle entities touches as few cache lines as it can; the
+       strings, callbacks and spawn keys the pass never reads follow. */
     int             movetype;
     int             flags;
+    float           nextthink;
+    void            (*prethink)(edict_t *self);
+    void            (*think)(edict_t *self);
+    char            *classname;
     vec3_t          velocity;
     vec3_t          avelocity;
+    float           gravity;
+    edict_t         *groundentity;
+    int             groundentity_linkcount;
 
     /* Physics */
     float           mass;
-    float           gravity;
 
     /* Combat */
     int             health;
@@ -652,17 +677,13 @@ struct edict_s {
     float           dmg_debounce_time;
 
     /* Targeting / triggering */
-    char            *classname;
     char            *model;
     char            *target;
     char            *targetname;
     char            *killtarget;
     char            *message;
 
-    /* Think function */
-    float           nextthink;
-    void            (*prethink)(edict_t *self);
-    void            (*think)(edict_t *self);
+    /* Callbacks */
     void            (*blocked)(edict_t *self, edict_t *other);
     void            (*touch)(edict_t *self, edict_t *other,
                              void *plane, csurface_t *surf);
@@ -693,8 +714,6 @@ struct edict_s {
     edict_t         *enemy;
     edict_t         *oldenemy;
     edict_t         *activator;
-    edict_t         *groundentity;
-    int             groundentity_linkcount;
     edict_t         *teamchain;
     edict_t         *teammaster;
 
@@ -783,14 +802,51 @@ extern game_import_t gi;
 void G_SpawnEntities(const char *mapname, const char *entstring,
                      const char *spawnpoint);
 edict_t *G_AllocEdict(void);
+void G_ClearEdictPool(void);
+void G_EdictFreed(edict_t *ent);
+int G_EdictGeneration(edict_t *ent);
+void G_EdictFrameEnd(int live);
+void G_EdictStats_f(void);
+
+/* Entity indexes (g_index.c) */
+void G_ClearEntityIndex(void);
+void G_IndexEdict(edict_t *ent);
+void G_PendingEdict(edict_t *ent);
+edict_t *G_FindClassname(edict_t *from, const char *classname);
+edict_t *G_FindTargetname(edict_t *from, const char *targetname);
 
 /* Entity physics (g_phys.c) */
 void G_RunEntity(edict_t *ent);
 
+/* AI scheduler (g_ai.c) */
+void AI_BeginFrame(void);
+void AI_RunDeferred(void);
+
+/* Save games (g_save.c). Saves are taken at the end of the frame they
+   were asked for in and written in the background. */
+typedef struct {
+    byte    *data;
+    int     size;
+    int     maxsize;
+} savebuf_t;
+
+void WriteGame(const char *filename, qboolean autosave);
+void ReadGame(const char *filename);
+void WriteLevel(const char *filename);
+void ReadLevel(const char *filename);
+void G_SaveWrite(savebuf_t *b, const void *data, int len);
+void G_SaveFrameBegin(void);
+void G_SaveFrameEnd(void);
+void G_SaveMapChanged(const char *mapname);
+void G_SaveShutdown(void);
+
 /* Script system (g_script.c) */
 void G_ScriptInit(void);
 void G_ScriptShutdown(void);
 void G_ScriptLoad(const char *scriptname, edict_t *owner);
 void G_ScriptRunFrame(float level_time);
+void G_ScriptSignal(edict_t *ent);
+void G_ScriptWriteState(savebuf_t *b);
+qboolean G_ScriptReadState(const byte *data, int len);
 
 #endif /* G_LOCAL_H */
@@ -36,6 +36,9 @@ extern void R_AddSprite(vec3_t origin, float size, float r, float g, float b,
                          float alpha, float lifetime, float rotation_speed);
 extern void R_AddTracer(vec3_t start, vec3_t end, float r, float g, float b);
 
+/* Lets the main thread in mid-tick when the game runs on sv_simthread */
+extern void SV_GameYield(void);
+
 /* Sound constants now in g_local.h */
 
 /* Forward declarations */
@@ -43,10 +46,6 @@ static void G_AngleVectors(vec3_t angles, vec3_t fwd, vec3_t rt, vec3_t up_out);
 static void G_FireProjectile(edict_t *ent, qboolean is_grenade);
 static void T_RadiusDamage(edict_t *inflictor, edict_t *attacker,
                             float damage, float radius);
-void WriteGame(const char *filename, qboolean autosave);
-static void ReadGame(const char *filename);
-void WriteLevel(const char *filename);
-static void ReadLevel(const char *filename);
 static void G_UpdateDecals(void);
 static void grapple_hook_think(edict_t *self);
 static void G_AddDecal(vec3_t origin, vec3_t normal, int type);
@@ -67,8 +66,8 @@ game_import_t   gi;         /* engine functions available to game */
 game_export_t   globals;    /* game functions provided to engine */
 
 static edict_t  *g_edicts;
-static gclient_t *g_clients;    /* one per maxclients */
-static int      game_maxclients;
+gclient_t       *g_clients;    /* one per maxclients */
+int             game_maxclients;
 static qboolean cheats_enabled;
 
 level_t level;
@@ -101,10 +100,10 @@ static cvar_t   *sv_gravity_x;
 static cvar_t   *sv_gravity_y;
 static cvar_t   *sv_gravity_z;
 
-static cvar_t   *maxclients;
+cvar_t   *maxclients;   /* non-static: g_spawn.c reads these per spawn */
 static cvar_t   *maxspectators;
 static cvar_t   *maxentities;
-static cvar_t   *deathmatch;
+cvar_t   *deathmatch;
 static cvar_t   *coop;
 cvar_t   *skill;  /* non-static: accessed by g_ai.c for difficulty scaling */
 static cvar_t   *fraglimit;
@@ -121,6 +120,8 @@ static cvar_t   *ai_goretest;
 static cvar_t   *ai_pathtest;
 static cvar_t   *ai_dumb;
 static cvar_t   *ai_maxcorpses;
+cvar_t   *sv_ai_budget_ms;  /* non-static: g_ai.c scheduler */
+cvar_t   *sv_script_ops;    /* non-static: g_script.c scheduler */
 
 /* GHOUL cvars (registered by game, not engine) */
 static cvar_t   *ghl_specular;
@@ -282,6 +283,8 @@ static void InitGame(void)
     ai_pathtest = gi.cvar("ai_pathtest", "0", 0);
     ai_dumb = gi.cvar("ai_dumb", "0", 0);
     ai_maxcorpses = gi.cvar("ai_maxcorpses", "8", 0);
+    sv_ai_budget_ms = gi.cvar("sv_ai_budget_ms", "4", 0);
+    sv_script_ops = gi.cvar("sv_script_ops", "10000", 0);
 
     /* GHOUL engine cvars (game-side registration) */
     ghl_specular = gi.cvar("ghl_specular", "1", CVAR_ARCHIVE);
@@ -330,6 +333,9 @@ static void InitGame(void)
     g_edicts[0].s.number = 0;
     g_edicts[0].classname = "worldspawn";
 
+    G_ClearEntityIndex();
+    G_ClearEdictPool();
+
     level.framenum = 0;
     level.frametime = 0.1f;  /* 10 Hz server tick */
 
@@ -349,6 +355,7 @@ static void InitGame(void)
 static void ShutdownGame(void)
 {
     gi.dprintf("==== ShutdownGame ====\n");
+    G_SaveShutdown();
     G_ScriptShutdown();
     gi.FreeTags(Z_TAG_GAME);
 }
@@ -401,6 +408,8 @@ static void G_FreeEdict(edict_t *ent)
     ent->inuse = qfalse;
     ent->classname = "freed";
     gi.unlinkentity(ent);
+    G_IndexEdict(ent);
+    G_EdictFreed(ent);
 }
 
 /* thrown_knife_touch — Thrown knife impact callback */
@@ -447,6 +456,8 @@ static void thrown_knife_touch(edict_t *self, edict_t *other, void *plane,
 static void SpawnEntities(const char *mapname, const char *entstring,
                           const char *spawnpoint)
 {
+    G_SaveMapChanged(mapname);
+
     /* Clear existing entities (except world + clients) */
     {
         int i;
@@ -456,6 +467,12 @@ static void SpawnEntities(const char *mapname, const char *entstring,
             }
         }
         globals.num_edicts = game_maxclients + 1;
+        G_ClearEdictPool();
+
+        /* Names are interned per level */
+        G_ClearEntityIndex();
+        for (i = 0; i <= game_maxclients; i++)
+            G_IndexEdict(&g_edicts[i]);
     }
 
     /* Parse entity string and spawn entities */
@@ -471,14 +488,14 @@ static void SpawnEntities(const char *mapname, const char *entstring,
     /* Count total monsters and secrets */
     {
         int i;
+        edict_t *e;
         for (i = 0; i < globals.num_edicts; i++) {
-            edict_t *e = &globals.edicts[i];
-            if (!e->inuse) continue;
-            if (e->svflags & SVF_MONSTER)
+            e = &globals.edicts[i];
+            if (e->inuse && (e->svflags & SVF_MONSTER))
                 level.total_monsters++;
-            if (e->classname && Q_stricmp(e->classname, "trigger_secret") == 0)
-                level.total_secrets++;
         }
+        for (e = NULL; (e = G_FindClassname(e, "trigger_secret")) != NULL; )
+            level.total_secrets++;
         gi.dprintf("Level: %d monsters, %d secrets\n",
                    level.total_monsters, level.total_secrets);
     }
@@ -491,21 +508,35 @@ static void SpawnEntities(const char *mapname, const char *entstring,
 
 static void RunFrame(void)
 {
-    int i;
+    int i, live = 0;
     edict_t *ent;
 
     level.framenum++;
     level.time = level.framenum * level.frametime;
 
+    G_SaveFrameBegin();
+
     /* Execute scripts */
     G_ScriptRunFrame(level.time);
 
-    /* Run think functions for all active entities */
-    for (i = 0; i < globals.max_edicts; i++) {
+    AI_BeginFrame();
+
+    /* Run think functions for all active entities. Nothing past
+       num_edicts has been allocated this level. */
+    for (i = 0; i < globals.num_edicts; i++) {
         ent = &g_edicts[i];
 
-        if (!ent->inuse)
+        /* Between entities, never inside one */
+        SV_GameYield();
+
+        /* Catch up with classnames set and frees done in place */
+        G_IndexEdict(ent);
+
+        if (!ent->inuse) {
+            G_EdictFreed(ent);
             continue;
+        }
+        live++;
 
         VectorCopy(ent->s.origin, ent->s.old_origin);
 
@@ -1037,6 +1068,10 @@ static void RunFrame(void)
         /* Run physics based on movetype */
         G_RunEntity(ent);
     }
+    G_EdictFrameEnd(live);
+
+    /* Idle monster thinks queued by the AI scheduler */
+    AI_RunDeferred();
 
     /* Update persistent decals */
     G_UpdateDecals();
@@ -1094,6 +1129,9 @@ static void RunFrame(void)
             level.vote_active = qfalse;
         }
     }
+
+    /* Saves asked for during the frame see all of it */
+    G_SaveFrameEnd();
 }
 
 /* ==========================================================================
@@ -3735,12 +3773,10 @@ static qboolean G_UseUtilityWeapon(edict_t *ent)
     if (weap == WEAP_C4) {
         if (ent->client->ammo[WEAP_C4] <= 0) {
             /* No C4 charges — try to detonate any placed ones */
-            int i;
+            edict_t *c4;
             qboolean detonated = qfalse;
-            for (i = 0; i < globals.max_edicts; i++) {
-                edict_t *c4 = &globals.edicts[i];
-                if (c4->inuse && c4->owner == ent &&
-                    c4->classname && Q_stricmp(c4->classname, "c4_charge") == 0) {
+            for (c4 = NULL; (c4 = G_FindClassname(c4, "c4_charge")) != NULL; ) {
+                if (c4->owner == ent) {
                     /* Detonate this C4 */
                     VectorCopy(c4->s.origin, c4->s.origin);
                     R_ParticleEffect(c4->s.origin, c4->s.angles, 2, 48);    /* fire burst */
@@ -4876,12 +4912,9 @@ static void G_FireHitscan(edict_t *ent)
     /* Turret override: mounted turret uses turret damage, zero spread */
     if (ent->movetype == MOVETYPE_NONE) {
         /* Check if player is on a turret */
-        extern game_export_t globals;
-        int ti;
-        for (ti = 1; ti < globals.num_edicts; ti++) {
-            edict_t *t = &globals.edicts[ti];
-            if (t->inuse && t->owner == ent && t->classname &&
-                Q_stricmp(t->classname, "func_turret") == 0) {
+        edict_t *t;
+        for (t = NULL; (t = G_FindClassname(t, "func_turret")) != NULL; ) {
+            if (t->owner == ent) {
                 damage = t->dmg > 0 ? t->dmg : 40;
                 break;
             }
@@ -7043,14 +7076,8 @@ static void ClientThink(edict_t *ent, usercmd_t *ucmd)
 
     /* Claymore mine arming + proximity check */
     {
-        extern game_export_t globals;
-        int i;
-        for (i = 0; i < globals.num_edicts; i++) {
-            edict_t *mine = &globals.edicts[i];
-            if (!mine->inuse || !mine->classname)
-                continue;
-            if (Q_stricmp(mine->classname, "claymore_mine") != 0)
-                continue;
+        edict_t *mine;
+        for (mine = NULL; (mine = G_FindClassname(mine, "claymore_mine")) != NULL; ) {
             if (mine->count == 0 && level.time >= mine->nextthink) {
                 mine->count = 1;  /* armed */
                 {
@@ -7871,313 +7898,6 @@ static void ClientDisconnect(edict_t *ent)
     }
 }
 
-/* ==========================================================================
-   Save/Load (stubs)
-   ========================================================================== */
-
-/* ==========================================================================
-   Save/Load System
-
-   WriteGame: Saves persistent game state (client inventory, game settings).
-   ReadGame:  Restores game state from a save file.
-   WriteLevel: Saves all entity state for current level.
-   ReadLevel:  Restores entity state for current level.
-
-   File format: Simple binary with magic + version header.
-   ========================================================================== */
-
-#define SAVE_MAGIC      0x534F4653  /* "SOFS" */
-
-/* Saved entity data — only fields that matter for restoration */
-typedef struct {
-    int         index;
-    qboolean    inuse;
-    vec3_t      origin;
-    vec3_t      angles;
-    vec3_t      velocity;
-    int         health;
-    int         max_health;
-    int         solid;
-    int         movetype;
-    int         takedamage;
-    int         deadflag;
-    int         flags;
-    int         count;          /* AI state for monsters */
-    float       nextthink;
-    int         ai_flags;
-    int         dmg;
-    int         style;
-    float       speed;
-    float       wait;
-    char        classname[64];
-    char        target[64];
-    char        targetname[64];
-} save_entity_t;
-
-/* Saved client/game state */
-#define SAVE_VERSION    4   /* bumped for entity target/dmg/speed/wait fields */
-typedef struct {
-    int         health;
-    int         max_health;
-    int         weapon;
-    vec3_t      origin;
-    vec3_t      angles;
-    float       viewheight;
-    float       game_time;
-    int         num_entities;
-    int         armor;
-    int         armor_max;
-    int         ammo[WEAP_COUNT];
-    int         ammo_max[WEAP_COUNT];
-    int         magazine[WEAP_COUNT];
-} save_game_t;
-
-void WriteGame(const char *filename, qboolean autosave)
-{
-    FILE *f;
-    save_game_t sg;
-    edict_t *player;
-    int magic = SAVE_MAGIC, version = SAVE_VERSION;
-
-    (void)autosave;
-
-    f = fopen(filename, "wb");
-    if (!f) {
-        gi.dprintf("WriteGame: can't open %s\n", filename);
-        return;
-    }
-
-    fwrite(&magic, 4, 1, f);
-    fwrite(&version, 4, 1, f);
-
-    player = &globals.edicts[1];
-    memset(&sg, 0, sizeof(sg));
-
-    if (player->inuse && player->client) {
-        sg.health = player->health;
-        sg.max_health = player->max_health;
-        sg.weapon = player->client->pers_weapon;
-        VectorCopy(player->s.origin, sg.origin);
-        VectorCopy(player->client->viewangles, sg.angles);
-        sg.viewheight = player->client->viewheight;
-        sg.armor = player->client->armor;
-        sg.armor_max = player->client->armor_max;
-        memcpy(sg.ammo, player->client->ammo, sizeof(sg.ammo));
-        memcpy(sg.ammo_max, player->client->ammo_max, sizeof(sg.ammo_max));
-        memcpy(sg.magazine, player->client->magazine, sizeof(sg.magazine));
-    }
-    sg.game_time = level.time;
-    sg.num_entities = globals.num_edicts;
-
-    fwrite(&sg, sizeof(sg), 1, f);
-    fclose(f);
-
-    gi.dprintf("Game saved: %s\n", filename);
-}
-
-static void ReadGame(const char *filename)
-{
-    FILE *f;
-    save_game_t sg;
-    edict_t *player;
-    int magic, version;
-
-    f = fopen(filename, "rb");
-    if (!f) {
-        gi.dprintf("ReadGame: can't open %s\n", filename);
-        return;
-    }
-
-    fread(&magic, 4, 1, f);
-    fread(&version, 4, 1, f);
-
-    if (magic != SAVE_MAGIC || version != SAVE_VERSION) {
-        gi.dprintf("ReadGame: bad save file %s\n", filename);
-        fclose(f);
-        return;
-    }
-
-    fread(&sg, sizeof(sg), 1, f);
-    fclose(f);
-
-    player = &globals.edicts[1];
-    if (player->inuse && player->client) {
-        player->health = sg.health;
-        player->max_health = sg.max_health;
-        player->client->pers_weapon = sg.weapon;
-        player->weapon_index = sg.weapon;
-        VectorCopy(sg.origin, player->s.origin);
-        VectorCopy(sg.angles, player->client->viewangles);
-        player->client->viewheight = sg.viewheight;
-        player->client->armor = sg.armor;
-        player->client->armor_max = sg.armor_max;
-        memcpy(player->client->ammo, sg.ammo, sizeof(sg.ammo));
-        memcpy(player->client->ammo_max, sg.ammo_max, sizeof(sg.ammo_max));
-        memcpy(player->client->magazine, sg.magazine, sizeof(sg.magazine));
-        player->deadflag = 0;
-        player->client->ps.pm_type = PM_NORMAL;
-    }
-
-    gi.dprintf("Game loaded: %s\n", filename);
-}
-
-void WriteLevel(const char *filename)
-{
-    FILE *f;
-    int magic = SAVE_MAGIC, version = SAVE_VERSION;
-    int i;
-
-    f = fopen(filename, "wb");
-    if (!f) {
-        gi.dprintf("WriteLevel: can't open %s\n", filename);
-        return;
-    }
-
-    fwrite(&magic, 4, 1, f);
-    fwrite(&version, 4, 1, f);
-    fwrite(&globals.num_edicts, 4, 1, f);
-
-    for (i = 0; i < globals.num_edicts; i++) {
-        edict_t *ent = &globals.edicts[i];
-        save_entity_t se;
-
-        memset(&se, 0, sizeof(se));
-        se.index = i;
-        se.inuse = ent->inuse;
-
-        if (ent->inuse) {
-            VectorCopy(ent->s.origin, se.origin);
-            VectorCopy(ent->s.angles, se.angles);
-            VectorCopy(ent->velocity, se.velocity);
-            se.health = ent->health;
-            se.max_health = ent->max_health;
-            se.solid = ent->solid;
-            se.movetype = ent->movetype;
-            se.takedamage = ent->takedamage;
-            se.deadflag = ent->deadflag;
-            se.flags = ent->flags;
-            se.count = ent->count;
-            se.nextthink = ent->nextthink;
-            se.ai_flags = ent->ai_flags;
-            se.dmg = ent->dmg;
-            se.style = ent->style;
-            se.speed = ent->speed;
-            se.wait = ent->wait;
-            if (ent->classname)
-                Q_strncpyz(se.classname, ent->classname, sizeof(se.classname));
-            if (ent->target)
-                Q_strncpyz(se.target, ent->target, sizeof(se.target));
-            if (ent->targetname)
-                Q_strncpyz(se.targetname, ent->targetname, sizeof(se.targetname));
-        }
-
-        fwrite(&se, sizeof(se), 1, f);
-    }
-
-    fclose(f);
-    gi.dprintf("Level saved: %s (%d entities)\n", filename, globals.num_edicts);
-}
-
-static void ReadLevel(const char *filename)
-{
-    FILE *f;
-    int magic, version, num_ents, i;
-
-    f = fopen(filename, "rb");
-    if (!f) {
-        gi.dprintf("ReadLevel: can't open %s\n", filename);
-        return;
-    }
-
-    fread(&magic, 4, 1, f);
-    fread(&version, 4, 1, f);
-
-    if (magic != SAVE_MAGIC || version != SAVE_VERSION) {
-        gi.dprintf("ReadLevel: bad save file %s\n", filename);
-        fclose(f);
-        return;
-    }
-
-    fread(&num_ents, 4, 1, f);
-
-    for (i = 0; i < num_ents && i < globals.max_edicts; i++) {
-        edict_t *ent = &globals.edicts[i];
-        save_entity_t se;
-
-        fread(&se, sizeof(se), 1, f);
-
-        /* Skip player entity — restored by ReadGame */
-        if (i == 0 || i == 1)
-            continue;
-
-        if (!se.inuse) {
-            if (ent->inuse) {
-                ent->inuse = qfalse;
-                gi.unlinkentity(ent);
-            }
-            continue;
-        }
-
-        /* Restore saved state over existing entity */
-        VectorCopy(se.origin, ent->s.origin);
-        VectorCopy(se.angles, ent->s.angles);
-        VectorCopy(se.velocity, ent->velocity);
-        ent->health = se.health;
-        ent->max_health = se.max_health;
-        ent->solid = se.solid;
-        ent->movetype = se.movetype;
-        ent->takedamage = se.takedamage;
-        ent->deadflag = se.deadflag;
-        ent->flags = se.flags;
-        ent->count = se.count;
-        ent->nextthink = se.nextthink;
-        ent->ai_flags = se.ai_flags;
-        ent->dmg = se.dmg;
-        ent->style = se.style;
-        ent->speed = se.speed;
-        ent->wait = se.wait;
-
-        /* Restore think/callback functions based on classname */
-        if (se.classname[0]) {
-            if (strncmp(se.classname, "monster_", 8) == 0) {
-                /* Monster entities: restore AI callbacks */
-                extern void monster_think(edict_t *self);
-                extern void monster_pain(edict_t *self, edict_t *other,
-                                         float kick, int damage);
-                extern void monster_die(edict_t *self, edict_t *inflictor,
-                                        edict_t *attacker, int damage,
-                                        vec3_t point);
-                ent->think = monster_think;
-                ent->pain = monster_pain;
-                ent->die = monster_die;
-                if (se.deadflag) {
-                    /* Dead monster: schedule corpse removal */
-                    ent->think = NULL;
-                    ent->takedamage = DAMAGE_NO;
-                    ent->solid = SOLID_NOT;
-                } else if (se.nextthink <= level.time) {
-                    ent->nextthink = level.time + 0.1f;
-                }
-            } else if (strcmp(se.classname, "func_door") == 0 ||
-                       strcmp(se.classname, "func_plat") == 0) {
-                /* Doors/plats keep their BSP-assigned callbacks */
-            } else if (strncmp(se.classname, "item_", 5) == 0 ||
-                       strncmp(se.classname, "weapon_", 7) == 0 ||
-                       strncmp(se.classname, "ammo_", 5) == 0) {
-                /* Pickup items: keep existing think from spawn */
-            }
-        }
-
-        /* Re-link entity with updated position */
-        if (ent->inuse)
-            gi.linkentity(ent);
-    }
-
-    globals.num_edicts = num_ents > globals.num_edicts ? num_ents : globals.num_edicts;
-    fclose(f);
-    gi.dprintf("Level loaded: %s (%d entities)\n", filename, num_ents);
-}
-
 /* ==========================================================================
    SoF-specific exports
    ========================================================================== */
@@ -8290,6 +8010,8 @@ static void ServerCommand(void)
         /* TODO: IP ban list */
     } else if (Q_stricmp(cmd, "removeip") == 0) {
         /* TODO: IP ban removal */
+    } else if (Q_stricmp(cmd, "edicts") == 0) {
+        G_EdictStats_f();
     } else {
         gi.dprintf("Unknown server command: %s\n", cmd);
     }
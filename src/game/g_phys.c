@@ -311,6 +311,8 @@ void G_RunEntity(edict_t *ent)
     if (!ent || !ent->inuse)
         return;
 
+    Prof_Begin("G_RunEntity");
+
     switch (ent->movetype) {
     case MOVETYPE_NONE:
         SV_Physics_None(ent);
@@ -343,4 +345,6 @@ void G_RunEntity(edict_t *ent)
     default:
         break;
     }
+
+    Prof_End();
 }
@@ -0,0 +1,866 @@
+/*
+ * g_save.c - Save games
+ *
+ * WriteGame saves the clients; WriteLevel saves the level locals, every
+ * edict and the running scripts. Both are snapshots of the structures
+ * themselves. The few fields that hold pointers are listed in the field
+ * tables below and written as something that survives a reload:
+ *
+ *   F_EDICT     entity number + 1, 0 for NULL
+ *   F_CLIENT    client number + 1
+ *   F_LSTRING   offset + 1 into the save's string table
+ *   F_FUNCTION  distance from GetGameAPI, 0 for NULL
+ *
+ * Everything else is plain data and is saved as it is, so a new field
+ * needs nothing here unless it is a pointer, and then one table line.
+ *
+ * A save asked for during a frame (a checkpoint trigger's autosave) is
+ * taken at the end of that frame, once every entity has had its think.
+ * Taking it is a copy into one buffer. Compressing it and writing it out
+ * happen on a background loader thread (FS_AsyncQueue), so saving doesn't
+ * hold up the frame. The file is written under a temporary name and
+ * renamed, so a crash part way leaves the previous save alone.
+ *
+ * Loading reads the file in one go and decompresses it. The records are
+ * fixed up in place in that buffer and copied over the live ones; the
+ * string table is kept as the storage for the strings it holds.
+ *
+ * Function distances only hold for the binary that wrote them. The header
+ * carries a layout stamp: the sizes of the saved structures, which must
+ * match, and the distances of a few functions in other files. If those
+ * have moved, the entities keep the callbacks the map spawned them with.
+ */
+
+#include "g_local.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+extern game_export_t globals;
+extern gclient_t *g_clients;
+extern int game_maxclients;
+extern cvar_t *maxclients;
+
+#define SAVE_MAGIC      0x534F4653  /* "SOFS" */
+#define SAVE_VERSION    5           /* field-table snapshots, compressed */
+
+#define SAVE_GAMEFILE   0           /* .sav: clients */
+#define SAVE_LEVELFILE  1           /* .sv2: level, edicts, scripts */
+
+/* Payload sections, each [int id] [int length] then the data, padded to 8 */
+enum {
+    SEC_END,
+    SEC_CLIENTS,
+    SEC_LEVEL,
+    SEC_EDICTS,
+    SEC_SCRIPTS,
+    SEC_STRINGS
+};
+
+#define SAVE_PROBES     5
+
+typedef struct {
+    int         magic;
+    int         version;
+    int         kind;
+    int         sizes[3];               /* edict_t, gclient_t, level_t */
+    int         probes[SAVE_PROBES];    /* function distances */
+    char        mapname[MAX_QPATH];
+    int         rawsize;                /* payload, uncompressed */
+    int         compsize;
+} saveheader_t;
+
+/* ==========================================================================
+   Field Tables
+   ========================================================================== */
+
+typedef enum {
+    F_EDICT,
+    F_CLIENT,
+    F_LSTRING,
+    F_FUNCTION
+} fieldtype_t;
+
+typedef struct {
+    const char  *name;
+    int         ofs;
+    fieldtype_t type;
+} field_t;
+
+#define FOFS(x)     (int)offsetof(edict_t, x)
+#define CLOFS(x)    (int)offsetof(gclient_t, x)
+
+static const field_t edict_fields[] = {
+    { "owner",          FOFS(owner),            F_EDICT },
+    { "prethink",       FOFS(prethink),         F_FUNCTION },
+    { "think",          FOFS(think),            F_FUNCTION },
+    { "classname",      FOFS(classname),        F_LSTRING },
+    { "groundentity",   FOFS(groundentity),     F_EDICT },
+    { "model",          FOFS(model),            F_LSTRING },
+    { "target",         FOFS(target),           F_LSTRING },
+    { "targetname",     FOFS(targetname),       F_LSTRING },
+    { "killtarget",     FOFS(killtarget),       F_LSTRING },
+    { "message",        FOFS(message),          F_LSTRING },
+    { "blocked",        FOFS(blocked),          F_FUNCTION },
+    { "touch",          FOFS(touch),            F_FUNCTION },
+    { "use",            FOFS(use),              F_FUNCTION },
+    { "pain",           FOFS(pain),             F_FUNCTION },
+    { "die",            FOFS(die),              F_FUNCTION },
+    { "chain",          FOFS(chain),            F_EDICT },
+    { "enemy",          FOFS(enemy),            F_EDICT },
+    { "oldenemy",       FOFS(oldenemy),         F_EDICT },
+    { "activator",      FOFS(activator),        F_EDICT },
+    { "teamchain",      FOFS(teamchain),        F_EDICT },
+    { "teammaster",     FOFS(teammaster),       F_EDICT },
+    { "client",         FOFS(client),           F_CLIENT },
+    { "weapon_model",   FOFS(weapon_model),     F_LSTRING },
+    { "endfunc",        FOFS(moveinfo.endfunc), F_FUNCTION },
+    { "patrol_target",  FOFS(patrol_target),    F_EDICT },
+    { NULL, 0, 0 }
+};
+
+static const field_t client_fields[] = {
+    { "held_object",    CLOFS(held_object),     F_EDICT },
+    { "c4_entity",      CLOFS(c4_entity),       F_EDICT },
+    { "zipline_ent",    CLOFS(zipline_ent),     F_EDICT },
+    { NULL, 0, 0 }
+};
+
+typedef void (*savefunc_t)(void);
+
+static intptr_t G_FuncDistance(savefunc_t func)
+{
+    return func ? (intptr_t)((byte *)func - (byte *)GetGameAPI) : 0;
+}
+
+static void G_SaveProbes(int *probes)
+{
+    probes[0] = (int)G_FuncDistance((savefunc_t)G_RunEntity);
+    probes[1] = (int)G_FuncDistance((savefunc_t)G_ScriptRunFrame);
+    probes[2] = (int)G_FuncDistance((savefunc_t)AI_BeginFrame);
+    probes[3] = (int)G_FuncDistance((savefunc_t)G_SpawnEntities);
+    probes[4] = (int)G_FuncDistance((savefunc_t)G_IndexEdict);
+}
+
+/* ==========================================================================
+   Save Buffers
+   ========================================================================== */
+
+void G_SaveWrite(savebuf_t *b, const void *data, int len)
+{
+    if (b->size + len > b->maxsize) {
+        int     newsize = b->maxsize ? b->maxsize : 65536;
+        byte    *newdata;
+
+        while (newsize < b->size + len)
+            newsize *= 2;
+        newdata = (byte *)Z_Malloc(newsize);
+        if (b->data) {
+            memcpy(newdata, b->data, b->size);
+            Z_Free(b->data);
+        }
+        b->data = newdata;
+        b->maxsize = newsize;
+    }
+
+    memcpy(b->data + b->size, data, len);
+    b->size += len;
+}
+
+/* The section started at start: fill in its length and pad it out */
+static int G_BeginSection(savebuf_t *b, int id)
+{
+    int hdr[2] = { id, 0 };
+    int start = b->size;
+
+    G_SaveWrite(b, hdr, sizeof(hdr));
+    return start;
+}
+
+static void G_EndSection(savebuf_t *b, int start)
+{
+    static const byte pad[8];
+    int len = b->size - start - 8;
+
+    memcpy(b->data + start + 4, &len, sizeof(len));
+    if (b->size & 7)
+        G_SaveWrite(b, pad, 8 - (b->size & 7));
+}
+
+static const byte *G_FindSection(const byte *data, int size, int id, int *len)
+{
+    int pos = 0;
+
+    while (pos + 8 <= size) {
+        int sec[2];
+
+        memcpy(sec, data + pos, sizeof(sec));
+        if (sec[0] == SEC_END || sec[1] < 0 || sec[1] > size - pos - 8)
+            break;
+        if (sec[0] == id) {
+            *len = sec[1];
+            return data + pos + 8;
+        }
+        pos += 8 + ((sec[1] + 7) & ~7);
+    }
+
+    *len = 0;
+    return NULL;
+}
+
+/* ==========================================================================
+   Field Conversion
+   ========================================================================== */
+
+/* rec is a copy of a live struct: turn its pointers into saved values */
+static void G_SaveFields(const field_t *fields, byte *rec, savebuf_t *strings)
+{
+    const field_t *f;
+
+    for (f = fields; f->name; f++) {
+        byte        *p = rec + f->ofs;
+        intptr_t    v = 0;
+
+        switch (f->type) {
+        case F_EDICT: {
+            edict_t *e;
+
+            memcpy(&e, p, sizeof(e));
+            if (e && e >= globals.edicts && e < globals.edicts + globals.max_edicts)
+                v = (e - globals.edicts) + 1;
+            break;
+        }
+        case F_CLIENT: {
+            gclient_t *cl;
+
+            memcpy(&cl, p, sizeof(cl));
+            if (cl && cl >= g_clients && cl < g_clients + game_maxclients)
+                v = (cl - g_clients) + 1;
+            break;
+        }
+        case F_LSTRING: {
+            char *s;
+
+            memcpy(&s, p, sizeof(s));
+            if (s) {
+                v = strings->size + 1;
+                G_SaveWrite(strings, s, (int)strlen(s) + 1);
+            }
+            break;
+        }
+        case F_FUNCTION: {
+            savefunc_t func;
+
+            memcpy(&func, p, sizeof(func));
+            v = G_FuncDistance(func);
+            break;
+        }
+        }
+
+        memcpy(p, &v, sizeof(v));
+    }
+}
+
+/*
+ * G_LoadFields — The other way, in place in the load buffer. When the
+ * functions can't be trusted, rec gets live's callbacks instead; live may
+ * be NULL for none.
+ */
+static void G_LoadFields(const field_t *fields, byte *rec, const byte *live,
+                         char *strings, int stringsize, qboolean funcs)
+{
+    const field_t *f;
+
+    for (f = fields; f->name; f++) {
+        byte        *p = rec + f->ofs;
+        intptr_t    v;
+        void        *ptr = NULL;
+
+        memcpy(&v, p, sizeof(v));
+
+        switch (f->type) {
+        case F_EDICT:
+            if (v > 0 && v <= globals.max_edicts)
+                ptr = &globals.edicts[v - 1];
+            break;
+        case F_CLIENT:
+            if (v > 0 && v <= game_maxclients)
+                ptr = &g_clients[v - 1];
+            break;
+        case F_LSTRING:
+            if (v > 0 && v <= stringsize)
+                ptr = strings + v - 1;
+            break;
+        case F_FUNCTION: {
+            savefunc_t func = NULL;
+
+            if (!funcs) {
+                if (live)
+                    memcpy(&func, live + f->ofs, sizeof(func));
+            } else if (v) {
+                func = (savefunc_t)((byte *)GetGameAPI + v);
+            }
+            memcpy(p, &func, sizeof(func));
+            continue;
+        }
+        }
+
+        memcpy(p, &ptr, sizeof(ptr));
+    }
+}
+
+/* ==========================================================================
+   Compression
+
+   LZ77 in the LZ4 block layout: a token byte with the literal count in
+   the high nibble and the match length - 4 in the low, 15 meaning more
+   length bytes follow (255 each until one isn't); the literals; a 16-bit
+   little-endian match offset. The last sequence is literals only. Edict
+   arrays are mostly zeros and repeats, and shrink to a fraction.
+   ========================================================================== */
+
+#define LZ_HASHBITS     14
+#define LZ_MAXOFFSET    65535
+
+static int LZ_Bound(int len)
+{
+    return len + len / 255 + 16;
+}
+
+static byte *LZ_PutLength(byte *op, int len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (byte)len;
+    return op;
+}
+
+static byte *LZ_PutSequence(byte *op, const byte *lit, int litlen, int matchlen, int offset)
+{
+    byte *token = op++;
+    int  ml = matchlen ? matchlen - 4 : 0;
+
+    *token = (byte)(((litlen >= 15 ? 15 : litlen) << 4) | (ml >= 15 ? 15 : ml));
+    if (litlen >= 15)
+        op = LZ_PutLength(op, litlen - 15);
+    memcpy(op, lit, litlen);
+    op += litlen;
+
+    if (matchlen) {
+        *op++ = (byte)(offset & 255);
+        *op++ = (byte)(offset >> 8);
+        if (ml >= 15)
+            op = LZ_PutLength(op, ml - 15);
+    }
+    return op;
+}
+
+/* out must hold LZ_Bound(len). Runs on a loader thread. */
+static int LZ_Compress(const byte *in, int len, byte *out)
+{
+    int     *table = (int *)Z_Malloc((1 << LZ_HASHBITS) * (int)sizeof(int));
+    byte    *op = out;
+    int     ip = 0, anchor = 0;
+
+    memset(table, 0xff, (1 << LZ_HASHBITS) * sizeof(int));
+
+    while (ip + 4 <= len) {
+        uint32_t    seq;
+        unsigned    h;
+        int         ref, mlen;
+
+        memcpy(&seq, in + ip, 4);
+        h = (seq * 2654435761u) >> (32 - LZ_HASHBITS);
+        ref = table[h];
+        table[h] = ip;
+
+        if (ref < 0 || ip - ref > LZ_MAXOFFSET || memcmp(in + ref, in + ip, 4)) {
+            ip++;
+            continue;
+        }
+
+        mlen = 4;
+        while (ip + mlen < len && in[ref + mlen] == in[ip + mlen])
+            mlen++;
+
+        op = LZ_PutSequence(op, in + anchor, ip - anchor, mlen, ip - ref);
+        ip += mlen;
+        anchor = ip;
+    }
+
+    op = LZ_PutSequence(op, in + anchor, len - anchor, 0, 0);
+    Z_Free(table);
+    return (int)(op - out);
+}
+
+static int LZ_GetLength(const byte **ip, const byte *end, int len)
+{
+    int c;
+
+    do {
+        if (*ip >= end)
+            return -1;
+        c = *(*ip)++;
+        len += c;
+    } while (c == 255);
+    return len;
+}
+
+/* Returns the bytes written to out, or -1 for a corrupt stream */
+static int LZ_Decompress(const byte *in, int len, byte *out, int outlen)
+{
+    const byte  *ip = in, *end = in + len;
+    int         op = 0;
+
+    while (ip < end) {
+        int token = *ip++;
+        int lit = token >> 4, mlen = token & 15, offset, i;
+
+        if (lit == 15 && (lit = LZ_GetLength(&ip, end, lit)) < 0)
+            return -1;
+        if (lit > end - ip || lit > outlen - op)
+            return -1;
+        memcpy(out + op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        if (ip == end)
+            break;      /* the last sequence */
+
+        if (end - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (!offset || offset > op)
+            return -1;
+
+        if (mlen == 15 && (mlen = LZ_GetLength(&ip, end, mlen)) < 0)
+            return -1;
+        mlen += 4;
+        if (mlen > outlen - op)
+            return -1;
+
+        /* Byte at a time: the match may overlap what it writes */
+        for (i = 0; i < mlen; i++, op++)
+            out[op] = out[op - offset];
+    }
+
+    return op;
+}
+
+/* ==========================================================================
+   Writing
+   ========================================================================== */
+
+#define MAX_QUEUED_SAVES    4
+
+static struct {
+    int     kind;
+    char    filename[MAX_OSPATH];
+} save_queue[MAX_QUEUED_SAVES];
+
+static int      save_queued;
+static qboolean save_inframe;
+static int      save_writing;           /* with a loader thread */
+static char     save_mapname[MAX_QPATH];
+static char     *save_strings;          /* the last load's string table */
+
+typedef struct {
+    char        filename[MAX_OSPATH];
+    byte        *data;                  /* header, then the payload */
+    int         size;
+    int         outsize;                /* on disk, 0 = failed */
+} savejob_t;
+
+/* Loader thread: compress and write. Plain file I/O and Z_ only. */
+static void G_SaveWork(void *ctx)
+{
+    savejob_t       *job = (savejob_t *)ctx;
+    saveheader_t    *hdr = (saveheader_t *)job->data;
+    char            tmpname[MAX_OSPATH + 4];
+    byte            *out;
+    int             rawsize = job->size - (int)sizeof(saveheader_t);
+    FILE            *f;
+
+    out = (byte *)Z_Malloc((int)sizeof(saveheader_t) + LZ_Bound(rawsize));
+    hdr->compsize = LZ_Compress(job->data + sizeof(saveheader_t), rawsize,
+                                out + sizeof(saveheader_t));
+    memcpy(out, hdr, sizeof(saveheader_t));
+
+    snprintf(tmpname, sizeof(tmpname), "%s.tmp", job->filename);
+    f = fopen(tmpname, "wb");
+    if (f) {
+        int total = (int)sizeof(saveheader_t) + hdr->compsize;
+        qboolean ok = fwrite(out, 1, total, f) == (size_t)total;
+
+        ok = !fclose(f) && ok;
+#ifdef SOF_PLATFORM_WINDOWS
+        remove(job->filename);
+#endif
+        if (ok && !rename(tmpname, job->filename))
+            job->outsize = total;
+        else
+            remove(tmpname);
+    }
+
+    Z_Free(out);
+}
+
+/* Main thread, from FS_AsyncPump */
+static void G_SaveDone(void *ctx)
+{
+    savejob_t *job = (savejob_t *)ctx;
+
+    if (job->outsize)
+        gi.dprintf("Saved %s (%d KB, %d KB on disk)\n", job->filename,
+                   job->size / 1024, job->outsize / 1024);
+    else
+        gi.dprintf("Couldn't write %s\n", job->filename);
+
+    Z_Free(job->data);
+    Z_Free(job);
+    save_writing--;
+}
+
+static void G_TakeSave(int kind, const char *filename)
+{
+    savebuf_t       b, strings;
+    saveheader_t    hdr;
+    savejob_t       *job;
+    int             sec, i;
+
+    memset(&b, 0, sizeof(b));
+    memset(&strings, 0, sizeof(strings));
+    memset(&hdr, 0, sizeof(hdr));
+    G_SaveWrite(&b, &hdr, sizeof(hdr));
+
+    if (kind == SAVE_GAMEFILE) {
+        sec = G_BeginSection(&b, SEC_CLIENTS);
+        for (i = 0; i < game_maxclients; i++) {
+            G_SaveWrite(&b, &g_clients[i], sizeof(gclient_t));
+            G_SaveFields(client_fields, b.data + b.size - sizeof(gclient_t), &strings);
+        }
+        G_EndSection(&b, sec);
+    } else {
+        sec = G_BeginSection(&b, SEC_LEVEL);
+        G_SaveWrite(&b, &level, sizeof(level));
+        G_EndSection(&b, sec);
+
+        sec = G_BeginSection(&b, SEC_EDICTS);
+        for (i = 0; i < globals.num_edicts; i++) {
+            G_SaveWrite(&b, &globals.edicts[i], sizeof(edict_t));
+            G_SaveFields(edict_fields, b.data + b.size - sizeof(edict_t), &strings);
+        }
+        G_EndSection(&b, sec);
+
+        sec = G_BeginSection(&b, SEC_SCRIPTS);
+        G_ScriptWriteState(&b);
+        G_EndSection(&b, sec);
+    }
+
+    sec = G_BeginSection(&b, SEC_STRINGS);
+    if (strings.size)
+        G_SaveWrite(&b, strings.data, strings.size);
+    G_EndSection(&b, sec);
+    if (strings.data)
+        Z_Free(strings.data);
+
+    hdr.magic = SAVE_MAGIC;
+    hdr.version = SAVE_VERSION;
+    hdr.kind = kind;
+    hdr.sizes[0] = (int)sizeof(edict_t);
+    hdr.sizes[1] = (int)sizeof(gclient_t);
+    hdr.sizes[2] = (int)sizeof(level_t);
+    G_SaveProbes(hdr.probes);
+    Q_strncpyz(hdr.mapname, save_mapname, sizeof(hdr.mapname));
+    hdr.rawsize = b.size - (int)sizeof(hdr);
+    memcpy(b.data, &hdr, sizeof(hdr));
+
+    job = (savejob_t *)Z_Malloc(sizeof(*job));
+    memset(job, 0, sizeof(*job));
+    Q_strncpyz(job->filename, filename, sizeof(job->filename));
+    job->data = b.data;
+    job->size = b.size;
+
+    /* The game lock keeps this and FS_AsyncPump off each other, whichever
+       thread the frame ran on */
+    save_writing++;
+    FS_AsyncQueue(G_SaveWork, G_SaveDone, job);
+}
+
+/* Take everything asked for so far */
+static void G_SaveFlush(void)
+{
+    int i;
+
+    for (i = 0; i < save_queued; i++)
+        G_TakeSave(save_queue[i].kind, save_queue[i].filename);
+    save_queued = 0;
+}
+
+static void G_QueueSave(int kind, const char *filename)
+{
+    if (!save_inframe) {
+        G_TakeSave(kind, filename);
+        return;
+    }
+
+    if (save_queued == MAX_QUEUED_SAVES)
+        G_SaveFlush();
+    save_queue[save_queued].kind = kind;
+    Q_strncpyz(save_queue[save_queued].filename, filename, sizeof(save_queue[0].filename));
+    save_queued++;
+}
+
+void WriteGame(const char *filename, qboolean autosave)
+{
+    (void)autosave;
+    G_QueueSave(SAVE_GAMEFILE, filename);
+}
+
+void WriteLevel(const char *filename)
+{
+    G_QueueSave(SAVE_LEVELFILE, filename);
+}
+
+/* RunFrame brackets the frame: saves asked for inside it wait for the end */
+void G_SaveFrameBegin(void)
+{
+    save_inframe = qtrue;
+}
+
+void G_SaveFrameEnd(void)
+{
+    save_inframe = qfalse;
+    if (save_queued)
+        G_SaveFlush();
+}
+
+/* Before a new map's entities replace the old */
+void G_SaveMapChanged(const char *mapname)
+{
+    G_SaveFlush();
+    Q_strncpyz(save_mapname, mapname, sizeof(save_mapname));
+}
+
+void G_SaveShutdown(void)
+{
+    save_queued = 0;
+    if (save_writing)
+        FS_AsyncWait();
+    save_strings = NULL;    /* Z_TAG_GAME goes with the game */
+}
+
+/* ==========================================================================
+   Reading
+   ========================================================================== */
+
+/* The decompressed payload of filename (Z_Free it), or NULL */
+static byte *G_LoadSave(const char *filename, int kind, saveheader_t *hdr)
+{
+    FILE    *f;
+    byte    *file, *payload;
+    long    len;
+
+    /* A save of this file may still be on its way to disk */
+    G_SaveFlush();
+    if (save_writing)
+        FS_AsyncWait();
+
+    f = fopen(filename, "rb");
+    if (!f) {
+        gi.dprintf("Can't open %s\n", filename);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (len < (long)sizeof(saveheader_t)) {
+        gi.dprintf("%s is not a save\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    file = (byte *)Z_Malloc((int)len);
+    if (fread(file, 1, (size_t)len, f) != (size_t)len) {
+        gi.dprintf("Couldn't read %s\n", filename);
+        fclose(f);
+        Z_Free(file);
+        return NULL;
+    }
+    fclose(f);
+
+    memcpy(hdr, file, sizeof(*hdr));
+    if (hdr->magic != SAVE_MAGIC || hdr->version != SAVE_VERSION || hdr->kind != kind) {
+        gi.dprintf("%s: not a version %d save\n", filename, SAVE_VERSION);
+        Z_Free(file);
+        return NULL;
+    }
+    if (hdr->sizes[0] != (int)sizeof(edict_t) || hdr->sizes[1] != (int)sizeof(gclient_t) ||
+        hdr->sizes[2] != (int)sizeof(level_t)) {
+        gi.dprintf("%s was saved by a different build\n", filename);
+        Z_Free(file);
+        return NULL;
+    }
+    if (Q_stricmp(hdr->mapname, save_mapname)) {
+        gi.dprintf("%s is a save on %s, not %s\n", filename, hdr->mapname, save_mapname);
+        Z_Free(file);
+        return NULL;
+    }
+    if (hdr->compsize < 0 || hdr->compsize > len - (long)sizeof(*hdr) || hdr->rawsize < 0) {
+        gi.dprintf("%s is truncated\n", filename);
+        Z_Free(file);
+        return NULL;
+    }
+
+    payload = (byte *)Z_Malloc(hdr->rawsize + 8);
+    if (LZ_Decompress(file + sizeof(*hdr), hdr->compsize, payload, hdr->rawsize) !=
+        hdr->rawsize) {
+        gi.dprintf("%s is corrupt\n", filename);
+        Z_Free(file);
+        Z_Free(payload);
+        return NULL;
+    }
+    Z_Free(file);
+    return payload;
+}
+
+static qboolean G_SaveFuncsValid(const saveheader_t *hdr)
+{
+    int probes[SAVE_PROBES];
+
+    G_SaveProbes(probes);
+    return !memcmp(probes, hdr->probes, sizeof(probes));
+}
+
+/* The string table, out of the load buffer into storage of its own */
+static char *G_LoadStrings(const byte *payload, int rawsize, int *size)
+{
+    const byte  *sec = G_FindSection(payload, rawsize, SEC_STRINGS, size);
+    char        *strings;
+
+    if (!sec || !*size || sec[*size - 1]) {
+        *size = 0;
+        return NULL;
+    }
+    strings = (char *)gi.TagMalloc(*size, Z_TAG_GAME);
+    memcpy(strings, sec, *size);
+    return strings;
+}
+
+void ReadGame(const char *filename)
+{
+    saveheader_t    hdr;
+    byte            *payload, *sec;
+    char            *strings;
+    int             len, count, stringsize, i;
+
+    payload = G_LoadSave(filename, SAVE_GAMEFILE, &hdr);
+    if (!payload)
+        return;
+
+    sec = (byte *)G_FindSection(payload, hdr.rawsize, SEC_CLIENTS, &len);
+    strings = G_LoadStrings(payload, hdr.rawsize, &stringsize);
+
+    count = len / (int)sizeof(gclient_t);
+    if (count > game_maxclients)
+        count = game_maxclients;
+    for (i = 0; i < count; i++) {
+        byte *rec = sec + i * sizeof(gclient_t);
+
+        G_LoadFields(client_fields, rec, NULL, strings, stringsize, qtrue);
+        memcpy(&g_clients[i], rec, sizeof(gclient_t));
+    }
+
+    Z_Free(payload);
+    gi.dprintf("Game loaded: %s\n", filename);
+}
+
+void ReadLevel(const char *filename)
+{
+    saveheader_t    hdr;
+    byte            *payload, *sec;
+    char            *strings;
+    qboolean        funcs;
+    int             len, num, stringsize, i;
+
+    payload = G_LoadSave(filename, SAVE_LEVELFILE, &hdr);
+    if (!payload)
+        return;
+
+    sec = (byte *)G_FindSection(payload, hdr.rawsize, SEC_EDICTS, &len);
+    num = len / (int)sizeof(edict_t);
+    if (num <= game_maxclients || num > globals.max_edicts) {
+        gi.dprintf("%s: bad entity count %d\n", filename, num);
+        Z_Free(payload);
+        return;
+    }
+
+    funcs = G_SaveFuncsValid(&hdr);
+    if (!funcs)
+        gi.dprintf("%s: saved by another build, entities keep their spawned callbacks\n",
+                   filename);
+    strings = G_LoadStrings(payload, hdr.rawsize, &stringsize);
+
+    {
+        const byte *lv = G_FindSection(payload, hdr.rawsize, SEC_LEVEL, &len);
+
+        if (lv && len == (int)sizeof(level_t))
+            memcpy(&level, lv, sizeof(level_t));
+    }
+
+    /* Every slot but the world's, saved or not */
+    for (i = 1; i < globals.num_edicts || i < num; i++) {
+        edict_t *ent = &globals.edicts[i];
+
+        if (ent->inuse || ent->linked)
+            gi.unlinkentity(ent);
+
+        if (i >= num) {
+            memset(ent, 0, sizeof(*ent));
+            continue;
+        }
+
+        {
+            byte        *rec = sec + i * sizeof(edict_t);
+            qboolean    linked;
+
+            G_LoadFields(edict_fields, rec, ent->inuse ? (const byte *)ent : NULL,
+                         strings, stringsize, funcs);
+            memcpy(ent, rec, sizeof(*ent));
+
+            linked = ent->linked;
+            ent->linked = qfalse;
+            if (ent->inuse && linked)
+                gi.linkentity(ent);
+        }
+    }
+    globals.num_edicts = num;
+
+    /* The allocator's free queue and the name indexes follow the slots */
+    G_ClearEdictPool();
+    G_ClearEntityIndex();
+    for (i = 0; i < globals.num_edicts; i++) {
+        edict_t *ent = &globals.edicts[i];
+
+        G_IndexEdict(ent);
+        if (!ent->inuse && i > game_maxclients)
+            G_EdictFreed(ent);
+    }
+
+    sec = (byte *)G_FindSection(payload, hdr.rawsize, SEC_SCRIPTS, &len);
+    if (!sec || !G_ScriptReadState(sec, len))
+        gi.dprintf("%s: no script state\n", filename);
+
+    /* Nothing points into the previous load's strings now */
+    if (save_strings)
+        gi.TagFree(save_strings);
+    save_strings = strings;
+
+    Z_Free(payload);
+    gi.dprintf("Level loaded: %s (%d entities)\n", filename, num);
+}
@@ -25,6 +25,7 @@
 #include <string.h>
 
 extern game_export_t globals;
+extern cvar_t *sv_script_ops;
 
 /* ==========================================================================
    Constants
@@ -107,6 +108,12 @@ extern game_export_t globals;
 #define OP_PRECACHE_MDL 0x30
 #define OP_TOUCH        0x31
 
+/* Recompilation extension, never emitted by SoF's script compiler: pop a
+   timeout in seconds, then an entity, and sleep until the entity is used
+   or freed or the timeout runs out (OS_EVENT_TIMEOUT if it is <= 0) */
+#define OP_WAIT_EVENT   0x40
+#define OS_EVENT_TIMEOUT    60.0f
+
 /* ==========================================================================
    Data Types
    ========================================================================== */
@@ -119,29 +126,85 @@ typedef union {
     edict_t *ent;
 } script_val_t;
 
+/* Entity fields OP_SET can write, looked up from the symbol name at load */
+enum {
+    SPROP_NONE,
+    SPROP_MOVETYPE,
+    SPROP_SOLID,
+    SPROP_HEALTH,
+    SPROP_TAKEDAMAGE,
+    SPROP_STATE,
+    SPROP_COUNT,
+    SPROP_WAIT,
+    SPROP_SPEED,
+    SPROP_YAW_SPEED
+};
+
 typedef struct {
     char        name[64];
     int         type;       /* SYM_INT, SYM_FLOAT, etc. */
     int         id;
+    int         prop;       /* SPROP_* */
     script_val_t val;
 } script_symbol_t;
 
 typedef struct {
     int             type;   /* 0=int, 1=float, 2=vec, 3=string, 4=entity */
-    script_val_t    val;
-    char            str[128]; /* string storage */
+    script_val_t    val;    /* strings point into the script's string pool */
 } stack_entry_t;
 
+/*
+ * Decoded instructions. G_ScriptLoad compiles the bytecode into an array
+ * of these once: operands unpacked, symbol IDs turned into indexes, and a
+ * literal targetname or sound path folded into the instruction that uses
+ * it. No-ops and stubs are dropped. The .os stream never jumps, so the
+ * array runs straight through like the bytes did.
+ */
+enum {
+    OSI_END,
+    OSI_ERROR,              /* truncated operand */
+    OSI_PUSH,               /* push imm, arg = stack type */
+    OSI_PUSH_SYM,           /* push symbols[arg] */
+    OSI_ENTREF,             /* pop targetname, push entity */
+    OSI_ENTREF_CONST,       /* push entity named imm.s, cached */
+    OSI_SET,
+    OSI_WAIT,               /* yield for imm.f seconds */
+    OSI_SLEEP,
+    OSI_WAIT_EVENT,
+    OSI_PRECACHE_SND,
+    OSI_POP,
+    OSI_PLAYSOUND,
+    OSI_PLAYSOUND_CONST,    /* sound imm.s, arg = index once resolved */
+    OSI_ACTIVATE,
+    OSI_DEACTIVATE,
+    OSI_USE,
+    OSI_KILL,
+    OSI_SET_CVAR,
+    OSI_PRINT,
+    OSI_NUM
+};
+
+typedef struct {
+    const void      *label;     /* handler, when direct-threaded */
+    int             op;         /* OSI_* */
+    int             arg;
+    script_val_t    imm;
+    edict_t         *ent;       /* OSI_ENTREF_CONST: last match */
+    int             gen;        /* and its G_EdictGeneration */
+} os_insn_t;
+
 /* A running script instance */
 typedef struct {
     qboolean        active;
     char            name[64];       /* script path (e.g., "nyc1/intro") */
     edict_t         *owner;         /* entity that started this script */
 
-    /* Loaded bytecode */
-    byte            *bytecode;
-    int             bytecode_len;
-    int             pc;             /* program counter */
+    /* Compiled program: instructions, then the string pool */
+    os_insn_t       *code;
+    int             num_insns;
+    int             poolsize;
+    qboolean        linked;         /* labels filled in */
+    int             pc;             /* next instruction */
 
     /* Symbol table */
     script_symbol_t symbols[MAX_SYMBOLS];
@@ -153,7 +216,14 @@ typedef struct {
 
     /* Wait state */
     float           wait_until;     /* level.time when script resumes */
+    edict_t         *wait_ent;      /* or until this entity is signalled */
     edict_t         *current_ent;   /* entity being operated on */
+    int             current_gen;    /* its G_EdictGeneration */
+
+    /* Scheduling */
+    int             budget;         /* instructions per slice */
+    int             due;            /* frame tick wait_until falls in */
+    char            profname[80];   /* profiler zone, kept by pointer */
 } script_instance_t;
 
 static script_instance_t scripts[MAX_SCRIPTS];
@@ -163,7 +233,7 @@ static int num_active_scripts = 0;
    Symbol Table Parser
    ========================================================================== */
 
-static int OS_ParseSymbolTable(byte *data, int len, script_symbol_t *syms, int max_syms)
+static int OS_ParseSymbolTable(const byte *data, int len, script_symbol_t *syms, int max_syms)
 {
     int pos = 4;    /* skip version */
     int count = 0;
@@ -249,8 +319,7 @@ static void OS_PushString(script_instance_t *sc, const char *s)
 {
     stack_entry_t e = {0};
     e.type = 3;
-    Q_strncpyz(e.str, s, sizeof(e.str));
-    e.val.s = e.str;
+    e.val.s = (char *)s;
     OS_Push(sc, &e);
 }
 
@@ -276,144 +345,179 @@ static int OS_StackInt(stack_entry_t *e)
     return 0;
 }
 
+static const char *OS_StackString(stack_entry_t *e)
+{
+    return (e->type == 3 && e->val.s) ? e->val.s : "";
+}
+
 /* ==========================================================================
    Entity Lookup
    ========================================================================== */
 
 static edict_t *OS_FindEntity(const char *targetname)
 {
-    int i;
     if (!targetname || !targetname[0])
         return NULL;
 
-    for (i = 0; i < globals.num_edicts; i++) {
-        edict_t *e = &globals.edicts[i];
-        if (!e->inuse) continue;
-        if (e->targetname && Q_stricmp(e->targetname, targetname) == 0)
-            return e;
+    return G_FindTargetname(NULL, targetname);
+}
+
+/*
+ * OS_ConstEntity - Entity for a literal targetname, kept between runs
+ * until it is freed or its slot reused. A miss is looked up again next
+ * time, since the entity may not have spawned yet.
+ */
+static edict_t *OS_ConstEntity(os_insn_t *in)
+{
+    if (in->ent && in->ent->inuse && G_EdictGeneration(in->ent) == in->gen)
+        return in->ent;
+
+    in->ent = OS_FindEntity(in->imm.s);
+    if (in->ent)
+        in->gen = G_EdictGeneration(in->ent);
+    return in->ent;
+}
+
+static void OS_SetCurrent(script_instance_t *sc, edict_t *ent)
+{
+    sc->current_ent = ent;
+    if (ent)
+        sc->current_gen = G_EdictGeneration(ent);
+}
+
+static int OS_SymbolById(script_instance_t *sc, int id)
+{
+    int si;
+
+    for (si = 0; si < sc->num_symbols; si++) {
+        if (sc->symbols[si].id == id)
+            return si;
     }
-    return NULL;
+    return -1;
+}
+
+static int OS_PropertyForName(const char *name)
+{
+    static const struct { const char *name; int prop; } props[] = {
+        { "movetype",   SPROP_MOVETYPE },
+        { "solid",      SPROP_SOLID },
+        { "health",     SPROP_HEALTH },
+        { "takedamage", SPROP_TAKEDAMAGE },
+        { "state",      SPROP_STATE },
+        { "count",      SPROP_COUNT },
+        { "wait",       SPROP_WAIT },
+        { "speed",      SPROP_SPEED },
+        { "yaw_speed",  SPROP_YAW_SPEED },
+    };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(props) / sizeof(props[0])); i++) {
+        if (Q_stricmp(name, props[i].name) == 0)
+            return props[i].prop;
+    }
+    return SPROP_NONE;
 }
 
 /* ==========================================================================
-   Bytecode Execution
+   Compiler
    ========================================================================== */
 
 /*
- * Execute bytecode for one time-slice.
- * Returns: 0 = finished, 1 = waiting, -1 = error
+ * Null-terminated string at *pc, truncated as the stack used to truncate
+ * it. Copied to pool when there is one; returns the pool bytes it takes.
  */
-static int OS_Execute(script_instance_t *sc, float current_time)
+static int OS_CompileString(const byte *bc, int len, int *pc, char *pool)
 {
-    byte *bc = sc->bytecode;
-    int len = sc->bytecode_len;
-    int ops_executed = 0;
-    int max_ops = 10000;    /* prevent infinite loops per frame */
+    int start = *pc;
+    int slen;
+
+    while (*pc < len && bc[*pc] != 0) (*pc)++;
+    slen = *pc - start;
+    if (slen > 127) slen = 127;
+    if (pool) {
+        memcpy(pool, &bc[start], slen);
+        pool[slen] = 0;
+    }
+    if (*pc < len) (*pc)++;  /* skip null */
+    return slen + 1;
+}
 
-    /* Check wait state */
-    if (sc->wait_until > 0 && current_time < sc->wait_until)
-        return 1;   /* still waiting */
-    sc->wait_until = 0;
+/*
+ * OS_Compile - Decode bytecode into instructions. G_ScriptLoad calls it
+ * twice: with code NULL to size the program, then to fill it in. Returns
+ * the instruction count and the string pool size in *poolsize.
+ */
+static int OS_Compile(script_instance_t *sc, const byte *bc, int len,
+                      os_insn_t *code, char *pool, int *poolsize)
+{
+    int pc = 0, n = 0, used = 0;
+    qboolean last_str = qfalse;     /* last instruction pushed a literal */
+    os_insn_t in;
 
-    while (sc->pc < len && ops_executed < max_ops) {
-        byte op = bc[sc->pc++];
-        ops_executed++;
+    while (pc < len) {
+        byte op = bc[pc++];
 
-        switch (op) {
-        case OP_NOP:
-        case OP_NOP2:
-            break;
+        memset(&in, 0, sizeof(in));
+        in.op = -1;
 
+        switch (op) {
         case OP_END:
         case OP_RETURN:
-            return 0;   /* script finished */
+            in.op = OSI_END;
+            break;
 
         case OP_PUSH: {
-            if (sc->pc >= len) return -1;
-            byte ptype = bc[sc->pc++];
+            byte ptype;
+
+            if (pc >= len) { in.op = OSI_ERROR; break; }
+            ptype = bc[pc++];
 
             switch (ptype) {
             case PUSH_INT:
-                if (sc->pc + 4 > len) return -1;
-                OS_PushInt(sc, *(int *)(bc + sc->pc));
-                sc->pc += 4;
-                break;
-
             case PUSH_FLOAT:
-                if (sc->pc + 4 > len) return -1;
-                OS_PushFloat(sc, *(float *)(bc + sc->pc));
-                sc->pc += 4;
+                if (pc + 4 > len) { in.op = OSI_ERROR; break; }
+                in.op = OSI_PUSH;
+                in.arg = ptype == PUSH_INT ? 0 : 1;
+                memcpy(&in.imm, bc + pc, 4);
+                pc += 4;
                 break;
 
-            case PUSH_STRING: {
-                int start = sc->pc;
-                while (sc->pc < len && bc[sc->pc] != 0) sc->pc++;
-                {
-                    char buf[128];
-                    int slen = sc->pc - start;
-                    if (slen >= (int)sizeof(buf)) slen = (int)sizeof(buf) - 1;
-                    memcpy(buf, &bc[start], slen);
-                    buf[slen] = 0;
-                    OS_PushString(sc, buf);
-                }
-                if (sc->pc < len) sc->pc++;  /* skip null */
+            case PUSH_STRING:
+                in.op = OSI_PUSH;
+                in.arg = 3;
+                in.imm.s = pool ? pool + used : NULL;
+                used += OS_CompileString(bc, len, &pc, pool ? pool + used : NULL);
                 break;
-            }
 
             case PUSH_VARREF:
             case PUSH_VARREF2: {
-                if (sc->pc + 4 > len) return -1;
-                {
-                    int var_id = *(int *)(bc + sc->pc);
-                    sc->pc += 4;
-                    /* Look up symbol by ID */
-                    {
-                        int si;
-                        qboolean found = qfalse;
-                        for (si = 0; si < sc->num_symbols; si++) {
-                            if (sc->symbols[si].id == var_id) {
-                                switch (sc->symbols[si].type) {
-                                case SYM_INT:
-                                    OS_PushInt(sc, sc->symbols[si].val.i);
-                                    break;
-                                case SYM_FLOAT:
-                                    OS_PushFloat(sc, sc->symbols[si].val.f);
-                                    break;
-                                case SYM_ENTITY:
-                                    OS_PushEntity(sc, sc->symbols[si].val.ent);
-                                    break;
-                                default:
-                                    OS_PushInt(sc, 0);
-                                    break;
-                                }
-                                found = qtrue;
-                                break;
-                            }
-                        }
-                        if (!found)
-                            OS_PushInt(sc, var_id);
-                    }
+                int var_id, si;
+
+                if (pc + 4 > len) { in.op = OSI_ERROR; break; }
+                var_id = *(const int *)(bc + pc);
+                pc += 4;
+                si = OS_SymbolById(sc, var_id);
+                if (si >= 0) {
+                    in.op = OSI_PUSH_SYM;
+                    in.arg = si;
+                } else {
+                    in.op = OSI_PUSH;
+                    in.arg = 0;
+                    in.imm.i = var_id;
                 }
                 break;
             }
 
-            case PUSH_ENTFIND: {
+            case PUSH_ENTFIND:
                 /* The previous string on stack is the entity targetname */
-                /* Nothing to push here — the string is already on stack */
                 break;
-            }
 
             case PUSH_VECTOR:
-                if (sc->pc + 12 > len) return -1;
-                {
-                    stack_entry_t e = {0};
-                    e.type = 2;
-                    e.val.v[0] = *(float *)(bc + sc->pc);
-                    e.val.v[1] = *(float *)(bc + sc->pc + 4);
-                    e.val.v[2] = *(float *)(bc + sc->pc + 8);
-                    OS_Push(sc, &e);
-                }
-                sc->pc += 12;
+                if (pc + 12 > len) { in.op = OSI_ERROR; break; }
+                in.op = OSI_PUSH;
+                in.arg = 2;
+                memcpy(in.imm.v, bc + pc, 12);
+                pc += 12;
                 break;
 
             default:
@@ -423,222 +527,608 @@ static int OS_Execute(script_instance_t *sc, float current_time)
             break;
         }
 
-        case 0x07: {
+        case 0x07:
             /* Literal string (null-terminated) */
-            int start = sc->pc;
-            while (sc->pc < len && bc[sc->pc] != 0) sc->pc++;
-            {
-                char buf[128];
-                int slen = sc->pc - start;
-                if (slen >= (int)sizeof(buf)) slen = (int)sizeof(buf) - 1;
-                memcpy(buf, &bc[start], slen);
-                buf[slen] = 0;
-                OS_PushString(sc, buf);
-            }
-            if (sc->pc < len) sc->pc++;
-            break;
-        }
-
-        case OP_ENTREF: {
-            /* Pop string from stack, find entity by targetname */
-            stack_entry_t *name_entry = OS_Pop(sc);
-            const char *tname = (name_entry->type == 3) ? name_entry->str : "";
-            edict_t *ent = OS_FindEntity(tname);
-            OS_PushEntity(sc, ent);
-            sc->current_ent = ent;
+            in.op = OSI_PUSH;
+            in.arg = 3;
+            in.imm.s = pool ? pool + used : NULL;
+            used += OS_CompileString(bc, len, &pc, pool ? pool + used : NULL);
             break;
-        }
 
-        case OP_SET: {
-            /* Set entity property: pop value, pop property name / var ref */
-            stack_entry_t *val = OS_Pop(sc);
-            stack_entry_t *prop = OS_Pop(sc);
-
-            if (sc->current_ent && prop->type == 0) {
-                /* prop is a variable reference (symbol ID) */
-                int var_id = prop->val.i;
-                int si;
-                for (si = 0; si < sc->num_symbols; si++) {
-                    if (sc->symbols[si].id == var_id) {
-                        edict_t *ent = sc->current_ent;
-                        const char *pname = sc->symbols[si].name;
-
-                        /* Apply known properties */
-                        if (Q_stricmp(pname, "movetype") == 0) {
-                            ent->movetype = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "solid") == 0) {
-                            ent->solid = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "health") == 0) {
-                            ent->health = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "takedamage") == 0) {
-                            ent->takedamage = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "state") == 0) {
-                            ent->s.frame = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "count") == 0) {
-                            ent->count = OS_StackInt(val);
-                        } else if (Q_stricmp(pname, "wait") == 0) {
-                            ent->wait = OS_StackFloat(val);
-                        } else if (Q_stricmp(pname, "speed") == 0) {
-                            ent->speed = OS_StackFloat(val);
-                        } else if (Q_stricmp(pname, "yaw_speed") == 0) {
-                            ent->yaw_speed = OS_StackFloat(val);
-                        }
-                        /* Store in symbol table too */
-                        sc->symbols[si].val = val->val;
-                        break;
-                    }
+        case OP_ENTREF:
+        case OP_PLAYSOUND:
+            /* A literal pushed just before is folded in */
+            if (last_str) {
+                if (code) {
+                    code[n - 1].op = op == OP_ENTREF ? OSI_ENTREF_CONST
+                                                     : OSI_PLAYSOUND_CONST;
+                    code[n - 1].arg = 0;
                 }
+                last_str = qfalse;
+                continue;
             }
+            in.op = op == OP_ENTREF ? OSI_ENTREF : OSI_PLAYSOUND;
             break;
-        }
-
-        case OP_WAIT: {
-            /* Wait N milliseconds / frames */
-            if (sc->pc + 4 > len) return -1;
-            {
-                int duration = *(int *)(bc + sc->pc);
-                sc->pc += 4;
-                sc->wait_until = current_time + (float)duration * 0.1f;
-                return 1;   /* yield execution */
-            }
-        }
-
-        case OP_SLEEP: {
-            /* Sleep — pop duration from stack */
-            stack_entry_t *dur = OS_Pop(sc);
-            float secs = OS_StackFloat(dur);
-            if (secs > 0)
-                sc->wait_until = current_time + secs;
-            return 1;
-        }
 
-        case OP_PRECACHE_SND: {
-            /* Pop sound path, precache it */
-            stack_entry_t *path = OS_Pop(sc);
-            if (path->type == 3 && path->str[0]) {
-                gi.soundindex(path->str);
-            }
+        case OP_WAIT:
+            /* Wait N tenths of a second */
+            if (pc + 4 > len) { in.op = OSI_ERROR; break; }
+            in.op = OSI_WAIT;
+            in.imm.f = (float)*(const int *)(bc + pc) * 0.1f;
+            pc += 4;
             break;
-        }
+
+        case OP_SET:            in.op = OSI_SET; break;
+        case OP_SLEEP:          in.op = OSI_SLEEP; break;
+        case OP_WAIT_EVENT:     in.op = OSI_WAIT_EVENT; break;
+        case OP_PRECACHE_SND:   in.op = OSI_PRECACHE_SND; break;
+        case OP_ACTIVATE:       in.op = OSI_ACTIVATE; break;
+        case OP_DEACTIVATE:     in.op = OSI_DEACTIVATE; break;
+        case OP_USE:            in.op = OSI_USE; break;
+        case OP_KILL:           in.op = OSI_KILL; break;
+        case OP_SET_CVAR:       in.op = OSI_SET_CVAR; break;
+        case OP_PRINT:          in.op = OSI_PRINT; break;
 
         case OP_PRECACHE_ROF:
         case OP_PRECACHE_MDL:
-        case OP_TOUCH: {
-            /* Pop path, precache (currently stub) */
-            OS_Pop(sc);
+        case OP_TOUCH:
+        case OP_PLAY_ROFF:
+            /* Pop path (currently stub) */
+            in.op = OSI_POP;
             break;
-        }
 
-        case OP_PLAYSOUND: {
-            /* Play sound on current entity */
-            stack_entry_t *snd = OS_Pop(sc);
-            if (sc->current_ent && snd->type == 3 && snd->str[0]) {
-                int idx = gi.soundindex(snd->str);
-                if (idx > 0) {
-                    gi.sound(sc->current_ent, CHAN_AUTO, idx, 1.0f, ATTN_NORM, 0);
-                }
-            }
+        default:
+            /* No-ops, stubs and unknown opcodes have no effect */
             break;
         }
 
-        case OP_PLAY_ROFF: {
-            /* Play ROFF animation on entity (stub) */
-            OS_Pop(sc);  /* path */
-            break;
+        if (in.op < 0)
+            continue;
+        if (code)
+            code[n] = in;
+        n++;
+        last_str = in.op == OSI_PUSH && in.arg == 3;
+
+        /* Nothing after these can run */
+        if (in.op == OSI_END || in.op == OSI_ERROR) {
+            *poolsize = used;
+            return n;
         }
+    }
 
-        case OP_STOP_ROFF:
-            break;
+    /* Running off the end finishes the script */
+    if (code) {
+        memset(&code[n], 0, sizeof(code[n]));
+        code[n].op = OSI_END;
+    }
+    *poolsize = used;
+    return n + 1;
+}
 
-        case OP_ACTIVATE: {
-            /* Activate entity (set SVF_NOCLIENT off, enable thinking) */
-            if (sc->current_ent) {
-                sc->current_ent->svflags &= ~SVF_NOCLIENT;
-                sc->current_ent->solid = SOLID_BSP;
-                gi.linkentity(sc->current_ent);
-            }
+/* ==========================================================================
+   Execution
+   ========================================================================== */
+
+/* Direct-threaded where the compiler has labels as values: each decoded
+   instruction holds its handler's address and every handler jumps
+   straight to the next one. Otherwise the same handlers sit in a switch. */
+#if defined(__GNUC__)
+#define OS_THREADED
+#endif
+
+#ifdef OS_THREADED
+#define OS_OP(x)        op_##x
+#define OS_DISPATCH()   { if (ops++ >= sc->budget) goto budget; goto *ip->label; }
+#else
+#define OS_OP(x)        case x
+#define OS_DISPATCH()   continue
+#endif
+#define OS_NEXT()       { ip++; OS_DISPATCH(); }
+#define OS_YIELD()      { sc->pc = (int)(ip + 1 - sc->code); return 1; }
+
+/*
+ * Execute one time-slice of at most sc->budget instructions.
+ * Returns: 0 = finished, 1 = waiting, -1 = error
+ */
+static int OS_Execute(script_instance_t *sc, float current_time)
+{
+#ifdef OS_THREADED
+    static const void *const labels[OSI_NUM] = {
+        [OSI_END]               = &&op_OSI_END,
+        [OSI_ERROR]             = &&op_OSI_ERROR,
+        [OSI_PUSH]              = &&op_OSI_PUSH,
+        [OSI_PUSH_SYM]          = &&op_OSI_PUSH_SYM,
+        [OSI_ENTREF]            = &&op_OSI_ENTREF,
+        [OSI_ENTREF_CONST]      = &&op_OSI_ENTREF_CONST,
+        [OSI_SET]               = &&op_OSI_SET,
+        [OSI_WAIT]              = &&op_OSI_WAIT,
+        [OSI_SLEEP]             = &&op_OSI_SLEEP,
+        [OSI_WAIT_EVENT]        = &&op_OSI_WAIT_EVENT,
+        [OSI_PRECACHE_SND]      = &&op_OSI_PRECACHE_SND,
+        [OSI_POP]               = &&op_OSI_POP,
+        [OSI_PLAYSOUND]         = &&op_OSI_PLAYSOUND,
+        [OSI_PLAYSOUND_CONST]   = &&op_OSI_PLAYSOUND_CONST,
+        [OSI_ACTIVATE]          = &&op_OSI_ACTIVATE,
+        [OSI_DEACTIVATE]        = &&op_OSI_DEACTIVATE,
+        [OSI_USE]               = &&op_OSI_USE,
+        [OSI_KILL]              = &&op_OSI_KILL,
+        [OSI_SET_CVAR]          = &&op_OSI_SET_CVAR,
+        [OSI_PRINT]             = &&op_OSI_PRINT,
+    };
+#endif
+    os_insn_t *ip;
+    int ops = 0;
+
+    /* Check wait state */
+    if (sc->wait_until > 0 && current_time < sc->wait_until)
+        return 1;   /* still waiting */
+    if (sc->wait_ent)
+        gi.dprintf("Script %s: timed out waiting on entity %d\n", sc->name,
+                   (int)(sc->wait_ent - globals.edicts));
+    sc->wait_until = 0;
+    sc->wait_ent = NULL;
+
+    /* The entity being operated on may have gone while we waited */
+    if (sc->current_ent && (!sc->current_ent->inuse ||
+        G_EdictGeneration(sc->current_ent) != sc->current_gen))
+        sc->current_ent = NULL;
+
+#ifdef OS_THREADED
+    if (!sc->linked) {
+        int i;
+        for (i = 0; i < sc->num_insns; i++)
+            sc->code[i].label = labels[sc->code[i].op];
+        sc->linked = qtrue;
+    }
+#endif
+
+    ip = sc->code + sc->pc;
+
+#ifdef OS_THREADED
+    OS_DISPATCH();
+#else
+    for (;;) {
+        if (ops++ >= sc->budget)
+            goto budget;
+        switch (ip->op) {
+#endif
+
+    OS_OP(OSI_END):
+        return 0;   /* script finished */
+
+    OS_OP(OSI_ERROR):
+        return -1;
+
+    OS_OP(OSI_PUSH): {
+        stack_entry_t e = {0};
+        e.type = ip->arg;
+        e.val = ip->imm;
+        OS_Push(sc, &e);
+        OS_NEXT();
+    }
+
+    OS_OP(OSI_PUSH_SYM): {
+        script_symbol_t *sym = &sc->symbols[ip->arg];
+        switch (sym->type) {
+        case SYM_INT:
+            OS_PushInt(sc, sym->val.i);
+            break;
+        case SYM_FLOAT:
+            OS_PushFloat(sc, sym->val.f);
+            break;
+        case SYM_ENTITY:
+            OS_PushEntity(sc, sym->val.ent);
+            break;
+        default:
+            OS_PushInt(sc, 0);
             break;
         }
+        OS_NEXT();
+    }
 
-        case OP_DEACTIVATE: {
-            if (sc->current_ent) {
-                sc->current_ent->svflags |= SVF_NOCLIENT;
-                sc->current_ent->solid = SOLID_NOT;
-                gi.linkentity(sc->current_ent);
+    OS_OP(OSI_ENTREF): {
+        /* Pop string from stack, find entity by targetname */
+        edict_t *ent = OS_FindEntity(OS_StackString(OS_Pop(sc)));
+        OS_PushEntity(sc, ent);
+        OS_SetCurrent(sc, ent);
+        OS_NEXT();
+    }
+
+    OS_OP(OSI_ENTREF_CONST): {
+        edict_t *ent = OS_ConstEntity(ip);
+        OS_PushEntity(sc, ent);
+        OS_SetCurrent(sc, ent);
+        OS_NEXT();
+    }
+
+    OS_OP(OSI_SET): {
+        /* Set entity property: pop value, pop property name / var ref */
+        stack_entry_t *val = OS_Pop(sc);
+        stack_entry_t *prop = OS_Pop(sc);
+        int si;
+
+        /* prop is a variable reference (symbol ID) */
+        if (sc->current_ent && prop->type == 0 &&
+            (si = OS_SymbolById(sc, prop->val.i)) >= 0) {
+            edict_t *ent = sc->current_ent;
+
+            /* Apply known properties */
+            switch (sc->symbols[si].prop) {
+            case SPROP_MOVETYPE:    ent->movetype = OS_StackInt(val); break;
+            case SPROP_SOLID:       ent->solid = OS_StackInt(val); break;
+            case SPROP_HEALTH:      ent->health = OS_StackInt(val); break;
+            case SPROP_TAKEDAMAGE:  ent->takedamage = OS_StackInt(val); break;
+            case SPROP_STATE:       ent->s.frame = OS_StackInt(val); break;
+            case SPROP_COUNT:       ent->count = OS_StackInt(val); break;
+            case SPROP_WAIT:        ent->wait = OS_StackFloat(val); break;
+            case SPROP_SPEED:       ent->speed = OS_StackFloat(val); break;
+            case SPROP_YAW_SPEED:   ent->yaw_speed = OS_StackFloat(val); break;
+            default:                break;
             }
-            break;
+            /* Store in symbol table too */
+            sc->symbols[si].val = val->val;
         }
+        OS_NEXT();
+    }
 
-        case OP_USE: {
-            /* Trigger entity's use callback */
-            if (sc->current_ent && sc->current_ent->use) {
-                sc->current_ent->use(sc->current_ent, sc->owner, sc->owner);
-            }
-            break;
+    OS_OP(OSI_WAIT):
+        sc->wait_until = current_time + ip->imm.f;
+        OS_YIELD();
+
+    OS_OP(OSI_SLEEP): {
+        /* Sleep — pop duration from stack */
+        float secs = OS_StackFloat(OS_Pop(sc));
+        if (secs > 0)
+            sc->wait_until = current_time + secs;
+        OS_YIELD();
+    }
+
+    OS_OP(OSI_WAIT_EVENT): {
+        /* Pop timeout, then entity; G_ScriptSignal or the timer wakes us */
+        float secs = OS_StackFloat(OS_Pop(sc));
+        stack_entry_t *ent = OS_Pop(sc);
+        if (secs <= 0)
+            secs = OS_EVENT_TIMEOUT;
+        sc->wait_until = current_time + secs;
+        if (ent->type == 4 && ent->val.ent && ent->val.ent->inuse)
+            sc->wait_ent = ent->val.ent;
+        OS_YIELD();
+    }
+
+    OS_OP(OSI_PRECACHE_SND): {
+        /* Pop sound path, precache it */
+        const char *path = OS_StackString(OS_Pop(sc));
+        if (path[0])
+            gi.soundindex(path);
+        OS_NEXT();
+    }
+
+    OS_OP(OSI_POP):
+        OS_Pop(sc);
+        OS_NEXT();
+
+    OS_OP(OSI_PLAYSOUND): {
+        /* Play sound on current entity */
+        const char *snd = OS_StackString(OS_Pop(sc));
+        if (sc->current_ent && snd[0]) {
+            int idx = gi.soundindex(snd);
+            if (idx > 0)
+                gi.sound(sc->current_ent, CHAN_AUTO, idx, 1.0f, ATTN_NORM, 0);
         }
+        OS_NEXT();
+    }
 
-        case OP_KILL: {
-            /* Remove/kill entity */
-            if (sc->current_ent) {
-                sc->current_ent->inuse = qfalse;
-                gi.unlinkentity(sc->current_ent);
-                sc->current_ent = NULL;
-            }
-            break;
+    OS_OP(OSI_PLAYSOUND_CONST):
+        if (sc->current_ent && ip->imm.s[0]) {
+            if (ip->arg <= 0)
+                ip->arg = gi.soundindex(ip->imm.s);
+            if (ip->arg > 0)
+                gi.sound(sc->current_ent, CHAN_AUTO, ip->arg, 1.0f, ATTN_NORM, 0);
         }
+        OS_NEXT();
+
+    OS_OP(OSI_ACTIVATE):
+        /* Activate entity (set SVF_NOCLIENT off, enable thinking) */
+        if (sc->current_ent) {
+            sc->current_ent->svflags &= ~SVF_NOCLIENT;
+            sc->current_ent->solid = SOLID_BSP;
+            gi.linkentity(sc->current_ent);
+        }
+        OS_NEXT();
 
-        case OP_SET_CVAR: {
-            /* Set a cvar: pop value, pop name */
-            stack_entry_t *val = OS_Pop(sc);
-            stack_entry_t *name_e = OS_Pop(sc);
-            if (name_e->type == 3 && name_e->str[0]) {
-                char vbuf[64];
-                if (val->type == 1)
-                    Com_sprintf(vbuf, sizeof(vbuf), "%f", val->val.f);
-                else if (val->type == 0)
-                    Com_sprintf(vbuf, sizeof(vbuf), "%d", val->val.i);
-                else
-                    Q_strncpyz(vbuf, val->str, sizeof(vbuf));
-                Cvar_Set(name_e->str, vbuf);
-            }
-            break;
+    OS_OP(OSI_DEACTIVATE):
+        if (sc->current_ent) {
+            sc->current_ent->svflags |= SVF_NOCLIENT;
+            sc->current_ent->solid = SOLID_NOT;
+            gi.linkentity(sc->current_ent);
         }
+        OS_NEXT();
 
-        case OP_PRINT: {
-            stack_entry_t *msg = OS_Pop(sc);
-            if (msg->type == 3)
-                gi.dprintf("Script: %s\n", msg->str);
-            break;
+    OS_OP(OSI_USE):
+        /* Trigger entity's use callback */
+        if (sc->current_ent) {
+            if (sc->current_ent->use)
+                sc->current_ent->use(sc->current_ent, sc->owner, sc->owner);
+            G_ScriptSignal(sc->current_ent);
+        }
+        OS_NEXT();
+
+    OS_OP(OSI_KILL):
+        /* Remove/kill entity */
+        if (sc->current_ent) {
+            sc->current_ent->inuse = qfalse;
+            gi.unlinkentity(sc->current_ent);
+            sc->current_ent = NULL;
         }
+        OS_NEXT();
+
+    OS_OP(OSI_SET_CVAR): {
+        /* Set a cvar: pop value, pop name */
+        stack_entry_t *val = OS_Pop(sc);
+        const char *name = OS_StackString(OS_Pop(sc));
+        if (name[0]) {
+            char vbuf[64];
+            if (val->type == 1)
+                Com_sprintf(vbuf, sizeof(vbuf), "%f", val->val.f);
+            else if (val->type == 0)
+                Com_sprintf(vbuf, sizeof(vbuf), "%d", val->val.i);
+            else
+                Q_strncpyz(vbuf, OS_StackString(val), sizeof(vbuf));
+            Cvar_Set(name, vbuf);
+        }
+        OS_NEXT();
+    }
 
-        case OP_CAMERA:
-            /* Camera control — stub */
-            break;
+    OS_OP(OSI_PRINT): {
+        stack_entry_t *msg = OS_Pop(sc);
+        if (msg->type == 3)
+            gi.dprintf("Script: %s\n", OS_StackString(msg));
+        OS_NEXT();
+    }
 
+#ifndef OS_THREADED
         default:
-            /* Unknown opcode — skip and continue */
-            break;
+            return -1;
         }
     }
+#endif
 
-    return (sc->pc >= len) ? 0 : 1;
+budget:
+    /* Out of steps for this frame, carry on from here next frame */
+    sc->pc = (int)(ip - sc->code);
+    return 1;
 }
 
 /* ==========================================================================
-   Public API
+   Scheduler
    ========================================================================== */
 
 /*
- * G_ScriptLoad — Load and start executing a script
+ * Each frame only touches scripts that can run. A script is on exactly one
+ * list: the run queue, a timer wheel slot or the far list. Waits are filed
+ * by frame tick in a two-level wheel, 64 one-frame slots under 64 slots of
+ * 64 frames, which covers about seven minutes at 10Hz. Longer waits sit on
+ * the far list and are re-filed as each outer slot comes round. A script
+ * in OP_WAIT_EVENT is also on the wait list of its entity, through a second
+ * set of links, so whichever of the signal and its timeout comes first
+ * wakes it.
  */
-void G_ScriptLoad(const char *scriptname, edict_t *owner)
+#define OS_WHEEL_BITS   6
+#define OS_WHEEL_SIZE   (1 << OS_WHEEL_BITS)
+#define OS_WHEEL_MASK   (OS_WHEEL_SIZE - 1)
+#define OS_WHEEL_SPAN   (OS_WHEEL_SIZE * OS_WHEEL_SIZE)
+
+typedef struct {
+    int     head, tail;     /* script slots, -1 */
+    int     count;
+} os_list_t;
+
+static os_list_t    os_runq;
+static os_list_t    os_wheel[2][OS_WHEEL_SIZE];
+static os_list_t    os_far;
+static os_list_t    os_entwait[MAX_EDICTS];
+
+static int          os_next[MAX_SCRIPTS], os_prev[MAX_SCRIPTS];
+static os_list_t    *os_on[MAX_SCRIPTS];    /* list a slot is on, or NULL */
+static int          os_enext[MAX_SCRIPTS], os_eprev[MAX_SCRIPTS];
+static os_list_t    *os_eon[MAX_SCRIPTS];   /* entity wait list, or NULL */
+static int          os_tick;                /* wheel has advanced to here */
+
+static void OS_ListClear(os_list_t *l)
+{
+    l->head = l->tail = -1;
+    l->count = 0;
+}
+
+static void OS_ResetScheduler(void)
+{
+    int i;
+
+    OS_ListClear(&os_runq);
+    OS_ListClear(&os_far);
+    for (i = 0; i < OS_WHEEL_SIZE; i++) {
+        OS_ListClear(&os_wheel[0][i]);
+        OS_ListClear(&os_wheel[1][i]);
+    }
+    for (i = 0; i < MAX_EDICTS; i++)
+        OS_ListClear(&os_entwait[i]);
+    memset(os_on, 0, sizeof(os_on));
+    memset(os_eon, 0, sizeof(os_eon));
+    os_tick = 0;
+}
+
+static void OS_Unlink(int slot)
+{
+    os_list_t *l = os_on[slot];
+
+    if (!l)
+        return;
+    if (os_prev[slot] >= 0) os_next[os_prev[slot]] = os_next[slot];
+    else l->head = os_next[slot];
+    if (os_next[slot] >= 0) os_prev[os_next[slot]] = os_prev[slot];
+    else l->tail = os_prev[slot];
+    l->count--;
+    os_on[slot] = NULL;
+}
+
+static void OS_Append(os_list_t *l, int slot)
+{
+    OS_Unlink(slot);
+    os_prev[slot] = l->tail;
+    os_next[slot] = -1;
+    if (l->tail >= 0) os_next[l->tail] = slot;
+    else l->head = slot;
+    l->tail = slot;
+    l->count++;
+    os_on[slot] = l;
+}
+
+/* The entity wait lists, on their own links */
+static void OS_EntUnlink(int slot)
+{
+    os_list_t *l = os_eon[slot];
+
+    if (!l)
+        return;
+    if (os_eprev[slot] >= 0) os_enext[os_eprev[slot]] = os_enext[slot];
+    else l->head = os_enext[slot];
+    if (os_enext[slot] >= 0) os_eprev[os_enext[slot]] = os_eprev[slot];
+    else l->tail = os_eprev[slot];
+    l->count--;
+    os_eon[slot] = NULL;
+}
+
+static void OS_EntAppend(os_list_t *l, int slot)
+{
+    OS_EntUnlink(slot);
+    os_eprev[slot] = l->tail;
+    os_enext[slot] = -1;
+    if (l->tail >= 0) os_enext[l->tail] = slot;
+    else l->head = slot;
+    l->tail = slot;
+    l->count++;
+    os_eon[slot] = l;
+}
+
+static float OS_FrameTime(void)
+{
+    return level.frametime > 0 ? level.frametime : 0.1f;
+}
+
+/* File a waiting script by the tick it is due in */
+static void OS_FileTimer(int slot)
+{
+    int due = scripts[slot].due;
+    int delta = due - os_tick;
+
+    if (delta <= 0)
+        OS_Append(&os_runq, slot);
+    else if (delta < OS_WHEEL_SIZE)
+        OS_Append(&os_wheel[0][due & OS_WHEEL_MASK], slot);
+    else if (delta < OS_WHEEL_SPAN)
+        OS_Append(&os_wheel[1][(due >> OS_WHEEL_BITS) & OS_WHEEL_MASK], slot);
+    else
+        OS_Append(&os_far, slot);
+}
+
+/* Re-file everything on a list against the current tick */
+static void OS_Refile(os_list_t *l)
+{
+    int n;
+
+    for (n = l->count; n > 0 && l->head >= 0; n--)
+        OS_FileTimer(l->head);
+}
+
+/* Put a script that yielded on the list its wait calls for */
+static void OS_Schedule(int slot, float now)
+{
+    script_instance_t *sc = &scripts[slot];
+
+    /* Waiting on an entity: on its list as well as the timer for the timeout */
+    OS_EntUnlink(slot);
+    if (sc->wait_ent) {
+        int num = (int)(sc->wait_ent - globals.edicts);
+        if (num >= 0 && num < MAX_EDICTS)
+            OS_EntAppend(&os_entwait[num], slot);
+        else
+            sc->wait_ent = NULL;
+    }
+
+    if (sc->wait_until > now) {
+        float frametime = OS_FrameTime();
+        sc->due = (int)(sc->wait_until / frametime);
+        if (sc->due * frametime < sc->wait_until)
+            sc->due++;
+        OS_FileTimer(slot);
+        return;
+    }
+
+    OS_Append(&os_runq, slot);
+}
+
+/* Move the wheel on to tick, queueing whatever has come due */
+static void OS_AdvanceTo(int tick)
+{
+    int i;
+
+    if (tick < os_tick || tick - os_tick > OS_WHEEL_SPAN) {
+        /* New level or a long gap: let everything re-check its wait */
+        os_tick = tick;
+        for (i = 0; i < OS_WHEEL_SIZE; i++) {
+            OS_Refile(&os_wheel[0][i]);
+            OS_Refile(&os_wheel[1][i]);
+        }
+        OS_Refile(&os_far);
+        return;
+    }
+
+    while (os_tick < tick) {
+        os_tick++;
+        if (!(os_tick & OS_WHEEL_MASK)) {
+            OS_Refile(&os_wheel[1][(os_tick >> OS_WHEEL_BITS) & OS_WHEEL_MASK]);
+            OS_Refile(&os_far);
+        }
+        OS_Refile(&os_wheel[0][os_tick & OS_WHEEL_MASK]);
+    }
+}
+
+/*
+ * G_ScriptSignal - Wake the scripts sleeping on an entity. Called when it
+ * is used by a trigger and when it is freed.
+ */
+void G_ScriptSignal(edict_t *ent)
+{
+    int num = (int)(ent - globals.edicts);
+    os_list_t *l;
+
+    if (num < 0 || num >= MAX_EDICTS)
+        return;
+    l = &os_entwait[num];
+    while (l->head >= 0) {
+        int slot = l->head;
+
+        OS_EntUnlink(slot);
+        scripts[slot].wait_ent = NULL;
+        scripts[slot].wait_until = 0;
+        OS_Append(&os_runq, slot);
+    }
+}
+
+/* ==========================================================================
+   Public API
+   ========================================================================== */
+
+static int OS_Load(const char *scriptname, edict_t *owner)
 {
-    byte    *raw;
+    const byte *raw;
     int     len;
     char    path[MAX_QPATH];
     int     slot;
     script_instance_t *sc;
     int     sym_end;
+    int     bytecode_len, poolsize;
+    int     i;
 
     /* Find free slot */
     slot = -1;
@@ -648,22 +1138,23 @@ void G_ScriptLoad(const char *scriptname, edict_t *owner)
     }
     if (slot >= MAX_SCRIPTS) {
         gi.dprintf("G_ScriptLoad: no free script slots for %s\n", scriptname);
-        return;
+        return -1;
     }
 
-    /* Load .os file from PAK */
+    /* Map .os file from PAK — it is compiled straight from the mapping */
     Com_sprintf(path, sizeof(path), "ds/%s.os", scriptname);
-    len = FS_LoadFile(path, (void **)&raw);
+    len = FS_MapFile(path, (const void **)&raw);
     if (!raw || len < 8) {
         Com_DPrintf("G_ScriptLoad: %s not found\n", path);
-        return;
+        FS_UnmapFile(raw);
+        return -1;
     }
 
     /* Verify version */
-    if (*(int *)raw != OS_VERSION) {
-        gi.dprintf("G_ScriptLoad: %s bad version %d\n", path, *(int *)raw);
-        FS_FreeFile(raw);
-        return;
+    if (*(const int *)raw != OS_VERSION) {
+        gi.dprintf("G_ScriptLoad: %s bad version %d\n", path, *(const int *)raw);
+        FS_UnmapFile(raw);
+        return -1;
     }
 
     sc = &scripts[slot];
@@ -674,6 +1165,8 @@ void G_ScriptLoad(const char *scriptname, edict_t *owner)
 
     /* Parse symbol table */
     sc->num_symbols = OS_ParseSymbolTable(raw, len, sc->symbols, MAX_SYMBOLS);
+    for (i = 0; i < sc->num_symbols; i++)
+        sc->symbols[i].prop = OS_PropertyForName(sc->symbols[i].name);
 
     /* Find bytecode start (after symbol table) */
     {
@@ -688,48 +1181,88 @@ void G_ScriptLoad(const char *scriptname, edict_t *owner)
         sym_end = pos;
     }
 
-    /* Copy bytecode */
-    sc->bytecode_len = len - sym_end;
-    if (sc->bytecode_len > MAX_SCRIPT_SIZE)
-        sc->bytecode_len = MAX_SCRIPT_SIZE;
-    sc->bytecode = (byte *)gi.TagMalloc(sc->bytecode_len, Z_TAG_GAME);
-    memcpy(sc->bytecode, raw + sym_end, sc->bytecode_len);
+    /* Compile the bytecode */
+    bytecode_len = len - sym_end;
+    if (bytecode_len > MAX_SCRIPT_SIZE)
+        bytecode_len = MAX_SCRIPT_SIZE;
+    if (bytecode_len < 0)
+        bytecode_len = 0;
+    sc->num_insns = OS_Compile(sc, raw + sym_end, bytecode_len, NULL, NULL, &poolsize);
+    sc->code = (os_insn_t *)gi.TagMalloc(sc->num_insns * (int)sizeof(os_insn_t) +
+                                         poolsize, Z_TAG_GAME);
+    OS_Compile(sc, raw + sym_end, bytecode_len, sc->code,
+               (char *)(sc->code + sc->num_insns), &poolsize);
+    sc->poolsize = poolsize;
     sc->pc = 0;
     sc->sp = 0;
 
-    FS_FreeFile(raw);
+    FS_UnmapFile(raw);
+
+    sc->budget = sv_script_ops ? (int)sv_script_ops->value : 0;
+    if (sc->budget <= 0)
+        sc->budget = 10000;
+    Com_sprintf(sc->profname, sizeof(sc->profname), "script %s", sc->name);
+    OS_Append(&os_runq, slot);
 
     num_active_scripts++;
-    Com_DPrintf("Script loaded: %s (%d symbols, %d bytes bytecode)\n",
-               scriptname, sc->num_symbols, sc->bytecode_len);
+    Com_DPrintf("Script loaded: %s (%d symbols, %d bytes bytecode, %d instructions)\n",
+               scriptname, sc->num_symbols, bytecode_len, sc->num_insns);
+    return slot;
 }
 
 /*
- * G_ScriptRunFrame — Execute all active scripts for one frame
+ * G_ScriptLoad — Load and start executing a script
+ */
+void G_ScriptLoad(const char *scriptname, edict_t *owner)
+{
+    Prof_MapLoadBegin(LOAD_SCRIPTS);
+    OS_Load(scriptname, owner);
+    Prof_MapLoadEnd();
+}
+
+/*
+ * G_ScriptRunFrame — Run the scripts that can run this frame. Scripts
+ * woken while it runs, and ones that used up their budget, go next frame.
  */
 void G_ScriptRunFrame(float level_time)
 {
-    int i;
+    int n;
 
-    for (i = 0; i < MAX_SCRIPTS; i++) {
-        script_instance_t *sc = &scripts[i];
-        if (!sc->active) continue;
+    OS_AdvanceTo((int)(level_time / OS_FrameTime() + 0.5f));
+    if (!os_runq.count)
+        return;
 
-        {
-            int result = OS_Execute(sc, level_time);
-            if (result == 0 || result == -1) {
-                /* Script finished or errored */
-                if (sc->bytecode) {
-                    gi.TagFree(sc->bytecode);
-                    sc->bytecode = NULL;
-                }
-                sc->active = qfalse;
-                num_active_scripts--;
-                Com_DPrintf("Script %s: %s\n", sc->name,
-                           result == 0 ? "completed" : "error");
-            }
+    Prof_Begin("G_ScriptRunFrame");
+
+    for (n = os_runq.count; n > 0 && os_runq.head >= 0; n--) {
+        int slot = os_runq.head;
+        script_instance_t *sc = &scripts[slot];
+        int result;
+
+        OS_Unlink(slot);
+        OS_EntUnlink(slot);
+
+        Prof_Begin(sc->profname);
+        result = OS_Execute(sc, level_time);
+        Prof_End();
+
+        if (result == 1) {
+            OS_Schedule(slot, level_time);
+            continue;
+        }
+
+        /* Script finished or errored */
+        if (sc->code) {
+            gi.TagFree(sc->code);
+            sc->code = NULL;
         }
+        sc->active = qfalse;
+        num_active_scripts--;
+        Com_DPrintf("Script %s: %s\n", sc->name,
+                   result == 0 ? "completed" : "error");
     }
+
+    Prof_End();
 }
 
 /*
@@ -739,6 +1272,7 @@ void G_ScriptInit(void)
 {
     memset(scripts, 0, sizeof(scripts));
     num_active_scripts = 0;
+    OS_ResetScheduler();
 }
 
 /*
@@ -748,10 +1282,154 @@ void G_ScriptShutdown(void)
 {
     int i;
     for (i = 0; i < MAX_SCRIPTS; i++) {
-        if (scripts[i].active && scripts[i].bytecode) {
-            gi.TagFree(scripts[i].bytecode);
+        if (scripts[i].active && scripts[i].code) {
+            gi.TagFree(scripts[i].code);
         }
     }
     memset(scripts, 0, sizeof(scripts));
     num_active_scripts = 0;
+    OS_ResetScheduler();
+}
+
+/* ==========================================================================
+   Save Games
+
+   A running script is saved as its name and where it had got to. Loading
+   compiles the script again and puts the position back: entities are
+   saved as numbers, strings on the stack as offsets into the string pool.
+   ========================================================================== */
+
+typedef struct {
+    char            name[64];
+    int             owner;          /* entity numbers, -1 = none */
+    int             pc;
+    int             sp;
+    int             num_symbols;
+    float           wait_until;
+    int             wait_ent;
+    int             current_ent;
+    script_val_t    symvals[MAX_SYMBOLS];
+    stack_entry_t   stack[MAX_STACK];
+} script_save_t;
+
+static int OS_EntNum(const edict_t *ent)
+{
+    return ent ? (int)(ent - globals.edicts) : -1;
+}
+
+static edict_t *OS_NumEnt(int num)
+{
+    return num >= 0 && num < globals.max_edicts ? &globals.edicts[num] : NULL;
+}
+
+void G_ScriptWriteState(savebuf_t *b)
+{
+    int count = 0, slot, i;
+
+    for (slot = 0; slot < MAX_SCRIPTS; slot++)
+        if (scripts[slot].active)
+            count++;
+    G_SaveWrite(b, &count, sizeof(count));
+
+    for (slot = 0; slot < MAX_SCRIPTS; slot++) {
+        const script_instance_t *sc = &scripts[slot];
+        const char      *pool, *poolend;
+        script_save_t   ss;
+
+        if (!sc->active)
+            continue;
+
+        memset(&ss, 0, sizeof(ss));
+        Q_strncpyz(ss.name, sc->name, sizeof(ss.name));
+        ss.owner = OS_EntNum(sc->owner);
+        ss.pc = sc->pc;
+        ss.sp = sc->sp;
+        ss.num_symbols = sc->num_symbols;
+        ss.wait_until = sc->wait_until;
+        ss.wait_ent = OS_EntNum(sc->wait_ent);
+        ss.current_ent = OS_EntNum(sc->current_ent);
+
+        for (i = 0; i < sc->num_symbols; i++) {
+            ss.symvals[i] = sc->symbols[i].val;
+            if (sc->symbols[i].type == SYM_ENTITY)
+                ss.symvals[i].i = OS_EntNum(sc->symbols[i].val.ent);
+        }
+
+        pool = (const char *)(sc->code + sc->num_insns);
+        poolend = pool + sc->poolsize;
+        for (i = 0; i < sc->sp; i++) {
+            ss.stack[i] = sc->stack[i];
+            if (sc->stack[i].type == 4) {
+                ss.stack[i].val.i = OS_EntNum(sc->stack[i].val.ent);
+            } else if (sc->stack[i].type == 3) {
+                const char *str = sc->stack[i].val.s;
+                ss.stack[i].val.i = str >= pool && str < poolend ? (int)(str - pool) : -1;
+            }
+        }
+
+        G_SaveWrite(b, &ss, sizeof(ss));
+    }
+}
+
+/* Replaces whatever is running. qfalse if the data is short. */
+qboolean G_ScriptReadState(const byte *data, int len)
+{
+    int count, n, i;
+
+    G_ScriptShutdown();
+    os_tick = (int)(level.time / OS_FrameTime() + 0.5f);
+
+    if (len < (int)sizeof(int))
+        return qfalse;
+    memcpy(&count, data, sizeof(count));
+    if (count < 0 || len < (int)sizeof(int) + count * (int)sizeof(script_save_t))
+        return qfalse;
+
+    for (n = 0; n < count; n++) {
+        script_save_t       ss;
+        script_instance_t   *sc;
+        char                *pool;
+        int                 slot;
+
+        memcpy(&ss, data + sizeof(int) + n * sizeof(ss), sizeof(ss));
+        slot = OS_Load(ss.name, OS_NumEnt(ss.owner));
+        if (slot < 0)
+            continue;
+        sc = &scripts[slot];
+
+        /* A script that changed since the save can't pick up where it was */
+        if (ss.num_symbols != sc->num_symbols || ss.pc < 0 || ss.pc > sc->num_insns ||
+            ss.sp < 0 || ss.sp > MAX_STACK) {
+            gi.dprintf("G_ScriptReadState: %s has changed, restarted\n", sc->name);
+            continue;
+        }
+
+        sc->pc = ss.pc;
+        sc->sp = ss.sp;
+        sc->wait_until = ss.wait_until;
+        sc->wait_ent = OS_NumEnt(ss.wait_ent);
+        sc->current_ent = OS_NumEnt(ss.current_ent);
+        sc->current_gen = sc->current_ent ? G_EdictGeneration(sc->current_ent) : 0;
+
+        for (i = 0; i < sc->num_symbols; i++) {
+            sc->symbols[i].val = ss.symvals[i];
+            if (sc->symbols[i].type == SYM_ENTITY)
+                sc->symbols[i].val.ent = OS_NumEnt(ss.symvals[i].i);
+        }
+
+        pool = (char *)(sc->code + sc->num_insns);
+        for (i = 0; i < sc->sp; i++) {
+            sc->stack[i] = ss.stack[i];
+            if (ss.stack[i].type == 4)
+                sc->stack[i].val.ent = OS_NumEnt(ss.stack[i].val.i);
+            else if (ss.stack[i].type == 3)
+                sc->stack[i].val.s = ss.stack[i].val.i >= 0 ? pool + ss.stack[i].val.i : NULL;
+        }
+
+        OS_Unlink(slot);
+        OS_EntUnlink(slot);
+        OS_Schedule(slot, level.time);
+    }
+
+    return qtrue;
 }
@@ -58,7 +58,6 @@ static void item_precache_sounds(void);
 
 /* Maximum key/value pairs per entity */
 #define MAX_ENTITY_FIELDS   64
-#define MAX_FIELD_VALUE     256
 
 /* ==========================================================================
    Entity Field Types
@@ -72,19 +71,83 @@ typedef enum {
     F_ANGLEHACK    /* angle → angles conversion */
 } fieldtype_t;
 
+/* Keys and values point into the copy of the entity string being spawned,
+   so they are only valid inside the spawn function */
 typedef struct {
-    char    key[64];
-    char    value[MAX_FIELD_VALUE];
+    const char  *key;
+    const char  *value;
+    int         keynum;     /* interned, -1 if the key table was full */
 } epair_t;
 
 /* ==========================================================================
    Entity String Parser
    ========================================================================== */
 
+/*
+ * The entity string is copied once per map and tokenized in place: closing
+ * quotes become terminators and the pairs point at the text. Keys are
+ * interned as they are met, so ED_FindValue compares key numbers instead
+ * of strings, and a key no entity on the map uses is rejected after a
+ * single hash lookup.
+ */
+#define ED_MAX_KEYS     512
+#define ED_KEY_HASH     1024    /* power of two, at least twice ED_MAX_KEYS */
+
+static char         *ed_text;               /* tokenized copy, during spawn */
+static const char   *ed_keys[ED_MAX_KEYS];
+static int          ed_numkeys;
+static short        ed_keyhash[ED_KEY_HASH];    /* ed_keys index + 1, 0 empty */
+static qboolean     ed_keyoverflow;
+
+static unsigned ED_HashString(const char *s)
+{
+    unsigned h = 5381;
+
+    while (*s) {
+        int c = *s++;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        h = h * 33 + (unsigned)c;
+    }
+    return h;
+}
+
+static void ED_ClearKeys(void)
+{
+    ed_numkeys = 0;
+    ed_keyoverflow = qfalse;
+    memset(ed_keyhash, 0, sizeof(ed_keyhash));
+}
+
+/*
+ * Interned number of a key, entering it when add is set. The text must stay
+ * put while the map spawns. -1 if it isn't there or can't be entered.
+ */
+static int ED_KeyNum(const char *key, qboolean add)
+{
+    unsigned h = ED_HashString(key) & (ED_KEY_HASH - 1);
+
+    while (ed_keyhash[h]) {
+        if (!Q_stricmp(ed_keys[ed_keyhash[h] - 1], key))
+            return ed_keyhash[h] - 1;
+        h = (h + 1) & (ED_KEY_HASH - 1);
+    }
+
+    if (!add)
+        return -1;
+    if (ed_numkeys == ED_MAX_KEYS) {
+        ed_keyoverflow = qtrue;
+        return -1;
+    }
+    ed_keys[ed_numkeys] = key;
+    ed_keyhash[h] = (short)++ed_numkeys;
+    return ed_numkeys - 1;
+}
+
 /*
  * Skip whitespace in entity string
  */
-static const char *ED_SkipWhitespace(const char *data)
+static char *ED_SkipWhitespace(char *data)
 {
     while (*data && *data <= ' ')
         data++;
@@ -92,24 +155,19 @@ static const char *ED_SkipWhitespace(const char *data)
 }
 
 /*
- * Parse a quoted string from entity data
- * Returns pointer past the closing quote, fills out with the content
+ * Terminate the quoted string at data in place and point out at it.
+ * Returns the position after it, or NULL if there is no quote.
  */
-static const char *ED_ParseQuotedString(const char *data, char *out, int outsize)
+static char *ED_ParseQuotedString(char *data, const char **out)
 {
-    int len = 0;
-
     if (*data != '"')
-        return data;
-    data++;
-
-    while (*data && *data != '"' && len < outsize - 1) {
-        out[len++] = *data++;
-    }
-    out[len] = '\0';
+        return NULL;
+    *out = ++data;
 
-    if (*data == '"')
+    while (*data && *data != '"')
         data++;
+    if (*data == '"')
+        *data++ = '\0';
 
     return data;
 }
@@ -118,7 +176,7 @@ static const char *ED_ParseQuotedString(const char *data, char *out, int outsize
  * Parse a single entity block from the entity string
  * Returns pointer past the closing brace, fills pairs[] and *num_pairs
  */
-static const char *ED_ParseEntity(const char *data, epair_t *pairs, int *num_pairs)
+static char *ED_ParseEntity(char *data, epair_t *pairs, int *num_pairs)
 {
     *num_pairs = 0;
 
@@ -128,6 +186,8 @@ static const char *ED_ParseEntity(const char *data, epair_t *pairs, int *num_pai
     data++;
 
     while (1) {
+        epair_t *pair;
+
         data = ED_SkipWhitespace(data);
 
         if (*data == '}') {
@@ -140,16 +200,20 @@ static const char *ED_ParseEntity(const char *data, epair_t *pairs, int *num_pai
 
         if (*num_pairs >= MAX_ENTITY_FIELDS)
             return NULL;
+        pair = &pairs[*num_pairs];
 
         /* Parse key */
-        data = ED_ParseQuotedString(data, pairs[*num_pairs].key,
-                                     sizeof(pairs[*num_pairs].key));
+        data = ED_ParseQuotedString(data, &pair->key);
+        if (!data)
+            return NULL;
         data = ED_SkipWhitespace(data);
 
         /* Parse value */
-        data = ED_ParseQuotedString(data, pairs[*num_pairs].value,
-                                     sizeof(pairs[*num_pairs].value));
+        data = ED_ParseQuotedString(data, &pair->value);
+        if (!data)
+            return NULL;
 
+        pair->keynum = ED_KeyNum(pair->key, qtrue);
         (*num_pairs)++;
     }
 }
@@ -159,9 +223,21 @@ static const char *ED_ParseEntity(const char *data, epair_t *pairs, int *num_pai
  */
 static const char *ED_FindValue(epair_t *pairs, int num_pairs, const char *key)
 {
-    int i;
+    int i, keynum = ED_KeyNum(key, qfalse);
+
+    if (keynum >= 0) {
+        for (i = 0; i < num_pairs; i++) {
+            if (pairs[i].keynum == keynum)
+                return pairs[i].value;
+        }
+        return NULL;
+    }
+
+    /* Not on this map, unless it didn't fit */
+    if (!ed_keyoverflow)
+        return NULL;
     for (i = 0; i < num_pairs; i++) {
-        if (Q_stricmp(pairs[i].key, key) == 0)
+        if (pairs[i].keynum < 0 && Q_stricmp(pairs[i].key, key) == 0)
             return pairs[i].value;
     }
     return NULL;
@@ -973,41 +1049,221 @@ static spawn_func_t spawn_funcs[] = {
     { NULL, NULL }
 };
 
+/*
+ * Classname to spawn_funcs index, built on first use. Where the table
+ * names a class twice the first entry wins, as the linear search did.
+ */
+#define SPAWN_HASH      512     /* power of two, at least twice the table */
+
+static short    spawn_hash[SPAWN_HASH];     /* spawn_funcs index + 1, 0 empty */
+static qboolean spawn_hashed;
+
+static void ED_HashSpawnFuncs(void)
+{
+    int i;
+
+    memset(spawn_hash, 0, sizeof(spawn_hash));
+    for (i = 0; spawn_funcs[i].classname; i++) {
+        unsigned h = ED_HashString(spawn_funcs[i].classname) & (SPAWN_HASH - 1);
+
+        while (spawn_hash[h] &&
+               Q_stricmp(spawn_funcs[spawn_hash[h] - 1].classname, spawn_funcs[i].classname))
+            h = (h + 1) & (SPAWN_HASH - 1);
+        if (!spawn_hash[h])
+            spawn_hash[h] = (short)(i + 1);
+    }
+    spawn_hashed = qtrue;
+}
+
+static const spawn_func_t *ED_FindSpawnFunc(const char *classname)
+{
+    unsigned h;
+
+    if (!spawn_hashed)
+        ED_HashSpawnFuncs();
+
+    h = ED_HashString(classname) & (SPAWN_HASH - 1);
+    while (spawn_hash[h]) {
+        const spawn_func_t *sf = &spawn_funcs[spawn_hash[h] - 1];
+        if (!Q_stricmp(sf->classname, classname))
+            return sf;
+        h = (h + 1) & (SPAWN_HASH - 1);
+    }
+    return NULL;
+}
+
 /* ==========================================================================
    Entity Allocation
    ========================================================================== */
 
 extern game_export_t globals;
 
+/*
+ * Freed edicts wait in a queue, oldest first, until EDICT_REUSE_DELAY has
+ * passed: a slot handed straight back out would reach clients as the old
+ * entity teleporting and changing model. Fresh slots past num_edicts are
+ * used while the oldest free one is still waiting, and only once the
+ * array is full does a slot get reused early. The queue holds entity
+ * numbers, outside edict_t, since G_AllocEdict clears the whole entity.
+ */
+#define EDICT_REUSE_DELAY   2.0f    /* seconds, as Quake II */
+
+static int      edict_queue[MAX_EDICTS];    /* ring of freed entity numbers */
+static int      edict_qhead, edict_qcount;
+static float    edict_freetime[MAX_EDICTS];
+static byte     edict_queued[MAX_EDICTS];
+static int      edict_generation[MAX_EDICTS];   /* bumped on every allocation */
+
+static struct {
+    int     allocs, frees, early;           /* since the last frame */
+    int     last_allocs, last_frees, last_early, last_live;
+    int     peak_live;
+    int     frames;
+} edict_stats;
+
+/*
+ * G_ClearEdictPool - Forget every freed slot. Called when the entity
+ * array is cleared for a new level.
+ */
+void G_ClearEdictPool(void)
+{
+    edict_qhead = edict_qcount = 0;
+    memset(edict_queued, 0, sizeof(edict_queued));
+    memset(&edict_stats, 0, sizeof(edict_stats));
+}
+
+/*
+ * G_EdictFreed - Queue a free slot for reuse. G_FreeEdict calls this, and
+ * so does the RunFrame pass for entities freed by clearing inuse in place;
+ * a slot already queued is left where it is.
+ */
+void G_EdictFreed(edict_t *ent)
+{
+    extern cvar_t *maxclients;
+    int num = (int)(ent - globals.edicts);
+
+    if (num <= (int)maxclients->value || num >= MAX_EDICTS || edict_queued[num])
+        return;
+
+    edict_queued[num] = 1;
+    edict_freetime[num] = level.time;
+    edict_queue[(edict_qhead + edict_qcount) % MAX_EDICTS] = num;
+    edict_qcount++;
+    edict_stats.frees++;
+
+    /* Scripts sleeping on it would never be woken otherwise */
+    G_ScriptSignal(ent);
+}
+
+static int G_DequeueEdict(void)
+{
+    int num = edict_queue[edict_qhead];
+
+    edict_qhead = (edict_qhead + 1) % MAX_EDICTS;
+    edict_qcount--;
+    edict_queued[num] = 0;
+    return num;
+}
+
+/*
+ * G_EdictGeneration - Changes whenever the slot is handed out again, so a
+ * saved (entity, generation) pair can tell the entity it named has gone.
+ * Never reset, not even between levels.
+ */
+int G_EdictGeneration(edict_t *ent)
+{
+    int num = (int)(ent - globals.edicts);
+
+    if (num < 0 || num >= MAX_EDICTS)
+        return 0;
+    return edict_generation[num];
+}
+
+/*
+ * G_EdictFrameEnd - Roll this frame's counters over; live is the number of
+ * entities in use, as counted by the RunFrame pass.
+ */
+void G_EdictFrameEnd(int live)
+{
+    edict_stats.last_allocs = edict_stats.allocs;
+    edict_stats.last_frees = edict_stats.frees;
+    edict_stats.last_early = edict_stats.early;
+    edict_stats.last_live = live;
+    if (live > edict_stats.peak_live)
+        edict_stats.peak_live = live;
+    edict_stats.allocs = edict_stats.frees = edict_stats.early = 0;
+    edict_stats.frames++;
+}
+
+/* "sv edicts" */
+void G_EdictStats_f(void)
+{
+    gi.dprintf("edicts: %d live, %d allocated, %d freed last frame\n",
+               edict_stats.last_live, edict_stats.last_allocs,
+               edict_stats.last_frees);
+    gi.dprintf("%d of %d slots used, %d waiting for reuse, peak %d live "
+               "(over %d frames)\n", globals.num_edicts, globals.max_edicts,
+               edict_qcount, edict_stats.peak_live, edict_stats.frames);
+    if (edict_stats.last_early)
+        gi.dprintf("%d slots reused early last frame\n", edict_stats.last_early);
+}
+
 edict_t *G_AllocEdict(void)
 {
-    int i;
+    int i = -1;
     edict_t *e;
-    int maxclients;
+    extern cvar_t *maxclients;
 
-    /* Get maxclients from cvar */
-    {
-        cvar_t *mc = gi.cvar("maxclients", "8", 0);
-        maxclients = (int)mc->value;
+    /* Oldest freed slot, once it has waited long enough. The first
+       seconds of a level free and allocate a lot, so don't wait then. */
+    while (edict_qcount > 0) {
+        int num = edict_queue[edict_qhead];
+
+        if (num >= globals.max_edicts || globals.edicts[num].inuse) {
+            G_DequeueEdict();   /* taken by a scan below */
+            continue;
+        }
+        if (level.time < EDICT_REUSE_DELAY ||
+            edict_freetime[num] + EDICT_REUSE_DELAY <= level.time)
+            i = G_DequeueEdict();
+        break;
     }
 
-    /* Find first free edict after clients */
-    for (i = maxclients + 1; i < globals.max_edicts; i++) {
-        e = &globals.edicts[i];
-        if (!e->inuse) {
-            memset(e, 0, sizeof(*e));
-            e->s.number = i;
-            e->inuse = qtrue;
+    /* A slot never used this level */
+    if (i < 0 && globals.num_edicts < globals.max_edicts)
+        i = globals.num_edicts;
 
-            if (i >= globals.num_edicts)
-                globals.num_edicts = i + 1;
+    /* Full: reuse one that's still waiting */
+    if (i < 0 && edict_qcount > 0) {
+        i = G_DequeueEdict();
+        edict_stats.early++;
+    }
 
-            return e;
+    /* Freed in place since the last RunFrame pass */
+    if (i < 0) {
+        for (i = (int)maxclients->value + 1; i < globals.max_edicts; i++) {
+            if (!globals.edicts[i].inuse)
+                break;
+        }
+        if (i == globals.max_edicts) {
+            gi.error("G_AllocEdict: no free edicts (max=%d)", globals.max_edicts);
+            return NULL;
         }
     }
 
-    gi.error("G_AllocEdict: no free edicts (max=%d)", globals.max_edicts);
-    return NULL;
+    e = &globals.edicts[i];
+    memset(e, 0, sizeof(*e));
+    e->s.number = i;
+    e->inuse = qtrue;
+    if (i < MAX_EDICTS)
+        edict_generation[i]++;
+
+    if (i >= globals.num_edicts)
+        globals.num_edicts = i + 1;
+
+    edict_stats.allocs++;
+    G_PendingEdict(e);
+    return e;
 }
 
 /* ==========================================================================
@@ -2238,34 +2494,25 @@ static void SP_func_plat(edict_t *ent, epair_t *pairs, int num_pairs)
 /* Kill entities matching killtarget field */
 static void G_KillTargets(const char *killtarget)
 {
-    int i;
+    edict_t *t;
     if (!killtarget || !killtarget[0]) return;
 
-    for (i = 0; i < globals.max_edicts; i++) {
-        edict_t *t = &globals.edicts[i];
-        if (!t->inuse || !t->targetname)
-            continue;
-        if (Q_stricmp(t->targetname, killtarget) == 0) {
-            t->inuse = qfalse;
-            gi.unlinkentity(t);
-        }
+    for (t = NULL; (t = G_FindTargetname(t, killtarget)) != NULL; ) {
+        t->inuse = qfalse;
+        gi.unlinkentity(t);
     }
 }
 
 /* Find entities by targetname and call their use() */
 static void G_UseTargets(edict_t *activator, const char *target)
 {
-    int i;
+    edict_t *t;
     if (!target || !target[0]) return;
 
-    for (i = 0; i < globals.max_edicts; i++) {
-        edict_t *t = &globals.edicts[i];
-        if (!t->inuse || !t->targetname)
-            continue;
-        if (Q_stricmp(t->targetname, target) == 0) {
-            if (t->use)
-                t->use(t, activator, activator);
-        }
+    for (t = NULL; (t = G_FindTargetname(t, target)) != NULL; ) {
+        if (t->use)
+            t->use(t, activator, activator);
+        G_ScriptSignal(t);
     }
 }
 
@@ -2530,15 +2777,7 @@ static void SP_env_acid(edict_t *ent, epair_t *pairs, int num_pairs)
 
 static edict_t *G_FindByTargetname(const char *targetname)
 {
-    extern game_export_t globals;
-    int i;
-    for (i = 0; i < globals.num_edicts; i++) {
-        edict_t *e = &globals.edicts[i];
-        if (e->inuse && e->targetname &&
-            Q_stricmp(e->targetname, targetname) == 0)
-            return e;
-    }
-    return NULL;
+    return G_FindTargetname(NULL, targetname);
 }
 
 static void teleport_touch(edict_t *self, edict_t *other, void *plane, csurface_t *surf)
@@ -3372,17 +3611,14 @@ static void explosive_die(edict_t *self, edict_t *inflictor, edict_t *attacker,
     /* Chain reaction: trigger nearby explosive barrels */
     {
         extern game_export_t globals;
-        int ci;
-        for (ci = 1; ci < globals.num_edicts; ci++) {
-            edict_t *other = &globals.edicts[ci];
+        edict_t *other;
+        for (other = NULL; (other = G_FindClassname(other, "func_explosive")) != NULL; ) {
             vec3_t cdiff;
             float cdist;
-            if (!other->inuse || other == self || other->health <= 0)
+            if (other == self || other->health <= 0)
                 continue;
             if (!other->die || other->takedamage != DAMAGE_YES)
                 continue;
-            if (!other->classname || Q_stricmp(other->classname, "func_explosive") != 0)
-                continue;
             VectorSubtract(other->s.origin, self->s.origin, cdiff);
             cdist = VectorLength(cdiff);
             if (cdist < 256.0f) {
@@ -4571,8 +4807,8 @@ static void item_touch(edict_t *self, edict_t *other, void *plane, csurface_t *s
 
     /* Deathmatch: hide and schedule respawn; SP: remove permanently */
     {
-        cvar_t *dm = gi.cvar("deathmatch", "0", 0);
-        if (dm && dm->value) {
+        extern cvar_t *deathmatch;
+        if (deathmatch && deathmatch->value) {
         self->solid = SOLID_NOT;
         self->svflags |= SVF_NOCLIENT;   /* hide from rendering */
         gi.unlinkentity(self);
@@ -6507,9 +6743,6 @@ static void SP_func_zipline(edict_t *ent, epair_t *pairs, int num_pairs)
 
 static void elevator_call_use(edict_t *self, edict_t *other, edict_t *activator)
 {
-    extern game_export_t globals;
-    int i;
-
     (void)other;
 
     if (!activator || !activator->client)
@@ -6523,15 +6756,9 @@ static void elevator_call_use(edict_t *self, edict_t *other, edict_t *activator)
 
     /* Find and activate the targeted elevator */
     if (self->target && self->target[0]) {
-        for (i = 1; i < globals.num_edicts; i++) {
-            edict_t *e = &globals.edicts[i];
-            if (e->inuse && e->targetname && e->targetname[0] &&
-                Q_stricmp(e->targetname, self->target) == 0) {
-                if (e->use)
-                    e->use(e, self, activator);
-                break;
-            }
-        }
+        edict_t *e = G_FindTargetname(NULL, self->target);
+        if (e && e->use)
+            e->use(e, self, activator);
     }
 
     self->dmg_debounce_time = level.time + self->wait;
@@ -7209,6 +7436,7 @@ static void SP_cover_point(edict_t *ent, epair_t *pairs, int num_pairs)
     ent->movetype = MOVETYPE_NONE;
     ent->svflags |= SVF_NOCLIENT;  /* invisible marker */
     gi.linkentity(ent);
+    gi.nav_addcover(ent->s.origin);
     gi.dprintf("  cover_point at (%.0f %.0f %.0f)\n",
                ent->s.origin[0], ent->s.origin[1], ent->s.origin[2]);
 }
@@ -8280,14 +8508,9 @@ static void fire_spread_think(edict_t *self)
 /* Attach fire spread behavior to trigger_hazard entities with "fire" message */
 void G_InitFireSpread(void)
 {
-    extern game_export_t globals;
-    int i;
-    for (i = 1; i < globals.num_edicts; i++) {
-        edict_t *e = &globals.edicts[i];
-        if (!e->inuse)
-            continue;
-        if (e->classname && Q_stricmp(e->classname, "trigger_hazard") == 0 &&
-            e->message && (strstr(e->message, "fire") || strstr(e->message, "flame"))) {
+    edict_t *e;
+    for (e = NULL; (e = G_FindClassname(e, "trigger_hazard")) != NULL; ) {
+        if (e->message && (strstr(e->message, "fire") || strstr(e->message, "flame"))) {
             e->think = fire_spread_think;
             e->nextthink = level.time + 3.0f;  /* start spreading after 3s */
         }
@@ -8512,13 +8735,9 @@ static void pillar_die(edict_t *self, edict_t *inflictor, edict_t *attacker,
 
     /* Fire targets */
     if (self->target) {
-        extern game_export_t globals;
-        int j;
-        for (j = 1; j < globals.num_edicts; j++) {
-            edict_t *t = &globals.edicts[j];
-            if (!t->inuse || !t->targetname)
-                continue;
-            if (Q_stricmp(t->targetname, self->target) == 0 && t->use)
+        edict_t *t;
+        for (t = NULL; (t = G_FindTargetname(t, self->target)) != NULL; ) {
+            if (t->use)
                 t->use(t, self, self);
         }
     }
@@ -8594,13 +8813,9 @@ static void fence_die(edict_t *self, edict_t *inflictor, edict_t *attacker,
 
     /* Fire targets */
     if (self->target) {
-        extern game_export_t globals;
-        int j;
-        for (j = 1; j < globals.num_edicts; j++) {
-            edict_t *t = &globals.edicts[j];
-            if (!t->inuse || !t->targetname)
-                continue;
-            if (Q_stricmp(t->targetname, self->target) == 0 && t->use)
+        edict_t *t;
+        for (t = NULL; (t = G_FindTargetname(t, self->target)) != NULL; ) {
+            if (t->use)
                 t->use(t, self, self);
         }
     }
@@ -8729,15 +8944,10 @@ static void extraction_touch(edict_t *self, edict_t *other, void *plane,
 
     /* Trigger any target entities */
     if (self->target) {
-        extern game_export_t globals;
-        int ei;
-        for (ei = 1; ei < globals.num_edicts; ei++) {
-            edict_t *t = &globals.edicts[ei];
-            if (t->inuse && t->targetname &&
-                Q_stricmp(t->targetname, self->target) == 0) {
-                if (t->use)
-                    t->use(t, self, other);
-            }
+        edict_t *t;
+        for (t = NULL; (t = G_FindTargetname(t, self->target)) != NULL; ) {
+            if (t->use)
+                t->use(t, self, other);
         }
     }
 
@@ -8809,13 +9019,10 @@ static void alarm_touch(edict_t *self, edict_t *other, void *plane,
 
     /* Trigger any linked entities (spawn points, etc.) */
     if (self->target) {
-        for (ai = 1; ai < globals.num_edicts; ai++) {
-            edict_t *t = &globals.edicts[ai];
-            if (t->inuse && t->targetname &&
-                Q_stricmp(t->targetname, self->target) == 0) {
-                if (t->use)
-                    t->use(t, self, other);
-            }
+        edict_t *t;
+        for (t = NULL; (t = G_FindTargetname(t, self->target)) != NULL; ) {
+            if (t->use)
+                t->use(t, self, other);
         }
     }
 }
@@ -12692,20 +12899,27 @@ void G_SpawnEntities(const char *mapname, const char *entstring,
 {
     epair_t     pairs[MAX_ENTITY_FIELDS];
     int         num_pairs;
-    const char  *data;
+    char        *data;
     int         entity_count = 0;
     int         spawned_count = 0;
+    int         len;
 
     (void)spawnpoint;
 
     gi.dprintf("SpawnEntities: %s\n", mapname);
 
-    data = entstring;
-    if (!data || !data[0]) {
+    if (!entstring || !entstring[0]) {
         gi.dprintf("  No entity string\n");
         return;
     }
 
+    /* One copy for the whole map, tokenized in place */
+    len = (int)strlen(entstring);
+    ed_text = (char *)gi.TagMalloc(len + 1, Z_TAG_GAME);
+    memcpy(ed_text, entstring, len + 1);
+    ED_ClearKeys();
+    data = ed_text;
+
     while (1) {
         data = ED_SkipWhitespace(data);
         if (!*data)
@@ -12720,9 +12934,8 @@ void G_SpawnEntities(const char *mapname, const char *entstring,
         /* Find classname */
         {
             const char  *classname;
-            int         i;
+            const spawn_func_t *sf;
             edict_t     *ent;
-            qboolean    found;
 
             classname = ED_FindValue(pairs, num_pairs, "classname");
             if (!classname) {
@@ -12750,23 +12963,23 @@ void G_SpawnEntities(const char *mapname, const char *entstring,
             }
 
             /* Find and call spawn function */
-            found = qfalse;
-            for (i = 0; spawn_funcs[i].classname; i++) {
-                if (Q_stricmp(classname, spawn_funcs[i].classname) == 0) {
-                    spawn_funcs[i].spawn(ent, pairs, num_pairs);
-                    found = qtrue;
-                    spawned_count++;
-                    break;
-                }
-            }
-
-            if (!found) {
+            sf = ED_FindSpawnFunc(classname);
+            if (sf) {
+                sf->spawn(ent, pairs, num_pairs);
+                spawned_count++;
+            } else {
                 /* Unknown entity type — keep it but log */
                 Com_DPrintf("  Unknown classname: %s\n", classname);
                 spawned_count++;
             }
+            G_IndexEdict(ent);
         }
     }
 
+    /* The pairs pointed into it */
+    gi.TagFree(ed_text);
+    ed_text = NULL;
+    ED_ClearKeys();
+
     gi.dprintf("  %d entities parsed, %d spawned\n", entity_count, spawned_count);
 }
@@ -134,6 +134,54 @@ typedef struct {
     qboolean        active;
 } ghoul_bolton_t;
 
+/* ==========================================================================
+   Skeleton and Skinning
+
+   A rig is a bone hierarchy plus a mesh bound to it, one bone per vertex.
+   The GHB mesh and GSQ sequence blocks aren't decoded yet, so every model
+   uses the built-in proxy humanoid: a box per bone, posed procedurally.
+   The renderer only sees the rig, so real meshes can take its place.
+   ========================================================================== */
+
+#define GHOUL_MAX_BONES     24
+
+typedef struct {
+    char            name[32];
+    int             parent;         /* -1 for the root; parents come first */
+    vec3_t          bindpos;        /* joint in model space, bind pose */
+    vec3_t          mins, maxs;     /* proxy box, model space */
+    gore_zone_id_t  zone;
+    uint32_t        hide_mask;      /* severing any of these zones hides it */
+    uint32_t        damage_mask;    /* damage to any of these shows on it */
+} ghoul_bone_t;
+
+typedef struct {
+    float           xyz[3];
+    float           normal[3];
+    int             bone;
+} ghoul_vert_t;
+
+typedef struct {
+    const ghoul_bone_t  *bones;
+    int                 num_bones;
+    const ghoul_vert_t  *verts;
+    int                 num_verts;
+    const uint16_t      *indices;
+    int                 num_indices;
+} ghoul_rig_t;
+
+/* 3x4 affine bone matrix, rows: v' = m * (v, 1) */
+typedef struct {
+    float           m[3][4];
+} ghoul_bonemat_t;
+
+typedef struct {
+    float           phase;          /* walk cycle, radians */
+    float           stride;         /* 0 = standing .. 1 = running */
+    qboolean        dead;
+    qboolean        armed;          /* right arm raised to hold a weapon */
+} ghoul_pose_t;
+
 /* ==========================================================================
    Skin / Material Assignment
    ========================================================================== */
@@ -157,7 +205,7 @@ typedef struct ghoul_model_s {
     char            base_dir[MAX_QPATH];    /* e.g., "enemy/meso" */
 
     /* GHB data (loaded from PAK) */
-    byte            *ghb_data;
+    const byte      *ghb_data;      /* read-only view from FS_MapFile */
     int             ghb_size;
     qboolean        loaded;
 
@@ -169,6 +217,11 @@ typedef struct ghoul_model_s {
 
     /* Gore zones */
     ghoul_zone_state_t  zones[GORE_NUM_ZONES];
+    uint32_t        zone_damaged;   /* bit per gore_zone_id_t */
+    uint32_t        zone_severed;
+
+    /* Skeleton the renderer poses */
+    const ghoul_rig_t *rig;
 
     /* Bolt-on attachments */
     ghoul_bolton_t  boltons[GHOUL_MAX_BOLTONS];
@@ -259,6 +312,16 @@ void    M32_FreeTexture(byte *data);
 void    GHOUL_AttachBolton(ghoul_model_t *model, const ghoul_bolton_t *bolton);
 void    GHOUL_DetachBolton(ghoul_model_t *model, int index);
 
+/* Skeleton and skinning. All of these are pure and safe on any thread
+   once GHOUL_HumanoidRig has been called once. */
+const ghoul_rig_t *GHOUL_HumanoidRig(void);
+const ghoul_rig_t *GHOUL_BoltonRig(void);
+int     GHOUL_FindBone(const ghoul_rig_t *rig, const char *name);
+void    GHOUL_ComputePalette(const ghoul_rig_t *rig, const ghoul_pose_t *pose,
+                             const ghoul_bonemat_t *model, ghoul_bonemat_t *palette);
+void    GHOUL_BoltMatrix(const ghoul_rig_t *rig, const ghoul_bonemat_t *palette,
+                         int bone, float scale, ghoul_bonemat_t *out);
+
 /* Known bolt points (from binary analysis of GHOUL_SetupBolts at 0x96C82) */
 /*
  * FORCED_CAMERA      — Camera attachment point
@@ -91,6 +91,8 @@ void GHOUL_ResetZones(ghoul_model_t *model)
         model->zones[i].damage_level = 0;
         model->zones[i].wound_count = 0;
     }
+    model->zone_damaged = 0;
+    model->zone_severed = 0;
 }
 
 void GHOUL_DamageZone(ghoul_model_t *model, gore_zone_id_t zone, int damage)
@@ -109,6 +111,7 @@ void GHOUL_DamageZone(ghoul_model_t *model, gore_zone_id_t zone, int damage)
     z->health -= damage;
     z->damaged = qtrue;
     z->wound_count++;
+    model->zone_damaged |= 1u << zone;
 
     /* Determine damage level */
     if (z->health > 70)
@@ -150,6 +153,7 @@ void GHOUL_SeverZone(ghoul_model_t *model, gore_zone_id_t zone)
     model->zones[zone].severed = qtrue;
     model->zones[zone].health = 0;
     model->zones[zone].damage_level = 3;
+    model->zone_severed |= 1u << zone;
 
     Com_DPrintf("GHOUL: %s — %s SEVERED!\n",
         model->name, GHOUL_ZoneName(zone));
@@ -194,30 +198,32 @@ void GHOUL_SeverZone(ghoul_model_t *model, gore_zone_id_t zone)
 
 ghoul_model_t *GHOUL_LoadGHB(const char *filename)
 {
-    byte            *raw;
+    const byte      *raw;
     int             len;
     ghoul_model_t   *model;
-    ghb_file_header_t *hdr;
+    const ghb_file_header_t *hdr;
 
-    len = FS_LoadFile(filename, (void **)&raw);
+    /* Mapped read-only view; the model keeps it for mesh/animation access */
+    len = FS_MapFile(filename, (const void **)&raw);
     if (!raw || len < (int)sizeof(ghb_file_header_t)) {
         Com_Printf("GHOUL_LoadGHB: can't load %s\n", filename);
+        FS_UnmapFile(raw);
         return NULL;
     }
 
-    hdr = (ghb_file_header_t *)raw;
+    hdr = (const ghb_file_header_t *)raw;
 
     /* Validate magic */
     if (LittleLong(hdr->magic) != GHB_MAGIC) {
         Com_Printf("Not a ghb file %s\n", filename);
-        FS_FreeFile(raw);
+        FS_UnmapFile(raw);
         return NULL;
     }
 
     /* Validate version */
     if (LittleLong(hdr->version) != GHB_VERSION) {
         Com_Printf("Old file %s\n", filename);
-        FS_FreeFile(raw);
+        FS_UnmapFile(raw);
         return NULL;
     }
 
@@ -231,7 +237,7 @@ ghoul_model_t *GHOUL_LoadGHB(const char *filename)
     {
         int path_off = LittleLong(hdr->path_offset);
         if (path_off > 0 && path_off < len) {
-            char *src = (char *)(raw + path_off);
+            const char *src = (const char *)(raw + path_off);
             /* Safely copy null-terminated path */
             int maxlen = len - path_off;
             if (maxlen > (int)sizeof(model->base_dir) - 1)
@@ -245,19 +251,22 @@ ghoul_model_t *GHOUL_LoadGHB(const char *filename)
 
     /* Read extended header fields if file is large enough */
     if (len >= 0x5C) {
-        uint32_t *u32 = (uint32_t *)raw;
+        const uint32_t *u32 = (const uint32_t *)raw;
         model->num_bones = LittleLong(u32[0x44 / 4]);
         model->num_skins = LittleLong(u32[0x48 / 4]);
 
-        float *flt = (float *)raw;
+        const float *flt = (const float *)raw;
         model->bounding_radius = LittleFloat(flt[0x58 / 4]);
     }
 
     /* Keep the raw GHB data for mesh/animation access */
-    model->ghb_data = raw;  /* Note: caller must not call FS_FreeFile */
+    model->ghb_data = raw;  /* Note: released by GHOUL_FreeModel via FS_UnmapFile */
     model->ghb_size = len;
     model->loaded = qtrue;
 
+    /* The mesh blocks aren't decoded yet: pose the proxy humanoid */
+    model->rig = GHOUL_HumanoidRig();
+
     /* Initialize gore zones */
     GHOUL_ResetZones(model);
 
@@ -273,7 +282,7 @@ void GHOUL_FreeModel(ghoul_model_t *model)
         return;
 
     if (model->ghb_data) {
-        FS_FreeFile(model->ghb_data);
+        FS_UnmapFile(model->ghb_data);
         model->ghb_data = NULL;
     }
 
@@ -539,3 +548,325 @@ void GHOUL_DetachBolton(ghoul_model_t *model, int index)
 
     model->num_boltons--;
 }
+
+/* ==========================================================================
+   Proxy Rigs
+
+   The humanoid has seventeen bones with a box each. It faces +X, +Y is its
+   left and its feet are at z = 0. A limb bone hides when any zone above it
+   in the chain is severed, so losing an upper arm takes the forearm and
+   hand too, matching the cascade in GHOUL_SeverZone. The torso never hides.
+   ========================================================================== */
+
+enum {
+    HB_PELVIS, HB_SPINE, HB_CHEST, HB_NECK, HB_HEAD,
+    HB_UPPERARM_R, HB_FOREARM_R, HB_HAND_R,
+    HB_UPPERARM_L, HB_FOREARM_L, HB_HAND_L,
+    HB_THIGH_R, HB_CALF_R, HB_FOOT_R,
+    HB_THIGH_L, HB_CALF_L, HB_FOOT_L,
+    HB_NUM_BONES
+};
+
+#define ZB(z)   (1u << GORE_ZONE_##z)
+
+static const ghoul_bone_t humanoid_bones[HB_NUM_BONES] = {
+    { "pelvis",      -1,            {0,    0, 24}, {-4,   -5,   21}, {4,    5,    27},
+      GORE_ZONE_GROIN, 0, ZB(GROIN) | ZB(BUTT) | ZB(HIP_R) | ZB(HIP_L) },
+    { "spine",       HB_PELVIS,     {0,    0, 27}, {-3.5f,-5.5f,27}, {3.5f, 5.5f, 36},
+      GORE_ZONE_STOMACH, 0, ZB(STOMACH) | ZB(CHEST_LOWER) | ZB(BACK_LOWER) },
+    { "chest",       HB_SPINE,      {0,    0, 36}, {-4,   -6,   36}, {4,    6,    48},
+      GORE_ZONE_CHEST_UPPER, 0, ZB(CHEST_UPPER) | ZB(BACK_UPPER) },
+    { "neck",        HB_CHEST,      {0,    0, 48}, {-1.5f,-1.5f,48}, {1.5f, 1.5f, 50},
+      GORE_ZONE_NECK, ZB(NECK), ZB(NECK) },
+    { "head",        HB_NECK,       {0,    0, 50}, {-4,   -4,   50}, {4,    4,    58},
+      GORE_ZONE_HEAD, ZB(NECK) | ZB(HEAD), ZB(HEAD) | ZB(FACE) },
+
+    { "upperarm_r",  HB_CHEST,      {0,-7.5f, 47}, {-1.5f,-9,   37}, {1.5f,-6,    48},
+      GORE_ZONE_ARM_UPPER_R, ZB(ARM_UPPER_R), ZB(ARM_UPPER_R) | ZB(SHOULDER_R) },
+    { "forearm_r",   HB_UPPERARM_R, {0,-7.5f, 37}, {-1.5f,-9,   29}, {1.5f,-6,    37},
+      GORE_ZONE_ARM_LOWER_R, ZB(ARM_UPPER_R) | ZB(ARM_LOWER_R), ZB(ARM_LOWER_R) },
+    { "hand_r",      HB_FOREARM_R,  {0,-7.5f, 29}, {-1.5f,-8.5f,26}, {1.5f,-6.5f, 29},
+      GORE_ZONE_HAND_R, ZB(ARM_UPPER_R) | ZB(ARM_LOWER_R) | ZB(HAND_R), ZB(HAND_R) },
+
+    { "upperarm_l",  HB_CHEST,      {0, 7.5f, 47}, {-1.5f, 6,   37}, {1.5f, 9,    48},
+      GORE_ZONE_ARM_UPPER_L, ZB(ARM_UPPER_L), ZB(ARM_UPPER_L) | ZB(SHOULDER_L) },
+    { "forearm_l",   HB_UPPERARM_L, {0, 7.5f, 37}, {-1.5f, 6,   29}, {1.5f, 9,    37},
+      GORE_ZONE_ARM_LOWER_L, ZB(ARM_UPPER_L) | ZB(ARM_LOWER_L), ZB(ARM_LOWER_L) },
+    { "hand_l",      HB_FOREARM_L,  {0, 7.5f, 29}, {-1.5f, 6.5f,26}, {1.5f, 8.5f, 29},
+      GORE_ZONE_HAND_L, ZB(ARM_UPPER_L) | ZB(ARM_LOWER_L) | ZB(HAND_L), ZB(HAND_L) },
+
+    { "thigh_r",     HB_PELVIS,     {0,   -3, 22}, {-2,   -5,   12}, {2,   -1,    22},
+      GORE_ZONE_LEG_UPPER_R, ZB(LEG_UPPER_R), ZB(LEG_UPPER_R) },
+    { "calf_r",      HB_THIGH_R,    {0,   -3, 12}, {-2,   -5,    3}, {2,   -1,    12},
+      GORE_ZONE_LEG_LOWER_R, ZB(LEG_UPPER_R) | ZB(LEG_LOWER_R), ZB(LEG_LOWER_R) },
+    { "foot_r",      HB_CALF_R,     {0,   -3,  3}, {-2,   -5,    0}, {4,   -1,     3},
+      GORE_ZONE_FOOT_R, ZB(LEG_UPPER_R) | ZB(LEG_LOWER_R) | ZB(FOOT_R), ZB(FOOT_R) },
+
+    { "thigh_l",     HB_PELVIS,     {0,    3, 22}, {-2,    1,   12}, {2,    5,    22},
+      GORE_ZONE_LEG_UPPER_L, ZB(LEG_UPPER_L), ZB(LEG_UPPER_L) },
+    { "calf_l",      HB_THIGH_L,    {0,    3, 12}, {-2,    1,    3}, {2,    5,    12},
+      GORE_ZONE_LEG_LOWER_L, ZB(LEG_UPPER_L) | ZB(LEG_LOWER_L), ZB(LEG_LOWER_L) },
+    { "foot_l",      HB_CALF_L,     {0,    3,  3}, {-2,    1,    0}, {4,    5,     3},
+      GORE_ZONE_FOOT_L, ZB(LEG_UPPER_L) | ZB(LEG_LOWER_L) | ZB(FOOT_L), ZB(FOOT_L) },
+};
+
+/* GPM/GBM bolt points the proxy skeleton knows */
+static const struct {
+    const char  *name;
+    int         bone;
+} humanoid_bolts[] = {
+    { "wbolt_hand_r",       HB_HAND_R },
+    { "to_wbolt_hand_r",    HB_HAND_R },
+    { "wbolt_hand_l",       HB_HAND_L },
+    { "to_wbolt_hand_l",    HB_HAND_L },
+    { "B_BOLT1",            HB_CHEST },
+};
+
+/*
+ * Bolt-ons hang off a single bone at the bolt point. The proxy is a rifle
+ * laid along the hand's -Z, which the armed pose turns to point forward.
+ */
+static const ghoul_bone_t bolton_bones[1] = {
+    { "bolt", -1, {0, 0, 0}, {-1, -1, -13}, {2, 1, -1}, GORE_ZONE_HAND_R, 0, 0 },
+};
+
+static const float bolton_boxes[][2][3] = {
+    { {-1,    -1,    -13}, {2,    1,    -1} },     /* receiver */
+    { { 0,    -0.5f, -22}, {1.2f, 0.5f, -13} },    /* barrel */
+    { {-5,    -0.75f, -8}, {-1,   0.75f, -5} },    /* magazine */
+    { {-0.5f, -1,     -1}, {1.5f, 1,     4} },     /* stock, along the forearm */
+};
+
+#define BOLTON_BOXES    (int)(sizeof(bolton_boxes) / sizeof(bolton_boxes[0]))
+
+static ghoul_vert_t humanoid_verts[HB_NUM_BONES * 24];
+static uint16_t     humanoid_indices[HB_NUM_BONES * 36];
+static ghoul_vert_t bolton_verts[BOLTON_BOXES * 24];
+static uint16_t     bolton_indices[BOLTON_BOXES * 36];
+
+static ghoul_rig_t  humanoid_rig;
+static ghoul_rig_t  bolton_rig;
+static qboolean     rigs_built;
+
+/* Six flat-shaded quads, wound counter-clockwise seen from outside */
+static void GHOUL_AddBox(ghoul_rig_t *rig, ghoul_vert_t *verts, uint16_t *indices,
+                         const float *mins, const float *maxs, int bone)
+{
+    int axis, side, k;
+
+    for (axis = 0; axis < 3; axis++) {
+        int u = (axis + 1) % 3, w = (axis + 2) % 3;
+
+        for (side = 0; side < 2; side++) {
+            static const int    order[2][4][2] = {
+                { {0, 0}, {0, 1}, {1, 1}, {1, 0} },     /* -axis */
+                { {0, 0}, {1, 0}, {1, 1}, {0, 1} },     /* +axis */
+            };
+            int                 base = rig->num_verts;
+
+            for (k = 0; k < 4; k++) {
+                ghoul_vert_t *v = &verts[rig->num_verts++];
+
+                v->xyz[axis] = side ? maxs[axis] : mins[axis];
+                v->xyz[u] = order[side][k][0] ? maxs[u] : mins[u];
+                v->xyz[w] = order[side][k][1] ? maxs[w] : mins[w];
+                v->normal[0] = v->normal[1] = v->normal[2] = 0;
+                v->normal[axis] = side ? 1.0f : -1.0f;
+                v->bone = bone;
+            }
+
+            indices[rig->num_indices++] = (uint16_t)base;
+            indices[rig->num_indices++] = (uint16_t)(base + 1);
+            indices[rig->num_indices++] = (uint16_t)(base + 2);
+            indices[rig->num_indices++] = (uint16_t)base;
+            indices[rig->num_indices++] = (uint16_t)(base + 2);
+            indices[rig->num_indices++] = (uint16_t)(base + 3);
+        }
+    }
+}
+
+static void GHOUL_BuildRigs(void)
+{
+    int i;
+
+    humanoid_rig.bones = humanoid_bones;
+    humanoid_rig.num_bones = HB_NUM_BONES;
+    humanoid_rig.verts = humanoid_verts;
+    humanoid_rig.indices = humanoid_indices;
+    for (i = 0; i < HB_NUM_BONES; i++)
+        GHOUL_AddBox(&humanoid_rig, humanoid_verts, humanoid_indices,
+                     humanoid_bones[i].mins, humanoid_bones[i].maxs, i);
+
+    bolton_rig.bones = bolton_bones;
+    bolton_rig.num_bones = 1;
+    bolton_rig.verts = bolton_verts;
+    bolton_rig.indices = bolton_indices;
+    for (i = 0; i < BOLTON_BOXES; i++)
+        GHOUL_AddBox(&bolton_rig, bolton_verts, bolton_indices,
+                     bolton_boxes[i][0], bolton_boxes[i][1], 0);
+
+    rigs_built = qtrue;
+}
+
+/* The first call builds the meshes; make it from one thread */
+const ghoul_rig_t *GHOUL_HumanoidRig(void)
+{
+    if (!rigs_built)
+        GHOUL_BuildRigs();
+    return &humanoid_rig;
+}
+
+const ghoul_rig_t *GHOUL_BoltonRig(void)
+{
+    if (!rigs_built)
+        GHOUL_BuildRigs();
+    return &bolton_rig;
+}
+
+/* Bone by name, or by bolt point name on the humanoid; -1 if neither */
+int GHOUL_FindBone(const ghoul_rig_t *rig, const char *name)
+{
+    int i;
+
+    for (i = 0; i < rig->num_bones; i++) {
+        if (!Q_stricmp(rig->bones[i].name, name))
+            return i;
+    }
+
+    if (rig == &humanoid_rig) {
+        for (i = 0; i < (int)(sizeof(humanoid_bolts) / sizeof(humanoid_bolts[0])); i++) {
+            if (!Q_stricmp(humanoid_bolts[i].name, name))
+                return humanoid_bolts[i].bone;
+        }
+    }
+
+    return -1;
+}
+
+/* ==========================================================================
+   Posing
+
+   Until GSQ sequences are decoded the humanoid is posed procedurally:
+   every joint only pitches about its lateral axis. For bones that hang
+   down, a negative angle swings them forward.
+   ========================================================================== */
+
+/* out = a * b */
+static void Bone_Concat(const ghoul_bonemat_t *a, const ghoul_bonemat_t *b,
+                        ghoul_bonemat_t *out)
+{
+    int i, j;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 4; j++) {
+            out->m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] +
+                           a->m[i][2] * b->m[2][j];
+        }
+        out->m[i][3] += a->m[i][3];
+    }
+}
+
+/* Pitch by deg about the Y axis, then move by ofs */
+static void Bone_Local(ghoul_bonemat_t *out, const float *ofs, float deg)
+{
+    float a = deg * (3.14159265f / 180.0f);
+    float s = sinf(a), c = cosf(a);
+
+    out->m[0][0] = c;    out->m[0][1] = 0; out->m[0][2] = s; out->m[0][3] = ofs[0];
+    out->m[1][0] = 0;    out->m[1][1] = 1; out->m[1][2] = 0; out->m[1][3] = ofs[1];
+    out->m[2][0] = -s;   out->m[2][1] = 0; out->m[2][2] = c; out->m[2][3] = ofs[2];
+}
+
+static void GHOUL_PoseHumanoid(const ghoul_pose_t *pose, float *pitch)
+{
+    float s = sinf(pose->phase), c = cosf(pose->phase), k = pose->stride;
+
+    memset(pitch, 0, HB_NUM_BONES * sizeof(float));
+    if (pose->dead)
+        return;
+
+    /* Legs swing opposite each other and each knee bends on the way forward */
+    pitch[HB_THIGH_R] = -30.0f * k * s;
+    pitch[HB_THIGH_L] = 30.0f * k * s;
+    pitch[HB_CALF_R] = 45.0f * k * (c > 0 ? c : 0);
+    pitch[HB_CALF_L] = 45.0f * k * (c < 0 ? -c : 0);
+    pitch[HB_SPINE] = 6.0f * k;
+
+    /* Arms against the legs, unless they are holding a weapon out */
+    if (pose->armed) {
+        pitch[HB_UPPERARM_R] = -25.0f;
+        pitch[HB_FOREARM_R] = -65.0f;
+        pitch[HB_UPPERARM_L] = -35.0f;
+        pitch[HB_FOREARM_L] = -50.0f;
+    } else {
+        pitch[HB_UPPERARM_R] = 25.0f * k * s;
+        pitch[HB_UPPERARM_L] = -25.0f * k * s;
+        pitch[HB_FOREARM_R] = pitch[HB_FOREARM_L] = -15.0f * k;
+    }
+}
+
+/*
+ * GHOUL_ComputePalette — Skinning matrices for a posed rig: one per bone,
+ * taking a bind pose vertex to world space through model.
+ */
+void GHOUL_ComputePalette(const ghoul_rig_t *rig, const ghoul_pose_t *pose,
+                          const ghoul_bonemat_t *model, ghoul_bonemat_t *palette)
+{
+    ghoul_bonemat_t world[GHOUL_MAX_BONES], local;
+    float           pitch[GHOUL_MAX_BONES];
+    int             i;
+
+    if (rig == &humanoid_rig)
+        GHOUL_PoseHumanoid(pose, pitch);
+    else
+        memset(pitch, 0, sizeof(pitch));
+
+    for (i = 0; i < rig->num_bones && i < GHOUL_MAX_BONES; i++) {
+        const ghoul_bone_t  *b = &rig->bones[i];
+        const float         *bp = b->bindpos;
+
+        if (b->parent < 0) {
+            if (pose->dead) {
+                /* Face down on the ground, head forward */
+                static const float lie[3] = { 0, 0, 4 };
+
+                Bone_Local(&local, lie, 90.0f + pitch[i]);
+            } else {
+                Bone_Local(&local, bp, pitch[i]);
+            }
+            Bone_Concat(model, &local, &world[i]);
+        } else {
+            const float *pp = rig->bones[b->parent].bindpos;
+            float       ofs[3] = { bp[0] - pp[0], bp[1] - pp[1], bp[2] - pp[2] };
+
+            Bone_Local(&local, ofs, pitch[i]);
+            Bone_Concat(&world[b->parent], &local, &world[i]);
+        }
+
+        /* Skin = world * translate(-bindpos) */
+        palette[i] = world[i];
+        palette[i].m[0][3] -= world[i].m[0][0] * bp[0] + world[i].m[0][1] * bp[1] +
+                              world[i].m[0][2] * bp[2];
+        palette[i].m[1][3] -= world[i].m[1][0] * bp[0] + world[i].m[1][1] * bp[1] +
+                              world[i].m[1][2] * bp[2];
+        palette[i].m[2][3] -= world[i].m[2][0] * bp[0] + world[i].m[2][1] * bp[1] +
+                              world[i].m[2][2] * bp[2];
+    }
+}
+
+/* The frame a bolt-on at bone hangs in, from that bone's palette entry */
+void GHOUL_BoltMatrix(const ghoul_rig_t *rig, const ghoul_bonemat_t *palette,
+                      int bone, float scale, ghoul_bonemat_t *out)
+{
+    const ghoul_bonemat_t   *p = &palette[bone];
+    const float             *bp = rig->bones[bone].bindpos;
+    int                     i;
+
+    for (i = 0; i < 3; i++) {
+        out->m[i][0] = p->m[i][0] * scale;
+        out->m[i][1] = p->m[i][1] * scale;
+        out->m[i][2] = p->m[i][2] * scale;
+        out->m[i][3] = p->m[i][0] * bp[0] + p->m[i][1] * bp[1] + p->m[i][2] * bp[2] +
+                       p->m[i][3];
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * cl_null.c - Client, screen and sound stubs for the dedicated server
+ *
+ * Quake II's null/cl_null.c with the SoF additions: the game module calls
+ * straight into the HUD and sound code (there was no cgame split), so a
+ * headless build has to satisfy those calls without dragging the client in.
+ *
+ * Nothing here keeps state. Messages a player would have seen on screen —
+ * chat, kills, intermission — go to the server console instead.
+ */
+
+#include "../common/qcommon.h"
+#include "../sound/snd_local.h"
+
+/* ==========================================================================
+   Client
+   ========================================================================== */
+
+void CL_Init(void) {}
+void CL_Drop(void) {}
+void CL_Shutdown(void) {}
+void CL_Frame(int msec) { (void)msec; }
+
+/* The game reads this for the player's bullet-time key */
+qboolean cl_bullet_time_active = qfalse;
+
+/* ==========================================================================
+   Demo Hooks
+   ========================================================================== */
+
+void CL_DemoInit(void) {}
+qboolean CL_DemoPlaying(void) { return qfalse; }
+int  CL_DemoBeginFrame(int msec) { return msec; }
+qboolean CL_DemoReadCmd(usercmd_t *cmd) { (void)cmd; return qfalse; }
+void CL_DemoWriteCmd(const usercmd_t *cmd) { (void)cmd; }
+void CL_DemoCamera(void) {}
+void CL_DemoMark(int phase) { (void)phase; }
+void CL_DemoEndFrame(void) {}
+
+/* ==========================================================================
+   Screen / HUD
+   ========================================================================== */
+
+void Chat_AddMessage(const char *text)
+{
+    Com_Printf("%s\n", text);
+}
+
+void SCR_AddKillFeed(const char *attacker, const char *victim, const char *weapon)
+{
+    Com_Printf("%s killed %s (%s)\n", attacker, victim, weapon);
+}
+
+/* No one to show the tally to — go straight to the next map */
+void SCR_BeginIntermission(const char *nextmap)
+{
+    Com_Printf("Intermission: next map %s\n", nextmap);
+    if (nextmap && nextmap[0])
+        Cbuf_AddText(va("map %s\n", nextmap));
+}
+
+void HUD_SetPickupMessage(const char *msg) { (void)msg; }
+void SCR_AddPickupMessage(const char *text) { (void)text; }
+void SCR_SetObjective(int index, const char *text) { (void)index; (void)text; }
+void SCR_ClearObjectives(void) {}
+void SCR_AddScreenShake(float intensity, float duration) { (void)intensity; (void)duration; }
+void SCR_AddDamageNumber(int damage, int x, int y) { (void)damage; (void)x; (void)y; }
+void SCR_AddDamageDirection(float angle) { (void)angle; }
+void SCR_AddBloodSplatter(int damage) { (void)damage; }
+void SCR_AddScorePopup(int score) { (void)score; }
+void SCR_TriggerHitMarker(void) {}
+void SCR_StartFade(float target, float speed, float hold) { (void)target; (void)speed; (void)hold; }
+void SCR_FadeIn(float speed) { (void)speed; }
+
+/* ==========================================================================
+   Sound
+   ========================================================================== */
+
+qboolean S_Init(void) { return qfalse; }
+void S_Shutdown(void) {}
+void S_BeginRegistration(void) {}
+void S_EndRegistration(void) {}
+void S_StopAllSounds(void) {}
+void S_StartLocalSound(const char *name) { (void)name; }
+
+/* NULL makes the server skip the start calls as well */
+sfx_t *S_RegisterSound(const char *name)
+{
+    (void)name;
+    return NULL;
+}
+
+void S_StartSound(vec3_t origin, int entnum, int entchannel,
+                  sfx_t *sfx, float vol, float attenuation, float timeofs)
+{
+    (void)origin; (void)entnum; (void)entchannel;
+    (void)sfx; (void)vol; (void)attenuation; (void)timeofs;
+}
+
+void S_StartLoopingSound(vec3_t origin, int entnum, int entchannel,
+                         sfx_t *sfx, float vol, float attenuation)
+{
+    (void)origin; (void)entnum; (void)entchannel;
+    (void)sfx; (void)vol; (void)attenuation;
+}
@@ -0,0 +1,124 @@
+/*
+ * r_null.c - Renderer stubs and world loading for the dedicated server
+ *
+ * The collision code (cm_trace.c, sv_world.c) reads the BSP through
+ * R_GetWorldModel, so the dedicated build still owns a world model; it just
+ * loads it with BSP_Load alone — no textures, lightmaps or camera. The
+ * "map" command lives here for the same reason it lives in r_surf.c.
+ *
+ * Every effect the game spawns (particles, decals, dlights, tracers) is
+ * client-side only and is dropped.
+ */
+
+#include "../common/qcommon.h"
+#include "../renderer/r_bsp.h"
+
+/* ==========================================================================
+   World Map
+   ========================================================================== */
+
+static bsp_world_t  r_worldmodel;
+static qboolean     r_worldloaded = qfalse;
+
+/* Forward declaration — engine calls game spawn after map load */
+extern void SV_SpawnMapEntities(const char *mapname, const char *entstring);
+
+void R_LoadWorldMap(const char *name)
+{
+    char fullname[MAX_QPATH];
+
+    Com_sprintf(fullname, sizeof(fullname), "maps/%s.bsp", name);
+
+    if (r_worldloaded) {
+        BSP_Free(&r_worldmodel);
+        r_worldloaded = qfalse;
+    }
+
+    Com_Printf("Loading map: %s\n", fullname);
+
+    Prof_MapLoadBegin(LOAD_BSP);
+    if (!BSP_Load(fullname, &r_worldmodel)) {
+        Prof_MapLoadEnd();
+        Com_Printf("R_LoadWorldMap: couldn't load %s\n", fullname);
+        return;
+    }
+    Prof_MapLoadEnd();
+
+    r_worldloaded = qtrue;
+}
+
+qboolean R_WorldLoaded(void)
+{
+    return r_worldloaded;
+}
+
+bsp_world_t *R_GetWorldModel(void)
+{
+    return r_worldloaded ? &r_worldmodel : NULL;
+}
+
+static void Cmd_Map_f(void)
+{
+    const char *mapname;
+
+    if (Cmd_Argc() < 2) {
+        Com_Printf("Usage: map <mapname>\n");
+        return;
+    }
+
+    mapname = Cmd_Argv(1);
+    Prof_MapLoadStart(mapname);
+    R_LoadWorldMap(mapname);
+
+    if (r_worldloaded && r_worldmodel.entity_string)
+        SV_SpawnMapEntities(mapname, r_worldmodel.entity_string);
+    Prof_MapLoadFinish();
+}
+
+void R_InitSurfCommands(void)
+{
+    Cmd_AddCommand("map", Cmd_Map_f);
+}
+
+/* ==========================================================================
+   Entity Interpolation
+   ========================================================================== */
+
+void R_SetInterpFraction(float frac) { (void)frac; }
+
+/* ==========================================================================
+   Effects
+   ========================================================================== */
+
+void R_ParticleEffect(vec3_t org, vec3_t dir, int type, int count)
+{
+    (void)org; (void)dir; (void)type; (void)count;
+}
+
+void R_AddTracer(vec3_t start, vec3_t end, float r, float g, float b)
+{
+    (void)start; (void)end; (void)r; (void)g; (void)b;
+}
+
+void R_AddDlight(vec3_t origin, float r, float g, float b, float intensity,
+                 float duration)
+{
+    (void)origin; (void)r; (void)g; (void)b; (void)intensity; (void)duration;
+}
+
+void R_AddSprite(vec3_t origin, float size, float r, float g, float b,
+                 float alpha, float lifetime, float rotation_speed)
+{
+    (void)origin; (void)size; (void)r; (void)g; (void)b;
+    (void)alpha; (void)lifetime; (void)rotation_speed;
+}
+
+void R_AddDecal(vec3_t origin, vec3_t normal, int type)
+{
+    (void)origin; (void)normal; (void)type;
+}
+
+void R_SetSky(const char *name, float rotate, vec3_t axis)
+{
+    (void)name; (void)rotate; (void)axis;
+}
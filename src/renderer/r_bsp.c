@@ -18,7 +18,11 @@ static int      pvs_cached_cluster = -1;
    Lump Loading Helpers
    ========================================================================== */
 
-static void *BSP_LoadLump(byte *filebase, bsp_lump_t *lump, int element_size,
+/*
+ * BSP_LoadLump — copy one lump out of the (read-only) file view into level
+ * memory. This is the only copy: the file itself is a mapped view.
+ */
+static void *BSP_LoadLump(const byte *filebase, bsp_lump_t *lump, int element_size,
                            int *count, const char *name)
 {
     void *data;
@@ -46,16 +50,17 @@ static void *BSP_LoadLump(byte *filebase, bsp_lump_t *lump, int element_size,
 
 qboolean BSP_Load(const char *name, bsp_world_t *world)
 {
-    byte            *raw;
+    const byte      *raw;
     int             len;
-    bsp_header_t    *header;
+    bsp_header_t    hdr;
+    bsp_header_t    *header = &hdr;
     int             i;
 
     memset(world, 0, sizeof(bsp_world_t));
     Q_strncpyz(world->name, name, sizeof(world->name));
 
-    /* Load file from PAK */
-    len = FS_LoadFile(name, (void **)&raw);
+    /* Map file from PAK (read-only view, no intermediate copy) */
+    len = FS_MapFile(name, (const void **)&raw);
     if (!raw) {
         Com_Printf("BSP_Load: %s not found\n", name);
         return qfalse;
@@ -63,17 +68,18 @@ qboolean BSP_Load(const char *name, bsp_world_t *world)
 
     if (len < (int)sizeof(bsp_header_t)) {
         Com_Printf("BSP_Load: %s too small\n", name);
-        FS_FreeFile(raw);
+        FS_UnmapFile(raw);
         return qfalse;
     }
 
-    header = (bsp_header_t *)raw;
+    /* The view is read-only, so swap the header in a local copy */
+    memcpy(&hdr, raw, sizeof(hdr));
 
     /* Validate magic */
     i = LittleLong(header->magic);
     if (i != BSP_MAGIC) {
         Com_Printf("BSP_Load: %s has wrong magic (0x%08X, expected IBSP)\n", name, i);
-        FS_FreeFile(raw);
+        FS_UnmapFile(raw);
         return qfalse;
     }
 
@@ -82,7 +88,7 @@ qboolean BSP_Load(const char *name, bsp_world_t *world)
     if (i != BSP_VERSION) {
         Com_Printf("BSP_Load: %s has wrong version (%d, expected %d)\n",
             name, i, BSP_VERSION);
-        FS_FreeFile(raw);
+        FS_UnmapFile(raw);
         return qfalse;
     }
 
@@ -92,6 +98,16 @@ qboolean BSP_Load(const char *name, bsp_world_t *world)
         header->lumps[i].length = LittleLong(header->lumps[i].length);
     }
 
+    /* Range-check the directory once; lumps are copied straight from the view */
+    for (i = 0; i < HEADER_LUMPS; i++) {
+        bsp_lump_t *l = &header->lumps[i];
+        if (l->offset < 0 || l->length < 0 || l->offset > len - l->length) {
+            Com_Printf("BSP_Load: %s lump %d out of range\n", name, i);
+            FS_UnmapFile(raw);
+            return qfalse;
+        }
+    }
+
     /* Load entity string */
     if (header->lumps[LUMP_ENTITIES].length > 0) {
         world->entity_string_len = header->lumps[LUMP_ENTITIES].length;
@@ -153,6 +169,9 @@ qboolean BSP_Load(const char *name, bsp_world_t *world)
     world->leafbrushes = (unsigned short *)BSP_LoadLump(raw, &header->lumps[LUMP_LEAFBRUSHES],
         sizeof(unsigned short), &world->num_leafbrushes, "leafbrushes");
 
+    /* Brush bounds and SoA sides for the trace kernels */
+    CM_InitBrushData(world);
+
     /* Load areas */
     world->areas = (bsp_area_t *)BSP_LoadLump(raw, &header->lumps[LUMP_AREAS],
         sizeof(bsp_area_t), &world->num_areas, "areas");
@@ -183,7 +202,7 @@ qboolean BSP_Load(const char *name, bsp_world_t *world)
     pvs_cached_cluster = -1;  /* Reset PVS cache for new map */
 
     /* Done with raw file */
-    FS_FreeFile(raw);
+    FS_UnmapFile(raw);
 
     Com_Printf("BSP: Loaded %s\n", name);
     Com_Printf("  %d planes, %d verts, %d edges, %d faces\n",
@@ -250,6 +269,61 @@ int BSP_PointLeaf(bsp_world_t *world, vec3_t p)
     return -(num + 1);  /* Convert to leaf index */
 }
 
+static void BSP_BoxLeafs_r(bsp_world_t *world, int num, const vec3_t mins,
+                           const vec3_t maxs, int *list, int listsize, int *count)
+{
+    while (num >= 0) {
+        bsp_node_t  *node;
+        bsp_plane_t *plane;
+        float       dmin, dmax;
+        int         i;
+
+        if (num >= world->num_nodes)
+            return;
+        node = &world->nodes[num];
+        if (node->planenum < 0 || node->planenum >= world->num_planes)
+            return;
+        plane = &world->planes[node->planenum];
+
+        /* Nearest and farthest box corners along the normal */
+        dmin = dmax = -plane->dist;
+        for (i = 0; i < 3; i++) {
+            if (plane->normal[i] >= 0) {
+                dmin += plane->normal[i] * mins[i];
+                dmax += plane->normal[i] * maxs[i];
+            } else {
+                dmin += plane->normal[i] * maxs[i];
+                dmax += plane->normal[i] * mins[i];
+            }
+        }
+
+        if (dmin >= 0)
+            num = node->children[0];
+        else if (dmax < 0)
+            num = node->children[1];
+        else {
+            BSP_BoxLeafs_r(world, node->children[0], mins, maxs, list, listsize, count);
+            num = node->children[1];
+        }
+    }
+
+    if (*count < listsize)
+        list[*count] = -(num + 1);
+    (*count)++;
+}
+
+/* Every leaf the box touches; past listsize they are only counted */
+int BSP_BoxLeafs(bsp_world_t *world, const vec3_t mins, const vec3_t maxs,
+                 int *list, int listsize)
+{
+    int count = 0;
+
+    if (!world->loaded || !world->nodes)
+        return 0;
+    BSP_BoxLeafs_r(world, 0, mins, maxs, list, listsize, &count);
+    return count;
+}
+
 /*
  * BSP_DecompressVis — Decompress Q2 RLE-encoded PVS data
  *
@@ -311,3 +385,76 @@ qboolean BSP_ClusterVisible(bsp_world_t *world, int cluster1, int cluster2)
 
     return qfalse;
 }
+
+/*
+ * BSP_ClusterSees — BSP_ClusterVisible without the shared row cache, for
+ * the game thread. Decodes set's (DVIS_PVS/DVIS_PHS) row of cluster1 only
+ * as far as cluster2's byte.
+ */
+qboolean BSP_ClusterSees(bsp_world_t *world, int cluster1, int cluster2, int set)
+{
+    const byte  *in, *end;
+    int         numclusters, ofs, target, pos = 0;
+
+    if (!world->vis || cluster1 < 0 || cluster2 < 0)
+        return qtrue;
+
+    numclusters = LittleLong(world->vis->numclusters);
+    if (cluster1 >= numclusters || cluster2 >= numclusters)
+        return qtrue;
+
+    ofs = LittleLong(((int *)((byte *)world->vis + 4))[cluster1 * 2 + set]);
+    if (ofs <= 0 || ofs >= world->vis_size)
+        return qtrue;
+
+    in = (byte *)world->vis + ofs;
+    end = (byte *)world->vis + world->vis_size;
+    target = cluster2 >> 3;
+
+    while (in < end) {
+        if (*in) {
+            if (pos == target)
+                return (*in & (1 << (cluster2 & 7))) ? qtrue : qfalse;
+            pos++;
+            in++;
+            continue;
+        }
+        if (in + 1 >= end)
+            break;
+        pos += in[1];   /* run of zero bytes */
+        if (pos > target)
+            return qfalse;
+        in += 2;
+    }
+
+    return qtrue;   /* truncated row: don't cull */
+}
+
+/*
+ * BSP_ClusterRow — Decode set's whole row of cluster into out, one bit per
+ * cluster, for callers testing many clusters against one. Returns the row
+ * size in bytes, or 0 when there is nothing to cull by (no vis, a bad
+ * cluster, or a row larger than size).
+ */
+int BSP_ClusterRow(bsp_world_t *world, int cluster, int set, byte *out, int size)
+{
+    int numclusters, ofs, row;
+
+    if (!world->vis || cluster < 0)
+        return 0;
+
+    numclusters = LittleLong(world->vis->numclusters);
+    if (cluster >= numclusters)
+        return 0;
+
+    row = (numclusters + 7) >> 3;
+    if (row > size)
+        return 0;
+
+    ofs = LittleLong(((int *)((byte *)world->vis + 4))[cluster * 2 + set]);
+    if (ofs <= 0 || ofs >= world->vis_size)
+        return 0;
+
+    BSP_DecompressVis((byte *)world->vis + ofs, out, row);
+    return row;
+}
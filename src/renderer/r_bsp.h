@@ -157,7 +157,24 @@ typedef struct {
     int     otherarea;
 } bsp_areaportal_t;
 
+/* Collision acceleration, built from the brushes at load (cm_trace.c) */
+typedef struct {
+    float   mins[3], maxs[3];   /* from the brush's axial sides; open where it has none */
+    int     firstgroup;         /* into cmsides */
+    int     numgroups;
+} bsp_cmbrush_t;
+
+/* Four brush sides laid out for the SIMD clip kernels; padding lanes have plane -1 */
+typedef struct {
+    float   normal[3][4];
+    float   dist[4];
+    int     plane[4];
+} bsp_cmsides_t;
+
 /* Visibility data */
+#define DVIS_PVS    0
+#define DVIS_PHS    1
+
 typedef struct {
     int     numclusters;
     int     bitofs[8][2];   /* [cluster][PVS/PHS] — variable length */
@@ -217,6 +234,11 @@ typedef struct {
     int             num_areaportals;
     bsp_areaportal_t *areaportals;
 
+    /* Collision acceleration (cm_trace.c), one per brush */
+    bsp_cmbrush_t   *cmbrushes;
+    bsp_cmsides_t   *cmsides;
+    int             num_cmsides;
+
     /* Lightmap data */
     int             lightdata_size;
     byte            *lightdata;
@@ -239,15 +261,23 @@ void        BSP_Free(bsp_world_t *world);
 
 /* Find which leaf a point is in */
 int         BSP_PointLeaf(bsp_world_t *world, vec3_t p);
+int         BSP_BoxLeafs(bsp_world_t *world, const vec3_t mins, const vec3_t maxs,
+                         int *list, int listsize);
 
 /* PVS cluster check */
 qboolean    BSP_ClusterVisible(bsp_world_t *world, int cluster1, int cluster2);
+qboolean    BSP_ClusterSees(bsp_world_t *world, int cluster1, int cluster2, int set);
+int         BSP_ClusterRow(bsp_world_t *world, int cluster, int set, byte *out, int size);
 
 /* Collision model (cm_trace.c) */
+void        CM_InitBrushData(bsp_world_t *world);
 trace_t     CM_BoxTrace(bsp_world_t *world,
                         vec3_t start, vec3_t mins, vec3_t maxs,
                         vec3_t end, int brushmask);
 int         CM_PointContents(bsp_world_t *world, vec3_t p);
+int         CM_BenchCapture(bsp_world_t *world, const char *path, int passes);
+void        CM_BoxTraceBatch(bsp_world_t *world, tracequery_t *queries, int count,
+                             int brushmask);
 trace_t     CM_TransformedBoxTrace(bsp_world_t *world,
                                    vec3_t start, vec3_t mins, vec3_t maxs,
                                    vec3_t end, int headnode,
@@ -0,0 +1,457 @@
+/*
+ * r_draw.c - 2D drawing: HUD, console, menus
+ *
+ * Nothing here draws straight away. Every call becomes a screen quad in
+ * one vertex array, kept in call order, and consecutive quads on the same
+ * texture share a batch. R_Flush2D draws the batches, from the ring on the
+ * GL4 path, from the stream on the Vulkan one and through client arrays
+ * otherwise. The font, a white block for fills and every pic that fits
+ * all live in r_image.c's scrap, so a HUD or a full console is usually
+ * one draw.
+ *
+ * The batch is flushed by R_EndFrame, when it fills up, and at the top of
+ * R_RenderFrame so the 3D view can't cover 2D drawn before it.
+ */
+
+#include "r_local.h"
+
+#define MAX_2D_QUADS    16384
+#define MAX_2D_BATCHES  512
+
+static struct {
+    r_drawvert_t    verts[MAX_2D_QUADS * 6];
+    int             numverts;
+    r_2dbatch_t     batches[MAX_2D_BATCHES];
+    int             numbatches;
+} r_2d;
+
+static image_t  *r_charimage;   /* "*conchars": 128x64, 16 glyphs a row */
+static image_t  *r_whiteimage;  /* "*white", under every fill */
+
+/* Current draw color for text rendering (default green for console) */
+static byte     r_drawcolor[4] = { 0, 255, 0, 255 };
+
+static const byte r_opaque[4] = { 255, 255, 255, 255 };
+
+/* ==========================================================================
+   Batching
+   ========================================================================== */
+
+static byte R_ColorByte(float f)
+{
+    if (f <= 0.0f) return 0;
+    if (f >= 1.0f) return 255;
+    return (byte)(f * 255.0f + 0.5f);
+}
+
+static void R_2DVert(r_drawvert_t *v, float x, float y, float s, float t, const byte *rgba)
+{
+    v->xy[0] = x;
+    v->xy[1] = y;
+    v->st[0] = s;
+    v->st[1] = t;
+    memcpy(v->rgba, rgba, 4);
+}
+
+/* Queue a quad from (x1,y1) to (x2,y2), as two triangles */
+static void R_2DQuad(GLuint texnum, float x1, float y1, float x2, float y2,
+                     float s1, float t1, float s2, float t2, const byte *rgba)
+{
+    r_2dbatch_t     *b;
+    r_drawvert_t    *v;
+
+    if (r_2d.numverts + 6 > MAX_2D_QUADS * 6)
+        R_Flush2D();
+
+    b = r_2d.numbatches ? &r_2d.batches[r_2d.numbatches - 1] : NULL;
+    if (!b || b->texnum != texnum) {
+        if (r_2d.numbatches == MAX_2D_BATCHES)
+            R_Flush2D();
+        b = &r_2d.batches[r_2d.numbatches++];
+        b->texnum = texnum;
+        b->first = r_2d.numverts;
+        b->count = 0;
+    }
+
+    v = &r_2d.verts[r_2d.numverts];
+    R_2DVert(&v[0], x1, y1, s1, t1, rgba);
+    R_2DVert(&v[1], x2, y1, s2, t1, rgba);
+    R_2DVert(&v[2], x2, y2, s2, t2, rgba);
+    v[3] = v[0];
+    v[4] = v[2];
+    R_2DVert(&v[5], x1, y2, s1, t2, rgba);
+
+    r_2d.numverts += 6;
+    b->count += 6;
+}
+
+/* Draw everything queued so far, one call per batch */
+void R_Flush2D(void)
+{
+    int offset = -1;
+    int i;
+
+    if (!r_2d.numbatches)
+        return;
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_Draw2D(r_2d.verts, r_2d.numverts, r_2d.batches, r_2d.numbatches);
+        r_2d.numverts = r_2d.numbatches = 0;
+        return;
+    }
+#endif
+    if (!qglDrawArrays) {
+        r_2d.numverts = r_2d.numbatches = 0;
+        return;
+    }
+
+    qglEnable(GL_TEXTURE_2D);
+    qglEnable(GL_BLEND);
+    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        int             size = r_2d.numverts * (int)sizeof(r_drawvert_t);
+        r_drawvert_t    *ring = R_GL4_RingAlloc(size, &offset);
+
+        if (ring) {
+            memcpy(ring, r_2d.verts, size);
+            R_GL4_Begin2D(offset);
+        }
+    }
+#endif
+    if (offset < 0) {
+        qglEnableClientState(GL_VERTEX_ARRAY);
+        qglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        qglEnableClientState(GL_COLOR_ARRAY);
+        qglVertexPointer(2, GL_FLOAT, sizeof(r_drawvert_t), r_2d.verts[0].xy);
+        qglTexCoordPointer(2, GL_FLOAT, sizeof(r_drawvert_t), r_2d.verts[0].st);
+        qglColorPointer(4, GL_UNSIGNED_BYTE, sizeof(r_drawvert_t), r_2d.verts[0].rgba);
+    }
+
+    for (i = 0; i < r_2d.numbatches; i++) {
+        const r_2dbatch_t *b = &r_2d.batches[i];
+
+        qglBindTexture(GL_TEXTURE_2D, b->texnum);
+        qglDrawArrays(GL_TRIANGLES, b->first, b->count);
+        c_brush_polys++;
+    }
+
+#ifdef SOF_RENDERER_GL4
+    if (offset >= 0)
+        R_GL4_End2D();
+#endif
+    if (offset < 0) {
+        qglDisableClientState(GL_COLOR_ARRAY);
+        qglDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        qglDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+    qglDisable(GL_BLEND);
+    qglColor4f(1, 1, 1, 1);
+
+    r_2d.numverts = 0;
+    r_2d.numbatches = 0;
+}
+
+/* ==========================================================================
+   Pics and Fills
+   ========================================================================== */
+
+void R_DrawGetPicSize(int *w, int *h, const char *name)
+{
+    image_t *pic = R_FindPic(name);
+    if (pic) {
+        *w = pic->width;
+        *h = pic->height;
+    } else {
+        *w = 0;
+        *h = 0;
+    }
+}
+
+void R_DrawPic(int x, int y, const char *name)
+{
+    image_t *pic = R_FindPic(name);
+    if (!pic || !pic->texnum)
+        return;
+
+    R_2DQuad(pic->texnum, (float)x, (float)y, (float)(x + pic->width), (float)(y + pic->height),
+             pic->sl, pic->tl, pic->sh, pic->th, r_opaque);
+}
+
+void R_DrawStretchPic(int x, int y, int w, int h, const char *name)
+{
+    image_t *pic = R_FindPic(name);
+    if (!pic || !pic->texnum)
+        return;
+
+    R_2DQuad(pic->texnum, (float)x, (float)y, (float)(x + w), (float)(y + h),
+             pic->sl, pic->tl, pic->sh, pic->th, r_opaque);
+}
+
+/* A flat quad: the middle of the white block, so it shares the scrap's batch */
+static void R_DrawFlat(float x1, float y1, float x2, float y2, const byte *rgba)
+{
+    float s, t;
+
+    if (!r_whiteimage)
+        return;
+
+    s = (r_whiteimage->sl + r_whiteimage->sh) * 0.5f;
+    t = (r_whiteimage->tl + r_whiteimage->th) * 0.5f;
+    R_2DQuad(r_whiteimage->texnum, x1, y1, x2, y2, s, t, s, t, rgba);
+}
+
+void R_DrawTileClear(int x, int y, int w, int h, const char *name)
+{
+    (void)x; (void)y; (void)w; (void)h; (void)name;
+}
+
+void R_DrawFill(int x, int y, int w, int h, int c)
+{
+    byte rgba[4];
+
+    /* Unpack RGBA if high bits set, otherwise use Q2 palette index */
+    if (c & 0xFF000000) {
+        /* ARGB packed color from console */
+        rgba[3] = (byte)((c >> 24) & 0xFF);
+        rgba[0] = (byte)(c & 0xFF);
+        rgba[1] = (byte)((c >> 8) & 0xFF);
+        rgba[2] = (byte)((c >> 16) & 0xFF);
+    } else {
+        /* Q2 palette index — approximate */
+        rgba[0] = R_ColorByte(((c >> 5) & 7) / 7.0f);
+        rgba[1] = R_ColorByte(((c >> 2) & 7) / 7.0f);
+        rgba[2] = R_ColorByte((c & 3) / 3.0f);
+        rgba[3] = 255;
+    }
+
+    R_DrawFlat((float)x, (float)y, (float)(x + w), (float)(y + h), rgba);
+}
+
+void R_DrawFadeScreen(void)
+{
+    R_DrawFadeScreenColor(0, 0, 0, 0.8f);
+}
+
+void R_DrawFadeScreenColor(float r, float g, float b, float a)
+{
+    byte rgba[4];
+
+    rgba[0] = R_ColorByte(r);
+    rgba[1] = R_ColorByte(g);
+    rgba[2] = R_ColorByte(b);
+    rgba[3] = R_ColorByte(a);
+    R_DrawFlat(0, 0, (float)g_display.width, (float)g_display.height, rgba);
+}
+
+void R_DrawStretchRaw(int x, int y, int w, int h, int cols, int rows, byte *data)
+{
+    (void)x; (void)y; (void)w; (void)h;
+    (void)cols; (void)rows; (void)data;
+    /* TODO: Used for cinematic playback */
+}
+
+/* ==========================================================================
+   Text
+   Built-in font: ASCII 32-127 in a 128x64 pic (16 chars x 6 rows),
+   drawn from a 5x7 bitmap baked in at init.
+   ========================================================================== */
+
+/* Minimal 5x7 font bitmaps for ASCII 33-126 (printable chars).
+ * Each char is 7 bytes, each byte is a row, bits 4-0 = pixels.
+ * Char 0 = '!' (ASCII 33), etc.
+ */
+static const byte font5x7[] = {
+    /* ! */  0x04,0x04,0x04,0x04,0x00,0x04,0x00,
+    /* " */  0x0A,0x0A,0x00,0x00,0x00,0x00,0x00,
+    /* # */  0x0A,0x1F,0x0A,0x1F,0x0A,0x00,0x00,
+    /* $ */  0x0E,0x15,0x06,0x14,0x0F,0x04,0x00,
+    /* % */  0x13,0x0B,0x04,0x1A,0x19,0x00,0x00,
+    /* & */  0x06,0x09,0x06,0x15,0x12,0x0D,0x00,
+    /* ' */  0x04,0x04,0x00,0x00,0x00,0x00,0x00,
+    /* ( */  0x08,0x04,0x04,0x04,0x04,0x08,0x00,
+    /* ) */  0x02,0x04,0x04,0x04,0x04,0x02,0x00,
+    /* * */  0x00,0x0A,0x04,0x0A,0x00,0x00,0x00,
+    /* + */  0x00,0x04,0x0E,0x04,0x00,0x00,0x00,
+    /* , */  0x00,0x00,0x00,0x00,0x04,0x02,0x00,
+    /* - */  0x00,0x00,0x0E,0x00,0x00,0x00,0x00,
+    /* . */  0x00,0x00,0x00,0x00,0x04,0x00,0x00,
+    /* / */  0x10,0x08,0x04,0x02,0x01,0x00,0x00,
+    /* 0 */  0x0E,0x11,0x19,0x15,0x13,0x0E,0x00,
+    /* 1 */  0x04,0x06,0x04,0x04,0x04,0x0E,0x00,
+    /* 2 */  0x0E,0x11,0x08,0x04,0x02,0x1F,0x00,
+    /* 3 */  0x0E,0x11,0x0C,0x10,0x11,0x0E,0x00,
+    /* 4 */  0x08,0x0C,0x0A,0x1F,0x08,0x08,0x00,
+    /* 5 */  0x1F,0x01,0x0F,0x10,0x11,0x0E,0x00,
+    /* 6 */  0x0C,0x02,0x0F,0x11,0x11,0x0E,0x00,
+    /* 7 */  0x1F,0x10,0x08,0x04,0x02,0x02,0x00,
+    /* 8 */  0x0E,0x11,0x0E,0x11,0x11,0x0E,0x00,
+    /* 9 */  0x0E,0x11,0x11,0x1E,0x08,0x06,0x00,
+    /* : */  0x00,0x04,0x00,0x04,0x00,0x00,0x00,
+    /* ; */  0x00,0x04,0x00,0x04,0x02,0x00,0x00,
+    /* < */  0x08,0x04,0x02,0x04,0x08,0x00,0x00,
+    /* = */  0x00,0x0E,0x00,0x0E,0x00,0x00,0x00,
+    /* > */  0x02,0x04,0x08,0x04,0x02,0x00,0x00,
+    /* ? */  0x0E,0x11,0x08,0x04,0x00,0x04,0x00,
+    /* @ */  0x0E,0x11,0x1D,0x1D,0x01,0x0E,0x00,
+    /* A */  0x0E,0x11,0x11,0x1F,0x11,0x11,0x00,
+    /* B */  0x0F,0x11,0x0F,0x11,0x11,0x0F,0x00,
+    /* C */  0x0E,0x11,0x01,0x01,0x11,0x0E,0x00,
+    /* D */  0x07,0x09,0x11,0x11,0x09,0x07,0x00,
+    /* E */  0x1F,0x01,0x0F,0x01,0x01,0x1F,0x00,
+    /* F */  0x1F,0x01,0x0F,0x01,0x01,0x01,0x00,
+    /* G */  0x0E,0x11,0x01,0x19,0x11,0x0E,0x00,
+    /* H */  0x11,0x11,0x1F,0x11,0x11,0x11,0x00,
+    /* I */  0x0E,0x04,0x04,0x04,0x04,0x0E,0x00,
+    /* J */  0x1C,0x08,0x08,0x08,0x09,0x06,0x00,
+    /* K */  0x11,0x09,0x07,0x09,0x11,0x11,0x00,
+    /* L */  0x01,0x01,0x01,0x01,0x01,0x1F,0x00,
+    /* M */  0x11,0x1B,0x15,0x11,0x11,0x11,0x00,
+    /* N */  0x11,0x13,0x15,0x19,0x11,0x11,0x00,
+    /* O */  0x0E,0x11,0x11,0x11,0x11,0x0E,0x00,
+    /* P */  0x0F,0x11,0x0F,0x01,0x01,0x01,0x00,
+    /* Q */  0x0E,0x11,0x11,0x15,0x09,0x16,0x00,
+    /* R */  0x0F,0x11,0x0F,0x09,0x11,0x11,0x00,
+    /* S */  0x0E,0x11,0x06,0x08,0x11,0x0E,0x00,
+    /* T */  0x1F,0x04,0x04,0x04,0x04,0x04,0x00,
+    /* U */  0x11,0x11,0x11,0x11,0x11,0x0E,0x00,
+    /* V */  0x11,0x11,0x11,0x0A,0x0A,0x04,0x00,
+    /* W */  0x11,0x11,0x15,0x15,0x1B,0x11,0x00,
+    /* X */  0x11,0x0A,0x04,0x0A,0x11,0x00,0x00,
+    /* Y */  0x11,0x0A,0x04,0x04,0x04,0x04,0x00,
+    /* Z */  0x1F,0x08,0x04,0x02,0x01,0x1F,0x00,
+    /* [ */  0x0E,0x02,0x02,0x02,0x02,0x0E,0x00,
+    /* \ */  0x01,0x02,0x04,0x08,0x10,0x00,0x00,
+    /* ] */  0x0E,0x08,0x08,0x08,0x08,0x0E,0x00,
+    /* ^ */  0x04,0x0A,0x00,0x00,0x00,0x00,0x00,
+    /* _ */  0x00,0x00,0x00,0x00,0x00,0x1F,0x00,
+    /* ` */  0x02,0x04,0x00,0x00,0x00,0x00,0x00,
+    /* a */  0x00,0x0E,0x10,0x1E,0x11,0x1E,0x00,
+    /* b */  0x01,0x0F,0x11,0x11,0x11,0x0F,0x00,
+    /* c */  0x00,0x0E,0x01,0x01,0x01,0x0E,0x00,
+    /* d */  0x10,0x1E,0x11,0x11,0x11,0x1E,0x00,
+    /* e */  0x00,0x0E,0x11,0x1F,0x01,0x0E,0x00,
+    /* f */  0x0C,0x02,0x0F,0x02,0x02,0x02,0x00,
+    /* g */  0x00,0x1E,0x11,0x1E,0x10,0x0E,0x00,
+    /* h */  0x01,0x0F,0x11,0x11,0x11,0x11,0x00,
+    /* i */  0x04,0x00,0x06,0x04,0x04,0x0E,0x00,
+    /* j */  0x08,0x00,0x0C,0x08,0x08,0x06,0x00,
+    /* k */  0x01,0x09,0x05,0x03,0x05,0x09,0x00,
+    /* l */  0x06,0x04,0x04,0x04,0x04,0x0E,0x00,
+    /* m */  0x00,0x0B,0x15,0x15,0x11,0x11,0x00,
+    /* n */  0x00,0x0F,0x11,0x11,0x11,0x11,0x00,
+    /* o */  0x00,0x0E,0x11,0x11,0x11,0x0E,0x00,
+    /* p */  0x00,0x0F,0x11,0x0F,0x01,0x01,0x00,
+    /* q */  0x00,0x1E,0x11,0x1E,0x10,0x10,0x00,
+    /* r */  0x00,0x0D,0x13,0x01,0x01,0x01,0x00,
+    /* s */  0x00,0x0E,0x02,0x04,0x08,0x0E,0x00,
+    /* t */  0x02,0x0F,0x02,0x02,0x02,0x0C,0x00,
+    /* u */  0x00,0x11,0x11,0x11,0x11,0x1E,0x00,
+    /* v */  0x00,0x11,0x11,0x0A,0x0A,0x04,0x00,
+    /* w */  0x00,0x11,0x11,0x15,0x15,0x0A,0x00,
+    /* x */  0x00,0x11,0x0A,0x04,0x0A,0x11,0x00,
+    /* y */  0x00,0x11,0x11,0x1E,0x10,0x0E,0x00,
+    /* z */  0x00,0x1F,0x08,0x04,0x02,0x1F,0x00,
+    /* { */  0x08,0x04,0x02,0x04,0x08,0x00,0x00,
+    /* | */  0x04,0x04,0x04,0x04,0x04,0x04,0x00,
+    /* } */  0x02,0x04,0x08,0x04,0x02,0x00,0x00,
+    /* ~ */  0x00,0x05,0x0A,0x00,0x00,0x00,0x00,
+};
+
+static void R_InitCharFont(void)
+{
+    byte pixels[128 * 64 * 4];  /* RGBA 128x64 */
+    int ch, px, py;
+
+    memset(pixels, 0, sizeof(pixels));
+
+    for (ch = 33; ch <= 126; ch++) {
+        int idx = ch - 33;
+        int cx = (ch % 16) * 8;
+        int cy = ((ch - 32) / 16) * 8;
+        const byte *glyph = &font5x7[idx * 7];
+
+        for (py = 0; py < 7; py++) {
+            byte bits = glyph[py];
+            for (px = 0; px < 5; px++) {
+                if (bits & (1 << px)) {
+                    int tx = cx + px + 1;
+                    int ty = cy + py;
+                    int ofs = (ty * 128 + tx) * 4;
+                    pixels[ofs + 0] = 255;
+                    pixels[ofs + 1] = 255;
+                    pixels[ofs + 2] = 255;
+                    pixels[ofs + 3] = 255;
+                }
+            }
+        }
+    }
+
+    r_charimage = R_LoadPicPixels("*conchars", pixels, 128, 64);
+}
+
+void R_SetDrawColor(float r, float g, float b, float a)
+{
+    r_drawcolor[0] = R_ColorByte(r);
+    r_drawcolor[1] = R_ColorByte(g);
+    r_drawcolor[2] = R_ColorByte(b);
+    r_drawcolor[3] = R_ColorByte(a);
+}
+
+void R_DrawChar(int x, int y, int ch)
+{
+    float s1, t1, s2, t2, sw, th;
+    int cx, cy;
+
+    ch &= 255;
+    if (ch == ' ' || ch < 32 || ch > 126 || !r_charimage)
+        return;
+
+    /* Glyph cell in the 128x64 font, scaled into where the scrap put it */
+    cx = (ch % 16) * 8;
+    cy = ((ch - 32) / 16) * 8;
+    sw = (r_charimage->sh - r_charimage->sl) / 128.0f;
+    th = (r_charimage->th - r_charimage->tl) / 64.0f;
+    s1 = r_charimage->sl + cx * sw;
+    t1 = r_charimage->tl + cy * th;
+    s2 = s1 + 8 * sw;
+    t2 = t1 + 8 * th;
+
+    R_2DQuad(r_charimage->texnum, (float)x, (float)y, (float)(x + 8), (float)(y + 8),
+             s1, t1, s2, t2, r_drawcolor);
+}
+
+void R_DrawString(int x, int y, const char *str)
+{
+    while (*str) {
+        if (*str != ' ')
+            R_DrawChar(x, y, (unsigned char)*str);
+        x += 8;
+        str++;
+    }
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+/* After R_InitImages: the font and the fill block go in the scrap first */
+void R_InitDraw(void)
+{
+    byte white[2 * 2 * 4];
+
+    memset(white, 255, sizeof(white));
+    r_2d.numverts = r_2d.numbatches = 0;
+
+    R_InitCharFont();
+    r_whiteimage = R_LoadPicPixels("*white", white, 2, 2);
+}
+
+void R_ShutdownDraw(void)
+{
+    r_2d.numverts = r_2d.numbatches = 0;
+    r_charimage = NULL;
+    r_whiteimage = NULL;
+}
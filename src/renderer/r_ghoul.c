@@ -0,0 +1,412 @@
+/*
+ * r_ghoul.c - GHOUL model drawing
+ *
+ * R_DrawBrushEntities queues each humanoid with R_AddGhoulInstance as it
+ * walks the snapshot, and R_DrawGhoulInstances then draws them all at once:
+ *
+ *   - Each instance's bone palette is posed on a job worker and written
+ *     straight to the memory the GPU reads it from.
+ *   - On the GL4 path the rig meshes sit in static buffers and are skinned
+ *     in the vertex shader. All the bodies are one instanced draw and all
+ *     the bolt-ons a second. Damaged and severed zones are per-instance
+ *     masks the shader tests against each vertex, so a maimed body still
+ *     shares the mesh and the draw.
+ *   - Otherwise the same jobs skin the meshes on the CPU into one batch of
+ *     dynamic vertices, collapsing the triangles below a severed zone.
+ *
+ * Every model uses the proxy rig from ghoul_main.c until GHB meshes are
+ * decoded; nothing here depends on its shape.
+ */
+
+#include "r_local.h"
+#include "../ghoul/ghoul.h"
+
+#define MAX_GHOUL_INSTANCES 256
+#define MAX_GHOUL_BOLTS     (MAX_GHOUL_INSTANCES * 2)
+
+/* Light direction for the two-tone shading, as in the skinning shader */
+static const float ghoul_lightdir[3] = { 0.36f, 0.24f, 0.9f };
+
+typedef struct {
+    const ghoul_rig_t   *rig;
+    ghoul_bonemat_t     model;          /* origin and yaw */
+    ghoul_pose_t        pose;
+    vec3_t              light;          /* R_LightPoint at the origin */
+    float               color[4];       /* lit base color */
+    uint32_t            damaged, severed;
+    int                 first_bolt, num_bolts;
+
+    /* Set by R_DrawGhoulInstances */
+    int                 bone_base;      /* into the palette */
+    int                 vert_base;      /* into the CPU vertices */
+} r_ghoulinst_t;
+
+typedef struct {
+    int                 bone;
+    float               scale;
+} r_ghoulbolt_t;
+
+static struct {
+    r_ghoulinst_t   insts[MAX_GHOUL_INSTANCES];
+    int             num_insts;
+    r_ghoulbolt_t   bolts[MAX_GHOUL_BOLTS];
+    int             num_bolts;
+    int             dropped;            /* over MAX_GHOUL_INSTANCES, ever */
+
+    /* This draw, for the jobs */
+    ghoul_bonemat_t *palette;
+    int             bolt_bone_base;     /* bolt-on matrices follow the bodies */
+    r_dynvert_t     *verts;             /* NULL when skinning on the GPU */
+    int             bolt_vert_base;
+
+    int             body_mesh, bolt_mesh;   /* R_GL4_CreateSkinMesh, -1 = none */
+} r_ghoul;
+
+/* ==========================================================================
+   Queueing
+   ========================================================================== */
+
+/*
+ * R_AddGhoulInstance — Queue a humanoid for R_DrawGhoulInstances. ghoul is
+ * the entity's model, or NULL for the stand-in monsters and players, who
+ * carry a default rifle. color is the unlit base color.
+ */
+void R_AddGhoulInstance(const snapent_t *ent, const struct ghoul_model_s *ghoul,
+                        const vec3_t origin, float yaw, const float *color)
+{
+    r_ghoulinst_t   *in;
+    vec3_t          org, move;
+    float           a, s, c, speed, dim;
+    int             i;
+
+    if (r_ghoul.num_insts == MAX_GHOUL_INSTANCES) {
+        if (!r_ghoul.dropped++)
+            Com_DPrintf("R_AddGhoulInstance: more than %d models\n", MAX_GHOUL_INSTANCES);
+        return;
+    }
+    in = &r_ghoul.insts[r_ghoul.num_insts++];
+
+    in->rig = ghoul && ghoul->rig ? ghoul->rig : GHOUL_HumanoidRig();
+
+    /* Yaw about the origin */
+    a = yaw * (3.14159265f / 180.0f);
+    s = sinf(a);
+    c = cosf(a);
+    in->model.m[0][0] = c; in->model.m[0][1] = -s; in->model.m[0][2] = 0; in->model.m[0][3] = origin[0];
+    in->model.m[1][0] = s; in->model.m[1][1] = c;  in->model.m[1][2] = 0; in->model.m[1][3] = origin[1];
+    in->model.m[2][0] = 0; in->model.m[2][1] = 0;  in->model.m[2][2] = 1; in->model.m[2][3] = origin[2];
+
+    /* Walk speed from the last tick's move (10 ticks a second). Entities
+       are out of step with each other so crowds don't march. */
+    VectorSubtract(ent->s.origin, ent->s.old_origin, move);
+    speed = sqrtf(move[0] * move[0] + move[1] * move[1]) * 10.0f;
+    in->pose.dead = ent->deadflag != 0;
+    in->pose.stride = in->pose.dead ? 0 : (speed > 300.0f ? 1.0f : speed / 300.0f);
+    in->pose.phase = (float)Sys_Milliseconds() * 0.001f * speed * (6.2831853f / 96.0f) +
+                     (float)ent->s.number * 1.7f;
+
+    /* Lit on the main thread: the lightmaps aren't for the workers */
+    VectorCopy(origin, org);
+    R_LightPoint(org, in->light);
+    dim = in->pose.dead ? 0.5f : 1.0f;
+    for (i = 0; i < 3; i++)
+        in->color[i] = color[i] * in->light[i] * dim;
+    in->color[3] = 1.0f;
+
+    in->damaged = (uint32_t)ent->gore_zone_mask;
+    in->severed = (uint32_t)ent->severed_zone_mask;
+    if (ghoul) {
+        in->damaged |= ghoul->zone_damaged;
+        in->severed |= ghoul->zone_severed;
+    }
+
+    /* Bolt-ons, unless the bone they hang from is gone; the dead drop theirs */
+    in->first_bolt = r_ghoul.num_bolts;
+    in->num_bolts = 0;
+    if (!in->pose.dead) {
+        int n = ghoul ? ghoul->num_boltons : 1;
+
+        for (i = 0; i < n && r_ghoul.num_bolts < MAX_GHOUL_BOLTS; i++) {
+            const char      *name = ghoul ? ghoul->boltons[i].bolt_name : "wbolt_hand_r";
+            int             bone;
+
+            if (ghoul && !ghoul->boltons[i].active)
+                continue;
+            bone = GHOUL_FindBone(in->rig, name);
+            if (bone < 0 || (in->rig->bones[bone].hide_mask & in->severed))
+                continue;
+
+            r_ghoul.bolts[r_ghoul.num_bolts].bone = bone;
+            r_ghoul.bolts[r_ghoul.num_bolts].scale =
+                ghoul && ghoul->boltons[i].scale > 0 ? ghoul->boltons[i].scale : 1.0f;
+            r_ghoul.num_bolts++;
+            in->num_bolts++;
+        }
+    }
+    in->pose.armed = in->num_bolts > 0;
+}
+
+/* ==========================================================================
+   Skinning
+   ========================================================================== */
+
+static byte R_GhoulByte(float f)
+{
+    if (f <= 0.0f) return 0;
+    if (f >= 1.0f) return 255;
+    return (byte)(f * 255.0f);
+}
+
+/*
+ * CPU skinning for the GL 1.x path: one vertex per index, so triangles
+ * come out flat shaded. Hidden ones collapse to a point, as in the shader.
+ */
+static void R_SkinMesh(const ghoul_rig_t *rig, const ghoul_bonemat_t *palette,
+                       const float *color, uint32_t damaged, uint32_t severed,
+                       r_dynvert_t *out)
+{
+    int i, k;
+
+    for (i = 0; i < rig->num_indices; i++) {
+        const ghoul_vert_t      *v = &rig->verts[rig->indices[i]];
+        const ghoul_bone_t      *b = &rig->bones[v->bone];
+        const ghoul_bonemat_t   *m = &palette[v->bone];
+        r_dynvert_t             *o = &out[i];
+        float                   n[3], len, shade, rgb[3];
+
+        if (b->hide_mask & severed) {
+            memset(o, 0, sizeof(*o));
+            continue;
+        }
+
+        for (k = 0; k < 3; k++) {
+            o->xyz[k] = m->m[k][0] * v->xyz[0] + m->m[k][1] * v->xyz[1] +
+                        m->m[k][2] * v->xyz[2] + m->m[k][3];
+            n[k] = m->m[k][0] * v->normal[0] + m->m[k][1] * v->normal[1] +
+                   m->m[k][2] * v->normal[2];
+        }
+
+        /* Bolt-ons may be scaled */
+        len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        shade = len > 0 ? (n[0] * ghoul_lightdir[0] + n[1] * ghoul_lightdir[1] +
+                           n[2] * ghoul_lightdir[2]) / len : 0;
+        shade = 0.6f + 0.4f * (shade > 0 ? shade : 0);
+
+        for (k = 0; k < 3; k++)
+            rgb[k] = color[k] * shade;
+        if (b->damage_mask & damaged) {
+            rgb[0] += (0.45f - rgb[0]) * 0.6f;
+            rgb[1] += (0.02f - rgb[1]) * 0.6f;
+            rgb[2] += (0.02f - rgb[2]) * 0.6f;
+        }
+
+        o->rgba[0] = R_GhoulByte(rgb[0]);
+        o->rgba[1] = R_GhoulByte(rgb[1]);
+        o->rgba[2] = R_GhoulByte(rgb[2]);
+        o->rgba[3] = R_GhoulByte(color[3]);
+    }
+}
+
+static void R_BoltColor(const r_ghoulinst_t *in, float *color)
+{
+    color[0] = 0.3f * in->light[0];
+    color[1] = 0.3f * in->light[1];
+    color[2] = 0.32f * in->light[2];
+    color[3] = 1.0f;
+}
+
+/* Job: pose one instance and its bolt-ons, and skin them if on the CPU */
+static void R_GhoulJob(void *ctx, int index)
+{
+    const r_ghoulinst_t *in = &r_ghoul.insts[index];
+    const ghoul_rig_t   *brig = GHOUL_BoltonRig();
+    ghoul_bonemat_t     pal[GHOUL_MAX_BONES], *bolts;
+    int                 i;
+
+    (void)ctx;
+
+    /* Posed on the stack: on GL4 the destination is write-combined */
+    GHOUL_ComputePalette(in->rig, &in->pose, &in->model, pal);
+    memcpy(r_ghoul.palette + in->bone_base, pal, in->rig->num_bones * sizeof(pal[0]));
+
+    bolts = r_ghoul.palette + r_ghoul.bolt_bone_base + in->first_bolt;
+    for (i = 0; i < in->num_bolts; i++) {
+        const r_ghoulbolt_t *b = &r_ghoul.bolts[in->first_bolt + i];
+        ghoul_bonemat_t     m;
+
+        GHOUL_BoltMatrix(in->rig, pal, b->bone, b->scale, &m);
+        bolts[i] = m;
+
+        if (r_ghoul.verts) {
+            float color[4];
+
+            R_BoltColor(in, color);
+            R_SkinMesh(brig, &m, color, 0, 0, r_ghoul.verts + r_ghoul.bolt_vert_base +
+                       (in->first_bolt + i) * brig->num_indices);
+        }
+    }
+
+    if (r_ghoul.verts)
+        R_SkinMesh(in->rig, pal, in->color, in->damaged, in->severed,
+                   r_ghoul.verts + in->vert_base);
+}
+
+/* ==========================================================================
+   Drawing
+   ========================================================================== */
+
+#ifdef SOF_RENDERER_GL4
+/* Instance records for the skinning shader; false if the ring is full */
+static qboolean R_GhoulStorage(int numbones, int *bones_ofs, int *inst_ofs, int *bolt_ofs)
+{
+    r_skininst_t    *insts, *bolts = NULL;
+    int             i, j;
+
+    r_ghoul.palette = R_GL4_StorageAlloc(numbones * (int)sizeof(ghoul_bonemat_t), bones_ofs);
+    if (!r_ghoul.palette)
+        return qfalse;
+    insts = R_GL4_StorageAlloc(r_ghoul.num_insts * (int)sizeof(r_skininst_t), inst_ofs);
+    if (!insts)
+        return qfalse;
+    if (r_ghoul.num_bolts) {
+        bolts = R_GL4_StorageAlloc(r_ghoul.num_bolts * (int)sizeof(r_skininst_t), bolt_ofs);
+        if (!bolts)
+            return qfalse;
+    }
+
+    /* Whole records: the ring is write-only */
+    for (i = 0; i < r_ghoul.num_insts; i++) {
+        const r_ghoulinst_t *in = &r_ghoul.insts[i];
+        r_skininst_t        rec;
+
+        memcpy(rec.color, in->color, sizeof(rec.color));
+        rec.severed = in->severed;
+        rec.damaged = in->damaged;
+        rec.bone_base = (uint32_t)in->bone_base;
+        rec.pad = 0;
+        insts[i] = rec;
+
+        for (j = 0; j < in->num_bolts; j++) {
+            R_BoltColor(in, rec.color);
+            rec.severed = rec.damaged = 0;
+            rec.bone_base = (uint32_t)(r_ghoul.bolt_bone_base + in->first_bolt + j);
+            bolts[in->first_bolt + j] = rec;
+        }
+    }
+
+    return qtrue;
+}
+#endif
+
+void R_DrawGhoulInstances(void)
+{
+    const ghoul_rig_t   *brig;
+    int                 numbones = 0, numverts = 0, i;
+    qboolean            gpu = qfalse;
+#ifdef SOF_RENDERER_GL4
+    int                 bones_ofs = 0, inst_ofs = 0, bolt_ofs = 0;
+#endif
+
+    if (!r_ghoul.num_insts)
+        return;
+
+    brig = GHOUL_BoltonRig();
+    for (i = 0; i < r_ghoul.num_insts; i++) {
+        r_ghoulinst_t *in = &r_ghoul.insts[i];
+
+        in->bone_base = numbones;
+        in->vert_base = numverts;
+        numbones += in->rig->num_bones;
+        numverts += in->rig->num_indices;
+    }
+    r_ghoul.bolt_bone_base = numbones;
+    r_ghoul.bolt_vert_base = numverts;
+    numbones += r_ghoul.num_bolts;
+    numverts += r_ghoul.num_bolts * brig->num_indices;
+
+    r_ghoul.verts = NULL;
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4 && r_ghoul.body_mesh >= 0 && r_ghoul.bolt_mesh >= 0)
+        gpu = R_GhoulStorage(numbones, &bones_ofs, &inst_ofs, &bolt_ofs);
+#endif
+    if (!gpu) {
+        r_ghoul.palette = Z_FrameAlloc(numbones * (int)sizeof(ghoul_bonemat_t));
+        r_ghoul.verts = R_DynAlloc(numverts);
+    }
+
+    Job_ParallelFor("R_GhoulBones", R_GhoulJob, NULL, r_ghoul.num_insts);
+
+    qglDisable(GL_TEXTURE_2D);
+    qglDisable(GL_BLEND);
+    qglEnable(GL_DEPTH_TEST);
+
+#ifdef SOF_RENDERER_GL4
+    if (gpu) {
+        int size = numbones * (int)sizeof(ghoul_bonemat_t);
+
+        R_GL4_DrawSkinned(r_ghoul.body_mesh, bones_ofs, size, inst_ofs, r_ghoul.num_insts);
+        R_GL4_DrawSkinned(r_ghoul.bolt_mesh, bones_ofs, size, bolt_ofs, r_ghoul.num_bolts);
+        c_brush_polys += r_ghoul.num_bolts ? 2 : 1;
+    }
+#endif
+    if (!gpu)
+        R_DynDraw(GL_TRIANGLES, r_ghoul.verts, numverts);
+
+    qglEnable(GL_TEXTURE_2D);
+    qglColor4f(1, 1, 1, 1);
+
+    r_ghoul.num_insts = 0;
+    r_ghoul.num_bolts = 0;
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+#ifdef SOF_RENDERER_GL4
+static int R_GhoulUploadRig(const ghoul_rig_t *rig)
+{
+    r_skinvert_t    *verts = Z_Malloc(rig->num_verts * (int)sizeof(r_skinvert_t));
+    int             i, mesh;
+
+    for (i = 0; i < rig->num_verts; i++) {
+        const ghoul_vert_t *v = &rig->verts[i];
+
+        memcpy(verts[i].xyz, v->xyz, sizeof(verts[i].xyz));
+        memcpy(verts[i].normal, v->normal, sizeof(verts[i].normal));
+        verts[i].bone = (uint32_t)v->bone;
+        verts[i].hide = rig->bones[v->bone].hide_mask;
+        verts[i].damage = rig->bones[v->bone].damage_mask;
+    }
+
+    mesh = R_GL4_CreateSkinMesh(verts, rig->num_verts, rig->indices, rig->num_indices);
+    Z_Free(verts);
+    return mesh;
+}
+#endif
+
+/* After R_GL4_Init */
+void R_InitGhoul(void)
+{
+    const ghoul_rig_t *rig = GHOUL_HumanoidRig();    /* builds the rigs */
+
+    r_ghoul.num_insts = r_ghoul.num_bolts = 0;
+    r_ghoul.body_mesh = r_ghoul.bolt_mesh = -1;
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        r_ghoul.body_mesh = R_GhoulUploadRig(rig);
+        r_ghoul.bolt_mesh = R_GhoulUploadRig(GHOUL_BoltonRig());
+    }
+#endif
+
+    Com_Printf("...GHOUL rig: %d bones, %d triangles, %s skinning\n", rig->num_bones,
+               rig->num_indices / 3, r_ghoul.body_mesh >= 0 ? "GPU" : "CPU");
+}
+
+/* Before R_GL4_Shutdown, which frees the meshes */
+void R_ShutdownGhoul(void)
+{
+    r_ghoul.num_insts = r_ghoul.num_bolts = 0;
+    r_ghoul.body_mesh = r_ghoul.bolt_mesh = -1;
+}
@@ -0,0 +1,1041 @@
+/*
+ * r_gl4.c - OpenGL 4.5 rendering path (SOF_RENDERER_GL4)
+ *
+ * The original ref_gl.dll is pure GL 1.1 fixed function, and most of this
+ * renderer still is. On a 4.5 context the hot paths move to modern GL:
+ *
+ *   - The world mesh (r_surf.c) lives in an immutable buffer and is drawn
+ *     through one shader that combines diffuse and lightmap, does the
+ *     alpha test, and animates SURF_WARP faces on the GPU, so water is
+ *     batched like everything else instead of going through glBegin.
+ *   - Per-frame geometry — world index lists, particles, sprites, tracers —
+ *     is written straight into a persistently mapped ring buffer split
+ *     into three fenced segments, one per frame in flight.
+ *   - Textures are created with DSA and immutable storage.
+ *   - MD2 models (r_model.c) keep every frame in a static buffer and lerp
+ *     between two of them in the vertex shader; copies of a model share
+ *     one instanced draw.
+ *   - GHOUL models (r_ghoul.c) are skinned in the vertex shader from
+ *     static meshes, with the bone palettes and per-instance zone masks
+ *     read from the ring as storage buffers; one instanced draw per mesh.
+ *   - The HUD and console (r_draw.c) are batched quads streamed through
+ *     the ring, one draw per run of the same texture.
+ *
+ * The context is a compatibility profile: the view weapon and the rest of
+ * the effects are still immediate mode, and the shaders read the
+ * fixed-function matrices, current color and fog through the GLSL
+ * compatibility built-ins, so both halves agree on the camera. Anything
+ * missing at init (no 4.5, a shader that fails to build) leaves
+ * gl_state.gl4 off and the GL 1.x path in charge.
+ */
+
+#include "r_local.h"
+
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION            0x821B
+#define GL_MINOR_VERSION            0x821C
+#endif
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER          0x8B30
+#define GL_VERTEX_SHADER            0x8B31
+#define GL_COMPILE_STATUS           0x8B81
+#define GL_LINK_STATUS              0x8B82
+#endif
+
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER     0x8893
+#endif
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT            0x0002
+#endif
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT       0x0040
+#define GL_MAP_COHERENT_BIT         0x0080
+#endif
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE   0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT      0x00000001
+#define GL_TIMEOUT_EXPIRED              0x911B
+#define GL_WAIT_FAILED                  0x911D
+#endif
+
+#ifndef GL_RGBA8
+#define GL_RGBA8                    0x8058
+#define GL_RGB8                     0x8051
+#endif
+
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE       0x8642
+#endif
+
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER                0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE            0x812F
+#endif
+
+/* ==========================================================================
+   GL 4.5 Entry Points
+   ========================================================================== */
+
+static GLuint (APIENTRY *qglCreateShader)(GLenum type);
+static void (APIENTRY *qglShaderSource)(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+static void (APIENTRY *qglCompileShader)(GLuint shader);
+static void (APIENTRY *qglGetShaderiv)(GLuint shader, GLenum pname, GLint *params);
+static void (APIENTRY *qglGetShaderInfoLog)(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+static void (APIENTRY *qglDeleteShader)(GLuint shader);
+static GLuint (APIENTRY *qglCreateProgram)(void);
+static void (APIENTRY *qglAttachShader)(GLuint program, GLuint shader);
+static void (APIENTRY *qglLinkProgram)(GLuint program);
+static void (APIENTRY *qglGetProgramiv)(GLuint program, GLenum pname, GLint *params);
+static void (APIENTRY *qglGetProgramInfoLog)(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+static void (APIENTRY *qglDeleteProgram)(GLuint program);
+static void (APIENTRY *qglUseProgram)(GLuint program);
+static GLint (APIENTRY *qglGetUniformLocation)(GLuint program, const GLchar *name);
+static void (APIENTRY *qglProgramUniform1i)(GLuint program, GLint location, GLint v0);
+static void (APIENTRY *qglProgramUniform1f)(GLuint program, GLint location, GLfloat v0);
+static void (APIENTRY *qglProgramUniform2f)(GLuint program, GLint location, GLfloat v0, GLfloat v1);
+
+static void (APIENTRY *qglCreateBuffers)(GLsizei n, GLuint *buffers);
+static void (APIENTRY *qglDeleteBuffers)(GLsizei n, const GLuint *buffers);
+static void (APIENTRY *qglNamedBufferStorage)(GLuint buffer, GLsizeiptr size, const void *data, GLbitfield flags);
+static void *(APIENTRY *qglMapNamedBufferRange)(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+static GLboolean (APIENTRY *qglUnmapNamedBuffer)(GLuint buffer);
+
+static void (APIENTRY *qglCreateVertexArrays)(GLsizei n, GLuint *arrays);
+static void (APIENTRY *qglDeleteVertexArrays)(GLsizei n, const GLuint *arrays);
+static void (APIENTRY *qglBindVertexArray)(GLuint array);
+static void (APIENTRY *qglVertexArrayVertexBuffer)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+static void (APIENTRY *qglVertexArrayElementBuffer)(GLuint vaobj, GLuint buffer);
+static void (APIENTRY *qglEnableVertexArrayAttrib)(GLuint vaobj, GLuint index);
+static void (APIENTRY *qglVertexArrayAttribFormat)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+static void (APIENTRY *qglVertexArrayAttribBinding)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+static void (APIENTRY *qglVertexArrayAttribIFormat)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+
+static void (APIENTRY *qglBindBufferRange)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+static void (APIENTRY *qglBindBufferBase)(GLenum target, GLuint index, GLuint buffer);
+static void (APIENTRY *qglDrawElementsInstanced)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount);
+
+static GLsync (APIENTRY *qglFenceSync)(GLenum condition, GLbitfield flags);
+static GLenum (APIENTRY *qglClientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+static void (APIENTRY *qglDeleteSync)(GLsync sync);
+
+static void (APIENTRY *qglCreateTextures)(GLenum target, GLsizei n, GLuint *textures);
+static void (APIENTRY *qglTextureStorage2D)(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+static void (APIENTRY *qglTextureSubImage2D)(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+static void (APIENTRY *qglCompressedTextureSubImage2D)(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data);
+static void (APIENTRY *qglTextureParameteri)(GLuint texture, GLenum pname, GLint param);
+
+static GLboolean (APIENTRY *qglIsEnabled)(GLenum cap);
+
+#define GL4_LOAD(name) \
+    if (!(qgl##name = (void *)Sys_GL_GetProcAddress("gl" #name))) { \
+        Com_Printf("GL4: gl" #name " not found\n"); \
+        ok = qfalse; \
+    }
+
+static qboolean R_GL4_LoadFunctions(void)
+{
+    qboolean ok = qtrue;
+
+    GL4_LOAD(CreateShader);
+    GL4_LOAD(ShaderSource);
+    GL4_LOAD(CompileShader);
+    GL4_LOAD(GetShaderiv);
+    GL4_LOAD(GetShaderInfoLog);
+    GL4_LOAD(DeleteShader);
+    GL4_LOAD(CreateProgram);
+    GL4_LOAD(AttachShader);
+    GL4_LOAD(LinkProgram);
+    GL4_LOAD(GetProgramiv);
+    GL4_LOAD(GetProgramInfoLog);
+    GL4_LOAD(DeleteProgram);
+    GL4_LOAD(UseProgram);
+    GL4_LOAD(GetUniformLocation);
+    GL4_LOAD(ProgramUniform1i);
+    GL4_LOAD(ProgramUniform1f);
+    GL4_LOAD(ProgramUniform2f);
+    GL4_LOAD(CreateBuffers);
+    GL4_LOAD(DeleteBuffers);
+    GL4_LOAD(NamedBufferStorage);
+    GL4_LOAD(MapNamedBufferRange);
+    GL4_LOAD(UnmapNamedBuffer);
+    GL4_LOAD(CreateVertexArrays);
+    GL4_LOAD(DeleteVertexArrays);
+    GL4_LOAD(BindVertexArray);
+    GL4_LOAD(VertexArrayVertexBuffer);
+    GL4_LOAD(VertexArrayElementBuffer);
+    GL4_LOAD(EnableVertexArrayAttrib);
+    GL4_LOAD(VertexArrayAttribFormat);
+    GL4_LOAD(VertexArrayAttribBinding);
+    GL4_LOAD(VertexArrayAttribIFormat);
+    GL4_LOAD(BindBufferRange);
+    GL4_LOAD(BindBufferBase);
+    GL4_LOAD(DrawElementsInstanced);
+    GL4_LOAD(FenceSync);
+    GL4_LOAD(ClientWaitSync);
+    GL4_LOAD(DeleteSync);
+    GL4_LOAD(CreateTextures);
+    GL4_LOAD(TextureStorage2D);
+    GL4_LOAD(TextureSubImage2D);
+    GL4_LOAD(CompressedTextureSubImage2D);
+    GL4_LOAD(TextureParameteri);
+    GL4_LOAD(IsEnabled);
+
+    return ok;
+}
+
+/* ==========================================================================
+   Shaders
+   ========================================================================== */
+
+/* Shared by both programs: GL_EXP2 fog, as R_RenderFrame sets it up */
+#define GL4_FOG_GLSL \
+    "uniform int u_fog;\n" \
+    "vec3 ApplyFog(vec3 c, float dist) {\n" \
+    "    if (u_fog == 0) return c;\n" \
+    "    float f = exp(-pow(gl_Fog.density * dist, 2.0));\n" \
+    "    return mix(gl_Fog.color.rgb, c, clamp(f, 0.0, 1.0));\n" \
+    "}\n"
+
+static const char *gl4_world_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec3 a_pos;\n"
+    "layout(location = 1) in vec2 a_st;\n"
+    "layout(location = 2) in vec2 a_lm;\n"
+    "uniform int u_warp;\n"
+    "uniform float u_time;\n"
+    "out vec2 v_st;\n"
+    "out vec2 v_lm;\n"
+    "out vec4 v_color;\n"
+    "out float v_dist;\n"
+    "void main() {\n"
+    "    vec3 p = a_pos;\n"
+    "    vec2 st = a_st;\n"
+    "    if (u_warp != 0) {\n"
+    "        st += 0.05 * sin(a_pos.yx * 0.05 + u_time * 2.0);\n"
+    "        p.z += 2.0 * sin(a_pos.x * 0.03 + u_time * 1.5)\n"
+    "             + 2.0 * sin(a_pos.y * 0.03 + u_time * 1.2);\n"
+    "    }\n"
+    "    v_st = st;\n"
+    "    v_lm = a_lm;\n"
+    "    v_color = gl_Color;\n"
+    "    v_dist = length((gl_ModelViewMatrix * vec4(p, 1.0)).xyz);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 1.0);\n"
+    "}\n";
+
+static const char *gl4_world_fs =
+    "#version 450 compatibility\n"
+    "layout(binding = 0) uniform sampler2D u_diffuse;\n"
+    "layout(binding = 1) uniform sampler2D u_lightmap;\n"
+    "uniform int u_textured;\n"
+    "uniform int u_lightmapped;\n"
+    "uniform float u_alpharef;\n"
+    GL4_FOG_GLSL
+    "in vec2 v_st;\n"
+    "in vec2 v_lm;\n"
+    "in vec4 v_color;\n"
+    "in float v_dist;\n"
+    "out vec4 o_color;\n"
+    "void main() {\n"
+    "    vec4 c = v_color;\n"
+    "    if (u_textured != 0) c *= texture(u_diffuse, v_st);\n"
+    "    if (u_lightmapped != 0) c.rgb *= texture(u_lightmap, v_lm).rgb;\n"
+    "    if (c.a <= u_alpharef) discard;\n"
+    "    o_color = vec4(ApplyFog(c.rgb, v_dist), c.a);\n"
+    "}\n";
+
+static const char *gl4_dyn_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec3 a_pos;\n"
+    "layout(location = 1) in vec4 a_color;\n"
+    "out vec4 v_color;\n"
+    "out float v_dist;\n"
+    "void main() {\n"
+    "    v_color = a_color;\n"
+    "    v_dist = length((gl_ModelViewMatrix * vec4(a_pos, 1.0)).xyz);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(a_pos, 1.0);\n"
+    "}\n";
+
+static const char *gl4_dyn_fs =
+    "#version 450 compatibility\n"
+    GL4_FOG_GLSL
+    "in vec4 v_color;\n"
+    "in float v_dist;\n"
+    "out vec4 o_color;\n"
+    "void main() {\n"
+    "    o_color = vec4(ApplyFog(v_color.rgb, v_dist), v_color.a);\n"
+    "}\n";
+
+/*
+ * Particles are point sprites. Small ones stay a fixed 3 pixels like the
+ * GL 1.x points; the rest cover their world size at their distance, as
+ * the billboard quads do.
+ */
+static const char *gl4_part_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec3 a_pos;\n"
+    "layout(location = 1) in vec4 a_color;\n"
+    "layout(location = 2) in float a_size;\n"
+    "uniform float u_pointscale;\n"
+    "out vec4 v_color;\n"
+    "out float v_dist;\n"
+    "void main() {\n"
+    "    vec4 eye = gl_ModelViewMatrix * vec4(a_pos, 1.0);\n"
+    "    v_color = a_color;\n"
+    "    v_dist = length(eye.xyz);\n"
+    "    gl_PointSize = a_size < 6.0 ? 3.0 : a_size * u_pointscale / max(-eye.z, 1.0);\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "}\n";
+
+/*
+ * GHOUL skinning. Each bone is three vec4 rows of a 3x4 matrix; an
+ * instance picks its palette with bone_base. A vertex whose bone hangs
+ * below a severed zone collapses to a point, so its triangles vanish
+ * without the mesh changing.
+ */
+/* 2D: screen coordinates through the ortho matrices, no fog */
+static const char *gl4_2d_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec2 a_pos;\n"
+    "layout(location = 1) in vec2 a_st;\n"
+    "layout(location = 2) in vec4 a_color;\n"
+    "out vec2 v_st;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    v_st = a_st;\n"
+    "    v_color = a_color;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(a_pos, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *gl4_2d_fs =
+    "#version 450 compatibility\n"
+    "layout(binding = 0) uniform sampler2D u_diffuse;\n"
+    "in vec2 v_st;\n"
+    "in vec4 v_color;\n"
+    "out vec4 o_color;\n"
+    "void main() {\n"
+    "    o_color = v_color * texture(u_diffuse, v_st);\n"
+    "}\n";
+
+static const char *gl4_skin_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec3 a_pos;\n"
+    "layout(location = 1) in vec3 a_normal;\n"
+    "layout(location = 2) in uint a_bone;\n"
+    "layout(location = 3) in uint a_hide;\n"
+    "layout(location = 4) in uint a_damage;\n"
+    "struct Instance { vec4 color; uvec4 info; };\n"   /* severed, damaged, bone_base */
+    "layout(std430, binding = 0) readonly buffer Bones { vec4 bones[]; };\n"
+    "layout(std430, binding = 1) readonly buffer Instances { Instance insts[]; };\n"
+    "out vec4 v_color;\n"
+    "out float v_dist;\n"
+    "void main() {\n"
+    "    Instance inst = insts[gl_InstanceID];\n"
+    "    uint b = (inst.info.z + a_bone) * 3u;\n"
+    "    vec4 p = vec4(a_pos, 1.0);\n"
+    "    vec3 pos = vec3(dot(bones[b], p), dot(bones[b + 1u], p), dot(bones[b + 2u], p));\n"
+    "    vec3 n = normalize(vec3(dot(bones[b].xyz, a_normal), dot(bones[b + 1u].xyz, a_normal),\n"
+    "                            dot(bones[b + 2u].xyz, a_normal)));\n"
+    "    vec3 c = inst.color.rgb * (0.6 + 0.4 * max(dot(n, vec3(0.36, 0.24, 0.9)), 0.0));\n"
+    "    if ((inst.info.y & a_damage) != 0u) c = mix(c, vec3(0.45, 0.02, 0.02), 0.6);\n"
+    "    v_color = vec4(c, inst.color.a);\n"
+    "    v_dist = length((gl_ModelViewMatrix * vec4(pos, 1.0)).xyz);\n"
+    "    gl_Position = (inst.info.x & a_hide) != 0u ? vec4(0.0, 0.0, 0.0, 1.0)\n"
+    "                : gl_ModelViewProjectionMatrix * vec4(pos, 1.0);\n"
+    "}\n";
+
+/*
+ * MD2 frame lerp. gl_VertexID is the index, so the position of vertex i in
+ * a frame is frames[frame + i]. Shading is by height in the model, as the
+ * GL 1.x path does it. Drawn with the world fragment shader.
+ */
+static const char *gl4_alias_vs =
+    "#version 450 compatibility\n"
+    "layout(location = 0) in vec2 a_st;\n"
+    "struct Instance { vec4 rows[3]; vec4 color; uint frame; uint oldframe;\n"
+    "                  float backlerp; float pad; };\n"
+    "layout(std430, binding = 0) readonly buffer Frames { float frames[]; };\n"
+    "layout(std430, binding = 1) readonly buffer Instances { Instance insts[]; };\n"
+    "uniform vec2 u_zrange;\n"                         /* mins z, 1 / height */
+    "out vec2 v_st;\n"
+    "out vec2 v_lm;\n"
+    "out vec4 v_color;\n"
+    "out float v_dist;\n"
+    "void main() {\n"
+    "    Instance inst = insts[gl_InstanceID];\n"
+    "    uint cur = (inst.frame + uint(gl_VertexID)) * 3u;\n"
+    "    uint old = (inst.oldframe + uint(gl_VertexID)) * 3u;\n"
+    "    vec3 a = vec3(frames[old], frames[old + 1u], frames[old + 2u]);\n"
+    "    vec3 b = vec3(frames[cur], frames[cur + 1u], frames[cur + 2u]);\n"
+    "    vec4 p = vec4(mix(b, a, inst.backlerp), 1.0);\n"
+    "    vec3 pos = vec3(dot(inst.rows[0], p), dot(inst.rows[1], p), dot(inst.rows[2], p));\n"
+    "    v_st = a_st;\n"
+    "    v_lm = vec2(0.0);\n"
+    "    v_color = vec4(inst.color.rgb * (0.6 + 0.4 * (p.z - u_zrange.x) * u_zrange.y), 1.0);\n"
+    "    v_dist = length((gl_ModelViewMatrix * vec4(pos, 1.0)).xyz);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(pos, 1.0);\n"
+    "}\n";
+
+static GLuint R_GL4_CompileShader(GLenum type, const char *src, const char *name)
+{
+    GLuint  shader = qglCreateShader(type);
+    GLint   status = 0;
+
+    qglShaderSource(shader, 1, &src, NULL);
+    qglCompileShader(shader);
+    qglGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    if (!status) {
+        char log[1024];
+
+        qglGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        Com_Printf("GL4: %s %s shader: %s\n", name,
+                   type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        qglDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+static GLuint R_GL4_BuildProgram(const char *vs_src, const char *fs_src, const char *name)
+{
+    GLuint  vs, fs, prog;
+    GLint   status = 0;
+
+    vs = R_GL4_CompileShader(GL_VERTEX_SHADER, vs_src, name);
+    fs = R_GL4_CompileShader(GL_FRAGMENT_SHADER, fs_src, name);
+    if (!vs || !fs) {
+        if (vs) qglDeleteShader(vs);
+        if (fs) qglDeleteShader(fs);
+        return 0;
+    }
+
+    prog = qglCreateProgram();
+    qglAttachShader(prog, vs);
+    qglAttachShader(prog, fs);
+    qglLinkProgram(prog);
+    qglDeleteShader(vs);
+    qglDeleteShader(fs);
+
+    qglGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (!status) {
+        char log[1024];
+
+        qglGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        Com_Printf("GL4: %s program: %s\n", name, log);
+        qglDeleteProgram(prog);
+        return 0;
+    }
+
+    return prog;
+}
+
+/* ==========================================================================
+   State
+   ========================================================================== */
+
+#define GL4_RING_SEGMENTS   3                   /* frames in flight */
+#define GL4_RING_SEGSIZE    (8 * 1024 * 1024)   /* bytes per frame */
+#define GL4_MAX_SKIN_MESHES 8
+
+static struct {
+    /* World program */
+    GLuint      world_prog;
+    GLint       u_warp, u_time, u_textured, u_lightmapped, u_alpharef, u_fog;
+    GLuint      world_vao;
+    GLuint      world_vbo;      /* vertex layout of r_surf.c worldvert_t */
+
+    /* Dynamic geometry program */
+    GLuint      dyn_prog;
+    GLint       u_dyn_fog;
+    GLuint      dyn_vao;
+
+    /* Particle program; shares the dynamic fragment shader */
+    GLuint      part_prog;
+    GLint       u_part_fog, u_pointscale;
+    GLuint      part_vao;
+
+    /* MD2 program; shares the world fragment shader */
+    GLuint      alias_prog;
+    GLint       u_alias_textured, u_alias_fog, u_zrange;
+
+    /* 2D program */
+    GLuint      ui_prog;
+    GLuint      ui_vao;
+
+    /* Skinning program; shares the dynamic fragment shader */
+    GLuint      skin_prog;
+    GLint       u_skin_fog;
+    struct {
+        GLuint  vao, vbo, ibo;
+        int     numindices;
+    }           skin_meshes[GL4_MAX_SKIN_MESHES];
+    int         num_skin_meshes;
+    int         ssbo_align;
+
+    /* Ring buffer */
+    GLuint      ring;
+    byte        *ring_base;
+    GLsync      fence[GL4_RING_SEGMENTS];
+    int         segment;
+    int         used;           /* bytes used in the current segment */
+    qboolean    overflowed;     /* warned this frame */
+} gl4;
+
+cvar_t  *r_gl4;
+
+/* ==========================================================================
+   Ring Buffer
+   ========================================================================== */
+
+/*
+ * Carve size bytes out of this frame's ring segment. Returns the mapped
+ * pointer and the offset into the ring buffer, or NULL when the segment
+ * is full — the caller falls back to client memory.
+ */
+void *R_GL4_RingAlloc(int size, int *offset)
+{
+    int start;
+
+    size = (size + 15) & ~15;
+    if (gl4.used + size > GL4_RING_SEGSIZE) {
+        if (!gl4.overflowed)
+            Com_DPrintf("GL4: ring segment full (%d bytes wanted)\n", size);
+        gl4.overflowed = qtrue;
+        return NULL;
+    }
+
+    start = gl4.segment * GL4_RING_SEGSIZE + gl4.used;
+    gl4.used += size;
+    *offset = start;
+    return gl4.ring_base + start;
+}
+
+/* As R_GL4_RingAlloc, but starting where a storage buffer may be bound */
+void *R_GL4_StorageAlloc(int size, int *offset)
+{
+    /* Segments start aligned, so this never runs past the segment end */
+    gl4.used += (gl4.ssbo_align - gl4.used % gl4.ssbo_align) % gl4.ssbo_align;
+    return R_GL4_RingAlloc(size, offset);
+}
+
+/*
+ * Fence the segment the last frame wrote and move to the next one, waiting
+ * for the GPU if it is still reading it (only when three frames behind).
+ */
+void R_GL4_BeginFrame(void)
+{
+    if (!gl_state.gl4)
+        return;
+
+    if (gl4.fence[gl4.segment])
+        qglDeleteSync(gl4.fence[gl4.segment]);
+    gl4.fence[gl4.segment] = qglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    gl4.segment = (gl4.segment + 1) % GL4_RING_SEGMENTS;
+    gl4.used = 0;
+    gl4.overflowed = qfalse;
+
+    if (gl4.fence[gl4.segment]) {
+        GLenum r;
+
+        Prof_Begin("R_GL4_RingWait");
+        do {
+            r = qglClientWaitSync(gl4.fence[gl4.segment], GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  (GLuint64)100 * 1000 * 1000);
+        } while (r == GL_TIMEOUT_EXPIRED);
+        Prof_End();
+
+        qglDeleteSync(gl4.fence[gl4.segment]);
+        gl4.fence[gl4.segment] = NULL;
+    }
+}
+
+/* ==========================================================================
+   Textures
+   ========================================================================== */
+
+/* Immutable 2D texture with room for levels mips */
+GLuint R_GL4_CreateTexture(int width, int height, int levels, GLenum internalformat,
+                           qboolean repeat)
+{
+    GLuint  tex;
+    GLint   wrap = repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+
+    qglCreateTextures(GL_TEXTURE_2D, 1, &tex);
+    qglTextureStorage2D(tex, levels, internalformat, width, height);
+    qglTextureParameteri(tex, GL_TEXTURE_MIN_FILTER,
+                         levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    qglTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    qglTextureParameteri(tex, GL_TEXTURE_WRAP_S, wrap);
+    qglTextureParameteri(tex, GL_TEXTURE_WRAP_T, wrap);
+    qglTextureParameteri(tex, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    return tex;
+}
+
+void R_GL4_TextureLevel(GLuint tex, int level, int width, int height,
+                        GLenum format, const void *pixels)
+{
+    qglTextureSubImage2D(tex, level, 0, 0, width, height, format,
+                         GL_UNSIGNED_BYTE, pixels);
+}
+
+/* Part of level 0, for lightmap luxels relit by dynamic lights */
+void R_GL4_TextureRect(GLuint tex, int x, int y, int width, int height,
+                       GLenum format, const void *pixels)
+{
+    qglTextureSubImage2D(tex, 0, x, y, width, height, format,
+                         GL_UNSIGNED_BYTE, pixels);
+}
+
+/* One level of a block-compressed texture from r_texcache.c */
+void R_GL4_CompressedLevel(GLuint tex, int level, int width, int height,
+                           GLenum internalformat, int size, const void *data)
+{
+    qglCompressedTextureSubImage2D(tex, level, 0, 0, width, height, internalformat,
+                                   size, data);
+}
+
+/* ==========================================================================
+   World
+   ========================================================================== */
+
+/* Static world vertices; replaces the previous map's buffer */
+GLuint R_GL4_CreateWorldBuffer(const void *verts, int size, int stride,
+                               int st_ofs, int lm_ofs)
+{
+    if (gl4.world_vbo)
+        qglDeleteBuffers(1, &gl4.world_vbo);
+
+    qglCreateBuffers(1, &gl4.world_vbo);
+    qglNamedBufferStorage(gl4.world_vbo, size, verts, 0);
+
+    qglVertexArrayVertexBuffer(gl4.world_vao, 0, gl4.world_vbo, 0, stride);
+    qglVertexArrayAttribFormat(gl4.world_vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    qglVertexArrayAttribFormat(gl4.world_vao, 1, 2, GL_FLOAT, GL_FALSE, st_ofs);
+    qglVertexArrayAttribFormat(gl4.world_vao, 2, 2, GL_FLOAT, GL_FALSE, lm_ofs);
+
+    return gl4.world_vbo;
+}
+
+void R_GL4_FreeWorldBuffer(void)
+{
+    if (gl4.world_vbo) {
+        qglDeleteBuffers(1, &gl4.world_vbo);
+        gl4.world_vbo = 0;
+    }
+}
+
+void R_GL4_BeginWorld(void)
+{
+    qglUseProgram(gl4.world_prog);
+    qglBindVertexArray(gl4.world_vao);
+    qglProgramUniform1f(gl4.world_prog, gl4.u_time, (float)Sys_Milliseconds() * 0.001f);
+    qglProgramUniform1i(gl4.world_prog, gl4.u_fog, qglIsEnabled(GL_FOG) ? 1 : 0);
+    qglProgramUniform1f(gl4.world_prog, gl4.u_alpharef, -1.0f);
+}
+
+void R_GL4_EndWorld(void)
+{
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+void R_GL4_SetMaterial(qboolean textured, qboolean lightmapped, qboolean warp)
+{
+    qglProgramUniform1i(gl4.world_prog, gl4.u_textured, textured);
+    qglProgramUniform1i(gl4.world_prog, gl4.u_lightmapped, lightmapped);
+    qglProgramUniform1i(gl4.world_prog, gl4.u_warp, warp);
+}
+
+/* Fragments at or below ref are dropped; negative turns the test off */
+void R_GL4_SetAlphaRef(float ref)
+{
+    qglProgramUniform1f(gl4.world_prog, gl4.u_alpharef, ref);
+}
+
+/* Draw count indices from the ring at offset, or from client memory
+ * when the ring was full (offset < 0) */
+void R_GL4_DrawIndexed(const GLuint *indices, int offset, int count)
+{
+    if (offset >= 0) {
+        qglDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const void *)(intptr_t)offset);
+    } else {
+        qglVertexArrayElementBuffer(gl4.world_vao, 0);
+        qglDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices);
+        qglVertexArrayElementBuffer(gl4.world_vao, gl4.ring);
+    }
+}
+
+/* ==========================================================================
+   Dynamic Geometry
+   ========================================================================== */
+
+/* r_dynvert_t vertices already written to the ring at offset */
+void R_GL4_DrawDynamic(GLenum prim, int offset, int count)
+{
+    qglUseProgram(gl4.dyn_prog);
+    qglProgramUniform1i(gl4.dyn_prog, gl4.u_dyn_fog, qglIsEnabled(GL_FOG) ? 1 : 0);
+    qglVertexArrayVertexBuffer(gl4.dyn_vao, 0, gl4.ring, offset, sizeof(r_dynvert_t));
+    qglBindVertexArray(gl4.dyn_vao);
+    qglDrawArrays(prim, 0, count);
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+void R_GL4_DrawParticles(int offset, int count)
+{
+    float   proj[16];
+    GLint   viewport[4];
+
+    /* Pixels covered by one world unit at distance one */
+    qglGetFloatv(GL_PROJECTION_MATRIX, proj);
+    qglGetIntegerv(GL_VIEWPORT, viewport);
+
+    qglUseProgram(gl4.part_prog);
+    qglProgramUniform1f(gl4.part_prog, gl4.u_pointscale, proj[5] * viewport[3] * 0.5f);
+    qglProgramUniform1i(gl4.part_prog, gl4.u_part_fog, qglIsEnabled(GL_FOG) ? 1 : 0);
+    qglVertexArrayVertexBuffer(gl4.part_vao, 0, gl4.ring, offset, sizeof(r_partvert_t));
+    qglBindVertexArray(gl4.part_vao);
+    qglEnable(GL_PROGRAM_POINT_SIZE);
+    qglDrawArrays(GL_POINTS, 0, count);
+    qglDisable(GL_PROGRAM_POINT_SIZE);
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+/* ==========================================================================
+   2D
+   ========================================================================== */
+
+/* r_drawvert_t vertices already in the ring at offset; the caller binds
+ * each texture and draws its ranges with glDrawArrays until R_GL4_End2D */
+void R_GL4_Begin2D(int offset)
+{
+    qglUseProgram(gl4.ui_prog);
+    qglVertexArrayVertexBuffer(gl4.ui_vao, 0, gl4.ring, offset, sizeof(r_drawvert_t));
+    qglBindVertexArray(gl4.ui_vao);
+}
+
+void R_GL4_End2D(void)
+{
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+/* ==========================================================================
+   Alias Models
+   ========================================================================== */
+
+/* Static buffers for an MD2: numframes * numverts positions, st per vertex */
+void R_GL4_CreateAliasMesh(r_gl4alias_t *out, const float *frames, int numframes,
+                           int numverts, const float *st, const uint16_t *indices,
+                           int numindices)
+{
+    qglCreateBuffers(1, &out->frames);
+    qglNamedBufferStorage(out->frames, numframes * numverts * 3 * (int)sizeof(float),
+                          frames, 0);
+    qglCreateBuffers(1, &out->st);
+    qglNamedBufferStorage(out->st, numverts * 2 * (int)sizeof(float), st, 0);
+    qglCreateBuffers(1, &out->ibo);
+    qglNamedBufferStorage(out->ibo, numindices * (int)sizeof(uint16_t), indices, 0);
+
+    qglCreateVertexArrays(1, &out->vao);
+    qglEnableVertexArrayAttrib(out->vao, 0);
+    qglVertexArrayAttribFormat(out->vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    qglVertexArrayAttribBinding(out->vao, 0, 0);
+    qglVertexArrayVertexBuffer(out->vao, 0, out->st, 0, 2 * sizeof(float));
+    qglVertexArrayElementBuffer(out->vao, out->ibo);
+
+    out->numindices = numindices;
+}
+
+void R_GL4_FreeAliasMesh(r_gl4alias_t *mesh)
+{
+    if (!mesh->vao || !qglDeleteBuffers)
+        return;
+
+    qglDeleteVertexArrays(1, &mesh->vao);
+    qglDeleteBuffers(1, &mesh->frames);
+    qglDeleteBuffers(1, &mesh->st);
+    qglDeleteBuffers(1, &mesh->ibo);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+/*
+ * count copies of an MD2 in one draw, their r_aliasinst_t records already
+ * in the ring from R_GL4_StorageAlloc. texnum 0 draws untextured.
+ */
+void R_GL4_DrawAlias(const r_gl4alias_t *mesh, GLuint texnum, float zmin, float zscale,
+                     int inst_ofs, int count)
+{
+    if (!mesh->vao || count <= 0)
+        return;
+
+    qglUseProgram(gl4.alias_prog);
+    qglProgramUniform1i(gl4.alias_prog, gl4.u_alias_fog, qglIsEnabled(GL_FOG) ? 1 : 0);
+    qglProgramUniform1i(gl4.alias_prog, gl4.u_alias_textured, texnum != 0);
+    qglProgramUniform2f(gl4.alias_prog, gl4.u_zrange, zmin, zscale);
+    if (texnum)
+        qglBindTexture(GL_TEXTURE_2D, texnum);
+
+    qglBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh->frames);
+    qglBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, gl4.ring, inst_ofs,
+                       count * (int)sizeof(r_aliasinst_t));
+    qglBindVertexArray(mesh->vao);
+    qglDrawElementsInstanced(GL_TRIANGLES, mesh->numindices, GL_UNSIGNED_SHORT, NULL, count);
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+/* ==========================================================================
+   Skinned Meshes
+   ========================================================================== */
+
+/* Static GHOUL mesh; returns the handle to draw it with, -1 if out of room */
+int R_GL4_CreateSkinMesh(const r_skinvert_t *verts, int numverts,
+                         const uint16_t *indices, int numindices)
+{
+    int     n = gl4.num_skin_meshes;
+    GLuint  vao;
+    int     i;
+
+    if (n == GL4_MAX_SKIN_MESHES)
+        return -1;
+
+    qglCreateBuffers(1, &gl4.skin_meshes[n].vbo);
+    qglNamedBufferStorage(gl4.skin_meshes[n].vbo, numverts * (int)sizeof(r_skinvert_t),
+                          verts, 0);
+    qglCreateBuffers(1, &gl4.skin_meshes[n].ibo);
+    qglNamedBufferStorage(gl4.skin_meshes[n].ibo, numindices * (int)sizeof(uint16_t),
+                          indices, 0);
+
+    qglCreateVertexArrays(1, &vao);
+    for (i = 0; i < 5; i++) {
+        qglEnableVertexArrayAttrib(vao, i);
+        qglVertexArrayAttribBinding(vao, i, 0);
+    }
+    qglVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(r_skinvert_t, xyz));
+    qglVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(r_skinvert_t, normal));
+    qglVertexArrayAttribIFormat(vao, 2, 1, GL_UNSIGNED_INT, offsetof(r_skinvert_t, bone));
+    qglVertexArrayAttribIFormat(vao, 3, 1, GL_UNSIGNED_INT, offsetof(r_skinvert_t, hide));
+    qglVertexArrayAttribIFormat(vao, 4, 1, GL_UNSIGNED_INT, offsetof(r_skinvert_t, damage));
+    qglVertexArrayVertexBuffer(vao, 0, gl4.skin_meshes[n].vbo, 0, sizeof(r_skinvert_t));
+    qglVertexArrayElementBuffer(vao, gl4.skin_meshes[n].ibo);
+
+    gl4.skin_meshes[n].vao = vao;
+    gl4.skin_meshes[n].numindices = numindices;
+    gl4.num_skin_meshes++;
+    return n;
+}
+
+/*
+ * count instances of mesh in one draw. The bone palettes (three vec4 rows
+ * each) and the r_skininst_t records are already in the ring, from
+ * R_GL4_StorageAlloc.
+ */
+void R_GL4_DrawSkinned(int mesh, int bones_ofs, int bones_size, int inst_ofs, int count)
+{
+    if (mesh < 0 || mesh >= gl4.num_skin_meshes || count <= 0)
+        return;
+
+    qglUseProgram(gl4.skin_prog);
+    qglProgramUniform1i(gl4.skin_prog, gl4.u_skin_fog, qglIsEnabled(GL_FOG) ? 1 : 0);
+    qglBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, gl4.ring, bones_ofs, bones_size);
+    qglBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, gl4.ring, inst_ofs,
+                       count * (int)sizeof(r_skininst_t));
+    qglBindVertexArray(gl4.skin_meshes[mesh].vao);
+    qglDrawElementsInstanced(GL_TRIANGLES, gl4.skin_meshes[mesh].numindices,
+                             GL_UNSIGNED_SHORT, NULL, count);
+    qglBindVertexArray(0);
+    qglUseProgram(0);
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+/* Called before the window exists: ask for a context this path can use */
+void R_GL4_RequestContext(void)
+{
+    r_gl4 = Cvar_Get("r_gl4", "1", CVAR_ARCHIVE | CVAR_LATCH);
+    if (r_gl4->value)
+        Sys_GL_RequestVersion(4, 5);
+}
+
+qboolean R_GL4_Init(void)
+{
+    GLint major = 0, minor = 0;
+
+    gl_state.gl4 = qfalse;
+    if (!r_gl4 || !r_gl4->value)
+        return qfalse;
+
+    qglGetIntegerv(GL_MAJOR_VERSION, &major);
+    qglGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 5)) {
+        Com_Printf("GL4: context is %d.%d, using the GL 1.x path\n", major, minor);
+        return qfalse;
+    }
+
+    if (!R_GL4_LoadFunctions() || !qglActiveTextureARB)
+        return qfalse;
+
+    gl4.world_prog = R_GL4_BuildProgram(gl4_world_vs, gl4_world_fs, "world");
+    gl4.dyn_prog = R_GL4_BuildProgram(gl4_dyn_vs, gl4_dyn_fs, "dynamic");
+    gl4.part_prog = R_GL4_BuildProgram(gl4_part_vs, gl4_dyn_fs, "particle");
+    gl4.alias_prog = R_GL4_BuildProgram(gl4_alias_vs, gl4_world_fs, "alias");
+    gl4.skin_prog = R_GL4_BuildProgram(gl4_skin_vs, gl4_dyn_fs, "skin");
+    gl4.ui_prog = R_GL4_BuildProgram(gl4_2d_vs, gl4_2d_fs, "2d");
+    if (!gl4.world_prog || !gl4.dyn_prog || !gl4.part_prog || !gl4.alias_prog ||
+        !gl4.skin_prog || !gl4.ui_prog) {
+        R_GL4_Shutdown();
+        return qfalse;
+    }
+
+    gl4.u_warp = qglGetUniformLocation(gl4.world_prog, "u_warp");
+    gl4.u_time = qglGetUniformLocation(gl4.world_prog, "u_time");
+    gl4.u_textured = qglGetUniformLocation(gl4.world_prog, "u_textured");
+    gl4.u_lightmapped = qglGetUniformLocation(gl4.world_prog, "u_lightmapped");
+    gl4.u_alpharef = qglGetUniformLocation(gl4.world_prog, "u_alpharef");
+    gl4.u_fog = qglGetUniformLocation(gl4.world_prog, "u_fog");
+    gl4.u_dyn_fog = qglGetUniformLocation(gl4.dyn_prog, "u_fog");
+    gl4.u_part_fog = qglGetUniformLocation(gl4.part_prog, "u_fog");
+    gl4.u_pointscale = qglGetUniformLocation(gl4.part_prog, "u_pointscale");
+    gl4.u_skin_fog = qglGetUniformLocation(gl4.skin_prog, "u_fog");
+    gl4.u_alias_textured = qglGetUniformLocation(gl4.alias_prog, "u_textured");
+    gl4.u_alias_fog = qglGetUniformLocation(gl4.alias_prog, "u_fog");
+    gl4.u_zrange = qglGetUniformLocation(gl4.alias_prog, "u_zrange");
+    qglProgramUniform1i(gl4.alias_prog, qglGetUniformLocation(gl4.alias_prog, "u_lightmapped"), 0);
+    qglProgramUniform1f(gl4.alias_prog, qglGetUniformLocation(gl4.alias_prog, "u_alpharef"), -1.0f);
+
+    gl4.ssbo_align = 16;
+    qglGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &gl4.ssbo_align);
+    if (gl4.ssbo_align < 16)
+        gl4.ssbo_align = 16;
+
+    /* Ring: written by the CPU through a permanent mapping */
+    qglCreateBuffers(1, &gl4.ring);
+    qglNamedBufferStorage(gl4.ring, GL4_RING_SEGMENTS * GL4_RING_SEGSIZE, NULL,
+                          GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    gl4.ring_base = qglMapNamedBufferRange(gl4.ring, 0, GL4_RING_SEGMENTS * GL4_RING_SEGSIZE,
+                          GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    if (!gl4.ring_base) {
+        Com_Printf("GL4: couldn't map the ring buffer\n");
+        R_GL4_Shutdown();
+        return qfalse;
+    }
+
+    /* World: vertex buffer attached per map, indices from the ring */
+    qglCreateVertexArrays(1, &gl4.world_vao);
+    qglEnableVertexArrayAttrib(gl4.world_vao, 0);
+    qglEnableVertexArrayAttrib(gl4.world_vao, 1);
+    qglEnableVertexArrayAttrib(gl4.world_vao, 2);
+    qglVertexArrayAttribBinding(gl4.world_vao, 0, 0);
+    qglVertexArrayAttribBinding(gl4.world_vao, 1, 0);
+    qglVertexArrayAttribBinding(gl4.world_vao, 2, 0);
+    qglVertexArrayElementBuffer(gl4.world_vao, gl4.ring);
+
+    /* Dynamic: position + byte color, straight from the ring */
+    qglCreateVertexArrays(1, &gl4.dyn_vao);
+    qglEnableVertexArrayAttrib(gl4.dyn_vao, 0);
+    qglEnableVertexArrayAttrib(gl4.dyn_vao, 1);
+    qglVertexArrayAttribFormat(gl4.dyn_vao, 0, 3, GL_FLOAT, GL_FALSE,
+                               offsetof(r_dynvert_t, xyz));
+    qglVertexArrayAttribFormat(gl4.dyn_vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                               offsetof(r_dynvert_t, rgba));
+    qglVertexArrayAttribBinding(gl4.dyn_vao, 0, 0);
+    qglVertexArrayAttribBinding(gl4.dyn_vao, 1, 0);
+
+    /* Particles: the dynamic layout plus a size */
+    qglCreateVertexArrays(1, &gl4.part_vao);
+    qglEnableVertexArrayAttrib(gl4.part_vao, 0);
+    qglEnableVertexArrayAttrib(gl4.part_vao, 1);
+    qglEnableVertexArrayAttrib(gl4.part_vao, 2);
+    qglVertexArrayAttribFormat(gl4.part_vao, 0, 3, GL_FLOAT, GL_FALSE,
+                               offsetof(r_partvert_t, v.xyz));
+    qglVertexArrayAttribFormat(gl4.part_vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                               offsetof(r_partvert_t, v.rgba));
+    qglVertexArrayAttribFormat(gl4.part_vao, 2, 1, GL_FLOAT, GL_FALSE,
+                               offsetof(r_partvert_t, size));
+    qglVertexArrayAttribBinding(gl4.part_vao, 0, 0);
+    qglVertexArrayAttribBinding(gl4.part_vao, 1, 0);
+    qglVertexArrayAttribBinding(gl4.part_vao, 2, 0);
+
+    /* 2D: screen position, texcoord, byte color */
+    qglCreateVertexArrays(1, &gl4.ui_vao);
+    qglEnableVertexArrayAttrib(gl4.ui_vao, 0);
+    qglEnableVertexArrayAttrib(gl4.ui_vao, 1);
+    qglEnableVertexArrayAttrib(gl4.ui_vao, 2);
+    qglVertexArrayAttribFormat(gl4.ui_vao, 0, 2, GL_FLOAT, GL_FALSE,
+                               offsetof(r_drawvert_t, xy));
+    qglVertexArrayAttribFormat(gl4.ui_vao, 1, 2, GL_FLOAT, GL_FALSE,
+                               offsetof(r_drawvert_t, st));
+    qglVertexArrayAttribFormat(gl4.ui_vao, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                               offsetof(r_drawvert_t, rgba));
+    qglVertexArrayAttribBinding(gl4.ui_vao, 0, 0);
+    qglVertexArrayAttribBinding(gl4.ui_vao, 1, 0);
+    qglVertexArrayAttribBinding(gl4.ui_vao, 2, 0);
+
+    gl_state.gl4 = qtrue;
+    Com_Printf("...using the OpenGL 4.5 path (%d MB ring)\n",
+               GL4_RING_SEGMENTS * GL4_RING_SEGSIZE / (1024 * 1024));
+    return qtrue;
+}
+
+void R_GL4_Shutdown(void)
+{
+    int i;
+
+    if (!qglDeleteProgram)
+        return;
+
+    for (i = 0; i < GL4_RING_SEGMENTS; i++) {
+        if (gl4.fence[i])
+            qglDeleteSync(gl4.fence[i]);
+    }
+    if (gl4.ring_base)
+        qglUnmapNamedBuffer(gl4.ring);
+    if (gl4.ring)
+        qglDeleteBuffers(1, &gl4.ring);
+    if (gl4.world_vbo)
+        qglDeleteBuffers(1, &gl4.world_vbo);
+    if (gl4.world_vao)
+        qglDeleteVertexArrays(1, &gl4.world_vao);
+    if (gl4.dyn_vao)
+        qglDeleteVertexArrays(1, &gl4.dyn_vao);
+    if (gl4.part_vao)
+        qglDeleteVertexArrays(1, &gl4.part_vao);
+    if (gl4.ui_vao)
+        qglDeleteVertexArrays(1, &gl4.ui_vao);
+    for (i = 0; i < gl4.num_skin_meshes; i++) {
+        qglDeleteVertexArrays(1, &gl4.skin_meshes[i].vao);
+        qglDeleteBuffers(1, &gl4.skin_meshes[i].vbo);
+        qglDeleteBuffers(1, &gl4.skin_meshes[i].ibo);
+    }
+    if (gl4.world_prog)
+        qglDeleteProgram(gl4.world_prog);
+    if (gl4.dyn_prog)
+        qglDeleteProgram(gl4.dyn_prog);
+    if (gl4.part_prog)
+        qglDeleteProgram(gl4.part_prog);
+    if (gl4.skin_prog)
+        qglDeleteProgram(gl4.skin_prog);
+    if (gl4.ui_prog)
+        qglDeleteProgram(gl4.ui_prog);
+    if (gl4.alias_prog)
+        qglDeleteProgram(gl4.alias_prog);
+
+    memset(&gl4, 0, sizeof(gl4));
+    gl_state.gl4 = qfalse;
+}
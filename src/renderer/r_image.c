@@ -25,15 +25,124 @@
    ========================================================================== */
 
 #define MAX_R_IMAGES    512
+#define IMAGE_HASH_SIZE 256     /* power of two */
 
 static image_t  r_images[MAX_R_IMAGES];
 static int      r_numimages;
 static int      r_registration_sequence;
+static image_t  *r_imagehash[IMAGE_HASH_SIZE];
 
 /* Checkerboard fallback texture */
 static GLuint   r_notexture;
 static GLuint   r_whitetexture;
 
+static image_t **R_ImageHashChain(const char *name)
+{
+    return &r_imagehash[Com_HashString(name) & (IMAGE_HASH_SIZE - 1)];
+}
+
+static image_t *R_LookupImage(const char *name)
+{
+    image_t *img;
+
+    for (img = *R_ImageHashChain(name); img; img = img->hash_next) {
+        if (Q_stricmp(img->name, name) == 0) {
+            img->registration_sequence = r_registration_sequence;
+            R_TouchImage(img);
+            return img;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * R_AllocImage - Reserve a cache slot, reusing slots released by
+ * R_ImageEndRegistration or by a failed load (name[0] == 0).
+ */
+static image_t *R_AllocImage(const char *name, imagetype_t type)
+{
+    image_t *img, **chain;
+    int     i;
+
+    for (i = 0; i < r_numimages; i++) {
+        if (!r_images[i].name[0])
+            break;
+    }
+    if (i == r_numimages) {
+        if (r_numimages >= MAX_R_IMAGES)
+            return NULL;
+        r_numimages++;
+    }
+
+    img = &r_images[i];
+    memset(img, 0, sizeof(*img));
+    Q_strncpyz(img->name, name, sizeof(img->name));
+    img->type = type;
+    img->sh = img->th = 1.0f;
+    img->registration_sequence = r_registration_sequence;
+    img->last_frame = r_framecount;
+
+    chain = R_ImageHashChain(img->name);
+    img->hash_next = *chain;
+    *chain = img;
+    return img;
+}
+
+/* ==========================================================================
+   Residency
+   Every image's video memory is counted. With r_texture_budget set,
+   R_ImageEndRegistration drops the top mip levels of the least recently
+   used wall textures (reloading them from disk at the smaller size) until
+   the set fits, and brings them back up when there is room again; this
+   all happens during the level load rather than mid-game.
+   ========================================================================== */
+
+#define R_MAX_MIP_SKIP  2
+
+static cvar_t   *r_texture_budget;
+static int      r_texture_bytes;    /* resident, every image */
+
+/* Free a texture on whichever path created it */
+void R_DeleteTexture(GLuint texnum)
+{
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_DeleteTexture(texnum);
+        return;
+    }
+#endif
+    qglDeleteTextures(1, &texnum);
+}
+
+/* Install a texture into an image, replacing any it had */
+static void R_SetImageTexture(image_t *img, GLuint texnum, int bytes, int full_bytes)
+{
+    if (img->texnum && img->texnum != texnum && !img->scrap)
+        R_DeleteTexture(img->texnum);
+    r_texture_bytes += bytes - img->bytes;
+
+    img->texnum = texnum;
+    img->bytes = bytes;
+    img->full_bytes = full_bytes;
+}
+
+/* Delete the texture and give the slot back */
+static void R_ReleaseImage(image_t *img)
+{
+    image_t **link;
+
+    for (link = R_ImageHashChain(img->name); *link; link = &(*link)->hash_next) {
+        if (*link == img) {
+            *link = img->hash_next;
+            break;
+        }
+    }
+
+    R_SetImageTexture(img, 0, 0, 0);
+    img->name[0] = 0;
+}
+
 /* ==========================================================================
    Q2 Palette (for WAL texture decoding)
    Approximate — the real palette is in colormap.pcx
@@ -74,11 +183,186 @@ static void R_LoadPalette(void)
    GL Texture Upload
    ========================================================================== */
 
+/*
+ * R_MipMap - 2x2 box filter one RGBA level down into `out`.
+ * Odd edges repeat their last texel.
+ */
+static void R_MipMap(const byte *in, int w, int h, byte *out)
+{
+    int nw = w > 1 ? w / 2 : 1;
+    int nh = h > 1 ? h / 2 : 1;
+    int x, y;
+
+    for (y = 0; y < nh; y++) {
+        for (x = 0; x < nw; x++) {
+            int sx = x * 2, sy = y * 2;
+            int src = (sy * w + sx) * 4;
+            int dst = (y * nw + x) * 4;
+            int c;
+            for (c = 0; c < 4; c++) {
+                int sum = in[src + c];
+                if (sx + 1 < w) sum += in[src + 4 + c]; else sum += in[src + c];
+                if (sy + 1 < h) sum += in[(src + w * 4) + c]; else sum += in[src + c];
+                if (sx + 1 < w && sy + 1 < h) sum += in[(src + w * 4 + 4) + c]; else sum += in[src + c];
+                out[dst + c] = (byte)(sum / 4);
+            }
+        }
+    }
+}
+
+/*
+ * Mip chains: level 0 followed directly by every smaller level down to 1x1,
+ * in one allocation. Built off the main thread by the background loader so
+ * the upload is nothing but glTexImage2D calls.
+ */
+static int R_MipChainSize(int w, int h)
+{
+    int size = 0;
+
+    for (;;) {
+        size += w * h * 4;
+        if (w == 1 && h == 1)
+            return size;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+}
+
+/* Fill in levels 1..n of a chain whose level 0 is already written */
+static void R_BuildMips(byte *chain, int w, int h)
+{
+    while (w > 1 || h > 1) {
+        byte *next = chain + w * h * 4;
+
+        R_MipMap(chain, w, h, next);
+        chain = next;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+}
+
+#ifdef SOF_RENDERER_GL4
+/* Immutable storage sized for the whole chain, filled with DSA */
+static GLuint R_GL4_UploadMipChain(const byte *chain, int width, int height)
+{
+    GLuint  texnum;
+    int     w, h, levels = 1, level;
+
+    for (w = width, h = height; w > 1 || h > 1; levels++) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    texnum = R_GL4_CreateTexture(width, height, levels, GL_RGBA8, qtrue);
+    for (level = 0; level < levels; level++) {
+        R_GL4_TextureLevel(texnum, level, width, height, GL_RGBA, chain);
+        chain += width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return texnum;
+}
+#endif
+
+#ifdef SOF_RENDERER_VULKAN
+/* One image for the whole chain, each level staged into it */
+static GLuint R_VK_UploadMipChain(const byte *chain, int width, int height)
+{
+    GLuint  texnum;
+    int     w, h, levels = 1, level;
+
+    for (w = width, h = height; w > 1 || h > 1; levels++) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    texnum = R_VK_CreateTexture(width, height, levels, GL_RGBA8, qtrue);
+    for (level = 0; level < levels; level++) {
+        R_VK_TextureLevel(texnum, level, width, height, GL_RGBA, chain);
+        chain += width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return texnum;
+}
+#endif
+
+static GLuint R_UploadMipChain(const byte *chain, int width, int height)
+{
+    GLuint  texnum;
+    int     level = 0;
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk)
+        return R_VK_UploadMipChain(chain, width, height);
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4)
+        return R_GL4_UploadMipChain(chain, width, height);
+#endif
+
+    qglGenTextures(1, &texnum);
+    qglBindTexture(GL_TEXTURE_2D, texnum);
+
+    for (;;) {
+        qglTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0,
+                      GL_RGBA, GL_UNSIGNED_BYTE, chain);
+        if (width == 1 && height == 1)
+            break;
+        chain += width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        level++;
+    }
+
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    return texnum;
+}
+
 static GLuint R_UploadTexture(byte *data, int width, int height,
                                qboolean mipmap, qboolean has_alpha)
 {
     GLuint texnum;
 
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        if (mipmap) {
+            byte *chain = Z_Malloc(R_MipChainSize(width, height));
+
+            memcpy(chain, data, width * height * 4);
+            R_BuildMips(chain, width, height);
+            texnum = R_VK_UploadMipChain(chain, width, height);
+            Z_Free(chain);
+        } else {
+            texnum = R_VK_CreateTexture(width, height, 1, GL_RGBA8, qtrue);
+            R_VK_TextureLevel(texnum, 0, width, height, GL_RGBA, data);
+        }
+        return texnum;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        if (mipmap) {
+            byte *chain = Z_Malloc(R_MipChainSize(width, height));
+
+            memcpy(chain, data, width * height * 4);
+            R_BuildMips(chain, width, height);
+            texnum = R_GL4_UploadMipChain(chain, width, height);
+            Z_Free(chain);
+        } else {
+            texnum = R_GL4_CreateTexture(width, height, 1, GL_RGBA8, qtrue);
+            R_GL4_TextureLevel(texnum, 0, width, height, GL_RGBA, data);
+        }
+        return texnum;
+    }
+#endif
+
     qglGenTextures(1, &texnum);
     qglBindTexture(GL_TEXTURE_2D, texnum);
 
@@ -98,26 +382,10 @@ static GLuint R_UploadTexture(byte *data, int width, int height,
             while (w > 1 || h > 1) {
                 int nw = w > 1 ? w / 2 : 1;
                 int nh = h > 1 ? h / 2 : 1;
-                int x, y;
 
                 prev = mip;
                 mip = (byte *)Z_Malloc(nw * nh * 4);
-
-                for (y = 0; y < nh; y++) {
-                    for (x = 0; x < nw; x++) {
-                        int sx = x * 2, sy = y * 2;
-                        int src = (sy * w + sx) * 4;
-                        int dst = (y * nw + x) * 4;
-                        int c;
-                        for (c = 0; c < 4; c++) {
-                            int sum = prev[src + c];
-                            if (sx + 1 < w) sum += prev[src + 4 + c]; else sum += prev[src + c];
-                            if (sy + 1 < h) sum += prev[(src + w * 4) + c]; else sum += prev[src + c];
-                            if (sx + 1 < w && sy + 1 < h) sum += prev[(src + w * 4 + 4) + c]; else sum += prev[src + c];
-                            mip[dst + c] = (byte)(sum / 4);
-                        }
-                    }
-                }
+                R_MipMap(prev, w, h, mip);
 
                 level++;
                 w = nw;
@@ -171,6 +439,111 @@ static void R_InitDefaultTextures(void)
     r_whitetexture = R_UploadTexture(white, 1, 1, qfalse, qfalse);
 }
 
+/* ==========================================================================
+   Scrap
+   Pics and r_draw.c's font share one atlas, so a HUD or console is mostly
+   a single texture and the 2D batcher draws it in a handful of calls.
+   Blocks are placed by column height, as Quake II's scrap does. Space is
+   never given back, so scrap pics stay resident across levels.
+   ========================================================================== */
+
+#define SCRAP_SIZE      1024
+#define SCRAP_MAX_PIC   256         /* bigger pics get their own texture */
+
+static int      scrap_allocated[SCRAP_SIZE];
+static GLuint   scrap_texnum;
+static int      scrap_used;         /* texels handed out */
+
+static qboolean Scrap_AllocBlock(int w, int h, int *x, int *y)
+{
+    int i, j, best, best2;
+
+    best = SCRAP_SIZE;
+    for (i = 0; i + w <= SCRAP_SIZE; i++) {
+        best2 = 0;
+        for (j = 0; j < w; j++) {
+            if (scrap_allocated[i + j] >= best)
+                break;
+            if (scrap_allocated[i + j] > best2)
+                best2 = scrap_allocated[i + j];
+        }
+        if (j == w) {
+            *x = i;
+            *y = best = best2;
+        }
+    }
+
+    if (best + h > SCRAP_SIZE)
+        return qfalse;
+
+    for (i = 0; i < w; i++)
+        scrap_allocated[*x + i] = best + h;
+    scrap_used += w * h;
+    return qtrue;
+}
+
+static void R_InitScrap(void)
+{
+    byte *clear = (byte *)Z_Malloc(SCRAP_SIZE * SCRAP_SIZE * 4);
+
+    memset(scrap_allocated, 0, sizeof(scrap_allocated));
+    scrap_used = 0;
+    scrap_texnum = R_UploadTexture(clear, SCRAP_SIZE, SCRAP_SIZE, qfalse, qtrue);
+    Z_Free(clear);
+}
+
+/*
+ * R_ScrapPic - Put a pic in the scrap if it fits, with a one texel border
+ * of its own edge pixels so filtering never reaches a neighbour. False
+ * leaves the image alone for a texture of its own.
+ */
+static qboolean R_ScrapPic(image_t *img, const byte *rgba, int w, int h)
+{
+    byte    *block;
+    int     bw = w + 2, bh = h + 2;
+    int     bx, by, x, y;
+
+    if (!scrap_texnum || w > SCRAP_MAX_PIC || h > SCRAP_MAX_PIC)
+        return qfalse;
+    if (!Scrap_AllocBlock(bw, bh, &bx, &by))
+        return qfalse;
+
+    block = (byte *)Z_Malloc(bw * bh * 4);
+    for (y = 0; y < bh; y++) {
+        int sy = y == 0 ? 0 : y > h ? h - 1 : y - 1;
+
+        for (x = 0; x < bw; x++) {
+            int sx = x == 0 ? 0 : x > w ? w - 1 : x - 1;
+
+            memcpy(block + (y * bw + x) * 4, rgba + (sy * w + sx) * 4, 4);
+        }
+    }
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_TextureRect(scrap_texnum, bx, by, bw, bh, GL_RGBA, block);
+    } else
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        R_GL4_TextureRect(scrap_texnum, bx, by, bw, bh, GL_RGBA, block);
+    } else
+#endif
+    {
+        qglBindTexture(GL_TEXTURE_2D, scrap_texnum);
+        qglTexSubImage2D(GL_TEXTURE_2D, 0, bx, by, bw, bh, GL_RGBA, GL_UNSIGNED_BYTE, block);
+    }
+    Z_Free(block);
+
+    img->scrap = qtrue;
+    img->texnum = scrap_texnum;
+    img->sl = (bx + 1) / (float)SCRAP_SIZE;
+    img->tl = (by + 1) / (float)SCRAP_SIZE;
+    img->sh = (bx + 1 + w) / (float)SCRAP_SIZE;
+    img->th = (by + 1 + h) / (float)SCRAP_SIZE;
+    return qtrue;
+}
+
 /* ==========================================================================
    WAL Texture Loader (Quake II standard)
    ========================================================================== */
@@ -186,38 +559,34 @@ typedef struct {
     int     value;
 } wal_header_t;
 
-static image_t *R_LoadWAL(const char *name, byte *raw, int rawlen)
+/*
+ * R_DecodeWAL - Expand mip 0 through the Q2 palette into a fresh RGBA mip
+ * chain. Touches nothing but its arguments and q2_palette, so it is safe on
+ * a loader thread.
+ */
+static byte *R_DecodeWAL(const byte *raw, int rawlen, int *width, int *height)
 {
-    wal_header_t    *wal;
-    image_t         *img;
-    byte            *pixels;
-    byte            *rgba;
-    int             i, size;
+    const wal_header_t  *wal;
+    const byte          *pixels;
+    byte                *rgba;
+    int                 i, size;
 
     if (rawlen < (int)sizeof(wal_header_t))
         return NULL;
 
-    wal = (wal_header_t *)raw;
+    wal = (const wal_header_t *)raw;
 
     if (wal->width <= 0 || wal->height <= 0 ||
         wal->width > 2048 || wal->height > 2048)
         return NULL;
 
     size = wal->width * wal->height;
-    if (wal->offsets[0] + size > rawlen)
+    if (wal->offsets[0] < 0 || wal->offsets[0] + size > rawlen)
         return NULL;
 
-    /* Find or create image slot */
-    img = &r_images[r_numimages++];
-    memset(img, 0, sizeof(*img));
-    Q_strncpyz(img->name, name, sizeof(img->name));
-    img->width = wal->width;
-    img->height = wal->height;
-    img->type = it_wall;
-
     /* Convert 8-bit paletted to RGBA */
     pixels = raw + wal->offsets[0];
-    rgba = (byte *)Z_Malloc(size * 4);
+    rgba = (byte *)Z_Malloc(R_MipChainSize(wal->width, wal->height));
 
     for (i = 0; i < size; i++) {
         byte idx = pixels[i];
@@ -227,10 +596,11 @@ static image_t *R_LoadWAL(const char *name, byte *raw, int rawlen)
         rgba[i * 4 + 3] = 255;
     }
 
-    img->texnum = R_UploadTexture(rgba, wal->width, wal->height, qtrue, qfalse);
-    Z_Free(rgba);
+    R_BuildMips(rgba, wal->width, wal->height);
 
-    return img;
+    *width = wal->width;
+    *height = wal->height;
+    return rgba;
 }
 
 /* ==========================================================================
@@ -254,59 +624,231 @@ static image_t *R_LoadWAL(const char *name, byte *raw, int rawlen)
 #define M32_MIP_OFFSETS_OFS   0x284
 #define M32_HEADER_SIZE       968
 
-static image_t *R_LoadM32(const char *name, byte *raw, int rawlen)
+/*
+ * R_DecodeM32 - Copy mip 0 out of an M32 into a fresh RGBA mip chain.
+ * The stored mips are ignored; they are rebuilt with the same filter WAL
+ * textures get. Safe on a loader thread.
+ */
+static byte *R_DecodeM32(const char *name, const byte *raw, int rawlen,
+                         int *width, int *height, qboolean *has_alpha)
 {
-    image_t     *img;
-    int         width, height;
+    int         w, h;
     int         data_offset;
     int         size;
+    byte        *rgba;
 
     if (rawlen < M32_HEADER_SIZE + 4)
         return NULL;
 
-    width = LittleLong(*(int *)(raw + M32_MIP_WIDTHS_OFS));
-    height = LittleLong(*(int *)(raw + M32_MIP_HEIGHTS_OFS));
+    w = LittleLong(*(const int *)(raw + M32_MIP_WIDTHS_OFS));
+    h = LittleLong(*(const int *)(raw + M32_MIP_HEIGHTS_OFS));
 
-    if (width <= 0 || height <= 0 || width > 2048 || height > 2048)
+    if (w <= 0 || h <= 0 || w > 2048 || h > 2048)
         return NULL;
 
-    data_offset = LittleLong(*(int *)(raw + M32_MIP_OFFSETS_OFS));
+    data_offset = LittleLong(*(const int *)(raw + M32_MIP_OFFSETS_OFS));
     if (data_offset <= 0 || data_offset >= rawlen)
         data_offset = M32_HEADER_SIZE;
 
-    size = width * height * 4;  /* RGBA8888 */
+    size = w * h * 4;  /* RGBA8888 */
 
     if (data_offset + size > rawlen) {
         Com_DPrintf("R_LoadM32: %s data doesn't fit (w=%d h=%d ofs=%d len=%d)\n",
-                   name, width, height, data_offset, rawlen);
+                   name, w, h, data_offset, rawlen);
         return NULL;
     }
 
-    /* Find or create image slot */
-    img = &r_images[r_numimages++];
-    memset(img, 0, sizeof(*img));
-    Q_strncpyz(img->name, name, sizeof(img->name));
-    img->width = width;
-    img->height = height;
-    img->type = it_wall;
+    rgba = (byte *)Z_Malloc(R_MipChainSize(w, h));
+    memcpy(rgba, raw + data_offset, size);
 
     /* M32 stores RGBA directly — check if actually has transparent pixels */
     {
-        byte *pixels = raw + data_offset;
-        int npix = width * height;
+        int npix = w * h;
         int j;
-        qboolean real_alpha = qfalse;
+        *has_alpha = qfalse;
         for (j = 0; j < npix; j++) {
-            if (pixels[j * 4 + 3] < 255) {
-                real_alpha = qtrue;
+            if (rgba[j * 4 + 3] < 255) {
+                *has_alpha = qtrue;
                 break;
             }
         }
-        img->texnum = R_UploadTexture(pixels, width, height, qtrue, real_alpha);
-        img->has_alpha = real_alpha;
     }
 
-    return img;
+    R_BuildMips(rgba, w, h);
+
+    *width = w;
+    *height = h;
+    return rgba;
+}
+
+/* ==========================================================================
+   Background Texture Loading
+   Wall textures (and M32 pics) are read and decoded by FS_AsyncQueue
+   workers; only the GL upload happens on the main thread.
+   ========================================================================== */
+
+typedef struct {
+    image_t     *img;           /* reserved slot; img->pending while queued */
+    char        name[MAX_QPATH];
+    imagetype_t type;
+    byte        *pixels;        /* decoded mip chain, NULL if nothing loaded */
+    int         width, height;
+    qboolean    has_alpha;
+    texformat_t format;         /* of pixels; block-compressed for walls with r_texcompress */
+    int         mip_skip;       /* levels to leave out of the upload */
+} imgload_t;
+
+/* A cached conversion of this file, if r_texcache has a current one */
+static qboolean R_ImageLoadCached(imgload_t *ld, const char *fullname)
+{
+    if (ld->type != it_wall)
+        return qfalse;
+    return R_TexCacheLoad(fullname, &ld->pixels, &ld->width, &ld->height,
+                          &ld->has_alpha, &ld->format);
+}
+
+/* Convert a freshly decoded wall texture, and remember the result */
+static void R_ImageLoadConvert(imgload_t *ld, const char *fullname)
+{
+    texformat_t format = R_TexTargetFormat(ld->has_alpha);
+    byte        *blocks;
+
+    if (ld->type != it_wall || format == TF_RGBA)
+        return;
+
+    blocks = R_CompressMipChain(ld->pixels, ld->width, ld->height, format);
+    R_TexCacheStore(fullname, blocks, ld->width, ld->height, ld->has_alpha, format);
+
+    Z_Free(ld->pixels);
+    ld->pixels = blocks;
+    ld->format = format;
+}
+
+/* Worker thread: find and decode the file, no GL */
+static void R_ImageLoadWork(void *ctx)
+{
+    imgload_t   *ld = (imgload_t *)ctx;
+    const byte  *raw;
+    char        fullname[MAX_QPATH];
+    int         len;
+
+    /* Try M32 first (SoF enhanced format) */
+    Com_sprintf(fullname, sizeof(fullname), "%s/%s.m32",
+                ld->type == it_pic ? "pics" : "textures", ld->name);
+    if (R_ImageLoadCached(ld, fullname))
+        return;
+    len = FS_MapFile(fullname, (const void **)&raw);
+    if (raw) {
+        ld->pixels = R_DecodeM32(ld->name, raw, len, &ld->width, &ld->height,
+                                 &ld->has_alpha);
+        FS_UnmapFile(raw);
+        if (ld->pixels) {
+            R_ImageLoadConvert(ld, fullname);
+            return;
+        }
+    }
+
+    /* Pics fall back to TGA/PCX in R_FindPic */
+    if (ld->type == it_pic)
+        return;
+
+    /* Try WAL (Q2 standard format) */
+    Com_sprintf(fullname, sizeof(fullname), "textures/%s.wal", ld->name);
+    if (R_ImageLoadCached(ld, fullname))
+        return;
+    len = FS_MapFile(fullname, (const void **)&raw);
+    if (raw) {
+        ld->pixels = R_DecodeWAL(raw, len, &ld->width, &ld->height);
+        ld->has_alpha = qfalse;
+        FS_UnmapFile(raw);
+        if (ld->pixels)
+            R_ImageLoadConvert(ld, fullname);
+    }
+}
+
+/* Main thread: upload, or give the slot back if nothing decoded */
+static void R_ImageLoadDone(void *ctx)
+{
+    imgload_t   *ld = (imgload_t *)ctx;
+    image_t     *img = ld->img;
+
+    img->pending = qfalse;
+
+    if (ld->pixels) {
+        const byte  *chain = ld->pixels;
+        int         w = ld->width, h = ld->height, level;
+        GLuint      texnum;
+
+        /* Budget-downsampled: upload from a smaller level of the chain */
+        for (level = 0; level < ld->mip_skip && (w > 1 || h > 1); level++) {
+            chain += R_TexLevelSize(ld->format, w, h);
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+
+        img->width = ld->width;
+        img->height = ld->height;
+        img->upload_width = w;
+        img->upload_height = h;
+        img->has_alpha = ld->has_alpha;
+        img->mip_skip = level;
+        if (img->type != it_pic || ld->format != TF_RGBA || !R_ScrapPic(img, chain, w, h)) {
+            if (ld->format != TF_RGBA)
+                texnum = R_UploadCompressedChain(chain, w, h, ld->format);
+            else
+                texnum = R_UploadMipChain(chain, w, h);
+            R_SetImageTexture(img, texnum, R_TexChainSize(ld->format, w, h),
+                              R_TexChainSize(ld->format, ld->width, ld->height));
+        }
+        Z_Free(ld->pixels);
+    } else if (!img->texnum) {
+        R_ReleaseImage(img);
+    }
+    /* else a budget reload that failed: keep what is resident */
+
+    Z_Free(ld);
+}
+
+static imgload_t *R_NewImageLoad(image_t *img)
+{
+    imgload_t *ld = (imgload_t *)Z_Malloc(sizeof(*ld));
+
+    ld->img = img;
+    Q_strncpyz(ld->name, img->name, sizeof(ld->name));
+    ld->type = img->type;
+    ld->format = TF_RGBA;
+    ld->mip_skip = img->mip_skip;
+    return ld;
+}
+
+/* Load into a reserved slot right now; false if the slot was released */
+static qboolean R_LoadImageNow(image_t *img)
+{
+    imgload_t *ld = R_NewImageLoad(img);
+
+    R_ImageLoadWork(ld);
+    R_ImageLoadDone(ld);
+    return img->name[0] != 0;
+}
+
+/*
+ * R_PrecacheImage - Queue a wall texture on the background loader so that
+ * a later R_FindImage of the same name only waits if the decode or upload
+ * hasn't happened yet.
+ */
+void R_PrecacheImage(const char *name)
+{
+    image_t *img;
+
+    if (!name || !name[0] || R_LookupImage(name))
+        return;
+
+    img = R_AllocImage(name, it_wall);
+    if (!img)
+        return;     /* R_FindImage reports the overflow */
+
+    img->pending = qtrue;
+    FS_AsyncQueue(R_ImageLoadWork, R_ImageLoadDone, R_NewImageLoad(img));
 }
 
 /* ==========================================================================
@@ -399,19 +941,20 @@ static image_t *R_LoadPCX(const char *name, byte *raw, int rawlen, imagetype_t t
         }
     }
 
-    if (r_numimages >= MAX_R_IMAGES) {
+    img = R_AllocImage(name, type);
+    if (!img) {
         Z_Free(rgba);
         return NULL;
     }
 
-    img = &r_images[r_numimages++];
-    memset(img, 0, sizeof(*img));
-    Q_strncpyz(img->name, name, sizeof(img->name));
     img->width = width;
     img->height = height;
-    img->type = type;
+    img->upload_width = width;
+    img->upload_height = height;
     img->has_alpha = (type == it_pic) ? qtrue : qfalse;
-    img->texnum = R_UploadTexture(rgba, width, height, qfalse, img->has_alpha);
+    if (type != it_pic || !R_ScrapPic(img, rgba, width, height))
+        R_SetImageTexture(img, R_UploadTexture(rgba, width, height, qfalse, img->has_alpha),
+                          width * height * 4, width * height * 4);
 
     Z_Free(rgba);
     return img;
@@ -473,19 +1016,21 @@ static image_t *R_LoadTGA(const char *name, byte *raw, int rawlen, imagetype_t t
         rgba[dst + 3] = has_alpha ? src[sidx + 3] : 255;
     }
 
-    if (r_numimages >= MAX_R_IMAGES) {
+    img = R_AllocImage(name, type);
+    if (!img) {
         Z_Free(rgba);
         return NULL;
     }
 
-    img = &r_images[r_numimages++];
-    memset(img, 0, sizeof(*img));
-    Q_strncpyz(img->name, name, sizeof(img->name));
     img->width = width;
     img->height = height;
-    img->type = type;
+    img->upload_width = width;
+    img->upload_height = height;
     img->has_alpha = has_alpha;
-    img->texnum = R_UploadTexture(rgba, width, height, (type == it_wall), has_alpha);
+    size = type == it_wall ? R_MipChainSize(width, height) : width * height * 4;
+    if (type != it_pic || !R_ScrapPic(img, rgba, width, height))
+        R_SetImageTexture(img, R_UploadTexture(rgba, width, height, (type == it_wall), has_alpha),
+                          size, size);
 
     Z_Free(rgba);
     return img;
@@ -507,34 +1052,21 @@ image_t *R_FindPic(const char *name)
     byte    *raw;
     int     len;
     char    fullname[MAX_QPATH];
-    int     i;
 
     if (!name || !name[0])
         return NULL;
 
     /* Search existing images */
-    for (i = 0; i < r_numimages; i++) {
-        if (Q_stricmp(r_images[i].name, name) == 0) {
-            r_images[i].registration_sequence = r_registration_sequence;
-            return &r_images[i];
-        }
-    }
-
-    if (r_numimages >= MAX_R_IMAGES)
-        return NULL;
+    img = R_LookupImage(name);
+    if (img)
+        return img;
 
     /* Try M32 */
-    Com_sprintf(fullname, sizeof(fullname), "pics/%s.m32", name);
-    len = FS_LoadFile(fullname, (void **)&raw);
-    if (raw) {
-        img = R_LoadM32(name, raw, len);
-        FS_FreeFile(raw);
-        if (img) {
-            img->type = it_pic;
-            img->registration_sequence = r_registration_sequence;
-            return img;
-        }
-    }
+    img = R_AllocImage(name, it_pic);
+    if (!img)
+        return NULL;
+    if (R_LoadImageNow(img))
+        return img;
 
     /* Try TGA */
     Com_sprintf(fullname, sizeof(fullname), "pics/%s.tga", name);
@@ -563,6 +1095,30 @@ image_t *R_FindPic(const char *name)
     return NULL;
 }
 
+/*
+ * R_LoadPicPixels - A pic made in code rather than read from pics/, such
+ * as the console font. Found again by name with R_FindPic.
+ */
+image_t *R_LoadPicPixels(const char *name, const byte *rgba, int width, int height)
+{
+    image_t *img = R_LookupImage(name);
+
+    if (img)
+        return img;
+
+    img = R_AllocImage(name, it_pic);
+    if (!img)
+        return NULL;
+
+    img->width = img->upload_width = width;
+    img->height = img->upload_height = height;
+    img->has_alpha = qtrue;
+    if (!R_ScrapPic(img, rgba, width, height))
+        R_SetImageTexture(img, R_UploadTexture((byte *)rgba, width, height, qfalse, qtrue),
+                          width * height * 4, width * height * 4);
+    return img;
+}
+
 /* ==========================================================================
    Texture Lookup
    ========================================================================== */
@@ -578,53 +1134,30 @@ image_t *R_FindPic(const char *name)
 image_t *R_FindImage(const char *name)
 {
     image_t *img;
-    byte    *raw;
-    int     len;
-    char    fullname[MAX_QPATH];
-    int     i;
 
     if (!name || !name[0])
         return NULL;
 
-    /* Search existing images */
-    for (i = 0; i < r_numimages; i++) {
-        if (Q_stricmp(r_images[i].name, name) == 0) {
-            r_images[i].registration_sequence = r_registration_sequence;
-            return &r_images[i];
-        }
+    /* Search existing images; a precached one may still be in flight */
+    img = R_LookupImage(name);
+    if (img) {
+        while (img->pending && FS_AsyncPump(qtrue))
+            ;
+        return img->name[0] ? img : NULL;
     }
 
-    if (r_numimages >= MAX_R_IMAGES) {
+    img = R_AllocImage(name, it_wall);
+    if (!img) {
         Com_Printf("R_FindImage: MAX_R_IMAGES exceeded\n");
         return NULL;
     }
 
-    /* Try M32 first (SoF enhanced format) */
-    Com_sprintf(fullname, sizeof(fullname), "textures/%s.m32", name);
-    len = FS_LoadFile(fullname, (void **)&raw);
-    if (raw) {
-        img = R_LoadM32(name, raw, len);
-        FS_FreeFile(raw);
-        if (img) {
-            img->registration_sequence = r_registration_sequence;
-            return img;
-        }
-    }
-
-    /* Try WAL (Q2 standard format) */
-    Com_sprintf(fullname, sizeof(fullname), "textures/%s.wal", name);
-    len = FS_LoadFile(fullname, (void **)&raw);
-    if (raw) {
-        img = R_LoadWAL(name, raw, len);
-        FS_FreeFile(raw);
-        if (img) {
-            img->registration_sequence = r_registration_sequence;
-            return img;
-        }
+    if (!R_LoadImageNow(img)) {
+        Com_DPrintf("R_FindImage: couldn't load %s\n", name);
+        return NULL;
     }
 
-    Com_DPrintf("R_FindImage: couldn't load %s\n", name);
-    return NULL;
+    return img;
 }
 
 /*
@@ -698,15 +1231,140 @@ GLuint R_LoadSkyTexture(const char *path)
 
     texnum = R_UploadTexture(rgba, width, height, qfalse, has_alpha);
 
-    /* Set clamp-to-edge to avoid seams */
-    qglBindTexture(GL_TEXTURE_2D, texnum);
-    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); /* GL_CLAMP_TO_EDGE */
-    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+    /* Set clamp-to-edge to avoid seams (the Vulkan path doesn't draw skies) */
+    if (!gl_state.vk) {
+        qglBindTexture(GL_TEXTURE_2D, texnum);
+        qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F); /* GL_CLAMP_TO_EDGE */
+        qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+    }
 
     Z_Free(rgba);
     return texnum;
 }
 
+/* ==========================================================================
+   Texture Budget
+   ========================================================================== */
+
+/* Least recently used first: older registration, then older last use */
+static int R_ImageLRUCompare(const void *a, const void *b)
+{
+    const image_t *ia = *(const image_t * const *)a;
+    const image_t *ib = *(const image_t * const *)b;
+
+    if (ia->registration_sequence != ib->registration_sequence)
+        return ia->registration_sequence - ib->registration_sequence;
+    if (ia->last_frame != ib->last_frame)
+        return ia->last_frame - ib->last_frame;
+    return ib->bytes - ia->bytes;
+}
+
+/*
+ * Fit the resident set into r_texture_budget (megabytes, 0 = no limit).
+ * Each skipped level cuts a texture to about a quarter; the plan uses
+ * that estimate, and the real sizes are counted once the reloads land.
+ */
+static void R_EnforceTextureBudget(void)
+{
+    image_t **lru;
+    int     *skip, *bytes;
+    int     budget, resident = r_texture_bytes, numlru = 0, pass, i;
+
+    budget = (int)(r_texture_budget->value * 1024 * 1024);
+    if (budget < 0)
+        budget = 0;
+    if (!r_numimages)
+        return;
+
+    lru = (image_t **)Z_Malloc(r_numimages * sizeof(*lru));
+    for (i = 0; i < r_numimages; i++) {
+        image_t *img = &r_images[i];
+
+        /* Walls reload through the async path; pics are small and 2D */
+        if (img->name[0] && img->type == it_wall && img->texnum && !img->pending)
+            lru[numlru++] = img;
+    }
+    if (!numlru) {
+        Z_Free(lru);
+        return;
+    }
+    qsort(lru, numlru, sizeof(*lru), R_ImageLRUCompare);
+
+    /* Planned mip_skip and estimated size of each */
+    skip = (int *)Z_Malloc(numlru * 2 * sizeof(int));
+    bytes = skip + numlru;
+    for (i = 0; i < numlru; i++) {
+        skip[i] = lru[i]->mip_skip;
+        bytes[i] = lru[i]->bytes;
+    }
+
+    if (budget && resident > budget) {
+        /* Over: shrink the stalest first, one level per pass */
+        for (pass = 1; pass <= R_MAX_MIP_SKIP && resident > budget; pass++) {
+            for (i = 0; i < numlru && resident > budget; i++) {
+                int width = lru[i]->upload_width >> (skip[i] - lru[i]->mip_skip);
+
+                if (skip[i] >= pass || width <= 1)
+                    continue;
+                resident -= bytes[i] - bytes[i] / 4;
+                bytes[i] /= 4;
+                skip[i]++;
+            }
+        }
+    } else {
+        /* Room to spare: restore the most recently used first */
+        for (i = numlru - 1; i >= 0; i--) {
+            if (!skip[i])
+                continue;
+            if (budget && resident - bytes[i] + lru[i]->full_bytes > budget)
+                continue;
+            resident += lru[i]->full_bytes - bytes[i];
+            skip[i] = 0;
+        }
+    }
+
+    for (i = 0; i < numlru; i++) {
+        image_t *img = lru[i];
+
+        if (skip[i] == img->mip_skip)
+            continue;
+        img->mip_skip = skip[i];
+        img->pending = qtrue;
+        FS_AsyncQueue(R_ImageLoadWork, R_ImageLoadDone, R_NewImageLoad(img));
+    }
+
+    Z_Free(skip);
+    Z_Free(lru);
+    FS_AsyncWait();
+}
+
+static void R_ImageList_f(void)
+{
+    int i, count = 0, skipped = 0, requested = 0;
+
+    for (i = 0; i < r_numimages; i++) {
+        image_t *img = &r_images[i];
+
+        if (!img->name[0])
+            continue;
+        Com_Printf("%c %4ix%-4i %6iK%s %s\n", img->type == it_pic ? 'P' : 'W',
+                   img->upload_width, img->upload_height, img->bytes / 1024,
+                   img->mip_skip ? " (down)" : img->scrap ? " (scrap)" : "       ", img->name);
+        count++;
+        requested += img->full_bytes;
+        if (img->mip_skip)
+            skipped++;
+    }
+
+    Com_Printf("%i images, %i downsampled, scrap %i%% full\n", count, skipped,
+               scrap_used * 100 / (SCRAP_SIZE * SCRAP_SIZE));
+    Com_Printf("%.1f MB resident of %.1f MB requested", r_texture_bytes / (1024.0f * 1024.0f),
+               requested / (1024.0f * 1024.0f));
+    if (r_texture_budget->value > 0)
+        Com_Printf(", budget %g MB", r_texture_budget->value);
+    Com_Printf("\n");
+}
+
 /* ==========================================================================
    Image System Init / Shutdown
    ========================================================================== */
@@ -715,9 +1373,15 @@ void R_InitImages(void)
 {
     r_numimages = 0;
     r_registration_sequence = 0;
+    r_texture_bytes = 0;
+    memset(r_imagehash, 0, sizeof(r_imagehash));
+
+    r_texture_budget = Cvar_Get("r_texture_budget", "0", CVAR_ARCHIVE);
+    Cmd_AddCommand("imagelist", R_ImageList_f);
 
     R_LoadPalette();
     R_InitDefaultTextures();
+    R_InitScrap();
 
     Com_Printf("Image system initialized\n");
 }
@@ -726,15 +1390,23 @@ void R_ShutdownImages(void)
 {
     int i;
 
+    /* Queued loads point into r_images */
+    FS_AsyncWait();
+
     for (i = 0; i < r_numimages; i++) {
-        if (r_images[i].texnum)
-            qglDeleteTextures(1, &r_images[i].texnum);
+        if (r_images[i].texnum && !r_images[i].scrap)
+            R_DeleteTexture(r_images[i].texnum);
     }
 
-    if (r_notexture) qglDeleteTextures(1, &r_notexture);
-    if (r_whitetexture) qglDeleteTextures(1, &r_whitetexture);
+    if (scrap_texnum) R_DeleteTexture(scrap_texnum);
+    scrap_texnum = 0;
+    if (r_notexture) R_DeleteTexture(r_notexture);
+    if (r_whitetexture) R_DeleteTexture(r_whitetexture);
 
     r_numimages = 0;
+    r_texture_bytes = 0;
+    memset(r_imagehash, 0, sizeof(r_imagehash));
+    Cmd_RemoveCommand("imagelist");
 }
 
 void R_ImageBeginRegistration(void)
@@ -746,13 +1418,16 @@ void R_ImageEndRegistration(void)
 {
     int i;
 
-    /* Free images that weren't re-registered this level */
+    FS_AsyncWait();
+
+    /* Free images that weren't re-registered this level. The slot is
+     * released too, so a later lookup reloads instead of finding texnum 0.
+     * Scrap pics stay: their space couldn't be reused anyway */
     for (i = 0; i < r_numimages; i++) {
-        if (r_images[i].registration_sequence != r_registration_sequence) {
-            if (r_images[i].texnum) {
-                qglDeleteTextures(1, &r_images[i].texnum);
-                r_images[i].texnum = 0;
-            }
-        }
+        if (r_images[i].name[0] && !r_images[i].scrap &&
+            r_images[i].registration_sequence != r_registration_sequence)
+            R_ReleaseImage(&r_images[i]);
     }
+
+    R_EnforceTextureBudget();
 }
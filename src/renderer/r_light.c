@@ -38,6 +38,11 @@ typedef struct {
     int     width, height;      /* lightmap dimensions in luxels */
     float   s_offset, t_offset; /* tex coord offset for face */
     float   s_scale, t_scale;   /* tex coord scale */
+
+    /* Dynamic lights (R_PushDlights) */
+    int         dlight_frame;   /* last update that marked this face */
+    unsigned    dlight_bits;    /* lights touching it in that update */
+    qboolean    dlit;           /* atlas holds dlight luxels, not the static ones */
 } face_lightmap_t;
 
 static GLuint           lm_textures[MAX_LIGHTMAPS];
@@ -49,6 +54,11 @@ static face_lightmap_t  *lm_faces;
 static int              lm_num_faces;
 static bsp_world_t     *lm_world;  /* pointer to current world for R_LightPoint */
 
+static int              *lm_dlit_faces;     /* faces with dlit set, lm_num_dlit of them */
+static int              lm_num_dlit;
+static int              lm_dlight_frame;
+int                     c_dlight_faces;     /* faces relit this frame */
+
 /* ==========================================================================
    Lightmap Atlas Packing
    Simple shelf packing: track allocated height per column.
@@ -116,6 +126,25 @@ static void LM_UploadBlock(void)
         return;
     }
 
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        tex = R_VK_CreateTexture(LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT, 1, GL_RGB8, qfalse);
+        R_VK_TextureLevel(tex, 0, LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT, GL_RGB, lm_buffer);
+        lm_textures[lm_num_textures++] = tex;
+        LM_InitBlock();
+        return;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        tex = R_GL4_CreateTexture(LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT, 1, GL_RGB8, qfalse);
+        R_GL4_TextureLevel(tex, 0, LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT, GL_RGB, lm_buffer);
+        lm_textures[lm_num_textures++] = tex;
+        LM_InitBlock();
+        return;
+    }
+#endif
+
     qglGenTextures(1, &tex);
     qglBindTexture(GL_TEXTURE_2D, tex);
     qglTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT,
@@ -204,11 +233,65 @@ static void R_CalcFaceLightmapExtents(bsp_world_t *world, int face_idx,
     if (*lm_h > 256) *lm_h = 256;
 }
 
+/*
+ * Expand a face's luxels from the BSP light lump to overbright RGB.
+ * Shared by the atlas build and by R_PushDlights, which starts every
+ * relit face from its static light.
+ */
+static qboolean LM_StaticLuxels(const bsp_world_t *world, const bsp_face_t *face,
+                                int lm_w, int lm_h, byte *dest, int stride)
+{
+    const byte  *src = world->lightdata + face->lightofs;
+    int         src_size = lm_w * lm_h;
+    int         x, y;
+
+    /* Verify source data fits */
+    if (face->lightofs + src_size > world->lightdata_size)
+        return qfalse;
+
+    /* Q2 lightmaps: check if RGB (SoF ArghRad) or greyscale */
+    /* SoF typically has 3 bytes per luxel (RGB lighting) */
+    if (face->lightofs + src_size * 3 <= world->lightdata_size) {
+        /* Assume RGB lightmap data (3 bytes per luxel) */
+        for (y = 0; y < lm_h; y++) {
+            byte *out = dest + y * stride;
+
+            for (x = 0; x < lm_w; x++) {
+                int src_ofs = (y * lm_w + x) * 3;
+                /* Apply overbright (Q2 style: lightmap * 2) */
+                int r = src[src_ofs + 0] * 2;
+                int g = src[src_ofs + 1] * 2;
+                int b = src[src_ofs + 2] * 2;
+                out[x * 3 + 0] = (byte)(r > 255 ? 255 : r);
+                out[x * 3 + 1] = (byte)(g > 255 ? 255 : g);
+                out[x * 3 + 2] = (byte)(b > 255 ? 255 : b);
+            }
+        }
+    } else {
+        /* Greyscale fallback (1 byte per luxel) */
+        for (y = 0; y < lm_h; y++) {
+            byte *out = dest + y * stride;
+
+            for (x = 0; x < lm_w; x++) {
+                int lit = src[y * lm_w + x] * 2;
+                if (lit > 255) lit = 255;
+                out[x * 3 + 0] = (byte)lit;
+                out[x * 3 + 1] = (byte)lit;
+                out[x * 3 + 2] = (byte)lit;
+            }
+        }
+    }
+
+    return qtrue;
+}
+
 /* ==========================================================================
    Build Lightmaps
    Called after map load to create all face lightmap textures.
    ========================================================================== */
 
+static void LM_BuildLightGrid(void);
+
 void R_BuildLightmaps(bsp_world_t *world)
 {
     int     i;
@@ -228,6 +311,8 @@ void R_BuildLightmaps(bsp_world_t *world)
     lm_faces = (face_lightmap_t *)Z_TagMalloc(
         sizeof(face_lightmap_t) * lm_num_faces, Z_TAG_LEVEL);
     memset(lm_faces, 0, sizeof(face_lightmap_t) * lm_num_faces);
+    lm_dlit_faces = (int *)Z_TagMalloc(sizeof(int) * lm_num_faces, Z_TAG_LEVEL);
+    lm_num_dlit = 0;
 
     LM_InitBlock();
     lm_num_textures = 0;
@@ -267,52 +352,11 @@ void R_BuildLightmaps(bsp_world_t *world)
         }
 
         /* Copy lightmap data into atlas buffer */
-        {
-            int x, y;
-            byte *src = world->lightdata + face->lightofs;
-            int src_size = lm_w * lm_h;
-
-            /* Verify source data fits */
-            if (face->lightofs + src_size > world->lightdata_size) {
-                Com_DPrintf("WARNING: lightmap overflow for face %d\n", i);
-                continue;
-            }
-
-            /* Q2 lightmaps: check if RGB (SoF ArghRad) or greyscale */
-            /* SoF typically has 3 bytes per luxel (RGB lighting) */
-            if (face->lightofs + src_size * 3 <= world->lightdata_size) {
-                /* Assume RGB lightmap data (3 bytes per luxel) */
-                for (y = 0; y < lm_h; y++) {
-                    for (x = 0; x < lm_w; x++) {
-                        int dst_ofs = ((ay + y) * LM_BLOCK_WIDTH + (ax + x)) * 3;
-                        int src_ofs = (y * lm_w + x) * 3;
-                        if (dst_ofs + 2 >= (int)sizeof(lm_buffer)) continue;
-                        /* Apply overbright (Q2 style: lightmap * 2) */
-                        int r = src[src_ofs + 0] * 2;
-                        int g = src[src_ofs + 1] * 2;
-                        int b = src[src_ofs + 2] * 2;
-                        lm_buffer[dst_ofs + 0] = (byte)(r > 255 ? 255 : r);
-                        lm_buffer[dst_ofs + 1] = (byte)(g > 255 ? 255 : g);
-                        lm_buffer[dst_ofs + 2] = (byte)(b > 255 ? 255 : b);
-                    }
-                }
-            } else {
-                /* Greyscale fallback (1 byte per luxel) */
-                for (y = 0; y < lm_h; y++) {
-                    for (x = 0; x < lm_w; x++) {
-                        int dst_ofs = ((ay + y) * LM_BLOCK_WIDTH + (ax + x)) * 3;
-                        int src_ofs = y * lm_w + x;
-                        byte val;
-                        if (dst_ofs + 2 >= (int)sizeof(lm_buffer)) continue;
-                        val = src[src_ofs];
-                        int lit = val * 2;
-                        if (lit > 255) lit = 255;
-                        lm_buffer[dst_ofs + 0] = (byte)lit;
-                        lm_buffer[dst_ofs + 1] = (byte)lit;
-                        lm_buffer[dst_ofs + 2] = (byte)lit;
-                    }
-                }
-            }
+        if (!LM_StaticLuxels(world, face, lm_w, lm_h,
+                             lm_buffer + (ay * LM_BLOCK_WIDTH + ax) * 3,
+                             LM_BLOCK_WIDTH * 3)) {
+            Com_DPrintf("WARNING: lightmap overflow for face %d\n", i);
+            continue;
         }
 
         /* Store face lightmap info */
@@ -338,6 +382,8 @@ void R_BuildLightmaps(bsp_world_t *world)
 
     Com_Printf("Lightmaps: %d faces, %d atlas textures (%dx%d)\n",
                built, lm_num_textures, LM_BLOCK_WIDTH, LM_BLOCK_HEIGHT);
+
+    LM_BuildLightGrid();
 }
 
 /* ==========================================================================
@@ -394,102 +440,488 @@ GLuint R_GetFaceLightmapTexture(int face_idx)
 }
 
 /* ==========================================================================
-   R_LightPoint - Sample world light at a position
-
-   Searches nearby floor faces to find the lightmap color at the given
-   world position. Returns an RGB light value (0-1 range).
+   Dynamic Lightmaps
+   Dynamic lights are added into the lightmap atlases instead of drawn as
+   extra passes. Each frame the light spheres are pushed down the BSP to
+   find the faces they touch, and only those faces' rectangles of their
+   atlas page are rebuilt (static luxels plus the lights) and uploaded.
+   A face a light has left is uploaded once more with its static luxels.
    ========================================================================== */
 
-void R_LightPoint(vec3_t p, vec3_t color)
+#define LM_DLIGHT_MINLIGHT  16.0f   /* below this a light adds nothing */
+
+/* Mark faces on node planes the light sphere reaches (Q2 R_MarkLights) */
+static void LM_MarkLights(const r_dlight_t *dl, unsigned bit, int nodenum,
+                          int *marked, int *nummarked)
 {
-    int i;
-    float best_dist = 999999.0f;
-    int best_face = -1;
+    bsp_world_t *world = lm_world;
 
-    color[0] = color[1] = color[2] = 1.0f;  /* default: full bright */
+    while (nodenum >= 0 && nodenum < world->num_nodes) {
+        bsp_node_t  *node = &world->nodes[nodenum];
+        bsp_plane_t *plane = &world->planes[node->planenum];
+        float       dist = DotProduct(dl->origin, plane->normal) - plane->dist;
+        int         i;
+
+        if (dist > dl->intensity) {
+            nodenum = node->children[0];
+            continue;
+        }
+        if (dist < -dl->intensity) {
+            nodenum = node->children[1];
+            continue;
+        }
+
+        for (i = 0; i < node->numfaces; i++) {
+            int             face_idx = node->firstface + i;
+            face_lightmap_t *flm;
+
+            if (face_idx >= lm_num_faces)
+                break;
+            flm = &lm_faces[face_idx];
+            if (flm->atlas_index < 0 || flm->atlas_index >= lm_num_textures)
+                continue;
+
+            if (flm->dlight_frame != lm_dlight_frame) {
+                flm->dlight_frame = lm_dlight_frame;
+                flm->dlight_bits = 0;
+                marked[(*nummarked)++] = face_idx;
+            }
+            flm->dlight_bits |= bit;
+        }
+
+        LM_MarkLights(dl, bit, node->children[0], marked, nummarked);
+        nodenum = node->children[1];
+    }
+}
+
+/*
+ * Add the marked lights into a face's luxels (Q2 R_AddDynamicLights):
+ * distance is measured in the face plane, from where the light projects
+ * onto it, with the usual octagonal approximation. False if no luxel
+ * actually picked anything up.
+ */
+static qboolean LM_AddDlights(int face_idx, const r_dlight_t *dlights, byte *luxels)
+{
+    bsp_face_t      *face = &lm_world->faces[face_idx];
+    face_lightmap_t *flm = &lm_faces[face_idx];
+    bsp_plane_t     *plane;
+    bsp_texinfo_t   *ti;
+    qboolean        lit = qfalse;
+    int             l;
+
+    if (face->texinfo < 0 || face->texinfo >= lm_world->num_texinfo ||
+        face->planenum >= lm_world->num_planes)
+        return qfalse;
+    plane = &lm_world->planes[face->planenum];
+    ti = &lm_world->texinfo[face->texinfo];
+
+    for (l = 0; l < MAX_DLIGHTS; l++) {
+        const r_dlight_t    *dl = &dlights[l];
+        float               fdist, frad, fminlight, local[2];
+        vec3_t              impact;
+        int                 x, y, k;
+
+        if (!(flm->dlight_bits & (1u << l)))
+            continue;
+
+        fdist = DotProduct(dl->origin, plane->normal) - plane->dist;
+        frad = dl->intensity - (float)fabs(fdist);
+        if (frad < LM_DLIGHT_MINLIGHT)
+            continue;
+        fminlight = frad - LM_DLIGHT_MINLIGHT;
+
+        for (k = 0; k < 3; k++)
+            impact[k] = dl->origin[k] - plane->normal[k] * fdist;
+        local[0] = DotProduct(impact, ti->vecs[0]) + ti->vecs[0][3] - flm->s_offset;
+        local[1] = DotProduct(impact, ti->vecs[1]) + ti->vecs[1][3] - flm->t_offset;
+
+        for (y = 0; y < flm->height; y++) {
+            float td = (float)fabs(local[1] - y * 16);
+
+            for (x = 0; x < flm->width; x++) {
+                float   sd = (float)fabs(local[0] - x * 16);
+                float   d = sd > td ? sd + td * 0.5f : td + sd * 0.5f;
+                byte    *out;
+
+                if (d >= fminlight)
+                    continue;
+
+                out = luxels + (y * flm->width + x) * 3;
+                for (k = 0; k < 3; k++) {
+                    int v = out[k] + (int)((frad - d) * dl->color[k]);
+                    out[k] = (byte)(v > 255 ? 255 : v);
+                }
+                lit = qtrue;
+            }
+        }
+    }
+
+    return lit;
+}
+
+/* Replace the face's rectangle of its atlas page */
+static void LM_UploadFace(const face_lightmap_t *flm, const byte *luxels)
+{
+    GLuint tex = lm_textures[flm->atlas_index];
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_TextureRect(tex, flm->atlas_x, flm->atlas_y, flm->width, flm->height,
+                         GL_RGB, luxels);
+        return;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        R_GL4_TextureRect(tex, flm->atlas_x, flm->atlas_y, flm->width, flm->height,
+                          GL_RGB, luxels);
+        return;
+    }
+#endif
+
+    qglBindTexture(GL_TEXTURE_2D, tex);
+    qglTexSubImage2D(GL_TEXTURE_2D, 0, flm->atlas_x, flm->atlas_y, flm->width, flm->height,
+                     GL_RGB, GL_UNSIGNED_BYTE, luxels);
+}
 
-    if (!lm_world || !lm_world->lightdata || !lm_faces)
+/*
+ * R_PushDlights - Bring the atlases up to date with this frame's lights
+ *
+ * Call once per frame before the world is drawn; with numdlights 0 it
+ * just restores whatever the previous frame lit.
+ */
+void R_PushDlights(const r_dlight_t *dlights, int numdlights)
+{
+    static byte luxels[256 * 256 * 3];  /* largest face, see R_CalcFaceLightmapExtents */
+    int         *marked, nummarked = 0, numdlit = 0, i;
+
+    c_dlight_faces = 0;
+
+    if (!lm_faces || !lm_world || (!numdlights && !lm_num_dlit))
         return;
 
-    /* Find the closest upward-facing face below this point */
-    for (i = 0; i < lm_world->num_faces; i++) {
-        bsp_face_t *face = &lm_world->faces[i];
-        bsp_plane_t *plane = &lm_world->planes[face->planenum];
-        float dot, dist;
+    lm_dlight_frame++;
+    marked = (int *)Z_FrameAlloc(lm_num_faces * sizeof(int));
+    for (i = 0; i < numdlights && i < MAX_DLIGHTS; i++)
+        LM_MarkLights(&dlights[i], 1u << i, 0, marked, &nummarked);
 
-        if (face->lightofs < 0)
+    if (!gl_state.vk)
+        qglPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    /* Faces lit last frame that no light reaches now go back to static */
+    for (i = 0; i < lm_num_dlit; i++) {
+        int             face_idx = lm_dlit_faces[i];
+        face_lightmap_t *flm = &lm_faces[face_idx];
+
+        if (flm->dlight_frame == lm_dlight_frame)
+            continue;
+        LM_StaticLuxels(lm_world, &lm_world->faces[face_idx], flm->width, flm->height,
+                        luxels, flm->width * 3);
+        LM_UploadFace(flm, luxels);
+        flm->dlit = qfalse;
+        c_dlight_faces++;
+    }
+
+    /* Faces a light reaches: rebuild, unless the sphere only grazed the
+     * plane and the face was static already */
+    for (i = 0; i < nummarked; i++) {
+        int             face_idx = marked[i];
+        face_lightmap_t *flm = &lm_faces[face_idx];
+        bsp_face_t      *face = &lm_world->faces[face_idx];
+        qboolean        lit;
+
+        if (!LM_StaticLuxels(lm_world, face, flm->width, flm->height,
+                             luxels, flm->width * 3))
+            continue;
+        lit = LM_AddDlights(face_idx, dlights, luxels);
+        if (!lit && !flm->dlit)
             continue;
 
-        /* Only consider mostly-horizontal surfaces (floors/ceilings) */
-        dot = plane->normal[2];
-        if (face->side) dot = -dot;
-        if (dot < 0.7f)
-            continue;  /* not floor-like */
+        LM_UploadFace(flm, luxels);
+        flm->dlit = lit;
+        if (lit)
+            lm_dlit_faces[numdlit++] = face_idx;
+        c_dlight_faces++;
+    }
+    lm_num_dlit = numdlit;
+
+    if (!gl_state.vk)
+        qglPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/* ==========================================================================
+   Light Grid
+   R_LightPoint is asked for the light at every model drawn, so instead of
+   searching faces per call the world's light is sampled once at map load
+   on a regular grid, Q3 style: each grid point traces straight down
+   through the BSP (Q2 RecursiveLightPoint) and takes the luxel of the
+   first lit face it hits. A query is then eight lookups and a trilinear
+   blend, which also keeps a moving model's light from popping between
+   faces. Points inside solid are marked empty and left out of the blend.
+   ========================================================================== */
 
-        /* Distance from point to plane */
-        dist = p[0] * plane->normal[0] + p[1] * plane->normal[1] +
-               p[2] * plane->normal[2] - plane->dist;
-        if (face->side)
-            dist = -dist;
+#define LG_CELL_XY          64      /* grid spacing, world units */
+#define LG_CELL_Z           128
+#define LG_MAX_POINTS       (1 << 21)
+#define LG_TRACE_DEPTH      2048.0f /* how far below a point a floor may be */
 
-        /* Only faces below us (positive dist means point is above plane) */
-        if (dist < -16.0f || dist > 256.0f)
+typedef struct {
+    byte    rgb[3];
+    byte    valid;          /* 0 = in solid, or nothing lit below */
+} lightgrid_point_t;
+
+static struct {
+    lightgrid_point_t   *points;    /* x fastest, then y, then z */
+    vec3_t              origin;     /* position of point 0,0,0 */
+    vec3_t              cell;
+    int                 size[3];
+} lm_grid;
+
+/* Colour of the luxel at s,t (texture space) on a face, 0-1 with overbright */
+static qboolean LM_SampleFace(int face_idx, float s, float t, vec3_t color)
+{
+    bsp_face_t      *face = &lm_world->faces[face_idx];
+    face_lightmap_t *flm = &lm_faces[face_idx];
+    int             ls, lt, ofs, k;
+
+    ls = (int)((s - flm->s_offset) / 16.0f + 0.5f);
+    lt = (int)((t - flm->t_offset) / 16.0f + 0.5f);
+    if (ls < 0) ls = 0;
+    if (lt < 0) lt = 0;
+    if (ls >= flm->width) ls = flm->width - 1;
+    if (lt >= flm->height) lt = flm->height - 1;
+
+    /* Same RGB/greyscale guess as LM_StaticLuxels */
+    if (face->lightofs + flm->width * flm->height * 3 <= lm_world->lightdata_size) {
+        ofs = face->lightofs + (lt * flm->width + ls) * 3;
+        for (k = 0; k < 3; k++)
+            color[k] = lm_world->lightdata[ofs + k] * (2.0f / 255.0f);
+    } else {
+        ofs = face->lightofs + lt * flm->width + ls;
+        if (ofs >= lm_world->lightdata_size)
+            return qfalse;
+        color[0] = color[1] = color[2] = lm_world->lightdata[ofs] * (2.0f / 255.0f);
+    }
+
+    for (k = 0; k < 3; k++)
+        if (color[k] > 1.0f)
+            color[k] = 1.0f;
+    return qtrue;
+}
+
+/*
+ * Light where the segment start->end first crosses a lit face; -1 if it
+ * reaches end (or solid) without one. Only reads the world, so the grid
+ * build runs it as jobs.
+ */
+static int LM_RecursiveLightPoint(int nodenum, const vec3_t start, const vec3_t end,
+                                  vec3_t color)
+{
+    bsp_node_t  *node;
+    bsp_plane_t *plane;
+    float       front, back, frac;
+    vec3_t      mid;
+    int         side, r, i;
+
+    if (nodenum < 0 || nodenum >= lm_world->num_nodes)
+        return -1;      /* a leaf */
+
+    node = &lm_world->nodes[nodenum];
+    plane = &lm_world->planes[node->planenum];
+    front = DotProduct(start, plane->normal) - plane->dist;
+    back = DotProduct(end, plane->normal) - plane->dist;
+    side = front < 0;
+
+    if ((back < 0) == side)
+        return LM_RecursiveLightPoint(node->children[side], start, end, color);
+
+    frac = front / (front - back);
+    for (i = 0; i < 3; i++)
+        mid[i] = start[i] + (end[i] - start[i]) * frac;
+
+    /* Front side first */
+    r = LM_RecursiveLightPoint(node->children[side], start, mid, color);
+    if (r >= 0)
+        return r;
+
+    /* Crossing the node plane: is mid on one of its faces? */
+    for (i = 0; i < node->numfaces; i++) {
+        int             face_idx = node->firstface + i;
+        bsp_face_t      *face;
+        face_lightmap_t *flm;
+        bsp_texinfo_t   *ti;
+        float           s, t;
+
+        if (face_idx >= lm_num_faces)
+            break;
+        face = &lm_world->faces[face_idx];
+        flm = &lm_faces[face_idx];
+        if (flm->atlas_index < 0 || face->texinfo < 0 ||
+            face->texinfo >= lm_world->num_texinfo)
+            continue;   /* sky, warp, nodraw or unlit */
+
+        ti = &lm_world->texinfo[face->texinfo];
+        s = DotProduct(mid, ti->vecs[0]) + ti->vecs[0][3] - flm->s_offset;
+        t = DotProduct(mid, ti->vecs[1]) + ti->vecs[1][3] - flm->t_offset;
+        if (s < 0 || t < 0 || s > (flm->width - 1) * 16 || t > (flm->height - 1) * 16)
             continue;
 
-        if (dist < best_dist) {
-            /* Check if point is within face's XY bounding box (rough) */
-            bsp_texinfo_t *ti = &lm_world->texinfo[face->texinfo];
-            float s = p[0] * ti->vecs[0][0] + p[1] * ti->vecs[0][1] +
-                      p[2] * ti->vecs[0][2] + ti->vecs[0][3];
-            float t = p[0] * ti->vecs[1][0] + p[1] * ti->vecs[1][1] +
-                      p[2] * ti->vecs[1][2] + ti->vecs[1][3];
-            face_lightmap_t *flm = &lm_faces[i];
-
-            /* Check if s/t coordinates are within this face's lightmap range */
-            if (flm->width > 0 && flm->height > 0) {
-                /* Use this face's texinfo to compute lightmap position */
-                best_dist = dist;
-                best_face = i;
-            }
+        return LM_SampleFace(face_idx, s + flm->s_offset, t + flm->t_offset, color) ? 1 : 0;
+    }
+
+    /* Back side */
+    return LM_RecursiveLightPoint(node->children[!side], mid, end, color);
+}
+
+static qboolean LM_PointInSolid(const vec3_t p)
+{
+    int nodenum = 0;
+
+    while (nodenum >= 0) {
+        bsp_node_t  *node;
+        bsp_plane_t *plane;
+
+        if (nodenum >= lm_world->num_nodes)
+            return qfalse;
+        node = &lm_world->nodes[nodenum];
+        plane = &lm_world->planes[node->planenum];
+        nodenum = node->children[DotProduct(p, plane->normal) - plane->dist < 0];
+    }
+
+    nodenum = -(nodenum + 1);
+    return nodenum < lm_world->num_leafs &&
+           (lm_world->leafs[nodenum].contents & CONTENTS_SOLID);
+}
+
+/* Job: every point of one grid layer (z = index) */
+static void LM_GridLayerJob(void *ctx, int z)
+{
+    int x, y;
+
+    (void)ctx;
+
+    for (y = 0; y < lm_grid.size[1]; y++) {
+        for (x = 0; x < lm_grid.size[0]; x++) {
+            lightgrid_point_t   *pt = &lm_grid.points[(z * lm_grid.size[1] + y) * lm_grid.size[0] + x];
+            vec3_t              p, end, color;
+            int                 k;
+
+            p[0] = lm_grid.origin[0] + x * lm_grid.cell[0];
+            p[1] = lm_grid.origin[1] + y * lm_grid.cell[1];
+            p[2] = lm_grid.origin[2] + z * lm_grid.cell[2];
+            VectorCopy(p, end);
+            end[2] -= LG_TRACE_DEPTH;
+
+            pt->valid = 0;
+            if (LM_PointInSolid(p) || LM_RecursiveLightPoint(0, p, end, color) <= 0)
+                continue;
+
+            for (k = 0; k < 3; k++)
+                pt->rgb[k] = (byte)(color[k] * 255.0f + 0.5f);
+            pt->valid = 1;
         }
     }
+}
+
+/* Called at the end of R_BuildLightmaps */
+static void LM_BuildLightGrid(void)
+{
+    bsp_model_t *bounds;
+    int         i, numpoints, valid = 0;
 
-    /* Sample the lightmap from the best face */
-    if (best_face >= 0) {
-        bsp_face_t *face = &lm_world->faces[best_face];
-        bsp_texinfo_t *ti = &lm_world->texinfo[face->texinfo];
-        face_lightmap_t *flm = &lm_faces[best_face];
-        float s, t;
-        int ls, lt;
-
-        s = p[0] * ti->vecs[0][0] + p[1] * ti->vecs[0][1] +
-            p[2] * ti->vecs[0][2] + ti->vecs[0][3];
-        t = p[0] * ti->vecs[1][0] + p[1] * ti->vecs[1][1] +
-            p[2] * ti->vecs[1][2] + ti->vecs[1][3];
-
-        /* Convert to luxel coordinates */
-        ls = (int)((s - flm->s_offset) / 16.0f);
-        lt = (int)((t - flm->t_offset) / 16.0f);
-
-        if (ls < 0) ls = 0;
-        if (lt < 0) lt = 0;
-        if (ls >= flm->width) ls = flm->width - 1;
-        if (lt >= flm->height) lt = flm->height - 1;
-
-        /* Read lightmap data — assume RGB (3 bytes per luxel) */
-        if (face->lightofs >= 0 &&
-            face->lightofs + (lt * flm->width + ls) * 3 + 2 < lm_world->lightdata_size) {
-            byte *sample = lm_world->lightdata + face->lightofs +
-                           (lt * flm->width + ls) * 3;
-            color[0] = sample[0] / 255.0f;
-            color[1] = sample[1] / 255.0f;
-            color[2] = sample[2] / 255.0f;
-
-            /* Boost (Q2-style overbright x2, clamped) */
-            color[0] = color[0] * 2.0f > 1.0f ? 1.0f : color[0] * 2.0f;
-            color[1] = color[1] * 2.0f > 1.0f ? 1.0f : color[1] * 2.0f;
-            color[2] = color[2] * 2.0f > 1.0f ? 1.0f : color[2] * 2.0f;
+    if (!lm_world->num_models || !lm_world->num_nodes)
+        return;
+    bounds = &lm_world->models[0];
+
+    lm_grid.cell[0] = lm_grid.cell[1] = LG_CELL_XY;
+    lm_grid.cell[2] = LG_CELL_Z;
+
+    /* Coarsen the spacing on huge maps rather than run out of points */
+    for (;;) {
+        for (i = 0; i < 3; i++) {
+            lm_grid.origin[i] = lm_grid.cell[i] * (float)ceil(bounds->mins[i] / lm_grid.cell[i]);
+            lm_grid.size[i] = (int)(floor(bounds->maxs[i] / lm_grid.cell[i]) -
+                                    floor(lm_grid.origin[i] / lm_grid.cell[i])) + 1;
+            if (lm_grid.size[i] < 1)
+                lm_grid.size[i] = 1;
         }
+        numpoints = lm_grid.size[0] * lm_grid.size[1] * lm_grid.size[2];
+        if (numpoints <= LG_MAX_POINTS)
+            break;
+        VectorScale(lm_grid.cell, 2.0f, lm_grid.cell);
+    }
+
+    lm_grid.points = (lightgrid_point_t *)Z_TagMalloc(numpoints * sizeof(lightgrid_point_t),
+                                                      Z_TAG_LEVEL);
+    Job_ParallelFor("LM_GridLayer", LM_GridLayerJob, NULL, lm_grid.size[2]);
+
+    for (i = 0; i < numpoints; i++)
+        valid += lm_grid.points[i].valid;
+
+    Com_Printf("Light grid: %dx%dx%d (%d lit points)\n",
+               lm_grid.size[0], lm_grid.size[1], lm_grid.size[2], valid);
+}
+
+/*
+ * R_LightPoint - Sample world light at a position
+ *
+ * Trilinear blend of the eight surrounding light grid points that have
+ * light. Returns an RGB light value (0-1 range); full bright without a
+ * lit map, and a direct downward trace if no neighbour has light.
+ */
+void R_LightPoint(vec3_t p, vec3_t color)
+{
+    float   frac[3], total = 0;
+    int     base[3], i, k;
+    vec3_t  sum = { 0, 0, 0 };
+
+    color[0] = color[1] = color[2] = 1.0f;  /* default: full bright */
+
+    if (!lm_world || !lm_world->lightdata || !lm_faces || !lm_grid.points)
+        return;
+
+    for (i = 0; i < 3; i++) {
+        float f = (p[i] - lm_grid.origin[i]) / lm_grid.cell[i];
+
+        if (f < 0)
+            f = 0;
+        if (f > lm_grid.size[i] - 1)
+            f = (float)(lm_grid.size[i] - 1);
+        base[i] = (int)f;
+        if (base[i] >= lm_grid.size[i] - 1 && lm_grid.size[i] > 1)
+            base[i] = lm_grid.size[i] - 2;
+        frac[i] = f - base[i];
+    }
+
+    for (i = 0; i < 8; i++) {
+        int                 gx = base[0] + (i & 1), gy = base[1] + ((i >> 1) & 1);
+        int                 gz = base[2] + (i >> 2);
+        float               w;
+        lightgrid_point_t   *pt;
+
+        if (gx >= lm_grid.size[0] || gy >= lm_grid.size[1] || gz >= lm_grid.size[2])
+            continue;
+        pt = &lm_grid.points[(gz * lm_grid.size[1] + gy) * lm_grid.size[0] + gx];
+        if (!pt->valid)
+            continue;
+
+        w = ((i & 1) ? frac[0] : 1.0f - frac[0]) *
+            (((i >> 1) & 1) ? frac[1] : 1.0f - frac[1]) *
+            ((i >> 2) ? frac[2] : 1.0f - frac[2]);
+        for (k = 0; k < 3; k++)
+            sum[k] += pt->rgb[k] * w;
+        total += w;
+    }
+
+    if (total > 0.001f) {
+        for (k = 0; k < 3; k++)
+            color[k] = sum[k] / (total * 255.0f);
+    } else {
+        vec3_t end;
+
+        VectorCopy(p, end);
+        end[2] -= LG_TRACE_DEPTH;
+        LM_RecursiveLightPoint(0, p, end, color);
     }
 }
 
@@ -503,7 +935,7 @@ void R_FreeLightmaps(void)
 
     for (i = 0; i < lm_num_textures; i++) {
         if (lm_textures[i]) {
-            qglDeleteTextures(1, &lm_textures[i]);
+            R_DeleteTexture(lm_textures[i]);
             lm_textures[i] = 0;
         }
     }
@@ -513,5 +945,14 @@ void R_FreeLightmaps(void)
         Z_Free(lm_faces);
         lm_faces = NULL;
     }
+    if (lm_dlit_faces) {
+        Z_Free(lm_dlit_faces);
+        lm_dlit_faces = NULL;
+    }
+    if (lm_grid.points) {
+        Z_Free(lm_grid.points);
+        lm_grid.points = NULL;
+    }
+    lm_num_dlit = 0;
     lm_num_faces = 0;
 }
@@ -53,9 +53,20 @@ typedef struct image_s {
     float           sl, tl, sh, th;     /* tex coords for sub-image (pics) */
     qboolean        scrap;
     qboolean        has_alpha;
+    qboolean        pending;            /* queued on the background loader */
     int             registration_sequence;
+
+    /* Residency (r_texture_budget) */
+    int             bytes;              /* video memory of the upload */
+    int             full_bytes;         /* ... with every level, as requested */
+    int             mip_skip;           /* top levels dropped to fit the budget */
+    int             last_frame;         /* r_framecount when last bound */
+    struct image_s  *hash_next;
 } image_t;
 
+/* Note that an image is being drawn this frame, for the residency LRU */
+#define R_TouchImage(img)   ((img)->last_frame = r_framecount)
+
 /* ==========================================================================
    GL State
    ========================================================================== */
@@ -75,6 +86,9 @@ typedef struct {
     qboolean    have_multitexture;
     qboolean    have_s3tc;
     qboolean    have_compiled_vertex_array;
+    qboolean    have_vbo;
+    qboolean    gl4;                /* r_gl4.c path is live */
+    qboolean    vk;                 /* r_vk.c path is live, no GL context */
 
     /* Active texture unit for multitexture */
     int         currenttextures[2];
@@ -121,6 +135,9 @@ extern cvar_t   *gl_modulate;
 /* SoF-specific renderer cvars */
 extern cvar_t   *ghl_specular;
 extern cvar_t   *ghl_mip;
+extern cvar_t   *r_dynamic;
+
+extern int      r_framecount;       /* frames begun, for image LRU */
 
 /* ==========================================================================
    Renderer API (matches refexport_t from sof_types.h)
@@ -184,6 +201,7 @@ extern void (APIENTRY *qglDisable)(GLenum cap);
 extern void (APIENTRY *qglBlendFunc)(GLenum sfactor, GLenum dfactor);
 extern void (APIENTRY *qglDepthFunc)(GLenum func);
 extern void (APIENTRY *qglDepthMask)(GLboolean flag);
+extern void (APIENTRY *qglAlphaFunc)(GLenum func, GLclampf ref);
 extern void (APIENTRY *qglViewport)(GLint x, GLint y, GLsizei width, GLsizei height);
 extern void (APIENTRY *qglScissor)(GLint x, GLint y, GLsizei width, GLsizei height);
 extern void (APIENTRY *qglMatrixMode)(GLenum mode);
@@ -240,6 +258,208 @@ typedef void (APIENTRY *PFNGLCLIENTACTIVETEXTUREARBPROC)(GLenum texture);
 extern PFNGLACTIVETEXTUREARBPROC        qglActiveTextureARB;
 extern PFNGLCLIENTACTIVETEXTUREARBPROC  qglClientActiveTextureARB;
 
+/* Vertex buffer objects (ARB_vertex_buffer_object) */
+#ifndef GL_ARRAY_BUFFER_ARB
+#define GL_ARRAY_BUFFER_ARB     0x8892
+#define GL_STATIC_DRAW_ARB      0x88E4
+#endif
+
+extern void (APIENTRY *qglGenBuffersARB)(GLsizei n, GLuint *buffers);
+extern void (APIENTRY *qglDeleteBuffersARB)(GLsizei n, const GLuint *buffers);
+extern void (APIENTRY *qglBindBufferARB)(GLenum target, GLuint buffer);
+extern void (APIENTRY *qglBufferDataARB)(GLenum target, ptrdiff_t size, const void *data, GLenum usage);
+
+/* Compressed texture upload (ARB_texture_compression), loaded with S3TC */
+extern void (APIENTRY *qglCompressedTexImage2DARB)(GLenum target, GLint level, GLenum internalformat,
+                                                   GLsizei width, GLsizei height, GLint border,
+                                                   GLsizei imageSize, const void *data);
+
+/* ==========================================================================
+   Dynamic Geometry (r_main.c)
+
+   Per-frame vertices for particles, sprites and tracers. Allocations last
+   until the end of the frame; on the GL4 path they live in the ring buffer.
+   ========================================================================== */
+
+typedef struct {
+    float   xyz[3];
+    byte    rgba[4];
+} r_dynvert_t;
+
+r_dynvert_t *R_DynAlloc(int numverts);
+void        R_DynDraw(GLenum prim, r_dynvert_t *verts, int numverts);
+
+/* ==========================================================================
+   2D Batching (r_draw.c)
+   ========================================================================== */
+
+/* One corner of a screen quad */
+typedef struct {
+    float   xy[2];
+    float   st[2];
+    byte    rgba[4];
+} r_drawvert_t;
+
+/* A run of vertices on one texture */
+typedef struct {
+    GLuint  texnum;
+    int     first, count;       /* vertices */
+} r_2dbatch_t;
+
+void        R_InitDraw(void);
+void        R_ShutdownDraw(void);
+void        R_Flush2D(void);
+
+#ifdef SOF_RENDERER_GL4
+/* ==========================================================================
+   OpenGL 4.5 Path (r_gl4.c)
+   ========================================================================== */
+
+extern cvar_t *r_gl4;
+
+/* Particle point sprite: world-space size next to the usual vertex */
+typedef struct {
+    r_dynvert_t v;
+    float       size;
+} r_partvert_t;
+
+void        R_GL4_RequestContext(void);
+qboolean    R_GL4_Init(void);
+void        R_GL4_Shutdown(void);
+void        R_GL4_BeginFrame(void);
+void       *R_GL4_RingAlloc(int size, int *offset);
+
+GLuint      R_GL4_CreateTexture(int width, int height, int levels,
+                                GLenum internalformat, qboolean repeat);
+void        R_GL4_TextureLevel(GLuint tex, int level, int width, int height,
+                               GLenum format, const void *pixels);
+void        R_GL4_TextureRect(GLuint tex, int x, int y, int width, int height,
+                              GLenum format, const void *pixels);
+void        R_GL4_CompressedLevel(GLuint tex, int level, int width, int height,
+                                  GLenum internalformat, int size, const void *data);
+
+GLuint      R_GL4_CreateWorldBuffer(const void *verts, int size, int stride,
+                                    int st_ofs, int lm_ofs);
+void        R_GL4_FreeWorldBuffer(void);
+void        R_GL4_BeginWorld(void);
+void        R_GL4_EndWorld(void);
+void        R_GL4_SetMaterial(qboolean textured, qboolean lightmapped, qboolean warp);
+void        R_GL4_SetAlphaRef(float ref);
+void        R_GL4_DrawIndexed(const GLuint *indices, int offset, int count);
+void        R_GL4_DrawDynamic(GLenum prim, int offset, int count);
+void        R_GL4_DrawParticles(int offset, int count);
+void        R_GL4_Begin2D(int offset);
+void        R_GL4_End2D(void);
+
+/* Static MD2 buffers (r_model.c) */
+typedef struct {
+    GLuint      vao;
+    GLuint      frames;         /* every frame's positions, a storage buffer */
+    GLuint      st, ibo;
+    int         numindices;
+} r_gl4alias_t;
+
+/* One copy of an MD2 as the shader reads it (std430) */
+typedef struct {
+    float       rows[3][4];     /* model to world */
+    float       color[4];       /* lit */
+    uint32_t    frame;          /* first vertex of each frame in the buffer */
+    uint32_t    oldframe;
+    float       backlerp;
+    float       pad;
+} r_aliasinst_t;
+
+void        R_GL4_CreateAliasMesh(r_gl4alias_t *out, const float *frames, int numframes,
+                                  int numverts, const float *st, const uint16_t *indices,
+                                  int numindices);
+void        R_GL4_FreeAliasMesh(r_gl4alias_t *mesh);
+void        R_GL4_DrawAlias(const r_gl4alias_t *mesh, GLuint texnum, float zmin,
+                            float zscale, int inst_ofs, int count);
+
+/* GHOUL skinned vertex: bind pose, its bone, and that bone's zone masks */
+typedef struct {
+    float       xyz[3];
+    float       normal[3];
+    uint32_t    bone;
+    uint32_t    hide;           /* severing any of these zones drops it */
+    uint32_t    damage;         /* damage to any of these tints it */
+} r_skinvert_t;
+
+/* One skinned instance as the shader reads it (std430) */
+typedef struct {
+    float       color[4];       /* lit base color */
+    uint32_t    severed;        /* bit per gore_zone_id_t */
+    uint32_t    damaged;
+    uint32_t    bone_base;      /* first palette matrix */
+    uint32_t    pad;
+} r_skininst_t;
+
+void       *R_GL4_StorageAlloc(int size, int *offset);
+int         R_GL4_CreateSkinMesh(const r_skinvert_t *verts, int numverts,
+                                 const uint16_t *indices, int numindices);
+void        R_GL4_DrawSkinned(int mesh, int bones_ofs, int bones_size,
+                              int inst_ofs, int count);
+#endif
+
+#ifdef SOF_RENDERER_VULKAN
+/* ==========================================================================
+   Vulkan Path (r_vk.c)
+   Textures keep GLuint handles so the image code can hold either kind.
+   ========================================================================== */
+
+extern cvar_t *r_vulkan;
+
+void        R_VK_RequestWindow(void);
+qboolean    R_VK_Init(void);
+void        R_VK_Shutdown(void);
+void        R_VK_BeginFrame(void);
+void        R_VK_EndFrame(void);
+void       *R_VK_StreamAlloc(int size, int *offset);
+
+GLuint      R_VK_CreateTexture(int width, int height, int levels,
+                               GLenum internalformat, qboolean repeat);
+void        R_VK_TextureLevel(GLuint tex, int level, int width, int height,
+                              GLenum format, const void *pixels);
+void        R_VK_TextureRect(GLuint tex, int x, int y, int width, int height,
+                             GLenum format, const void *pixels);
+void        R_VK_CompressedLevel(GLuint tex, int level, int width, int height,
+                                 GLenum internalformat, int size, const void *data);
+void        R_VK_DeleteTexture(GLuint tex);
+
+qboolean    R_VK_CreateWorldBuffer(const void *verts, int size, int stride,
+                                   int st_ofs, int lm_ofs);
+void        R_VK_FreeWorldBuffer(void);
+void        R_VK_SetView(const refdef_t *fd, const float *fog);
+void        R_VK_ViewMatrix(float *clip);
+void        R_VK_BeginWorld(void);
+void        R_VK_EndWorld(void);
+void        R_VK_SetMaterial(GLuint texture, GLuint lightmap, const float *color,
+                             qboolean warp);
+void        R_VK_SetAlphaRef(float ref);
+void        R_VK_SetBlend(qboolean blend);
+void        R_VK_DrawIndexed(int offset, int count);
+void        R_VK_Draw2D(const r_drawvert_t *verts, int numverts,
+                        const r_2dbatch_t *batches, int numbatches);
+#endif
+
+/* Block-compressed wall textures and their disk cache (r_texcache.c) */
+typedef enum {
+    TF_RGBA,
+    TF_BC1,                     /* DXT1, opaque */
+    TF_BC3                      /* DXT5, with alpha */
+} texformat_t;
+
+void        R_InitTexCache(void);
+texformat_t R_TexTargetFormat(qboolean has_alpha);
+int         R_TexLevelSize(texformat_t format, int width, int height);
+int         R_TexChainSize(texformat_t format, int width, int height);
+byte       *R_CompressMipChain(const byte *chain, int width, int height, texformat_t format);
+qboolean    R_TexCacheLoad(const char *path, byte **data, int *width, int *height,
+                           qboolean *has_alpha, texformat_t *format);
+void        R_TexCacheStore(const char *path, const byte *data, int width, int height,
+                            qboolean has_alpha, texformat_t format);
+GLuint      R_UploadCompressedChain(const byte *data, int width, int height, texformat_t format);
+
 /* Load all GL function pointers */
 qboolean QGL_Init(void);
 void QGL_Shutdown(void);
@@ -247,13 +467,24 @@ void QGL_Shutdown(void);
 /* Image/Texture system (r_image.c) */
 void        R_InitImages(void);
 void        R_ShutdownImages(void);
+void        R_DeleteTexture(GLuint texnum);
 image_t    *R_FindImage(const char *name);
+void        R_PrecacheImage(const char *name);
 image_t    *R_FindPic(const char *name);
+image_t    *R_LoadPicPixels(const char *name, const byte *rgba, int width, int height);
 GLuint      R_GetNoTexture(void);
 void        R_ImageBeginRegistration(void);
 void        R_ImageEndRegistration(void);
 GLuint      R_LoadSkyTexture(const char *path);
 
+/* Dynamic lights (r_main.c), folded into the lightmaps by r_light.c */
+typedef struct {
+    vec3_t  origin;
+    vec3_t  color;
+    float   intensity;  /* radius in world units */
+    float   die;        /* time when light expires (from Sys_Milliseconds) */
+} r_dlight_t;
+
 /* Lightmap system (r_light.c) */
 void        R_BuildLightmaps(bsp_world_t *world);
 void        R_FreeLightmaps(void);
@@ -263,15 +494,18 @@ qboolean    R_GetFaceLightmapTC(int face_idx, float *vertex,
                                  float *out_s, float *out_t,
                                  GLuint *out_texnum);
 GLuint      R_GetFaceLightmapTexture(int face_idx);
+void        R_PushDlights(const r_dlight_t *dlights, int numdlights);
+extern int  c_dlight_faces;                     /* faces relit this frame */
 
 /* BSP surface rendering (r_surf.c) */
 void        R_LoadWorldMap(const char *name);
 qboolean    R_WorldLoaded(void);
 void        R_DrawWorld(void);
-void        R_DrawSingleFace(bsp_world_t *world, int face_idx);
 void        R_DrawBrushModel(int modelindex, vec3_t origin, vec3_t angles);
 void        R_RenderWorldView(void);
 void        R_InitSurfCommands(void);
+extern int  c_brush_polys, c_visible_faces;     /* draw calls, faces */
+extern int  c_state_changes;                    /* texture/lightmap binds */
 
 /* Particle system */
 void        R_ClearParticles(void);
@@ -330,6 +564,10 @@ typedef struct {
 
     /* Bounding box (first frame) */
     vec3_t      mins, maxs;
+
+#ifdef SOF_RENDERER_GL4
+    r_gl4alias_t gl4;           /* vao 0 = not uploaded */
+#endif
 } md2_mesh_t;
 
 struct model_s {
@@ -359,10 +597,15 @@ void        R_FreeMD2(model_t *mod);
 void        R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
                              int frame, int oldframe, float backlerp,
                              float r, float g, float b);
-
-/* GHOUL model rendering (r_main.c) */
-void        R_DrawGhoulModel(struct ghoul_model_s *ghoul, vec3_t origin,
-                              vec3_t angles, float r, float g, float b);
+void        R_DrawAliasInstances(void);
+
+/* GHOUL model rendering (r_ghoul.c). Humanoids are queued while the
+ * snapshot is walked and drawn together after it. */
+void        R_InitGhoul(void);
+void        R_ShutdownGhoul(void);
+void        R_AddGhoulInstance(const snapent_t *ent, const struct ghoul_model_s *ghoul,
+                               const vec3_t origin, float yaw, const float *color);
+void        R_DrawGhoulInstances(void);
 
 /* Entity interpolation (r_main.c) */
 void        R_SetInterpFraction(float frac);
@@ -19,6 +19,14 @@
 #include "../game/g_local.h"
 #include "../ghoul/ghoul.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define R_PARTICLE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define R_PARTICLE_NEON
+#endif
+
 /* ==========================================================================
    GL State
    ========================================================================== */
@@ -51,6 +59,9 @@ cvar_t  *gl_fogcolor_b;
 /* SoF-specific */
 cvar_t  *ghl_specular;
 cvar_t  *ghl_mip;
+cvar_t  *r_dynamic;
+
+int     r_framecount;
 
 /* ==========================================================================
    Skybox State
@@ -65,16 +76,13 @@ static vec3_t   sky_axis;
    Dynamic Lights
    ========================================================================== */
 
-typedef struct {
-    vec3_t  origin;
-    vec3_t  color;
-    float   intensity;
-    float   die;        /* time when light expires (from Sys_Milliseconds) */
-} r_dlight_t;
-
 static r_dlight_t   r_dlights[MAX_DLIGHTS];
 static int          r_num_dlights;
 
+/* Guards the particle, sprite, tracer, dlight and decal lists: with
+ * sv_simthread the game spawns effects while the main thread draws them */
+static void         *r_fxlock;
+
 /* ==========================================================================
    GL Function Pointers
    ========================================================================== */
@@ -94,6 +102,7 @@ void (APIENTRY *qglDisable)(GLenum cap);
 void (APIENTRY *qglBlendFunc)(GLenum sfactor, GLenum dfactor);
 void (APIENTRY *qglDepthFunc)(GLenum func);
 void (APIENTRY *qglDepthMask)(GLboolean flag);
+void (APIENTRY *qglAlphaFunc)(GLenum func, GLclampf ref);
 void (APIENTRY *qglViewport)(GLint x, GLint y, GLsizei width, GLsizei height);
 void (APIENTRY *qglScissor)(GLint x, GLint y, GLsizei width, GLsizei height);
 void (APIENTRY *qglMatrixMode)(GLenum mode);
@@ -139,6 +148,11 @@ void (APIENTRY *qglPolygonOffset)(GLfloat factor, GLfloat units);
 /* Extensions */
 PFNGLACTIVETEXTUREARBPROC       qglActiveTextureARB;
 PFNGLCLIENTACTIVETEXTUREARBPROC qglClientActiveTextureARB;
+void (APIENTRY *qglGenBuffersARB)(GLsizei n, GLuint *buffers);
+void (APIENTRY *qglDeleteBuffersARB)(GLsizei n, const GLuint *buffers);
+void (APIENTRY *qglBindBufferARB)(GLenum target, GLuint buffer);
+void (APIENTRY *qglBufferDataARB)(GLenum target, ptrdiff_t size, const void *data, GLenum usage);
+void (APIENTRY *qglCompressedTexImage2DARB)(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data);
 
 /* ==========================================================================
    QGL_Init — Load all GL function pointers via SDL
@@ -164,6 +178,7 @@ qboolean QGL_Init(void)
     QGL_LOAD(BlendFunc);
     QGL_LOAD(DepthFunc);
     QGL_LOAD(DepthMask);
+    QGL_LOAD(AlphaFunc);
     QGL_LOAD(Viewport);
     QGL_LOAD(Scissor);
     QGL_LOAD(MatrixMode);
@@ -225,6 +240,69 @@ void QGL_Shutdown(void)
    R_Init — Initialize renderer
    ========================================================================== */
 
+/* GL function pointers, capabilities and initial state */
+static qboolean R_InitGL(void)
+{
+    /* Load GL function pointers */
+    if (!QGL_Init())
+        return qfalse;
+
+    /* Query GL info */
+    gl_state.vendor_string = (const char *)qglGetString(GL_VENDOR);
+    gl_state.renderer_string = (const char *)qglGetString(GL_RENDERER);
+    gl_state.version_string = (const char *)qglGetString(GL_VERSION);
+    gl_state.extensions_string = (const char *)qglGetString(GL_EXTENSIONS);
+
+    Com_Printf("GL_VENDOR: %s\n", gl_state.vendor_string ? gl_state.vendor_string : "unknown");
+    Com_Printf("GL_RENDERER: %s\n", gl_state.renderer_string ? gl_state.renderer_string : "unknown");
+    Com_Printf("GL_VERSION: %s\n", gl_state.version_string ? gl_state.version_string : "unknown");
+
+    /* Check for extensions */
+    if (gl_state.extensions_string) {
+        gl_state.have_multitexture = (strstr(gl_state.extensions_string, "GL_ARB_multitexture") != NULL);
+        gl_state.have_s3tc = (strstr(gl_state.extensions_string, "GL_EXT_texture_compression_s3tc") != NULL ||
+                              strstr(gl_state.extensions_string, "GL_S3_s3tc") != NULL);
+        gl_state.have_compiled_vertex_array = (strstr(gl_state.extensions_string, "GL_EXT_compiled_vertex_array") != NULL);
+        gl_state.have_vbo = (strstr(gl_state.extensions_string, "GL_ARB_vertex_buffer_object") != NULL);
+    }
+
+    if (gl_state.have_multitexture) {
+        qglActiveTextureARB = (PFNGLACTIVETEXTUREARBPROC)Sys_GL_GetProcAddress("glActiveTextureARB");
+        qglClientActiveTextureARB = (PFNGLCLIENTACTIVETEXTUREARBPROC)Sys_GL_GetProcAddress("glClientActiveTextureARB");
+        if (qglActiveTextureARB)
+            Com_Printf("...using GL_ARB_multitexture\n");
+    }
+
+    if (gl_state.have_vbo) {
+        qglGenBuffersARB = Sys_GL_GetProcAddress("glGenBuffersARB");
+        qglDeleteBuffersARB = Sys_GL_GetProcAddress("glDeleteBuffersARB");
+        qglBindBufferARB = Sys_GL_GetProcAddress("glBindBufferARB");
+        qglBufferDataARB = Sys_GL_GetProcAddress("glBufferDataARB");
+        if (qglGenBuffersARB && qglDeleteBuffersARB && qglBindBufferARB && qglBufferDataARB)
+            Com_Printf("...using GL_ARB_vertex_buffer_object\n");
+        else
+            gl_state.have_vbo = qfalse;
+    }
+
+    if (gl_state.have_s3tc) {
+        qglCompressedTexImage2DARB = Sys_GL_GetProcAddress("glCompressedTexImage2DARB");
+        if (!qglCompressedTexImage2DARB)
+            gl_state.have_s3tc = qfalse;
+    }
+
+#ifdef SOF_RENDERER_GL4
+    R_GL4_Init();
+#endif
+
+    /* Set initial GL state */
+    qglClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    qglEnable(GL_DEPTH_TEST);
+    qglEnable(GL_CULL_FACE);
+    qglEnable(GL_TEXTURE_2D);
+
+    return qtrue;
+}
+
 int R_Init(void *hinstance, void *hWnd)
 {
     (void)hinstance;
@@ -232,6 +310,9 @@ int R_Init(void *hinstance, void *hWnd)
 
     Com_Printf("------- Renderer Init -------\n");
 
+    if (!r_fxlock)
+        r_fxlock = Sys_CreateMutex();
+
     /* Register cvars */
     r_mode = Cvar_Get("r_mode", "6", CVAR_ARCHIVE);  /* 6 = 1024x768 in Q2 */
     r_fullscreen = Cvar_Get("vid_fullscreen", "0", CVAR_ARCHIVE);
@@ -254,6 +335,14 @@ int R_Init(void *hinstance, void *hWnd)
     /* SoF-specific renderer cvars */
     ghl_specular = Cvar_Get("ghl_specular", "1", CVAR_ARCHIVE);
     ghl_mip = Cvar_Get("ghl_mip", "1", CVAR_ARCHIVE);
+    r_dynamic = Cvar_Get("r_dynamic", "1", CVAR_ARCHIVE);
+
+#ifdef SOF_RENDERER_VULKAN
+    R_VK_RequestWindow();
+#endif
+#ifdef SOF_RENDERER_GL4
+    R_GL4_RequestContext();
+#endif
 
     /* Create window and GL context */
     {
@@ -266,47 +355,34 @@ int R_Init(void *hinstance, void *hWnd)
             Com_Error(ERR_FATAL, "R_Init: couldn't create window");
             return -1;
         }
+
+#ifdef SOF_RENDERER_VULKAN
+        /* No usable device: fall back to a GL window */
+        if (r_vulkan->value && !R_VK_Init()) {
+            Com_Printf("...Vulkan unavailable, using OpenGL\n");
+            Sys_DestroyWindow();
+            Sys_RequestVulkanWindow(0);
+            if (!Sys_CreateWindow(w, h, fs)) {
+                Com_Error(ERR_FATAL, "R_Init: couldn't create window");
+                return -1;
+            }
+        }
+#endif
     }
 
-    /* Load GL function pointers */
-    if (!QGL_Init()) {
+    if (!gl_state.vk && !R_InitGL()) {
         Com_Error(ERR_FATAL, "R_Init: QGL_Init failed");
         return -1;
     }
 
-    /* Query GL info */
-    gl_state.vendor_string = (const char *)qglGetString(GL_VENDOR);
-    gl_state.renderer_string = (const char *)qglGetString(GL_RENDERER);
-    gl_state.version_string = (const char *)qglGetString(GL_VERSION);
-    gl_state.extensions_string = (const char *)qglGetString(GL_EXTENSIONS);
+    R_InitGhoul();
 
-    Com_Printf("GL_VENDOR: %s\n", gl_state.vendor_string ? gl_state.vendor_string : "unknown");
-    Com_Printf("GL_RENDERER: %s\n", gl_state.renderer_string ? gl_state.renderer_string : "unknown");
-    Com_Printf("GL_VERSION: %s\n", gl_state.version_string ? gl_state.version_string : "unknown");
-
-    /* Check for extensions */
-    if (gl_state.extensions_string) {
-        gl_state.have_multitexture = (strstr(gl_state.extensions_string, "GL_ARB_multitexture") != NULL);
-        gl_state.have_s3tc = (strstr(gl_state.extensions_string, "GL_EXT_texture_compression_s3tc") != NULL ||
-                              strstr(gl_state.extensions_string, "GL_S3_s3tc") != NULL);
-        gl_state.have_compiled_vertex_array = (strstr(gl_state.extensions_string, "GL_EXT_compiled_vertex_array") != NULL);
-    }
-
-    if (gl_state.have_multitexture) {
-        qglActiveTextureARB = (PFNGLACTIVETEXTUREARBPROC)Sys_GL_GetProcAddress("glActiveTextureARB");
-        qglClientActiveTextureARB = (PFNGLCLIENTACTIVETEXTUREARBPROC)Sys_GL_GetProcAddress("glClientActiveTextureARB");
-        if (qglActiveTextureARB)
-            Com_Printf("...using GL_ARB_multitexture\n");
-    }
-
-    /* Set initial GL state */
-    qglClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    qglEnable(GL_DEPTH_TEST);
-    qglEnable(GL_CULL_FACE);
-    qglEnable(GL_TEXTURE_2D);
+    /* Before R_InitImages: decides what the loader threads convert to */
+    R_InitTexCache();
 
     /* Initialize texture system */
     R_InitImages();
+    R_InitDraw();
 
     /* Register map/camera commands */
     R_InitSurfCommands();
@@ -322,7 +398,15 @@ int R_Init(void *hinstance, void *hWnd)
 
 void R_Shutdown(void)
 {
+    R_ShutdownGhoul();
+#ifdef SOF_RENDERER_GL4
+    R_GL4_Shutdown();
+#endif
+    R_ShutdownDraw();
     R_ShutdownImages();
+#ifdef SOF_RENDERER_VULKAN
+    R_VK_Shutdown();
+#endif
     QGL_Shutdown();
     Sys_DestroyWindow();
 }
@@ -350,9 +434,19 @@ void R_BeginFrame(float camera_separation)
 
     (void)camera_separation;
 
-    if (!qglClear)
+    if (!qglClear && !gl_state.vk)
         return;
 
+    r_framecount++;
+
+#ifdef SOF_RENDERER_GL4
+    R_GL4_BeginFrame();
+#endif
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk)
+        R_VK_BeginFrame();
+#endif
+
     /* Compute frametime for particle simulation */
     now = Sys_Milliseconds();
     frametime = (now - last_frame_time) * 0.001f;
@@ -361,14 +455,20 @@ void R_BeginFrame(float camera_separation)
     last_frame_time = now;
 
     /* Update particles, sprites, tracers, and dynamic lights */
+    Sys_LockMutex(r_fxlock);
+    Prof_Begin("R_UpdateParticles");
     R_UpdateParticles(frametime);
+    Prof_End();
     R_UpdateSprites(frametime);
     R_UpdateTracers(frametime);
     R_UpdateDlights();
+    Sys_UnlockMutex(r_fxlock);
 
-    /* Clear screen */
-    qglClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-    qglClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    /* Clear screen (the Vulkan render pass clears to the same) */
+    if (!gl_state.vk) {
+        qglClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+        qglClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
     /* Render 3D world if loaded — build refdef from freecam state */
     if (R_WorldLoaded()) {
@@ -392,6 +492,8 @@ void R_BeginFrame(float camera_separation)
     }
 
     /* Switch to 2D mode for HUD/console overlay */
+    if (gl_state.vk)
+        return;
     qglViewport(0, 0, g_display.width, g_display.height);
     qglMatrixMode(GL_PROJECTION);
     qglLoadIdentity();
@@ -446,18 +548,17 @@ static void R_Setup3DModelview(refdef_t *fd)
 
 /* ==========================================================================
    Entity Rendering
-   Iterate game entity list and draw inline BSP models (func_door, etc.)
+   Iterate the entity snapshot and draw inline BSP models (func_door, etc.)
    ========================================================================== */
 
-/* Access game's entity list through engine bridge */
-extern game_export_t *SV_GetGameExport(void);
+/* Entities come from the server's snapshot (sv_snap.c), never from edicts */
 extern const char *SV_GetConfigstring(int index);
 
 /*
  * Draw a colored wireframe box at an entity's position
  * Used as placeholder rendering for non-BSP entities (monsters, items, etc.)
  */
-static void R_DrawEntityBox(vec3_t origin, vec3_t mins, vec3_t maxs,
+static void R_DrawEntityBox(vec3_t origin, const vec3_t mins, const vec3_t maxs,
                             float r, float g, float b)
 {
     vec3_t p1, p2;
@@ -597,156 +698,25 @@ static void R_DrawBlobShadow(vec3_t origin, float radius)
 }
 
 /*
- * R_DrawHumanoid — Draw a simple humanoid figure at the given position
- * Draws: head, torso, 2 arms, 2 legs as solid colored boxes
- * yaw: rotation angle in degrees
- * deadflag: if nonzero, draw fallen/ragdoll pose
+ * R_DrawHealthBar — Bar over an injured humanoid's head, green above
+ * 30 health and red below.
  */
-static void R_DrawHumanoid(vec3_t origin, float yaw, float r, float g, float b,
-                            int deadflag, int health)
+static void R_DrawHealthBar(vec3_t origin, float yaw, int health)
 {
     vec3_t bmin, bmax;
-    vec3_t lightcolor;
-
-    /* Sample world lightmap at entity position */
-    R_LightPoint(origin, lightcolor);
-    r *= lightcolor[0];
-    g *= lightcolor[1];
-    b *= lightcolor[2];
+    float bar_w = 12.0f * ((float)health / 100.0f);
 
     qglDisable(GL_TEXTURE_2D);
     qglEnable(GL_BLEND);
     qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglEnable(GL_DEPTH_TEST);
 
     qglPushMatrix();
     qglTranslatef(origin[0], origin[1], origin[2]);
     qglRotatef(yaw, 0, 0, 1);
-
-    if (deadflag) {
-        /* Dead: flat on the ground */
-        VectorSet(bmin, -16, -6, 0);
-        VectorSet(bmax, 16, 6, 4);
-        R_DrawSolidBox(bmin, bmax, r * 0.5f, g * 0.5f, b * 0.5f, 0.7f);
-    } else {
-        /* Torso */
-        VectorSet(bmin, -6, -4, 24);
-        VectorSet(bmax, 6, 4, 48);
-        R_DrawSolidBox(bmin, bmax, r, g, b, 0.9f);
-
-        /* Head */
-        VectorSet(bmin, -4, -4, 48);
-        VectorSet(bmax, 4, 4, 58);
-        R_DrawSolidBox(bmin, bmax, r * 0.9f, g * 0.9f + 0.1f, b * 0.9f + 0.1f, 0.9f);
-
-        /* Left arm */
-        VectorSet(bmin, -9, -2, 28);
-        VectorSet(bmax, -6, 2, 48);
-        R_DrawSolidBox(bmin, bmax, r * 0.8f, g * 0.8f, b * 0.8f, 0.9f);
-
-        /* Right arm */
-        VectorSet(bmin, 6, -2, 28);
-        VectorSet(bmax, 9, 2, 48);
-        R_DrawSolidBox(bmin, bmax, r * 0.8f, g * 0.8f, b * 0.8f, 0.9f);
-
-        /* Left leg */
-        VectorSet(bmin, -5, -3, 0);
-        VectorSet(bmax, -1, 3, 24);
-        R_DrawSolidBox(bmin, bmax, r * 0.7f, g * 0.7f, b * 0.7f, 0.9f);
-
-        /* Right leg */
-        VectorSet(bmin, 1, -3, 0);
-        VectorSet(bmax, 5, 3, 24);
-        R_DrawSolidBox(bmin, bmax, r * 0.7f, g * 0.7f, b * 0.7f, 0.9f);
-
-        /* Health bar above head (if injured) */
-        if (health > 0 && health < 100) {
-            float bar_w = 12.0f * ((float)health / 100.0f);
-            float hr = (health < 30) ? 1.0f : 0.0f;
-            float hg = (health >= 30) ? 1.0f : 0.0f;
-            VectorSet(bmin, -6, -0.5f, 62);
-            VectorSet(bmax, -6 + bar_w, 0.5f, 63);
-            R_DrawSolidBox(bmin, bmax, hr, hg, 0.0f, 0.8f);
-        }
-    }
-
-    qglPopMatrix();
-
-    qglDisable(GL_BLEND);
-    qglEnable(GL_TEXTURE_2D);
-    qglColor4f(1, 1, 1, 1);
-}
-
-/*
- * R_DrawGhoulModel — Render a GHOUL skeletal model
- *
- * Currently draws an improved humanoid approximation using the model's
- * bounding radius. When GHB mesh parsing is complete, this will draw
- * actual mesh geometry.
- */
-void R_DrawGhoulModel(struct ghoul_model_s *ghoul, vec3_t origin,
-                       vec3_t angles, float r, float g, float b)
-{
-    float radius, height;
-    vec3_t lightcolor;
-    vec3_t bmin, bmax;
-
-    if (!ghoul || !ghoul->loaded)
-        return;
-
-    radius = ghoul->bounding_radius;
-    if (radius <= 0) radius = 100.0f;
-
-    /* Scale humanoid proportions to model bounding radius */
-    height = radius * 0.6f;  /* approximate standing height */
-    if (height < 30.0f) height = 30.0f;
-    if (height > 80.0f) height = 80.0f;
-
-    /* Light the model from the world lightmap */
-    R_LightPoint(origin, lightcolor);
-    r *= lightcolor[0];
-    g *= lightcolor[1];
-    b *= lightcolor[2];
-
-    qglDisable(GL_TEXTURE_2D);
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglEnable(GL_DEPTH_TEST);
-
-    qglPushMatrix();
-    qglTranslatef(origin[0], origin[1], origin[2]);
-    qglRotatef(angles[1], 0, 0, 1);
-
-    {
-        float s = height / 58.0f;  /* scale factor relative to default humanoid */
-
-        /* Torso */
-        VectorSet(bmin, -6*s, -4*s, 24*s);
-        VectorSet(bmax, 6*s, 4*s, 48*s);
-        R_DrawSolidBox(bmin, bmax, r, g, b, 0.9f);
-
-        /* Head */
-        VectorSet(bmin, -4*s, -4*s, 48*s);
-        VectorSet(bmax, 4*s, 4*s, 58*s);
-        R_DrawSolidBox(bmin, bmax, r*0.9f, g*0.9f+0.1f, b*0.9f+0.1f, 0.9f);
-
-        /* Arms */
-        VectorSet(bmin, -9*s, -2*s, 28*s);
-        VectorSet(bmax, -6*s, 2*s, 48*s);
-        R_DrawSolidBox(bmin, bmax, r*0.8f, g*0.8f, b*0.8f, 0.9f);
-        VectorSet(bmin, 6*s, -2*s, 28*s);
-        VectorSet(bmax, 9*s, 2*s, 48*s);
-        R_DrawSolidBox(bmin, bmax, r*0.8f, g*0.8f, b*0.8f, 0.9f);
-
-        /* Legs */
-        VectorSet(bmin, -5*s, -3*s, 0);
-        VectorSet(bmax, -1*s, 3*s, 24*s);
-        R_DrawSolidBox(bmin, bmax, r*0.7f, g*0.7f, b*0.7f, 0.9f);
-        VectorSet(bmin, 1*s, -3*s, 0);
-        VectorSet(bmax, 5*s, 3*s, 24*s);
-        R_DrawSolidBox(bmin, bmax, r*0.7f, g*0.7f, b*0.7f, 0.9f);
-    }
-
+    VectorSet(bmin, -6, -0.5f, 62);
+    VectorSet(bmax, -6 + bar_w, 0.5f, 63);
+    R_DrawSolidBox(bmin, bmax, health < 30 ? 1.0f : 0.0f, health >= 30 ? 1.0f : 0.0f,
+                   0.0f, 0.8f);
     qglPopMatrix();
 
     qglDisable(GL_BLEND);
@@ -757,22 +727,10 @@ void R_DrawGhoulModel(struct ghoul_model_s *ghoul, vec3_t origin,
 /* ==========================================================================
    Entity Interpolation
 
-   Tracks previous entity positions and lerps between old and current
-   for smooth visual movement at frame rates higher than 10Hz tick.
+   Each snapshot entity carries its state from the previous tick as well;
+   lerp between the two for smooth movement at frame rates above 10Hz.
    ========================================================================== */
 
-#define MAX_INTERP_ENTS     256
-
-typedef struct {
-    int         index;          /* entity index */
-    vec3_t      prev_origin;    /* position at last server tick */
-    vec3_t      prev_angles;    /* angles at last server tick */
-    int         prev_frame;     /* animation frame at last server tick */
-    qboolean    valid;          /* has valid previous state */
-} interp_ent_t;
-
-static interp_ent_t    interp_ents[MAX_INTERP_ENTS];
-static int             interp_count;
 static float           interp_frac;     /* 0..1 fractional server tick */
 
 void R_SetInterpFraction(float frac)
@@ -780,109 +738,44 @@ void R_SetInterpFraction(float frac)
     interp_frac = frac;
 }
 
-void R_UpdateEntityInterp(void)
+static void R_GetInterpOrigin(const snapent_t *se, vec3_t out_origin, vec3_t out_angles)
 {
-    game_export_t *ge = SV_GetGameExport();
     int i;
 
-    interp_count = 0;
-    if (!ge || !ge->edicts)
-        return;
-
-    for (i = 1; i < ge->num_edicts && interp_count < MAX_INTERP_ENTS; i++) {
-        edict_t *ent = (edict_t *)((byte *)ge->edicts + i * ge->edict_size);
+    for (i = 0; i < 3; i++) {
+        float delta = se->s.angles[i] - se->old_angles[i];
 
-        if (!ent->inuse)
-            continue;
+        /* Take the short way round */
+        if (delta > 180)
+            delta -= 360;
+        else if (delta < -180)
+            delta += 360;
 
-        /* Interpolate entities that are moving or animating */
-        if (ent->velocity[0] != 0 || ent->velocity[1] != 0 || ent->velocity[2] != 0 ||
-            ent->avelocity[0] != 0 || ent->avelocity[1] != 0 || ent->avelocity[2] != 0 ||
-            ent->s.modelindex != 0) {
-            interp_ent_t *ie = &interp_ents[interp_count++];
-            ie->index = i;
-            VectorCopy(ent->s.origin, ie->prev_origin);
-            VectorCopy(ent->s.angles, ie->prev_angles);
-            ie->prev_frame = ent->s.frame;
-            ie->valid = qtrue;
-        }
+        out_origin[i] = se->s.old_origin[i] +
+                        (se->s.origin[i] - se->s.old_origin[i]) * interp_frac;
+        out_angles[i] = se->old_angles[i] + delta * interp_frac;
     }
 }
 
-static qboolean R_GetInterpOrigin(int index, vec3_t out_origin, vec3_t cur_origin,
-                                  vec3_t out_angles, vec3_t cur_angles)
-{
-    int i;
-    for (i = 0; i < interp_count; i++) {
-        if (interp_ents[i].index == index && interp_ents[i].valid) {
-            out_origin[0] = interp_ents[i].prev_origin[0] +
-                            (cur_origin[0] - interp_ents[i].prev_origin[0]) * interp_frac;
-            out_origin[1] = interp_ents[i].prev_origin[1] +
-                            (cur_origin[1] - interp_ents[i].prev_origin[1]) * interp_frac;
-            out_origin[2] = interp_ents[i].prev_origin[2] +
-                            (cur_origin[2] - interp_ents[i].prev_origin[2]) * interp_frac;
-
-            out_angles[0] = interp_ents[i].prev_angles[0] +
-                            (cur_angles[0] - interp_ents[i].prev_angles[0]) * interp_frac;
-            out_angles[1] = interp_ents[i].prev_angles[1] +
-                            (cur_angles[1] - interp_ents[i].prev_angles[1]) * interp_frac;
-            out_angles[2] = interp_ents[i].prev_angles[2] +
-                            (cur_angles[2] - interp_ents[i].prev_angles[2]) * interp_frac;
-            return qtrue;
-        }
-    }
-    return qfalse;
-}
-
-/*
- * R_GetInterpFrame - Get old frame and backlerp for animation interpolation
- * Returns qtrue if interpolation data is available.
- */
-static qboolean R_GetInterpFrame(int index, int cur_frame, int *out_oldframe, float *out_backlerp)
-{
-    int i;
-    for (i = 0; i < interp_count; i++) {
-        if (interp_ents[i].index == index && interp_ents[i].valid) {
-            *out_oldframe = interp_ents[i].prev_frame;
-            *out_backlerp = 1.0f - interp_frac;  /* backlerp = how much of old frame */
-            return qtrue;
-        }
-    }
-    *out_oldframe = cur_frame;
-    *out_backlerp = 0.0f;
-    return qfalse;
-}
-
 static void R_DrawBrushEntities(void)
 {
-    game_export_t *ge = SV_GetGameExport();
+    const snapshot_t *snap = SV_GetSnapshot();
     int i;
 
-    if (!ge || !ge->edicts || ge->num_edicts <= 0)
-        return;
-
-    for (i = 1; i < ge->num_edicts; i++) {
-        edict_t *ent = (edict_t *)((byte *)ge->edicts + i * ge->edict_size);
+    for (i = 0; i < snap->num_entities; i++) {
+        const snapent_t *ent = &snap->entities[i];
         const char *model_name;
         vec3_t render_origin, render_angles;
 
-        if (!ent->inuse)
-            continue;
-
         /* Skip entities flagged as viewer model (not drawn through own eyes) */
         if (ent->s.renderfx & RF_VIEWERMODEL)
             continue;
 
         /* Skip local player entity (edict[1]) — we're looking through their eyes */
-        if (i == 1 && ent->client)
+        if (ent->s.number == 1 && ent->client)
             continue;
 
-        /* Get interpolated position if available, otherwise use current */
-        if (!R_GetInterpOrigin(i, render_origin, ent->s.origin,
-                               render_angles, ent->s.angles)) {
-            VectorCopy(ent->s.origin, render_origin);
-            VectorCopy(ent->s.angles, render_angles);
-        }
+        R_GetInterpOrigin(ent, render_origin, render_angles);
 
         /* EF_ROTATE — spin on pedestal (items, pickups) */
         if (ent->s.effects & EF_ROTATE) {
@@ -920,20 +813,18 @@ static void R_DrawBrushEntities(void)
             if (model_name && model_name[0]) {
                 model_t *mod = R_FindModel(model_name);
                 if (mod && mod->ghoul) {
-                    /* GHOUL skeletal model */
-                    float r_c = 0.8f, g_c = 0.8f, b_c = 0.8f;
-                    R_DrawGhoulModel(mod->ghoul, render_origin, render_angles,
-                                     r_c, g_c, b_c);
+                    /* GHOUL skeletal model, drawn with the rest after the loop */
+                    static const float ghoul_color[3] = { 0.8f, 0.8f, 0.8f };
+
+                    R_AddGhoulInstance(ent, mod->ghoul, render_origin, render_angles[1],
+                                       ghoul_color);
                     R_DrawBlobShadow(render_origin, 16.0f);
                     continue;
                 }
                 if (mod && mod->md2) {
                     float r_c = 0.8f, g_c = 0.8f, b_c = 0.8f;
-                    int oldframe;
-                    float backlerp;
-                    R_GetInterpFrame(i, ent->s.frame, &oldframe, &backlerp);
                     R_DrawAliasModel(mod, render_origin, render_angles,
-                                     ent->s.frame, oldframe, backlerp,
+                                     ent->s.frame, ent->oldframe, 1.0f - interp_frac,
                                      r_c, g_c, b_c);
                     R_DrawBlobShadow(render_origin, 16.0f);
                     continue;
@@ -948,16 +839,16 @@ static void R_DrawBrushEntities(void)
 
             /* Humanoid rendering for monsters and player */
             if ((ent->svflags & SVF_MONSTER) || ent->client) {
-                float r_c, g_c, b_c;
-                if (ent->svflags & SVF_MONSTER) {
-                    r_c = 0.7f; g_c = 0.15f; b_c = 0.1f;  /* dark red = monster */
-                } else {
-                    r_c = 0.1f; g_c = 0.6f; b_c = 0.1f;   /* green = player */
-                }
-                R_DrawHumanoid(render_origin, render_angles[1],
-                               r_c, g_c, b_c, ent->deadflag, ent->health);
-                if (!ent->deadflag)
+                static const float monster_color[3] = { 0.7f, 0.15f, 0.1f };  /* dark red */
+                static const float player_color[3] = { 0.1f, 0.6f, 0.1f };    /* green */
+
+                R_AddGhoulInstance(ent, NULL, render_origin, render_angles[1],
+                                   (ent->svflags & SVF_MONSTER) ? monster_color : player_color);
+                if (!ent->deadflag) {
+                    if (ent->health > 0 && ent->health < 100)
+                        R_DrawHealthBar(render_origin, render_angles[1], ent->health);
                     R_DrawBlobShadow(render_origin, 14.0f);
+                }
             } else {
                 /* Generic entity — yellow wireframe box */
                 if (ent->mins[0] != 0 || ent->maxs[0] != 0 ||
@@ -968,6 +859,9 @@ static void R_DrawBrushEntities(void)
             }
         }
     }
+
+    R_DrawGhoulInstances();
+    R_DrawAliasInstances();
 }
 
 /*
@@ -1579,6 +1473,44 @@ static void R_DrawViewWeapon(refdef_t *fd)
     qglPopMatrix();
 }
 
+#ifdef SOF_RENDERER_VULKAN
+/*
+ * R_RenderFrameVK - The world and the screen blend through r_vk.c. The
+ * rest of the scene (sky, entities, effects, view weapon) is GL-only.
+ */
+static void R_RenderFrameVK(refdef_t *fd)
+{
+    float fog[4] = { 0, 0, 0, 0 };
+
+    if (gl_fog && gl_fog->value > 0) {
+        fog[0] = gl_fogcolor_r ? gl_fogcolor_r->value : 0.5f;
+        fog[1] = gl_fogcolor_g ? gl_fogcolor_g->value : 0.5f;
+        fog[2] = gl_fogcolor_b ? gl_fogcolor_b->value : 0.5f;
+        fog[3] = gl_fogdensity ? gl_fogdensity->value : 0.001f;
+    }
+    if (fd->rdflags & RDF_UNDERWATER) {
+        fog[0] = 0.1f;
+        fog[1] = 0.2f;
+        fog[2] = 0.4f;
+        fog[3] = 0.003f;
+    }
+
+    R_VK_SetView(fd, fog);
+
+    if (R_WorldLoaded()) {
+        Sys_LockMutex(r_fxlock);
+        R_PushDlights(r_dlights, r_dynamic->value ? r_num_dlights : 0);
+        Sys_UnlockMutex(r_fxlock);
+    }
+    if (R_WorldLoaded() && r_drawworld->value)
+        R_DrawWorld();
+
+    /* Queued as 2D, so it lands over the view */
+    if (fd->blend[3] > 0)
+        R_DrawFadeScreenColor(fd->blend[0], fd->blend[1], fd->blend[2], fd->blend[3]);
+}
+#endif
+
 /*
  * R_RenderFrame - Render a 3D scene from a refdef_t
  *
@@ -1588,13 +1520,23 @@ static void R_DrawViewWeapon(refdef_t *fd)
  */
 void R_RenderFrame(refdef_t *fd)
 {
-    if (!fd || !qglClear)
+    if (!fd || (!qglClear && !gl_state.vk))
         return;
 
+    /* 2D queued so far goes under the view, as it was drawn first */
+    R_Flush2D();
+
     /* Update camera state to match refdef (so R_DrawWorld uses correct PVS) */
     R_SetCameraOrigin(fd->vieworg);
     R_SetCameraAngles(fd->viewangles);
 
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_RenderFrameVK(fd);
+        return;
+    }
+#endif
+
     /* Set up 3D projection and modelview */
     R_Setup3DProjection(fd);
     R_Setup3DModelview(fd);
@@ -1636,25 +1578,41 @@ void R_RenderFrame(refdef_t *fd)
     /* Draw skybox (before world, depth writes off so world occludes it) */
     R_DrawSkyBox();
 
+    /* Light the lightmap luxels this frame's dynamic lights reach */
+    if (R_WorldLoaded()) {
+        Sys_LockMutex(r_fxlock);
+        R_PushDlights(r_dlights, r_dynamic->value ? r_num_dlights : 0);
+        Sys_UnlockMutex(r_fxlock);
+    }
+
     /* Draw BSP world */
     if (R_WorldLoaded() && r_drawworld->value)
         R_DrawWorld();
 
     /* Draw brush entities (inline BSP models) */
-    if (r_drawentities->value)
+    if (r_drawentities->value) {
+        Prof_Begin("R_DrawBrushEntities");
         R_DrawBrushEntities();
+        Prof_End();
+    }
+
+    Sys_LockMutex(r_fxlock);
 
     /* Draw decals on world surfaces */
     R_DrawDecals();
 
     /* Draw particles, sprites, and tracers */
+    Prof_Begin("R_DrawParticles");
     R_DrawParticles();
     R_DrawSprites();
     R_DrawTracers();
+    Prof_End();
 
     /* Draw dynamic lights */
     R_DrawDlights();
 
+    Sys_UnlockMutex(r_fxlock);
+
     /* Disable fog before 2D rendering */
     qglDisable(GL_FOG);
 
@@ -1697,7 +1655,19 @@ void R_RenderFrame(refdef_t *fd)
 
 void R_EndFrame(void)
 {
+    R_Flush2D();
+
+    if (r_speeds->value)
+        Com_Printf("%4i faces %4i draws %4i binds %4i relit\n",
+                   c_visible_faces, c_brush_polys, c_state_changes, c_dlight_faces);
+
     /* Swap buffers */
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_EndFrame();
+        return;
+    }
+#endif
     Sys_SwapBuffers();
 }
 
@@ -1705,52 +1675,69 @@ void R_EndFrame(void)
    Particle System
    ========================================================================== */
 
-typedef struct {
-    vec3_t  org;
-    vec3_t  vel;
-    vec3_t  accel;
-    float   color[4];       /* RGBA */
-    float   alpha_decay;    /* alpha lost per second */
-    float   time;           /* time remaining */
-    float   size;           /* particle size (1.0 = default point, >4 = quad) */
-    float   size_decay;     /* size lost per second (shrink over time) */
-} r_particle_t;
+/*
+ * Particles are stored as a structure of arrays, one float array per
+ * field, so the update can step four particles at a time with SSE or
+ * NEON. The pool starts small and doubles on demand up to
+ * R_PARTICLE_LIMIT; all of it is guarded by r_fxlock.
+ */
+enum {
+    PF_ORG,                 /* x, y, z */
+    PF_VEL = PF_ORG + 3,
+    PF_ACCEL = PF_VEL + 3,
+    PF_COLOR = PF_ACCEL + 3,    /* r, g, b, a */
+    PF_ALPHA_DECAY = PF_COLOR + 4,  /* alpha lost per second */
+    PF_TIME,                /* time remaining */
+    PF_SIZE,                /* particle size (1.0 = default point, >4 = quad) */
+    PF_SIZE_DECAY,          /* size lost per second (shrink over time) */
+    PF_NUMFIELDS
+};
 
-#define MAX_R_PARTICLES     2048
+#define R_PARTICLE_START    4096
+#define R_PARTICLE_LIMIT    65536
 
-static r_particle_t r_particles[MAX_R_PARTICLES];
-static int          r_num_particles;
+static struct {
+    float   *f[PF_NUMFIELDS];   /* each holds capacity floats */
+    float   *block;
+    int     num;
+    int     capacity;
+} r_parts;
 
 /*
  * R_ClearParticles - Remove all active particles
  */
 void R_ClearParticles(void)
 {
-    r_num_particles = 0;
+    r_parts.num = 0;
 }
 
-/*
- * R_AddParticle - Spawn a single particle
- */
-static void R_AddParticle(vec3_t org, vec3_t vel, vec3_t accel,
-                           float r, float g, float b, float a,
-                           float alpha_decay, float lifetime)
+/* Make room for one more particle; qfalse at the limit */
+static qboolean R_GrowParticles(void)
 {
-    r_particle_t *p;
+    float   *block;
+    int     i, capacity;
 
-    if (r_num_particles >= MAX_R_PARTICLES)
-        return;
+    if (r_parts.num < r_parts.capacity)
+        return qtrue;
+    if (r_parts.capacity >= R_PARTICLE_LIMIT)
+        return qfalse;
+
+    capacity = r_parts.capacity ? r_parts.capacity * 2 : R_PARTICLE_START;
+    block = (float *)Z_Malloc(capacity * PF_NUMFIELDS * sizeof(float));
 
-    p = &r_particles[r_num_particles++];
-    VectorCopy(org, p->org);
-    VectorCopy(vel, p->vel);
-    VectorCopy(accel, p->accel);
-    p->color[0] = r; p->color[1] = g;
-    p->color[2] = b; p->color[3] = a;
-    p->alpha_decay = alpha_decay;
-    p->time = lifetime;
-    p->size = 3.0f;
-    p->size_decay = 0.0f;
+    for (i = 0; i < PF_NUMFIELDS; i++) {
+        float *field = block + i * capacity;
+
+        if (r_parts.num)
+            memcpy(field, r_parts.f[i], r_parts.num * sizeof(float));
+        r_parts.f[i] = field;
+    }
+
+    if (r_parts.block)
+        Z_Free(r_parts.block);
+    r_parts.block = block;
+    r_parts.capacity = capacity;
+    return qtrue;
 }
 
 /*
@@ -1761,21 +1748,36 @@ static void R_AddParticleSized(vec3_t org, vec3_t vel, vec3_t accel,
                                 float alpha_decay, float lifetime,
                                 float size, float size_decay)
 {
-    r_particle_t *p;
+    float   **f = r_parts.f;
+    int     i, n;
 
-    if (r_num_particles >= MAX_R_PARTICLES)
+    if (!R_GrowParticles())
         return;
 
-    p = &r_particles[r_num_particles++];
-    VectorCopy(org, p->org);
-    VectorCopy(vel, p->vel);
-    VectorCopy(accel, p->accel);
-    p->color[0] = r; p->color[1] = g;
-    p->color[2] = b; p->color[3] = a;
-    p->alpha_decay = alpha_decay;
-    p->time = lifetime;
-    p->size = size;
-    p->size_decay = size_decay;
+    n = r_parts.num++;
+    for (i = 0; i < 3; i++) {
+        f[PF_ORG + i][n] = org[i];
+        f[PF_VEL + i][n] = vel[i];
+        f[PF_ACCEL + i][n] = accel[i];
+    }
+    f[PF_COLOR + 0][n] = r;
+    f[PF_COLOR + 1][n] = g;
+    f[PF_COLOR + 2][n] = b;
+    f[PF_COLOR + 3][n] = a;
+    f[PF_ALPHA_DECAY][n] = alpha_decay;
+    f[PF_TIME][n] = lifetime;
+    f[PF_SIZE][n] = size;
+    f[PF_SIZE_DECAY][n] = size_decay;
+}
+
+/*
+ * R_AddParticle - Spawn a single particle
+ */
+static void R_AddParticle(vec3_t org, vec3_t vel, vec3_t accel,
+                           float r, float g, float b, float a,
+                           float alpha_decay, float lifetime)
+{
+    R_AddParticleSized(org, vel, accel, r, g, b, a, alpha_decay, lifetime, 3.0f, 0.0f);
 }
 
 /*
@@ -1788,6 +1790,7 @@ void R_ParticleEffect(vec3_t org, vec3_t dir, int type, int count)
     float spread, speed;
     vec3_t vel, accel;
 
+    Sys_LockMutex(r_fxlock);
     switch (type) {
     case 0: /* bullet impact — grey/brown dust */
         spread = 30.0f; speed = 60.0f;
@@ -2026,6 +2029,184 @@ void R_ParticleEffect(vec3_t org, vec3_t dir, int type, int count)
         }
         break;
     }
+    Sys_UnlockMutex(r_fxlock);
+}
+
+/* ==========================================================================
+   Dynamic Geometry
+
+   Particles, sprites and tracers are rebuilt every frame. They are written
+   into an r_dynvert_t array and drawn with one call per primitive type
+   instead of a glVertex per corner. With the GL4 path the array is ring
+   buffer memory the GPU reads directly; otherwise it is frame memory drawn
+   through client arrays.
+   ========================================================================== */
+
+static struct {
+    r_dynvert_t *verts;     /* last allocation */
+    int         offset;     /* its ring offset, or -1 */
+} r_dyn;
+
+r_dynvert_t *R_DynAlloc(int numverts)
+{
+    int size = numverts * (int)sizeof(r_dynvert_t);
+
+    r_dyn.verts = NULL;
+    r_dyn.offset = -1;
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4)
+        r_dyn.verts = R_GL4_RingAlloc(size, &r_dyn.offset);
+#endif
+    if (!r_dyn.verts)
+        r_dyn.verts = Z_FrameAlloc(size);
+
+    return r_dyn.verts;
+}
+
+static byte R_DynByte(float f)
+{
+    if (f <= 0.0f) return 0;
+    if (f >= 1.0f) return 255;
+    return (byte)(f * 255.0f);
+}
+
+static void R_DynVert(r_dynvert_t *v, float x, float y, float z, const float *color, float alpha)
+{
+    v->xyz[0] = x;
+    v->xyz[1] = y;
+    v->xyz[2] = z;
+    v->rgba[0] = R_DynByte(color[0]);
+    v->rgba[1] = R_DynByte(color[1]);
+    v->rgba[2] = R_DynByte(color[2]);
+    v->rgba[3] = R_DynByte(alpha);
+}
+
+/* Two triangles for a billboard centred on org */
+static r_dynvert_t *R_DynQuad(r_dynvert_t *v, const vec3_t org, const vec3_t right,
+                              const vec3_t up, float sz, const float *color, float alpha)
+{
+    float   c[4][3];
+    int     i;
+
+    for (i = 0; i < 3; i++) {
+        c[0][i] = org[i] - right[i]*sz - up[i]*sz;
+        c[1][i] = org[i] + right[i]*sz - up[i]*sz;
+        c[2][i] = org[i] + right[i]*sz + up[i]*sz;
+        c[3][i] = org[i] - right[i]*sz + up[i]*sz;
+    }
+
+    R_DynVert(v++, c[0][0], c[0][1], c[0][2], color, alpha);
+    R_DynVert(v++, c[1][0], c[1][1], c[1][2], color, alpha);
+    R_DynVert(v++, c[2][0], c[2][1], c[2][2], color, alpha);
+    R_DynVert(v++, c[0][0], c[0][1], c[0][2], color, alpha);
+    R_DynVert(v++, c[2][0], c[2][1], c[2][2], color, alpha);
+    R_DynVert(v++, c[3][0], c[3][1], c[3][2], color, alpha);
+    return v;
+}
+
+/* verts must be the most recent R_DynAlloc */
+void R_DynDraw(GLenum prim, r_dynvert_t *verts, int numverts)
+{
+    if (numverts <= 0)
+        return;
+
+    c_brush_polys++;
+
+#ifdef SOF_RENDERER_GL4
+    if (verts == r_dyn.verts && r_dyn.offset >= 0) {
+        R_GL4_DrawDynamic(prim, r_dyn.offset, numverts);
+        return;
+    }
+#endif
+
+    qglEnableClientState(GL_VERTEX_ARRAY);
+    qglEnableClientState(GL_COLOR_ARRAY);
+    qglVertexPointer(3, GL_FLOAT, sizeof(r_dynvert_t), verts->xyz);
+    qglColorPointer(4, GL_UNSIGNED_BYTE, sizeof(r_dynvert_t), verts->rgba);
+    qglDrawArrays(prim, 0, numverts);
+    qglDisableClientState(GL_COLOR_ARRAY);
+    qglDisableClientState(GL_VERTEX_ARRAY);
+}
+
+/*
+ * Four-wide float ops for the particle update. Everything is unaligned
+ * loads and stores: the field arrays are only float aligned.
+ */
+#if defined(R_PARTICLE_SSE)
+typedef __m128 pv4_t;
+#define PV_LOAD(p)          _mm_loadu_ps(p)
+#define PV_STORE(p, v)      _mm_storeu_ps(p, v)
+#define PV_SET(x)           _mm_set1_ps(x)
+#define PV_ADD(a, b)        _mm_add_ps(a, b)
+#define PV_SUB(a, b)        _mm_sub_ps(a, b)
+#define PV_MUL(a, b)        _mm_mul_ps(a, b)
+#define PV_MAX(a, b)        _mm_max_ps(a, b)
+#define PV_SELGT0(x, a, b)  _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), a), \
+                                      _mm_andnot_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), b))
+#elif defined(R_PARTICLE_NEON)
+typedef float32x4_t pv4_t;
+#define PV_LOAD(p)          vld1q_f32(p)
+#define PV_STORE(p, v)      vst1q_f32(p, v)
+#define PV_SET(x)           vdupq_n_f32(x)
+#define PV_ADD(a, b)        vaddq_f32(a, b)
+#define PV_SUB(a, b)        vsubq_f32(a, b)
+#define PV_MUL(a, b)        vmulq_f32(a, b)
+#define PV_MAX(a, b)        vmaxq_f32(a, b)
+#define PV_SELGT0(x, a, b)  vbslq_f32(vcgtq_f32(x, vdupq_n_f32(0.0f)), a, b)
+#endif
+
+/* Integrate and fade every particle; dead ones are dropped afterwards */
+static void R_StepParticles(float frametime, int n)
+{
+    float   **f = r_parts.f;
+    int     i = 0, k;
+
+#ifdef PV_LOAD
+    {
+        pv4_t dt = PV_SET(frametime);
+        pv4_t one = PV_SET(1.0f);
+
+        for (; i + 4 <= n; i += 4) {
+            pv4_t size, decay;
+
+            PV_STORE(f[PF_TIME] + i, PV_SUB(PV_LOAD(f[PF_TIME] + i), dt));
+            PV_STORE(f[PF_COLOR + 3] + i, PV_SUB(PV_LOAD(f[PF_COLOR + 3] + i),
+                     PV_MUL(PV_LOAD(f[PF_ALPHA_DECAY] + i), dt)));
+
+            /* Euler integration */
+            for (k = 0; k < 3; k++) {
+                pv4_t vel = PV_ADD(PV_LOAD(f[PF_VEL + k] + i),
+                                   PV_MUL(PV_LOAD(f[PF_ACCEL + k] + i), dt));
+
+                PV_STORE(f[PF_VEL + k] + i, vel);
+                PV_STORE(f[PF_ORG + k] + i, PV_ADD(PV_LOAD(f[PF_ORG + k] + i),
+                                                   PV_MUL(vel, dt)));
+            }
+
+            /* Size decay, only for particles that have one */
+            size = PV_LOAD(f[PF_SIZE] + i);
+            decay = PV_LOAD(f[PF_SIZE_DECAY] + i);
+            PV_STORE(f[PF_SIZE] + i,
+                     PV_SELGT0(decay, PV_MAX(PV_SUB(size, PV_MUL(decay, dt)), one), size));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        f[PF_TIME][i] -= frametime;
+        f[PF_COLOR + 3][i] -= f[PF_ALPHA_DECAY][i] * frametime;
+
+        for (k = 0; k < 3; k++) {
+            f[PF_VEL + k][i] += f[PF_ACCEL + k][i] * frametime;
+            f[PF_ORG + k][i] += f[PF_VEL + k][i] * frametime;
+        }
+
+        if (f[PF_SIZE_DECAY][i] > 0) {
+            f[PF_SIZE][i] -= f[PF_SIZE_DECAY][i] * frametime;
+            if (f[PF_SIZE][i] < 1.0f) f[PF_SIZE][i] = 1.0f;
+        }
+    }
 }
 
 /*
@@ -2033,83 +2214,103 @@ void R_ParticleEffect(vec3_t org, vec3_t dir, int type, int count)
  */
 void R_UpdateParticles(float frametime)
 {
-    int i;
-    r_particle_t *p;
+    float   **f = r_parts.f;
+    int     i, k, live = 0;
 
-    for (i = 0; i < r_num_particles; ) {
-        p = &r_particles[i];
-        p->time -= frametime;
-        p->color[3] -= p->alpha_decay * frametime;
+    R_StepParticles(frametime, r_parts.num);
 
-        if (p->time <= 0 || p->color[3] <= 0) {
-            /* Remove by swapping with last */
-            r_particles[i] = r_particles[--r_num_particles];
+    /* Compact the survivors down, keeping their order */
+    for (i = 0; i < r_parts.num; i++) {
+        if (f[PF_TIME][i] <= 0 || f[PF_COLOR + 3][i] <= 0)
             continue;
+        if (live != i) {
+            for (k = 0; k < PF_NUMFIELDS; k++)
+                f[k][live] = f[k][i];
         }
+        live++;
+    }
+    r_parts.num = live;
+}
 
-        /* Euler integration */
-        p->vel[0] += p->accel[0] * frametime;
-        p->vel[1] += p->accel[1] * frametime;
-        p->vel[2] += p->accel[2] * frametime;
-        p->org[0] += p->vel[0] * frametime;
-        p->org[1] += p->vel[1] * frametime;
-        p->org[2] += p->vel[2] * frametime;
-
-        /* Size decay */
-        if (p->size_decay > 0) {
-            p->size -= p->size_decay * frametime;
-            if (p->size < 1.0f) p->size = 1.0f;
-        }
+#ifdef SOF_RENDERER_GL4
+/* Every particle as one point sprite, streamed through the ring */
+static qboolean R_StreamParticles(void)
+{
+    float           **f = r_parts.f;
+    r_partvert_t    *pv;
+    int             i, offset;
 
-        i++;
+    pv = R_GL4_RingAlloc(r_parts.num * (int)sizeof(r_partvert_t), &offset);
+    if (!pv)
+        return qfalse;
+
+    for (i = 0; i < r_parts.num; i++, pv++) {
+        float color[3] = { f[PF_COLOR][i], f[PF_COLOR + 1][i], f[PF_COLOR + 2][i] };
+
+        R_DynVert(&pv->v, f[PF_ORG][i], f[PF_ORG + 1][i], f[PF_ORG + 2][i],
+                  color, f[PF_COLOR + 3][i]);
+        pv->size = f[PF_SIZE][i];
     }
+
+    R_GL4_DrawParticles(offset, r_parts.num);
+    c_brush_polys++;
+    return qtrue;
 }
+#endif
 
 /*
  * R_DrawParticles - Render all active particles
  *
  * Small particles (size < 6) render as GL_POINTS with variable size.
  * Large particles (size >= 6) render as camera-facing billboard quads
- * for a softer, more volumetric look (smoke, dust clouds, etc).
+ * for a softer, more volumetric look (smoke, dust clouds, etc). On the
+ * GL4 path both kinds are one point-sprite draw, sized in the shader.
  */
 static void R_DrawParticles(void)
 {
-    int i;
-    int has_points = 0, has_quads = 0;
+    float   **f = r_parts.f;
+    int     i;
+    int     num_points = 0, num_quads = 0;
+    qboolean streamed = qfalse;
+    r_dynvert_t *verts, *v;
 
-    if (r_num_particles == 0)
+    if (r_parts.num == 0)
         return;
 
-    /* Check what we need to render */
-    for (i = 0; i < r_num_particles; i++) {
-        if (r_particles[i].size >= 6.0f)
-            has_quads = 1;
-        else
-            has_points = 1;
-        if (has_points && has_quads) break;
-    }
-
     qglDisable(GL_TEXTURE_2D);
     qglEnable(GL_BLEND);
     qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     qglDepthMask(GL_FALSE);
 
+#ifdef SOF_RENDERER_GL4
+    streamed = gl_state.gl4 && R_StreamParticles();
+#endif
+
+    /* Count what we need to render */
+    for (i = 0; !streamed && i < r_parts.num; i++) {
+        if (f[PF_SIZE][i] >= 6.0f)
+            num_quads++;
+        else
+            num_points++;
+    }
+
     /* Pass 1: small particles as GL_POINTS */
-    if (has_points) {
-        if (qglPointSize) qglPointSize(3.0f);
-        qglBegin(GL_POINTS);
-        for (i = 0; i < r_num_particles; i++) {
-            r_particle_t *p = &r_particles[i];
-            if (p->size >= 6.0f) continue;
-            qglColor4f(p->color[0], p->color[1], p->color[2], p->color[3]);
-            qglVertex3f(p->org[0], p->org[1], p->org[2]);
+    if (num_points) {
+        v = verts = R_DynAlloc(num_points);
+        for (i = 0; i < r_parts.num; i++) {
+            float color[3] = { f[PF_COLOR][i], f[PF_COLOR + 1][i], f[PF_COLOR + 2][i] };
+
+            if (f[PF_SIZE][i] >= 6.0f) continue;
+            R_DynVert(v++, f[PF_ORG][i], f[PF_ORG + 1][i], f[PF_ORG + 2][i],
+                      color, f[PF_COLOR + 3][i]);
         }
-        qglEnd();
+        if (qglPointSize) qglPointSize(3.0f);
+        R_DynDraw(GL_POINTS, verts, num_points);
         if (qglPointSize) qglPointSize(1.0f);
     }
 
     /* Pass 2: large particles as camera-facing quads */
-    if (has_quads) {
+    if (num_quads) {
         vec3_t cam_ang, right, up;
         float yaw_rad;
 
@@ -2121,29 +2322,16 @@ static void R_DrawParticles(void)
         right[2] = 0;
         up[0] = 0; up[1] = 0; up[2] = 1;
 
-        qglBegin(GL_QUADS);
-        for (i = 0; i < r_num_particles; i++) {
-            r_particle_t *p = &r_particles[i];
-            float sz;
-            if (p->size < 6.0f) continue;
-            sz = p->size * 0.5f;
-
-            qglColor4f(p->color[0], p->color[1], p->color[2], p->color[3]);
-
-            qglVertex3f(p->org[0] - right[0]*sz - up[0]*sz,
-                         p->org[1] - right[1]*sz - up[1]*sz,
-                         p->org[2] - right[2]*sz - up[2]*sz);
-            qglVertex3f(p->org[0] + right[0]*sz - up[0]*sz,
-                         p->org[1] + right[1]*sz - up[1]*sz,
-                         p->org[2] + right[2]*sz - up[2]*sz);
-            qglVertex3f(p->org[0] + right[0]*sz + up[0]*sz,
-                         p->org[1] + right[1]*sz + up[1]*sz,
-                         p->org[2] + right[2]*sz + up[2]*sz);
-            qglVertex3f(p->org[0] - right[0]*sz + up[0]*sz,
-                         p->org[1] - right[1]*sz + up[1]*sz,
-                         p->org[2] - right[2]*sz + up[2]*sz);
+        v = verts = R_DynAlloc(num_quads * 6);
+        for (i = 0; i < r_parts.num; i++) {
+            vec3_t  org;
+            float   color[3] = { f[PF_COLOR][i], f[PF_COLOR + 1][i], f[PF_COLOR + 2][i] };
+
+            if (f[PF_SIZE][i] < 6.0f) continue;
+            VectorSet(org, f[PF_ORG][i], f[PF_ORG + 1][i], f[PF_ORG + 2][i]);
+            v = R_DynQuad(v, org, right, up, f[PF_SIZE][i] * 0.5f, color, f[PF_COLOR + 3][i]);
         }
-        qglEnd();
+        R_DynDraw(GL_TRIANGLES, verts, num_quads * 6);
     }
 
     qglDepthMask(GL_TRUE);
@@ -2173,14 +2361,18 @@ void R_AddTracer(vec3_t start, vec3_t end, float r, float g, float b)
 {
     r_tracer_t *t;
 
-    if (r_num_tracers >= MAX_TRACERS)
+    Sys_LockMutex(r_fxlock);
+    if (r_num_tracers >= MAX_TRACERS) {
+        Sys_UnlockMutex(r_fxlock);
         return;
+    }
 
     t = &r_tracers[r_num_tracers++];
     VectorCopy(start, t->start);
     VectorCopy(end, t->end);
     t->color[0] = r; t->color[1] = g; t->color[2] = b;
     t->time = TRACER_LIFETIME;
+    Sys_UnlockMutex(r_fxlock);
 }
 
 static void R_UpdateTracers(float frametime)
@@ -2200,6 +2392,7 @@ static void R_UpdateTracers(float frametime)
 static void R_DrawTracers(void)
 {
     int i;
+    r_dynvert_t *verts, *v;
 
     if (r_num_tracers == 0)
         return;
@@ -2209,20 +2402,22 @@ static void R_DrawTracers(void)
     qglBlendFunc(GL_SRC_ALPHA, GL_ONE);  /* additive */
     qglDepthMask(GL_FALSE);
 
-    qglBegin(GL_LINES);
+    v = verts = R_DynAlloc(r_num_tracers * 2);
 
     for (i = 0; i < r_num_tracers; i++) {
         r_tracer_t *t = &r_tracers[i];
         float alpha = t->time / TRACER_LIFETIME;
+        float dim[3];
 
         /* Bright start, dimmer end */
-        qglColor4f(t->color[0], t->color[1], t->color[2], alpha);
-        qglVertex3f(t->start[0], t->start[1], t->start[2]);
-        qglColor4f(t->color[0] * 0.5f, t->color[1] * 0.5f, t->color[2] * 0.5f, alpha * 0.3f);
-        qglVertex3f(t->end[0], t->end[1], t->end[2]);
+        dim[0] = t->color[0] * 0.5f;
+        dim[1] = t->color[1] * 0.5f;
+        dim[2] = t->color[2] * 0.5f;
+        R_DynVert(v++, t->start[0], t->start[1], t->start[2], t->color, alpha);
+        R_DynVert(v++, t->end[0], t->end[1], t->end[2], dim, alpha * 0.3f);
     }
 
-    qglEnd();
+    R_DynDraw(GL_LINES, verts, r_num_tracers * 2);
 
     qglDepthMask(GL_TRUE);
     qglDisable(GL_BLEND);
@@ -2242,14 +2437,18 @@ void R_AddDlight(vec3_t origin, float r, float g, float b, float intensity,
 {
     r_dlight_t *dl;
 
-    if (r_num_dlights >= MAX_DLIGHTS)
+    Sys_LockMutex(r_fxlock);
+    if (r_num_dlights >= MAX_DLIGHTS) {
+        Sys_UnlockMutex(r_fxlock);
         return;
+    }
 
     dl = &r_dlights[r_num_dlights++];
     VectorCopy(origin, dl->origin);
     dl->color[0] = r; dl->color[1] = g; dl->color[2] = b;
     dl->intensity = intensity;
     dl->die = (float)Sys_Milliseconds() + duration * 1000.0f;
+    Sys_UnlockMutex(r_fxlock);
 }
 
 /*
@@ -2311,8 +2510,11 @@ void R_AddSprite(vec3_t origin, float size, float r, float g, float b,
 {
     r_sprite_t *s;
 
-    if (r_num_sprites >= MAX_SPRITES)
+    Sys_LockMutex(r_fxlock);
+    if (r_num_sprites >= MAX_SPRITES) {
+        Sys_UnlockMutex(r_fxlock);
         return;
+    }
 
     s = &r_sprites[r_num_sprites++];
     VectorCopy(origin, s->origin);
@@ -2329,6 +2531,7 @@ void R_AddSprite(vec3_t origin, float size, float r, float g, float b,
     s->current_frame = 0;
     s->frame_time = 0;
     s->frame_accum = 0;
+    Sys_UnlockMutex(r_fxlock);
 }
 
 /*
@@ -2371,6 +2574,7 @@ static void R_DrawSprites(void)
     vec3_t cam_org, cam_ang;
     vec3_t up, right;
     float yaw_rad, pitch_rad;
+    r_dynvert_t *verts, *v;
 
     if (r_num_sprites == 0)
         return;
@@ -2397,38 +2601,14 @@ static void R_DrawSprites(void)
     qglBlendFunc(GL_SRC_ALPHA, GL_ONE);  /* additive blending */
     qglDepthMask(GL_FALSE);
 
-    qglBegin(GL_QUADS);
+    v = verts = R_DynAlloc(r_num_sprites * 6);
 
     for (i = 0; i < r_num_sprites; i++) {
         r_sprite_t *s = &r_sprites[i];
-        vec3_t p1, p2, p3, p4;
-
-        qglColor4f(s->color[0], s->color[1], s->color[2], s->color[3]);
-
-        /* Calculate quad corners */
-        p1[0] = s->origin[0] - right[0] * s->size - up[0] * s->size;
-        p1[1] = s->origin[1] - right[1] * s->size - up[1] * s->size;
-        p1[2] = s->origin[2] - right[2] * s->size - up[2] * s->size;
-
-        p2[0] = s->origin[0] + right[0] * s->size - up[0] * s->size;
-        p2[1] = s->origin[1] + right[1] * s->size - up[1] * s->size;
-        p2[2] = s->origin[2] + right[2] * s->size - up[2] * s->size;
-
-        p3[0] = s->origin[0] + right[0] * s->size + up[0] * s->size;
-        p3[1] = s->origin[1] + right[1] * s->size + up[1] * s->size;
-        p3[2] = s->origin[2] + right[2] * s->size + up[2] * s->size;
-
-        p4[0] = s->origin[0] - right[0] * s->size + up[0] * s->size;
-        p4[1] = s->origin[1] - right[1] * s->size + up[1] * s->size;
-        p4[2] = s->origin[2] - right[2] * s->size + up[2] * s->size;
-
-        qglVertex3f(p1[0], p1[1], p1[2]);
-        qglVertex3f(p2[0], p2[1], p2[2]);
-        qglVertex3f(p3[0], p3[1], p3[2]);
-        qglVertex3f(p4[0], p4[1], p4[2]);
+        v = R_DynQuad(v, s->origin, right, up, s->size, s->color, s->color[3]);
     }
 
-    qglEnd();
+    R_DynDraw(GL_TRIANGLES, verts, r_num_sprites * 6);
 
     qglDepthMask(GL_TRUE);
     qglDisable(GL_BLEND);
@@ -2440,12 +2620,13 @@ static void R_DrawSprites(void)
  * R_DrawDlights - Render dynamic lights as additive flares
  * Draws axis-aligned diamond quads at each light position with additive
  * blending. Bright center fading to transparent edges simulates a glow.
+ * Only with r_dynamic 0; otherwise R_PushDlights lights the world itself.
  */
 static void R_DrawDlights(void)
 {
     int i;
 
-    if (r_num_dlights == 0)
+    if (r_num_dlights == 0 || (r_dynamic->value && R_WorldLoaded()))
         return;
 
     qglDisable(GL_TEXTURE_2D);
@@ -2545,8 +2726,10 @@ static int          r_decal_write;
 
 void R_AddDecal(vec3_t origin, vec3_t normal, int type)
 {
-    r_decal_t *d = &r_decals[r_decal_write];
+    r_decal_t *d;
 
+    Sys_LockMutex(r_fxlock);
+    d = &r_decals[r_decal_write];
     VectorCopy(origin, d->origin);
     VectorCopy(normal, d->normal);
     d->spawn_time = (float)Sys_Milliseconds();
@@ -2554,6 +2737,7 @@ void R_AddDecal(vec3_t origin, vec3_t normal, int type)
     d->active = qtrue;
 
     r_decal_write = (r_decal_write + 1) % MAX_R_DECALS;
+    Sys_UnlockMutex(r_fxlock);
 }
 
 static void R_DrawDecals(void)
@@ -2778,7 +2962,7 @@ void R_SetSky(const char *name, float rotate, vec3_t axis)
     /* Free old sky textures */
     for (i = 0; i < 6; i++) {
         if (sky_textures[i]) {
-            qglDeleteTextures(1, &sky_textures[i]);
+            R_DeleteTexture(sky_textures[i]);
             sky_textures[i] = 0;
         }
     }
@@ -2825,6 +3009,7 @@ void R_EndRegistration(void)
     for (i = 0; i < mod_numknown; i++) {
         if (mod_known[i].name[0] &&
             mod_known[i].registration_sequence != mod_registration_sequence) {
+            R_FreeMD2(&mod_known[i]);
             memset(&mod_known[i], 0, sizeof(mod_known[i]));
         }
     }
@@ -2833,347 +3018,6 @@ void R_EndRegistration(void)
     R_ImageEndRegistration();
 }
 
-/* ==========================================================================
-   2D Drawing Stubs
-   ========================================================================== */
-
-void R_DrawGetPicSize(int *w, int *h, const char *name)
-{
-    image_t *pic = R_FindPic(name);
-    if (pic) {
-        *w = pic->width;
-        *h = pic->height;
-    } else {
-        *w = 0;
-        *h = 0;
-    }
-}
-
-void R_DrawPic(int x, int y, const char *name)
-{
-    image_t *pic = R_FindPic(name);
-    if (!pic || !pic->texnum || !qglBegin)
-        return;
-
-    qglEnable(GL_TEXTURE_2D);
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglBindTexture(GL_TEXTURE_2D, pic->texnum);
-    qglColor4f(1, 1, 1, 1);
-
-    qglBegin(GL_QUADS);
-    qglTexCoord2f(0, 0); qglVertex3f((float)x, (float)y, 0);
-    qglTexCoord2f(1, 0); qglVertex3f((float)(x + pic->width), (float)y, 0);
-    qglTexCoord2f(1, 1); qglVertex3f((float)(x + pic->width), (float)(y + pic->height), 0);
-    qglTexCoord2f(0, 1); qglVertex3f((float)x, (float)(y + pic->height), 0);
-    qglEnd();
-
-    qglDisable(GL_BLEND);
-}
-
-void R_DrawStretchPic(int x, int y, int w, int h, const char *name)
-{
-    image_t *pic = R_FindPic(name);
-    if (!pic || !pic->texnum || !qglBegin)
-        return;
-
-    qglEnable(GL_TEXTURE_2D);
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglBindTexture(GL_TEXTURE_2D, pic->texnum);
-    qglColor4f(1, 1, 1, 1);
-
-    qglBegin(GL_QUADS);
-    qglTexCoord2f(0, 0); qglVertex3f((float)x, (float)y, 0);
-    qglTexCoord2f(1, 0); qglVertex3f((float)(x + w), (float)y, 0);
-    qglTexCoord2f(1, 1); qglVertex3f((float)(x + w), (float)(y + h), 0);
-    qglTexCoord2f(0, 1); qglVertex3f((float)x, (float)(y + h), 0);
-    qglEnd();
-
-    qglDisable(GL_BLEND);
-}
-
-/*
- * Built-in 8x8 bitmap font texture (generated once on first use).
- * Maps ASCII 32-127 into a 128x64 texture (16 chars x 6 rows).
- * Uses a simple 5x7 pixel font baked into GL texture.
- */
-static GLuint   r_charTexture = 0;
-
-/* Minimal 5x7 font bitmaps for ASCII 33-126 (printable chars).
- * Each char is 7 bytes, each byte is a row, bits 4-0 = pixels.
- * Char 0 = '!' (ASCII 33), etc.
- */
-static const byte font5x7[] = {
-    /* ! */  0x04,0x04,0x04,0x04,0x00,0x04,0x00,
-    /* " */  0x0A,0x0A,0x00,0x00,0x00,0x00,0x00,
-    /* # */  0x0A,0x1F,0x0A,0x1F,0x0A,0x00,0x00,
-    /* $ */  0x0E,0x15,0x06,0x14,0x0F,0x04,0x00,
-    /* % */  0x13,0x0B,0x04,0x1A,0x19,0x00,0x00,
-    /* & */  0x06,0x09,0x06,0x15,0x12,0x0D,0x00,
-    /* ' */  0x04,0x04,0x00,0x00,0x00,0x00,0x00,
-    /* ( */  0x08,0x04,0x04,0x04,0x04,0x08,0x00,
-    /* ) */  0x02,0x04,0x04,0x04,0x04,0x02,0x00,
-    /* * */  0x00,0x0A,0x04,0x0A,0x00,0x00,0x00,
-    /* + */  0x00,0x04,0x0E,0x04,0x00,0x00,0x00,
-    /* , */  0x00,0x00,0x00,0x00,0x04,0x02,0x00,
-    /* - */  0x00,0x00,0x0E,0x00,0x00,0x00,0x00,
-    /* . */  0x00,0x00,0x00,0x00,0x04,0x00,0x00,
-    /* / */  0x10,0x08,0x04,0x02,0x01,0x00,0x00,
-    /* 0 */  0x0E,0x11,0x19,0x15,0x13,0x0E,0x00,
-    /* 1 */  0x04,0x06,0x04,0x04,0x04,0x0E,0x00,
-    /* 2 */  0x0E,0x11,0x08,0x04,0x02,0x1F,0x00,
-    /* 3 */  0x0E,0x11,0x0C,0x10,0x11,0x0E,0x00,
-    /* 4 */  0x08,0x0C,0x0A,0x1F,0x08,0x08,0x00,
-    /* 5 */  0x1F,0x01,0x0F,0x10,0x11,0x0E,0x00,
-    /* 6 */  0x0C,0x02,0x0F,0x11,0x11,0x0E,0x00,
-    /* 7 */  0x1F,0x10,0x08,0x04,0x02,0x02,0x00,
-    /* 8 */  0x0E,0x11,0x0E,0x11,0x11,0x0E,0x00,
-    /* 9 */  0x0E,0x11,0x11,0x1E,0x08,0x06,0x00,
-    /* : */  0x00,0x04,0x00,0x04,0x00,0x00,0x00,
-    /* ; */  0x00,0x04,0x00,0x04,0x02,0x00,0x00,
-    /* < */  0x08,0x04,0x02,0x04,0x08,0x00,0x00,
-    /* = */  0x00,0x0E,0x00,0x0E,0x00,0x00,0x00,
-    /* > */  0x02,0x04,0x08,0x04,0x02,0x00,0x00,
-    /* ? */  0x0E,0x11,0x08,0x04,0x00,0x04,0x00,
-    /* @ */  0x0E,0x11,0x1D,0x1D,0x01,0x0E,0x00,
-    /* A */  0x0E,0x11,0x11,0x1F,0x11,0x11,0x00,
-    /* B */  0x0F,0x11,0x0F,0x11,0x11,0x0F,0x00,
-    /* C */  0x0E,0x11,0x01,0x01,0x11,0x0E,0x00,
-    /* D */  0x07,0x09,0x11,0x11,0x09,0x07,0x00,
-    /* E */  0x1F,0x01,0x0F,0x01,0x01,0x1F,0x00,
-    /* F */  0x1F,0x01,0x0F,0x01,0x01,0x01,0x00,
-    /* G */  0x0E,0x11,0x01,0x19,0x11,0x0E,0x00,
-    /* H */  0x11,0x11,0x1F,0x11,0x11,0x11,0x00,
-    /* I */  0x0E,0x04,0x04,0x04,0x04,0x0E,0x00,
-    /* J */  0x1C,0x08,0x08,0x08,0x09,0x06,0x00,
-    /* K */  0x11,0x09,0x07,0x09,0x11,0x11,0x00,
-    /* L */  0x01,0x01,0x01,0x01,0x01,0x1F,0x00,
-    /* M */  0x11,0x1B,0x15,0x11,0x11,0x11,0x00,
-    /* N */  0x11,0x13,0x15,0x19,0x11,0x11,0x00,
-    /* O */  0x0E,0x11,0x11,0x11,0x11,0x0E,0x00,
-    /* P */  0x0F,0x11,0x0F,0x01,0x01,0x01,0x00,
-    /* Q */  0x0E,0x11,0x11,0x15,0x09,0x16,0x00,
-    /* R */  0x0F,0x11,0x0F,0x09,0x11,0x11,0x00,
-    /* S */  0x0E,0x11,0x06,0x08,0x11,0x0E,0x00,
-    /* T */  0x1F,0x04,0x04,0x04,0x04,0x04,0x00,
-    /* U */  0x11,0x11,0x11,0x11,0x11,0x0E,0x00,
-    /* V */  0x11,0x11,0x11,0x0A,0x0A,0x04,0x00,
-    /* W */  0x11,0x11,0x15,0x15,0x1B,0x11,0x00,
-    /* X */  0x11,0x0A,0x04,0x0A,0x11,0x00,0x00,
-    /* Y */  0x11,0x0A,0x04,0x04,0x04,0x04,0x00,
-    /* Z */  0x1F,0x08,0x04,0x02,0x01,0x1F,0x00,
-    /* [ */  0x0E,0x02,0x02,0x02,0x02,0x0E,0x00,
-    /* \ */  0x01,0x02,0x04,0x08,0x10,0x00,0x00,
-    /* ] */  0x0E,0x08,0x08,0x08,0x08,0x0E,0x00,
-    /* ^ */  0x04,0x0A,0x00,0x00,0x00,0x00,0x00,
-    /* _ */  0x00,0x00,0x00,0x00,0x00,0x1F,0x00,
-    /* ` */  0x02,0x04,0x00,0x00,0x00,0x00,0x00,
-    /* a */  0x00,0x0E,0x10,0x1E,0x11,0x1E,0x00,
-    /* b */  0x01,0x0F,0x11,0x11,0x11,0x0F,0x00,
-    /* c */  0x00,0x0E,0x01,0x01,0x01,0x0E,0x00,
-    /* d */  0x10,0x1E,0x11,0x11,0x11,0x1E,0x00,
-    /* e */  0x00,0x0E,0x11,0x1F,0x01,0x0E,0x00,
-    /* f */  0x0C,0x02,0x0F,0x02,0x02,0x02,0x00,
-    /* g */  0x00,0x1E,0x11,0x1E,0x10,0x0E,0x00,
-    /* h */  0x01,0x0F,0x11,0x11,0x11,0x11,0x00,
-    /* i */  0x04,0x00,0x06,0x04,0x04,0x0E,0x00,
-    /* j */  0x08,0x00,0x0C,0x08,0x08,0x06,0x00,
-    /* k */  0x01,0x09,0x05,0x03,0x05,0x09,0x00,
-    /* l */  0x06,0x04,0x04,0x04,0x04,0x0E,0x00,
-    /* m */  0x00,0x0B,0x15,0x15,0x11,0x11,0x00,
-    /* n */  0x00,0x0F,0x11,0x11,0x11,0x11,0x00,
-    /* o */  0x00,0x0E,0x11,0x11,0x11,0x0E,0x00,
-    /* p */  0x00,0x0F,0x11,0x0F,0x01,0x01,0x00,
-    /* q */  0x00,0x1E,0x11,0x1E,0x10,0x10,0x00,
-    /* r */  0x00,0x0D,0x13,0x01,0x01,0x01,0x00,
-    /* s */  0x00,0x0E,0x02,0x04,0x08,0x0E,0x00,
-    /* t */  0x02,0x0F,0x02,0x02,0x02,0x0C,0x00,
-    /* u */  0x00,0x11,0x11,0x11,0x11,0x1E,0x00,
-    /* v */  0x00,0x11,0x11,0x0A,0x0A,0x04,0x00,
-    /* w */  0x00,0x11,0x11,0x15,0x15,0x0A,0x00,
-    /* x */  0x00,0x11,0x0A,0x04,0x0A,0x11,0x00,
-    /* y */  0x00,0x11,0x11,0x1E,0x10,0x0E,0x00,
-    /* z */  0x00,0x1F,0x08,0x04,0x02,0x1F,0x00,
-    /* { */  0x08,0x04,0x02,0x04,0x08,0x00,0x00,
-    /* | */  0x04,0x04,0x04,0x04,0x04,0x04,0x00,
-    /* } */  0x02,0x04,0x08,0x04,0x02,0x00,0x00,
-    /* ~ */  0x00,0x05,0x0A,0x00,0x00,0x00,0x00,
-};
-
-static void R_InitCharFont(void)
-{
-    byte pixels[128 * 64 * 4];  /* RGBA 128x64 */
-    int ch, row, col, px, py;
-
-    memset(pixels, 0, sizeof(pixels));
-
-    for (ch = 33; ch <= 126; ch++) {
-        int idx = ch - 33;
-        int cx = (ch % 16) * 8;
-        int cy = ((ch - 32) / 16) * 8;
-        const byte *glyph = &font5x7[idx * 7];
-
-        for (py = 0; py < 7; py++) {
-            byte bits = glyph[py];
-            for (px = 0; px < 5; px++) {
-                if (bits & (1 << px)) {
-                    int tx = cx + px + 1;
-                    int ty = cy + py;
-                    int ofs = (ty * 128 + tx) * 4;
-                    pixels[ofs + 0] = 255;
-                    pixels[ofs + 1] = 255;
-                    pixels[ofs + 2] = 255;
-                    pixels[ofs + 3] = 255;
-                }
-            }
-        }
-    }
-
-    qglGenTextures(1, &r_charTexture);
-    qglBindTexture(GL_TEXTURE_2D, r_charTexture);
-    qglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 128, 64, 0,
-                  GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-}
-
-/* Current draw color for text rendering (default green for console) */
-static float r_drawcolor[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
-
-void R_SetDrawColor(float r, float g, float b, float a)
-{
-    r_drawcolor[0] = r;
-    r_drawcolor[1] = g;
-    r_drawcolor[2] = b;
-    r_drawcolor[3] = a;
-}
-
-void R_DrawChar(int x, int y, int ch)
-{
-    float s1, t1, s2, t2;
-    int cx, cy;
-
-    if (!qglBegin)
-        return;
-
-    ch &= 255;
-    if (ch == ' ' || ch < 32 || ch > 126)
-        return;
-
-    /* Generate font texture on first use */
-    if (!r_charTexture)
-        R_InitCharFont();
-
-    /* Calculate UV coordinates in 128x64 texture */
-    cx = (ch % 16) * 8;
-    cy = ((ch - 32) / 16) * 8;
-    s1 = cx / 128.0f;
-    t1 = cy / 64.0f;
-    s2 = (cx + 8) / 128.0f;
-    t2 = (cy + 8) / 64.0f;
-
-    qglEnable(GL_TEXTURE_2D);
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglBindTexture(GL_TEXTURE_2D, r_charTexture);
-    qglColor4f(r_drawcolor[0], r_drawcolor[1], r_drawcolor[2], r_drawcolor[3]);
-
-    qglBegin(GL_QUADS);
-    qglTexCoord2f(s1, t1); qglVertex3f((float)x,     (float)y,     0);
-    qglTexCoord2f(s2, t1); qglVertex3f((float)(x+8),  (float)y,     0);
-    qglTexCoord2f(s2, t2); qglVertex3f((float)(x+8),  (float)(y+8), 0);
-    qglTexCoord2f(s1, t2); qglVertex3f((float)x,     (float)(y+8), 0);
-    qglEnd();
-
-    qglDisable(GL_BLEND);
-    qglColor4f(1, 1, 1, 1);
-}
-
-void R_DrawString(int x, int y, const char *str)
-{
-    while (*str) {
-        if (*str != ' ')
-            R_DrawChar(x, y, (unsigned char)*str);
-        x += 8;
-        str++;
-    }
-}
-
-void R_DrawTileClear(int x, int y, int w, int h, const char *name)
-{
-    (void)x; (void)y; (void)w; (void)h; (void)name;
-}
-
-void R_DrawFill(int x, int y, int w, int h, int c)
-{
-    float r, g, b, a;
-
-    if (!qglDisable || !qglBegin)
-        return;
-
-    /* Unpack RGBA if high bits set, otherwise use Q2 palette index */
-    if (c & 0xFF000000) {
-        /* ARGB packed color from console */
-        a = ((c >> 24) & 0xFF) / 255.0f;
-        r = (c & 0xFF) / 255.0f;
-        g = ((c >> 8) & 0xFF) / 255.0f;
-        b = ((c >> 16) & 0xFF) / 255.0f;
-    } else {
-        /* Q2 palette index — approximate */
-        r = ((c >> 5) & 7) / 7.0f;
-        g = ((c >> 2) & 7) / 7.0f;
-        b = (c & 3) / 3.0f;
-        a = 1.0f;
-    }
-
-    qglDisable(GL_TEXTURE_2D);
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglColor4f(r, g, b, a);
-    qglBegin(GL_QUADS);
-    qglVertex3f((float)x, (float)y, 0);
-    qglVertex3f((float)(x + w), (float)y, 0);
-    qglVertex3f((float)(x + w), (float)(y + h), 0);
-    qglVertex3f((float)x, (float)(y + h), 0);
-    qglEnd();
-    qglDisable(GL_BLEND);
-    qglEnable(GL_TEXTURE_2D);
-    qglColor4f(1, 1, 1, 1);
-}
-
-void R_DrawFadeScreen(void)
-{
-    R_DrawFadeScreenColor(0, 0, 0, 0.8f);
-}
-
-void R_DrawFadeScreenColor(float r, float g, float b, float a)
-{
-    if (!qglEnable || !qglBegin)
-        return;
-
-    qglEnable(GL_BLEND);
-    qglDisable(GL_TEXTURE_2D);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglColor4f(r, g, b, a);
-    qglBegin(GL_QUADS);
-    qglVertex3f(0, 0, 0);
-    qglVertex3f((float)g_display.width, 0, 0);
-    qglVertex3f((float)g_display.width, (float)g_display.height, 0);
-    qglVertex3f(0, (float)g_display.height, 0);
-    qglEnd();
-    qglColor4f(1, 1, 1, 1);
-    qglEnable(GL_TEXTURE_2D);
-    qglDisable(GL_BLEND);
-}
-
-void R_DrawStretchRaw(int x, int y, int w, int h, int cols, int rows, byte *data)
-{
-    (void)x; (void)y; (void)w; (void)h;
-    (void)cols; (void)rows; (void)data;
-    /* TODO: Used for cinematic playback */
-}
-
 /* Quake II standard video modes + modern additions */
 typedef struct {
     int     width;
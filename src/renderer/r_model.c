@@ -12,6 +12,12 @@
  *   - Frames (scale + translate + name + compressed vertices)
  *   - GL commands (triangle strips/fans for optimized rendering)
  *
+ * On the GL4 path every frame is uploaded once at load and the vertex
+ * shader lerps between two of them, so a model costs the CPU one instance
+ * record whatever its vertex count. R_DrawAliasModel only queues it;
+ * R_DrawAliasInstances draws each distinct model once, instanced. The
+ * GL 1.x path lerps on the CPU as before.
+ *
  * Original SoF: ref_gl.dll loaded MD2s at 0x30xxxxxx
  */
 
@@ -364,6 +370,30 @@ qboolean R_LoadMD2(model_t *mod, const char *name)
         }
     }
 
+#ifdef SOF_RENDERER_GL4
+    /* Every frame goes to the GPU now; drawing only picks two of them */
+    if (gl_state.gl4) {
+        uint16_t *indices = (uint16_t *)Z_Malloc(mesh->num_tris * 3 * sizeof(uint16_t));
+        int n = 0;
+
+        for (i = 0; i < mesh->num_tris; i++) {
+            const int *t = &mesh->tris[i * 3];
+
+            if (t[0] < 0 || t[0] >= mesh->num_verts || t[1] < 0 || t[1] >= mesh->num_verts ||
+                t[2] < 0 || t[2] >= mesh->num_verts)
+                continue;
+            indices[n++] = (uint16_t)t[0];
+            indices[n++] = (uint16_t)t[1];
+            indices[n++] = (uint16_t)t[2];
+        }
+
+        if (n)
+            R_GL4_CreateAliasMesh(&mesh->gl4, mesh->frames, mesh->num_frames,
+                                  mesh->num_verts, mesh->texcoords, indices, n);
+        Z_Free(indices);
+    }
+#endif
+
     /* Load skin textures if available */
     if (hdr->num_skins > 0) {
         char *skin_names = (char *)(buf + hdr->ofs_skins);
@@ -391,6 +421,9 @@ qboolean R_LoadMD2(model_t *mod, const char *name)
 void R_FreeMD2(model_t *mod)
 {
     if (mod->md2) {
+#ifdef SOF_RENDERER_GL4
+        R_GL4_FreeAliasMesh(&mod->md2->gl4);
+#endif
         if (mod->md2->tris) Z_Free(mod->md2->tris);
         if (mod->md2->texcoords) Z_Free(mod->md2->texcoords);
         if (mod->md2->frames) Z_Free(mod->md2->frames);
@@ -404,43 +437,55 @@ void R_FreeMD2(model_t *mod)
    MD2 Renderer
    ========================================================================== */
 
-/*
- * R_DrawAliasModel - Render an MD2 model at a world position
- *
- * Supports frame interpolation (backlerp between oldframe and frame).
- * Uses basic directional lighting with ambient.
- */
-void R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
-                      int frame, int oldframe, float backlerp,
-                      float r, float g, float b)
+#ifdef SOF_RENDERER_GL4
+/* Rotation by deg about one axis, as glRotatef */
+static void R_AxisRotation(float m[3][3], int axis, float deg)
 {
-    md2_mesh_t *mesh;
-    float *cur_verts, *old_verts;
-    float frontlerp;
-    int i;
+    int     u = (axis + 1) % 3, w = (axis + 2) % 3;
+    float   a = deg * (3.14159265f / 180.0f);
+
+    memset(m, 0, 9 * sizeof(float));
+    m[axis][axis] = 1.0f;
+    m[u][u] = m[w][w] = cosf(a);
+    m[u][w] = -sinf(a);
+    m[w][u] = sinf(a);
+}
 
-    if (!mod || !mod->md2)
-        return;
+/* Model to world, the same transform R_DrawAliasCPU builds with GL calls */
+static void R_AliasTransform(const vec3_t origin, const vec3_t angles, float rows[3][4])
+{
+    float   yaw[3][3], pitch[3][3], roll[3][3], yp[3][3];
+    int     i, j;
+
+    R_AxisRotation(yaw, 2, angles[1]);
+    R_AxisRotation(pitch, 1, -angles[0]);
+    R_AxisRotation(roll, 0, angles[2]);
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            yp[i][j] = yaw[i][0] * pitch[0][j] + yaw[i][1] * pitch[1][j] + yaw[i][2] * pitch[2][j];
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++)
+            rows[i][j] = yp[i][0] * roll[0][j] + yp[i][1] * roll[1][j] + yp[i][2] * roll[2][j];
+        rows[i][3] = origin[i];
+    }
+}
 
-    mesh = mod->md2;
+#endif
 
-    /* Clamp frame indices */
-    if (frame < 0 || frame >= mesh->num_frames) frame = 0;
-    if (oldframe < 0 || oldframe >= mesh->num_frames) oldframe = 0;
+/* GL 1.x path: lerp every vertex on the CPU, in immediate mode */
+static void R_DrawAliasCPU(model_t *mod, const vec3_t origin, const vec3_t angles,
+                           int frame, int oldframe, float backlerp, const float *color)
+{
+    md2_mesh_t *mesh = mod->md2;
+    float *cur_verts, *old_verts;
+    float frontlerp;
+    int i;
 
     cur_verts = mesh->frames + frame * mesh->num_verts * 3;
     old_verts = mesh->frames + oldframe * mesh->num_verts * 3;
     frontlerp = 1.0f - backlerp;
 
-    /* Sample world light at model position */
-    {
-        vec3_t lightcolor;
-        R_LightPoint(origin, lightcolor);
-        r *= lightcolor[0];
-        g *= lightcolor[1];
-        b *= lightcolor[2];
-    }
-
     /* Set up model transform */
     qglPushMatrix();
 
@@ -462,17 +507,20 @@ void R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
 
     /* Draw triangles with vertex interpolation */
     qglBegin(GL_TRIANGLES);
-    qglColor4f(r, g, b, 1.0f);
 
     for (i = 0; i < mesh->num_tris; i++) {
+        const int *t = &mesh->tris[i * 3];
         int j;
+
+        /* Whole triangles only, or the rest would be misaligned */
+        if (t[0] < 0 || t[0] >= mesh->num_verts || t[1] < 0 || t[1] >= mesh->num_verts ||
+            t[2] < 0 || t[2] >= mesh->num_verts)
+            continue;
+
         for (j = 0; j < 3; j++) {
-            int vi = mesh->tris[i * 3 + j];
+            int vi = t[j];
             float vx, vy, vz;
 
-            if (vi < 0 || vi >= mesh->num_verts)
-                continue;
-
             /* Interpolate vertex position */
             vx = old_verts[vi*3+0] * backlerp + cur_verts[vi*3+0] * frontlerp;
             vy = old_verts[vi*3+1] * backlerp + cur_verts[vi*3+1] * frontlerp;
@@ -488,7 +536,7 @@ void R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
             {
                 float shade = 0.6f + 0.4f * (vz - mesh->mins[2]) /
                               (mesh->maxs[2] - mesh->mins[2] + 0.01f);
-                qglColor4f(r * shade, g * shade, b * shade, 1.0f);
+                qglColor4f(color[0] * shade, color[1] * shade, color[2] * shade, 1.0f);
             }
 
             qglVertex3f(vx, vy, vz);
@@ -504,3 +552,133 @@ void R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
 
     qglPopMatrix();
 }
+
+#ifdef SOF_RENDERER_GL4
+#define MAX_ALIAS_INSTANCES 1024
+
+typedef struct {
+    model_t         *mod;
+    vec3_t          origin, angles;     /* for the CPU fallback */
+    int             frame, oldframe;
+    r_aliasinst_t   inst;
+} r_aliasqueue_t;
+
+static r_aliasqueue_t   alias_queue[MAX_ALIAS_INSTANCES];
+static int              alias_queued;
+#endif
+
+/*
+ * R_DrawAliasModel - Render an MD2 model at a world position
+ *
+ * Supports frame interpolation (backlerp between oldframe and frame).
+ * Uses basic directional lighting with ambient. On the GL4 path the model
+ * is queued for R_DrawAliasInstances instead of drawn here.
+ */
+void R_DrawAliasModel(model_t *mod, vec3_t origin, vec3_t angles,
+                      int frame, int oldframe, float backlerp,
+                      float r, float g, float b)
+{
+    md2_mesh_t *mesh;
+    float color[3];
+
+    if (!mod || !mod->md2)
+        return;
+
+    mesh = mod->md2;
+
+    /* Clamp frame indices */
+    if (frame < 0 || frame >= mesh->num_frames) frame = 0;
+    if (oldframe < 0 || oldframe >= mesh->num_frames) oldframe = 0;
+
+    /* Sample world light at model position */
+    {
+        vec3_t lightcolor;
+        R_LightPoint(origin, lightcolor);
+        color[0] = r * lightcolor[0];
+        color[1] = g * lightcolor[1];
+        color[2] = b * lightcolor[2];
+    }
+
+    if (mod->num_skins > 0 && mod->skins[0])
+        R_TouchImage(mod->skins[0]);
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4 && mesh->gl4.vao && alias_queued < MAX_ALIAS_INSTANCES) {
+        r_aliasqueue_t *q = &alias_queue[alias_queued++];
+
+        q->mod = mod;
+        VectorCopy(origin, q->origin);
+        VectorCopy(angles, q->angles);
+        q->frame = frame;
+        q->oldframe = oldframe;
+        R_AliasTransform(origin, angles, q->inst.rows);
+        q->inst.color[0] = color[0];
+        q->inst.color[1] = color[1];
+        q->inst.color[2] = color[2];
+        q->inst.color[3] = 1.0f;
+        q->inst.frame = (uint32_t)(frame * mesh->num_verts);
+        q->inst.oldframe = (uint32_t)(oldframe * mesh->num_verts);
+        q->inst.backlerp = backlerp;
+        q->inst.pad = 0;
+        return;
+    }
+#endif
+
+    R_DrawAliasCPU(mod, origin, angles, frame, oldframe, backlerp, color);
+}
+
+#ifdef SOF_RENDERER_GL4
+static int R_AliasQueueCmp(const void *a, const void *b)
+{
+    const model_t *ma = ((const r_aliasqueue_t *)a)->mod;
+    const model_t *mb = ((const r_aliasqueue_t *)b)->mod;
+
+    return ma < mb ? -1 : ma > mb;
+}
+#endif
+
+/* Draw what R_DrawAliasModel queued: one instanced draw per model */
+void R_DrawAliasInstances(void)
+{
+#ifdef SOF_RENDERER_GL4
+    r_aliasinst_t   *insts;
+    int             ofs, i, start;
+
+    if (!alias_queued)
+        return;
+
+    qsort(alias_queue, alias_queued, sizeof(alias_queue[0]), R_AliasQueueCmp);
+
+    /* Ring full: the CPU path still has everything it needs */
+    insts = R_GL4_StorageAlloc(alias_queued * (int)sizeof(r_aliasinst_t), &ofs);
+    if (!insts) {
+        for (i = 0; i < alias_queued; i++) {
+            r_aliasqueue_t *q = &alias_queue[i];
+
+            R_DrawAliasCPU(q->mod, q->origin, q->angles, q->frame, q->oldframe,
+                           q->inst.backlerp, q->inst.color);
+        }
+        alias_queued = 0;
+        return;
+    }
+
+    for (i = 0; i < alias_queued; i++)
+        insts[i] = alias_queue[i].inst;
+
+    for (start = 0; start < alias_queued; start = i) {
+        model_t     *mod = alias_queue[start].mod;
+        md2_mesh_t  *mesh = mod->md2;
+        GLuint      texnum = mod->num_skins > 0 && mod->skins[0] ? mod->skins[0]->texnum : 0;
+
+        for (i = start + 1; i < alias_queued && alias_queue[i].mod == mod; i++)
+            ;
+
+        R_GL4_DrawAlias(&mesh->gl4, texnum, mesh->mins[2],
+                        1.0f / (mesh->maxs[2] - mesh->mins[2] + 0.01f),
+                        ofs + start * (int)sizeof(r_aliasinst_t), i - start);
+        c_brush_polys++;
+    }
+
+    alias_queued = 0;
+#endif
+}
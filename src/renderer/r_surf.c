@@ -1,16 +1,20 @@
 /*
  * r_surf.c - BSP surface rendering
  *
- * Renders loaded BSP world geometry using OpenGL immediate mode.
- * Converts BSP face→surfedge→edge→vertex chains into GL polygons.
+ * Renders loaded BSP world geometry from a vertex buffer baked at map load.
+ * Converts BSP face→surfedge→edge→vertex chains into GL triangles once.
  *
- * BSP Face Rendering Pipeline:
- *   1. For each visible face:
+ * BSP Face Baking (R_BuildWorldMesh):
+ *   1. For each face:
  *      a. Get face's surfedge list (face->firstedge, face->numedges)
  *      b. Each surfedge is an index into the edges array (negative = reversed)
  *      c. Each edge has two vertex indices
- *      d. Emit vertices as a GL triangle fan
- *   2. Texture coordinates computed from texinfo vecs[2][4]
+ *      d. Emit the vertices, and the fan as a list of triangles
+ *   2. Texture coordinates computed from texinfo vecs[2][4], lightmap
+ *      coordinates from the face's place in the lightmap atlas
+ *
+ * Each frame the visible faces are gathered per material and drawn with
+ * glDrawElements. Water still goes through immediate mode (it animates).
  *
  * Original ref_gl.dll: R_DrawBrushModel at 0x3000BC00
  */
@@ -30,14 +34,20 @@ static vec3_t   r_camera_origin;
 static vec3_t   r_camera_angles;    /* pitch, yaw, roll */
 static float    r_camera_speed = 400.0f;
 
-/* Stats */
-static int  c_brush_polys;
-static int  c_visible_faces;
+/* Stats — reset by R_DrawWorld, read by the timedemo report */
+int         c_brush_polys;      /* draw calls issued */
+int         c_visible_faces;
 
 /* Per-texinfo cached texture lookups (populated on map load) */
 #define MAX_TEXINFO_CACHE   8192
 static image_t  *r_texinfo_images[MAX_TEXINFO_CACHE];
 
+/* World mesh and visibility — defined below */
+static void R_BuildWorldMesh(bsp_world_t *world);
+static void R_FreeWorldMesh(void);
+static void R_BuildWorldVis(bsp_world_t *world);
+static void R_FreeWorldVis(void);
+
 /* ==========================================================================
    Map Loading
    ========================================================================== */
@@ -51,6 +61,7 @@ void R_LoadWorldMap(const char *name)
 
     /* Free previous map */
     if (r_worldloaded) {
+        R_FreeWorldMesh();
         R_FreeLightmaps();
         BSP_Free(&r_worldmodel);
         r_worldloaded = qfalse;
@@ -58,22 +69,43 @@ void R_LoadWorldMap(const char *name)
 
     Com_Printf("Loading map: %s\n", fullname);
 
+    Prof_MapLoadBegin(LOAD_BSP);
     if (!BSP_Load(fullname, &r_worldmodel)) {
+        Prof_MapLoadEnd();
         Com_Printf("R_LoadWorldMap: couldn't load %s\n", fullname);
         return;
     }
+    Prof_MapLoadEnd();
 
     r_worldloaded = qtrue;
 
-    /* Load textures for all texinfo entries */
+    /* Load textures for all texinfo entries. Everything is queued on the
+     * background loader first so decoding overlaps the lightmap build;
+     * the second pass only waits on whatever hasn't finished yet. */
     {
         int ti;
         int loaded = 0, missed = 0;
+        int start = Sys_Milliseconds();
+        int numti = r_worldmodel.num_texinfo;
+
+        if (numti > MAX_TEXINFO_CACHE)
+            numti = MAX_TEXINFO_CACHE;
 
         memset(r_texinfo_images, 0, sizeof(r_texinfo_images));
+        Prof_MapLoadBegin(LOAD_TEXTURES);
         R_ImageBeginRegistration();
 
-        for (ti = 0; ti < r_worldmodel.num_texinfo && ti < MAX_TEXINFO_CACHE; ti++) {
+        for (ti = 0; ti < numti; ti++)
+            R_PrecacheImage(r_worldmodel.texinfo[ti].texture);
+        Prof_MapLoadEnd();
+
+        /* Build lightmap atlas textures */
+        Prof_MapLoadBegin(LOAD_LIGHTMAPS);
+        R_BuildLightmaps(&r_worldmodel);
+        Prof_MapLoadEnd();
+
+        Prof_MapLoadBegin(LOAD_TEXTURES);
+        for (ti = 0; ti < numti; ti++) {
             const char *texname = r_worldmodel.texinfo[ti].texture;
             if (texname[0]) {
                 r_texinfo_images[ti] = R_FindImage(texname);
@@ -85,13 +117,17 @@ void R_LoadWorldMap(const char *name)
         }
 
         R_ImageEndRegistration();
-        Com_Printf("Textures: %d loaded, %d missing (of %d texinfo)\n",
-                   loaded, missed, r_worldmodel.num_texinfo);
+        Prof_MapLoadEnd();
+        Com_Printf("Textures: %d loaded, %d missing (of %d texinfo) in %d ms\n",
+                   loaded, missed, r_worldmodel.num_texinfo,
+                   Sys_Milliseconds() - start);
 
     }
 
-    /* Build lightmap atlas textures */
-    R_BuildLightmaps(&r_worldmodel);
+    /* Needs texture sizes and lightmap atlases, so last */
+    Prof_MapLoadBegin(LOAD_BSP);
+    R_BuildWorldMesh(&r_worldmodel);
+    Prof_MapLoadEnd();
 
     /* Reset camera to origin */
     VectorClear(r_camera_origin);
@@ -218,40 +254,163 @@ void R_UpdateCamera(float forward, float right, float up,
 }
 
 /* ==========================================================================
-   Surface Rendering
+   World Mesh
+   Every world face is baked at map load into one interleaved vertex
+   buffer — position, diffuse UV and lightmap atlas UV — plus a triangle
+   index list, so drawing a face no longer walks surfedges or recomputes
+   texture coordinates. Faces with the same texture, lightmap atlas and
+   surface flags share a material. Materials are sorted by pass, then
+   texture, then lightmap, so walking them in order changes as little GL
+   state as possible.
    ========================================================================== */
 
-/*
- * Draw a single BSP face as a triangle fan
- * face_idx is needed for lightmap TC lookup
- */
-static void R_DrawFace(bsp_world_t *world, bsp_face_t *face,
-                        int face_idx, qboolean use_lightmap)
+/* Which pass a face is drawn in */
+typedef enum {
+    WPASS_OPAQUE,
+    WPASS_ALPHATEST,    /* texture alpha only: no sorting needed */
+    WPASS_BLEND,        /* trans33/66 and water: sorted back to front */
+    WPASS_NUM
+} worldpass_t;
+
+#define WORLD_BLEND_FLAGS   (SURF_TRANS33 | SURF_TRANS66 | SURF_WARP)
+
+typedef struct {
+    float   xyz[3];
+    float   st[2];          /* diffuse, normalized by texture size */
+    float   lm[2];          /* lightmap atlas */
+} worldvert_t;
+
+typedef struct {
+    int     firstindex;
+    int     numindices;     /* 0 = never drawn (sky, nodraw, degenerate) */
+    int     material;
+    vec3_t  center;         /* blend pass sort key */
+} worldface_t;
+
+typedef struct {
+    worldpass_t pass;
+    image_t     *image;
+    GLuint      lightmap;
+    int         flags;      /* WORLD_BLEND_FLAGS subset */
+    int         face;       /* first face using it, for R_FaceColor */
+} worldmaterial_t;
+
+static struct {
+    worldvert_t     *verts;     /* NULL once uploaded to the VBO */
+    int             numverts;
+    GLuint          *indices;
+    int             numindices;
+    worldface_t     *faces;
+    worldmaterial_t *materials;
+    int             nummaterials;
+    GLuint          vbo;
+} r_worldmesh;
+
+static image_t *R_FaceImage(bsp_world_t *world, bsp_face_t *face)
 {
-    int         i;
-    int         edge_idx;
-    bsp_edge_t  *edge;
-    float       *v;
-    bsp_texinfo_t *ti = NULL;
-    qboolean    is_warp = qfalse;
-    float       warp_time = 0;
-
-    if (face->numedges < 3)
+    if (face->texinfo < 0 || face->texinfo >= world->num_texinfo ||
+        face->texinfo >= MAX_TEXINFO_CACHE)
+        return NULL;
+    return r_texinfo_images[face->texinfo];
+}
+
+static int R_FaceFlags(bsp_world_t *world, bsp_face_t *face)
+{
+    if (face->texinfo < 0 || face->texinfo >= world->num_texinfo)
+        return 0;
+    return world->texinfo[face->texinfo].flags;
+}
+
+/* Untextured faces are colored per texinfo, so they can only share with
+ * the same texinfo */
+static int R_FindMaterial(bsp_world_t *world, int face_idx, int *hash, int hashsize)
+{
+    bsp_face_t      *face = &world->faces[face_idx];
+    image_t         *img = R_FaceImage(world, face);
+    GLuint          lm = R_GetFaceLightmapTexture(face_idx);
+    int             flags = R_FaceFlags(world, face) & WORLD_BLEND_FLAGS;
+    uintptr_t       key = img ? (uintptr_t)img : (uintptr_t)face->texinfo;
+    unsigned        h = (unsigned)((key >> 4) * 31 + lm * 7 + flags) & (hashsize - 1);
+    worldmaterial_t *mat;
+
+    while (hash[h] >= 0) {
+        mat = &r_worldmesh.materials[hash[h]];
+        if (mat->image == img && mat->lightmap == lm && mat->flags == flags &&
+            (img || world->faces[mat->face].texinfo == face->texinfo))
+            return hash[h];
+        h = (h + 1) & (hashsize - 1);
+    }
+
+    hash[h] = r_worldmesh.nummaterials;
+    mat = &r_worldmesh.materials[r_worldmesh.nummaterials];
+    mat->image = img;
+    mat->lightmap = lm;
+    mat->flags = flags;
+    mat->face = face_idx;
+    if (flags)
+        mat->pass = WPASS_BLEND;
+    else if (img && img->has_alpha)
+        mat->pass = WPASS_ALPHATEST;
+    else
+        mat->pass = WPASS_OPAQUE;
+    return r_worldmesh.nummaterials++;
+}
+
+static int R_CompareMaterials(const void *a, const void *b)
+{
+    const worldmaterial_t *ma = &r_worldmesh.materials[*(const int *)a];
+    const worldmaterial_t *mb = &r_worldmesh.materials[*(const int *)b];
+
+    if (ma->pass != mb->pass)
+        return ma->pass - mb->pass;
+    if (ma->image != mb->image)
+        return (uintptr_t)ma->image < (uintptr_t)mb->image ? -1 : 1;
+    if (ma->lightmap != mb->lightmap)
+        return ma->lightmap < mb->lightmap ? -1 : 1;
+    return *(const int *)a - *(const int *)b;
+}
+
+/* Renumber materials into draw order */
+static void R_SortMaterials(bsp_world_t *world)
+{
+    int             i, n = r_worldmesh.nummaterials;
+    int             *order, *remap;
+    worldmaterial_t *sorted;
+
+    if (!n)
         return;
 
-    if (face->texinfo >= 0 && face->texinfo < world->num_texinfo) {
-        ti = &world->texinfo[face->texinfo];
-        if (ti->flags & SURF_WARP)
-            is_warp = qtrue;
+    order = Z_Malloc(n * sizeof(int));
+    remap = Z_Malloc(n * sizeof(int));
+    sorted = Z_TagMalloc(n * sizeof(worldmaterial_t), Z_TAG_LEVEL);
+
+    for (i = 0; i < n; i++)
+        order[i] = i;
+    qsort(order, n, sizeof(int), R_CompareMaterials);
+
+    for (i = 0; i < n; i++) {
+        sorted[i] = r_worldmesh.materials[order[i]];
+        remap[order[i]] = i;
     }
+    for (i = 0; i < world->num_faces; i++)
+        r_worldmesh.faces[i].material = remap[r_worldmesh.faces[i].material];
 
-    if (is_warp)
-        warp_time = (float)Sys_Milliseconds() * 0.001f;
+    Z_Free(r_worldmesh.materials);
+    r_worldmesh.materials = sorted;
+    Z_Free(remap);
+    Z_Free(order);
+}
 
-    qglBegin(GL_TRIANGLE_FAN);
+/* Face corners in winding order, skipping broken edges */
+static int R_FaceVertexes(bsp_world_t *world, bsp_face_t *face, float **out)
+{
+    int i, count = 0;
 
     for (i = 0; i < face->numedges; i++) {
-        int se_idx = face->firstedge + i;
+        int         se_idx = face->firstedge + i;
+        int         edge_idx;
+        bsp_edge_t  *edge;
+
         if (se_idx < 0 || se_idx >= world->num_surfedges)
             continue;
         edge_idx = world->surfedges[se_idx];
@@ -260,58 +419,339 @@ static void R_DrawFace(bsp_world_t *world, bsp_face_t *face,
             if (edge_idx >= world->num_edges) continue;
             edge = &world->edges[edge_idx];
             if (edge->v[0] >= (unsigned short)world->num_vertexes) continue;
-            v = world->vertexes[edge->v[0]].point;
+            out[count++] = world->vertexes[edge->v[0]].point;
         } else {
             if (-edge_idx >= world->num_edges) continue;
             edge = &world->edges[-edge_idx];
             if (edge->v[1] >= (unsigned short)world->num_vertexes) continue;
-            v = world->vertexes[edge->v[1]].point;
+            out[count++] = world->vertexes[edge->v[1]].point;
         }
+    }
 
-        /* Compute texture coordinates from texinfo */
-        if (ti) {
-            float s = DotProduct(v, ti->vecs[0]) + ti->vecs[0][3];
-            float t = DotProduct(v, ti->vecs[1]) + ti->vecs[1][3];
-            /* Normalize by actual texture dimensions if loaded */
-            image_t *img = (face->texinfo < MAX_TEXINFO_CACHE) ?
-                            r_texinfo_images[face->texinfo] : NULL;
-            if (img && img->width > 0 && img->height > 0) {
-                s /= (float)img->width;
-                t /= (float)img->height;
-            } else {
-                s /= 64.0f;
-                t /= 64.0f;
-            }
+    return count;
+}
 
-            /* Water warp: scroll texture coordinates with sine wave */
-            if (is_warp) {
-                s += 0.05f * (float)sin(v[1] * 0.05f + warp_time * 2.0f);
-                t += 0.05f * (float)sin(v[0] * 0.05f + warp_time * 2.0f);
-            }
+static void R_FreeWorldMesh(void)
+{
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk)
+        R_VK_FreeWorldBuffer();
+    else
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4)
+        R_GL4_FreeWorldBuffer();
+    else
+#endif
+    if (r_worldmesh.vbo)
+        qglDeleteBuffersARB(1, &r_worldmesh.vbo);
+    if (r_worldmesh.verts)
+        Z_Free(r_worldmesh.verts);
+    if (r_worldmesh.indices)
+        Z_Free(r_worldmesh.indices);
+    if (r_worldmesh.faces)
+        Z_Free(r_worldmesh.faces);
+    if (r_worldmesh.materials)
+        Z_Free(r_worldmesh.materials);
+    memset(&r_worldmesh, 0, sizeof(r_worldmesh));
+
+    R_FreeWorldVis();
+}
 
-            qglTexCoord2f(s, t);
-
-            /* Lightmap TC on TMU1 */
-            if (use_lightmap && qglActiveTextureARB) {
-                float lm_s, lm_t;
-                GLuint lm_tex;
-                if (R_GetFaceLightmapTC(face_idx, v, ti,
-                                         &lm_s, &lm_t, &lm_tex)) {
-                    qglActiveTextureARB(GL_TEXTURE1_ARB);
-                    qglTexCoord2f(lm_s, lm_t);
-                    qglActiveTextureARB(GL_TEXTURE0_ARB);
-                }
+/*
+ * R_BuildWorldMesh - Bake all faces. Runs after the textures are found
+ * (diffuse UVs need their sizes) and the lightmap atlases are built.
+ */
+static void R_BuildWorldMesh(bsp_world_t *world)
+{
+    int     i, maxverts = 0, maxcorners = 0;
+    int     *hash, hashsize;
+    float   **corners;
+
+    R_FreeWorldMesh();
+
+    for (i = 0; i < world->num_faces; i++) {
+        maxverts += world->faces[i].numedges > 0 ? world->faces[i].numedges : 0;
+        if (world->faces[i].numedges > maxcorners)
+            maxcorners = world->faces[i].numedges;
+    }
+    if (maxverts < 3)
+        return;
+
+    r_worldmesh.verts = Z_TagMalloc(maxverts * sizeof(worldvert_t), Z_TAG_LEVEL);
+    r_worldmesh.indices = Z_TagMalloc((maxverts - 2) * 3 * sizeof(GLuint), Z_TAG_LEVEL);
+    r_worldmesh.faces = Z_TagMalloc(world->num_faces * sizeof(worldface_t), Z_TAG_LEVEL);
+    r_worldmesh.materials = Z_TagMalloc(world->num_faces * sizeof(worldmaterial_t), Z_TAG_LEVEL);
+    corners = Z_Malloc(maxcorners * sizeof(float *));
+
+    for (hashsize = 64; hashsize < world->num_faces * 2; hashsize <<= 1)
+        ;
+    hash = Z_Malloc(hashsize * sizeof(int));
+    memset(hash, 0xff, hashsize * sizeof(int));
+
+    for (i = 0; i < world->num_faces; i++) {
+        bsp_face_t      *face = &world->faces[i];
+        worldface_t     *wf = &r_worldmesh.faces[i];
+        bsp_texinfo_t   *ti = NULL;
+        image_t         *img;
+        float           tw = 64.0f, th = 64.0f;
+        int             j, n, first = r_worldmesh.numverts;
+
+        memset(wf, 0, sizeof(*wf));
+        wf->firstindex = r_worldmesh.numindices;
+
+        if (R_FaceFlags(world, face) & (SURF_SKY | SURF_NODRAW))
+            continue;
+        n = R_FaceVertexes(world, face, corners);
+        if (n < 3)
+            continue;
+
+        if (face->texinfo >= 0 && face->texinfo < world->num_texinfo)
+            ti = &world->texinfo[face->texinfo];
+        img = R_FaceImage(world, face);
+        if (img && img->width > 0 && img->height > 0) {
+            tw = (float)img->width;
+            th = (float)img->height;
+        }
+
+        for (j = 0; j < n; j++) {
+            worldvert_t *wv = &r_worldmesh.verts[r_worldmesh.numverts++];
+            float       *v = corners[j];
+            GLuint      lm_tex;
+
+            VectorCopy(v, wv->xyz);
+            VectorAdd(wf->center, v, wf->center);
+            wv->st[0] = wv->st[1] = wv->lm[0] = wv->lm[1] = 0;
+            if (ti) {
+                wv->st[0] = (DotProduct(v, ti->vecs[0]) + ti->vecs[0][3]) / tw;
+                wv->st[1] = (DotProduct(v, ti->vecs[1]) + ti->vecs[1][3]) / th;
+                R_GetFaceLightmapTC(i, v, ti, &wv->lm[0], &wv->lm[1], &lm_tex);
             }
         }
+        VectorScale(wf->center, 1.0f / n, wf->center);
 
-        /* Water warp: slight vertex displacement for wave effect */
-        if (is_warp) {
-            float wz = v[2] + 2.0f * (float)sin(v[0] * 0.03f + warp_time * 1.5f)
-                             + 2.0f * (float)sin(v[1] * 0.03f + warp_time * 1.2f);
-            qglVertex3f(v[0], v[1], wz);
-        } else {
-            qglVertex3f(v[0], v[1], v[2]);
+        /* Triangle fan → list */
+        for (j = 2; j < n; j++) {
+            r_worldmesh.indices[r_worldmesh.numindices++] = first;
+            r_worldmesh.indices[r_worldmesh.numindices++] = first + j - 1;
+            r_worldmesh.indices[r_worldmesh.numindices++] = first + j;
+        }
+        wf->numindices = r_worldmesh.numindices - wf->firstindex;
+        wf->material = R_FindMaterial(world, i, hash, hashsize);
+    }
+
+    Z_Free(hash);
+    Z_Free(corners);
+
+    R_SortMaterials(world);
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_CreateWorldBuffer(r_worldmesh.verts,
+                               r_worldmesh.numverts * (int)sizeof(worldvert_t),
+                               sizeof(worldvert_t), offsetof(worldvert_t, st),
+                               offsetof(worldvert_t, lm));
+        Z_Free(r_worldmesh.verts);
+        r_worldmesh.verts = NULL;
+    } else
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        r_worldmesh.vbo = R_GL4_CreateWorldBuffer(r_worldmesh.verts,
+                              r_worldmesh.numverts * (int)sizeof(worldvert_t),
+                              sizeof(worldvert_t), offsetof(worldvert_t, st),
+                              offsetof(worldvert_t, lm));
+        Z_Free(r_worldmesh.verts);
+        r_worldmesh.verts = NULL;
+    } else
+#endif
+    if (gl_state.have_vbo) {
+        qglGenBuffersARB(1, &r_worldmesh.vbo);
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, r_worldmesh.vbo);
+        qglBufferDataARB(GL_ARRAY_BUFFER_ARB,
+                         (ptrdiff_t)r_worldmesh.numverts * sizeof(worldvert_t),
+                         r_worldmesh.verts, GL_STATIC_DRAW_ARB);
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        Z_Free(r_worldmesh.verts);
+        r_worldmesh.verts = NULL;
+    }
+
+    Com_Printf("World mesh: %d verts, %d tris, %d materials%s\n",
+               r_worldmesh.numverts, r_worldmesh.numindices / 3,
+               r_worldmesh.nummaterials, r_worldmesh.vbo ? " (VBO)" : "");
+
+    R_BuildWorldVis(world);
+}
+
+/* ==========================================================================
+   Surface State
+   World passes bind through here so a material that uses the texture or
+   lightmap already bound costs nothing. Valid between R_BeginWorldMesh and
+   R_EndWorldMesh; anything else may have changed the bindings.
+   ========================================================================== */
+
+#define SURF_STATE_UNKNOWN  ((GLuint)-1)
+
+static struct {
+    GLuint  texture;        /* TMU0, 0 = texturing off */
+    GLuint  lightmap;       /* TMU1, 0 = off */
+} r_surfstate;
+
+int         c_state_changes;
+
+static void R_BindTexture0(GLuint tex)
+{
+    if (tex == r_surfstate.texture)
+        return;
+
+    if (!tex) {
+        qglDisable(GL_TEXTURE_2D);
+    } else {
+        if (!r_surfstate.texture || r_surfstate.texture == SURF_STATE_UNKNOWN)
+            qglEnable(GL_TEXTURE_2D);
+        qglBindTexture(GL_TEXTURE_2D, tex);
+    }
+    r_surfstate.texture = tex;
+    c_state_changes++;
+}
+
+static void R_BindLightmap(GLuint tex)
+{
+    if (!gl_state.have_multitexture || !qglActiveTextureARB)
+        return;
+    if (tex == r_surfstate.lightmap)
+        return;
+
+    qglActiveTextureARB(GL_TEXTURE1_ARB);
+    if (!tex) {
+        qglDisable(GL_TEXTURE_2D);
+    } else {
+        if (!r_surfstate.lightmap || r_surfstate.lightmap == SURF_STATE_UNKNOWN) {
+            qglEnable(GL_TEXTURE_2D);
+            qglTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
         }
+        qglBindTexture(GL_TEXTURE_2D, tex);
+    }
+    qglActiveTextureARB(GL_TEXTURE0_ARB);
+    r_surfstate.lightmap = tex;
+    c_state_changes++;
+}
+
+/* Point the vertex arrays at the world mesh; pair with R_EndWorldMesh */
+static void R_BeginWorldMesh(void)
+{
+    const byte *base = (const byte *)r_worldmesh.verts;    /* NULL in the VBO */
+
+    r_surfstate.texture = SURF_STATE_UNKNOWN;
+    r_surfstate.lightmap = SURF_STATE_UNKNOWN;
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_BeginWorld();
+        return;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        R_GL4_BeginWorld();
+        return;
+    }
+#endif
+
+    if (r_worldmesh.vbo)
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, r_worldmesh.vbo);
+
+    qglEnableClientState(GL_VERTEX_ARRAY);
+    qglVertexPointer(3, GL_FLOAT, sizeof(worldvert_t), base + offsetof(worldvert_t, xyz));
+    qglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    qglTexCoordPointer(2, GL_FLOAT, sizeof(worldvert_t), base + offsetof(worldvert_t, st));
+
+    if (qglClientActiveTextureARB) {
+        qglClientActiveTextureARB(GL_TEXTURE1_ARB);
+        qglEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        qglTexCoordPointer(2, GL_FLOAT, sizeof(worldvert_t), base + offsetof(worldvert_t, lm));
+        qglClientActiveTextureARB(GL_TEXTURE0_ARB);
+    }
+}
+
+static void R_EndWorldMesh(void)
+{
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        R_VK_EndWorld();
+        return;
+    }
+#endif
+
+    /* Leave TMU0 texturing on and TMU1 off, as the rest of the frame expects */
+    R_BindLightmap(0);
+    if (!r_surfstate.texture)
+        qglEnable(GL_TEXTURE_2D);
+    qglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        R_GL4_EndWorld();
+        return;
+    }
+#endif
+
+    if (qglClientActiveTextureARB) {
+        qglClientActiveTextureARB(GL_TEXTURE1_ARB);
+        qglDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        qglClientActiveTextureARB(GL_TEXTURE0_ARB);
+    }
+    qglDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    qglDisableClientState(GL_VERTEX_ARRAY);
+
+    /* Other vertex array users pass client pointers */
+    if (r_worldmesh.vbo)
+        qglBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+}
+
+/* ==========================================================================
+   Surface Rendering
+   ========================================================================== */
+
+/*
+ * Draw a water face. The UVs and heights wave every frame, so on the GL 1.x path these stay
+ * in immediate mode; they have no lightmap.
+ */
+static void R_DrawWarpFace(bsp_world_t *world, bsp_face_t *face)
+{
+    float       *corners[64];
+    float       warp_time = (float)Sys_Milliseconds() * 0.001f;
+    bsp_texinfo_t *ti = &world->texinfo[face->texinfo];
+    image_t     *img = R_FaceImage(world, face);
+    float       tw = 64.0f, th = 64.0f;
+    int         i, n;
+
+    if (face->numedges < 3 || face->numedges > 64)
+        return;
+    n = R_FaceVertexes(world, face, corners);
+
+    if (img && img->width > 0 && img->height > 0) {
+        tw = (float)img->width;
+        th = (float)img->height;
+    }
+
+    qglBegin(GL_TRIANGLE_FAN);
+
+    for (i = 0; i < n; i++) {
+        float *v = corners[i];
+        float s = (DotProduct(v, ti->vecs[0]) + ti->vecs[0][3]) / tw;
+        float t = (DotProduct(v, ti->vecs[1]) + ti->vecs[1][3]) / th;
+        float wz;
+
+        /* Scroll texture coordinates with sine wave */
+        s += 0.05f * (float)sin(v[1] * 0.05f + warp_time * 2.0f);
+        t += 0.05f * (float)sin(v[0] * 0.05f + warp_time * 2.0f);
+        qglTexCoord2f(s, t);
+
+        /* Slight vertex displacement for wave effect */
+        wz = v[2] + 2.0f * (float)sin(v[0] * 0.03f + warp_time * 1.5f)
+                  + 2.0f * (float)sin(v[1] * 0.03f + warp_time * 1.2f);
+        qglVertex3f(v[0], v[1], wz);
     }
 
     qglEnd();
@@ -319,37 +759,132 @@ static void R_DrawFace(bsp_world_t *world, bsp_face_t *face,
 }
 
 /*
- * Determine face color from texinfo (for untextured wireframe/flat rendering)
+ * Determine face color from texinfo (for untextured wireframe/flat rendering).
+ * qfalse for a surface with no color of its own (nodraw).
  */
-static void R_SetFaceColor(bsp_world_t *world, bsp_face_t *face)
+static qboolean R_FaceColor(bsp_world_t *world, bsp_face_t *face, float *color)
 {
+    float r = 0.5f, g = 0.5f, b = 0.5f, a = 1.0f;
+
     if (face->texinfo >= 0 && face->texinfo < world->num_texinfo) {
         bsp_texinfo_t *ti = &world->texinfo[face->texinfo];
 
         /* Color by surface type */
         if (ti->flags & SURF_SKY) {
-            qglColor4f(0.3f, 0.3f, 0.8f, 1.0f);   /* sky = blue */
+            r = 0.3f; g = 0.3f; b = 0.8f;               /* sky = blue */
         } else if (ti->flags & SURF_WARP) {
-            qglColor4f(0.2f, 0.5f, 0.8f, 1.0f);   /* water = cyan */
+            r = 0.2f; g = 0.5f; b = 0.8f;               /* water = cyan */
         } else if (ti->flags & SURF_TRANS33) {
-            qglColor4f(0.6f, 0.6f, 0.6f, 0.33f);  /* transparent */
+            r = g = b = 0.6f; a = 0.33f;                /* transparent */
         } else if (ti->flags & SURF_TRANS66) {
-            qglColor4f(0.6f, 0.6f, 0.6f, 0.66f);  /* semi-transparent */
+            r = g = b = 0.6f; a = 0.66f;                /* semi-transparent */
         } else if (ti->flags & SURF_NODRAW) {
-            return;  /* skip invisible surfaces */
+            return qfalse;  /* skip invisible surfaces */
         } else {
             /* Hash texture name for a consistent pseudorandom color */
             unsigned hash = 0;
             const char *n = ti->texture;
             while (*n) { hash = hash * 31 + (unsigned char)*n++; }
-            float r = 0.3f + (float)((hash >> 0) & 0xFF) / 512.0f;
-            float g = 0.3f + (float)((hash >> 8) & 0xFF) / 512.0f;
-            float b = 0.3f + (float)((hash >> 16) & 0xFF) / 512.0f;
-            qglColor4f(r, g, b, 1.0f);
+            r = 0.3f + (float)((hash >> 0) & 0xFF) / 512.0f;
+            g = 0.3f + (float)((hash >> 8) & 0xFF) / 512.0f;
+            b = 0.3f + (float)((hash >> 16) & 0xFF) / 512.0f;
         }
+    }
+
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+    color[3] = a;
+    return qtrue;
+}
+
+/* Bind a material's texture, lightmap and color */
+static void R_BindMaterial(bsp_world_t *world, const worldmaterial_t *mat)
+{
+    float       color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    GLuint      texnum = 0;
+    qboolean    colored = qtrue;
+
+    if (mat->image && mat->image->texnum) {
+        if (mat->flags & SURF_TRANS33)
+            color[3] = 0.33f;
+        else if (mat->flags & SURF_TRANS66)
+            color[3] = 0.66f;
+
+        texnum = mat->image->texnum;
+        R_TouchImage(mat->image);
     } else {
-        qglColor4f(0.5f, 0.5f, 0.5f, 1.0f);
+        colored = R_FaceColor(world, &world->faces[mat->face], color);
+    }
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        if (texnum != r_surfstate.texture || mat->lightmap != r_surfstate.lightmap)
+            c_state_changes++;
+        r_surfstate.texture = texnum;
+        r_surfstate.lightmap = mat->lightmap;
+        R_VK_SetMaterial(texnum, mat->lightmap, color, (mat->flags & SURF_WARP) != 0);
+        return;
+    }
+#endif
+
+    R_BindTexture0(texnum);
+    if (colored)
+        qglColor4f(color[0], color[1], color[2], color[3]);
+
+    R_BindLightmap(mat->lightmap);
+
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4)
+        R_GL4_SetMaterial(r_surfstate.texture != 0, r_surfstate.lightmap != 0,
+                          (mat->flags & SURF_WARP) != 0);
+#endif
+}
+
+/*
+ * Per-frame index lists. On the GL4 path they are written straight into
+ * the ring buffer and drawn from there, on the Vulkan path into the
+ * frame's stream; ringofs is -1 for client memory.
+ */
+static GLuint *R_AllocWorldIndices(int count, int *ringofs)
+{
+    GLuint *indices = NULL;
+
+    *ringofs = -1;
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk)
+        indices = R_VK_StreamAlloc(count * (int)sizeof(GLuint), ringofs);
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4)
+        indices = R_GL4_RingAlloc(count * (int)sizeof(GLuint), ringofs);
+#endif
+    if (!indices)
+        indices = (GLuint *)Z_FrameAlloc(count * sizeof(GLuint));
+    return indices;
+}
+
+static void R_DrawWorldIndices(const GLuint *indices, int ringofs, int first, int count)
+{
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        if (ringofs >= 0)
+            R_VK_DrawIndexed(ringofs + first * (int)sizeof(GLuint), count);
+        c_brush_polys++;
+        return;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        R_GL4_DrawIndexed(indices + first,
+                          ringofs < 0 ? -1 : ringofs + first * (int)sizeof(GLuint), count);
+        c_brush_polys++;
+        return;
     }
+#endif
+    (void)ringofs;
+    qglDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices + first);
+    c_brush_polys++;
 }
 
 /* ==========================================================================
@@ -357,218 +892,629 @@ static void R_SetFaceColor(bsp_world_t *world, bsp_face_t *face)
    ========================================================================== */
 
 /*
- * R_DrawSingleFace - Draw one face with texture and lightmap binding
+ * Faces are gathered into material runs in chunks, one per job thread:
+ * each chunk counts its triangles per material, the runs are laid out so
+ * that within a material the chunks follow each other in face order, and
+ * then every chunk copies its indices into its slots. Small lists are
+ * one chunk on the main thread.
  */
-void R_DrawSingleFace(bsp_world_t *world, int face_idx)
+#define WORLD_JOB_MINFACES  1024    /* below this a gather isn't worth a wakeup */
+#define WORLD_MAX_CHUNKS    8
+
+typedef struct {
+    const int   *faces;
+    int         numfaces;
+    int         chunksize;
+    int         nummat;
+    int         *counts;        /* [chunk * nummat + material] */
+    int         *offsets;       /* same layout: where the chunk's part goes */
+    GLuint      *indices;
+} worldgather_t;
+
+static void R_GatherCountJob(void *ctx, int chunk)
+{
+    worldgather_t   *g = (worldgather_t *)ctx;
+    int             *counts = g->counts + chunk * g->nummat;
+    int             i = chunk * g->chunksize;
+    int             end = i + g->chunksize < g->numfaces ? i + g->chunksize : g->numfaces;
+
+    memset(counts, 0, g->nummat * sizeof(int));
+    for (; i < end; i++) {
+        worldface_t *wf = &r_worldmesh.faces[g->faces[i]];
+        counts[wf->material] += wf->numindices;
+    }
+}
+
+static void R_GatherCopyJob(void *ctx, int chunk)
 {
-    bsp_face_t *face = &world->faces[face_idx];
-    image_t *img = NULL;
-    qboolean use_lm = qfalse;
-    GLuint lm_tex;
+    worldgather_t   *g = (worldgather_t *)ctx;
+    int             *offsets = g->offsets + chunk * g->nummat;
+    int             i = chunk * g->chunksize;
+    int             end = i + g->chunksize < g->numfaces ? i + g->chunksize : g->numfaces;
 
-    /* Skip faces with NODRAW/SKY flags */
-    if (face->texinfo >= 0 && face->texinfo < world->num_texinfo) {
-        if (world->texinfo[face->texinfo].flags & SURF_NODRAW)
-            return;
-        if (world->texinfo[face->texinfo].flags & SURF_SKY)
-            return;
+    for (; i < end; i++) {
+        worldface_t *wf = &r_worldmesh.faces[g->faces[i]];
 
-        /* Look up cached texture */
-        if (face->texinfo < MAX_TEXINFO_CACHE)
-            img = r_texinfo_images[face->texinfo];
+        memcpy(g->indices + offsets[wf->material], r_worldmesh.indices + wf->firstindex,
+               wf->numindices * sizeof(GLuint));
+        offsets[wf->material] += wf->numindices;
     }
+}
 
-    if (img && img->texnum) {
-        qglEnable(GL_TEXTURE_2D);
-        qglBindTexture(GL_TEXTURE_2D, img->texnum);
-        if (img->has_alpha) {
+/*
+ * R_DrawBatched - Draw faces a material at a time, one glDrawElements each.
+ * Order between materials doesn't matter, so this is for the depth-writing
+ * passes only.
+ */
+static void R_DrawBatched(bsp_world_t *world, const int *faces, int numfaces)
+{
+    worldgather_t   g;
+    int             i, c, numchunks = 1, total = 0, ringofs;
+    int             *first, *count;
+
+    if (!numfaces)
+        return;
+
+    if (numfaces >= WORLD_JOB_MINFACES) {
+        numchunks = Job_Threads();
+        if (numchunks > WORLD_MAX_CHUNKS)
+            numchunks = WORLD_MAX_CHUNKS;
+    }
+
+    g.faces = faces;
+    g.numfaces = numfaces;
+    g.chunksize = (numfaces + numchunks - 1) / numchunks;
+    g.nummat = r_worldmesh.nummaterials;
+    g.counts = (int *)Z_FrameAlloc(numchunks * g.nummat * sizeof(int));
+    g.offsets = (int *)Z_FrameAlloc(numchunks * g.nummat * sizeof(int));
+    first = (int *)Z_FrameAlloc(g.nummat * sizeof(int));
+    count = (int *)Z_FrameAlloc(g.nummat * sizeof(int));
+
+    Job_ParallelFor("R_GatherCount", R_GatherCountJob, &g, numchunks);
+
+    for (i = 0; i < g.nummat; i++) {
+        first[i] = total;
+        for (c = 0; c < numchunks; c++) {
+            g.offsets[c * g.nummat + i] = total;
+            total += g.counts[c * g.nummat + i];
+        }
+        count[i] = total - first[i];
+    }
+
+    /* Gather each material's triangles into one run */
+    g.indices = R_AllocWorldIndices(total, &ringofs);
+    Job_ParallelFor("R_GatherCopy", R_GatherCopyJob, &g, numchunks);
+
+    /* Materials are numbered in bind order */
+    for (i = 0; i < g.nummat; i++) {
+        if (!count[i])
+            continue;
+
+        R_BindMaterial(world, &r_worldmesh.materials[i]);
+        R_DrawWorldIndices(g.indices, ringofs, first[i], count[i]);
+    }
+}
+
+typedef struct {
+    float   dist;
+    int     face;
+} sortface_t;
+
+static int R_CompareFarthest(const void *a, const void *b)
+{
+    float da = ((const sortface_t *)a)->dist, db = ((const sortface_t *)b)->dist;
+    return da < db ? 1 : (da > db ? -1 : 0);
+}
+
+/*
+ * R_DrawSorted - Draw blended faces back to front. Neighbours in the
+ * sorted order that share a material still go out as one draw.
+ */
+static void R_DrawSorted(bsp_world_t *world, const int *faces, int numfaces,
+                         const vec3_t vieworg)
+{
+    sortface_t  *sorted;
+    GLuint      *indices;
+    int         i, j, used = 0, ringofs;
+
+    if (!numfaces)
+        return;
+
+    sorted = (sortface_t *)Z_FrameAlloc(numfaces * sizeof(sortface_t));
+    for (i = 0; i < numfaces; i++) {
+        vec3_t d;
+
+        VectorSubtract(r_worldmesh.faces[faces[i]].center, vieworg, d);
+        sorted[i].dist = DotProduct(d, d);
+        sorted[i].face = faces[i];
+    }
+    qsort(sorted, numfaces, sizeof(sortface_t), R_CompareFarthest);
+
+    for (i = 0, j = 0; i < numfaces; i++)
+        j += r_worldmesh.faces[faces[i]].numindices;
+    indices = R_AllocWorldIndices(j, &ringofs);
+
+    for (i = 0; i < numfaces; i = j) {
+        int             mat_idx = r_worldmesh.faces[sorted[i].face].material;
+        worldmaterial_t *mat = &r_worldmesh.materials[mat_idx];
+        int             count = 0;
+
+        R_BindMaterial(world, mat);
+
+        if ((mat->flags & SURF_WARP) && !gl_state.gl4 && !gl_state.vk) {
+            R_DrawWarpFace(world, &world->faces[sorted[i].face]);
+            j = i + 1;
+            continue;
+        }
+
+        for (j = i; j < numfaces; j++) {
+            worldface_t *wf = &r_worldmesh.faces[sorted[j].face];
+
+            if (wf->material != mat_idx)
+                break;
+            memcpy(indices + used + count, r_worldmesh.indices + wf->firstindex,
+                   wf->numindices * sizeof(GLuint));
+            count += wf->numindices;
+        }
+
+        /* Each run gets its own range: the GPU may still be reading the last */
+        R_DrawWorldIndices(indices, ringofs, used, count);
+        used += count;
+    }
+}
+
+/*
+ * R_DrawFaces - Draw a set of faces through all three passes.
+ * vieworg is the camera in the faces' own space, for the blend sort.
+ */
+static void R_DrawFaces(bsp_world_t *world, const int *faces, int numfaces,
+                        const vec3_t vieworg)
+{
+    int *lists[WPASS_NUM];
+    int counts[WPASS_NUM];
+    int i;
+
+    for (i = 0; i < WPASS_NUM; i++) {
+        lists[i] = (int *)Z_FrameAlloc(numfaces * sizeof(int));
+        counts[i] = 0;
+    }
+
+    for (i = 0; i < numfaces; i++) {
+        worldface_t *wf = &r_worldmesh.faces[faces[i]];
+        int         pass;
+
+        if (!wf->numindices)
+            continue;
+        pass = r_worldmesh.materials[wf->material].pass;
+        lists[pass][counts[pass]++] = faces[i];
+    }
+
+    R_BeginWorldMesh();
+
+    /* Pass 1: Opaque faces */
+    R_DrawBatched(world, lists[WPASS_OPAQUE], counts[WPASS_OPAQUE]);
+
+    /* Pass 2: Cutout textures — depth-tested and written like opaque */
+    if (counts[WPASS_ALPHATEST]) {
+#ifdef SOF_RENDERER_VULKAN
+        if (gl_state.vk) {
+            R_VK_SetAlphaRef(0.5f);
+            R_DrawBatched(world, lists[WPASS_ALPHATEST], counts[WPASS_ALPHATEST]);
+            R_VK_SetAlphaRef(-1.0f);
+        } else
+#endif
+#ifdef SOF_RENDERER_GL4
+        if (gl_state.gl4) {
+            R_GL4_SetAlphaRef(0.5f);
+            R_DrawBatched(world, lists[WPASS_ALPHATEST], counts[WPASS_ALPHATEST]);
+            R_GL4_SetAlphaRef(-1.0f);
+        } else
+#endif
+        {
+            qglEnable(GL_ALPHA_TEST);
+            qglAlphaFunc(GL_GREATER, 0.5f);
+            R_DrawBatched(world, lists[WPASS_ALPHATEST], counts[WPASS_ALPHATEST]);
+            qglDisable(GL_ALPHA_TEST);
+        }
+    }
+
+    /* Pass 3: Translucent surfaces, after all depth-writing geometry */
+    if (counts[WPASS_BLEND]) {
+#ifdef SOF_RENDERER_VULKAN
+        if (gl_state.vk) {
+            R_VK_SetBlend(qtrue);
+            R_DrawSorted(world, lists[WPASS_BLEND], counts[WPASS_BLEND], vieworg);
+            R_VK_SetBlend(qfalse);
+        } else
+#endif
+        {
             qglEnable(GL_BLEND);
             qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            qglDepthMask(GL_FALSE);
+            R_DrawSorted(world, lists[WPASS_BLEND], counts[WPASS_BLEND], vieworg);
+            qglDepthMask(GL_TRUE);
+            qglDisable(GL_BLEND);
         }
-        qglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-    } else {
-        qglDisable(GL_TEXTURE_2D);
-        qglBindTexture(GL_TEXTURE_2D, R_GetNoTexture());
-        R_SetFaceColor(world, face);
     }
 
-    /* Set up lightmap on TMU1 if available */
-    lm_tex = R_GetFaceLightmapTexture(face_idx);
-    if (lm_tex && gl_state.have_multitexture && qglActiveTextureARB) {
-        qglActiveTextureARB(GL_TEXTURE1_ARB);
-        qglEnable(GL_TEXTURE_2D);
-        qglBindTexture(GL_TEXTURE_2D, lm_tex);
-        qglTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-        qglActiveTextureARB(GL_TEXTURE0_ARB);
-        use_lm = qtrue;
+    R_EndWorldMesh();
+
+    c_visible_faces += counts[WPASS_OPAQUE] + counts[WPASS_ALPHATEST] + counts[WPASS_BLEND];
+}
+
+/* ==========================================================================
+   World Visibility
+   The PVS part is cached: leaves and their parent nodes are marked with a
+   visframe, and that marking is redone only when the camera moves into
+   another cluster (or r_novis flips). Each frame then walks just the
+   marked nodes, dropping any whose bounds are outside the view frustum,
+   and collects the faces of the leaves it reaches.
+   ========================================================================== */
+
+static struct {
+    int         *node_parent;   /* -1 for the root */
+    int         *leaf_parent;
+    int         *node_visframe;
+    int         *leaf_visframe;
+    int         *face_frame;    /* last framecount the face was collected */
+    int         *node_faces;    /* leaf face references under each node */
+    int         visframe;       /* bumped when the marks are rebuilt */
+    int         framecount;
+    int         viewcluster;
+    qboolean    novis;
+} r_worldvis;
+
+static bsp_plane_t r_frustum[4];
+
+static void R_FreeWorldVis(void)
+{
+    if (r_worldvis.node_parent)
+        Z_Free(r_worldvis.node_parent);
+    if (r_worldvis.leaf_parent)
+        Z_Free(r_worldvis.leaf_parent);
+    if (r_worldvis.node_visframe)
+        Z_Free(r_worldvis.node_visframe);
+    if (r_worldvis.leaf_visframe)
+        Z_Free(r_worldvis.leaf_visframe);
+    if (r_worldvis.face_frame)
+        Z_Free(r_worldvis.face_frame);
+    if (r_worldvis.node_faces)
+        Z_Free(r_worldvis.node_faces);
+    memset(&r_worldvis, 0, sizeof(r_worldvis));
+}
+
+static void R_BuildWorldVis(bsp_world_t *world)
+{
+    int i, j;
+
+    R_FreeWorldVis();
+
+    if (!world->nodes || world->num_nodes <= 0 || !world->leafs ||
+        world->num_leafs <= 0 || !world->leaffaces)
+        return;
+
+    r_worldvis.node_parent = Z_TagMalloc(world->num_nodes * sizeof(int), Z_TAG_LEVEL);
+    r_worldvis.node_visframe = Z_TagMalloc(world->num_nodes * sizeof(int), Z_TAG_LEVEL);
+    r_worldvis.leaf_parent = Z_TagMalloc(world->num_leafs * sizeof(int), Z_TAG_LEVEL);
+    r_worldvis.leaf_visframe = Z_TagMalloc(world->num_leafs * sizeof(int), Z_TAG_LEVEL);
+    r_worldvis.face_frame = Z_TagMalloc(world->num_faces * sizeof(int), Z_TAG_LEVEL);
+    r_worldvis.node_faces = Z_TagMalloc(world->num_nodes * sizeof(int), Z_TAG_LEVEL);
+    memset(r_worldvis.node_parent, 0xff, world->num_nodes * sizeof(int));
+    memset(r_worldvis.node_visframe, 0, world->num_nodes * sizeof(int));
+    memset(r_worldvis.leaf_parent, 0xff, world->num_leafs * sizeof(int));
+    memset(r_worldvis.leaf_visframe, 0, world->num_leafs * sizeof(int));
+    memset(r_worldvis.face_frame, 0, world->num_faces * sizeof(int));
+    memset(r_worldvis.node_faces, 0, world->num_nodes * sizeof(int));
+
+    for (i = 0; i < world->num_nodes; i++) {
+        for (j = 0; j < 2; j++) {
+            int child = world->nodes[i].children[j];
+
+            if (child >= 0 && child < world->num_nodes)
+                r_worldvis.node_parent[child] = i;
+            else if (child < 0 && -(child + 1) < world->num_leafs)
+                r_worldvis.leaf_parent[-(child + 1)] = i;
+        }
     }
 
-    R_DrawFace(world, face, face_idx, use_lm);
+    /* Sizes each worker's collection list in R_DrawWorld */
+    for (i = 0; i < world->num_leafs; i++) {
+        int node;
 
-    if (use_lm) {
-        qglActiveTextureARB(GL_TEXTURE1_ARB);
-        qglDisable(GL_TEXTURE_2D);
-        qglActiveTextureARB(GL_TEXTURE0_ARB);
+        for (node = r_worldvis.leaf_parent[i]; node >= 0; node = r_worldvis.node_parent[node])
+            r_worldvis.node_faces[node] += world->leafs[i].numleaffaces;
     }
 
-    if (img && img->has_alpha)
-        qglDisable(GL_BLEND);
+    r_worldvis.viewcluster = -2;    /* force the first R_MarkLeaves */
+}
+
+/*
+ * R_MarkLeaves - Mark the leaves visible from the camera cluster, and every
+ * node above them. Free unless the cluster changed.
+ */
+static void R_MarkLeaves(bsp_world_t *world)
+{
+    int         i, cluster = -1;
+    int         cam_leaf = BSP_PointLeaf(world, r_camera_origin);
+    qboolean    novis = !world->vis || (r_novis && r_novis->value);
 
-    c_visible_faces++;
+    if (cam_leaf >= 0 && cam_leaf < world->num_leafs)
+        cluster = world->leafs[cam_leaf].cluster;
+
+    if (cluster == r_worldvis.viewcluster && novis == r_worldvis.novis)
+        return;
+
+    r_worldvis.visframe++;
+    r_worldvis.viewcluster = cluster;
+    r_worldvis.novis = novis;
+
+    for (i = 0; i < world->num_leafs; i++) {
+        int leafcluster = world->leafs[i].cluster;
+        int node;
+
+        /* Outside the map or in solid, everything stays visible */
+        if (!novis && cluster >= 0 && leafcluster >= 0 &&
+            !BSP_ClusterVisible(world, cluster, leafcluster))
+            continue;
+
+        r_worldvis.leaf_visframe[i] = r_worldvis.visframe;
+        for (node = r_worldvis.leaf_parent[i];
+             node >= 0 && r_worldvis.node_visframe[node] != r_worldvis.visframe;
+             node = r_worldvis.node_parent[node])
+            r_worldvis.node_visframe[node] = r_worldvis.visframe;
+    }
 }
 
 /*
- * R_DrawWorld - Render BSP world with PVS culling
- *
- * Uses the Potentially Visible Set to only render faces in leafs
- * visible from the camera's current leaf/cluster. Falls back to
- * rendering all faces if PVS data is unavailable.
+ * R_SetupFrustum - Side planes of the current view, pulled out of the GL
+ * projection * modelview matrix so they match whatever set up the camera
  */
+static void R_SetupFrustum(void)
+{
+    float   proj[16], mv[16], clip[16];
+    int     i, j;
+
+#ifdef SOF_RENDERER_VULKAN
+    /* Its y is flipped, which only swaps the bottom and top planes */
+    if (gl_state.vk) {
+        R_VK_ViewMatrix(clip);
+    } else
+#endif
+    {
+        qglGetFloatv(GL_PROJECTION_MATRIX, proj);
+        qglGetFloatv(GL_MODELVIEW_MATRIX, mv);
+
+        /* Column-major: clip[col * 4 + row] */
+        for (i = 0; i < 4; i++)
+            for (j = 0; j < 4; j++)
+                clip[i * 4 + j] = proj[0 * 4 + j] * mv[i * 4 + 0] +
+                                  proj[1 * 4 + j] * mv[i * 4 + 1] +
+                                  proj[2 * 4 + j] * mv[i * 4 + 2] +
+                                  proj[3 * 4 + j] * mv[i * 4 + 3];
+    }
+
+    /* Left, right, bottom, top: row 3 plus or minus row 0 / row 1 */
+    for (i = 0; i < 4; i++) {
+        int     row = i >> 1;
+        float   sign = (i & 1) ? -1.0f : 1.0f;
+        float   len;
+
+        for (j = 0; j < 3; j++)
+            r_frustum[i].normal[j] = clip[j * 4 + 3] + sign * clip[j * 4 + row];
+        r_frustum[i].dist = -(clip[12 + 3] + sign * clip[12 + row]);
+
+        len = VectorLength(r_frustum[i].normal);
+        if (len > 0) {
+            VectorScale(r_frustum[i].normal, 1.0f / len, r_frustum[i].normal);
+            r_frustum[i].dist /= len;
+        }
+    }
+}
+
 /*
- * R_IsAlphaFace - Check if a face has transparency flags
+ * R_CullWorldNode - qtrue if a node is unmarked or outside the frustum.
+ * clipflags has a bit for each frustum plane the node still straddles;
+ * planes the node is wholly inside are cleared for its children.
  */
-static qboolean R_IsAlphaFace(bsp_world_t *world, int face_idx)
+static qboolean R_CullWorldNode(bsp_world_t *world, int num, int *clipflags)
 {
-    bsp_face_t *face = &world->faces[face_idx];
+    bsp_node_t  *node;
+    int         i;
 
-    if (face->texinfo >= 0 && face->texinfo < world->num_texinfo) {
-        int flags = world->texinfo[face->texinfo].flags;
-        if (flags & (SURF_TRANS33 | SURF_TRANS66 | SURF_WARP))
-            return qtrue;
-
-        /* Also check if the texture itself has alpha */
-        if (face->texinfo < MAX_TEXINFO_CACHE && r_texinfo_images[face->texinfo]) {
-            if (r_texinfo_images[face->texinfo]->has_alpha)
-                return qtrue;
+    if (num >= world->num_nodes || r_worldvis.node_visframe[num] != r_worldvis.visframe)
+        return qtrue;
+    node = &world->nodes[num];
+
+    for (i = 0; i < 4 && *clipflags; i++) {
+        bsp_plane_t *p = &r_frustum[i];
+        vec3_t      far_pt, near_pt;
+        int         k;
+
+        if (!(*clipflags & (1 << i)))
+            continue;
+
+        for (k = 0; k < 3; k++) {
+            if (p->normal[k] >= 0) {
+                far_pt[k] = node->maxs[k];
+                near_pt[k] = node->mins[k];
+            } else {
+                far_pt[k] = node->mins[k];
+                near_pt[k] = node->maxs[k];
+            }
         }
+
+        if (DotProduct(far_pt, p->normal) < p->dist)
+            return qtrue;                       /* wholly outside */
+        if (DotProduct(near_pt, p->normal) >= p->dist)
+            *clipflags &= ~(1 << i);            /* wholly inside */
     }
+
     return qfalse;
 }
 
 /*
- * R_DrawSingleFaceAlpha - Draw a face with proper alpha blending
+ * R_RecursiveWorldNode - Collect the leaf faces under a marked node. Faces
+ * shared between leafs come out more than once; R_DrawWorld drops the
+ * repeats when it merges the lists. Safe to run as a job.
  */
-static void R_DrawSingleFaceAlpha(bsp_world_t *world, int face_idx)
+static void R_RecursiveWorldNode(bsp_world_t *world, int num, int clipflags,
+                                 int *visible, int *num_visible)
 {
-    bsp_face_t *face = &world->faces[face_idx];
-    int flags = 0;
-    float alpha = 1.0f;
+    while (num >= 0) {
+        if (R_CullWorldNode(world, num, &clipflags))
+            return;
 
-    if (face->texinfo >= 0 && face->texinfo < world->num_texinfo)
-        flags = world->texinfo[face->texinfo].flags;
+        R_RecursiveWorldNode(world, world->nodes[num].children[0], clipflags,
+                             visible, num_visible);
+        num = world->nodes[num].children[1];
+    }
 
-    /* Determine alpha level from surface flags */
-    if (flags & SURF_TRANS33)
-        alpha = 0.33f;
-    else if (flags & SURF_TRANS66)
-        alpha = 0.66f;
+    /* Leaf */
+    {
+        int         leafnum = -(num + 1);
+        bsp_leaf_t  *leaf;
+        int         j;
 
-    qglEnable(GL_BLEND);
-    qglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    qglDepthMask(GL_FALSE);
-    qglColor4f(1.0f, 1.0f, 1.0f, alpha);
+        if (leafnum >= world->num_leafs ||
+            r_worldvis.leaf_visframe[leafnum] != r_worldvis.visframe)
+            return;
+        leaf = &world->leafs[leafnum];
 
-    R_DrawSingleFace(world, face_idx);
+        for (j = 0; j < leaf->numleaffaces; j++) {
+            int lf_idx = leaf->firstleafface + j;
+            int face_idx;
 
-    qglDepthMask(GL_TRUE);
-    qglDisable(GL_BLEND);
-    qglColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+            if (lf_idx >= world->num_leaffaces)
+                break;
+
+            face_idx = world->leaffaces[lf_idx];
+            if (face_idx < 0 || face_idx >= world->num_faces)
+                continue;
+
+            visible[(*num_visible)++] = face_idx;
+        }
+    }
 }
 
-#define MAX_ALPHA_FACES     2048
+/*
+ * The walk is split into subtrees a few levels below the root, each
+ * collected by a job into its own list.
+ */
+#define WORLD_SPLIT_DEPTH   4       /* up to 16 subtrees */
 
+typedef struct {
+    int     node;
+    int     clipflags;
+    int     *visible;
+    int     numvisible;
+} worldwalk_t;
+
+static void R_SplitWorldNode(bsp_world_t *world, int num, int clipflags, int depth,
+                             worldwalk_t *walks, int *numwalks)
+{
+    worldwalk_t *w;
+    int         capacity;
+
+    if (num >= 0 && depth > 0) {
+        if (R_CullWorldNode(world, num, &clipflags))
+            return;
+        R_SplitWorldNode(world, world->nodes[num].children[0], clipflags, depth - 1,
+                         walks, numwalks);
+        R_SplitWorldNode(world, world->nodes[num].children[1], clipflags, depth - 1,
+                         walks, numwalks);
+        return;
+    }
+
+    if (num >= 0)
+        capacity = num < world->num_nodes ? r_worldvis.node_faces[num] : 0;
+    else
+        capacity = -(num + 1) < world->num_leafs ? world->leafs[-(num + 1)].numleaffaces : 0;
+    if (capacity <= 0)
+        return;
+
+    w = &walks[(*numwalks)++];
+    w->node = num;
+    w->clipflags = clipflags;
+    w->visible = (int *)Z_FrameAlloc(capacity * sizeof(int));
+    w->numvisible = 0;
+}
+
+static void R_WorldWalkJob(void *ctx, int index)
+{
+    worldwalk_t *w = (worldwalk_t *)ctx + index;
+
+    R_RecursiveWorldNode(&r_worldmodel, w->node, w->clipflags, w->visible, &w->numvisible);
+}
+
+/*
+ * R_DrawWorld - Render BSP world with PVS and frustum culling
+ *
+ * Only faces in leafs visible from the camera's cluster, under nodes that
+ * intersect the view frustum, are drawn. Falls back to rendering all
+ * faces if the map has no BSP tree.
+ */
 void R_DrawWorld(void)
 {
     int i;
     bsp_world_t *world = &r_worldmodel;
-    int alpha_faces[MAX_ALPHA_FACES];
-    int num_alpha_faces = 0;
-
-    if (!r_worldloaded)
-        return;
+    int *visible;       /* frame scratch, room for every face */
+    int num_visible = 0;
 
     c_brush_polys = 0;
     c_visible_faces = 0;
+    c_state_changes = 0;
 
-    /* Set up for world rendering */
-    qglEnable(GL_DEPTH_TEST);
-    qglDepthFunc(GL_LEQUAL);
-    qglDepthMask(GL_TRUE);
-    qglDisable(GL_CULL_FACE);   /* Q2 BSP doesn't use GL culling */
-    qglEnable(GL_TEXTURE_2D);
-
-    /* PVS culling: find camera leaf/cluster */
-    if (world->vis && world->leafs && world->leaffaces &&
-        world->num_leafs > 0 && !(r_novis && r_novis->value)) {
-        int cam_leaf = BSP_PointLeaf(world, r_camera_origin);
-        int cam_cluster = -1;
-        byte *face_drawn;  /* prevent drawing same face twice */
-
-        if (cam_leaf >= 0 && cam_leaf < world->num_leafs)
-            cam_cluster = world->leafs[cam_leaf].cluster;
-
-        /* Bitfield to track already-drawn faces */
-        face_drawn = (byte *)Z_Malloc((world->num_faces + 7) / 8);
-        memset(face_drawn, 0, (world->num_faces + 7) / 8);
-
-        /* Pass 1: Opaque faces */
-        for (i = 0; i < world->num_leafs; i++) {
-            bsp_leaf_t *leaf = &world->leafs[i];
-            int j;
-
-            /* Skip if not visible from camera cluster */
-            if (cam_cluster >= 0 && leaf->cluster >= 0) {
-                if (!BSP_ClusterVisible(world, cam_cluster, leaf->cluster))
-                    continue;
-            }
+    if (!r_worldloaded || world->num_faces <= 0 || !r_worldmesh.faces)
+        return;
 
-            /* Render opaque faces, collect alpha faces */
-            for (j = 0; j < leaf->numleaffaces; j++) {
-                int lf_idx = leaf->firstleafface + j;
-                int face_idx;
+    Prof_Begin("R_DrawWorld");
 
-                if (lf_idx >= world->num_leaffaces)
-                    break;
+    visible = (int *)Z_FrameAlloc(world->num_faces * sizeof(int));
 
-                face_idx = world->leaffaces[lf_idx];
-                if (face_idx < 0 || face_idx >= world->num_faces)
-                    continue;
+    /* Set up for world rendering (the Vulkan pipelines have it baked in) */
+    if (!gl_state.vk) {
+        qglEnable(GL_DEPTH_TEST);
+        qglDepthFunc(GL_LEQUAL);
+        qglDepthMask(GL_TRUE);
+        qglDisable(GL_CULL_FACE);   /* Q2 BSP doesn't use GL culling */
+        qglEnable(GL_TEXTURE_2D);
+    }
 
-                /* Skip already-drawn faces (shared between leafs) */
-                if (face_drawn[face_idx >> 3] & (1 << (face_idx & 7)))
-                    continue;
-                face_drawn[face_idx >> 3] |= (1 << (face_idx & 7));
+    if (r_worldvis.node_parent) {
+        worldwalk_t walks[1 << WORLD_SPLIT_DEPTH];
+        int         numwalks = 0, w, j;
 
-                if (R_IsAlphaFace(world, face_idx)) {
-                    if (num_alpha_faces < MAX_ALPHA_FACES)
-                        alpha_faces[num_alpha_faces++] = face_idx;
-                } else {
-                    R_DrawSingleFace(world, face_idx);
-                }
-            }
-        }
+        R_MarkLeaves(world);
+        R_SetupFrustum();
+        r_worldvis.framecount++;
 
-        Z_Free(face_drawn);
-    } else {
-        /* No PVS — draw all faces (fallback) */
-        for (i = 0; i < world->num_faces; i++) {
-            if (R_IsAlphaFace(world, i)) {
-                if (num_alpha_faces < MAX_ALPHA_FACES)
-                    alpha_faces[num_alpha_faces++] = i;
-            } else {
-                R_DrawSingleFace(world, i);
+        R_SplitWorldNode(world, 0, (r_nocull && r_nocull->value) ? 0 : 15,
+                         Job_Threads() > 1 ? WORLD_SPLIT_DEPTH : 0, walks, &numwalks);
+        Job_ParallelFor("R_WorldWalk", R_WorldWalkJob, walks, numwalks);
+
+        /* Merge in walk order, keeping the first copy of each face */
+        for (w = 0; w < numwalks; w++) {
+            for (j = 0; j < walks[w].numvisible; j++) {
+                int face_idx = walks[w].visible[j];
+
+                if (r_worldvis.face_frame[face_idx] == r_worldvis.framecount)
+                    continue;
+                r_worldvis.face_frame[face_idx] = r_worldvis.framecount;
+                visible[num_visible++] = face_idx;
             }
         }
+    } else {
+        /* No BSP tree — draw all faces (fallback) */
+        for (i = 0; i < world->num_faces; i++)
+            visible[num_visible++] = i;
     }
 
-    /* Pass 2: Alpha surfaces (rendered after all opaque geometry) */
-    if (num_alpha_faces > 0) {
-        for (i = 0; i < num_alpha_faces; i++)
-            R_DrawSingleFaceAlpha(world, alpha_faces[i]);
-    }
+    R_DrawFaces(world, visible, num_visible, r_camera_origin);
 
-    qglDisable(GL_CULL_FACE);
+    if (!gl_state.vk)
+        qglDisable(GL_CULL_FACE);
 
+    Prof_End();
 }
 
 /*
@@ -650,12 +1596,18 @@ void R_DrawBrushModel(int modelindex, vec3_t origin, vec3_t angles)
 {
     bsp_world_t *world = &r_worldmodel;
     bsp_model_t *mod;
+    int *faces;
+    int numfaces = 0;
+    vec3_t vieworg;
     int i;
 
-    if (!r_worldloaded || modelindex <= 0 || modelindex >= world->num_models)
+    if (!r_worldloaded || !r_worldmesh.faces ||
+        modelindex <= 0 || modelindex >= world->num_models)
         return;
 
     mod = &world->models[modelindex];
+    if (mod->numfaces <= 0)
+        return;
 
     qglPushMatrix();
     qglTranslatef(origin[0], origin[1], origin[2]);
@@ -666,12 +1618,16 @@ void R_DrawBrushModel(int modelindex, vec3_t origin, vec3_t angles)
         qglRotatef(angles[2], 1, 0, 0);  /* roll */
     }
 
-    /* Render all faces belonging to this submodel */
+    /* Render all faces belonging to this submodel. The blend sort ignores
+     * the rotation; it only orders this model's own faces. */
+    faces = (int *)Z_FrameAlloc(mod->numfaces * sizeof(int));
     for (i = 0; i < mod->numfaces; i++) {
         int face_idx = mod->firstface + i;
         if (face_idx >= 0 && face_idx < world->num_faces)
-            R_DrawSingleFace(world, face_idx);
+            faces[numfaces++] = face_idx;
     }
+    VectorSubtract(r_camera_origin, origin, vieworg);
+    R_DrawFaces(world, faces, numfaces, vieworg);
 
     qglPopMatrix();
 }
@@ -700,12 +1656,14 @@ static void Cmd_Map_f(void)
         SCR_DrawLoadingScreen(mapname);
     }
 
+    Prof_MapLoadStart(mapname);
     R_LoadWorldMap(mapname);
 
     /* Spawn entities from BSP */
     if (r_worldloaded && r_worldmodel.entity_string) {
         SV_SpawnMapEntities(mapname, r_worldmodel.entity_string);
     }
+    Prof_MapLoadFinish();
 
     /* Fade in from black after level load */
     {
@@ -0,0 +1,490 @@
+/*
+ * r_texcache.c - Block-compressed wall textures and their disk cache
+ *
+ * With r_texcompress 1 (and S3TC support) wall textures are converted to
+ * BC1, or BC3 when they have alpha, on the background loader threads, and
+ * uploaded as compressed mip chains: a quarter to an eighth of the video
+ * memory, and no CPU mip building on the main thread.
+ *
+ * Encoding is the slow part, so each converted chain is written to
+ * <gamedir>/texcache/<hash>.tc next to the FS_FileStamp of its source.
+ * The next launch reads the chain back and uploads it as is; the stamp
+ * changes whenever the source file or the copy that wins the search path
+ * does, and then the texture is converted again. r_texcache 0 converts
+ * every launch without touching the disk.
+ *
+ * Everything except R_InitTexCache and the uploads runs on loader
+ * threads: no GL, cvars or console output there.
+ */
+
+#include "r_local.h"
+
+#include <stdio.h>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT     0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#endif
+
+#define TEXCACHE_MAGIC      (('C'<<24)+('T'<<16)+('o'<<8)+'S')     /* "SoTC" */
+#define TEXCACHE_VERSION    1
+#define TEXCACHE_STAMP      256
+
+typedef struct {
+    int     magic;
+    int     version;
+    char    stamp[TEXCACHE_STAMP];  /* FS_FileStamp of the source */
+    int     width, height;
+    int     format;                 /* texformat_t */
+    int     has_alpha;
+    int     datasize;               /* bytes of mip chain that follow */
+} texcache_header_t;
+
+static struct {
+    qboolean    compress;           /* r_texcompress, latched at init */
+    qboolean    use_disk;           /* r_texcache */
+    char        dir[MAX_OSPATH];
+} r_texcache;
+
+static cvar_t   *r_texcompress;
+static cvar_t   *r_texcache_cvar;
+
+/* ==========================================================================
+   Formats
+   ========================================================================== */
+
+/* What a wall texture should be converted to; TF_RGBA means not at all */
+texformat_t R_TexTargetFormat(qboolean has_alpha)
+{
+    if (!r_texcache.compress)
+        return TF_RGBA;
+    return has_alpha ? TF_BC3 : TF_BC1;
+}
+
+int R_TexLevelSize(texformat_t format, int width, int height)
+{
+    int bw = (width + 3) / 4, bh = (height + 3) / 4;
+
+    switch (format) {
+    case TF_BC1:    return bw * bh * 8;
+    case TF_BC3:    return bw * bh * 16;
+    default:        return width * height * 4;
+    }
+}
+
+int R_TexChainSize(texformat_t format, int width, int height)
+{
+    int size = 0;
+
+    for (;;) {
+        size += R_TexLevelSize(format, width, height);
+        if (width == 1 && height == 1)
+            return size;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+/* ==========================================================================
+   Block Compression
+   A straightforward range fit: each 4x4 block's endpoints are the corners
+   of its colour bounding box, pulled in a little, and every pixel takes the
+   nearest of the four palette entries. Not as good as a full cluster fit,
+   but fast enough to run on every texture of a level load.
+   ========================================================================== */
+
+static unsigned short R_Pack565(const int *c)
+{
+    return (unsigned short)(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+}
+
+static void R_Unpack565(unsigned short v, int *c)
+{
+    c[0] = ((v >> 11) & 31) * 255 / 31;
+    c[1] = ((v >> 5) & 63) * 255 / 63;
+    c[2] = (v & 31) * 255 / 31;
+}
+
+/* 8-byte BC1 colour block; always the four-colour mode */
+static void R_EncodeColorBlock(const byte *block, byte *out)
+{
+    int             mins[3] = { 255, 255, 255 }, maxs[3] = { 0, 0, 0 };
+    int             pal[4][3], i, k;
+    unsigned short  c0, c1;
+    unsigned        indices = 0;
+
+    for (i = 0; i < 16; i++) {
+        for (k = 0; k < 3; k++) {
+            if (block[i * 4 + k] < mins[k]) mins[k] = block[i * 4 + k];
+            if (block[i * 4 + k] > maxs[k]) maxs[k] = block[i * 4 + k];
+        }
+    }
+
+    /*
+     * The box has four diagonals; take the one the colours actually run
+     * along, by flipping any channel that falls while green rises.
+     */
+    {
+        int mean[3] = { 0, 0, 0 }, cov[3] = { 0, 0, 0 };
+
+        for (i = 0; i < 16; i++)
+            for (k = 0; k < 3; k++)
+                mean[k] += block[i * 4 + k];
+        for (k = 0; k < 3; k++)
+            mean[k] = (mean[k] + 8) >> 4;
+
+        for (i = 0; i < 16; i++) {
+            int dg = block[i * 4 + 1] - mean[1];
+
+            cov[0] += (block[i * 4 + 0] - mean[0]) * dg;
+            cov[2] += (block[i * 4 + 2] - mean[2]) * dg;
+        }
+
+        for (k = 0; k < 3; k += 2) {
+            if (cov[k] < 0) {
+                int t = mins[k];
+                mins[k] = maxs[k];
+                maxs[k] = t;
+            }
+        }
+    }
+
+    /* Inset by 1/16 of the range so the endpoints aren't outliers */
+    for (k = 0; k < 3; k++) {
+        int inset = (maxs[k] - mins[k]) / 16;
+
+        mins[k] += inset;
+        maxs[k] -= inset;
+    }
+
+    c0 = R_Pack565(maxs);
+    c1 = R_Pack565(mins);
+    if (c0 < c1) {
+        unsigned short t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+
+    if (c0 != c1) {
+        R_Unpack565(c0, pal[0]);
+        R_Unpack565(c1, pal[1]);
+        for (k = 0; k < 3; k++) {
+            pal[2][k] = (2 * pal[0][k] + pal[1][k]) / 3;
+            pal[3][k] = (pal[0][k] + 2 * pal[1][k]) / 3;
+        }
+
+        for (i = 0; i < 16; i++) {
+            int best = 0, bestdist = 0x7fffffff, j;
+
+            for (j = 0; j < 4; j++) {
+                int dr = block[i * 4 + 0] - pal[j][0];
+                int dg = block[i * 4 + 1] - pal[j][1];
+                int db = block[i * 4 + 2] - pal[j][2];
+                int dist = dr * dr + dg * dg + db * db;
+
+                if (dist < bestdist) {
+                    bestdist = dist;
+                    best = j;
+                }
+            }
+            indices |= (unsigned)best << (i * 2);
+        }
+    }
+    /* else a flat block: every index 0 */
+
+    out[0] = c0 & 0xff;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xff;
+    out[3] = c1 >> 8;
+    out[4] = indices & 0xff;
+    out[5] = (indices >> 8) & 0xff;
+    out[6] = (indices >> 16) & 0xff;
+    out[7] = indices >> 24;
+}
+
+/* 8-byte BC3 alpha block, eight-value mode */
+static void R_EncodeAlphaBlock(const byte *block, byte *out)
+{
+    int         amin = 255, amax = 0, pal[8], i, j;
+    uint64_t    indices = 0;
+
+    for (i = 0; i < 16; i++) {
+        if (block[i * 4 + 3] < amin) amin = block[i * 4 + 3];
+        if (block[i * 4 + 3] > amax) amax = block[i * 4 + 3];
+    }
+
+    out[0] = (byte)amax;
+    out[1] = (byte)amin;
+
+    if (amax != amin) {
+        pal[0] = amax;
+        pal[1] = amin;
+        for (j = 1; j < 7; j++)
+            pal[j + 1] = ((7 - j) * amax + j * amin) / 7;
+
+        for (i = 0; i < 16; i++) {
+            int best = 0, bestdist = 256;
+
+            for (j = 0; j < 8; j++) {
+                int dist = abs(block[i * 4 + 3] - pal[j]);
+
+                if (dist < bestdist) {
+                    bestdist = dist;
+                    best = j;
+                }
+            }
+            indices |= (uint64_t)best << (i * 3);
+        }
+    }
+
+    for (i = 0; i < 6; i++)
+        out[2 + i] = (byte)(indices >> (i * 8));
+}
+
+/* Compress one level; blocks past the edge repeat the edge pixels */
+static byte *R_CompressLevel(const byte *rgba, int width, int height, texformat_t format,
+                             byte *out)
+{
+    byte    block[16 * 4];
+    int     bx, by, x, y;
+
+    for (by = 0; by < height; by += 4) {
+        for (bx = 0; bx < width; bx += 4) {
+            for (y = 0; y < 4; y++) {
+                for (x = 0; x < 4; x++) {
+                    int sx = bx + x < width ? bx + x : width - 1;
+                    int sy = by + y < height ? by + y : height - 1;
+
+                    memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+                }
+            }
+
+            if (format == TF_BC3) {
+                R_EncodeAlphaBlock(block, out);
+                out += 8;
+            }
+            R_EncodeColorBlock(block, out);
+            out += 8;
+        }
+    }
+
+    return out;
+}
+
+/* Compress a whole RGBA mip chain (as R_BuildMips lays it out) */
+byte *R_CompressMipChain(const byte *chain, int width, int height, texformat_t format)
+{
+    byte *data = (byte *)Z_Malloc(R_TexChainSize(format, width, height));
+    byte *out = data;
+
+    for (;;) {
+        out = R_CompressLevel(chain, width, height, format, out);
+        if (width == 1 && height == 1)
+            return data;
+        chain += width * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+}
+
+/* ==========================================================================
+   Disk Cache
+   ========================================================================== */
+
+static void R_TexCachePath(const char *path, char *out, int size)
+{
+    Com_sprintf(out, size, "%s/%08x.tc", r_texcache.dir, Com_HashString(path));
+}
+
+/*
+ * Read a converted chain for path, if the cached copy was made from the
+ * file that would be loaded now and in the format wanted now.
+ */
+qboolean R_TexCacheLoad(const char *path, byte **data, int *width, int *height,
+                        qboolean *has_alpha, texformat_t *format)
+{
+    texcache_header_t   hdr;
+    char                stamp[TEXCACHE_STAMP], cachename[MAX_OSPATH];
+    FILE                *f;
+    byte                *buf;
+
+    if (!r_texcache.compress || !r_texcache.use_disk)
+        return qfalse;
+    if (!FS_FileStamp(path, stamp, sizeof(stamp)))
+        return qfalse;
+
+    R_TexCachePath(path, cachename, sizeof(cachename));
+    f = fopen(cachename, "rb");
+    if (!f)
+        return qfalse;
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != TEXCACHE_MAGIC ||
+        hdr.version != TEXCACHE_VERSION || strncmp(hdr.stamp, stamp, sizeof(hdr.stamp)) ||
+        hdr.width <= 0 || hdr.height <= 0 || hdr.width > 4096 || hdr.height > 4096 ||
+        hdr.format != (int)R_TexTargetFormat(hdr.has_alpha) ||
+        hdr.datasize != R_TexChainSize(hdr.format, hdr.width, hdr.height)) {
+        fclose(f);
+        return qfalse;
+    }
+
+    buf = (byte *)Z_Malloc(hdr.datasize);
+    if (fread(buf, hdr.datasize, 1, f) != 1) {
+        Z_Free(buf);
+        fclose(f);
+        return qfalse;
+    }
+    fclose(f);
+
+    *data = buf;
+    *width = hdr.width;
+    *height = hdr.height;
+    *has_alpha = hdr.has_alpha ? qtrue : qfalse;
+    *format = (texformat_t)hdr.format;
+    return qtrue;
+}
+
+/* Write a converted chain; through a temp file so a reader never sees half */
+void R_TexCacheStore(const char *path, const byte *data, int width, int height,
+                     qboolean has_alpha, texformat_t format)
+{
+    texcache_header_t   hdr;
+    char                cachename[MAX_OSPATH], tempname[MAX_OSPATH];
+    FILE                *f;
+    qboolean            ok;
+
+    if (!r_texcache.use_disk)
+        return;
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (!FS_FileStamp(path, hdr.stamp, sizeof(hdr.stamp)))
+        return;
+    hdr.magic = TEXCACHE_MAGIC;
+    hdr.version = TEXCACHE_VERSION;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.format = format;
+    hdr.has_alpha = has_alpha;
+    hdr.datasize = R_TexChainSize(format, width, height);
+
+    R_TexCachePath(path, cachename, sizeof(cachename));
+    Com_sprintf(tempname, sizeof(tempname), "%s.%lu", cachename, Sys_ThreadID());
+
+    f = fopen(tempname, "wb");
+    if (!f)
+        return;
+    ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+         fwrite(data, hdr.datasize, 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+
+    remove(cachename);
+    if (!ok || rename(tempname, cachename) != 0)
+        remove(tempname);
+}
+
+/* ==========================================================================
+   Upload
+   ========================================================================== */
+
+GLuint R_UploadCompressedChain(const byte *data, int width, int height, texformat_t format)
+{
+    GLenum  internal = format == TF_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+                                        : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    GLuint  texnum;
+    int     level = 0;
+
+#ifdef SOF_RENDERER_VULKAN
+    if (gl_state.vk) {
+        int w, h, levels = 1;
+
+        for (w = width, h = height; w > 1 || h > 1; levels++) {
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+
+        texnum = R_VK_CreateTexture(width, height, levels, internal, qtrue);
+        for (level = 0; level < levels; level++) {
+            int size = R_TexLevelSize(format, width, height);
+
+            R_VK_CompressedLevel(texnum, level, width, height, internal, size, data);
+            data += size;
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        return texnum;
+    }
+#endif
+#ifdef SOF_RENDERER_GL4
+    if (gl_state.gl4) {
+        int w, h, levels = 1;
+
+        for (w = width, h = height; w > 1 || h > 1; levels++) {
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+
+        texnum = R_GL4_CreateTexture(width, height, levels, internal, qtrue);
+        for (level = 0; level < levels; level++) {
+            int size = R_TexLevelSize(format, width, height);
+
+            R_GL4_CompressedLevel(texnum, level, width, height, internal, size, data);
+            data += size;
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        return texnum;
+    }
+#endif
+
+    qglGenTextures(1, &texnum);
+    qglBindTexture(GL_TEXTURE_2D, texnum);
+
+    for (;;) {
+        int size = R_TexLevelSize(format, width, height);
+
+        qglCompressedTexImage2DARB(GL_TEXTURE_2D, level, internal, width, height, 0,
+                                   size, data);
+        if (width == 1 && height == 1)
+            break;
+        data += size;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        level++;
+    }
+
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    qglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    return texnum;
+}
+
+/* ==========================================================================
+   Init
+   ========================================================================== */
+
+/* After extension detection, before any texture is loaded */
+void R_InitTexCache(void)
+{
+    r_texcompress = Cvar_Get("r_texcompress", "0", CVAR_ARCHIVE | CVAR_LATCH);
+    r_texcache_cvar = Cvar_Get("r_texcache", "1", CVAR_ARCHIVE | CVAR_LATCH);
+
+    memset(&r_texcache, 0, sizeof(r_texcache));
+
+    if (!r_texcompress->value)
+        return;
+
+    if (!gl_state.have_s3tc) {
+        Com_Printf("r_texcompress: no S3TC support, textures stay uncompressed\n");
+        return;
+    }
+
+    r_texcache.compress = qtrue;
+    Com_Printf("...compressing wall textures to BC1/BC3\n");
+
+    if (r_texcache_cvar->value) {
+        Com_sprintf(r_texcache.dir, sizeof(r_texcache.dir), "%s/texcache", FS_Gamedir());
+        Sys_Mkdir(r_texcache.dir);
+        r_texcache.use_disk = qtrue;
+    }
+}
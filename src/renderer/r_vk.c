@@ -0,0 +1,2213 @@
+/*
+ * r_vk.c - Vulkan rendering path (SOF_RENDERER_VULKAN)
+ *
+ * A second backend behind the same R_Init / R_RenderFrame / R_EndFrame
+ * entry points. When r_vulkan is set the window is created without a GL
+ * context and none of the qgl pointers are loaded; instead:
+ *
+ *   - Textures (r_image.c, r_light.c, r_texcache.c) are VkImages in a
+ *     handle table indexed by the same GLuint texnum the rest of the
+ *     renderer passes around, each with its own descriptor set. Uploads
+ *     go through a per-frame staging buffer into a command buffer that is
+ *     submitted ahead of the frame; BC1/BC3 are used when the device has
+ *     textureCompressionBC.
+ *   - The world mesh (r_surf.c) is a device-local vertex buffer. The
+ *     gather is unchanged and writes its index lists into a per-frame
+ *     host-visible stream buffer; the material runs it produces are then
+ *     split across the job threads, each recording its share into a
+ *     secondary command buffer of its own.
+ *   - The HUD and console (r_draw.c) are streamed the same way, one
+ *     secondary per R_Flush2D.
+ *   - R_EndFrame records one primary that runs the secondaries in order
+ *     inside the render pass, and submits it with two frames in flight,
+ *     each with its own fence, command pools, stream and staging memory.
+ *     Nothing a frame used is destroyed until its fence has signalled.
+ *
+ * Only the world and 2D are drawn here so far: models, particles, sprites,
+ * decals, the sky and the view weapon are still GL-only. Anything missing
+ * at init (no loader, no device, no swapchain) leaves gl_state.vk off and
+ * R_Init recreates the window for GL.
+ */
+
+#include "r_local.h"
+
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+#include <SDL2/SDL_vulkan.h>
+
+/* SPIR-V from src/renderer/shaders, built by glslangValidator */
+#include "vk_world_vert.h"
+#include "vk_world_frag.h"
+#include "vk_2d_vert.h"
+#include "vk_2d_frag.h"
+
+cvar_t *r_vulkan;
+
+#define VK_FRAMES           2               /* frames in flight */
+#define VK_MAX_TEXTURES     4096
+#define VK_MAX_SECONDARIES  64              /* per frame */
+#define VK_MAX_SWAPIMAGES   16
+#define VK_MAX_BLOCKS       64
+#define VK_MAX_DEAD_BUFFERS 4
+#define VK_IMAGE_BLOCK      (64 * 1024 * 1024)
+#define VK_STREAM_SIZE      (32 * 1024 * 1024)
+#define VK_STAGING_SIZE     (8 * 1024 * 1024)   /* grows for a bigger upload */
+
+#define VK_WORLD_JOB_MINDRAWS   64          /* below this a secondary isn't worth a wakeup */
+#define VK_WORLD_MAX_CHUNKS     8
+
+/* ==========================================================================
+   Vulkan Entry Points
+   ========================================================================== */
+
+static PFN_vkGetInstanceProcAddr                    qvkGetInstanceProcAddr;
+static PFN_vkCreateInstance                         qvkCreateInstance;
+
+static PFN_vkDestroyInstance                        qvkDestroyInstance;
+static PFN_vkEnumeratePhysicalDevices               qvkEnumeratePhysicalDevices;
+static PFN_vkGetPhysicalDeviceProperties            qvkGetPhysicalDeviceProperties;
+static PFN_vkGetPhysicalDeviceFeatures              qvkGetPhysicalDeviceFeatures;
+static PFN_vkGetPhysicalDeviceQueueFamilyProperties qvkGetPhysicalDeviceQueueFamilyProperties;
+static PFN_vkGetPhysicalDeviceMemoryProperties      qvkGetPhysicalDeviceMemoryProperties;
+static PFN_vkGetPhysicalDeviceFormatProperties      qvkGetPhysicalDeviceFormatProperties;
+static PFN_vkGetPhysicalDeviceSurfaceSupportKHR     qvkGetPhysicalDeviceSurfaceSupportKHR;
+static PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR qvkGetPhysicalDeviceSurfaceCapabilitiesKHR;
+static PFN_vkGetPhysicalDeviceSurfaceFormatsKHR     qvkGetPhysicalDeviceSurfaceFormatsKHR;
+static PFN_vkDestroySurfaceKHR                      qvkDestroySurfaceKHR;
+static PFN_vkCreateDevice                           qvkCreateDevice;
+static PFN_vkGetDeviceProcAddr                      qvkGetDeviceProcAddr;
+
+static PFN_vkDestroyDevice                          qvkDestroyDevice;
+static PFN_vkGetDeviceQueue                         qvkGetDeviceQueue;
+static PFN_vkDeviceWaitIdle                         qvkDeviceWaitIdle;
+static PFN_vkQueueSubmit                            qvkQueueSubmit;
+static PFN_vkQueueWaitIdle                          qvkQueueWaitIdle;
+static PFN_vkCreateSwapchainKHR                     qvkCreateSwapchainKHR;
+static PFN_vkDestroySwapchainKHR                    qvkDestroySwapchainKHR;
+static PFN_vkGetSwapchainImagesKHR                  qvkGetSwapchainImagesKHR;
+static PFN_vkAcquireNextImageKHR                    qvkAcquireNextImageKHR;
+static PFN_vkQueuePresentKHR                        qvkQueuePresentKHR;
+static PFN_vkAllocateMemory                         qvkAllocateMemory;
+static PFN_vkFreeMemory                             qvkFreeMemory;
+static PFN_vkMapMemory                              qvkMapMemory;
+static PFN_vkCreateBuffer                           qvkCreateBuffer;
+static PFN_vkDestroyBuffer                          qvkDestroyBuffer;
+static PFN_vkGetBufferMemoryRequirements            qvkGetBufferMemoryRequirements;
+static PFN_vkBindBufferMemory                       qvkBindBufferMemory;
+static PFN_vkCreateImage                            qvkCreateImage;
+static PFN_vkDestroyImage                           qvkDestroyImage;
+static PFN_vkGetImageMemoryRequirements             qvkGetImageMemoryRequirements;
+static PFN_vkBindImageMemory                        qvkBindImageMemory;
+static PFN_vkCreateImageView                        qvkCreateImageView;
+static PFN_vkDestroyImageView                       qvkDestroyImageView;
+static PFN_vkCreateSampler                          qvkCreateSampler;
+static PFN_vkDestroySampler                         qvkDestroySampler;
+static PFN_vkCreateRenderPass                       qvkCreateRenderPass;
+static PFN_vkDestroyRenderPass                      qvkDestroyRenderPass;
+static PFN_vkCreateFramebuffer                      qvkCreateFramebuffer;
+static PFN_vkDestroyFramebuffer                     qvkDestroyFramebuffer;
+static PFN_vkCreateShaderModule                     qvkCreateShaderModule;
+static PFN_vkDestroyShaderModule                    qvkDestroyShaderModule;
+static PFN_vkCreatePipelineLayout                   qvkCreatePipelineLayout;
+static PFN_vkDestroyPipelineLayout                  qvkDestroyPipelineLayout;
+static PFN_vkCreateGraphicsPipelines                qvkCreateGraphicsPipelines;
+static PFN_vkDestroyPipeline                        qvkDestroyPipeline;
+static PFN_vkCreateDescriptorSetLayout              qvkCreateDescriptorSetLayout;
+static PFN_vkDestroyDescriptorSetLayout             qvkDestroyDescriptorSetLayout;
+static PFN_vkCreateDescriptorPool                   qvkCreateDescriptorPool;
+static PFN_vkDestroyDescriptorPool                  qvkDestroyDescriptorPool;
+static PFN_vkAllocateDescriptorSets                 qvkAllocateDescriptorSets;
+static PFN_vkFreeDescriptorSets                     qvkFreeDescriptorSets;
+static PFN_vkUpdateDescriptorSets                   qvkUpdateDescriptorSets;
+static PFN_vkCreateCommandPool                      qvkCreateCommandPool;
+static PFN_vkDestroyCommandPool                     qvkDestroyCommandPool;
+static PFN_vkResetCommandPool                       qvkResetCommandPool;
+static PFN_vkAllocateCommandBuffers                 qvkAllocateCommandBuffers;
+static PFN_vkBeginCommandBuffer                     qvkBeginCommandBuffer;
+static PFN_vkEndCommandBuffer                       qvkEndCommandBuffer;
+static PFN_vkResetCommandBuffer                     qvkResetCommandBuffer;
+static PFN_vkCreateFence                            qvkCreateFence;
+static PFN_vkDestroyFence                           qvkDestroyFence;
+static PFN_vkWaitForFences                          qvkWaitForFences;
+static PFN_vkResetFences                            qvkResetFences;
+static PFN_vkCreateSemaphore                        qvkCreateSemaphore;
+static PFN_vkDestroySemaphore                       qvkDestroySemaphore;
+static PFN_vkCmdBeginRenderPass                     qvkCmdBeginRenderPass;
+static PFN_vkCmdEndRenderPass                       qvkCmdEndRenderPass;
+static PFN_vkCmdExecuteCommands                     qvkCmdExecuteCommands;
+static PFN_vkCmdBindPipeline                        qvkCmdBindPipeline;
+static PFN_vkCmdBindDescriptorSets                  qvkCmdBindDescriptorSets;
+static PFN_vkCmdBindVertexBuffers                   qvkCmdBindVertexBuffers;
+static PFN_vkCmdBindIndexBuffer                     qvkCmdBindIndexBuffer;
+static PFN_vkCmdPushConstants                       qvkCmdPushConstants;
+static PFN_vkCmdSetViewport                         qvkCmdSetViewport;
+static PFN_vkCmdSetScissor                          qvkCmdSetScissor;
+static PFN_vkCmdDraw                                qvkCmdDraw;
+static PFN_vkCmdDrawIndexed                         qvkCmdDrawIndexed;
+static PFN_vkCmdClearAttachments                    qvkCmdClearAttachments;
+static PFN_vkCmdPipelineBarrier                     qvkCmdPipelineBarrier;
+static PFN_vkCmdCopyBuffer                          qvkCmdCopyBuffer;
+static PFN_vkCmdCopyBufferToImage                   qvkCmdCopyBufferToImage;
+
+/* ==========================================================================
+   State
+   ========================================================================== */
+
+typedef struct {
+    VkBuffer        buffer;
+    VkDeviceMemory  memory;
+    byte            *mapped;        /* host-visible buffers only */
+    VkDeviceSize    size;
+} vkbuffer_t;
+
+/* Images share big allocations; a block is reused once it empties */
+typedef struct {
+    VkDeviceMemory  memory;
+    uint32_t        type;
+    VkDeviceSize    used;
+    int             refs;
+} vkblock_t;
+
+typedef struct {
+    qboolean        used;
+    VkImage         image;
+    VkImageView     view;
+    VkDescriptorSet set;
+    int             block;          /* -1: memory is its own */
+    VkDeviceMemory  memory;
+    VkFormat        format;
+    int             levels;
+} vktexture_t;
+
+typedef struct {
+    VkFence         fence;
+    VkSemaphore     acquired;
+    VkCommandPool   pool;           /* primary and uploads, main thread only */
+    VkCommandBuffer primary;
+    VkCommandBuffer upload;
+    qboolean        uploading;      /* upload has been begun */
+
+    /* One pool each, so several can be recorded at once */
+    VkCommandPool   secondary_pools[VK_MAX_SECONDARIES];
+    VkCommandBuffer secondaries[VK_MAX_SECONDARIES];
+    int             numsecondaries;
+
+    vkbuffer_t      stream;         /* indices and 2D vertices */
+    int             stream_used;
+    vkbuffer_t      staging;        /* texture and buffer uploads */
+    int             staging_used;
+
+    /* Destroyed once the frame's fence says the GPU is done with them */
+    int             dead_textures[VK_MAX_TEXTURES];
+    int             num_dead_textures;
+    vkbuffer_t      dead_buffers[VK_MAX_DEAD_BUFFERS];
+    int             num_dead_buffers;
+} vkframe_t;
+
+/* The per-view half of the world push constants */
+typedef struct {
+    float   mvp[16];
+    float   fog[4];                 /* rgb, density */
+    float   vieworg[4];             /* xyz, time */
+} vkviewpush_t;
+
+/* ... and the per-draw half after it */
+typedef struct {
+    float   color[4];
+    float   alpharef;
+    int32_t warp;
+} vkdrawpush_t;
+
+#define VK_PUSH_SIZE    128         /* the guaranteed minimum */
+
+static struct {
+    VkInstance                      instance;
+    VkSurfaceKHR                    surface;
+    VkPhysicalDevice                physical;
+    VkPhysicalDeviceMemoryProperties memprops;
+    VkDevice                        device;
+    VkQueue                         queue;
+    uint32_t                        queue_family;
+    qboolean                        bc;             /* textureCompressionBC */
+
+    /* Swapchain; recreated when the window changes */
+    VkSurfaceFormatKHR              surface_format;
+    VkFormat                        depth_format;
+    VkSwapchainKHR                  swapchain;
+    VkExtent2D                      extent;
+    uint32_t                        numimages;
+    VkImage                         images[VK_MAX_SWAPIMAGES];
+    VkImageView                     views[VK_MAX_SWAPIMAGES];
+    VkFramebuffer                   framebuffers[VK_MAX_SWAPIMAGES];
+    VkSemaphore                     rendered[VK_MAX_SWAPIMAGES];
+    VkImage                         depth_image;
+    VkImageView                     depth_view;
+    VkDeviceMemory                  depth_memory;
+    int                             display_width, display_height;
+    qboolean                        recreate;
+
+    VkRenderPass                    renderpass;
+    VkSampler                       sampler_repeat, sampler_clamp;
+    VkDescriptorSetLayout           set_layout;
+    VkDescriptorPool                set_pool;
+    VkPipelineLayout                layout;
+    VkShaderModule                  world_vs, world_fs, ui_vs, ui_fs;
+    VkPipeline                      world_opaque, world_blend, ui;
+    int                             world_stride, world_st_ofs, world_lm_ofs;
+
+    vkframe_t                       frames[VK_FRAMES];
+    int                             frame;
+
+    vktexture_t                     textures[VK_MAX_TEXTURES];
+    int                             texture_rover;
+    GLuint                          white;
+    vkblock_t                       blocks[VK_MAX_BLOCKS];
+    int                             numblocks;
+
+    vkbuffer_t                      world_verts;
+
+    /* Current view, from R_VK_SetView */
+    vkviewpush_t                    view;
+    VkViewport                      viewport;
+    VkRect2D                        scissor;
+
+    qboolean                        stream_warned;
+} vk;
+
+/* World draws queued between R_VK_BeginWorld and R_VK_EndWorld */
+typedef struct {
+    GLuint      texture, lightmap;  /* 0 = white */
+    vkdrawpush_t push;
+    qboolean    blend;
+    uint32_t    firstindex, numindices;
+} vkdraw_t;
+
+static struct {
+    vkdraw_t    cur;
+    vkdraw_t    *draws;
+    int         numdraws;
+    int         maxdraws;
+} vk_world;
+
+#define VK_FRAME()  (&vk.frames[vk.frame])
+
+/* ==========================================================================
+   Loading
+   ========================================================================== */
+
+#define VK_LOAD_INSTANCE(name) \
+    if (!(q##name = (PFN_##name)qvkGetInstanceProcAddr(vk.instance, #name))) { \
+        Com_Printf("VK: " #name " not found\n"); \
+        ok = qfalse; \
+    }
+
+#define VK_LOAD_DEVICE(name) \
+    if (!(q##name = (PFN_##name)qvkGetDeviceProcAddr(vk.device, #name))) { \
+        Com_Printf("VK: " #name " not found\n"); \
+        ok = qfalse; \
+    }
+
+static qboolean R_VK_LoadInstanceFunctions(void)
+{
+    qboolean ok = qtrue;
+
+    VK_LOAD_INSTANCE(vkDestroyInstance);
+    VK_LOAD_INSTANCE(vkEnumeratePhysicalDevices);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceProperties);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceFeatures);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceQueueFamilyProperties);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceMemoryProperties);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceFormatProperties);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceSurfaceSupportKHR);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    VK_LOAD_INSTANCE(vkGetPhysicalDeviceSurfaceFormatsKHR);
+    VK_LOAD_INSTANCE(vkDestroySurfaceKHR);
+    VK_LOAD_INSTANCE(vkCreateDevice);
+    VK_LOAD_INSTANCE(vkGetDeviceProcAddr);
+
+    return ok;
+}
+
+static qboolean R_VK_LoadDeviceFunctions(void)
+{
+    qboolean ok = qtrue;
+
+    VK_LOAD_DEVICE(vkDestroyDevice);
+    VK_LOAD_DEVICE(vkGetDeviceQueue);
+    VK_LOAD_DEVICE(vkDeviceWaitIdle);
+    VK_LOAD_DEVICE(vkQueueSubmit);
+    VK_LOAD_DEVICE(vkQueueWaitIdle);
+    VK_LOAD_DEVICE(vkCreateSwapchainKHR);
+    VK_LOAD_DEVICE(vkDestroySwapchainKHR);
+    VK_LOAD_DEVICE(vkGetSwapchainImagesKHR);
+    VK_LOAD_DEVICE(vkAcquireNextImageKHR);
+    VK_LOAD_DEVICE(vkQueuePresentKHR);
+    VK_LOAD_DEVICE(vkAllocateMemory);
+    VK_LOAD_DEVICE(vkFreeMemory);
+    VK_LOAD_DEVICE(vkMapMemory);
+    VK_LOAD_DEVICE(vkCreateBuffer);
+    VK_LOAD_DEVICE(vkDestroyBuffer);
+    VK_LOAD_DEVICE(vkGetBufferMemoryRequirements);
+    VK_LOAD_DEVICE(vkBindBufferMemory);
+    VK_LOAD_DEVICE(vkCreateImage);
+    VK_LOAD_DEVICE(vkDestroyImage);
+    VK_LOAD_DEVICE(vkGetImageMemoryRequirements);
+    VK_LOAD_DEVICE(vkBindImageMemory);
+    VK_LOAD_DEVICE(vkCreateImageView);
+    VK_LOAD_DEVICE(vkDestroyImageView);
+    VK_LOAD_DEVICE(vkCreateSampler);
+    VK_LOAD_DEVICE(vkDestroySampler);
+    VK_LOAD_DEVICE(vkCreateRenderPass);
+    VK_LOAD_DEVICE(vkDestroyRenderPass);
+    VK_LOAD_DEVICE(vkCreateFramebuffer);
+    VK_LOAD_DEVICE(vkDestroyFramebuffer);
+    VK_LOAD_DEVICE(vkCreateShaderModule);
+    VK_LOAD_DEVICE(vkDestroyShaderModule);
+    VK_LOAD_DEVICE(vkCreatePipelineLayout);
+    VK_LOAD_DEVICE(vkDestroyPipelineLayout);
+    VK_LOAD_DEVICE(vkCreateGraphicsPipelines);
+    VK_LOAD_DEVICE(vkDestroyPipeline);
+    VK_LOAD_DEVICE(vkCreateDescriptorSetLayout);
+    VK_LOAD_DEVICE(vkDestroyDescriptorSetLayout);
+    VK_LOAD_DEVICE(vkCreateDescriptorPool);
+    VK_LOAD_DEVICE(vkDestroyDescriptorPool);
+    VK_LOAD_DEVICE(vkAllocateDescriptorSets);
+    VK_LOAD_DEVICE(vkFreeDescriptorSets);
+    VK_LOAD_DEVICE(vkUpdateDescriptorSets);
+    VK_LOAD_DEVICE(vkCreateCommandPool);
+    VK_LOAD_DEVICE(vkDestroyCommandPool);
+    VK_LOAD_DEVICE(vkResetCommandPool);
+    VK_LOAD_DEVICE(vkAllocateCommandBuffers);
+    VK_LOAD_DEVICE(vkBeginCommandBuffer);
+    VK_LOAD_DEVICE(vkEndCommandBuffer);
+    VK_LOAD_DEVICE(vkResetCommandBuffer);
+    VK_LOAD_DEVICE(vkCreateFence);
+    VK_LOAD_DEVICE(vkDestroyFence);
+    VK_LOAD_DEVICE(vkWaitForFences);
+    VK_LOAD_DEVICE(vkResetFences);
+    VK_LOAD_DEVICE(vkCreateSemaphore);
+    VK_LOAD_DEVICE(vkDestroySemaphore);
+    VK_LOAD_DEVICE(vkCmdBeginRenderPass);
+    VK_LOAD_DEVICE(vkCmdEndRenderPass);
+    VK_LOAD_DEVICE(vkCmdExecuteCommands);
+    VK_LOAD_DEVICE(vkCmdBindPipeline);
+    VK_LOAD_DEVICE(vkCmdBindDescriptorSets);
+    VK_LOAD_DEVICE(vkCmdBindVertexBuffers);
+    VK_LOAD_DEVICE(vkCmdBindIndexBuffer);
+    VK_LOAD_DEVICE(vkCmdPushConstants);
+    VK_LOAD_DEVICE(vkCmdSetViewport);
+    VK_LOAD_DEVICE(vkCmdSetScissor);
+    VK_LOAD_DEVICE(vkCmdDraw);
+    VK_LOAD_DEVICE(vkCmdDrawIndexed);
+    VK_LOAD_DEVICE(vkCmdClearAttachments);
+    VK_LOAD_DEVICE(vkCmdPipelineBarrier);
+    VK_LOAD_DEVICE(vkCmdCopyBuffer);
+    VK_LOAD_DEVICE(vkCmdCopyBufferToImage);
+
+    return ok;
+}
+
+/* ==========================================================================
+   Memory and Buffers
+   ========================================================================== */
+
+static int R_VK_MemoryType(uint32_t bits, VkMemoryPropertyFlags props)
+{
+    uint32_t i;
+
+    for (i = 0; i < vk.memprops.memoryTypeCount; i++) {
+        if ((bits & (1u << i)) &&
+            (vk.memprops.memoryTypes[i].propertyFlags & props) == props)
+            return (int)i;
+    }
+    return -1;
+}
+
+static qboolean R_VK_AllocMemory(const VkMemoryRequirements *req, VkMemoryPropertyFlags props,
+                                 VkDeviceSize size, VkDeviceMemory *out)
+{
+    VkMemoryAllocateInfo    info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    int                     type = R_VK_MemoryType(req->memoryTypeBits, props);
+
+    if (type < 0)
+        return qfalse;
+    info.allocationSize = size;
+    info.memoryTypeIndex = (uint32_t)type;
+    return qvkAllocateMemory(vk.device, &info, NULL, out) == VK_SUCCESS;
+}
+
+static qboolean R_VK_CreateBuffer(vkbuffer_t *b, VkDeviceSize size, VkBufferUsageFlags usage,
+                                  qboolean host)
+{
+    VkBufferCreateInfo      info = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    VkMemoryRequirements    req;
+    VkMemoryPropertyFlags   props = host ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                         : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    memset(b, 0, sizeof(*b));
+    info.size = size;
+    info.usage = usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (qvkCreateBuffer(vk.device, &info, NULL, &b->buffer) != VK_SUCCESS)
+        return qfalse;
+
+    qvkGetBufferMemoryRequirements(vk.device, b->buffer, &req);
+    if (!R_VK_AllocMemory(&req, props, req.size, &b->memory) ||
+        qvkBindBufferMemory(vk.device, b->buffer, b->memory, 0) != VK_SUCCESS ||
+        (host && qvkMapMemory(vk.device, b->memory, 0, VK_WHOLE_SIZE, 0,
+                              (void **)&b->mapped) != VK_SUCCESS)) {
+        if (b->memory)
+            qvkFreeMemory(vk.device, b->memory, NULL);
+        qvkDestroyBuffer(vk.device, b->buffer, NULL);
+        memset(b, 0, sizeof(*b));
+        return qfalse;
+    }
+
+    b->size = size;
+    return qtrue;
+}
+
+static void R_VK_DestroyBuffer(vkbuffer_t *b)
+{
+    if (b->buffer)
+        qvkDestroyBuffer(vk.device, b->buffer, NULL);
+    if (b->memory)
+        qvkFreeMemory(vk.device, b->memory, NULL);  /* unmaps */
+    memset(b, 0, sizeof(*b));
+}
+
+/* Bind an image into a block, or give it memory of its own if it's big */
+static qboolean R_VK_BindImage(vktexture_t *t)
+{
+    VkMemoryRequirements    req;
+    vkblock_t               *b;
+    VkDeviceSize            ofs = 0;
+    int                     type, i;
+
+    qvkGetImageMemoryRequirements(vk.device, t->image, &req);
+    type = R_VK_MemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (type < 0)
+        return qfalse;
+
+    t->block = -1;
+    if (req.size > VK_IMAGE_BLOCK / 4) {
+        if (!R_VK_AllocMemory(&req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.size, &t->memory))
+            return qfalse;
+        return qvkBindImageMemory(vk.device, t->image, t->memory, 0) == VK_SUCCESS;
+    }
+
+    for (i = 0; i < vk.numblocks; i++) {
+        b = &vk.blocks[i];
+        ofs = (b->used + req.alignment - 1) & ~(req.alignment - 1);
+        if (b->memory && b->type == (uint32_t)type && ofs + req.size <= VK_IMAGE_BLOCK)
+            break;
+    }
+    if (i == vk.numblocks) {
+        if (vk.numblocks == VK_MAX_BLOCKS)
+            return qfalse;
+        b = &vk.blocks[vk.numblocks];
+        if (!R_VK_AllocMemory(&req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_BLOCK,
+                              &b->memory))
+            return qfalse;
+        b->type = (uint32_t)type;
+        b->used = 0;
+        b->refs = 0;
+        vk.numblocks++;
+        ofs = 0;
+    }
+
+    if (qvkBindImageMemory(vk.device, t->image, b->memory, ofs) != VK_SUCCESS)
+        return qfalse;
+    b->used = ofs + req.size;
+    b->refs++;
+    t->block = i;
+    return qtrue;
+}
+
+/* ==========================================================================
+   Uploads
+   Recorded into the frame's upload command buffer, which is submitted
+   ahead of the frame's primary. A level load that outgrows the staging
+   buffer submits what it has and waits.
+   ========================================================================== */
+
+static VkCommandBuffer R_VK_UploadCmd(void)
+{
+    vkframe_t                   *f = VK_FRAME();
+    VkCommandBufferBeginInfo    begin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+
+    if (!f->uploading) {
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        qvkBeginCommandBuffer(f->upload, &begin);
+        f->uploading = qtrue;
+    }
+    return f->upload;
+}
+
+static void R_VK_FlushUploads(void)
+{
+    vkframe_t       *f = VK_FRAME();
+    VkSubmitInfo    submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+
+    if (f->uploading) {
+        qvkEndCommandBuffer(f->upload);
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &f->upload;
+        qvkQueueSubmit(vk.queue, 1, &submit, VK_NULL_HANDLE);
+        qvkQueueWaitIdle(vk.queue);
+        qvkResetCommandBuffer(f->upload, 0);
+        f->uploading = qfalse;
+    }
+    f->staging_used = 0;
+}
+
+static byte *R_VK_StagingAlloc(int size, VkDeviceSize *offset)
+{
+    vkframe_t   *f = VK_FRAME();
+    int         ofs = (f->staging_used + 15) & ~15;
+
+    if ((VkDeviceSize)(ofs + size) > f->staging.size) {
+        R_VK_FlushUploads();
+        ofs = 0;
+
+        if ((VkDeviceSize)size > f->staging.size) {
+            VkDeviceSize grow = f->staging.size * 2;
+
+            R_VK_DestroyBuffer(&f->staging);
+            if (!R_VK_CreateBuffer(&f->staging, grow > (VkDeviceSize)size ? grow : (VkDeviceSize)size,
+                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT, qtrue)) {
+                Com_Printf("VK: couldn't grow the staging buffer to %d bytes\n", size);
+                R_VK_CreateBuffer(&f->staging, VK_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                  qtrue);
+                return NULL;
+            }
+        }
+    }
+
+    f->staging_used = ofs + size;
+    *offset = (VkDeviceSize)ofs;
+    return f->staging.mapped + ofs;
+}
+
+static void R_VK_ImageBarrier(VkCommandBuffer cmd, VkImage image, int level, int levels,
+                              VkImageLayout from, VkImageLayout to,
+                              VkPipelineStageFlags src_stage, VkAccessFlags src_access,
+                              VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = from;
+    barrier.newLayout = to;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = (uint32_t)level;
+    barrier.subresourceRange.levelCount = (uint32_t)levels;
+    barrier.subresourceRange.layerCount = 1;
+    qvkCmdPipelineBarrier(cmd, src_stage, dst_stage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+/* Copy staged texels into a rectangle of one level. Images otherwise stay
+ * shader-readable, so any draw before or after this is ordered against it. */
+static void R_VK_CopyToImage(GLuint tex, int level, int x, int y, int width, int height,
+                             VkDeviceSize offset)
+{
+    vktexture_t         *t = &vk.textures[tex];
+    VkCommandBuffer     cmd = R_VK_UploadCmd();
+    VkBufferImageCopy   region;
+
+    R_VK_ImageBarrier(cmd, t->image, level, 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    memset(&region, 0, sizeof(region));
+    region.bufferOffset = offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = (uint32_t)level;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset.x = x;
+    region.imageOffset.y = y;
+    region.imageExtent.width = (uint32_t)width;
+    region.imageExtent.height = (uint32_t)height;
+    region.imageExtent.depth = 1;
+    qvkCmdCopyBufferToImage(cmd, VK_FRAME()->staging.buffer, t->image,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    R_VK_ImageBarrier(cmd, t->image, level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+/* ==========================================================================
+   Textures
+   ========================================================================== */
+
+static qboolean R_VK_ValidTexture(GLuint tex)
+{
+    return tex > 0 && tex < VK_MAX_TEXTURES && vk.textures[tex].used;
+}
+
+static void R_VK_DestroyTexture(GLuint tex)
+{
+    vktexture_t *t = &vk.textures[tex];
+
+    if (t->set)
+        qvkFreeDescriptorSets(vk.device, vk.set_pool, 1, &t->set);
+    if (t->view)
+        qvkDestroyImageView(vk.device, t->view, NULL);
+    if (t->image)
+        qvkDestroyImage(vk.device, t->image, NULL);
+    if (t->block >= 0) {
+        vkblock_t *b = &vk.blocks[t->block];
+
+        if (--b->refs == 0)
+            b->used = 0;
+    } else if (t->memory) {
+        qvkFreeMemory(vk.device, t->memory, NULL);
+    }
+    memset(t, 0, sizeof(*t));
+}
+
+GLuint R_VK_CreateTexture(int width, int height, int levels, GLenum internalformat,
+                          qboolean repeat)
+{
+    VkImageCreateInfo       info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    VkImageViewCreateInfo   view = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    VkDescriptorSetAllocateInfo alloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    VkWriteDescriptorSet    write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    VkDescriptorImageInfo   image;
+    vktexture_t             *t;
+    GLuint                  tex;
+    int                     i;
+
+    for (i = 0; i < VK_MAX_TEXTURES - 1; i++) {
+        tex = 1 + (GLuint)((vk.texture_rover + i) % (VK_MAX_TEXTURES - 1));
+        if (!vk.textures[tex].used)
+            break;
+    }
+    if (i == VK_MAX_TEXTURES - 1) {
+        Com_Printf("VK: out of texture handles\n");
+        return 0;
+    }
+    vk.texture_rover = (int)tex;
+
+    t = &vk.textures[tex];
+    memset(t, 0, sizeof(*t));
+    t->used = qtrue;
+    t->block = -1;
+    t->levels = levels;
+    switch (internalformat) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:   t->format = VK_FORMAT_BC1_RGB_UNORM_BLOCK; break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:  t->format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+    default:                                t->format = VK_FORMAT_R8G8B8A8_UNORM; break;
+    }
+
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = t->format;
+    info.extent.width = (uint32_t)width;
+    info.extent.height = (uint32_t)height;
+    info.extent.depth = 1;
+    info.mipLevels = (uint32_t)levels;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (qvkCreateImage(vk.device, &info, NULL, &t->image) != VK_SUCCESS || !R_VK_BindImage(t))
+        goto fail;
+
+    view.image = t->image;
+    view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view.format = t->format;
+    view.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view.subresourceRange.levelCount = (uint32_t)levels;
+    view.subresourceRange.layerCount = 1;
+    if (qvkCreateImageView(vk.device, &view, NULL, &t->view) != VK_SUCCESS)
+        goto fail;
+
+    alloc.descriptorPool = vk.set_pool;
+    alloc.descriptorSetCount = 1;
+    alloc.pSetLayouts = &vk.set_layout;
+    if (qvkAllocateDescriptorSets(vk.device, &alloc, &t->set) != VK_SUCCESS) {
+        t->set = VK_NULL_HANDLE;
+        goto fail;
+    }
+
+    image.sampler = repeat ? vk.sampler_repeat : vk.sampler_clamp;
+    image.imageView = t->view;
+    image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    write.dstSet = t->set;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image;
+    qvkUpdateDescriptorSets(vk.device, 1, &write, 0, NULL);
+
+    /* Every level readable from the start; the uploads fill them in */
+    R_VK_ImageBarrier(R_VK_UploadCmd(), t->image, 0, levels, VK_IMAGE_LAYOUT_UNDEFINED,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    return tex;
+
+fail:
+    Com_Printf("VK: couldn't create a %dx%d texture\n", width, height);
+    R_VK_DestroyTexture(tex);
+    return 0;
+}
+
+/* GL_RGB sources (lightmaps) are widened: RGB8 can't be sampled everywhere */
+static void R_VK_UploadRect(GLuint tex, int level, int x, int y, int width, int height,
+                            GLenum format, const void *pixels)
+{
+    const byte      *in = (const byte *)pixels;
+    VkDeviceSize    offset;
+    byte            *out;
+    int             i, n = width * height;
+
+    if (!R_VK_ValidTexture(tex) || n <= 0)
+        return;
+    if (!(out = R_VK_StagingAlloc(n * 4, &offset)))
+        return;
+
+    if (format == GL_RGB) {
+        for (i = 0; i < n; i++, in += 3, out += 4) {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+            out[3] = 255;
+        }
+    } else {
+        memcpy(out, in, n * 4);
+    }
+
+    R_VK_CopyToImage(tex, level, x, y, width, height, offset);
+}
+
+void R_VK_TextureLevel(GLuint tex, int level, int width, int height, GLenum format,
+                       const void *pixels)
+{
+    R_VK_UploadRect(tex, level, 0, 0, width, height, format, pixels);
+}
+
+void R_VK_TextureRect(GLuint tex, int x, int y, int width, int height, GLenum format,
+                      const void *pixels)
+{
+    R_VK_UploadRect(tex, 0, x, y, width, height, format, pixels);
+}
+
+void R_VK_CompressedLevel(GLuint tex, int level, int width, int height, GLenum internalformat,
+                          int size, const void *data)
+{
+    VkDeviceSize    offset;
+    byte            *out;
+
+    (void)internalformat;
+    if (!R_VK_ValidTexture(tex) || size <= 0)
+        return;
+    if (!(out = R_VK_StagingAlloc(size, &offset)))
+        return;
+
+    memcpy(out, data, size);
+    R_VK_CopyToImage(tex, level, 0, 0, width, height, offset);
+}
+
+void R_VK_DeleteTexture(GLuint tex)
+{
+    vkframe_t *f = VK_FRAME();
+
+    if (!R_VK_ValidTexture(tex) || tex == vk.white)
+        return;
+    if (f->num_dead_textures < VK_MAX_TEXTURES)
+        f->dead_textures[f->num_dead_textures++] = (int)tex;
+}
+
+static VkDescriptorSet R_VK_TextureSet(GLuint tex)
+{
+    if (!R_VK_ValidTexture(tex))
+        tex = vk.white;
+    return vk.textures[tex].set;
+}
+
+/* ==========================================================================
+   Pipelines
+   ========================================================================== */
+
+static VkShaderModule R_VK_ShaderModule(const uint32_t *code, size_t size)
+{
+    VkShaderModuleCreateInfo    info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    VkShaderModule              module = VK_NULL_HANDLE;
+
+    info.codeSize = size;
+    info.pCode = code;
+    if (qvkCreateShaderModule(vk.device, &info, NULL, &module) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    return module;
+}
+
+static VkPipeline R_VK_BuildPipeline(VkShaderModule vs, VkShaderModule fs,
+                                     const VkVertexInputAttributeDescription *attrs,
+                                     int numattrs, int stride, qboolean depth, qboolean blend)
+{
+    static const VkDynamicState dynamic[2] = { VK_DYNAMIC_STATE_VIEWPORT,
+                                               VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineShaderStageCreateInfo         stages[2];
+    VkVertexInputBindingDescription         binding;
+    VkPipelineVertexInputStateCreateInfo    input = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineInputAssemblyStateCreateInfo  assembly = { VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    VkPipelineViewportStateCreateInfo       viewport = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    VkPipelineRasterizationStateCreateInfo  raster = { VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    VkPipelineMultisampleStateCreateInfo    multisample = { VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    VkPipelineDepthStencilStateCreateInfo   depthstencil = { VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+    VkPipelineColorBlendAttachmentState     attachment;
+    VkPipelineColorBlendStateCreateInfo     colorblend = { VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    VkPipelineDynamicStateCreateInfo        dynstate = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    VkGraphicsPipelineCreateInfo            info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    VkPipeline                              pipeline = VK_NULL_HANDLE;
+
+    memset(stages, 0, sizeof(stages));
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vs;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fs;
+    stages[1].pName = "main";
+
+    binding.binding = 0;
+    binding.stride = (uint32_t)stride;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    input.vertexBindingDescriptionCount = 1;
+    input.pVertexBindingDescriptions = &binding;
+    input.vertexAttributeDescriptionCount = (uint32_t)numattrs;
+    input.pVertexAttributeDescriptions = attrs;
+
+    assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+
+    /* Q2 BSP doesn't use culling, and neither does the 2D */
+    raster.polygonMode = VK_POLYGON_MODE_FILL;
+    raster.cullMode = VK_CULL_MODE_NONE;
+    raster.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    raster.lineWidth = 1.0f;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    depthstencil.depthTestEnable = depth ? VK_TRUE : VK_FALSE;
+    depthstencil.depthWriteEnable = depth && !blend ? VK_TRUE : VK_FALSE;
+    depthstencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    memset(&attachment, 0, sizeof(attachment));
+    attachment.blendEnable = blend ? VK_TRUE : VK_FALSE;
+    attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorblend.attachmentCount = 1;
+    colorblend.pAttachments = &attachment;
+
+    dynstate.dynamicStateCount = 2;
+    dynstate.pDynamicStates = dynamic;
+
+    info.stageCount = 2;
+    info.pStages = stages;
+    info.pVertexInputState = &input;
+    info.pInputAssemblyState = &assembly;
+    info.pViewportState = &viewport;
+    info.pRasterizationState = &raster;
+    info.pMultisampleState = &multisample;
+    info.pDepthStencilState = &depthstencil;
+    info.pColorBlendState = &colorblend;
+    info.pDynamicState = &dynstate;
+    info.layout = vk.layout;
+    info.renderPass = vk.renderpass;
+    info.subpass = 0;
+
+    if (qvkCreateGraphicsPipelines(vk.device, VK_NULL_HANDLE, 1, &info, NULL,
+                                   &pipeline) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    return pipeline;
+}
+
+static void R_VK_DestroyWorldPipelines(void)
+{
+    if (vk.world_opaque)
+        qvkDestroyPipeline(vk.device, vk.world_opaque, NULL);
+    if (vk.world_blend)
+        qvkDestroyPipeline(vk.device, vk.world_blend, NULL);
+    vk.world_opaque = vk.world_blend = VK_NULL_HANDLE;
+    vk.world_stride = 0;
+}
+
+/* The world's vertex layout comes from r_surf.c with its buffer */
+static qboolean R_VK_BuildWorldPipelines(int stride, int st_ofs, int lm_ofs)
+{
+    VkVertexInputAttributeDescription attrs[3];
+
+    if (vk.world_opaque && stride == vk.world_stride && st_ofs == vk.world_st_ofs &&
+        lm_ofs == vk.world_lm_ofs)
+        return qtrue;
+
+    qvkDeviceWaitIdle(vk.device);
+    R_VK_DestroyWorldPipelines();
+
+    attrs[0].location = 0;
+    attrs[0].binding = 0;
+    attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attrs[0].offset = 0;
+    attrs[1].location = 1;
+    attrs[1].binding = 0;
+    attrs[1].format = VK_FORMAT_R32G32_SFLOAT;
+    attrs[1].offset = (uint32_t)st_ofs;
+    attrs[2].location = 2;
+    attrs[2].binding = 0;
+    attrs[2].format = VK_FORMAT_R32G32_SFLOAT;
+    attrs[2].offset = (uint32_t)lm_ofs;
+
+    vk.world_opaque = R_VK_BuildPipeline(vk.world_vs, vk.world_fs, attrs, 3, stride,
+                                         qtrue, qfalse);
+    vk.world_blend = R_VK_BuildPipeline(vk.world_vs, vk.world_fs, attrs, 3, stride,
+                                        qtrue, qtrue);
+    if (!vk.world_opaque || !vk.world_blend) {
+        Com_Printf("VK: couldn't build the world pipelines\n");
+        R_VK_DestroyWorldPipelines();
+        return qfalse;
+    }
+
+    vk.world_stride = stride;
+    vk.world_st_ofs = st_ofs;
+    vk.world_lm_ofs = lm_ofs;
+    return qtrue;
+}
+
+static qboolean R_VK_CreatePipelines(void)
+{
+    VkDescriptorSetLayoutBinding    binding;
+    VkDescriptorSetLayoutCreateInfo setinfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    VkDescriptorPoolSize            poolsize;
+    VkDescriptorPoolCreateInfo      poolinfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    VkDescriptorSetLayout           sets[2];
+    VkPushConstantRange             push;
+    VkPipelineLayoutCreateInfo      layoutinfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    VkSamplerCreateInfo             sampler = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    VkVertexInputAttributeDescription attrs[3];
+
+    /* One combined image sampler per texture; the world binds two */
+    memset(&binding, 0, sizeof(binding));
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    setinfo.bindingCount = 1;
+    setinfo.pBindings = &binding;
+    if (qvkCreateDescriptorSetLayout(vk.device, &setinfo, NULL, &vk.set_layout) != VK_SUCCESS)
+        return qfalse;
+
+    poolsize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolsize.descriptorCount = VK_MAX_TEXTURES;
+    poolinfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolinfo.maxSets = VK_MAX_TEXTURES;
+    poolinfo.poolSizeCount = 1;
+    poolinfo.pPoolSizes = &poolsize;
+    if (qvkCreateDescriptorPool(vk.device, &poolinfo, NULL, &vk.set_pool) != VK_SUCCESS)
+        return qfalse;
+
+    sets[0] = sets[1] = vk.set_layout;
+    push.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    push.offset = 0;
+    push.size = VK_PUSH_SIZE;
+    layoutinfo.setLayoutCount = 2;
+    layoutinfo.pSetLayouts = sets;
+    layoutinfo.pushConstantRangeCount = 1;
+    layoutinfo.pPushConstantRanges = &push;
+    if (qvkCreatePipelineLayout(vk.device, &layoutinfo, NULL, &vk.layout) != VK_SUCCESS)
+        return qfalse;
+
+    /* gl_texturemode's default, and clamp-to-edge for lightmaps */
+    sampler.magFilter = VK_FILTER_LINEAR;
+    sampler.minFilter = VK_FILTER_LINEAR;
+    sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler.maxLod = VK_LOD_CLAMP_NONE;
+    if (qvkCreateSampler(vk.device, &sampler, NULL, &vk.sampler_repeat) != VK_SUCCESS)
+        return qfalse;
+    sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (qvkCreateSampler(vk.device, &sampler, NULL, &vk.sampler_clamp) != VK_SUCCESS)
+        return qfalse;
+
+    vk.world_vs = R_VK_ShaderModule(vk_world_vert, sizeof(vk_world_vert));
+    vk.world_fs = R_VK_ShaderModule(vk_world_frag, sizeof(vk_world_frag));
+    vk.ui_vs = R_VK_ShaderModule(vk_2d_vert, sizeof(vk_2d_vert));
+    vk.ui_fs = R_VK_ShaderModule(vk_2d_frag, sizeof(vk_2d_frag));
+    if (!vk.world_vs || !vk.world_fs || !vk.ui_vs || !vk.ui_fs)
+        return qfalse;
+
+    /* 2D: screen position, texcoord, byte color */
+    attrs[0].location = 0;
+    attrs[0].binding = 0;
+    attrs[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attrs[0].offset = offsetof(r_drawvert_t, xy);
+    attrs[1].location = 1;
+    attrs[1].binding = 0;
+    attrs[1].format = VK_FORMAT_R32G32_SFLOAT;
+    attrs[1].offset = offsetof(r_drawvert_t, st);
+    attrs[2].location = 2;
+    attrs[2].binding = 0;
+    attrs[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attrs[2].offset = offsetof(r_drawvert_t, rgba);
+    vk.ui = R_VK_BuildPipeline(vk.ui_vs, vk.ui_fs, attrs, 3, sizeof(r_drawvert_t),
+                               qfalse, qtrue);
+    return vk.ui != VK_NULL_HANDLE;
+}
+
+/* ==========================================================================
+   Swapchain
+   ========================================================================== */
+
+static void R_VK_DestroySwapchainViews(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < vk.numimages; i++) {
+        if (vk.framebuffers[i])
+            qvkDestroyFramebuffer(vk.device, vk.framebuffers[i], NULL);
+        if (vk.views[i])
+            qvkDestroyImageView(vk.device, vk.views[i], NULL);
+        if (vk.rendered[i])
+            qvkDestroySemaphore(vk.device, vk.rendered[i], NULL);
+        vk.framebuffers[i] = VK_NULL_HANDLE;
+        vk.views[i] = VK_NULL_HANDLE;
+        vk.rendered[i] = VK_NULL_HANDLE;
+    }
+    vk.numimages = 0;
+
+    if (vk.depth_view)
+        qvkDestroyImageView(vk.device, vk.depth_view, NULL);
+    if (vk.depth_image)
+        qvkDestroyImage(vk.device, vk.depth_image, NULL);
+    if (vk.depth_memory)
+        qvkFreeMemory(vk.device, vk.depth_memory, NULL);
+    vk.depth_view = VK_NULL_HANDLE;
+    vk.depth_image = VK_NULL_HANDLE;
+    vk.depth_memory = VK_NULL_HANDLE;
+}
+
+static qboolean R_VK_CreateDepth(void)
+{
+    VkImageCreateInfo       info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    VkImageViewCreateInfo   view = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    VkMemoryRequirements    req;
+
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = vk.depth_format;
+    info.extent.width = vk.extent.width;
+    info.extent.height = vk.extent.height;
+    info.extent.depth = 1;
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (qvkCreateImage(vk.device, &info, NULL, &vk.depth_image) != VK_SUCCESS)
+        return qfalse;
+
+    qvkGetImageMemoryRequirements(vk.device, vk.depth_image, &req);
+    if (!R_VK_AllocMemory(&req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, req.size, &vk.depth_memory) ||
+        qvkBindImageMemory(vk.device, vk.depth_image, vk.depth_memory, 0) != VK_SUCCESS)
+        return qfalse;
+
+    view.image = vk.depth_image;
+    view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view.format = vk.depth_format;
+    view.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    view.subresourceRange.levelCount = 1;
+    view.subresourceRange.layerCount = 1;
+    return qvkCreateImageView(vk.device, &view, NULL, &vk.depth_view) == VK_SUCCESS;
+}
+
+/*
+ * R_VK_CreateSwapchain - (Re)build the swapchain for the window's current
+ * size. qfalse with no swapchain while the window is minimized.
+ */
+static qboolean R_VK_CreateSwapchain(void)
+{
+    VkSurfaceCapabilitiesKHR    caps;
+    VkSwapchainCreateInfoKHR    info = { VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR };
+    VkSemaphoreCreateInfo       seminfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    VkSwapchainKHR              old = vk.swapchain;
+    uint32_t                    count, i;
+
+    qvkDeviceWaitIdle(vk.device);
+    R_VK_DestroySwapchainViews();
+    vk.swapchain = VK_NULL_HANDLE;
+    vk.recreate = qfalse;
+    vk.display_width = g_display.width;
+    vk.display_height = g_display.height;
+
+    if (qvkGetPhysicalDeviceSurfaceCapabilitiesKHR(vk.physical, vk.surface, &caps) != VK_SUCCESS)
+        goto fail;
+
+    vk.extent = caps.currentExtent;
+    if (vk.extent.width == 0xFFFFFFFF) {
+        vk.extent.width = (uint32_t)g_display.width;
+        vk.extent.height = (uint32_t)g_display.height;
+        if (vk.extent.width < caps.minImageExtent.width)
+            vk.extent.width = caps.minImageExtent.width;
+        if (vk.extent.width > caps.maxImageExtent.width)
+            vk.extent.width = caps.maxImageExtent.width;
+        if (vk.extent.height < caps.minImageExtent.height)
+            vk.extent.height = caps.minImageExtent.height;
+        if (vk.extent.height > caps.maxImageExtent.height)
+            vk.extent.height = caps.maxImageExtent.height;
+    }
+    if (!vk.extent.width || !vk.extent.height)
+        goto fail;
+
+    count = caps.minImageCount + 1;
+    if (caps.maxImageCount && count > caps.maxImageCount)
+        count = caps.maxImageCount;
+
+    info.surface = vk.surface;
+    info.minImageCount = count;
+    info.imageFormat = vk.surface_format.format;
+    info.imageColorSpace = vk.surface_format.colorSpace;
+    info.imageExtent = vk.extent;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = caps.currentTransform;
+    info.compositeAlpha = (caps.supportedCompositeAlpha & VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
+                              ? VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR
+                              : VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
+    info.presentMode = VK_PRESENT_MODE_FIFO_KHR;   /* vsync, as the GL path */
+    info.clipped = VK_TRUE;
+    info.oldSwapchain = old;
+    if (qvkCreateSwapchainKHR(vk.device, &info, NULL, &vk.swapchain) != VK_SUCCESS) {
+        vk.swapchain = VK_NULL_HANDLE;
+        goto fail;
+    }
+    if (old)
+        qvkDestroySwapchainKHR(vk.device, old, NULL);
+    old = VK_NULL_HANDLE;
+
+    count = 0;
+    qvkGetSwapchainImagesKHR(vk.device, vk.swapchain, &count, NULL);
+    if (count > VK_MAX_SWAPIMAGES)
+        goto fail;
+    qvkGetSwapchainImagesKHR(vk.device, vk.swapchain, &count, vk.images);
+    vk.numimages = count;
+
+    if (!R_VK_CreateDepth())
+        goto fail;
+
+    for (i = 0; i < count; i++) {
+        VkImageViewCreateInfo   view = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        VkFramebufferCreateInfo fb = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        VkImageView             attachments[2];
+
+        view.image = vk.images[i];
+        view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view.format = vk.surface_format.format;
+        view.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view.subresourceRange.levelCount = 1;
+        view.subresourceRange.layerCount = 1;
+        if (qvkCreateImageView(vk.device, &view, NULL, &vk.views[i]) != VK_SUCCESS)
+            goto fail;
+
+        attachments[0] = vk.views[i];
+        attachments[1] = vk.depth_view;
+        fb.renderPass = vk.renderpass;
+        fb.attachmentCount = 2;
+        fb.pAttachments = attachments;
+        fb.width = vk.extent.width;
+        fb.height = vk.extent.height;
+        fb.layers = 1;
+        if (qvkCreateFramebuffer(vk.device, &fb, NULL, &vk.framebuffers[i]) != VK_SUCCESS ||
+            qvkCreateSemaphore(vk.device, &seminfo, NULL, &vk.rendered[i]) != VK_SUCCESS)
+            goto fail;
+    }
+
+    return qtrue;
+
+fail:
+    if (old)
+        qvkDestroySwapchainKHR(vk.device, old, NULL);
+    R_VK_DestroySwapchainViews();
+    if (vk.swapchain)
+        qvkDestroySwapchainKHR(vk.device, vk.swapchain, NULL);
+    vk.swapchain = VK_NULL_HANDLE;
+    return qfalse;
+}
+
+static qboolean R_VK_CreateRenderPass(void)
+{
+    VkAttachmentDescription attachments[2];
+    VkAttachmentReference   color = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference   depth = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription    subpass;
+    VkSubpassDependency     dep;
+    VkRenderPassCreateInfo  info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+
+    memset(attachments, 0, sizeof(attachments));
+    attachments[0].format = vk.surface_format.format;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachments[1].format = vk.depth_format;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    memset(&subpass, 0, sizeof(subpass));
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color;
+    subpass.pDepthStencilAttachment = &depth;
+
+    /* The depth buffer is shared by both frames in flight: order its
+     * clear after the previous frame's writes, and the color writes after
+     * the acquire */
+    memset(&dep, 0, sizeof(dep));
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                       VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dep.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    info.attachmentCount = 2;
+    info.pAttachments = attachments;
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+    info.dependencyCount = 1;
+    info.pDependencies = &dep;
+    return qvkCreateRenderPass(vk.device, &info, NULL, &vk.renderpass) == VK_SUCCESS;
+}
+
+/* ==========================================================================
+   Frames
+   ========================================================================== */
+
+static qboolean R_VK_CreateFrames(void)
+{
+    VkFenceCreateInfo           fence = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    VkSemaphoreCreateInfo       sem = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    VkCommandPoolCreateInfo     pool = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    VkCommandBufferAllocateInfo alloc = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    VkCommandBuffer             cmds[2];
+    int                         i, j;
+
+    fence.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    pool.queueFamilyIndex = vk.queue_family;
+
+    for (i = 0; i < VK_FRAMES; i++) {
+        vkframe_t *f = &vk.frames[i];
+
+        if (qvkCreateFence(vk.device, &fence, NULL, &f->fence) != VK_SUCCESS ||
+            qvkCreateSemaphore(vk.device, &sem, NULL, &f->acquired) != VK_SUCCESS)
+            return qfalse;
+
+        /* The upload buffer is reset on its own when a load flushes it */
+        pool.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (qvkCreateCommandPool(vk.device, &pool, NULL, &f->pool) != VK_SUCCESS)
+            return qfalse;
+        alloc.commandPool = f->pool;
+        alloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc.commandBufferCount = 2;
+        if (qvkAllocateCommandBuffers(vk.device, &alloc, cmds) != VK_SUCCESS)
+            return qfalse;
+        f->primary = cmds[0];
+        f->upload = cmds[1];
+
+        pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        for (j = 0; j < VK_MAX_SECONDARIES; j++) {
+            if (qvkCreateCommandPool(vk.device, &pool, NULL, &f->secondary_pools[j]) != VK_SUCCESS)
+                return qfalse;
+            alloc.commandPool = f->secondary_pools[j];
+            alloc.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            alloc.commandBufferCount = 1;
+            if (qvkAllocateCommandBuffers(vk.device, &alloc, &f->secondaries[j]) != VK_SUCCESS)
+                return qfalse;
+        }
+
+        if (!R_VK_CreateBuffer(&f->stream, VK_STREAM_SIZE,
+                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                               qtrue) ||
+            !R_VK_CreateBuffer(&f->staging, VK_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                               qtrue))
+            return qfalse;
+    }
+
+    vk.frame = 0;
+    return qtrue;
+}
+
+static void R_VK_FreeDead(vkframe_t *f)
+{
+    int i;
+
+    for (i = 0; i < f->num_dead_textures; i++)
+        R_VK_DestroyTexture((GLuint)f->dead_textures[i]);
+    f->num_dead_textures = 0;
+    for (i = 0; i < f->num_dead_buffers; i++)
+        R_VK_DestroyBuffer(&f->dead_buffers[i]);
+    f->num_dead_buffers = 0;
+}
+
+/* Move to the next frame slot once the GPU is done with what it held */
+static void R_VK_NextFrame(void)
+{
+    vkframe_t   *f;
+    int         i;
+
+    vk.frame = (vk.frame + 1) % VK_FRAMES;
+    f = VK_FRAME();
+
+    qvkWaitForFences(vk.device, 1, &f->fence, VK_TRUE, UINT64_MAX);
+    for (i = 0; i < f->numsecondaries; i++)
+        qvkResetCommandPool(vk.device, f->secondary_pools[i], 0);
+    f->numsecondaries = 0;
+    f->stream_used = 0;
+    f->staging_used = 0;
+    R_VK_FreeDead(f);
+}
+
+static void R_VK_DestroyFrames(void)
+{
+    int i, j;
+
+    for (i = 0; i < VK_FRAMES; i++) {
+        vkframe_t *f = &vk.frames[i];
+
+        R_VK_FreeDead(f);
+        for (j = 0; j < VK_MAX_SECONDARIES; j++) {
+            if (f->secondary_pools[j])
+                qvkDestroyCommandPool(vk.device, f->secondary_pools[j], NULL);
+        }
+        if (f->pool)
+            qvkDestroyCommandPool(vk.device, f->pool, NULL);
+        if (f->acquired)
+            qvkDestroySemaphore(vk.device, f->acquired, NULL);
+        if (f->fence)
+            qvkDestroyFence(vk.device, f->fence, NULL);
+        R_VK_DestroyBuffer(&f->stream);
+        R_VK_DestroyBuffer(&f->staging);
+        memset(f, 0, sizeof(*f));
+    }
+}
+
+/* Hand out secondaries in execution order. *count may come back smaller;
+ * the return is the first index, -1 if none are left. */
+static int R_VK_AllocSecondaries(int *count)
+{
+    vkframe_t   *f = VK_FRAME();
+    int         first = f->numsecondaries;
+
+    if (*count > VK_MAX_SECONDARIES - first)
+        *count = VK_MAX_SECONDARIES - first;
+    if (*count <= 0) {
+        Com_DPrintf("VK: out of secondary command buffers this frame\n");
+        return -1;
+    }
+    f->numsecondaries += *count;
+    return first;
+}
+
+static VkCommandBuffer R_VK_BeginSecondary(int index)
+{
+    VkCommandBufferInheritanceInfo  inherit = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    VkCommandBufferBeginInfo        begin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    VkCommandBuffer                 cmd = VK_FRAME()->secondaries[index];
+
+    inherit.renderPass = vk.renderpass;
+    inherit.subpass = 0;
+    inherit.framebuffer = VK_NULL_HANDLE;   /* any of the swapchain's */
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                  VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin.pInheritanceInfo = &inherit;
+    qvkBeginCommandBuffer(cmd, &begin);
+    return cmd;
+}
+
+void *R_VK_StreamAlloc(int size, int *offset)
+{
+    vkframe_t   *f = VK_FRAME();
+    int         ofs = (f->stream_used + 15) & ~15;
+
+    if ((VkDeviceSize)(ofs + size) > f->stream.size) {
+        if (!vk.stream_warned) {
+            Com_Printf("VK: stream buffer full, dropping draws\n");
+            vk.stream_warned = qtrue;
+        }
+        return NULL;
+    }
+
+    f->stream_used = ofs + size;
+    *offset = ofs;
+    return f->stream.mapped + ofs;
+}
+
+/* ==========================================================================
+   View
+   ========================================================================== */
+
+/* Column-major, as GL keeps them: m[col * 4 + row] */
+static void R_VK_MatMul(float *out, const float *a, const float *b)
+{
+    float   r[16];
+    int     i, j;
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            r[i * 4 + j] = a[0 * 4 + j] * b[i * 4 + 0] + a[1 * 4 + j] * b[i * 4 + 1] +
+                           a[2 * 4 + j] * b[i * 4 + 2] + a[3 * 4 + j] * b[i * 4 + 3];
+    memcpy(out, r, sizeof(r));
+}
+
+/* m *= glRotatef(degrees) about the x (0), y (1) or z (2) axis */
+static void R_VK_Rotate(float *m, float degrees, int axis)
+{
+    float   r[16];
+    float   a = degrees * (float)(3.14159265 / 180.0);
+    float   c = (float)cos(a), s = (float)sin(a);
+    int     u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+    memset(r, 0, sizeof(r));
+    r[axis * 4 + axis] = 1.0f;
+    r[15] = 1.0f;
+    r[u * 4 + u] = c;
+    r[v * 4 + u] = -s;
+    r[u * 4 + v] = s;
+    r[v * 4 + v] = c;
+    R_VK_MatMul(m, m, r);
+}
+
+/*
+ * R_VK_SetView - Set up the matrices and viewport R_Setup3DProjection and
+ * R_Setup3DModelview would, for Vulkan's clip space (y down, depth 0..1),
+ * and clear the view's depth. fog is rgb + density, density 0 for none.
+ */
+void R_VK_SetView(const refdef_t *fd, const float *fog)
+{
+    float           proj[16], mv[16];
+    float           znear = 4.0f, zfar = 8192.0f;
+    float           xmax = znear * (float)tan(fd->fov_x * 3.14159265 / 360.0);
+    float           ymax = znear * (float)tan(fd->fov_y * 3.14159265 / 360.0);
+    float           sx = g_display.width ? (float)vk.extent.width / g_display.width : 1.0f;
+    float           sy = g_display.height ? (float)vk.extent.height / g_display.height : 1.0f;
+    VkClearAttachment clear;
+    VkClearRect     rect;
+    VkCommandBuffer cmd;
+    int             x0, y0, x1, y1, n = 1, index;
+
+    memset(proj, 0, sizeof(proj));
+    proj[0] = znear / xmax;
+    proj[5] = -znear / ymax;
+    proj[10] = -zfar / (zfar - znear);
+    proj[11] = -1.0f;
+    proj[14] = -zfar * znear / (zfar - znear);
+
+    /* Q2 Z-up to GL Y-up, then the view, as R_Setup3DModelview */
+    memset(mv, 0, sizeof(mv));
+    mv[0] = mv[5] = mv[10] = mv[15] = 1.0f;
+    R_VK_Rotate(mv, -90, 0);
+    R_VK_Rotate(mv, 90, 2);
+    R_VK_Rotate(mv, -fd->viewangles[2], 0);
+    R_VK_Rotate(mv, -fd->viewangles[0], 1);
+    R_VK_Rotate(mv, -fd->viewangles[1], 2);
+    mv[12] -= mv[0] * fd->vieworg[0] + mv[4] * fd->vieworg[1] + mv[8] * fd->vieworg[2];
+    mv[13] -= mv[1] * fd->vieworg[0] + mv[5] * fd->vieworg[1] + mv[9] * fd->vieworg[2];
+    mv[14] -= mv[2] * fd->vieworg[0] + mv[6] * fd->vieworg[1] + mv[10] * fd->vieworg[2];
+
+    R_VK_MatMul(vk.view.mvp, proj, mv);
+    memcpy(vk.view.fog, fog, sizeof(vk.view.fog));
+    VectorCopy(fd->vieworg, vk.view.vieworg);
+    vk.view.vieworg[3] = (float)Sys_Milliseconds() * 0.001f;
+
+    /* refdef rects are in window units; the swapchain may be larger */
+    x0 = (int)(fd->x * sx);
+    y0 = (int)(fd->y * sy);
+    x1 = (int)((fd->x + fd->width) * sx);
+    y1 = (int)((fd->y + fd->height) * sy);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > (int)vk.extent.width) x1 = (int)vk.extent.width;
+    if (y1 > (int)vk.extent.height) y1 = (int)vk.extent.height;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+
+    vk.viewport.x = (float)x0;
+    vk.viewport.y = (float)y0;
+    vk.viewport.width = (float)(x1 - x0);
+    vk.viewport.height = (float)(y1 - y0);
+    vk.viewport.minDepth = 0.0f;
+    vk.viewport.maxDepth = 1.0f;
+    vk.scissor.offset.x = x0;
+    vk.scissor.offset.y = y0;
+    vk.scissor.extent.width = (uint32_t)(x1 - x0);
+    vk.scissor.extent.height = (uint32_t)(y1 - y0);
+
+    if (!vk.swapchain || x1 == x0 || y1 == y0 || (index = R_VK_AllocSecondaries(&n)) < 0)
+        return;
+
+    cmd = R_VK_BeginSecondary(index);
+    memset(&clear, 0, sizeof(clear));
+    clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    clear.clearValue.depthStencil.depth = 1.0f;
+    rect.rect = vk.scissor;
+    rect.baseArrayLayer = 0;
+    rect.layerCount = 1;
+    qvkCmdClearAttachments(cmd, 1, &clear, 1, &rect);
+    qvkEndCommandBuffer(cmd);
+}
+
+/* The current view's clip matrix, for r_surf.c's frustum */
+void R_VK_ViewMatrix(float *clip)
+{
+    memcpy(clip, vk.view.mvp, sizeof(vk.view.mvp));
+}
+
+/* ==========================================================================
+   World
+   ========================================================================== */
+
+qboolean R_VK_CreateWorldBuffer(const void *verts, int size, int stride, int st_ofs, int lm_ofs)
+{
+    VkBufferMemoryBarrier   barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    VkBufferCopy            region;
+    VkDeviceSize            offset;
+    VkCommandBuffer         cmd;
+    byte                    *staged;
+
+    R_VK_FreeWorldBuffer();
+    if (!R_VK_BuildWorldPipelines(stride, st_ofs, lm_ofs))
+        return qfalse;
+    if (!R_VK_CreateBuffer(&vk.world_verts, size,
+                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           qfalse)) {
+        Com_Printf("VK: couldn't create the world vertex buffer\n");
+        return qfalse;
+    }
+    if (!(staged = R_VK_StagingAlloc(size, &offset))) {
+        R_VK_DestroyBuffer(&vk.world_verts);
+        return qfalse;
+    }
+    memcpy(staged, verts, size);
+
+    cmd = R_VK_UploadCmd();
+    region.srcOffset = offset;
+    region.dstOffset = 0;
+    region.size = size;
+    qvkCmdCopyBuffer(cmd, VK_FRAME()->staging.buffer, vk.world_verts.buffer, 1, &region);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = vk.world_verts.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    qvkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                          0, 0, NULL, 1, &barrier, 0, NULL);
+    return qtrue;
+}
+
+void R_VK_FreeWorldBuffer(void)
+{
+    vkframe_t *f = VK_FRAME();
+
+    if (!vk.world_verts.buffer)
+        return;
+    if (f->num_dead_buffers == VK_MAX_DEAD_BUFFERS) {
+        qvkDeviceWaitIdle(vk.device);
+        R_VK_FreeDead(f);
+    }
+    f->dead_buffers[f->num_dead_buffers++] = vk.world_verts;
+    memset(&vk.world_verts, 0, sizeof(vk.world_verts));
+}
+
+void R_VK_BeginWorld(void)
+{
+    memset(&vk_world.cur, 0, sizeof(vk_world.cur));
+    vk_world.cur.push.color[0] = vk_world.cur.push.color[1] = 1.0f;
+    vk_world.cur.push.color[2] = vk_world.cur.push.color[3] = 1.0f;
+    vk_world.cur.push.alpharef = -1.0f;
+    vk_world.numdraws = 0;
+}
+
+void R_VK_SetMaterial(GLuint texture, GLuint lightmap, const float *color, qboolean warp)
+{
+    vk_world.cur.texture = texture;
+    vk_world.cur.lightmap = lightmap;
+    memcpy(vk_world.cur.push.color, color, sizeof(vk_world.cur.push.color));
+    vk_world.cur.push.warp = warp ? 1 : 0;
+}
+
+void R_VK_SetAlphaRef(float ref)
+{
+    vk_world.cur.push.alpharef = ref;
+}
+
+void R_VK_SetBlend(qboolean blend)
+{
+    vk_world.cur.blend = blend;
+}
+
+/* offset is in bytes into this frame's stream, from R_VK_StreamAlloc */
+void R_VK_DrawIndexed(int offset, int count)
+{
+    vkdraw_t *d;
+
+    if (count <= 0)
+        return;
+    if (vk_world.numdraws == vk_world.maxdraws) {
+        int         max = vk_world.maxdraws ? vk_world.maxdraws * 2 : 1024;
+        vkdraw_t    *draws = (vkdraw_t *)Z_Malloc(max * sizeof(vkdraw_t));
+
+        if (vk_world.draws) {
+            memcpy(draws, vk_world.draws, vk_world.numdraws * sizeof(vkdraw_t));
+            Z_Free(vk_world.draws);
+        }
+        vk_world.draws = draws;
+        vk_world.maxdraws = max;
+    }
+
+    d = &vk_world.draws[vk_world.numdraws++];
+    *d = vk_world.cur;
+    d->firstindex = (uint32_t)(offset / (int)sizeof(uint32_t));
+    d->numindices = (uint32_t)count;
+}
+
+typedef struct {
+    int     first;          /* secondary of chunk 0 */
+    int     chunksize;
+} vkworldjob_t;
+
+/* Record one contiguous run of the world draws. Safe to run as a job: it
+ * only reads shared state, and its command buffer's pool is its own. */
+static void R_VK_RecordWorldJob(void *ctx, int chunk)
+{
+    vkworldjob_t    *job = (vkworldjob_t *)ctx;
+    VkCommandBuffer cmd = R_VK_BeginSecondary(job->first + chunk);
+    VkDeviceSize    zero = 0;
+    VkPipeline      bound = VK_NULL_HANDLE;
+    GLuint          texture = (GLuint)-1, lightmap = (GLuint)-1;
+    int             i = chunk * job->chunksize;
+    int             end = i + job->chunksize < vk_world.numdraws ? i + job->chunksize
+                                                                 : vk_world.numdraws;
+
+    qvkCmdSetViewport(cmd, 0, 1, &vk.viewport);
+    qvkCmdSetScissor(cmd, 0, 1, &vk.scissor);
+    qvkCmdBindVertexBuffers(cmd, 0, 1, &vk.world_verts.buffer, &zero);
+    qvkCmdBindIndexBuffer(cmd, VK_FRAME()->stream.buffer, 0, VK_INDEX_TYPE_UINT32);
+    qvkCmdPushConstants(cmd, vk.layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0, sizeof(vkviewpush_t), &vk.view);
+
+    for (; i < end; i++) {
+        const vkdraw_t  *d = &vk_world.draws[i];
+        VkPipeline      pipeline = d->blend ? vk.world_blend : vk.world_opaque;
+
+        if (pipeline != bound) {
+            qvkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            bound = pipeline;
+        }
+        if (d->texture != texture || d->lightmap != lightmap) {
+            VkDescriptorSet sets[2];
+
+            sets[0] = R_VK_TextureSet(d->texture);
+            sets[1] = R_VK_TextureSet(d->lightmap);
+            qvkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk.layout, 0, 2, sets,
+                                     0, NULL);
+            texture = d->texture;
+            lightmap = d->lightmap;
+        }
+        qvkCmdPushConstants(cmd, vk.layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                            sizeof(vkviewpush_t), sizeof(vkdrawpush_t), &d->push);
+        qvkCmdDrawIndexed(cmd, d->numindices, 1, d->firstindex, 0, 0);
+    }
+
+    qvkEndCommandBuffer(cmd);
+}
+
+/*
+ * R_VK_EndWorld - Record the queued draws. Large lists are cut into runs,
+ * one per job thread, each into a secondary of its own; the secondaries
+ * run in list order, which keeps the blend pass sorted.
+ */
+void R_VK_EndWorld(void)
+{
+    vkworldjob_t    job;
+    int             numchunks = 1;
+
+    if (!vk_world.numdraws || !vk.swapchain || !vk.world_verts.buffer || !vk.world_opaque)
+        return;
+
+    if (vk_world.numdraws >= VK_WORLD_JOB_MINDRAWS * 2) {
+        numchunks = Job_Threads();
+        if (numchunks > VK_WORLD_MAX_CHUNKS)
+            numchunks = VK_WORLD_MAX_CHUNKS;
+        if (numchunks > vk_world.numdraws / VK_WORLD_JOB_MINDRAWS)
+            numchunks = vk_world.numdraws / VK_WORLD_JOB_MINDRAWS;
+    }
+    if ((job.first = R_VK_AllocSecondaries(&numchunks)) < 0)
+        return;
+    job.chunksize = (vk_world.numdraws + numchunks - 1) / numchunks;
+
+    Job_ParallelFor("R_VK_RecordWorld", R_VK_RecordWorldJob, &job, numchunks);
+    vk_world.numdraws = 0;
+}
+
+/* ==========================================================================
+   2D
+   ========================================================================== */
+
+void R_VK_Draw2D(const r_drawvert_t *verts, int numverts, const r_2dbatch_t *batches,
+                 int numbatches)
+{
+    int             size = numverts * (int)sizeof(r_drawvert_t);
+    int             offset, index, n = 1, i;
+    r_drawvert_t    *stream;
+    VkCommandBuffer cmd;
+    VkDeviceSize    ofs;
+    VkViewport      viewport;
+    VkRect2D        scissor;
+    float           ortho[16];
+
+    if (!vk.swapchain || !(stream = R_VK_StreamAlloc(size, &offset)))
+        return;
+    if ((index = R_VK_AllocSecondaries(&n)) < 0)
+        return;
+    memcpy(stream, verts, size);
+
+    /* Window pixels, y down, onto the whole swapchain */
+    memset(ortho, 0, sizeof(ortho));
+    ortho[0] = 2.0f / (g_display.width ? g_display.width : 1);
+    ortho[5] = 2.0f / (g_display.height ? g_display.height : 1);
+    ortho[10] = 1.0f;
+    ortho[12] = -1.0f;
+    ortho[13] = -1.0f;
+    ortho[15] = 1.0f;
+
+    viewport.x = viewport.y = 0.0f;
+    viewport.width = (float)vk.extent.width;
+    viewport.height = (float)vk.extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    scissor.offset.x = scissor.offset.y = 0;
+    scissor.extent = vk.extent;
+
+    cmd = R_VK_BeginSecondary(index);
+    ofs = (VkDeviceSize)offset;
+    qvkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk.ui);
+    qvkCmdSetViewport(cmd, 0, 1, &viewport);
+    qvkCmdSetScissor(cmd, 0, 1, &scissor);
+    qvkCmdBindVertexBuffers(cmd, 0, 1, &VK_FRAME()->stream.buffer, &ofs);
+    qvkCmdPushConstants(cmd, vk.layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0, sizeof(ortho), ortho);
+
+    for (i = 0; i < numbatches; i++) {
+        VkDescriptorSet set = R_VK_TextureSet(batches[i].texnum);
+
+        qvkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vk.layout, 0, 1, &set,
+                                 0, NULL);
+        qvkCmdDraw(cmd, (uint32_t)batches[i].count, 1, (uint32_t)batches[i].first, 0);
+        c_brush_polys++;
+    }
+
+    qvkEndCommandBuffer(cmd);
+}
+
+/* ==========================================================================
+   Frame
+   ========================================================================== */
+
+void R_VK_BeginFrame(void)
+{
+    if (vk.display_width != g_display.width || vk.display_height != g_display.height)
+        vk.recreate = qtrue;
+    if (vk.recreate || !vk.swapchain)
+        R_VK_CreateSwapchain();
+}
+
+/*
+ * R_VK_EndFrame - Run this frame's secondaries in one render pass and
+ * present it, then move to the next slot. The upload buffer goes in the
+ * same submit, ahead of the frame.
+ */
+void R_VK_EndFrame(void)
+{
+    vkframe_t               *f = VK_FRAME();
+    VkSubmitInfo            submits[2];
+    VkPipelineStageFlags    wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    uint32_t                index = 0;
+    int                     numsubmits = 0;
+    qboolean                acquired = qfalse;
+    VkResult                result;
+
+    memset(submits, 0, sizeof(submits));
+
+    if (vk.swapchain) {
+        result = qvkAcquireNextImageKHR(vk.device, vk.swapchain, UINT64_MAX, f->acquired,
+                                        VK_NULL_HANDLE, &index);
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+            acquired = qtrue;
+        if (result != VK_SUCCESS)
+            vk.recreate = qtrue;    /* this frame's secondaries are dropped */
+    }
+
+    if (f->uploading) {
+        qvkEndCommandBuffer(f->upload);
+        submits[numsubmits].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submits[numsubmits].commandBufferCount = 1;
+        submits[numsubmits].pCommandBuffers = &f->upload;
+        numsubmits++;
+        f->uploading = qfalse;
+    }
+
+    if (acquired) {
+        VkCommandBufferBeginInfo    begin = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        VkRenderPassBeginInfo       pass = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+        VkClearValue                clears[2];
+
+        /* R_BeginFrame's clear color */
+        memset(clears, 0, sizeof(clears));
+        clears[0].color.float32[0] = 0.1f;
+        clears[0].color.float32[1] = 0.1f;
+        clears[0].color.float32[2] = 0.15f;
+        clears[0].color.float32[3] = 1.0f;
+        clears[1].depthStencil.depth = 1.0f;
+
+        begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        qvkBeginCommandBuffer(f->primary, &begin);
+        pass.renderPass = vk.renderpass;
+        pass.framebuffer = vk.framebuffers[index];
+        pass.renderArea.extent = vk.extent;
+        pass.clearValueCount = 2;
+        pass.pClearValues = clears;
+        qvkCmdBeginRenderPass(f->primary, &pass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        if (f->numsecondaries)
+            qvkCmdExecuteCommands(f->primary, (uint32_t)f->numsecondaries, f->secondaries);
+        qvkCmdEndRenderPass(f->primary);
+        qvkEndCommandBuffer(f->primary);
+
+        submits[numsubmits].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submits[numsubmits].waitSemaphoreCount = 1;
+        submits[numsubmits].pWaitSemaphores = &f->acquired;
+        submits[numsubmits].pWaitDstStageMask = &wait_stage;
+        submits[numsubmits].commandBufferCount = 1;
+        submits[numsubmits].pCommandBuffers = &f->primary;
+        submits[numsubmits].signalSemaphoreCount = 1;
+        submits[numsubmits].pSignalSemaphores = &vk.rendered[index];
+        numsubmits++;
+    }
+
+    /* Always submitted with the fence, even empty, so the slot comes back */
+    qvkResetFences(vk.device, 1, &f->fence);
+    result = qvkQueueSubmit(vk.queue, (uint32_t)numsubmits, submits, f->fence);
+    if (result != VK_SUCCESS)
+        Com_Error(ERR_FATAL, "R_VK_EndFrame: vkQueueSubmit failed (%d)", (int)result);
+
+    if (acquired) {
+        VkPresentInfoKHR present = { VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+
+        present.waitSemaphoreCount = 1;
+        present.pWaitSemaphores = &vk.rendered[index];
+        present.swapchainCount = 1;
+        present.pSwapchains = &vk.swapchain;
+        present.pImageIndices = &index;
+        result = qvkQueuePresentKHR(vk.queue, &present);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+            vk.recreate = qtrue;
+    }
+
+    R_VK_NextFrame();
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+/* Called before the window exists */
+void R_VK_RequestWindow(void)
+{
+    r_vulkan = Cvar_Get("r_vulkan", "1", CVAR_ARCHIVE | CVAR_LATCH);
+    Sys_RequestVulkanWindow(r_vulkan->value != 0);
+}
+
+static qboolean R_VK_CreateInstance(void)
+{
+    VkApplicationInfo       app = { VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    VkInstanceCreateInfo    info = { VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    const char              **exts;
+    unsigned int            count = 0;
+    qboolean                ok;
+
+    qvkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)SDL_Vulkan_GetVkGetInstanceProcAddr();
+    if (!qvkGetInstanceProcAddr) {
+        Com_Printf("VK: no Vulkan loader (%s)\n", SDL_GetError());
+        return qfalse;
+    }
+    qvkCreateInstance = (PFN_vkCreateInstance)qvkGetInstanceProcAddr(VK_NULL_HANDLE,
+                                                                      "vkCreateInstance");
+    if (!qvkCreateInstance ||
+        !SDL_Vulkan_GetInstanceExtensions(g_display.window, &count, NULL))
+        return qfalse;
+
+    exts = (const char **)Z_Malloc(count * sizeof(char *));
+    SDL_Vulkan_GetInstanceExtensions(g_display.window, &count, exts);
+
+    app.pApplicationName = "Soldier of Fortune";
+    app.pEngineName = "sof-recomp";
+    app.apiVersion = VK_API_VERSION_1_0;
+    info.pApplicationInfo = &app;
+    info.enabledExtensionCount = count;
+    info.ppEnabledExtensionNames = exts;
+    ok = qvkCreateInstance(&info, NULL, &vk.instance) == VK_SUCCESS;
+    Z_Free((void *)exts);
+
+    if (!ok) {
+        vk.instance = VK_NULL_HANDLE;
+        Com_Printf("VK: vkCreateInstance failed\n");
+        return qfalse;
+    }
+    return R_VK_LoadInstanceFunctions();
+}
+
+/* The first device that can draw to the window; a discrete GPU if any */
+static qboolean R_VK_PickDevice(void)
+{
+    VkPhysicalDevice    devices[16];
+    uint32_t            count = 16, i, q;
+    int                 best_score = -1;
+
+    if (qvkEnumeratePhysicalDevices(vk.instance, &count, devices) < 0 || !count)
+        return qfalse;
+
+    for (i = 0; i < count; i++) {
+        VkQueueFamilyProperties     families[16];
+        VkPhysicalDeviceProperties  props;
+        uint32_t                    numfamilies = 16;
+        int                         score;
+
+        qvkGetPhysicalDeviceProperties(devices[i], &props);
+        qvkGetPhysicalDeviceQueueFamilyProperties(devices[i], &numfamilies, families);
+
+        for (q = 0; q < numfamilies; q++) {
+            VkBool32 present = VK_FALSE;
+
+            if (!(families[q].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+                continue;
+            qvkGetPhysicalDeviceSurfaceSupportKHR(devices[i], q, vk.surface, &present);
+            if (present)
+                break;
+        }
+        if (q == numfamilies)
+            continue;
+
+        score = props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 2 :
+                props.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 1 : 0;
+        if (score > best_score) {
+            best_score = score;
+            vk.physical = devices[i];
+            vk.queue_family = q;
+        }
+    }
+
+    return best_score >= 0;
+}
+
+static qboolean R_VK_CreateDevice(void)
+{
+    static const char           *exts[1] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    static const VkFormat       depths[3] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT,
+                                              VK_FORMAT_D16_UNORM };
+    float                       priority = 1.0f;
+    VkDeviceQueueCreateInfo     queue = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+    VkDeviceCreateInfo          info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    VkPhysicalDeviceFeatures    supported, features;
+    VkSurfaceFormatKHR          formats[64];
+    uint32_t                    count = 64, i;
+
+    qvkGetPhysicalDeviceFeatures(vk.physical, &supported);
+    memset(&features, 0, sizeof(features));
+    features.textureCompressionBC = supported.textureCompressionBC;
+    vk.bc = supported.textureCompressionBC == VK_TRUE;
+
+    queue.queueFamilyIndex = vk.queue_family;
+    queue.queueCount = 1;
+    queue.pQueuePriorities = &priority;
+    info.queueCreateInfoCount = 1;
+    info.pQueueCreateInfos = &queue;
+    info.enabledExtensionCount = 1;
+    info.ppEnabledExtensionNames = exts;
+    info.pEnabledFeatures = &features;
+    if (qvkCreateDevice(vk.physical, &info, NULL, &vk.device) != VK_SUCCESS) {
+        vk.device = VK_NULL_HANDLE;
+        return qfalse;
+    }
+    if (!R_VK_LoadDeviceFunctions())
+        return qfalse;
+    qvkGetDeviceQueue(vk.device, vk.queue_family, 0, &vk.queue);
+    qvkGetPhysicalDeviceMemoryProperties(vk.physical, &vk.memprops);
+
+    /* Plain UNORM: the GL path writes its colors without sRGB encoding */
+    if (qvkGetPhysicalDeviceSurfaceFormatsKHR(vk.physical, vk.surface, &count, formats) < 0 ||
+        !count)
+        return qfalse;
+    vk.surface_format = formats[0];
+    if (count == 1 && formats[0].format == VK_FORMAT_UNDEFINED)
+        vk.surface_format.format = VK_FORMAT_B8G8R8A8_UNORM;
+    for (i = 0; i < count; i++) {
+        if (formats[i].format == VK_FORMAT_B8G8R8A8_UNORM ||
+            formats[i].format == VK_FORMAT_R8G8B8A8_UNORM) {
+            vk.surface_format = formats[i];
+            break;
+        }
+    }
+
+    vk.depth_format = VK_FORMAT_UNDEFINED;
+    for (i = 0; i < 3; i++) {
+        VkFormatProperties props;
+
+        qvkGetPhysicalDeviceFormatProperties(vk.physical, depths[i], &props);
+        if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            vk.depth_format = depths[i];
+            break;
+        }
+    }
+    return vk.depth_format != VK_FORMAT_UNDEFINED;
+}
+
+qboolean R_VK_Init(void)
+{
+    VkPhysicalDeviceProperties  props;
+    byte                        white[4] = { 255, 255, 255, 255 };
+
+    gl_state.vk = qfalse;
+    if (!r_vulkan || !r_vulkan->value || !g_display.window)
+        return qfalse;
+
+    memset(&vk, 0, sizeof(vk));
+    if (!R_VK_CreateInstance())
+        goto fail;
+    if (!SDL_Vulkan_CreateSurface(g_display.window, vk.instance, &vk.surface)) {
+        Com_Printf("VK: couldn't create a surface (%s)\n", SDL_GetError());
+        vk.surface = VK_NULL_HANDLE;
+        goto fail;
+    }
+    if (!R_VK_PickDevice()) {
+        Com_Printf("VK: no device can present to this window\n");
+        goto fail;
+    }
+    if (!R_VK_CreateDevice() || !R_VK_CreateRenderPass() || !R_VK_CreatePipelines() ||
+        !R_VK_CreateFrames()) {
+        Com_Printf("VK: device setup failed\n");
+        goto fail;
+    }
+    if (!R_VK_CreateSwapchain()) {
+        Com_Printf("VK: couldn't create a swapchain\n");
+        goto fail;
+    }
+
+    /* Stands in for a missing texture or lightmap */
+    vk.white = R_VK_CreateTexture(1, 1, 1, GL_RGBA8, qtrue);
+    if (!vk.white)
+        goto fail;
+    R_VK_TextureLevel(vk.white, 0, 1, 1, GL_RGBA, white);
+
+    qvkGetPhysicalDeviceProperties(vk.physical, &props);
+    gl_state.vk = qtrue;
+    gl_state.have_s3tc = vk.bc;
+    gl_state.vendor_string = "Vulkan";
+    gl_state.renderer_string = NULL;
+    Com_Printf("...using Vulkan: %s, %d frames in flight%s\n", props.deviceName, VK_FRAMES,
+               vk.bc ? ", BC textures" : "");
+    return qtrue;
+
+fail:
+    R_VK_Shutdown();
+    return qfalse;
+}
+
+void R_VK_Shutdown(void)
+{
+    int i;
+
+    if (vk.device) {
+        qvkDeviceWaitIdle(vk.device);
+
+        R_VK_DestroyFrames();
+        for (i = 1; i < VK_MAX_TEXTURES; i++) {
+            if (vk.textures[i].used)
+                R_VK_DestroyTexture((GLuint)i);
+        }
+        for (i = 0; i < vk.numblocks; i++) {
+            if (vk.blocks[i].memory)
+                qvkFreeMemory(vk.device, vk.blocks[i].memory, NULL);
+        }
+        R_VK_DestroyBuffer(&vk.world_verts);
+
+        R_VK_DestroySwapchainViews();
+        if (vk.swapchain)
+            qvkDestroySwapchainKHR(vk.device, vk.swapchain, NULL);
+        R_VK_DestroyWorldPipelines();
+        if (vk.ui)
+            qvkDestroyPipeline(vk.device, vk.ui, NULL);
+        if (vk.world_vs) qvkDestroyShaderModule(vk.device, vk.world_vs, NULL);
+        if (vk.world_fs) qvkDestroyShaderModule(vk.device, vk.world_fs, NULL);
+        if (vk.ui_vs) qvkDestroyShaderModule(vk.device, vk.ui_vs, NULL);
+        if (vk.ui_fs) qvkDestroyShaderModule(vk.device, vk.ui_fs, NULL);
+        if (vk.layout)
+            qvkDestroyPipelineLayout(vk.device, vk.layout, NULL);
+        if (vk.set_pool)
+            qvkDestroyDescriptorPool(vk.device, vk.set_pool, NULL);
+        if (vk.set_layout)
+            qvkDestroyDescriptorSetLayout(vk.device, vk.set_layout, NULL);
+        if (vk.sampler_repeat)
+            qvkDestroySampler(vk.device, vk.sampler_repeat, NULL);
+        if (vk.sampler_clamp)
+            qvkDestroySampler(vk.device, vk.sampler_clamp, NULL);
+        if (vk.renderpass)
+            qvkDestroyRenderPass(vk.device, vk.renderpass, NULL);
+        qvkDestroyDevice(vk.device, NULL);
+    }
+    if (vk.surface)
+        qvkDestroySurfaceKHR(vk.instance, vk.surface, NULL);
+    if (vk.instance)
+        qvkDestroyInstance(vk.instance, NULL);
+
+    if (vk_world.draws)
+        Z_Free(vk_world.draws);
+    memset(&vk_world, 0, sizeof(vk_world));
+    memset(&vk, 0, sizeof(vk));
+    gl_state.vk = qfalse;
+}
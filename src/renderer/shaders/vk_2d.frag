@@ -0,0 +1,13 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D u_diffuse;
+
+layout(location = 0) in vec2 v_st;
+layout(location = 1) in vec4 v_color;
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    o_color = v_color * texture(u_diffuse, v_st);
+}
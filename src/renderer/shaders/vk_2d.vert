@@ -0,0 +1,21 @@
+#version 450
+
+// HUD and console quads from r_draw.c, in screen pixels
+
+layout(push_constant) uniform Draw {
+    mat4    mvp;            // pixels to clip space
+} pc;
+
+layout(location = 0) in vec2 a_pos;
+layout(location = 1) in vec2 a_st;
+layout(location = 2) in vec4 a_color;
+
+layout(location = 0) out vec2 v_st;
+layout(location = 1) out vec4 v_color;
+
+void main()
+{
+    v_st = a_st;
+    v_color = a_color;
+    gl_Position = pc.mvp * vec4(a_pos, 0.0, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 450
+
+// Untextured and unlit faces are bound to a white texture, so every face
+// takes the same path.
+
+layout(push_constant) uniform Draw {
+    mat4    mvp;
+    vec4    fog;
+    vec4    vieworg;
+    vec4    color;
+    float   alpharef;
+    int     warp;
+} pc;
+
+layout(set = 0, binding = 0) uniform sampler2D u_diffuse;
+layout(set = 1, binding = 0) uniform sampler2D u_lightmap;
+
+layout(location = 0) in vec2 v_st;
+layout(location = 1) in vec2 v_lm;
+layout(location = 2) in float v_dist;
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+    vec4 c = pc.color * texture(u_diffuse, v_st);
+
+    c.rgb *= texture(u_lightmap, v_lm).rgb;
+    if (c.a <= pc.alpharef)
+        discard;
+
+    // GL_EXP2, as R_RenderFrame sets it up
+    if (pc.fog.w > 0.0) {
+        float f = exp(-pow(pc.fog.w * v_dist, 2.0));
+        c.rgb = mix(pc.fog.rgb, c.rgb, clamp(f, 0.0, 1.0));
+    }
+
+    o_color = c;
+}
@@ -0,0 +1,38 @@
+#version 450
+
+// World faces for r_vk.c: the GL4 world shader, with the matrices and
+// material in push constants instead of the compatibility built-ins.
+
+layout(push_constant) uniform Draw {
+    mat4    mvp;
+    vec4    fog;            // rgb, density (0 = off)
+    vec4    vieworg;        // xyz, time in seconds
+    vec4    color;
+    float   alpharef;       // < 0: no alpha test
+    int     warp;
+} pc;
+
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec2 a_st;
+layout(location = 2) in vec2 a_lm;
+
+layout(location = 0) out vec2 v_st;
+layout(location = 1) out vec2 v_lm;
+layout(location = 2) out float v_dist;
+
+void main()
+{
+    vec3 p = a_pos;
+    vec2 st = a_st;
+
+    if (pc.warp != 0) {
+        st += 0.05 * sin(a_pos.yx * 0.05 + pc.vieworg.w * 2.0);
+        p.z += 2.0 * sin(a_pos.x * 0.03 + pc.vieworg.w * 1.5)
+             + 2.0 * sin(a_pos.y * 0.03 + pc.vieworg.w * 1.2);
+    }
+
+    v_st = st;
+    v_lm = a_lm;
+    v_dist = length(p - pc.vieworg.xyz);
+    gl_Position = pc.mvp * vec4(p, 1.0);
+}
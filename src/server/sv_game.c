@@ -227,7 +227,16 @@ static int GI_modelindex(const char *name)
 
 static int GI_soundindex(const char *name)
 {
-    return SV_FindIndex(name, CS_SOUNDS, MAX_SOUNDS);
+    int index = SV_FindIndex(name, CS_SOUNDS, MAX_SOUNDS);
+
+    /* Precache: start loading it now rather than on first playback */
+    if (index > 0 && name[0]) {
+        Prof_MapLoadBegin(LOAD_SOUNDS);
+        S_RegisterSound(name);
+        Prof_MapLoadEnd();
+    }
+
+    return index;
 }
 
 static int GI_imageindex(const char *name)
@@ -242,6 +251,14 @@ extern void SV_UnlinkEdict(edict_t *ent);
 extern int  SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list,
                           int maxcount, int areatype);
 extern void SV_ClearWorld(void);
+extern void SV_SetWorldBounds(vec3_t mins, vec3_t maxs);
+extern void SV_NavLoad(void);
+extern void SV_NavShutdown(void);
+extern void SV_NavExposeCovers(void);
+extern int  SV_NavPath(vec3_t start, vec3_t end, vec3_t *points, int max);
+extern qboolean SV_NavCover(vec3_t origin, vec3_t threat, float mindist, float maxdist,
+                            vec3_t out);
+extern void SV_NavAddCover(vec3_t origin);
 
 static void GI_setmodel(edict_t *ent, const char *name)
 {
@@ -371,12 +388,57 @@ static qboolean SV_ClipTraceToEntity(trace_t *tr, vec3_t start, vec3_t mins, vec
     }
 }
 
+/*
+ * SV_ClipTraceToEntities — Clip a world trace against every solid entity
+ * along it. Only reads entity and world state, so batched traces run it
+ * on the job threads.
+ */
+static void SV_ClipTraceToEntities(trace_t *tr, vec3_t start, vec3_t mins, vec3_t maxs,
+                                   vec3_t end, edict_t *passent, int contentmask)
+{
+    edict_t *touch[64];
+    int num_touch, i;
+    vec3_t trace_mins, trace_maxs;
+
+    /* Build AABB encompassing entire trace */
+    for (i = 0; i < 3; i++) {
+        if (start[i] < end[i]) {
+            trace_mins[i] = start[i] + (mins ? mins[i] : 0);
+            trace_maxs[i] = end[i] + (maxs ? maxs[i] : 0);
+        } else {
+            trace_mins[i] = end[i] + (mins ? mins[i] : 0);
+            trace_maxs[i] = start[i] + (maxs ? maxs[i] : 0);
+        }
+    }
+
+    num_touch = SV_AreaEdicts(trace_mins, trace_maxs, touch, 64, AREA_SOLID);
+
+    for (i = 0; i < num_touch; i++) {
+        edict_t *ent = touch[i];
+
+        if (!ent || ent == passent || !ent->inuse)
+            continue;
+
+        /* Skip non-solid entities */
+        if (ent->solid == SOLID_NOT || ent->solid == SOLID_TRIGGER)
+            continue;
+
+        /* Skip owner */
+        if (passent && ent->owner == passent)
+            continue;
+
+        SV_ClipTraceToEntity(tr, start, mins, maxs, end, ent, contentmask);
+    }
+}
+
 static trace_t GI_trace(vec3_t start, vec3_t mins, vec3_t maxs,
                         vec3_t end, edict_t *passent, int contentmask)
 {
     trace_t tr;
     bsp_world_t *world = R_GetWorldModel();
 
+    Prof_Begin("GI_trace");
+
     /* Trace against BSP world */
     if (world && world->loaded) {
         tr = CM_BoxTrace(world, start, mins, maxs, end, contentmask);
@@ -387,43 +449,71 @@ static trace_t GI_trace(vec3_t start, vec3_t mins, vec3_t maxs,
     }
 
     /* Trace against solid entities */
-    {
-        edict_t *touch[64];
-        int num_touch, i;
-        vec3_t trace_mins, trace_maxs;
+    SV_ClipTraceToEntities(&tr, start, mins, maxs, end, passent, contentmask);
 
-        /* Build AABB encompassing entire trace */
-        for (i = 0; i < 3; i++) {
-            if (start[i] < end[i]) {
-                trace_mins[i] = start[i] + (mins ? mins[i] : 0);
-                trace_maxs[i] = end[i] + (maxs ? maxs[i] : 0);
-            } else {
-                trace_mins[i] = end[i] + (mins ? mins[i] : 0);
-                trace_maxs[i] = start[i] + (maxs ? maxs[i] : 0);
-            }
-        }
+    Prof_End();
+    return tr;
+}
+
+#define GI_BATCH_CHUNK  8       /* entity clips per job */
 
-        num_touch = SV_AreaEdicts(trace_mins, trace_maxs, touch, 64, AREA_SOLID);
+typedef struct {
+    tracequery_t    *queries;
+    int             count;
+    edict_t         *passent;
+    int             contentmask;
+} gi_batch_t;
 
-        for (i = 0; i < num_touch; i++) {
-            edict_t *ent = touch[i];
+static void GI_ClipBatchJob(void *ctx, int index)
+{
+    gi_batch_t  *b = ctx;
+    int         i, last = (index + 1) * GI_BATCH_CHUNK;
+
+    if (last > b->count)
+        last = b->count;
+    for (i = index * GI_BATCH_CHUNK; i < last; i++) {
+        tracequery_t *q = &b->queries[i];
+
+        SV_ClipTraceToEntities(&q->trace, q->start, q->mins, q->maxs, q->end,
+                               b->passent, b->contentmask);
+    }
+}
 
-            if (!ent || ent == passent || !ent->inuse)
-                continue;
+/*
+ * GI_trace_batch — gi.trace for every query. The world traces and then
+ * the entity clips are each spread over the job threads; the game is
+ * blocked in here meanwhile, so nothing they read can change.
+ */
+static void GI_trace_batch(tracequery_t *queries, int count,
+                           edict_t *passent, int contentmask)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    gi_batch_t  b;
+    int         i;
 
-            /* Skip non-solid entities */
-            if (ent->solid == SOLID_NOT || ent->solid == SOLID_TRIGGER)
-                continue;
+    if (count <= 0)
+        return;
 
-            /* Skip owner */
-            if (passent && ent->owner == passent)
-                continue;
+    Prof_Begin("GI_trace_batch");
 
-            SV_ClipTraceToEntity(&tr, start, mins, maxs, end, ent, contentmask);
+    if (world && world->loaded) {
+        CM_BoxTraceBatch(world, queries, count, contentmask);
+    } else {
+        for (i = 0; i < count; i++) {
+            memset(&queries[i].trace, 0, sizeof(queries[i].trace));
+            queries[i].trace.fraction = 1.0f;
+            VectorCopy(queries[i].end, queries[i].trace.endpos);
         }
     }
 
-    return tr;
+    b.queries = queries;
+    b.count = count;
+    b.passent = passent;
+    b.contentmask = contentmask;
+    Job_ParallelFor("GI_ClipBatch", GI_ClipBatchJob, &b,
+                    (count + GI_BATCH_CHUNK - 1) / GI_BATCH_CHUNK);
+
+    Prof_End();
 }
 
 static int GI_pointcontents(vec3_t point)
@@ -435,16 +525,32 @@ static int GI_pointcontents(vec3_t point)
     return 0;
 }
 
+/* Could anything at p1 see or hear p2? Cluster-level only; no PVS = yes */
+static qboolean GI_inVisSet(vec3_t p1, vec3_t p2, int set)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    int leaf1, leaf2;
+
+    if (!world || !world->loaded || !world->vis)
+        return qtrue;
+
+    leaf1 = BSP_PointLeaf(world, p1);
+    leaf2 = BSP_PointLeaf(world, p2);
+    if (leaf1 < 0 || leaf1 >= world->num_leafs || leaf2 < 0 || leaf2 >= world->num_leafs)
+        return qtrue;
+
+    return BSP_ClusterSees(world, world->leafs[leaf1].cluster,
+                           world->leafs[leaf2].cluster, set);
+}
+
 static qboolean GI_inPVS(vec3_t p1, vec3_t p2)
 {
-    (void)p1; (void)p2;
-    return qtrue;
+    return GI_inVisSet(p1, p2, DVIS_PVS);
 }
 
 static qboolean GI_inPHS(vec3_t p1, vec3_t p2)
 {
-    (void)p1; (void)p2;
-    return qtrue;
+    return GI_inVisSet(p1, p2, DVIS_PHS);
 }
 
 static void GI_setorigin(edict_t *ent, vec3_t origin)
@@ -737,6 +843,12 @@ void SV_InitGameProgs(void)
     gi_impl.flrand = flrand;
     gi_impl.irand = irand;
 
+    /* Recompilation extensions */
+    gi_impl.trace_batch = GI_trace_batch;
+    gi_impl.nav_path = SV_NavPath;
+    gi_impl.nav_cover = SV_NavCover;
+    gi_impl.nav_addcover = SV_NavAddCover;
+
     /* Initialize game module */
     ge = GetGameAPI(&gi_impl);
 
@@ -764,6 +876,7 @@ void SV_ShutdownGameProgs(void)
         ge->Shutdown();
         ge = NULL;
     }
+    SV_NavShutdown();
 }
 
 /* ==========================================================================
@@ -791,6 +904,7 @@ void SV_SetConfigstring(int index, const char *val)
     if (index < 0 || index >= MAX_CONFIGSTRINGS)
         return;
     Q_strncpyz(sv_configstrings[index], val ? val : "", MAX_QPATH);
+    SV_NetConfigstring(index, sv_configstrings[index]);
 }
 
 /*
@@ -826,6 +940,94 @@ void SV_ClientThink(usercmd_t *cmd)
         ge->ClientThink(player, cmd);
 }
 
+/* ==========================================================================
+   Deferred Client Commands
+   With client prediction (cl_pred.c) the client doesn't run its commands
+   through ClientThink as it makes them; it queues them here and the game
+   runs them at the start of its next tick, as a server would on receiving
+   them. The sequence of the last one run is the client's acknowledgement.
+   Both sides run with the game locked.
+   ========================================================================== */
+
+#define SV_CMD_QUEUE    256     /* a tick's worth at well over 1000 fps */
+
+static usercmd_t    sv_cmdqueue[SV_CMD_QUEUE];
+static int          sv_cmdseq[SV_CMD_QUEUE];
+static int          sv_cmdhead, sv_cmdtail;     /* run, queued */
+static int          sv_cmdack;                  /* last sequence run */
+
+void SV_QueueClientThink(const usercmd_t *cmd, int sequence)
+{
+    /* The game has stalled for a long time: make room the old way */
+    if (sv_cmdtail - sv_cmdhead == SV_CMD_QUEUE) {
+        int i = sv_cmdhead++ & (SV_CMD_QUEUE - 1);
+
+        SV_ClientThink(&sv_cmdqueue[i]);
+        sv_cmdack = sv_cmdseq[i];
+    }
+
+    sv_cmdqueue[sv_cmdtail & (SV_CMD_QUEUE - 1)] = *cmd;
+    sv_cmdseq[sv_cmdtail & (SV_CMD_QUEUE - 1)] = sequence;
+    sv_cmdtail++;
+}
+
+/* Run whatever the client queued since the last tick */
+static void SV_RunQueuedThinks(void)
+{
+    while (sv_cmdhead != sv_cmdtail) {
+        int i = sv_cmdhead++ & (SV_CMD_QUEUE - 1);
+
+        SV_ClientThink(&sv_cmdqueue[i]);
+        sv_cmdack = sv_cmdseq[i];
+    }
+}
+
+/* Run one now, acknowledged at once. Anything still queued goes first. */
+void SV_RunClientThink(usercmd_t *cmd, int sequence)
+{
+    SV_RunQueuedThinks();
+    SV_ClientThink(cmd);
+    sv_cmdack = sequence;
+}
+
+/*
+ * SV_GetPredictionState — The player's movement state as the game has it,
+ * and the sequence of the last command that went into it
+ */
+qboolean SV_GetPredictionState(pmove_state_t *ps, int *ack)
+{
+    edict_t *player;
+
+    if (!ge || !ge->edicts)
+        return qfalse;
+
+    player = (edict_t *)((byte *)ge->edicts + ge->edict_size);
+    if (!player->inuse || !player->client)
+        return qfalse;
+
+    /* The entity, not ps, is what gets drawn once the tick is done with it */
+    *ps = player->client->ps;
+    VectorCopy(player->s.origin, ps->origin);
+    VectorCopy(player->velocity, ps->velocity);
+    *ack = sv_cmdack;
+    return qtrue;
+}
+
+/* Player movement clipping, for Pmove run outside the game */
+trace_t SV_PlayerTrace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end)
+{
+    edict_t *player = NULL;
+
+    if (ge && ge->edicts)
+        player = (edict_t *)((byte *)ge->edicts + ge->edict_size);
+    return GI_trace(start, mins, maxs, end, player, MASK_PLAYERSOLID);
+}
+
+int SV_PointContents(vec3_t point)
+{
+    return GI_pointcontents(point);
+}
+
 /*
  * SV_GetPlayerOrigin — Get player entity position for camera
  */
@@ -1321,8 +1523,12 @@ float SV_GetReloadProgress(void)
  */
 void SV_RunGameFrame(void)
 {
+    SV_RunQueuedThinks();
+
     if (ge && ge->RunFrame) {
+        Prof_Begin("SV_RunGameFrame");
         ge->RunFrame();
+        Prof_End();
     }
 }
 
@@ -1331,12 +1537,34 @@ void SV_RunGameFrame(void)
  */
 void SV_SpawnMapEntities(const char *mapname, const char *entstring)
 {
-    /* Re-initialize spatial structure for new map */
+    /* Re-initialize spatial structure for new map, sized to its world model */
     SV_ClearWorld();
+    {
+        bsp_world_t *world = R_GetWorldModel();
+
+        if (world && world->loaded && world->num_models > 0)
+            SV_SetWorldBounds(world->models[0].mins, world->models[0].maxs);
+    }
+
+    /* Navigation graph, before cover points spawn into it */
+    Prof_MapLoadBegin(LOAD_NAV);
+    SV_NavLoad();
+    Prof_MapLoadEnd();
+
+    /* Previous map's entities must not be drawn or lerped from */
+    SV_ClearSnapshots();
+
+    /* Nor moved by the previous map's commands */
+    if (sv_cmdhead != sv_cmdtail)
+        sv_cmdack = sv_cmdseq[(sv_cmdtail - 1) & (SV_CMD_QUEUE - 1)];
+    sv_cmdhead = sv_cmdtail = 0;
 
     /* Clear configstrings from previous map */
     memset(sv_configstrings, 0, sizeof(sv_configstrings));
 
+    /* Sounds the spawn functions soundindex are loaded in the background */
+    S_BeginRegistration();
+
     if (ge && ge->SpawnEntities) {
         /* Connect and begin the local player (edict[1]) before spawning
            entities, so info_player_start can position the player */
@@ -1346,9 +1574,20 @@ void SV_SpawnMapEntities(const char *mapname, const char *entstring)
             ge->ClientBegin(player);
         }
 
+        Prof_MapLoadBegin(LOAD_ENTITIES);
         ge->SpawnEntities(mapname, entstring, "");
+        Prof_MapLoadEnd();
+
+        Prof_MapLoadBegin(LOAD_NAV);
+        SV_NavExposeCovers();
+        Prof_MapLoadEnd();
     }
 
+    /* Waits for the background sound loads */
+    Prof_MapLoadBegin(LOAD_SOUNDS);
+    S_EndRegistration();
+    Prof_MapLoadEnd();
+
     /* Apply sky settings from configstrings set by worldspawn */
     {
         const char *skyname = sv_configstrings[CS_SKY];
@@ -1366,6 +1605,9 @@ void SV_SpawnMapEntities(const char *mapname, const char *entstring)
             R_SetSky(skyname, rotate, axis);
         }
     }
+
+    /* Remote players load the new map */
+    SV_NetMapChanged();
 }
 
 /* ==========================================================================
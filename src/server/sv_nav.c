@@ -0,0 +1,1051 @@
+/*
+ * sv_nav.c - Navigation graph and cover index for the AI
+ *
+ * At map load the world's walkable faces are sampled on a grid into a
+ * waypoint graph: nodes where a monster hull stands clear of the world,
+ * linked to the neighbours it can walk to in a straight line. The graph
+ * is cached in nav/<map>.nav under the game directory, keyed by a
+ * checksum of the BSP, so only the first load of a map builds it.
+ *
+ * Game code asks for paths through gi.nav_path (A* over the graph, with
+ * recent results cached) and for cover through gi.nav_cover. Cover
+ * points are registered as the map's cover entities spawn and kept in
+ * a spatial hash; each knows which PVS clusters it is exposed to, from
+ * one trace per cluster made when the level starts, so a query comes
+ * down to a few lookups and at most NAV_COVER_VERIFY traces.
+ *
+ * Everything here runs on whichever thread runs the game.
+ */
+
+#include "../common/qcommon.h"
+#include "../game/g_local.h"
+#include "../renderer/r_bsp.h"
+
+extern bsp_world_t *R_GetWorldModel(void);
+
+/* ==========================================================================
+   Graph
+   ========================================================================== */
+
+#define NAV_IDENT       (('V' << 24) + ('A' << 16) + ('N' << 8) + 'G')
+#define NAV_VERSION     1
+
+#define NAV_GRID        48.0f   /* floor sample spacing */
+#define NAV_MERGE       24.0f   /* samples closer than this share a node */
+#define NAV_LINK        72.0f   /* longest link; covers the grid diagonal */
+#define NAV_STEP        18.0f   /* STEPSIZE */
+#define NAV_ATTACH      128.0f  /* furthest a point may be from its node */
+#define NAV_MAX_NODES   32768
+#define NAV_MAX_LINKS   12
+#define NAV_MAX_VERTS   64      /* per sampled face */
+
+#define NAV_CELL        128.0f  /* spatial hash cell for nodes */
+#define NAV_COVER_CELL  256.0f  /* and for cover points */
+#define NAV_HASH        4096    /* power of two */
+
+#define NAV_BATCH       4096    /* traces per CM_BoxTraceBatch */
+
+#define NAV_MAX_PATH    64      /* nodes kept per cached path */
+#define NAV_PATH_CACHE  64      /* power of two */
+
+#define NAV_MAX_COVERS  512
+#define NAV_COVER_VERIFY 4
+#define NAV_EYE         20.0f   /* eye height above a node, as the AI uses */
+
+/* As saved, one per node */
+typedef struct {
+    float   origin[3];          /* where a monster's origin stands */
+    int     cluster;
+    int     numlinks;
+    int     links[NAV_MAX_LINKS];
+} navnode_t;
+
+typedef struct {
+    int         ident;
+    int         version;
+    unsigned    checksum;       /* SV_NavChecksum of the BSP */
+    int         numnodes;
+} navheader_t;
+
+typedef struct {
+    int         from, to;       /* nodes; from -1 = empty */
+    int         count;
+    qboolean    truncated;      /* longer than NAV_MAX_PATH */
+    int         nodes[NAV_MAX_PATH];
+} navpath_t;
+
+typedef struct {
+    vec3_t      origin;
+    int         cluster;
+    int         node;           /* nearest node, -1 none */
+    int         next;           /* cover hash chain */
+    byte        *exposed;       /* bit per cluster: seen from its sample node */
+} navcover_t;
+
+static struct {
+    navnode_t   *nodes;
+    int         numnodes, maxnodes;
+    int         numlinks;
+    int         *component;     /* connected component of each node */
+    int         hash[NAV_HASH]; /* first node in the cell, -1 */
+    int         *hashnext;
+
+    /* A* scratch, one of each per node */
+    float       *g, *f;
+    int         *parent;
+    int         *heap, *heappos;    /* heappos -1 once closed */
+    unsigned    *stamp;             /* search that last touched the node */
+    unsigned    search;
+    int         heapsize;
+
+    navpath_t   paths[NAV_PATH_CACHE];
+
+    navcover_t  covers[NAV_MAX_COVERS];
+    int         numcovers, numexposed;
+    int         coverhash[NAV_HASH];
+    int         *samples;       /* per cluster: node at its middle, -1 */
+    int         numclusters;
+} nav;
+
+static vec3_t nav_mins = {-16, -16, -24};
+static vec3_t nav_maxs = { 16,  16,  32};
+static vec3_t nav_point = {0, 0, 0};
+
+/* Build and cover exposure queries, and what each one was for */
+static tracequery_t nav_queries[NAV_BATCH];
+static int          nav_querya[NAV_BATCH], nav_queryb[NAV_BATCH];
+
+static int SV_NavHash(float x, float y, float cell)
+{
+    unsigned cx = (unsigned)(int)floorf(x / cell);
+    unsigned cy = (unsigned)(int)floorf(y / cell);
+
+    return (int)((cx * 73856093u ^ cy * 19349663u) & (NAV_HASH - 1));
+}
+
+static int SV_NavCluster(bsp_world_t *world, vec3_t p)
+{
+    int leaf = BSP_PointLeaf(world, p);
+
+    if (leaf < 0 || leaf >= world->num_leafs)
+        return -1;
+    return world->leafs[leaf].cluster;
+}
+
+/*
+ * SV_NavClear - Drop the graph, its scratch space and the cover points
+ */
+static void SV_NavClear(void)
+{
+    int i;
+
+    if (nav.nodes) Z_Free(nav.nodes);
+    if (nav.component) Z_Free(nav.component);
+    if (nav.hashnext) Z_Free(nav.hashnext);
+    if (nav.g) Z_Free(nav.g);
+    if (nav.f) Z_Free(nav.f);
+    if (nav.parent) Z_Free(nav.parent);
+    if (nav.heap) Z_Free(nav.heap);
+    if (nav.heappos) Z_Free(nav.heappos);
+    if (nav.stamp) Z_Free(nav.stamp);
+    if (nav.samples) Z_Free(nav.samples);
+    for (i = 0; i < nav.numcovers; i++)
+        if (nav.covers[i].exposed)
+            Z_Free(nav.covers[i].exposed);
+
+    memset(&nav, 0, sizeof(nav));
+    for (i = 0; i < NAV_HASH; i++)
+        nav.hash[i] = nav.coverhash[i] = -1;
+    for (i = 0; i < NAV_PATH_CACHE; i++)
+        nav.paths[i].from = -1;
+}
+
+/*
+ * SV_NavChecksum - FNV-1a over the lumps the graph is built from; a
+ * cached graph is only used for the BSP it was built from
+ */
+static unsigned SV_NavChecksum(bsp_world_t *world)
+{
+    const void *lumps[5];
+    int sizes[5], i, j;
+    unsigned h = 2166136261u;
+
+    lumps[0] = world->planes;     sizes[0] = world->num_planes * (int)sizeof(bsp_plane_t);
+    lumps[1] = world->vertexes;   sizes[1] = world->num_vertexes * (int)sizeof(bsp_vertex_t);
+    lumps[2] = world->faces;      sizes[2] = world->num_faces * (int)sizeof(bsp_face_t);
+    lumps[3] = world->brushsides; sizes[3] = world->num_brushsides * (int)sizeof(bsp_brushside_t);
+    lumps[4] = world->leafs;      sizes[4] = world->num_leafs * (int)sizeof(bsp_leaf_t);
+
+    for (i = 0; i < 5; i++) {
+        const byte *b = (const byte *)lumps[i];
+        for (j = 0; b && j < sizes[i]; j++)
+            h = (h ^ b[j]) * 16777619u;
+    }
+    return h;
+}
+
+/* ==========================================================================
+   Building
+   ========================================================================== */
+
+/*
+ * SV_NavAddNode - Add a node unless one already stands within NAV_MERGE
+ */
+static void SV_NavAddNode(bsp_world_t *world, vec3_t origin)
+{
+    navnode_t *node;
+    int dx, dy, i, h;
+
+    for (dx = -1; dx <= 1; dx++) {
+        for (dy = -1; dy <= 1; dy++) {
+            h = SV_NavHash(origin[0] + dx * NAV_MERGE, origin[1] + dy * NAV_MERGE, NAV_CELL);
+            for (i = nav.hash[h]; i >= 0; i = nav.hashnext[i]) {
+                float *o = nav.nodes[i].origin;
+                if (fabsf(o[0] - origin[0]) < NAV_MERGE &&
+                    fabsf(o[1] - origin[1]) < NAV_MERGE &&
+                    fabsf(o[2] - origin[2]) < NAV_STEP)
+                    return;
+            }
+        }
+    }
+
+    if (nav.numnodes == nav.maxnodes) {
+        navnode_t *nodes;
+        int *next;
+        int max = nav.maxnodes ? nav.maxnodes * 2 : 1024;
+
+        if (nav.maxnodes >= NAV_MAX_NODES)
+            return;
+        if (max > NAV_MAX_NODES)
+            max = NAV_MAX_NODES;
+        nodes = Z_Malloc(max * (int)sizeof(navnode_t));
+        next = Z_Malloc(max * (int)sizeof(int));
+        if (nav.nodes) {
+            memcpy(nodes, nav.nodes, nav.numnodes * sizeof(navnode_t));
+            memcpy(next, nav.hashnext, nav.numnodes * sizeof(int));
+            Z_Free(nav.nodes);
+            Z_Free(nav.hashnext);
+        }
+        nav.nodes = nodes;
+        nav.hashnext = next;
+        nav.maxnodes = max;
+    }
+
+    node = &nav.nodes[nav.numnodes];
+    VectorCopy(origin, node->origin);
+    node->cluster = SV_NavCluster(world, origin);
+    node->numlinks = 0;
+
+    h = SV_NavHash(origin[0], origin[1], NAV_CELL);
+    nav.hashnext[nav.numnodes] = nav.hash[h];
+    nav.hash[h] = nav.numnodes++;
+}
+
+/*
+ * SV_NavDropSamples - Drop a standing hull onto each queued floor
+ * sample; the ones that land on walkable ground become nodes
+ */
+static void SV_NavDropSamples(bsp_world_t *world, int count)
+{
+    int i;
+
+    CM_BoxTraceBatch(world, nav_queries, count, MASK_MONSTERSOLID);
+
+    for (i = 0; i < count; i++) {
+        trace_t *tr = &nav_queries[i].trace;
+
+        if (tr->startsolid || tr->allsolid || tr->fraction >= 1.0f)
+            continue;
+        if (tr->plane.normal[2] < 0.7f)
+            continue;
+        SV_NavAddNode(world, tr->endpos);
+    }
+}
+
+/* Whether p lies inside the convex polygon v, looked at from above */
+static qboolean SV_NavInsideXY(vec3_t *v, int n, float x, float y)
+{
+    int i, pos = 0, neg = 0;
+
+    for (i = 0; i < n; i++) {
+        float *a = v[i], *b = v[(i + 1) % n];
+        float c = (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+        if (c > 0.01f) pos++;
+        else if (c < -0.01f) neg++;
+    }
+    return !(pos && neg);
+}
+
+/* Queue a hull dropped onto the floor point (x, y, z) */
+static void SV_NavQueueSample(bsp_world_t *world, int *n, float x, float y, float z)
+{
+    tracequery_t *q = &nav_queries[*n];
+
+    VectorSet(q->start, x, y, z - nav_mins[2] + NAV_STEP);
+    VectorSet(q->end, x, y, z - nav_mins[2] - NAV_STEP);
+    VectorCopy(nav_mins, q->mins);
+    VectorCopy(nav_maxs, q->maxs);
+    if (++*n == NAV_BATCH) {
+        SV_NavDropSamples(world, *n);
+        *n = 0;
+    }
+}
+
+/*
+ * SV_NavSampleFaces - Queue a floor sample at every grid point on each
+ * upward-facing world face, or at its middle if it's smaller than a
+ * cell. The grid is world-aligned so neighbouring faces agree on it.
+ */
+static void SV_NavSampleFaces(bsp_world_t *world)
+{
+    bsp_model_t *model = &world->models[0];
+    int f, n = 0;
+
+    for (f = model->firstface; f < model->firstface + model->numfaces; f++) {
+        bsp_face_t *face = &world->faces[f];
+        bsp_plane_t *plane;
+        vec3_t verts[NAV_MAX_VERTS], normal, mins, maxs, mid;
+        float dist, x, y;
+        int i, numverts, sampled = 0;
+
+        if (face->planenum >= world->num_planes || face->numedges < 3 ||
+            face->numedges > NAV_MAX_VERTS)
+            continue;
+        if (face->texinfo >= 0 && face->texinfo < world->num_texinfo &&
+            (world->texinfo[face->texinfo].flags & (SURF_SKY | SURF_WARP)))
+            continue;
+
+        plane = &world->planes[face->planenum];
+        VectorCopy(plane->normal, normal);
+        dist = plane->dist;
+        if (face->side) {
+            VectorNegate(normal, normal);
+            dist = -dist;
+        }
+        if (normal[2] < 0.7f)
+            continue;
+
+        numverts = face->numedges;
+        VectorSet(mins, 99999, 99999, 99999);
+        VectorSet(maxs, -99999, -99999, -99999);
+        VectorClear(mid);
+        for (i = 0; i < numverts; i++) {
+            int e = world->surfedges[face->firstedge + i];
+            int vi = e >= 0 ? world->edges[e].v[0] : world->edges[-e].v[1];
+            int k;
+
+            VectorCopy(world->vertexes[vi].point, verts[i]);
+            VectorAdd(mid, verts[i], mid);
+            for (k = 0; k < 3; k++) {
+                if (verts[i][k] < mins[k]) mins[k] = verts[i][k];
+                if (verts[i][k] > maxs[k]) maxs[k] = verts[i][k];
+            }
+        }
+        VectorScale(mid, 1.0f / numverts, mid);
+
+        for (x = ceilf(mins[0] / NAV_GRID) * NAV_GRID; x <= maxs[0]; x += NAV_GRID) {
+            for (y = ceilf(mins[1] / NAV_GRID) * NAV_GRID; y <= maxs[1]; y += NAV_GRID) {
+                if (!SV_NavInsideXY(verts, numverts, x, y))
+                    continue;
+                SV_NavQueueSample(world, &n, x, y,
+                                  (dist - normal[0] * x - normal[1] * y) / normal[2]);
+                sampled++;
+            }
+        }
+
+        /* Too small for the grid: one sample in the middle */
+        if (!sampled)
+            SV_NavQueueSample(world, &n, mid[0], mid[1], mid[2]);
+    }
+
+    if (n)
+        SV_NavDropSamples(world, n);
+}
+
+/*
+ * SV_NavCheckLinks - Keep each queued pair whose hull walks clear from
+ * one to the other, one step up, over ground
+ */
+static void SV_NavCheckLinks(bsp_world_t *world, int pairs)
+{
+    int i;
+
+    CM_BoxTraceBatch(world, nav_queries, pairs * 2, MASK_MONSTERSOLID);
+
+    for (i = 0; i < pairs; i++) {
+        trace_t *walk = &nav_queries[i * 2].trace;
+        trace_t *floor = &nav_queries[i * 2 + 1].trace;
+        navnode_t *a = &nav.nodes[nav_querya[i]];
+        navnode_t *b = &nav.nodes[nav_queryb[i]];
+
+        if (walk->startsolid || walk->fraction < 1.0f || floor->fraction >= 1.0f)
+            continue;
+        if (a->numlinks == NAV_MAX_LINKS || b->numlinks == NAV_MAX_LINKS)
+            continue;
+        a->links[a->numlinks++] = nav_queryb[i];
+        b->links[b->numlinks++] = nav_querya[i];
+        nav.numlinks += 2;
+    }
+}
+
+static void SV_NavLinkNodes(bsp_world_t *world)
+{
+    int a, pairs = 0;
+
+    for (a = 0; a < nav.numnodes; a++) {
+        float *oa = nav.nodes[a].origin;
+        int dx, dy, h, b, seen[9], numseen = 0, s;
+
+        for (dx = -1; dx <= 1; dx++) {
+            for (dy = -1; dy <= 1; dy++) {
+                h = SV_NavHash(oa[0] + dx * NAV_LINK, oa[1] + dy * NAV_LINK, NAV_CELL);
+
+                /* Neighbouring offsets can land in the same cell */
+                for (s = 0; s < numseen && seen[s] != h; s++)
+                    ;
+                if (s < numseen)
+                    continue;
+                seen[numseen++] = h;
+
+                for (b = nav.hash[h]; b >= 0; b = nav.hashnext[b]) {
+                    float *ob = nav.nodes[b].origin;
+                    float hx = ob[0] - oa[0], hy = ob[1] - oa[1];
+                    float horiz = sqrtf(hx * hx + hy * hy);
+                    float dz = fabsf(ob[2] - oa[2]);
+                    tracequery_t *walk, *floor;
+
+                    if (b <= a || horiz > NAV_LINK || horiz < 1.0f)
+                        continue;
+                    if (dz > NAV_STEP + horiz)  /* steeper than walkable */
+                        continue;
+
+                    walk = &nav_queries[pairs * 2];
+                    VectorCopy(oa, walk->start);
+                    VectorCopy(ob, walk->end);
+                    walk->start[2] += NAV_STEP;
+                    walk->end[2] += NAV_STEP;
+                    VectorCopy(nav_mins, walk->mins);
+                    VectorCopy(nav_maxs, walk->maxs);
+
+                    floor = &nav_queries[pairs * 2 + 1];
+                    VectorAdd(oa, ob, floor->start);
+                    VectorScale(floor->start, 0.5f, floor->start);
+                    VectorCopy(floor->start, floor->end);
+                    floor->end[2] += nav_mins[2] - NAV_STEP - dz * 0.5f;
+                    VectorClear(floor->mins);
+                    VectorClear(floor->maxs);
+
+                    nav_querya[pairs] = a;
+                    nav_queryb[pairs] = b;
+                    if (++pairs == NAV_BATCH / 2) {
+                        SV_NavCheckLinks(world, pairs);
+                        pairs = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    if (pairs)
+        SV_NavCheckLinks(world, pairs);
+}
+
+/* ==========================================================================
+   Cache
+   ========================================================================== */
+
+static void SV_NavCachePath(bsp_world_t *world, char *out, int size)
+{
+    const char *slash = strrchr(world->name, '/');
+    char map[MAX_QPATH], *dot;
+
+    Q_strncpyz(map, slash ? slash + 1 : world->name, sizeof(map));
+    dot = strrchr(map, '.');
+    if (dot)
+        *dot = 0;
+    Com_sprintf(out, size, "nav/%s.nav", map);
+}
+
+static qboolean SV_NavReadCache(const char *path, unsigned checksum)
+{
+    navheader_t *header = NULL;
+    int len, i, j;
+
+    len = FS_LoadFile(path, (void **)&header);
+    if (!header)
+        return qfalse;
+
+    if (len < (int)sizeof(*header) || header->ident != NAV_IDENT ||
+        header->version != NAV_VERSION || header->checksum != checksum ||
+        header->numnodes <= 0 || header->numnodes > NAV_MAX_NODES ||
+        (len - (int)sizeof(*header)) / (int)sizeof(navnode_t) < header->numnodes) {
+        FS_FreeFile(header);
+        return qfalse;
+    }
+
+    nav.numnodes = nav.maxnodes = header->numnodes;
+    nav.nodes = Z_Malloc(nav.numnodes * (int)sizeof(navnode_t));
+    nav.hashnext = Z_Malloc(nav.numnodes * (int)sizeof(int));
+    memcpy(nav.nodes, header + 1, nav.numnodes * sizeof(navnode_t));
+    FS_FreeFile(header);
+
+    for (i = 0; i < nav.numnodes; i++) {
+        navnode_t *node = &nav.nodes[i];
+        int h;
+
+        if (node->numlinks < 0 || node->numlinks > NAV_MAX_LINKS)
+            node->numlinks = 0;
+        for (j = 0; j < node->numlinks; j++) {
+            if (node->links[j] < 0 || node->links[j] >= nav.numnodes) {
+                node->numlinks = j;
+                break;
+            }
+        }
+        nav.numlinks += node->numlinks;
+
+        h = SV_NavHash(node->origin[0], node->origin[1], NAV_CELL);
+        nav.hashnext[i] = nav.hash[h];
+        nav.hash[h] = i;
+    }
+    return qtrue;
+}
+
+static void SV_NavWriteCache(const char *path, unsigned checksum)
+{
+    navheader_t header;
+    FILE *f;
+
+    Sys_Mkdir(va("%s/nav", FS_Gamedir()));
+    f = fopen(va("%s/%s", FS_Gamedir(), path), "wb");
+    if (!f) {
+        Com_Printf("SV_NavLoad: couldn't write %s\n", path);
+        return;
+    }
+
+    header.ident = NAV_IDENT;
+    header.version = NAV_VERSION;
+    header.checksum = checksum;
+    header.numnodes = nav.numnodes;
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(nav.nodes, sizeof(navnode_t), nav.numnodes, f);
+    fclose(f);
+}
+
+/* ==========================================================================
+   Loading
+   ========================================================================== */
+
+/*
+ * SV_NavPrepare - Label connected components, pick a sample node for
+ * each cluster and allocate the search scratch
+ */
+static void SV_NavPrepare(bsp_world_t *world)
+{
+    float *sums, *best;
+    int *counts, *stack;
+    int i, j, label = 0;
+
+    nav.component = Z_Malloc(nav.numnodes * (int)sizeof(int));
+    nav.g = Z_Malloc(nav.numnodes * (int)sizeof(float));
+    nav.f = Z_Malloc(nav.numnodes * (int)sizeof(float));
+    nav.parent = Z_Malloc(nav.numnodes * (int)sizeof(int));
+    nav.heap = Z_Malloc(nav.numnodes * (int)sizeof(int));
+    nav.heappos = Z_Malloc(nav.numnodes * (int)sizeof(int));
+    nav.stamp = Z_Malloc(nav.numnodes * (int)sizeof(unsigned));
+
+    /* Flood fill, using the heap as the stack */
+    stack = nav.heap;
+    for (i = 0; i < nav.numnodes; i++)
+        nav.component[i] = -1;
+    for (i = 0; i < nav.numnodes; i++) {
+        int top = 0;
+
+        if (nav.component[i] >= 0)
+            continue;
+        nav.component[i] = label;
+        stack[top++] = i;
+        while (top) {
+            navnode_t *node = &nav.nodes[stack[--top]];
+            for (j = 0; j < node->numlinks; j++) {
+                int n = node->links[j];
+                if (nav.component[n] < 0) {
+                    nav.component[n] = label;
+                    stack[top++] = n;
+                }
+            }
+        }
+        label++;
+    }
+
+    /* Each cluster's sample is its node nearest the middle of its nodes */
+    nav.numclusters = world->vis ? world->vis->numclusters : 0;
+    if (nav.numclusters <= 0)
+        return;
+
+    nav.samples = Z_Malloc(nav.numclusters * (int)sizeof(int));
+    sums = Z_Malloc(nav.numclusters * 3 * (int)sizeof(float));
+    counts = Z_Malloc(nav.numclusters * (int)sizeof(int));
+    best = Z_Malloc(nav.numclusters * (int)sizeof(float));
+
+    for (i = 0; i < nav.numnodes; i++) {
+        int c = nav.nodes[i].cluster;
+        if (c < 0 || c >= nav.numclusters)
+            continue;
+        VectorAdd(&sums[c * 3], nav.nodes[i].origin, &sums[c * 3]);
+        counts[c]++;
+    }
+    for (i = 0; i < nav.numclusters; i++) {
+        if (counts[i])
+            VectorScale(&sums[i * 3], 1.0f / counts[i], &sums[i * 3]);
+        nav.samples[i] = -1;
+        best[i] = 0;
+    }
+    for (i = 0; i < nav.numnodes; i++) {
+        int c = nav.nodes[i].cluster;
+        vec3_t d;
+        float ds;
+
+        if (c < 0 || c >= nav.numclusters)
+            continue;
+        VectorSubtract(nav.nodes[i].origin, &sums[c * 3], d);
+        ds = DotProduct(d, d);
+        if (nav.samples[c] < 0 || ds < best[c]) {
+            nav.samples[c] = i;
+            best[c] = ds;
+        }
+    }
+
+    Z_Free(best);
+    Z_Free(counts);
+    Z_Free(sums);
+}
+
+/*
+ * SV_NavLoad - Load or build the navigation graph for the current
+ * world. Called when a map's entities are about to spawn.
+ */
+void SV_NavLoad(void)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    char        path[MAX_QPATH];
+    unsigned    checksum;
+    qboolean    cached;
+    uint64_t    t0 = Sys_PerfCounter();
+
+    SV_NavClear();
+    if (!world || !world->loaded || world->num_models < 1)
+        return;
+
+    SV_NavCachePath(world, path, sizeof(path));
+    checksum = SV_NavChecksum(world);
+    cached = SV_NavReadCache(path, checksum);
+    if (!cached) {
+        SV_NavSampleFaces(world);
+        SV_NavLinkNodes(world);
+        if (nav.numnodes)
+            SV_NavWriteCache(path, checksum);
+    }
+    if (!nav.numnodes)
+        return;
+
+    SV_NavPrepare(world);
+
+    Com_Printf("nav: %d nodes, %d links %s in %.0f ms\n", nav.numnodes, nav.numlinks,
+               cached ? "loaded" : "built",
+               (double)(Sys_PerfCounter() - t0) * 1000.0 / (double)Sys_PerfFrequency());
+}
+
+/*
+ * SV_NavShutdown - Free the graph when the game goes away
+ */
+void SV_NavShutdown(void)
+{
+    SV_NavClear();
+}
+
+/* ==========================================================================
+   Paths
+   ========================================================================== */
+
+/*
+ * SV_NavNearest - The node a point belongs to: the nearest of the few
+ * closest within NAV_ATTACH that it can see, else just the nearest
+ */
+static int SV_NavNearest(bsp_world_t *world, vec3_t p)
+{
+    int best[3] = {-1, -1, -1};
+    float bestdist[3] = {0, 0, 0};
+    int dx, dy, i, k, h;
+
+    for (dx = -1; dx <= 1; dx++) {
+        for (dy = -1; dy <= 1; dy++) {
+            h = SV_NavHash(p[0] + dx * NAV_CELL, p[1] + dy * NAV_CELL, NAV_CELL);
+            for (i = nav.hash[h]; i >= 0; i = nav.hashnext[i]) {
+                vec3_t d;
+                float ds;
+
+                VectorSubtract(nav.nodes[i].origin, p, d);
+                if (fabsf(d[2]) > NAV_ATTACH * 0.5f)
+                    continue;
+                ds = DotProduct(d, d);
+                if (ds > NAV_ATTACH * NAV_ATTACH)
+                    continue;
+
+                /* Keep the three closest, in order */
+                for (k = 0; k < 3; k++) {
+                    if (best[k] == i)
+                        break;
+                    if (best[k] < 0 || ds < bestdist[k]) {
+                        int m;
+                        for (m = 2; m > k; m--) {
+                            best[m] = best[m - 1];
+                            bestdist[m] = bestdist[m - 1];
+                        }
+                        best[k] = i;
+                        bestdist[k] = ds;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    for (k = 0; k < 3 && best[k] >= 0; k++) {
+        trace_t tr = CM_BoxTrace(world, p, nav_point, nav_point,
+                                 nav.nodes[best[k]].origin, MASK_MONSTERSOLID);
+        if (tr.fraction >= 1.0f)
+            return best[k];
+    }
+    return best[0];
+}
+
+static void SV_NavHeapSwap(int a, int b)
+{
+    int t = nav.heap[a];
+
+    nav.heap[a] = nav.heap[b];
+    nav.heap[b] = t;
+    nav.heappos[nav.heap[a]] = a;
+    nav.heappos[nav.heap[b]] = b;
+}
+
+static void SV_NavHeapUp(int i)
+{
+    while (i > 0) {
+        int up = (i - 1) / 2;
+        if (nav.f[nav.heap[up]] <= nav.f[nav.heap[i]])
+            break;
+        SV_NavHeapSwap(i, up);
+        i = up;
+    }
+}
+
+static int SV_NavHeapPop(void)
+{
+    int top = nav.heap[0], i = 0;
+
+    nav.heap[0] = nav.heap[--nav.heapsize];
+    nav.heappos[nav.heap[0]] = 0;
+    for (;;) {
+        int l = i * 2 + 1, r = l + 1, m = i;
+        if (l < nav.heapsize && nav.f[nav.heap[l]] < nav.f[nav.heap[m]]) m = l;
+        if (r < nav.heapsize && nav.f[nav.heap[r]] < nav.f[nav.heap[m]]) m = r;
+        if (m == i)
+            break;
+        SV_NavHeapSwap(i, m);
+        i = m;
+    }
+    nav.heappos[top] = -1;
+    return top;
+}
+
+static float SV_NavDistance(int a, int b)
+{
+    vec3_t d;
+
+    VectorSubtract(nav.nodes[a].origin, nav.nodes[b].origin, d);
+    return VectorLength(d);
+}
+
+/*
+ * SV_NavSearch - A* from one node to another in the same component.
+ * Fills out with the first max nodes of the path, from included, and
+ * returns how many.
+ */
+static int SV_NavSearch(int from, int to, int *out, int max, qboolean *truncated)
+{
+    int n, i, len;
+
+    if (++nav.search == 0) {
+        memset(nav.stamp, 0, nav.numnodes * sizeof(unsigned));
+        nav.search = 1;
+    }
+
+    nav.stamp[from] = nav.search;
+    nav.g[from] = 0;
+    nav.f[from] = SV_NavDistance(from, to);
+    nav.parent[from] = -1;
+    nav.heap[0] = from;
+    nav.heappos[from] = 0;
+    nav.heapsize = 1;
+
+    while (nav.heapsize) {
+        navnode_t *node;
+
+        n = SV_NavHeapPop();
+        if (n == to)
+            break;
+
+        node = &nav.nodes[n];
+        for (i = 0; i < node->numlinks; i++) {
+            int m = node->links[i];
+            float g = nav.g[n] + SV_NavDistance(n, m);
+
+            if (nav.stamp[m] == nav.search) {
+                if (nav.heappos[m] < 0 || g >= nav.g[m])
+                    continue;   /* closed, or no better */
+            } else {
+                nav.stamp[m] = nav.search;
+                nav.heappos[m] = nav.heapsize;
+                nav.heap[nav.heapsize++] = m;
+            }
+            nav.g[m] = g;
+            nav.f[m] = g + SV_NavDistance(m, to);
+            nav.parent[m] = n;
+            SV_NavHeapUp(nav.heappos[m]);
+        }
+    }
+
+    if (nav.stamp[to] != nav.search)
+        return 0;
+
+    /* Walk back from the goal, then hand out the front of it */
+    len = 0;
+    for (n = to; n >= 0; n = nav.parent[n])
+        nav.heap[len++] = n;
+    *truncated = len > max;
+    for (i = 0; i < len && i < max; i++)
+        out[i] = nav.heap[len - 1 - i];
+    return i;
+}
+
+/*
+ * SV_NavPath - gi.nav_path: waypoints from start towards end. The last
+ * is end itself when the whole path fits. Returns the number written,
+ * 0 when there is no graph or no way there.
+ */
+int SV_NavPath(vec3_t start, vec3_t end, vec3_t *points, int max)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    navpath_t *path;
+    int from, to, i, count = 0;
+
+    if (!nav.numnodes || !world || max <= 0)
+        return 0;
+
+    from = SV_NavNearest(world, start);
+    to = SV_NavNearest(world, end);
+    if (from < 0 || to < 0 || nav.component[from] != nav.component[to])
+        return 0;
+
+    /* The graph doesn't change during a level, so neither do its paths */
+    path = &nav.paths[((unsigned)from * 31u + (unsigned)to) & (NAV_PATH_CACHE - 1)];
+    if (path->from != from || path->to != to) {
+        path->from = from;
+        path->to = to;
+        path->count = SV_NavSearch(from, to, path->nodes, NAV_MAX_PATH, &path->truncated);
+    }
+
+    /* The first node is only where the search began */
+    for (i = path->count > 1 ? 1 : 0; i < path->count && count < max; i++, count++)
+        VectorCopy(nav.nodes[path->nodes[i]].origin, points[count]);
+    if (!path->truncated && count < max) {
+        VectorCopy(end, points[count]);
+        count++;
+    }
+    return count;
+}
+
+/* ==========================================================================
+   Cover
+   ========================================================================== */
+
+/*
+ * SV_NavAddCover - gi.nav_addcover: register a cover point
+ */
+void SV_NavAddCover(vec3_t origin)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    navcover_t *cover;
+    int h;
+
+    if (!world || !world->loaded || nav.numcovers == NAV_MAX_COVERS)
+        return;
+
+    cover = &nav.covers[nav.numcovers];
+    VectorCopy(origin, cover->origin);
+    cover->cluster = SV_NavCluster(world, origin);
+    cover->node = nav.numnodes ? SV_NavNearest(world, origin) : -1;
+    cover->exposed = NULL;
+
+    h = SV_NavHash(origin[0], origin[1], NAV_COVER_CELL);
+    cover->next = nav.coverhash[h];
+    nav.coverhash[h] = nav.numcovers++;
+}
+
+static void SV_NavExposeBatch(bsp_world_t *world, int count)
+{
+    int i;
+
+    CM_BoxTraceBatch(world, nav_queries, count, MASK_OPAQUE);
+    for (i = 0; i < count; i++) {
+        if (nav_queries[i].trace.fraction >= 1.0f) {
+            int k = nav_queryb[i];
+            nav.covers[nav_querya[i]].exposed[k >> 3] |= (byte)(1 << (k & 7));
+        }
+    }
+}
+
+/*
+ * SV_NavExposeCovers - Trace each new cover point from the sample node
+ * of every cluster in its PVS. Called once the map's entities have
+ * spawned, and again by a query if more have been added since.
+ */
+void SV_NavExposeCovers(void)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    int n = 0;
+
+    if (!world || !world->loaded)
+        return;
+
+    for (; nav.numexposed < nav.numcovers; nav.numexposed++) {
+        navcover_t *cover = &nav.covers[nav.numexposed];
+        int k;
+
+        if (nav.numclusters <= 0 || cover->cluster < 0)
+            continue;
+        cover->exposed = Z_Malloc((nav.numclusters + 7) >> 3);
+
+        for (k = 0; k < nav.numclusters; k++) {
+            tracequery_t *q;
+
+            if (nav.samples[k] < 0 ||
+                !BSP_ClusterSees(world, k, cover->cluster, DVIS_PVS))
+                continue;
+
+            q = &nav_queries[n];
+            VectorCopy(nav.nodes[nav.samples[k]].origin, q->start);
+            q->start[2] += NAV_EYE;
+            VectorCopy(cover->origin, q->end);
+            VectorClear(q->mins);
+            VectorClear(q->maxs);
+            nav_querya[n] = nav.numexposed;
+            nav_queryb[n] = k;
+            if (++n == NAV_BATCH) {
+                SV_NavExposeBatch(world, n);
+                n = 0;
+            }
+        }
+    }
+
+    if (n)
+        SV_NavExposeBatch(world, n);
+}
+
+/*
+ * SV_NavCover - gi.nav_cover: the nearest cover point between mindist
+ * and maxdist of origin that threat can't see, and that origin can walk
+ * to when there is a graph. Points out of the threat's PVS are taken as
+ * they are; the rest are skipped if exposed to the threat's cluster and
+ * otherwise confirmed with a trace, nearest first.
+ */
+qboolean SV_NavCover(vec3_t origin, vec3_t threat, float mindist, float maxdist, vec3_t out)
+{
+    bsp_world_t *world = R_GetWorldModel();
+    int best[NAV_COVER_VERIFY], numbest = 0;
+    float bestdist[NAV_COVER_VERIFY];
+    qboolean hidden[NAV_COVER_VERIFY];
+    int tc, component = -1, i, k, h, x, y, cells;
+    float cx, cy;
+
+    if (!world || !world->loaded || !nav.numcovers)
+        return qfalse;
+    if (nav.numexposed < nav.numcovers)
+        SV_NavExposeCovers();
+
+    tc = SV_NavCluster(world, threat);
+    if (tc >= nav.numclusters)
+        tc = -1;
+    if (nav.numnodes) {
+        int node = SV_NavNearest(world, origin);
+        if (node >= 0)
+            component = nav.component[node];
+    }
+
+    cells = (int)ceilf(maxdist / NAV_COVER_CELL);
+    for (x = -cells; x <= cells; x++) {
+        for (y = -cells; y <= cells; y++) {
+            cx = origin[0] + x * NAV_COVER_CELL;
+            cy = origin[1] + y * NAV_COVER_CELL;
+            h = SV_NavHash(cx, cy, NAV_COVER_CELL);
+
+            for (i = nav.coverhash[h]; i >= 0; i = nav.covers[i].next) {
+                navcover_t *cover = &nav.covers[i];
+                qboolean sure = qfalse;
+                vec3_t d;
+                float dist;
+
+                /* Distinct offsets can hash to the same chain */
+                if ((int)floorf(cover->origin[0] / NAV_COVER_CELL) != (int)floorf(cx / NAV_COVER_CELL) ||
+                    (int)floorf(cover->origin[1] / NAV_COVER_CELL) != (int)floorf(cy / NAV_COVER_CELL))
+                    continue;
+
+                VectorSubtract(cover->origin, origin, d);
+                dist = VectorLength(d);
+                if (dist < mindist || dist > maxdist)
+                    continue;
+                if (component >= 0 && cover->node >= 0 &&
+                    nav.component[cover->node] != component)
+                    continue;   /* can't get there */
+
+                if (tc >= 0 && cover->cluster >= 0) {
+                    if (!BSP_ClusterSees(world, tc, cover->cluster, DVIS_PVS))
+                        sure = qtrue;
+                    else if (cover->exposed && (cover->exposed[tc >> 3] & (1 << (tc & 7))))
+                        continue;
+                }
+
+                /* Keep the nearest few, in order */
+                for (k = numbest; k > 0 && bestdist[k - 1] > dist; k--) {
+                    if (k < NAV_COVER_VERIFY) {
+                        best[k] = best[k - 1];
+                        bestdist[k] = bestdist[k - 1];
+                        hidden[k] = hidden[k - 1];
+                    }
+                }
+                if (k < NAV_COVER_VERIFY) {
+                    best[k] = i;
+                    bestdist[k] = dist;
+                    hidden[k] = sure;
+                    if (numbest < NAV_COVER_VERIFY)
+                        numbest++;
+                }
+            }
+        }
+    }
+
+    for (k = 0; k < numbest; k++) {
+        navcover_t *cover = &nav.covers[best[k]];
+
+        if (!hidden[k]) {
+            trace_t tr = CM_BoxTrace(world, cover->origin, nav_point, nav_point,
+                                     threat, MASK_OPAQUE);
+            if (tr.fraction >= 1.0f)
+                continue;
+        }
+        VectorCopy(cover->origin, out);
+        return qtrue;
+    }
+    return qfalse;
+}
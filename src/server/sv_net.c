@@ -0,0 +1,941 @@
+/*
+ * sv_net.c - Remote clients
+ *
+ * The local player is edict 1 and talks to the game directly. Players
+ * connecting over UDP get the client slots after it, edicts 2 up to
+ * maxclients, each with a netchan (net_chan.c).
+ *
+ *   getchallenge            -> challenge <n>
+ *   connect <protocol> <qport> <challenge> "<userinfo>"
+ *                           -> client_connect, then the gamestate
+ *   info                    -> info <hostname> <map> <players> <max>
+ *
+ * The gamestate is streamed over the reliable channel a message at a
+ * time: svc_serverdata, every configstring, the client's baselines, then
+ * svc_gamestate_done. The client answers "begin" and from then on gets
+ * an unreliable svc_frame after every game tick.
+ *
+ * Baselines are per client: the state of every entity as of the moment
+ * it connected. A frame is a delta against the last frame the client
+ * acknowledged, if that is still in the backlog; entities it didn't have
+ * there are sent against their baselines. Everything after a frame's
+ * header is bit-packed (net_msg.c): the client's movement state, then
+ * each entity that changed, came into view or left it, culled by PVS.
+ *
+ * All of it runs with the game locked: packets are read from SV_Frame,
+ * frames are sent from whichever thread just ran the tick, with the
+ * frame building spread over the job system. sv_netstats prints
+ * per-client traffic and snapshot sizes.
+ */
+
+#include "../common/qcommon.h"
+#include "../game/g_local.h"
+#include "../renderer/r_bsp.h"
+
+#define MAX_NETCLIENTS      32
+
+#define UPDATE_BACKUP       16      /* frames kept to delta against; power of two */
+#define UPDATE_MASK         (UPDATE_BACKUP - 1)
+#define MAX_FRAME_ENTITIES  256     /* per frame, after culling */
+
+#define GAMESTATE_RESERVE   64      /* room left in a reliable message */
+#define MAX_VIS_ROW         8192    /* bytes, as r_bsp.c allows */
+
+typedef enum {
+    NC_FREE,
+    NC_CONNECTED,           /* streaming the gamestate */
+    NC_SPAWNED              /* in the game, getting frames */
+} netclientstate_t;
+
+typedef struct {
+    int             framenum;       /* 0 = slot never filled */
+    int             sent_time;
+    int             bytes;
+    int             first_entity;   /* in the client's frame_ents ring */
+    int             num_entities;
+    pmove_state_t   ps;
+} netframe_t;
+
+typedef struct {
+    netclientstate_t state;
+    int             edictnum;
+    char            userinfo[MAX_INFO_STRING];
+    netchan_t       chan;
+
+    int             servercount;    /* map the gamestate was for */
+    int             next_configstring;
+    int             next_baseline;
+
+    int             lastframe;      /* last acknowledged, -1 = none */
+    usercmd_t       lastcmd;
+    int             lastdropped;    /* chan.stats.dropped at the last move */
+
+    netframe_t      frames[UPDATE_BACKUP];
+    entity_state_t  *frame_ents;    /* UPDATE_BACKUP * MAX_FRAME_ENTITIES */
+    int             next_frame_ent;
+    entity_state_t  *baselines;     /* MAX_EDICTS */
+
+    int             vis_row;        /* this tick's PVS row, -1 = sees all */
+    byte            snapbuf[MAX_MSGLEN];
+    qboolean        snap_overflowed;
+
+    int             ping;
+    int             snap_bytes;     /* last frame */
+    int             snap_entities;
+    int             snap_total;     /* all frames, for the average */
+    int             snaps;
+} netclient_t;
+
+typedef struct {
+    netadr_t        adr;
+    int             challenge;
+    int             time;
+} challenge_t;
+
+#define MAX_CHALLENGES      64
+
+static struct {
+    netclient_t     clients[MAX_NETCLIENTS];
+    int             num_clients;        /* slots usable this game */
+    int             framenum;
+    int             servercount;
+    challenge_t     challenges[MAX_CHALLENGES];
+} sv_net;
+
+static cvar_t   *net_listen;
+static cvar_t   *sv_timeout;
+static cvar_t   *hostname;
+
+extern cvar_t   *dedicated;
+
+static byte     sv_packetbuf[MAX_MSGLEN + PACKET_HEADER];   /* incoming */
+
+extern game_export_t *SV_GetGameExport(void);
+extern bsp_world_t *R_GetWorldModel(void);
+extern int SV_EntityClusters(int num, const int **clusters);
+extern void SV_UnlinkEdict(edict_t *ent);
+
+static edict_t *SV_NetEdict(int num)
+{
+    game_export_t *ge = SV_GetGameExport();
+
+    return (edict_t *)((byte *)ge->edicts + num * ge->edict_size);
+}
+
+/* ==========================================================================
+   Dropping
+   ========================================================================== */
+
+static void SV_DropClient(netclient_t *cl, const char *reason)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    byte            buf[64];
+    sizebuf_t       msg;
+
+    if (cl->state == NC_FREE)
+        return;
+
+    Com_Printf("%s dropped: %s\n", NET_AdrToString(&cl->chan.remote_address), reason);
+
+    /* Tell it, unreliably, a few times over */
+    SZ_Init(&msg, buf, sizeof(buf));
+    MSG_WriteByte(&msg, svc_disconnect);
+    Netchan_Transmit(&cl->chan, msg.cursize, msg.data);
+    Netchan_Transmit(&cl->chan, msg.cursize, msg.data);
+    Netchan_Transmit(&cl->chan, msg.cursize, msg.data);
+
+    if (ge && ge->edicts) {
+        edict_t *ent = SV_NetEdict(cl->edictnum);
+
+        if (ge->ClientDisconnect)
+            ge->ClientDisconnect(ent);
+
+        /* The game's ClientDisconnect doesn't free the body yet */
+        if (ent->inuse) {
+            SV_UnlinkEdict(ent);
+            ent->inuse = qfalse;
+        }
+    }
+
+    Z_Free(cl->frame_ents);
+    Z_Free(cl->baselines);
+    memset(cl, 0, sizeof(*cl));
+}
+
+/* ==========================================================================
+   Gamestate
+   ========================================================================== */
+
+/* Whether ent goes to clients at all */
+static qboolean SV_EntitySendable(const edict_t *ent)
+{
+    if (!ent->inuse || (ent->svflags & SVF_NOCLIENT))
+        return qfalse;
+    return ent->s.modelindex || ent->s.effects || ent->s.sound || ent->s.event;
+}
+
+/* Baselines are what each entity looks like now; stay put from here on */
+static void SV_CaptureBaselines(netclient_t *cl)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    int             i;
+
+    memset(cl->baselines, 0, MAX_EDICTS * sizeof(entity_state_t));
+    for (i = 0; i < MAX_EDICTS; i++)
+        cl->baselines[i].number = i;
+
+    if (!ge || !ge->edicts)
+        return;
+
+    for (i = 1; i < ge->num_edicts && i < MAX_EDICTS; i++) {
+        edict_t *ent = SV_NetEdict(i);
+
+        if (!SV_EntitySendable(ent))
+            continue;
+        cl->baselines[i] = ent->s;
+        cl->baselines[i].number = i;
+        cl->baselines[i].event = 0;
+    }
+}
+
+static void SV_StartGamestate(netclient_t *cl)
+{
+    cl->state = NC_CONNECTED;
+    cl->servercount = sv_net.servercount;
+    cl->next_configstring = 0;
+    cl->next_baseline = 0;
+    cl->lastframe = -1;
+    memset(cl->frames, 0, sizeof(cl->frames));
+    SV_CaptureBaselines(cl);
+
+    /* Whatever was queued for the old map is moot */
+    SZ_Clear(&cl->chan.message);
+
+    MSG_WriteByte(&cl->chan.message, svc_serverdata);
+    MSG_WriteLong(&cl->chan.message, PROTOCOL_VERSION);
+    MSG_WriteLong(&cl->chan.message, cl->servercount);
+    MSG_WriteShort(&cl->chan.message, cl->edictnum);
+    MSG_WriteString(&cl->chan.message, SV_GetConfigstring(CS_NAME));
+}
+
+/* Fill the reliable message with as much of the gamestate as fits */
+static void SV_StreamGamestate(netclient_t *cl)
+{
+    sizebuf_t   *msg = &cl->chan.message;
+    int         room;
+    qboolean    any;
+
+    if (!Netchan_CanReliable(&cl->chan) || cl->next_baseline > MAX_EDICTS)
+        return;
+    room = msg->maxsize - GAMESTATE_RESERVE;
+
+    while (cl->next_configstring < MAX_CONFIGSTRINGS) {
+        const char *cs = SV_GetConfigstring(cl->next_configstring);
+        int len = (int)strlen(cs);
+
+        if (len) {
+            if (msg->cursize + len + 4 > room)
+                return;
+            MSG_WriteByte(msg, svc_configstring);
+            MSG_WriteShort(msg, cl->next_configstring);
+            MSG_WriteString(msg, cs);
+        }
+        cl->next_configstring++;
+    }
+
+    /* One bit-packed run of baselines per message */
+    any = qfalse;
+    while (cl->next_baseline < MAX_EDICTS) {
+        static const entity_state_t null_state;
+        const entity_state_t *b = &cl->baselines[cl->next_baseline];
+
+        if (b->modelindex || b->effects || b->sound) {
+            /* A full baseline is under 40 bytes */
+            if (msg->cursize + 48 > room)
+                break;
+            if (!any) {
+                MSG_WriteByte(msg, svc_baselines);
+                any = qtrue;
+            }
+            MSG_WriteDeltaEntity(msg, &null_state, b, qtrue);
+        }
+        cl->next_baseline++;
+    }
+    if (any)
+        MSG_WriteBits(msg, MAX_EDICTS, ENTNUM_BITS);
+
+    if (cl->next_baseline == MAX_EDICTS && msg->cursize + 1 <= room) {
+        MSG_WriteByte(msg, svc_gamestate_done);
+        cl->next_baseline++;
+    }
+}
+
+/* ==========================================================================
+   Frames
+
+   Every tick, before any client's frame is built: the entities that go to
+   clients at all with the clusters each one was linked in, and the PVS row
+   of every cluster a client is looking from, decoded once however many
+   clients share it. That leaves a bit test per client and cluster the
+   entity touches, usually one. The frames themselves are independent and
+   are built and written in parallel on the job system, each into its
+   client's own packet buffer; only the sends happen one at a time.
+   ========================================================================== */
+
+typedef struct {
+    int         number;
+    int         num_clusters;   /* -1 = sent to everyone */
+    const int   *clusters;      /* sv_world.c's, as of the last link */
+} sendent_t;
+
+static struct {
+    sendent_t   ents[MAX_EDICTS];
+    int         num_ents;
+
+    int         clusters[MAX_NETCLIENTS];   /* whose rows[] are decoded */
+    byte        rows[MAX_NETCLIENTS][MAX_VIS_ROW];
+    int         num_rows;
+
+    netclient_t *clients[MAX_NETCLIENTS];   /* getting a frame this tick */
+    int         num_clients;
+
+    int         build_usec;                 /* last tick's parallel part */
+} sv_snap;
+
+static int SV_PointCluster(bsp_world_t *world, vec3_t p)
+{
+    int leaf = BSP_PointLeaf(world, p);
+
+    if (leaf < 0 || leaf >= world->num_leafs)
+        return -1;
+    return world->leafs[leaf].cluster;
+}
+
+/* The per-tick tables the frame jobs read */
+static void SV_PrepareSnapshots(void)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    bsp_world_t     *world = R_GetWorldModel();
+    qboolean        usevis = world && world->loaded && world->vis;
+    int             i, j;
+
+    sv_snap.num_ents = 0;
+    for (i = 1; i < ge->num_edicts && i < MAX_EDICTS; i++) {
+        edict_t     *ent = SV_NetEdict(i);
+        sendent_t   *se;
+
+        if (!SV_EntitySendable(ent))
+            continue;
+
+        se = &sv_snap.ents[sv_snap.num_ents++];
+        se->number = i;
+        se->num_clusters = -1;
+
+        /* Beams stretch between two points */
+        if (usevis && !(ent->s.renderfx & RF_BEAM))
+            se->num_clusters = SV_EntityClusters(i, &se->clusters);
+    }
+
+    sv_snap.num_rows = 0;
+    for (i = 0; i < sv_snap.num_clients; i++) {
+        netclient_t *cl = sv_snap.clients[i];
+        edict_t     *clent = SV_NetEdict(cl->edictnum);
+        vec3_t      org;
+        int         cluster;
+
+        cl->vis_row = -1;
+        if (!usevis)
+            continue;
+
+        VectorCopy(clent->s.origin, org);
+        if (clent->client)
+            org[2] += clent->client->viewheight;
+        cluster = SV_PointCluster(world, org);
+        if (cluster < 0)
+            continue;
+
+        for (j = 0; j < sv_snap.num_rows; j++)
+            if (sv_snap.clusters[j] == cluster)
+                break;
+        if (j == sv_snap.num_rows) {
+            if (!BSP_ClusterRow(world, cluster, DVIS_PVS, sv_snap.rows[j], MAX_VIS_ROW))
+                continue;
+            sv_snap.clusters[j] = cluster;
+            sv_snap.num_rows++;
+        }
+        cl->vis_row = j;
+    }
+}
+
+/* Collect what this client gets this tick into frame, in number order */
+static void SV_BuildClientFrame(netclient_t *cl, netframe_t *frame)
+{
+    edict_t     *clent = SV_NetEdict(cl->edictnum);
+    const byte  *row = cl->vis_row >= 0 ? sv_snap.rows[cl->vis_row] : NULL;
+    int         i;
+
+    frame->framenum = sv_net.framenum;
+    frame->first_entity = cl->next_frame_ent;
+    frame->num_entities = 0;
+    if (clent->client)
+        frame->ps = clent->client->ps;
+    VectorCopy(clent->s.origin, frame->ps.origin);
+    VectorCopy(clent->velocity, frame->ps.velocity);
+
+    for (i = 0; i < sv_snap.num_ents && frame->num_entities < MAX_FRAME_ENTITIES; i++) {
+        const sendent_t *se = &sv_snap.ents[i];
+        entity_state_t  *es;
+
+        /* We always see ourselves */
+        if (row && se->num_clusters >= 0 && se->number != cl->edictnum) {
+            int j;
+
+            for (j = 0; j < se->num_clusters; j++)
+                if (row[se->clusters[j] >> 3] & (1 << (se->clusters[j] & 7)))
+                    break;
+            if (j == se->num_clusters)
+                continue;
+        }
+
+        es = &cl->frame_ents[cl->next_frame_ent++ % (UPDATE_BACKUP * MAX_FRAME_ENTITIES)];
+        *es = SV_NetEdict(se->number)->s;
+        es->number = se->number;
+        frame->num_entities++;
+    }
+}
+
+static entity_state_t *SV_FrameEntity(netclient_t *cl, const netframe_t *frame, int i)
+{
+    return &cl->frame_ents[(frame->first_entity + i) % (UPDATE_BACKUP * MAX_FRAME_ENTITIES)];
+}
+
+/* The entity list as a delta from the old frame, or from the baselines */
+static void SV_EmitPacketEntities(netclient_t *cl, const netframe_t *from,
+                                  const netframe_t *to, sizebuf_t *msg)
+{
+    int oldindex = 0, newindex = 0;
+    int oldmax = from ? from->num_entities : 0;
+
+    while (newindex < to->num_entities || oldindex < oldmax) {
+        const entity_state_t *newent = NULL, *oldent = NULL;
+        int newnum = MAX_EDICTS, oldnum = MAX_EDICTS;
+
+        if (newindex < to->num_entities) {
+            newent = SV_FrameEntity(cl, to, newindex);
+            newnum = newent->number;
+        }
+        if (oldindex < oldmax) {
+            oldent = SV_FrameEntity(cl, from, oldindex);
+            oldnum = oldent->number;
+        }
+
+        if (newnum == oldnum) {
+            MSG_WriteDeltaEntity(msg, oldent, newent, qfalse);
+            oldindex++;
+            newindex++;
+        } else if (newnum < oldnum) {
+            /* Came into view */
+            MSG_WriteDeltaEntity(msg, &cl->baselines[newnum], newent, qtrue);
+            newindex++;
+        } else {
+            /* Gone */
+            MSG_WriteDeltaEntity(msg, oldent, NULL, qtrue);
+            oldindex++;
+        }
+    }
+
+    MSG_WriteBits(msg, MAX_EDICTS, ENTNUM_BITS);
+}
+
+/* One client's frame, built and written into its snapbuf. A job: touches
+   nothing but the client and reads nothing the tick could be changing. */
+static void SV_ClientFrameJob(void *ctx, int index)
+{
+    static const pmove_state_t null_ps;
+    netclient_t *cl = sv_snap.clients[index];
+    netframe_t  *frame = &cl->frames[sv_net.framenum & UPDATE_MASK];
+    netframe_t  *old = NULL;
+    sizebuf_t   msg;
+
+    (void)ctx;
+
+    SV_BuildClientFrame(cl, frame);
+
+    /* Delta from the last acknowledged frame, if it's still in the ring
+       and its entities haven't been written over since */
+    if (cl->lastframe > 0 && sv_net.framenum - cl->lastframe < UPDATE_BACKUP) {
+        old = &cl->frames[cl->lastframe & UPDATE_MASK];
+        if (old->framenum != cl->lastframe ||
+            cl->next_frame_ent - old->first_entity > UPDATE_BACKUP * MAX_FRAME_ENTITIES)
+            old = NULL;
+    }
+
+    SZ_Init(&msg, cl->snapbuf, sizeof(cl->snapbuf));
+    msg.allowoverflow = qtrue;
+
+    MSG_WriteByte(&msg, svc_frame);
+    MSG_WriteLong(&msg, sv_net.framenum);
+    MSG_WriteLong(&msg, old ? old->framenum : -1);
+    MSG_WriteDeltaPmove(&msg, old ? &old->ps : &null_ps, &frame->ps);
+    SV_EmitPacketEntities(cl, old, frame, &msg);
+
+    cl->snap_overflowed = msg.overflowed;
+    cl->snap_bytes = msg.overflowed ? 0 : msg.cursize;
+    frame->bytes = cl->snap_bytes;
+}
+
+static void SV_SendClientFrames(void)
+{
+    uint64_t    start;
+    int         i;
+
+    if (!sv_snap.num_clients)
+        return;
+
+    start = Sys_PerfCounter();
+    SV_PrepareSnapshots();
+    Job_ParallelFor("SV_ClientFrame", SV_ClientFrameJob, NULL, sv_snap.num_clients);
+    sv_snap.build_usec = (int)((Sys_PerfCounter() - start) * 1000000 / Sys_PerfFrequency());
+
+    for (i = 0; i < sv_snap.num_clients; i++) {
+        netclient_t *cl = sv_snap.clients[i];
+        netframe_t  *frame = &cl->frames[sv_net.framenum & UPDATE_MASK];
+
+        if (cl->snap_overflowed)
+            Com_DPrintf("%s: frame overflowed\n", NET_AdrToString(&cl->chan.remote_address));
+
+        frame->sent_time = Sys_Milliseconds();
+        cl->snap_entities = frame->num_entities;
+        cl->snap_total += cl->snap_bytes;
+        cl->snaps++;
+
+        Netchan_Transmit(&cl->chan, cl->snap_bytes, cl->snapbuf);
+    }
+}
+
+/*
+ * SV_SendClientMessages — After every game tick: a frame for everyone in
+ * the game, the next piece of the gamestate for those joining
+ */
+void SV_SendClientMessages(void)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    int             now = Sys_Milliseconds();
+    int             i;
+
+    if (!sv_net.num_clients || !ge || !ge->edicts)
+        return;
+
+    sv_net.framenum++;
+    sv_snap.num_clients = 0;
+
+    for (i = 0; i < sv_net.num_clients; i++) {
+        netclient_t *cl = &sv_net.clients[i];
+
+        if (cl->state == NC_FREE)
+            continue;
+
+        if (cl->chan.fatal_error) {
+            SV_DropClient(cl, "reliable overflow");
+            continue;
+        }
+        if (now - cl->chan.last_received > (int)(sv_timeout->value * 1000)) {
+            SV_DropClient(cl, "timed out");
+            continue;
+        }
+
+        if (cl->state == NC_CONNECTED) {
+            SV_StreamGamestate(cl);
+            Netchan_Transmit(&cl->chan, 0, NULL);
+        } else {
+            sv_snap.clients[sv_snap.num_clients++] = cl;
+        }
+    }
+
+    SV_SendClientFrames();
+}
+
+/* ==========================================================================
+   Client Messages
+   ========================================================================== */
+
+static void SV_ClientStringCommand(netclient_t *cl, char *s)
+{
+    game_export_t *ge = SV_GetGameExport();
+
+    Cmd_TokenizeString(s, qfalse);
+
+    if (!Q_stricmp(Cmd_Argv(0), "begin")) {
+        if (cl->state != NC_CONNECTED || atoi(Cmd_Argv(1)) != cl->servercount)
+            return;     /* for a previous map */
+        cl->state = NC_SPAWNED;
+        if (ge->ClientBegin)
+            ge->ClientBegin(SV_NetEdict(cl->edictnum));
+    } else if (!Q_stricmp(Cmd_Argv(0), "disconnect")) {
+        SV_DropClient(cl, "disconnected");
+    } else if (cl->state == NC_SPAWNED && ge->ClientCommand) {
+        ge->ClientCommand(SV_NetEdict(cl->edictnum));
+    }
+}
+
+static void SV_ExecuteClientMessage(netclient_t *cl, sizebuf_t *msg)
+{
+    game_export_t *ge = SV_GetGameExport();
+
+    for (;;) {
+        int c;
+
+        if (msg->readcount > msg->cursize) {
+            SV_DropClient(cl, "bad read");
+            return;
+        }
+
+        c = MSG_ReadByte(msg);
+        if (c == -1)
+            return;
+
+        switch (c) {
+        case clc_nop:
+            break;
+
+        case clc_move: {
+            usercmd_t   cmds[3];
+            int         ack = MSG_ReadLong(msg);
+            int         count = MSG_ReadByte(msg);
+            int         i, dropped;
+            static const usercmd_t null_cmd;
+
+            /* Ping off the frame it acknowledged */
+            if (ack > cl->lastframe && ack <= sv_net.framenum) {
+                netframe_t *f = &cl->frames[ack & UPDATE_MASK];
+
+                if (f->framenum == ack)
+                    cl->ping = Sys_Milliseconds() - f->sent_time;
+                cl->lastframe = ack;
+            }
+
+            if (count < 1 || count > 3) {
+                SV_DropClient(cl, "bad clc_move");
+                return;
+            }
+
+            /* Oldest first, each against the one before */
+            for (i = 0; i < count; i++)
+                MSG_ReadDeltaUsercmd(msg, (void *)(i ? &cmds[i - 1] : &null_cmd), &cmds[i]);
+            if (msg->readcount > msg->cursize)
+                break;
+
+            if (cl->state != NC_SPAWNED || !ge->ClientThink)
+                break;
+
+            /* The older copies stand in for packets that were lost */
+            dropped = cl->chan.stats.dropped - cl->lastdropped;
+            cl->lastdropped = cl->chan.stats.dropped;
+            if (dropped > count - 1)
+                dropped = count - 1;
+            for (i = count - 1 - dropped; i < count; i++)
+                ge->ClientThink(SV_NetEdict(cl->edictnum), &cmds[i]);
+            cl->lastcmd = cmds[count - 1];
+            break;
+        }
+
+        case clc_stringcmd:
+            SV_ClientStringCommand(cl, MSG_ReadString(msg));
+            if (cl->state == NC_FREE)
+                return;
+            break;
+
+        default:
+            SV_DropClient(cl, "unknown command");
+            return;
+        }
+    }
+}
+
+/* ==========================================================================
+   Connectionless
+   ========================================================================== */
+
+static void SVC_GetChallenge(const netadr_t *from)
+{
+    challenge_t *c, *oldest = &sv_net.challenges[0];
+    int i;
+
+    for (i = 0; i < MAX_CHALLENGES; i++) {
+        c = &sv_net.challenges[i];
+        if (NET_CompareBaseAdr(&c->adr, from))
+            break;
+        if (c->time < oldest->time)
+            oldest = c;
+    }
+
+    if (i == MAX_CHALLENGES) {
+        c = oldest;
+        c->adr = *from;
+        c->challenge = (rand() << 16) ^ rand() ^ Sys_Milliseconds();
+    }
+    c->time = Sys_Milliseconds();
+
+    Netchan_OutOfBandPrint(from, "challenge %i", c->challenge);
+}
+
+static void SVC_Connect(const netadr_t *from)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    netclient_t     *cl = NULL;
+    char            userinfo[MAX_INFO_STRING];
+    int             protocol, port, challenge, i;
+
+    protocol = atoi(Cmd_Argv(1));
+    port = atoi(Cmd_Argv(2)) & 0xffff;
+    challenge = atoi(Cmd_Argv(3));
+    Q_strncpyz(userinfo, Cmd_Argv(4), sizeof(userinfo));
+
+    if (protocol != PROTOCOL_VERSION) {
+        Netchan_OutOfBandPrint(from, "print\nServer uses protocol %i.\n", PROTOCOL_VERSION);
+        return;
+    }
+
+    for (i = 0; i < MAX_CHALLENGES; i++)
+        if (NET_CompareBaseAdr(&sv_net.challenges[i].adr, from))
+            break;
+    if (i == MAX_CHALLENGES || sv_net.challenges[i].challenge != challenge) {
+        Netchan_OutOfBandPrint(from, "print\nBad challenge.\n");
+        return;
+    }
+
+    /* A reconnect from the same player takes its old slot */
+    for (i = 0; i < sv_net.num_clients; i++) {
+        netclient_t *c = &sv_net.clients[i];
+
+        if (c->state != NC_FREE && NET_CompareBaseAdr(&c->chan.remote_address, from) &&
+            (c->chan.qport == port || c->chan.remote_address.port == from->port)) {
+            SV_DropClient(c, "reconnected");
+            break;
+        }
+    }
+
+    for (i = 0; i < sv_net.num_clients; i++) {
+        if (sv_net.clients[i].state == NC_FREE) {
+            cl = &sv_net.clients[i];
+            break;
+        }
+    }
+    if (!cl || !ge || !ge->edicts) {
+        Netchan_OutOfBandPrint(from, "print\nServer is full.\n");
+        return;
+    }
+
+    memset(cl, 0, sizeof(*cl));
+    cl->edictnum = 2 + i;
+    Q_strncpyz(cl->userinfo, userinfo, sizeof(cl->userinfo));
+
+    if (ge->ClientConnect && !ge->ClientConnect(SV_NetEdict(cl->edictnum), cl->userinfo)) {
+        Netchan_OutOfBandPrint(from, "print\nConnection refused.\n");
+        return;
+    }
+
+    cl->frame_ents = (entity_state_t *)Z_Malloc(UPDATE_BACKUP * MAX_FRAME_ENTITIES *
+                                                sizeof(entity_state_t));
+    cl->baselines = (entity_state_t *)Z_Malloc(MAX_EDICTS * sizeof(entity_state_t));
+
+    Netchan_Setup(&cl->chan, qfalse, from, port);
+    Netchan_OutOfBandPrint(from, "client_connect");
+    SV_StartGamestate(cl);
+
+    Com_Printf("%s connected as client %i\n", NET_AdrToString(from), cl->edictnum);
+}
+
+static void SVC_Info(const netadr_t *from)
+{
+    int i, count = 0;
+
+    for (i = 0; i < sv_net.num_clients; i++)
+        if (sv_net.clients[i].state != NC_FREE)
+            count++;
+
+    Netchan_OutOfBandPrint(from, "info\n%s %s %i %i\n", hostname->string,
+                           SV_GetConfigstring(CS_NAME), count, sv_net.num_clients);
+}
+
+static void SV_ConnectionlessPacket(const netadr_t *from, sizebuf_t *msg)
+{
+    char *s, *c;
+
+    MSG_BeginReading(msg);
+    MSG_ReadLong(msg);      /* -1 */
+
+    s = MSG_ReadString(msg);
+    Cmd_TokenizeString(s, qfalse);
+    c = Cmd_Argv(0);
+
+    if (!strcmp(c, "getchallenge"))
+        SVC_GetChallenge(from);
+    else if (!strcmp(c, "connect"))
+        SVC_Connect(from);
+    else if (!strcmp(c, "info"))
+        SVC_Info(from);
+    else
+        Com_DPrintf("Bad connectionless packet from %s: %s\n", NET_AdrToString(from), s);
+}
+
+/*
+ * SV_ReadPackets — Everything that arrived since the last frame. The
+ * main thread, game locked.
+ */
+void SV_ReadPackets(void)
+{
+    netadr_t    from;
+    sizebuf_t   msg;
+    int         i;
+
+    if (!NET_IsOpen())
+        return;
+
+    SZ_Init(&msg, sv_packetbuf, sizeof(sv_packetbuf));
+
+    while (NET_GetPacket(&from, &msg)) {
+        int port;
+
+        if (msg.cursize >= 4 && *(int *)msg.data == -1) {
+            SV_ConnectionlessPacket(&from, &msg);
+            continue;
+        }
+        if (msg.cursize < PACKET_HEADER)
+            continue;
+
+        /* By address and qport, since a NAT may have changed the port */
+        MSG_BeginReading(&msg);
+        MSG_ReadLong(&msg);
+        MSG_ReadLong(&msg);
+        port = MSG_ReadShort(&msg) & 0xffff;
+
+        for (i = 0; i < sv_net.num_clients; i++) {
+            netclient_t *cl = &sv_net.clients[i];
+
+            if (cl->state == NC_FREE || !NET_CompareBaseAdr(&from, &cl->chan.remote_address) ||
+                cl->chan.qport != port)
+                continue;
+
+            if (cl->chan.remote_address.port != from.port) {
+                Com_Printf("%s: fixing up a translated port\n", NET_AdrToString(&from));
+                cl->chan.remote_address.port = from.port;
+            }
+
+            if (Netchan_Process(&cl->chan, &msg))
+                SV_ExecuteClientMessage(cl, &msg);
+            break;
+        }
+    }
+}
+
+/* ==========================================================================
+   Map Changes and Configstrings
+   ========================================================================== */
+
+/* A new map's entities have spawned: everyone loads it again */
+void SV_NetMapChanged(void)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    int             i;
+
+    sv_net.servercount++;
+
+    for (i = 0; i < sv_net.num_clients; i++) {
+        netclient_t *cl = &sv_net.clients[i];
+
+        if (cl->state == NC_FREE)
+            continue;
+
+        if (ge && ge->ClientConnect &&
+            !ge->ClientConnect(SV_NetEdict(cl->edictnum), cl->userinfo)) {
+            SV_DropClient(cl, "refused on map change");
+            continue;
+        }
+        SV_StartGamestate(cl);
+    }
+}
+
+/* Pass a configstring change on to whoever has already had that one */
+void SV_NetConfigstring(int index, const char *val)
+{
+    int i;
+
+    for (i = 0; i < sv_net.num_clients; i++) {
+        netclient_t *cl = &sv_net.clients[i];
+
+        if (cl->state == NC_FREE || (cl->state == NC_CONNECTED && index >= cl->next_configstring))
+            continue;
+
+        MSG_WriteByte(&cl->chan.message, svc_configstring);
+        MSG_WriteShort(&cl->chan.message, index);
+        MSG_WriteString(&cl->chan.message, val);
+    }
+}
+
+/* ==========================================================================
+   Stats
+   ========================================================================== */
+
+static void SV_NetStats_f(void)
+{
+    int i, count = 0;
+
+    Com_Printf("num state  ping  in B/s out B/s  pkts in/out   drop  largest  snap B  ents  avg snap  address\n");
+    for (i = 0; i < sv_net.num_clients; i++) {
+        netclient_t *cl = &sv_net.clients[i];
+        netstats_t  *st = &cl->chan.stats;
+
+        if (cl->state == NC_FREE)
+            continue;
+        count++;
+
+        Com_Printf("%3i %-6s %4i %7i %7i %6i/%-6i %5i %8i %7i %5i %9i  %s\n",
+                   cl->edictnum, cl->state == NC_SPAWNED ? "game" : "load", cl->ping,
+                   st->in_rate, st->out_rate, st->in_packets, st->out_packets,
+                   st->dropped, st->largest_out, cl->snap_bytes, cl->snap_entities,
+                   cl->snaps ? cl->snap_total / cl->snaps : 0,
+                   NET_AdrToString(&cl->chan.remote_address));
+    }
+    Com_Printf("%i remote client%s, %i slots\n", count, count == 1 ? "" : "s",
+               sv_net.num_clients);
+    Com_Printf("last frames: %i us for %i clients, %i entities, %i PVS rows\n",
+               sv_snap.build_usec, sv_snap.num_clients, sv_snap.num_ents, sv_snap.num_rows);
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+void SV_InitNet(void)
+{
+    int max;
+
+    net_listen = Cvar_Get("net_listen", "0", CVAR_LATCH);
+    sv_timeout = Cvar_Get("sv_timeout", "30", 0);
+    hostname = Cvar_Get("hostname", "SoF server", CVAR_SERVERINFO | CVAR_ARCHIVE);
+    Cmd_AddCommand("sv_netstats", SV_NetStats_f);
+
+    /* Slot 0 of the game's clients is the local player */
+    max = (int)Cvar_VariableValue("maxclients") - 1;
+    if (max > MAX_NETCLIENTS)
+        max = MAX_NETCLIENTS;
+    sv_net.num_clients = max > 0 ? max : 0;
+
+    if (!(dedicated && dedicated->value) && !net_listen->value)
+        return;
+    if (!sv_net.num_clients) {
+        Com_Printf("SV_InitNet: maxclients leaves no room for remote players\n");
+        return;
+    }
+    NET_Config(qtrue);
+}
+
+void SV_ShutdownNet(void)
+{
+    int i;
+
+    for (i = 0; i < sv_net.num_clients; i++)
+        SV_DropClient(&sv_net.clients[i], "server shutdown");
+    NET_Config(qfalse);
+}
@@ -0,0 +1,176 @@
+/*
+ * sv_snap.c - Renderable entity snapshots
+ *
+ * After every game tick the server copies the state the renderer needs out
+ * of the edicts into a snapshot_t and publishes it. The renderer draws from
+ * the latest snapshot and never touches edicts, so it can run while the
+ * next tick is being simulated on another thread (sv_thread.c).
+ *
+ * Three buffers rotate between the two sides: the writer fills one, one
+ * holds the most recent complete snapshot, and the reader owns the third
+ * for the whole frame. The lock only covers the index swap. Each entity
+ * carries its previous-tick origin, angles and frame, so one snapshot is
+ * enough to interpolate from.
+ */
+
+#include "../common/qcommon.h"
+#include "../game/g_local.h"
+
+#include <math.h>
+
+#define SNAP_BUFFERS        3
+#define SNAP_TELEPORT_DIST  256     /* further than this in a tick: don't lerp */
+
+static snapshot_t   sv_snaps[SNAP_BUFFERS];
+
+static struct {
+    void        *lock;
+    int         write;          /* owned by the writer */
+    int         ready;          /* last published */
+    int         read;           /* owned by the reader */
+    qboolean    fresh;          /* ready is newer than read */
+    int         sequence;
+} sv_snap;
+
+/* Writer side: where each edict was as of the last published tick */
+typedef struct {
+    int         sequence;       /* tick it was last seen in, 0 = never */
+    vec3_t      origin;
+    vec3_t      angles;
+    int         frame;
+} snapprev_t;
+
+static snapprev_t   sv_snapprev[SNAP_MAX_ENTITIES];
+
+extern game_export_t *SV_GetGameExport(void);
+
+/* ==========================================================================
+   Init
+   ========================================================================== */
+
+void SV_InitSnapshots(void)
+{
+    sv_snap.lock = Sys_CreateMutex();
+    sv_snap.write = 0;
+    sv_snap.ready = 1;
+    sv_snap.read = 2;
+    SV_ClearSnapshots();
+}
+
+/* New map: nothing published so far is valid. Call with the game locked. */
+void SV_ClearSnapshots(void)
+{
+    int i;
+
+    Sys_LockMutex(sv_snap.lock);
+    for (i = 0; i < SNAP_BUFFERS; i++) {
+        sv_snaps[i].num_entities = 0;
+        sv_snaps[i].sequence = 0;
+        sv_snaps[i].time = Sys_PerfCounter();
+    }
+    sv_snap.fresh = qfalse;
+    Sys_UnlockMutex(sv_snap.lock);
+
+    memset(sv_snapprev, 0, sizeof(sv_snapprev));
+}
+
+/* ==========================================================================
+   Writer
+   ========================================================================== */
+
+static qboolean SV_SnapTeleported(const vec3_t from, const vec3_t to)
+{
+    return fabs(to[0] - from[0]) > SNAP_TELEPORT_DIST ||
+           fabs(to[1] - from[1]) > SNAP_TELEPORT_DIST ||
+           fabs(to[2] - from[2]) > SNAP_TELEPORT_DIST;
+}
+
+/*
+ * SV_PublishSnapshot — copy renderable state out of the edicts.
+ * Runs on whichever thread just finished the tick, with the game locked.
+ */
+void SV_PublishSnapshot(void)
+{
+    game_export_t   *ge = SV_GetGameExport();
+    snapshot_t      *snap = &sv_snaps[sv_snap.write];
+    int             i, seq, tmp;
+
+    seq = ++sv_snap.sequence;
+    snap->sequence = seq;
+    snap->num_entities = 0;
+
+    if (ge && ge->edicts) {
+        for (i = 1; i < ge->num_edicts && i < SNAP_MAX_ENTITIES; i++) {
+            edict_t     *ent = (edict_t *)((byte *)ge->edicts + i * ge->edict_size);
+            snapent_t   *se;
+            snapprev_t  *prev = &sv_snapprev[i];
+
+            if (!ent->inuse)
+                continue;
+
+            se = &snap->entities[snap->num_entities++];
+            se->s = ent->s;
+            se->s.number = i;
+            VectorCopy(ent->mins, se->mins);
+            VectorCopy(ent->maxs, se->maxs);
+            se->solid = ent->solid;
+            se->svflags = ent->svflags;
+            se->health = ent->health;
+            se->deadflag = ent->deadflag;
+            se->gore_zone_mask = ent->gore_zone_mask;
+            se->severed_zone_mask = ent->severed_zone_mask;
+            se->client = ent->client != NULL;
+
+            /* Only lerp from a state this same entity had last tick */
+            if (prev->sequence == seq - 1 &&
+                !SV_SnapTeleported(prev->origin, ent->s.origin)) {
+                VectorCopy(prev->origin, se->s.old_origin);
+                VectorCopy(prev->angles, se->old_angles);
+                se->oldframe = prev->frame;
+            } else {
+                VectorCopy(ent->s.origin, se->s.old_origin);
+                VectorCopy(ent->s.angles, se->old_angles);
+                se->oldframe = ent->s.frame;
+            }
+
+            prev->sequence = seq;
+            VectorCopy(ent->s.origin, prev->origin);
+            VectorCopy(ent->s.angles, prev->angles);
+            prev->frame = ent->s.frame;
+        }
+    }
+
+    snap->time = Sys_PerfCounter();
+
+    Sys_LockMutex(sv_snap.lock);
+    tmp = sv_snap.ready;
+    sv_snap.ready = sv_snap.write;
+    sv_snap.write = tmp;
+    sv_snap.fresh = qtrue;
+    Sys_UnlockMutex(sv_snap.lock);
+}
+
+/* ==========================================================================
+   Reader
+   ========================================================================== */
+
+/* Pick up the newest snapshot. Main thread, once per frame, before drawing. */
+void SV_AcquireSnapshot(void)
+{
+    int tmp;
+
+    Sys_LockMutex(sv_snap.lock);
+    if (sv_snap.fresh) {
+        tmp = sv_snap.read;
+        sv_snap.read = sv_snap.ready;
+        sv_snap.ready = tmp;
+        sv_snap.fresh = qfalse;
+    }
+    Sys_UnlockMutex(sv_snap.lock);
+}
+
+/* The snapshot this frame draws. Stays put until the next acquire. */
+const snapshot_t *SV_GetSnapshot(void)
+{
+    return &sv_snaps[sv_snap.read];
+}
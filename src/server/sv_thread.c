@@ -0,0 +1,215 @@
+/*
+ * sv_thread.c - Game simulation thread
+ *
+ * With sv_simthread 1 the 10 Hz game tick runs on its own thread instead of
+ * inside SV_Frame, and publishes a snapshot (sv_snap.c) when it finishes.
+ * The main thread keeps rendering at whatever rate the display allows and
+ * interpolates from the latest snapshot, so a slow AI tick no longer shows
+ * up as a slow frame, and a slow frame no longer delays the tick.
+ *
+ * Game state is not thread safe, so it is guarded by one lock. The sim
+ * thread holds it for a whole tick; the main thread holds it around the
+ * parts of its frame that read or write live game or HUD state: command
+ * execution, CL_Frame and the 2D HUD. World and entity rendering work from
+ * the snapshot and don't need it. A tick can hold the lock for a long time,
+ * so the game calls SV_GameYield between entities: if the main thread is
+ * waiting, the sim thread hands the lock over and waits until it's back.
+ *
+ * With sv_simthread 0 (the default) none of the locks exist and every call
+ * here is a no-op.
+ */
+
+#include "../common/qcommon.h"
+
+#define SIM_TICK_MSEC   100     /* the game's fixed frame time */
+
+static struct {
+    void            *thread;
+    void            *gamelock;
+    void            *yield_sem;     /* posted when a yielded lock comes back */
+    void            *quit_sem;      /* doubles as the tick timer */
+    volatile int    quit;
+    volatile int    wanted;         /* main thread is waiting for the lock */
+    int             yielded;        /* sim thread is waiting for it back */
+    int             held;           /* main thread's lock depth */
+    unsigned long   threadid;
+    uint64_t        period;         /* current tick length, perf counter units */
+} sv_sim;
+
+static cvar_t   *sv_simthread;
+
+extern cvar_t   *timescale;
+extern cvar_t   *dedicated;
+extern void     SV_RunGameFrame(void);
+
+/* ==========================================================================
+   Game Lock
+   ========================================================================== */
+
+void SV_LockGame(void)
+{
+    if (!sv_sim.gamelock)
+        return;
+
+    sv_sim.wanted = 1;
+    Sys_LockMutex(sv_sim.gamelock);
+    sv_sim.wanted = 0;
+    sv_sim.held++;
+}
+
+void SV_UnlockGame(void)
+{
+    qboolean handback;
+
+    if (!sv_sim.gamelock)
+        return;
+
+    sv_sim.held--;
+    handback = sv_sim.yielded;
+    sv_sim.yielded = 0;
+    Sys_UnlockMutex(sv_sim.gamelock);
+
+    if (handback)
+        Sys_SemPost(sv_sim.yield_sem);
+}
+
+/*
+ * SV_GameYield — called by the game between entities. Sim thread only.
+ * The flag is read unlocked; missing it just means one more entity runs
+ * before the main thread gets in.
+ */
+void SV_GameYield(void)
+{
+    if (!sv_sim.gamelock || !sv_sim.wanted || Sys_ThreadID() != sv_sim.threadid)
+        return;
+
+    sv_sim.yielded = 1;
+    Sys_UnlockMutex(sv_sim.gamelock);
+    Sys_SemWait(sv_sim.yield_sem, -1);
+    Sys_LockMutex(sv_sim.gamelock);
+}
+
+/* ==========================================================================
+   Sim Thread
+   ========================================================================== */
+
+static int SV_SimThread(void *arg)
+{
+    uint64_t    freq = Sys_PerfFrequency();
+    uint64_t    deadline = Sys_PerfCounter();
+
+    (void)arg;
+    sv_sim.threadid = Sys_ThreadID();
+
+    while (!sv_sim.quit) {
+        float       scale = timescale && timescale->value > 0 ? timescale->value : 1.0f;
+        uint64_t    now;
+
+        sv_sim.period = (uint64_t)((double)freq * SIM_TICK_MSEC / 1000.0 / scale);
+        deadline += sv_sim.period;
+
+        now = Sys_PerfCounter();
+        if (now < deadline) {
+            int ms = (int)((deadline - now) * 1000 / freq);
+
+            /* Woken early only by shutdown */
+            if (ms > 0 && Sys_SemWait(sv_sim.quit_sem, ms))
+                break;
+        } else if (now - deadline > sv_sim.period) {
+            deadline = now;     /* fell a whole tick behind: don't burst */
+        }
+
+        Sys_LockMutex(sv_sim.gamelock);
+        SV_RunGameFrame();
+        SV_PublishSnapshot();
+        SV_SendClientMessages();
+        Sys_UnlockMutex(sv_sim.gamelock);
+    }
+
+    return 0;
+}
+
+/* ==========================================================================
+   Interpolation
+   ========================================================================== */
+
+/* How far the render clock is past the snapshot being drawn, 0..1 */
+float SV_SimThreadLerp(void)
+{
+    const snapshot_t    *snap = SV_GetSnapshot();
+    uint64_t            now = Sys_PerfCounter();
+    float               frac;
+
+    if (!sv_sim.period || now <= snap->time)
+        return 0.0f;
+
+    frac = (float)((double)(now - snap->time) / (double)sv_sim.period);
+    return frac > 1.0f ? 1.0f : frac;
+}
+
+qboolean SV_SimThreadActive(void)
+{
+    return sv_sim.thread != NULL;
+}
+
+/* ==========================================================================
+   Init / Shutdown
+   ========================================================================== */
+
+void SV_InitSimThread(void)
+{
+    sv_simthread = Cvar_Get("sv_simthread", "0", CVAR_ARCHIVE | CVAR_LATCH);
+
+    /* Nothing to decouple from without a renderer */
+    if (!sv_simthread->value || (dedicated && dedicated->value))
+        return;
+
+    if (Sys_CPUCount() < 2) {
+        Com_Printf("sv_simthread: single core, running the game on the main thread\n");
+        return;
+    }
+
+    sv_sim.gamelock = Sys_CreateMutex();
+    sv_sim.yield_sem = Sys_CreateSemaphore(0);
+    sv_sim.quit_sem = Sys_CreateSemaphore(0);
+    if (!sv_sim.gamelock || !sv_sim.yield_sem || !sv_sim.quit_sem) {
+        Com_Printf("SV_InitSimThread: couldn't create sync objects\n");
+        SV_ShutdownSimThread();
+        return;
+    }
+
+    sv_sim.quit = 0;
+    sv_sim.thread = Sys_CreateThread(SV_SimThread, "sv_sim", NULL);
+    if (!sv_sim.thread) {
+        Com_Printf("SV_InitSimThread: couldn't start thread\n");
+        SV_ShutdownSimThread();
+        return;
+    }
+
+    Com_Printf("Game simulation running on its own thread\n");
+}
+
+/* Usually reached from "quit", i.e. from inside a locked Cbuf_Execute */
+void SV_ShutdownSimThread(void)
+{
+    if (sv_sim.thread) {
+        /* A fatal error on the sim thread itself: it can't wait for itself */
+        if (Sys_ThreadID() == sv_sim.threadid) {
+            sv_sim.quit = 1;
+            return;
+        }
+
+        while (sv_sim.held > 0)
+            SV_UnlockGame();
+
+        sv_sim.quit = 1;
+        Sys_SemPost(sv_sim.quit_sem);
+        Sys_WaitThread(sv_sim.thread);
+        sv_sim.thread = NULL;
+    }
+
+    Sys_DestroySemaphore(sv_sim.quit_sem);
+    Sys_DestroySemaphore(sv_sim.yield_sem);
+    Sys_DestroyMutex(sv_sim.gamelock);
+    sv_sim.quit_sem = sv_sim.yield_sem = sv_sim.gamelock = NULL;
+}
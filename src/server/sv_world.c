@@ -1,12 +1,13 @@
 /*
  * sv_world.c - Entity area linking and spatial queries
  *
- * Manages entity-to-world spatial relationships using an area node tree.
- * Entities are linked into BSP area nodes for efficient spatial queries.
+ * Manages entity-to-world spatial relationships using a loose octree.
+ * Entities are linked into octree nodes for efficient spatial queries.
  *
  * Key functions:
  *   SV_LinkEdict   — Insert entity into world, compute absmin/absmax
  *   SV_UnlinkEdict — Remove entity from world
+ *   SV_EntityClusters — PVS clusters an entity's bounds touch
  *   SV_AreaEdicts  — Find all entities within an AABB (for triggers, combat)
  *
  * Original SoF: SV_LinkEdict=0x2A870, SV_AreaEdicts=0x2A680
@@ -18,123 +19,321 @@
 #include "../renderer/r_bsp.h"
 
 /* ==========================================================================
-   Area Node Tree
-   Subdivides world space for efficient entity spatial queries.
+   World Partition
+   A loose octree over the world bounds. Every linked entity sits in
+   exactly one node: the deepest whose cell is at least as big as the
+   entity, found from the entity's centre. A node's loose bounds are its
+   cell grown by half a cell on every side, so whatever is stored there
+   lies inside them. Each node keeps separate solid and trigger lists,
+   which have no cap, and a count of the entities at or below it, so a
+   query skips empty subtrees. Entities whose centre is outside the
+   world go in the root, which is always searched.
+
+   Links are kept here by entity number rather than in edict_t. A relink
+   whose node and list haven't changed only refreshes the bounds, and
+   unlinking is O(1).
    ========================================================================== */
 
-#define AREA_DEPTH      4
-#define AREA_NODES      32      /* 2^(AREA_DEPTH+1) - 1 */
+#define AREA_DEPTH      5       /* levels below the root */
+#define AREA_NODES      37449   /* (8^(AREA_DEPTH+1) - 1) / 7 */
+#define AREA_LISTS      2       /* solid, trigger */
 
-typedef struct areanode_s {
-    int     axis;           /* -1 = leaf node */
-    float   dist;           /* split distance */
-    int     children[2];    /* child node indices */
-
-    /* Linked list of entities in this node */
-    int     num_entities;
-    edict_t *entities[256]; /* Max entities per node */
+typedef struct {
+    int     head[AREA_LISTS];   /* first entity number, -1 = empty */
+    int     count;              /* entities in this node and below */
 } areanode_t;
 
+typedef struct {
+    int     node;               /* -1 = not in the partition */
+    int     list;
+    int     prev, next;         /* entity numbers within the node's list */
+} arealink_t;
+
 static areanode_t   sv_areanodes[AREA_NODES];
-static int          sv_numareanodes;
+static arealink_t   sv_arealinks[MAX_EDICTS];
+static int          sv_levelfirst[AREA_DEPTH + 1];  /* first node of each level */
 
 static vec3_t       world_mins, world_maxs;
+static vec3_t       area_origin;    /* root cell's minimum corner */
+static float        area_size;      /* root cell's edge length */
 
 /* ==========================================================================
-   Area Node Construction
+   Entity Clusters
+   Every PVS cluster the entity's bounds touch, recorded at link time as
+   Q2's SV_LinkEdict does, so the frame builder tests each against the
+   viewer's row. Too many clusters, no vis data or an unlinked entity
+   means it goes to everyone.
    ========================================================================== */
 
-static int SV_CreateAreaNode(int depth, vec3_t mins, vec3_t maxs)
-{
-    areanode_t *anode;
-    vec3_t size, mins1, maxs1, mins2, maxs2;
-    int idx;
+#define MAX_ENT_CLUSTERS    16
+#define MAX_ENT_LEAFS       128
 
-    idx = sv_numareanodes;
-    if (sv_numareanodes >= AREA_NODES)
-        return 0;
+typedef struct {
+    int     num_clusters;       /* -1 = always sent */
+    int     clusternums[MAX_ENT_CLUSTERS];
+} entclusters_t;
 
-    anode = &sv_areanodes[sv_numareanodes++];
-    memset(anode, 0, sizeof(*anode));
+static entclusters_t sv_entclusters[MAX_EDICTS];
 
-    if (depth == AREA_DEPTH) {
-        anode->axis = -1;  /* leaf */
-        anode->children[0] = -1;
-        anode->children[1] = -1;
-        return idx;
-    }
+extern game_export_t *SV_GetGameExport(void);
+extern bsp_world_t *R_GetWorldModel(void);
 
-    VectorSubtract(maxs, mins, size);
-    if (size[0] > size[1])
-        anode->axis = 0;
-    else
-        anode->axis = 1;
+static edict_t *SV_EdictNum(int num)
+{
+    return (edict_t *)((byte *)SV_GetGameExport()->edicts +
+                       num * SV_GetGameExport()->edict_size);
+}
 
-    anode->dist = 0.5f * (maxs[anode->axis] + mins[anode->axis]);
+static int SV_NumForEdict(edict_t *ent)
+{
+    game_export_t *ge = SV_GetGameExport();
 
-    VectorCopy(mins, mins1);
-    VectorCopy(maxs, maxs1);
-    VectorCopy(mins, mins2);
-    VectorCopy(maxs, maxs2);
+    if (!ge || !ge->edicts)
+        return -1;
+    return (int)(((byte *)ent - (byte *)ge->edicts) / ge->edict_size);
+}
 
-    maxs1[anode->axis] = anode->dist;
-    mins2[anode->axis] = anode->dist;
+static void SV_ResetAreaNodes(void)
+{
+    int i, n, first = 0;
 
-    anode->children[0] = SV_CreateAreaNode(depth + 1, mins2, maxs2);
-    anode->children[1] = SV_CreateAreaNode(depth + 1, mins1, maxs1);
+    for (i = 0, n = 1; i <= AREA_DEPTH; i++, n *= 8) {
+        sv_levelfirst[i] = first;
+        first += n;
+    }
 
-    return idx;
+    for (i = 0; i < AREA_NODES; i++) {
+        sv_areanodes[i].head[0] = sv_areanodes[i].head[1] = -1;
+        sv_areanodes[i].count = 0;
+    }
+    for (i = 0; i < MAX_EDICTS; i++) {
+        sv_arealinks[i].node = -1;
+        sv_arealinks[i].prev = sv_arealinks[i].next = -1;
+        sv_entclusters[i].num_clusters = -1;
+    }
 }
 
-void SV_ClearWorld(void)
+/* A cube around the world bounds, so every level's cells are cubes too */
+static void SV_SetAreaRoot(void)
 {
-    sv_numareanodes = 0;
+    int i;
+
+    area_size = 0;
+    for (i = 0; i < 3; i++) {
+        if (world_maxs[i] - world_mins[i] > area_size)
+            area_size = world_maxs[i] - world_mins[i];
+    }
+    if (area_size < 64)
+        area_size = 64;
+    for (i = 0; i < 3; i++)
+        area_origin[i] = 0.5f * (world_mins[i] + world_maxs[i]) - 0.5f * area_size;
+}
 
+void SV_ClearWorld(void)
+{
     /* Use default world bounds if no BSP loaded */
     VectorSet(world_mins, -4096, -4096, -4096);
     VectorSet(world_maxs, 4096, 4096, 4096);
 
-    SV_CreateAreaNode(0, world_mins, world_maxs);
-}
-
-void SV_SetWorldBounds(vec3_t mins, vec3_t maxs)
-{
-    VectorCopy(mins, world_mins);
-    VectorCopy(maxs, world_maxs);
-    sv_numareanodes = 0;
-    SV_CreateAreaNode(0, world_mins, world_maxs);
+    SV_SetAreaRoot();
+    SV_ResetAreaNodes();
 }
 
 /* ==========================================================================
    Entity Linking
    ========================================================================== */
 
-static void SV_LinkToAreaNode(edict_t *ent, int node_idx)
+/* Choose the node for a box: deepest level that holds it, cell by its centre */
+static int SV_AreaNodeForBox(vec3_t absmin, vec3_t absmax)
 {
-    areanode_t *anode;
+    float   size = 0, cell = area_size;
+    int     level = 0, i, n, c[3];
+    vec3_t  center;
+
+    for (i = 0; i < 3; i++) {
+        if (absmax[i] - absmin[i] > size)
+            size = absmax[i] - absmin[i];
+        center[i] = 0.5f * (absmin[i] + absmax[i]) - area_origin[i];
+        if (center[i] < 0 || center[i] >= area_size)
+            return 0;   /* outside the world: root */
+    }
 
-    if (node_idx < 0 || node_idx >= sv_numareanodes)
+    while (level < AREA_DEPTH && cell * 0.5f >= size) {
+        cell *= 0.5f;
+        level++;
+    }
+
+    n = 1 << level;
+    for (i = 0; i < 3; i++) {
+        c[i] = (int)(center[i] / cell);
+        if (c[i] >= n)
+            c[i] = n - 1;
+    }
+    return sv_levelfirst[level] + (c[2] * n + c[1]) * n + c[0];
+}
+
+/* Add delta to a node's count and every ancestor's */
+static void SV_AreaCount(int node, int delta)
+{
+    int level, n, c[3], idx;
+
+    for (level = AREA_DEPTH; level > 0 && node < sv_levelfirst[level]; level--)
+        ;
+
+    n = 1 << level;
+    idx = node - sv_levelfirst[level];
+    c[0] = idx % n;
+    c[1] = (idx / n) % n;
+    c[2] = idx / (n * n);
+
+    for (;;) {
+        sv_areanodes[sv_levelfirst[level] + (c[2] * n + c[1]) * n + c[0]].count += delta;
+        if (!level)
+            break;
+        level--;
+        n >>= 1;
+        c[0] >>= 1;
+        c[1] >>= 1;
+        c[2] >>= 1;
+    }
+}
+
+static void SV_RemoveAreaLink(int num)
+{
+    arealink_t *link = &sv_arealinks[num];
+
+    if (link->node < 0)
         return;
 
-    anode = &sv_areanodes[node_idx];
+    if (link->prev >= 0)
+        sv_arealinks[link->prev].next = link->next;
+    else
+        sv_areanodes[link->node].head[link->list] = link->next;
+    if (link->next >= 0)
+        sv_arealinks[link->next].prev = link->prev;
+
+    SV_AreaCount(link->node, -1);
+    link->node = -1;
+    link->prev = link->next = -1;
+}
 
-    /* If leaf node, add entity here */
-    if (anode->axis == -1) {
-        if (anode->num_entities < 256) {
-            anode->entities[anode->num_entities++] = ent;
-        }
+static void SV_InsertAreaLink(int num, int node, int list)
+{
+    arealink_t *link = &sv_arealinks[num];
+    areanode_t *anode = &sv_areanodes[node];
+
+    link->node = node;
+    link->list = list;
+    link->prev = -1;
+    link->next = anode->head[list];
+    if (link->next >= 0)
+        sv_arealinks[link->next].prev = num;
+    anode->head[list] = num;
+
+    SV_AreaCount(node, 1);
+}
+
+/* Put an entity in the right node and list for its current bounds */
+static void SV_RelinkArea(edict_t *ent, int num)
+{
+    arealink_t  *link = &sv_arealinks[num];
+    int         node, list;
+
+    /* Non-solid entities are linked, but no query returns them */
+    if (ent->solid == SOLID_NOT) {
+        SV_RemoveAreaLink(num);
         return;
     }
 
-    /* Check which child(ren) the entity overlaps */
-    if (ent->absmax[anode->axis] > anode->dist)
-        SV_LinkToAreaNode(ent, anode->children[0]);
-    if (ent->absmin[anode->axis] < anode->dist)
-        SV_LinkToAreaNode(ent, anode->children[1]);
+    list = ent->solid == SOLID_TRIGGER ? 1 : 0;
+    node = SV_AreaNodeForBox(ent->absmin, ent->absmax);
+    if (link->node == node && link->list == list)
+        return;     /* moved within its cell */
+
+    SV_RemoveAreaLink(num);
+    SV_InsertAreaLink(num, node, list);
+}
+
+static void SV_LinkClusters(edict_t *ent, int num)
+{
+    entclusters_t   *ec = &sv_entclusters[num];
+    bsp_world_t     *world = R_GetWorldModel();
+    int             leafs[MAX_ENT_LEAFS];
+    int             count, i, j;
+
+    ec->num_clusters = -1;
+    if (!world || !world->loaded || !world->vis)
+        return;
+
+    count = BSP_BoxLeafs(world, ent->absmin, ent->absmax, leafs, MAX_ENT_LEAFS);
+    if (count > MAX_ENT_LEAFS)
+        return;
+
+    ec->num_clusters = 0;
+    for (i = 0; i < count; i++) {
+        int cluster;
+
+        if (leafs[i] < 0 || leafs[i] >= world->num_leafs)
+            continue;
+        cluster = world->leafs[leafs[i]].cluster;
+        if (cluster < 0)
+            continue;
+        for (j = 0; j < ec->num_clusters; j++)
+            if (ec->clusternums[j] == cluster)
+                break;
+        if (j < ec->num_clusters)
+            continue;
+        if (ec->num_clusters == MAX_ENT_CLUSTERS) {
+            ec->num_clusters = -1;
+            return;
+        }
+        ec->clusternums[ec->num_clusters++] = cluster;
+    }
+
+    /* Only in solid: nothing to cull against */
+    if (!ec->num_clusters)
+        ec->num_clusters = -1;
+}
+
+/* The clusters entity num was last linked in, or -1 to send it to everyone */
+int SV_EntityClusters(int num, const int **clusters)
+{
+    if (num < 0 || num >= MAX_EDICTS || !SV_EdictNum(num)->linked)
+        return -1;
+    *clusters = sv_entclusters[num].clusternums;
+    return sv_entclusters[num].num_clusters;
+}
+
+void SV_SetWorldBounds(vec3_t mins, vec3_t maxs)
+{
+    game_export_t *ge = SV_GetGameExport();
+    int i;
+
+    VectorCopy(mins, world_mins);
+    VectorCopy(maxs, world_maxs);
+    SV_SetAreaRoot();
+
+    /* Cells moved: put everything linked back in by its new node, and
+       look up its clusters in what may be a new world */
+    for (i = 0; i < MAX_EDICTS; i++) {
+        edict_t *ent;
+
+        if (!ge || !ge->edicts || i >= ge->max_edicts)
+            break;
+        ent = SV_EdictNum(i);
+        if (ent->linked)
+            SV_LinkClusters(ent, i);
+        if (sv_arealinks[i].node < 0)
+            continue;
+        SV_RemoveAreaLink(i);
+        SV_RelinkArea(ent, i);
+    }
 }
 
 void SV_LinkEdict(edict_t *ent)
 {
+    int num;
+
     if (!ent)
         return;
 
@@ -150,32 +349,30 @@ void SV_LinkEdict(edict_t *ent)
     ent->absmax[1] += 1;
     ent->absmax[2] += 1;
 
-    /* Link into area nodes */
+    /* Link into the partition */
     ent->linked = qtrue;
-    if (sv_numareanodes > 0)
-        SV_LinkToAreaNode(ent, 0);
+
+    num = SV_NumForEdict(ent);
+    if (num < 0 || num >= MAX_EDICTS) {
+        Com_DPrintf("SV_LinkEdict: entity %d out of range\n", num);
+        return;
+    }
+    SV_RelinkArea(ent, num);
+    SV_LinkClusters(ent, num);
 }
 
 void SV_UnlinkEdict(edict_t *ent)
 {
-    int i, j;
+    int num;
 
     if (!ent)
         return;
 
     ent->linked = qfalse;
 
-    /* Remove from all area nodes */
-    for (i = 0; i < sv_numareanodes; i++) {
-        areanode_t *anode = &sv_areanodes[i];
-        for (j = 0; j < anode->num_entities; j++) {
-            if (anode->entities[j] == ent) {
-                anode->entities[j] = anode->entities[anode->num_entities - 1];
-                anode->num_entities--;
-                break;
-            }
-        }
-    }
+    num = SV_NumForEdict(ent);
+    if (num >= 0 && num < MAX_EDICTS)
+        SV_RemoveAreaLink(num);
 }
 
 /* ==========================================================================
@@ -188,24 +385,42 @@ typedef struct {
     int     maxcount;
     vec3_t  mins;
     vec3_t  maxs;
-    int     areatype;
+    int     arealist;
 } areaparms_t;
 
-static void SV_AreaEdicts_r(int node_idx, areaparms_t *ap)
+static void SV_AreaEdicts_r(int level, int x, int y, int z, areaparms_t *ap)
 {
-    areanode_t *anode;
-    int i;
+    int         n = 1 << level;
+    areanode_t  *anode = &sv_areanodes[sv_levelfirst[level] + (z * n + y) * n + x];
+    int         num, i;
 
-    if (node_idx < 0 || node_idx >= sv_numareanodes)
+    if (!anode->count)
         return;
 
-    anode = &sv_areanodes[node_idx];
+    /* The root holds whatever is outside the world, so always search it */
+    if (level) {
+        float cell = area_size / n;
+        vec3_t lmins, lmaxs;
+
+        lmins[0] = area_origin[0] + (x - 0.5f) * cell;
+        lmins[1] = area_origin[1] + (y - 0.5f) * cell;
+        lmins[2] = area_origin[2] + (z - 0.5f) * cell;
+        lmaxs[0] = lmins[0] + 2 * cell;
+        lmaxs[1] = lmins[1] + 2 * cell;
+        lmaxs[2] = lmins[2] + 2 * cell;
+
+        if (lmins[0] > ap->maxs[0] || lmins[1] > ap->maxs[1] || lmins[2] > ap->maxs[2] ||
+            lmaxs[0] < ap->mins[0] || lmaxs[1] < ap->mins[1] || lmaxs[2] < ap->mins[2])
+            return;
+    }
 
-    /* Check entities in this node */
-    for (i = 0; i < anode->num_entities; i++) {
-        edict_t *ent = anode->entities[i];
+    for (num = anode->head[ap->arealist]; num >= 0; num = sv_arealinks[num].next) {
+        edict_t *ent = SV_EdictNum(num);
 
-        if (!ent || !ent->inuse || !ent->linked)
+        /* Much of the game frees edicts by clearing inuse without an
+         * unlink; they stay listed until the slot is linked again.
+         * Queries may run on job threads, so they only skip them. */
+        if (!ent->inuse)
             continue;
 
         /* AABB overlap test */
@@ -225,29 +440,30 @@ static void SV_AreaEdicts_r(int node_idx, areaparms_t *ap)
         ap->list[ap->count++] = ent;
     }
 
-    /* Recurse into children if not a leaf */
-    if (anode->axis != -1) {
-        if (ap->maxs[anode->axis] > anode->dist)
-            SV_AreaEdicts_r(anode->children[0], ap);
-        if (ap->mins[anode->axis] < anode->dist)
-            SV_AreaEdicts_r(anode->children[1], ap);
-    }
+    if (level == AREA_DEPTH)
+        return;
+    for (i = 0; i < 8 && ap->count < ap->maxcount; i++)
+        SV_AreaEdicts_r(level + 1, x * 2 + (i & 1), y * 2 + ((i >> 1) & 1),
+                        z * 2 + (i >> 2), ap);
 }
 
 int SV_AreaEdicts(vec3_t mins, vec3_t maxs, edict_t **list,
                   int maxcount, int areatype)
 {
     areaparms_t ap;
+    game_export_t *ge = SV_GetGameExport();
+
+    if (!ge || !ge->edicts)
+        return 0;
 
     ap.list = list;
     ap.count = 0;
     ap.maxcount = maxcount;
     VectorCopy(mins, ap.mins);
     VectorCopy(maxs, ap.maxs);
-    ap.areatype = areatype;
+    ap.arealist = areatype == AREA_TRIGGERS ? 1 : 0;
 
-    if (sv_numareanodes > 0)
-        SV_AreaEdicts_r(0, &ap);
+    SV_AreaEdicts_r(0, 0, 0, 0, &ap);
 
     return ap.count;
 }
@@ -72,12 +72,15 @@ typedef struct {
 typedef struct sfx_s {
     char        name[MAX_QPATH];
     qboolean    loaded;
+    qboolean    pending;        /* queued on the background loader */
     int         registration_sequence;
+    int         last_used;      /* Sys_Milliseconds, for the cache's LRU */
 
     /* PCM data (converted to output format) */
     int         length;         /* in samples */
     int         loopstart;      /* -1 = no loop */
     byte        *data;          /* 16-bit signed PCM */
+    int         bytes;          /* of data, counted in snd.cache_bytes */
 
     /* Original format info */
     wavinfo_t   info;
@@ -95,12 +98,18 @@ typedef struct {
     float       master_vol;     /* 0.0-1.0 */
     float       dist_mult;      /* attenuation multiplier */
     int         pos;            /* current sample position */
+    int         frac;           /* and the fraction past it, 16.16 */
+    int         step;           /* source samples per output sample, 16.16 */
     int         end;            /* end sample position */
+    volatile int gains;         /* left << 16 | right, GAIN_ONE = 1.0; from S_Update */
     qboolean    autosound;      /* ambient looping */
     qboolean    looping;        /* force loop from start (ambient/music) */
     qboolean    fixed_origin;   /* use origin instead of entity origin */
 } channel_t;
 
+#define GAIN_SHIFT          14
+#define GAIN_ONE            (1 << GAIN_SHIFT)
+
 /* ==========================================================================
    Sound System State
    ========================================================================== */
@@ -113,14 +122,24 @@ typedef struct {
     SDL_AudioDeviceID   device;
     SDL_AudioSpec       spec;
 
-    /* Mixing buffer */
-    int16_t     *mixbuffer;     /* mixed output buffer */
-    int         mixsamples;     /* size of mix buffer in samples */
+    /* Mixer stats, written by the audio thread, for s_stats */
+    int         mix_callbacks;
+    int         mix_usec;       /* last callback */
+    int         mix_peak_usec;  /* since the last s_stats */
+    int         mix_total_usec;
+    int         mix_channels;   /* mixed in the last callback */
+    int         mix_underruns;  /* callbacks late enough that the device ran dry */
+    uint64_t    mix_last;       /* Sys_PerfCounter of the last callback */
 
     /* Loaded sounds */
     sfx_t       known_sfx[MAX_SFX];
     int         num_sfx;
     int         registration_sequence;
+    qboolean    registering;    /* between Begin and EndRegistration */
+
+    /* Decoded effects, against s_cache_mb */
+    int         cache_bytes;
+    int         cache_evictions;
 
     /* Playback channels */
     channel_t   channels[MAX_CHANNELS];
@@ -180,7 +199,20 @@ void        S_SetMusicIntensity(float intensity);
 void        S_SetMusicDesignerInfo(void *info);
 
 /* Internal helpers */
-wavinfo_t   S_GetWavInfo(const char *name, byte *wav, int wavlength);
+wavinfo_t   S_GetWavInfo(const char *name, const byte *wav, int wavlength);
 void        S_LoadSound(sfx_t *sfx);
 
+/* Streams (snd_stream.c) */
+#define STREAM_MUSIC        0
+#define STREAM_AMBIENT      1
+#define NUM_STREAMS         2
+
+void        S_InitStreams(void);
+void        S_ShutdownStreams(void);
+void        S_PlayStream(int stream, const char *name, qboolean loop);
+void        S_UpdateStreams(void);
+void        S_EndAmbientRegistration(void);
+int         S_ReadStream(int stream, float *out, int frames, float *gl, float *gr);
+void        S_PrintStreams(void);
+
 #endif /* SND_LOCAL_H */
@@ -5,10 +5,17 @@
  * Implements the 20-function sound_export_t interface.
  *
  * Sound pipeline:
- *   1. S_RegisterSound: loads .wav/.adp from PAK, decodes to 16-bit PCM
+ *   1. S_RegisterSound: queues .wav/.adp decode to 16-bit PCM on the
+ *      background loader (S_LoadSound does it inline if still needed)
  *   2. S_StartSound: assigns a playback channel with 3D position
- *   3. SDL audio callback: mixes active channels with spatial attenuation
- *   4. S_Update: updates listener position each frame
+ *   3. S_Update: updates the listener and each channel's left/right gains
+ *      each frame
+ *   4. SDL audio callback: resamples the active channels to the device
+ *      rate and mixes them with those gains (SSE2/NEON, see Mix Kernels)
+ *
+ * Effects are decoded whole and kept in a cache with an LRU byte budget
+ * (s_cache_mb, see Sound Cache). Music and ambience are streamed instead
+ * (snd_stream.c) and mixed in after the channels.
  *
  * Original SoF sound stats:
  *   - ~1,500 .wav files in pak0.pak
@@ -32,23 +39,24 @@ static cvar_t   *s_nosound;
 static cvar_t   *s_mixahead;
 static cvar_t   *s_show;
 static cvar_t   *s_khz;
+static cvar_t   *s_cache_mb;
 
 /* ==========================================================================
    WAV File Loader
    ========================================================================== */
 
 /* Read little-endian values from byte buffer */
-static short S_ReadShort(byte *p) { return (short)(p[0] | (p[1] << 8)); }
-static int S_ReadInt(byte *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24); }
+static short S_ReadShort(const byte *p) { return (short)(p[0] | (p[1] << 8)); }
+static int S_ReadInt(const byte *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24); }
 
 /*
  * Find a RIFF chunk in a WAV file
  * Returns pointer to chunk data and sets *len to data length
  */
-static byte *S_FindChunk(byte *data, int datalen, const char *name, int *len)
+static const byte *S_FindChunk(const byte *data, int datalen, const char *name, int *len)
 {
-    byte    *p = data + 12;     /* skip RIFF header */
-    byte    *end = data + datalen;
+    const byte  *p = data + 12;     /* skip RIFF header */
+    const byte  *end = data + datalen;
 
     while (p + 8 <= end) {
         int chunk_len = S_ReadInt(p + 4);
@@ -69,11 +77,11 @@ static byte *S_FindChunk(byte *data, int datalen, const char *name, int *len)
 /*
  * Parse WAV file header and return format info
  */
-wavinfo_t S_GetWavInfo(const char *name, byte *wav, int wavlength)
+wavinfo_t S_GetWavInfo(const char *name, const byte *wav, int wavlength)
 {
     wavinfo_t   info;
-    byte        *fmt_data;
-    byte        *data_chunk;
+    const byte  *fmt_data;
+    const byte  *data_chunk;
     int         fmt_len, data_len;
 
     memset(&info, 0, sizeof(info));
@@ -116,7 +124,7 @@ wavinfo_t S_GetWavInfo(const char *name, byte *wav, int wavlength)
 
     /* Check for "cue " chunk (loop point) */
     {
-        byte *cue;
+        const byte *cue;
         int cue_len;
         cue = S_FindChunk(wav, wavlength, "cue ", &cue_len);
         if (cue && cue_len >= 24) {
@@ -128,68 +136,219 @@ wavinfo_t S_GetWavInfo(const char *name, byte *wav, int wavlength)
 }
 
 /*
- * Load a sound effect from PAK filesystem
+ * S_DecodeSound - Read a sound from the PAK filesystem and convert it to
+ * 16-bit signed PCM in zone memory. Doesn't touch sfx_t or snd, so the
+ * background loader can run it on a worker thread.
  */
-void S_LoadSound(sfx_t *sfx)
+static byte *S_DecodeSound(const char *name, wavinfo_t *info)
 {
-    byte    *data;
-    int     len;
-    char    namebuf[MAX_QPATH];
-
-    if (sfx->loaded)
-        return;
+    const byte  *data;
+    byte        *pcm;
+    int         len;
+    char        namebuf[MAX_QPATH];
 
     /* Try with "sound/" prefix if not already present */
-    if (sfx->name[0] == '*') {
-        /* Player-specific sound — skip for now */
-        return;
-    }
-
-    if (strncmp(sfx->name, "sound/", 6) != 0) {
-        Com_sprintf(namebuf, sizeof(namebuf), "sound/%s", sfx->name);
+    if (strncmp(name, "sound/", 6) != 0) {
+        Com_sprintf(namebuf, sizeof(namebuf), "sound/%s", name);
     } else {
-        Q_strncpyz(namebuf, sfx->name, sizeof(namebuf));
+        Q_strncpyz(namebuf, name, sizeof(namebuf));
     }
 
-    len = FS_LoadFile(namebuf, (void **)&data);
+    /* Parse straight out of the pak mapping; only the PCM is copied */
+    len = FS_MapFile(namebuf, (const void **)&data);
     if (!data) {
         Com_DPrintf("S_LoadSound: couldn't load %s\n", namebuf);
-        return;
+        return NULL;
     }
 
-    sfx->info = S_GetWavInfo(namebuf, data, len);
-    if (sfx->info.rate == 0) {
+    *info = S_GetWavInfo(namebuf, data, len);
+    if (info->rate == 0) {
         Com_DPrintf("S_LoadSound: bad wav format %s\n", namebuf);
-        FS_FreeFile(data);
-        return;
+        FS_UnmapFile(data);
+        return NULL;
     }
 
     /* Convert to 16-bit signed PCM at native rate */
     {
-        int sample_count = sfx->info.samples * sfx->info.channels;
-        int src_bytes = sample_count * sfx->info.width;
-        byte *src = data + sfx->info.dataofs;
+        int sample_count = info->samples * info->channels;
+        int src_bytes = sample_count * info->width;
+        const byte *src = data + info->dataofs;
 
-        sfx->data = (byte *)Z_TagMalloc(sample_count * 2, Z_TAG_LEVEL);
-        sfx->length = sfx->info.samples;
-        sfx->loopstart = sfx->info.loopstart;
+        /* Registration owns the lifetime, so not Z_TAG_LEVEL: the BSP
+         * loader's Z_FreeTags would pull it out from under the mixer */
+        pcm = (byte *)Z_Malloc(sample_count * 2);
 
-        if (sfx->info.width == 2) {
+        if (info->width == 2) {
             /* Already 16-bit — copy directly */
             if (src + src_bytes <= data + len)
-                memcpy(sfx->data, src, sample_count * 2);
+                memcpy(pcm, src, sample_count * 2);
         } else {
             /* 8-bit unsigned → 16-bit signed */
             int i;
-            int16_t *out = (int16_t *)sfx->data;
+            int16_t *out = (int16_t *)pcm;
             for (i = 0; i < sample_count && (src + i) < (data + len); i++) {
                 out[i] = (int16_t)((src[i] - 128) << 8);
             }
         }
     }
 
+    FS_UnmapFile(data);
+    return pcm;
+}
+
+/* ==========================================================================
+   Sound Cache
+   Decoded effects stay loaded across levels while they fit in s_cache_mb.
+   Past that, the least recently used ones nothing refers to (not
+   registered this level, not playing) are freed; a later S_StartSound
+   decodes one again on demand. The current level's sounds are never
+   evicted, so the budget is a ceiling on everything else.
+   ========================================================================== */
+
+static qboolean S_SoundInUse(const sfx_t *sfx)
+{
+    int i;
+
+    if (sfx->pending || sfx->registration_sequence == snd.registration_sequence)
+        return qtrue;
+    for (i = 0; i < MAX_CHANNELS; i++) {
+        if (snd.channels[i].sfx == sfx)
+            return qtrue;
+    }
+    return qfalse;
+}
+
+static void S_UncacheSound(sfx_t *sfx)
+{
+    if (sfx->data) {
+        Z_Free(sfx->data);
+        snd.cache_bytes -= sfx->bytes;
+    }
+    sfx->data = NULL;
+    sfx->bytes = 0;
+    sfx->loaded = qfalse;
+}
+
+/* Evict until under budget. Not during registration: the old level's
+   sounds haven't all been claimed yet. */
+static void S_TrimCache(void)
+{
+    int budget = (int)(s_cache_mb->value * 1024 * 1024);
+
+    if (snd.registering || snd.cache_bytes <= budget)
+        return;
+
+    /* The device is locked so the mixer can't pick one up mid-free */
+    SDL_LockAudioDevice(snd.device);
+    while (snd.cache_bytes > budget) {
+        sfx_t   *oldest = NULL;
+        int     i;
+
+        for (i = 0; i < snd.num_sfx; i++) {
+            sfx_t *sfx = &snd.known_sfx[i];
+
+            if (!sfx->data || S_SoundInUse(sfx))
+                continue;
+            if (!oldest || sfx->last_used - oldest->last_used < 0)
+                oldest = sfx;
+        }
+        if (!oldest)
+            break;      /* all of it is in use */
+
+        S_UncacheSound(oldest);
+        snd.cache_evictions++;
+    }
+    SDL_UnlockAudioDevice(snd.device);
+}
+
+static void S_AttachSound(sfx_t *sfx, byte *pcm, const wavinfo_t *info)
+{
+    sfx->info = *info;
+    sfx->length = info->samples;
+    sfx->loopstart = info->loopstart;
+    sfx->data = pcm;
     sfx->loaded = qtrue;
-    FS_FreeFile(data);
+    sfx->bytes = info->samples * info->channels * 2;
+    sfx->last_used = Sys_Milliseconds();
+
+    snd.cache_bytes += sfx->bytes;
+    S_TrimCache();
+}
+
+/*
+ * Load a sound effect from PAK filesystem
+ */
+void S_LoadSound(sfx_t *sfx)
+{
+    wavinfo_t   info;
+    byte        *pcm;
+
+    /* Precached by S_RegisterSound — just wait for that load. The sim
+       thread can't pump, so it skips the sound until the main thread
+       hooks it up; one missed play beats running completions off it. */
+    if (sfx->pending && !FS_AsyncMainThread())
+        return;
+    while (sfx->pending && FS_AsyncPump(qtrue))
+        ;
+
+    if (sfx->loaded)
+        return;
+
+    if (sfx->name[0] == '*') {
+        /* Player-specific sound — skip for now */
+        return;
+    }
+
+    pcm = S_DecodeSound(sfx->name, &info);
+    if (pcm)
+        S_AttachSound(sfx, pcm, &info);
+}
+
+/* ==========================================================================
+   Background Loading
+   S_RegisterSound queues the read and PCM conversion on the FS_AsyncQueue
+   workers, so a level's precache list loads while the rest of the map
+   spawns instead of hitching on first playback.
+   ========================================================================== */
+
+typedef struct {
+    sfx_t       *sfx;
+    char        name[MAX_QPATH];
+    wavinfo_t   info;
+    byte        *pcm;
+} sndload_t;
+
+static void S_SoundLoadWork(void *ctx)
+{
+    sndload_t *ld = (sndload_t *)ctx;
+
+    ld->pcm = S_DecodeSound(ld->name, &ld->info);
+}
+
+static void S_SoundLoadDone(void *ctx)
+{
+    sndload_t *ld = (sndload_t *)ctx;
+
+    ld->sfx->pending = qfalse;
+    if (ld->pcm)
+        S_AttachSound(ld->sfx, ld->pcm, &ld->info);
+
+    Z_Free(ld);
+}
+
+static void S_PrecacheSound(sfx_t *sfx)
+{
+    sndload_t *ld;
+
+    if (sfx->loaded || sfx->pending || sfx->name[0] == '*')
+        return;
+
+    ld = (sndload_t *)Z_Malloc(sizeof(*ld));
+    ld->sfx = sfx;
+    Q_strncpyz(ld->name, sfx->name, sizeof(ld->name));
+
+    sfx->pending = qtrue;
+    FS_AsyncQueue(S_SoundLoadWork, S_SoundLoadDone, ld);
 }
 
 /* ==========================================================================
@@ -242,114 +401,401 @@ static channel_t *S_PickChannel(int entnum, int entchannel)
 }
 
 /* ==========================================================================
-   SDL Audio Callback
+   Spatialization
+   The game-rate half of mixing: S_Update works out each channel's left and
+   right gain from the listener and publishes them to the mixer in one int
+   store, so the audio thread reads a pair that belongs together without a
+   lock. S_StartSound does it for a new channel before it can be mixed.
    ========================================================================== */
 
-static void S_AudioCallback(void *userdata, Uint8 *stream, int len)
+static void S_Spatialize(channel_t *ch)
 {
-    int         samples_needed;
-    int         i, j;
-    int         *mixbuf;
-    int16_t     *out;
+    float   base_vol = ch->master_vol * snd.master_volume;
+    float   dist_atten = 1.0f;
+    float   pan = 0.0f;     /* -1 = full left, +1 = full right */
+    float   vol_l, vol_r;
+    int     l, r;
+
+    if (ch->dist_mult > 0) {
+        vec3_t  delta;
+        float   dist;
+
+        VectorSubtract(ch->origin, snd.listener_origin, delta);
+        dist = VectorLength(delta);
+
+        /* Distance attenuation */
+        dist_atten = 1.0f - dist * ch->dist_mult;
+        if (dist_atten < 0.0f) dist_atten = 0.0f;
+        if (dist_atten > 1.0f) dist_atten = 1.0f;
+
+        /* Stereo panning via dot product with listener right vector */
+        if (dist > 1.0f) {
+            pan = DotProduct(delta, snd.listener_right) / dist;
+            if (pan > 1.0f) pan = 1.0f;
+            if (pan < -1.0f) pan = -1.0f;
+        }
+    }
 
-    (void)userdata;
+    vol_l = base_vol * dist_atten * (1.0f - pan * 0.35f);
+    vol_r = base_vol * dist_atten * (1.0f + pan * 0.35f);
 
-    samples_needed = len / (2 * SND_CHANNELS);  /* 16-bit stereo */
+    /* Too quiet to hear reads as silent: the mixer only advances it */
+    l = vol_l < 0.001f ? 0 : (int)(vol_l * GAIN_ONE);
+    r = vol_r < 0.001f ? 0 : (int)(vol_r * GAIN_ONE);
+    if (l > 0xffff) l = 0xffff;
+    if (r > 0xffff) r = 0xffff;
 
-    /* Temporary 32-bit mix buffer on stack */
-    mixbuf = (int *)alloca(samples_needed * SND_CHANNELS * sizeof(int));
-    memset(mixbuf, 0, samples_needed * SND_CHANNELS * sizeof(int));
+    ch->gains = (l << 16) | r;
+}
 
-    /* Mix all active channels */
-    for (i = 0; i < MAX_CHANNELS; i++) {
-        channel_t   *ch = &snd.channels[i];
-        int16_t     *src;
-        float       vol_l, vol_r;
+/* Source samples per output sample, for a channel starting sfx */
+static int S_ChannelStep(const sfx_t *sfx)
+{
+    if (!sfx->info.rate || !snd.spec.freq)
+        return 1 << 16;
+    return (int)(((int64_t)sfx->info.rate << 16) / snd.spec.freq);
+}
 
-        if (!ch->sfx || !ch->sfx->loaded || !ch->sfx->data)
-            continue;
+/* ==========================================================================
+   Mix Kernels
+   The mixer works in float, MIX_CHUNK frames at a time, in static buffers:
+   only the audio thread mixes. Each channel is resampled to the device
+   rate into mix_src, then scaled by its gains and added into mix_buf four
+   floats at a time. The output pass converts with saturation, which is
+   the clipping.
+   ========================================================================== */
 
-        src = (int16_t *)ch->sfx->data;
-
-        /* Spatial attenuation and stereo panning */
-        {
-            float base_vol = ch->master_vol * snd.master_volume;
-            float dist_atten = 1.0f;
-            float pan = 0.0f;  /* -1 = full left, +1 = full right */
-
-            if (ch->dist_mult > 0) {
-                vec3_t delta;
-                float dist;
-
-                delta[0] = ch->origin[0] - snd.listener_origin[0];
-                delta[1] = ch->origin[1] - snd.listener_origin[1];
-                delta[2] = ch->origin[2] - snd.listener_origin[2];
-                dist = (float)sqrt(delta[0]*delta[0] + delta[1]*delta[1] + delta[2]*delta[2]);
-
-                /* Distance attenuation */
-                dist_atten = 1.0f - dist * ch->dist_mult;
-                if (dist_atten < 0.0f) dist_atten = 0.0f;
-                if (dist_atten > 1.0f) dist_atten = 1.0f;
-
-                /* Stereo panning via dot product with listener right vector */
-                if (dist > 1.0f) {
-                    float inv_dist = 1.0f / dist;
-                    pan = (delta[0] * snd.listener_right[0] +
-                           delta[1] * snd.listener_right[1] +
-                           delta[2] * snd.listener_right[2]) * inv_dist;
-                    if (pan > 1.0f) pan = 1.0f;
-                    if (pan < -1.0f) pan = -1.0f;
-                }
-            }
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S_MIX_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define S_MIX_NEON
+#endif
+
+#define MIX_CHUNK   512     /* frames */
+
+static float    mix_buf[MIX_CHUNK * SND_CHANNELS];
+static float    mix_src[MIX_CHUNK * SND_CHANNELS + 4];
+
+/* mix += src * gains, src mono: each sample feeds both sides */
+static void S_MixMono(float *mix, const float *src, int frames, float gl, float gr)
+{
+    int j = 0;
+
+#if defined(S_MIX_SSE)
+    __m128 g = _mm_setr_ps(gl, gr, gl, gr);
+
+    for (; j + 4 <= frames; j += 4) {
+        __m128 s = _mm_loadu_ps(src + j);
+        __m128 lo = _mm_unpacklo_ps(s, s);
+        __m128 hi = _mm_unpackhi_ps(s, s);
 
-            vol_l = base_vol * dist_atten * (1.0f - pan * 0.35f);
-            vol_r = base_vol * dist_atten * (1.0f + pan * 0.35f);
-            if (vol_l < 0.001f && vol_r < 0.001f)
-                continue;   /* too quiet to hear */
+        _mm_storeu_ps(mix + j * 2, _mm_add_ps(_mm_loadu_ps(mix + j * 2), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(mix + j * 2 + 4, _mm_add_ps(_mm_loadu_ps(mix + j * 2 + 4), _mm_mul_ps(hi, g)));
+    }
+#elif defined(S_MIX_NEON)
+    float32x4_t gl4 = vdupq_n_f32(gl), gr4 = vdupq_n_f32(gr);
+
+    for (; j + 4 <= frames; j += 4) {
+        float32x4_t     s = vld1q_f32(src + j);
+        float32x4x2_t   m = vld2q_f32(mix + j * 2);
+
+        m.val[0] = vmlaq_f32(m.val[0], s, gl4);
+        m.val[1] = vmlaq_f32(m.val[1], s, gr4);
+        vst2q_f32(mix + j * 2, m);
+    }
+#endif
+
+    for (; j < frames; j++) {
+        mix[j * 2 + 0] += src[j] * gl;
+        mix[j * 2 + 1] += src[j] * gr;
+    }
+}
+
+/* The same for interleaved stereo */
+static void S_MixStereo(float *mix, const float *src, int frames, float gl, float gr)
+{
+    int i = 0, count = frames * 2;
+
+#if defined(S_MIX_SSE)
+    __m128 g = _mm_setr_ps(gl, gr, gl, gr);
+
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(mix + i, _mm_add_ps(_mm_loadu_ps(mix + i),
+                                          _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#elif defined(S_MIX_NEON)
+    const float     gv[4] = { gl, gr, gl, gr };
+    float32x4_t     g = vld1q_f32(gv);
+
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(mix + i, vmlaq_f32(vld1q_f32(mix + i), vld1q_f32(src + i), g));
+#endif
+
+    for (; i < count; i += 2) {
+        mix[i + 0] += src[i + 0] * gl;
+        mix[i + 1] += src[i + 1] * gr;
+    }
+}
+
+/* Float to 16-bit, clipped */
+static void S_WriteOutput(int16_t *out, const float *mix, int count)
+{
+    int i = 0;
+
+#if defined(S_MIX_SSE)
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_cvtps_epi32(_mm_loadu_ps(mix + i));
+        __m128i b = _mm_cvtps_epi32(_mm_loadu_ps(mix + i + 4));
+
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(S_MIX_NEON)
+    for (; i + 8 <= count; i += 8) {
+        int16x4_t a = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(mix + i)));
+        int16x4_t b = vqmovn_s32(vcvtq_s32_f32(vld1q_f32(mix + i + 4)));
+
+        vst1q_s16(out + i, vcombine_s16(a, b));
+    }
+#endif
+
+    for (; i < count; i++) {
+        float val = mix[i];
+
+        if (val > 32767.0f) val = 32767.0f;
+        if (val < -32768.0f) val = -32768.0f;
+        out[i] = (int16_t)lrintf(val);   /* rounded, as the SSE2 convert */
+    }
+}
+
+/* ==========================================================================
+   Channel Playback
+   ========================================================================== */
+
+/*
+ * S_WrapChannel — The channel has run off the end of its sound: loop it,
+ * or stop it. qfalse when it has stopped.
+ */
+static qboolean S_WrapChannel(channel_t *ch)
+{
+    const sfx_t *sfx = ch->sfx;
+    int         restart;
+
+    if (ch->looping)
+        restart = 0;
+    else if (sfx->loopstart >= 0 && sfx->loopstart < sfx->length)
+        restart = sfx->loopstart;
+    else {
+        ch->sfx = NULL;     /* sound finished */
+        return qfalse;
+    }
+
+    if (sfx->length - restart <= 0) {
+        ch->sfx = NULL;
+        return qfalse;
+    }
+    ch->pos = restart + (ch->pos - sfx->length) % (sfx->length - restart);
+    return qtrue;
+}
+
+/* The sample after pos, for interpolation, across the loop point */
+static int S_NextSample(const channel_t *ch, int pos)
+{
+    const sfx_t *sfx = ch->sfx;
+
+    if (pos + 1 < sfx->length)
+        return pos + 1;
+    if (ch->looping)
+        return 0;
+    if (sfx->loopstart >= 0 && sfx->loopstart < sfx->length)
+        return sfx->loopstart;
+    return pos;
+}
+
+/* A silent channel still plays on: move it along without reading it */
+static void S_AdvanceChannel(channel_t *ch, int frames)
+{
+    int64_t total = (int64_t)ch->frac + (int64_t)ch->step * frames;
+
+    ch->pos += (int)(total >> 16);
+    ch->frac = (int)(total & 0xffff);
+    if (ch->pos >= ch->sfx->length)
+        S_WrapChannel(ch);
+}
+
+/*
+ * S_ResampleChannel — Up to frames of the channel at the device rate into
+ * out, by linear interpolation (a straight copy when the rates match).
+ * Returns the frames written, fewer when the sound ends.
+ */
+static int S_ResampleChannel(channel_t *ch, float *out, int frames)
+{
+    const int16_t   *src = (const int16_t *)ch->sfx->data;
+    int             stereo = ch->sfx->info.channels == 2;
+    int             j;
+
+    for (j = 0; j < frames; j++) {
+        int pos = ch->pos, next;
+
+        if (pos >= ch->sfx->length) {
+            if (!S_WrapChannel(ch))
+                break;
+            pos = ch->pos;
         }
 
-        /* Mix samples */
-        for (j = 0; j < samples_needed; j++) {
-            int sample_idx = ch->pos;
-
-            if (sample_idx >= ch->sfx->length) {
-                /* Check for loop */
-                if (ch->looping) {
-                    ch->pos = 0;
-                    sample_idx = 0;
-                } else if (ch->sfx->loopstart >= 0) {
-                    ch->pos = ch->sfx->loopstart;
-                    sample_idx = ch->pos;
-                } else {
-                    /* Sound finished */
-                    ch->sfx = NULL;
-                    break;
-                }
+        if (!ch->frac) {
+            if (stereo) {
+                out[j * 2 + 0] = src[pos * 2 + 0];
+                out[j * 2 + 1] = src[pos * 2 + 1];
+            } else {
+                out[j] = src[pos];
             }
+        } else {
+            float t = ch->frac * (1.0f / 65536.0f);
 
-            if (ch->sfx->info.channels == 1) {
-                /* Mono → stereo */
-                int s = src[sample_idx];
-                mixbuf[j * 2 + 0] += (int)(s * vol_l);
-                mixbuf[j * 2 + 1] += (int)(s * vol_r);
+            next = S_NextSample(ch, pos);
+            if (stereo) {
+                out[j * 2 + 0] = src[pos * 2 + 0] + (src[next * 2 + 0] - src[pos * 2 + 0]) * t;
+                out[j * 2 + 1] = src[pos * 2 + 1] + (src[next * 2 + 1] - src[pos * 2 + 1]) * t;
             } else {
-                /* Stereo */
-                mixbuf[j * 2 + 0] += (int)(src[sample_idx * 2 + 0] * vol_l);
-                mixbuf[j * 2 + 1] += (int)(src[sample_idx * 2 + 1] * vol_r);
+                out[j] = src[pos] + (src[next] - src[pos]) * t;
             }
+        }
+
+        ch->frac += ch->step;
+        ch->pos += ch->frac >> 16;
+        ch->frac &= 0xffff;
+    }
+
+    return j;
+}
+
+/* ==========================================================================
+   SDL Audio Callback
+   ========================================================================== */
 
-            ch->pos++;
+/* Returns the channels mixed */
+static int S_MixChunk(int16_t *out, int frames)
+{
+    int i, mixed = 0;
+
+    memset(mix_buf, 0, frames * SND_CHANNELS * sizeof(float));
+
+    for (i = 0; i < MAX_CHANNELS; i++) {
+        channel_t   *ch = &snd.channels[i];
+        int         gains, produced;
+        float       gl, gr;
+
+        if (!ch->sfx || !ch->sfx->loaded || !ch->sfx->data)
+            continue;
+
+        gains = ch->gains;
+        if (!gains) {
+            S_AdvanceChannel(ch, frames);
+            continue;
         }
+        gl = (float)((unsigned)gains >> 16) * (1.0f / GAIN_ONE);
+        gr = (float)(gains & 0xffff) * (1.0f / GAIN_ONE);
+
+        produced = S_ResampleChannel(ch, mix_src, frames);
+        if (ch->sfx && ch->sfx->info.channels == 2)
+            S_MixStereo(mix_buf, mix_src, produced, gl, gr);
+        else
+            S_MixMono(mix_buf, mix_src, produced, gl, gr);
+        mixed++;
     }
 
-    /* Clamp and write to output */
-    out = (int16_t *)stream;
-    for (i = 0; i < samples_needed * SND_CHANNELS; i++) {
-        int val = mixbuf[i];
-        if (val > 32767) val = 32767;
-        if (val < -32768) val = -32768;
-        out[i] = (int16_t)val;
+    for (i = 0; i < NUM_STREAMS; i++) {
+        float   gl, gr;
+        int     produced = S_ReadStream(i, mix_src, frames, &gl, &gr);
+
+        if (produced)
+            S_MixStereo(mix_buf, mix_src, produced, gl, gr);
     }
+
+    S_WriteOutput(out, mix_buf, frames * SND_CHANNELS);
+    return mixed;
+}
+
+static void S_AudioCallback(void *userdata, Uint8 *stream, int len)
+{
+    int16_t     *out = (int16_t *)stream;
+    int         frames;
+    uint64_t    start = Sys_PerfCounter();
+    uint64_t    freq = Sys_PerfFrequency();
+
+    (void)userdata;
+
+    Prof_Begin("S_AudioCallback");
+
+    frames = len / (2 * SND_CHANNELS);  /* 16-bit stereo */
+
+    /* A callback more than half a buffer late means the device played out
+       what it had and went silent */
+    if (snd.mix_last && snd.spec.freq &&
+        (start - snd.mix_last) * snd.spec.freq > freq * (uint64_t)frames * 3 / 2)
+        snd.mix_underruns++;
+    snd.mix_last = start;
+
+    snd.mix_channels = 0;
+    while (frames > 0) {
+        int n = frames < MIX_CHUNK ? frames : MIX_CHUNK;
+        int mixed = S_MixChunk(out, n);
+
+        if (mixed > snd.mix_channels)
+            snd.mix_channels = mixed;
+        out += n * SND_CHANNELS;
+        frames -= n;
+    }
+
+    snd.mix_usec = (int)((Sys_PerfCounter() - start) * 1000000 / freq);
+    snd.mix_total_usec += snd.mix_usec;
+    if (snd.mix_usec > snd.mix_peak_usec)
+        snd.mix_peak_usec = snd.mix_usec;
+    snd.mix_callbacks++;
+
+    Prof_End();
+}
+
+/*
+ * S_Stats_f — Mixer cost against the time it has (a buffer's worth of
+ * playback) and how often the device ran dry. Resets the peak.
+ */
+static void S_Stats_f(void)
+{
+    int     budget, avg, i, active = 0;
+
+    if (!snd.initialized) {
+        Com_Printf("Sound not started\n");
+        return;
+    }
+
+    for (i = 0; i < MAX_CHANNELS; i++)
+        if (snd.channels[i].sfx)
+            active++;
+
+    budget = snd.spec.freq ? (int)((int64_t)snd.spec.samples * 1000000 / snd.spec.freq) : 0;
+    avg = snd.mix_callbacks ? snd.mix_total_usec / snd.mix_callbacks : 0;
+
+    Com_Printf("%d Hz, %d frame buffer (%d us), %s mixer\n", snd.spec.freq,
+               snd.spec.samples, budget,
+#if defined(S_MIX_SSE)
+               "SSE2"
+#elif defined(S_MIX_NEON)
+               "NEON"
+#else
+               "scalar"
+#endif
+               );
+    Com_Printf("channels: %d playing, %d mixed last callback\n", active, snd.mix_channels);
+    Com_Printf("mix: %d us last, %d avg, %d peak (%.1f%% of the buffer)\n", snd.mix_usec,
+               avg, snd.mix_peak_usec, budget ? 100.0f * snd.mix_peak_usec / budget : 0.0f);
+    Com_Printf("%d callbacks, %d underruns\n", snd.mix_callbacks, snd.mix_underruns);
+    Com_Printf("cache: %d KB of %d MB, %d evictions\n", snd.cache_bytes / 1024,
+               (int)s_cache_mb->value, snd.cache_evictions);
+    S_PrintStreams();
+
+    snd.mix_peak_usec = 0;
 }
 
 /* ==========================================================================
@@ -370,6 +816,7 @@ qboolean S_Init(void)
     s_mixahead = Cvar_Get("s_mixahead", "0.2", CVAR_ARCHIVE);
     s_show = Cvar_Get("s_show", "0", 0);
     s_khz = Cvar_Get("s_khz", "22", CVAR_ARCHIVE);
+    s_cache_mb = Cvar_Get("s_cache_mb", "32", CVAR_ARCHIVE);
 
     if (s_nosound->value) {
         Com_Printf("Sound disabled\n");
@@ -413,6 +860,9 @@ qboolean S_Init(void)
     snd.initialized = qtrue;
     snd.active = qtrue;
 
+    Cmd_AddCommand("s_stats", S_Stats_f);
+    S_InitStreams();
+
     Com_Printf("SDL Audio: %d Hz, %d ch, %d sample buffer\n",
                snd.spec.freq, snd.spec.channels, snd.spec.samples);
     Com_Printf("Audio driver: %s\n", SDL_GetCurrentAudioDriver());
@@ -429,6 +879,11 @@ void S_Shutdown(void)
         return;
 
     Com_Printf("Sound shutdown\n");
+    Cmd_RemoveCommand("s_stats");
+
+    /* Queued loads point into snd.known_sfx and the streams */
+    FS_AsyncWait();
+    S_ShutdownStreams();
 
     /* Stop and close audio device */
     if (snd.device) {
@@ -461,6 +916,7 @@ void S_Activate(qboolean active)
 void S_BeginRegistration(void)
 {
     snd.registration_sequence++;
+    snd.registering = qtrue;
 }
 
 sfx_t *S_FindName(const char *name)
@@ -503,36 +959,37 @@ sfx_t *S_RegisterSound(const char *name)
 
     sfx->registration_sequence = snd.registration_sequence;
 
-    /* Load on demand — don't load during registration */
+    /* Start reading it in the background; S_StartSound waits if needed */
+    S_PrecacheSound(sfx);
     return sfx;
 }
 
 void S_EndRegistration(void)
 {
-    int i;
 
-    /* Free sounds that weren't re-registered this level */
-    for (i = 0; i < snd.num_sfx; i++) {
-        sfx_t *sfx = &snd.known_sfx[i];
-        if (sfx->registration_sequence != snd.registration_sequence) {
-            if (sfx->data) {
-                Z_Free(sfx->data);
-                sfx->data = NULL;
-            }
-            sfx->loaded = qfalse;
-        }
-    }
-}
+    if (!snd.initialized)
+        return;
 
-void S_RegisterAmbientSet(const char *name) { (void)name; }
-void S_RegisterMusicSet(const char *name) { (void)name; }
+    /* Sounds that weren't re-registered this level stay cached while
+     * they fit the budget */
+    snd.registering = qfalse;
+    S_TrimCache();
+    S_EndAmbientRegistration();
+}
 
 void S_FreeSound(sfx_t *sfx)
 {
+    /* Off the main thread a pending load can't be waited for; it stays
+       cached and S_TrimCache evicts it like any other */
+    if (sfx && sfx->pending && !FS_AsyncMainThread())
+        return;
+    while (sfx && sfx->pending && FS_AsyncPump(qtrue))
+        ;
+
     if (sfx && sfx->data) {
-        Z_Free(sfx->data);
-        sfx->data = NULL;
-        sfx->loaded = qfalse;
+        SDL_LockAudioDevice(snd.device);
+        S_UncacheSound(sfx);
+        SDL_UnlockAudioDevice(snd.device);
     }
 }
 
@@ -569,6 +1026,7 @@ void S_StartSound(vec3_t origin, int entnum, int entchannel,
         ch->master_vol = vol;
         ch->dist_mult = attenuation / 1000.0f;
         ch->pos = 0;
+        ch->step = S_ChannelStep(sfx);
 
         if (origin) {
             VectorCopy(origin, ch->origin);
@@ -576,7 +1034,9 @@ void S_StartSound(vec3_t origin, int entnum, int entchannel,
         } else {
             ch->fixed_origin = qfalse;
         }
+        S_Spatialize(ch);
     }
+    sfx->last_used = Sys_Milliseconds();
 
     SDL_UnlockAudioDevice(snd.device);
 }
@@ -604,6 +1064,7 @@ void S_StartLoopingSound(vec3_t origin, int entnum, int entchannel,
         ch->master_vol = vol;
         ch->dist_mult = attenuation / 1000.0f;
         ch->pos = 0;
+        ch->step = S_ChannelStep(sfx);
         ch->looping = qtrue;
         ch->autosound = qtrue;
 
@@ -613,7 +1074,9 @@ void S_StartLoopingSound(vec3_t origin, int entnum, int entchannel,
         } else {
             ch->fixed_origin = qfalse;
         }
+        S_Spatialize(ch);
     }
+    sfx->last_used = Sys_Milliseconds();
 
     SDL_UnlockAudioDevice(snd.device);
 }
@@ -657,6 +1120,21 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
     snd.master_volume = s_volume->value;
     snd.music_volume = s_musicvolume->value;
 
+    S_UpdateStreams();
+
+    /* New gains for the mixer's next callback. Locked like S_StartSound,
+       which may be filling a channel in on the sim thread. */
+    {
+        int i;
+
+        SDL_LockAudioDevice(snd.device);
+        for (i = 0; i < MAX_CHANNELS; i++) {
+            if (snd.channels[i].sfx)
+                S_Spatialize(&snd.channels[i]);
+        }
+        SDL_UnlockAudioDevice(snd.device);
+    }
+
     /* Debug: show active channels */
     if (s_show && s_show->value) {
         int i, active = 0;
@@ -675,7 +1153,6 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 
 void S_SetSoundStruct(void *sound_data) { (void)sound_data; }
 void S_SetSoundProcType(int type) { (void)type; }
-void S_SetGeneralAmbientSet(const char *name) { (void)name; }
 
 void S_SetMusicIntensity(float intensity)
 {
@@ -0,0 +1,506 @@
+/*
+ * snd_stream.c - Streamed music and ambience
+ *
+ * Music tracks and ambient beds run for minutes, so unlike effects they
+ * are never decoded whole. Each stream has a ring of 16-bit stereo frames
+ * at the track's own rate. The background loader fills it a chunk at a
+ * time, converting straight out of the track's FS_MapFile view. In a
+ * mapped pak that view is the pak mapping itself, so only the pages being
+ * decoded are ever read in. The mixer resamples from the ring to the
+ * device rate.
+ *
+ * The ring has one writer and one reader. The loader fills it from
+ * write, the audio thread drains it from read. Each side publishes its
+ * index with Sys_AtomicAdd once its frames are done, so neither needs a
+ * lock. The main thread owns everything else (opening, switching,
+ * stopping) under the game lock, and only touches a stream when no load
+ * is in flight. It shuts the mixer out with the device lock for the
+ * moment it resets the ring.
+ *
+ *   music <track>      plays music/<track>.wav, looped; no track stops it
+ *
+ * S_RegisterMusicSet plays music/<name>.wav and S_SetGeneralAmbientSet
+ * plays sound/ambient/<name>.wav. Both loop until replaced.
+ * S_RegisterAmbientSet opens an ambient set's track while the level
+ * loads, so switching to it later doesn't wait on the file.
+ */
+
+#include "snd_local.h"
+
+#define STREAM_FRAMES   65536       /* ring size, a power of two */
+#define STREAM_MASK     (STREAM_FRAMES - 1)
+#define STREAM_CHUNK    8192        /* frames per load */
+
+typedef struct {
+    /* Main thread; the loader's while pending */
+    char            name[MAX_QPATH];    /* playing or being opened */
+    char            want[MAX_QPATH];    /* asked for, "" = silence */
+    qboolean        loop;
+    qboolean        pending;            /* a load is in flight */
+    const byte      *file;              /* FS_MapFile view */
+    int             filelen;
+    wavinfo_t       info;
+    int             decode_pos;         /* next source frame to load */
+    qboolean        ended;              /* the loader reached the end, unlooped */
+
+    /* Shared with the mixer */
+    int16_t         ring[STREAM_FRAMES * 2];
+    volatile int    write;              /* frames loaded, ever */
+    volatile int    read;               /* frames mixed, ever */
+    int             frac;               /* past read, 16.16; mixer only */
+    int             step;
+    volatile int    gains;              /* left << 16 | right, as channel_t */
+    volatile int    active;
+    int             underruns;          /* mixer found the ring empty */
+} sndstream_t;
+
+static sndstream_t  snd_streams[NUM_STREAMS];
+
+#define MAX_AMBIENT_SETS    16
+
+typedef struct {
+    char            path[MAX_QPATH];    /* "" = free slot */
+    qboolean        pending;            /* being opened */
+    const byte      *file;              /* checked FS_MapFile view, or NULL */
+    int             filelen;
+    wavinfo_t       info;
+    int             registration_sequence;
+} ambientset_t;
+
+static ambientset_t ambient_sets[MAX_AMBIENT_SETS];
+
+static const char   *stream_names[NUM_STREAMS] = { "music", "ambient" };
+
+/* ==========================================================================
+   Loading
+   ========================================================================== */
+
+/* Frames the ring can take */
+static int S_StreamSpace(const sndstream_t *st)
+{
+    return STREAM_FRAMES - (int)((unsigned)st->write - (unsigned)st->read);
+}
+
+/* Loader thread: map a track and check it is a WAV the loader can read */
+static const byte *S_OpenStreamFile(const char *name, int *filelen, wavinfo_t *info)
+{
+    const byte *file;
+
+    *filelen = FS_MapFile(name, (const void **)&file);
+    if (!file)
+        return NULL;
+
+    *info = S_GetWavInfo(name, file, *filelen);
+    if (!info->rate || (info->width != 1 && info->width != 2) ||
+        (info->channels != 1 && info->channels != 2) ||
+        info->dataofs + info->samples * info->width * info->channels > *filelen) {
+        FS_UnmapFile(file);
+        return NULL;
+    }
+    return file;
+}
+
+/* Loader thread: open the track on the first call, then load a chunk */
+static void S_StreamWork(void *ctx)
+{
+    sndstream_t *st = (sndstream_t *)ctx;
+    int         frames, n = 0, w = st->write;
+
+    if (!st->file) {
+        st->file = S_OpenStreamFile(st->name, &st->filelen, &st->info);
+        if (!st->file)
+            return;
+        st->decode_pos = 0;
+    }
+
+    frames = S_StreamSpace(st);
+    if (frames > STREAM_CHUNK)
+        frames = STREAM_CHUNK;
+
+    while (n < frames) {
+        const byte  *src;
+        int         count, i, chans = st->info.channels;
+
+        if (st->decode_pos >= st->info.samples) {
+            if (!st->loop || !st->info.samples) {
+                st->ended = qtrue;
+                break;
+            }
+            st->decode_pos = st->info.loopstart >= 0 && st->info.loopstart < st->info.samples
+                             ? st->info.loopstart : 0;
+        }
+
+        count = st->info.samples - st->decode_pos;
+        if (count > frames - n)
+            count = frames - n;
+        src = st->file + st->info.dataofs + st->decode_pos * st->info.width * chans;
+
+        for (i = 0; i < count; i++) {
+            int16_t     *out = &st->ring[((w + n + i) & STREAM_MASK) * 2];
+            int         l, r;
+
+            if (st->info.width == 2) {
+                l = (int16_t)(src[0] | (src[1] << 8));
+                r = chans == 2 ? (int16_t)(src[2] | (src[3] << 8)) : l;
+            } else {
+                l = (src[0] - 128) << 8;     /* 8-bit unsigned */
+                r = chans == 2 ? (src[1] - 128) << 8 : l;
+            }
+            src += st->info.width * chans;
+
+            out[0] = (int16_t)l;
+            out[1] = (int16_t)r;
+        }
+
+        st->decode_pos += count;
+        n += count;
+    }
+
+    /* Frames first, then the index that lets the mixer see them */
+    Sys_AtomicAdd(&st->write, n);
+}
+
+static void S_StreamDone(void *ctx)
+{
+    sndstream_t *st = (sndstream_t *)ctx;
+
+    st->pending = qfalse;
+
+    if (!st->file) {
+        Com_Printf("Couldn't stream %s\n", st->name);
+        if (!Q_stricmp(st->want, st->name))
+            st->want[0] = 0;
+        st->name[0] = 0;
+        return;
+    }
+
+    if (!st->active) {
+        st->frac = 0;
+        st->step = snd.spec.freq
+                   ? (int)(((int64_t)st->info.rate << 16) / snd.spec.freq) : 1 << 16;
+        st->active = 1;
+        Com_DPrintf("Streaming %s: %d Hz, %d ch, %d KB\n", st->name, st->info.rate,
+                    st->info.channels, st->filelen / 1024);
+    }
+}
+
+/* Main thread, no load in flight: back to silence */
+static void S_CloseStream(sndstream_t *st)
+{
+    SDL_LockAudioDevice(snd.device);
+    st->active = 0;
+    SDL_UnlockAudioDevice(snd.device);
+
+    if (st->file)
+        FS_UnmapFile(st->file);
+    st->file = NULL;
+    st->filelen = 0;
+    st->name[0] = 0;
+    st->decode_pos = 0;
+    st->ended = qfalse;
+    st->write = st->read = 0;
+    st->frac = 0;
+}
+
+/* ==========================================================================
+   Ambient Sets
+   ========================================================================== */
+
+static void S_AmbientSetWork(void *ctx)
+{
+    ambientset_t *set = (ambientset_t *)ctx;
+
+    set->file = S_OpenStreamFile(set->path, &set->filelen, &set->info);
+}
+
+static void S_AmbientSetDone(void *ctx)
+{
+    ambientset_t *set = (ambientset_t *)ctx;
+
+    set->pending = qfalse;
+    if (!set->file) {
+        Com_DPrintf("Couldn't open ambient set %s\n", set->path);
+        set->path[0] = 0;
+    }
+}
+
+/* Main thread, opening st: take a registered set's view if it has one */
+static void S_TakeAmbientSet(sndstream_t *st)
+{
+    int i;
+
+    for (i = 0; i < MAX_AMBIENT_SETS; i++) {
+        ambientset_t *set = &ambient_sets[i];
+
+        if (set->pending || !set->file || Q_stricmp(set->path, st->name))
+            continue;
+
+        st->file = set->file;
+        st->filelen = set->filelen;
+        st->info = set->info;
+        st->decode_pos = 0;
+        set->file = NULL;       /* the stream unmaps it now */
+        return;
+    }
+}
+
+static void S_FreeAmbientSet(ambientset_t *set)
+{
+    if (set->file)
+        FS_UnmapFile(set->file);
+    memset(set, 0, sizeof(*set));
+}
+
+/* S_EndRegistration: drop sets this level didn't register */
+void S_EndAmbientRegistration(void)
+{
+    int i;
+
+    for (i = 0; i < MAX_AMBIENT_SETS; i++) {
+        ambientset_t *set = &ambient_sets[i];
+
+        if (set->path[0] && !set->pending &&
+            set->registration_sequence != snd.registration_sequence)
+            S_FreeAmbientSet(set);
+    }
+}
+
+/* ==========================================================================
+   Control
+   ========================================================================== */
+
+/* Play name (a full path) on a stream, "" or NULL to stop it. Takes
+   effect from S_UpdateStreams. */
+void S_PlayStream(int stream, const char *name, qboolean loop)
+{
+    sndstream_t *st = &snd_streams[stream];
+
+    Q_strncpyz(st->want, name ? name : "", sizeof(st->want));
+    st->loop = loop;
+}
+
+/* path/name.wav, unless name has an extension of its own */
+static void S_StreamPath(char *out, int size, const char *dir, const char *name)
+{
+    Com_sprintf(out, size, "%s/%s%s", dir, name, strchr(name, '.') ? "" : ".wav");
+}
+
+/* S_Update, every frame: open, switch and refill the streams.
+   S_Update runs outside the frame's game lock, but the sim thread queues
+   on fs_async and asks for tracks under it, so take it here. */
+void S_UpdateStreams(void)
+{
+    int i;
+
+    SV_LockGame();
+    for (i = 0; i < NUM_STREAMS; i++) {
+        sndstream_t *st = &snd_streams[i];
+        float       vol = i == STREAM_MUSIC ? snd.music_volume : snd.master_volume;
+        int         g = (int)(vol * GAIN_ONE);
+
+        if (g < 0) g = 0;
+        if (g > 0xffff) g = 0xffff;
+        st->gains = (g << 16) | g;
+
+        if (st->pending)
+            continue;
+
+        /* A new track, or silence, was asked for */
+        if (Q_stricmp(st->want, st->name)) {
+            S_CloseStream(st);
+            if (!st->want[0])
+                continue;
+            Q_strncpyz(st->name, st->want, sizeof(st->name));
+            if (i == STREAM_AMBIENT)
+                S_TakeAmbientSet(st);
+            st->pending = qtrue;
+            FS_AsyncQueue(S_StreamWork, S_StreamDone, st);
+            continue;
+        }
+
+        if (!st->active)
+            continue;
+
+        /* Played out */
+        if (st->ended) {
+            if (st->write == st->read) {
+                S_CloseStream(st);
+                st->want[0] = 0;
+            }
+            continue;
+        }
+
+        if (S_StreamSpace(st) >= STREAM_CHUNK) {
+            st->pending = qtrue;
+            FS_AsyncQueue(S_StreamWork, S_StreamDone, st);
+        }
+    }
+    SV_UnlockGame();
+}
+
+/* ==========================================================================
+   Mixing (audio thread)
+   ========================================================================== */
+
+/*
+ * S_ReadStream — Up to frames of the stream at the device rate into out,
+ * interleaved stereo, with the gains to mix it at. Returns the frames
+ * written: 0 when the stream is silent, short when the ring ran dry.
+ */
+int S_ReadStream(int stream, float *out, int frames, float *gl, float *gr)
+{
+    sndstream_t *st = &snd_streams[stream];
+    unsigned    r, w;
+    int         j, gains;
+
+    if (!st->active)
+        return 0;
+
+    gains = st->gains;
+    *gl = (float)((unsigned)gains >> 16) * (1.0f / GAIN_ONE);
+    *gr = (float)(gains & 0xffff) * (1.0f / GAIN_ONE);
+
+    r = (unsigned)st->read;
+    w = (unsigned)st->write;
+
+    for (j = 0; j < frames; j++) {
+        const int16_t   *a, *b;
+        float           t;
+
+        /* Interpolating needs the frame after this one too */
+        if (w - r < 2) {
+            if (!st->ended)
+                st->underruns++;
+            break;
+        }
+
+        a = &st->ring[(r & STREAM_MASK) * 2];
+        b = &st->ring[((r + 1) & STREAM_MASK) * 2];
+        t = st->frac * (1.0f / 65536.0f);
+        out[j * 2 + 0] = a[0] + (b[0] - a[0]) * t;
+        out[j * 2 + 1] = a[1] + (b[1] - a[1]) * t;
+
+        st->frac += st->step;
+        r += (unsigned)(st->frac >> 16);
+        st->frac &= 0xffff;
+    }
+
+    /* Done with those frames: the loader may have them */
+    Sys_AtomicAdd(&st->read, (int)(r - (unsigned)st->read));
+    return j;
+}
+
+/* ==========================================================================
+   Commands
+   ========================================================================== */
+
+static void S_Music_f(void)
+{
+    char path[MAX_QPATH];
+
+    if (Cmd_Argc() < 2) {
+        S_PlayStream(STREAM_MUSIC, NULL, qfalse);
+        return;
+    }
+
+    S_StreamPath(path, sizeof(path), "music", Cmd_Argv(1));
+    S_PlayStream(STREAM_MUSIC, path, qtrue);
+}
+
+void S_RegisterMusicSet(const char *name)
+{
+    char path[MAX_QPATH];
+
+    if (!name || !name[0]) {
+        S_PlayStream(STREAM_MUSIC, NULL, qfalse);
+        return;
+    }
+    S_StreamPath(path, sizeof(path), "music", name);
+    S_PlayStream(STREAM_MUSIC, path, qtrue);
+}
+
+/* Open the set's track in the background; S_SetGeneralAmbientSet plays it */
+void S_RegisterAmbientSet(const char *name)
+{
+    ambientset_t    *set = NULL;
+    char            path[MAX_QPATH];
+    int             i;
+
+    if (!snd.initialized || !name || !name[0])
+        return;
+    S_StreamPath(path, sizeof(path), "sound/ambient", name);
+
+    for (i = 0; i < MAX_AMBIENT_SETS; i++) {
+        if (!Q_stricmp(ambient_sets[i].path, path)) {
+            set = &ambient_sets[i];
+            break;
+        }
+        if (!set && !ambient_sets[i].path[0])
+            set = &ambient_sets[i];
+    }
+    if (!set) {
+        Com_DPrintf("S_RegisterAmbientSet: no room for %s\n", name);
+        return;
+    }
+
+    set->registration_sequence = snd.registration_sequence;
+    if (set->pending || set->file)
+        return;
+
+    /* New, or its view went to the stream: open it (again) */
+    Q_strncpyz(set->path, path, sizeof(set->path));
+    set->pending = qtrue;
+    FS_AsyncQueue(S_AmbientSetWork, S_AmbientSetDone, set);
+}
+
+void S_SetGeneralAmbientSet(const char *name)
+{
+    char path[MAX_QPATH];
+
+    if (!name || !name[0]) {
+        S_PlayStream(STREAM_AMBIENT, NULL, qfalse);
+        return;
+    }
+    S_StreamPath(path, sizeof(path), "sound/ambient", name);
+    S_PlayStream(STREAM_AMBIENT, path, qtrue);
+}
+
+/* For s_stats */
+void S_PrintStreams(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_STREAMS; i++) {
+        const sndstream_t *st = &snd_streams[i];
+
+        if (!st->name[0]) {
+            Com_Printf("%s: off\n", stream_names[i]);
+            continue;
+        }
+        Com_Printf("%s: %s, %d%% buffered, %d underruns%s\n", stream_names[i], st->name,
+                   (STREAM_FRAMES - S_StreamSpace(st)) * 100 / STREAM_FRAMES,
+                   st->underruns, st->active ? "" : " (opening)");
+    }
+}
+
+void S_InitStreams(void)
+{
+    memset(snd_streams, 0, sizeof(snd_streams));
+    memset(ambient_sets, 0, sizeof(ambient_sets));
+    Cmd_AddCommand("music", S_Music_f);
+}
+
+/* After FS_AsyncWait: nothing is loading */
+void S_ShutdownStreams(void)
+{
+    int i;
+
+    Cmd_RemoveCommand("music");
+    for (i = 0; i < NUM_STREAMS; i++) {
+        snd_streams[i].pending = qfalse;
+        S_CloseStream(&snd_streams[i]);
+        snd_streams[i].want[0] = 0;
+    }
+    for (i = 0; i < MAX_AMBIENT_SETS; i++)
+        S_FreeAmbientSet(&ambient_sets[i]);
+}
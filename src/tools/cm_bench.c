@@ -0,0 +1,134 @@
+/*
+ * cm_bench.c - Headless collision benchmark
+ *
+ * The cm_bench console command without the game: loads a map with
+ * BSP_Load alone and replays a capture written by cm_capture through the
+ * reference and kernel trace paths (CM_BenchCapture), so the numbers can
+ * be reproduced on a machine with no window or audio, e.g. in CI.
+ *
+ *   cm_bench [+set basedir <dir>] [+set game <dir>] <map> [passes] [file]
+ *
+ * file defaults to traces/<map>.trc under the game directories. The exit
+ * status is 0 if every trace agreed, 1 if the map or capture couldn't be
+ * loaded and 2 if any trace differed from the reference.
+ */
+
+#include "../common/qcommon.h"
+#include "../renderer/r_bsp.h"
+
+#include <stdarg.h>
+
+static bsp_world_t  bench_world;
+static qboolean     bench_loaded;
+
+/* ==========================================================================
+   Engine Stand-ins
+   What common.c, main.c and r_null.c would provide, without the rest of
+   the engine they bring in.
+   ========================================================================== */
+
+void Com_Printf(const char *fmt, ...)
+{
+    va_list argptr;
+
+    va_start(argptr, fmt);
+    vprintf(fmt, argptr);
+    va_end(argptr);
+    fflush(stdout);
+}
+
+void Com_DPrintf(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+void Com_Error(int code, const char *fmt, ...)
+{
+    va_list argptr;
+
+    (void)code;
+    va_start(argptr, fmt);
+    fputs("cm_bench: ", stderr);
+    vfprintf(stderr, fmt, argptr);
+    fputs("\n", stderr);
+    va_end(argptr);
+    exit(1);
+}
+
+void Sys_Error(const char *error, ...)
+{
+    va_list argptr;
+
+    va_start(argptr, error);
+    vfprintf(stderr, error, argptr);
+    fputs("\n", stderr);
+    va_end(argptr);
+    exit(1);
+}
+
+void Sys_Mkdir(const char *path)
+{
+    (void)path;     /* nothing is captured here */
+}
+
+bsp_world_t *R_GetWorldModel(void)
+{
+    return bench_loaded ? &bench_world : NULL;
+}
+
+/* ==========================================================================
+   Main
+   ========================================================================== */
+
+int main(int argc, char **argv)
+{
+    const char  *args[3] = { NULL, NULL, NULL };
+    char        bspname[MAX_QPATH], path[MAX_QPATH];
+    int         i, nargs = 0, result;
+
+    Z_Init();
+    Cbuf_Init();
+    Cmd_Init();
+    Cvar_Init();
+
+    /* +set before the filesystem comes up, as Qcommon_Init does */
+    for (i = 1; i < argc; i++) {
+        if (!Q_stricmp(argv[i], "+set") && i + 2 < argc) {
+            Cbuf_AddText(va("set %s %s\n", argv[i + 1], argv[i + 2]));
+            i += 2;
+        } else if (nargs < 3) {
+            args[nargs++] = argv[i];
+        }
+    }
+    Cbuf_Execute();
+
+    if (!args[0]) {
+        fprintf(stderr, "usage: cm_bench [+set basedir <dir>] [+set game <dir>] "
+                        "<map> [passes] [file]\n");
+        return 1;
+    }
+
+    FS_InitFilesystem();
+    Job_Init();
+
+    Com_sprintf(bspname, sizeof(bspname), "maps/%s.bsp", args[0]);
+    if (!BSP_Load(bspname, &bench_world)) {
+        Com_Printf("cm_bench: couldn't load %s\n", bspname);
+        return 1;
+    }
+    bench_loaded = qtrue;
+
+    if (args[2])
+        Q_strncpyz(path, args[2], sizeof(path));
+    else
+        Com_sprintf(path, sizeof(path), "traces/%s.trc", args[0]);
+
+    result = CM_BenchCapture(&bench_world, path, args[1] ? atoi(args[1]) : 10);
+
+    Job_Shutdown();
+    BSP_Free(&bench_world);
+
+    if (result < 0)
+        return 1;
+    return result ? 2 : 0;
+}